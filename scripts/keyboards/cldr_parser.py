@@ -9,24 +9,46 @@ from pprint import pprint
 from lxml import etree
 import unicodedata
 import statistics
+import struct
+import math
+import zlib
 import re
 
 # Set the directory that you extract the cldr keyboards zip file here
 CLDR_KEYBOARDS_BASE_PATH = "cldr-keyboards-33.1/keyboards"
 # the platform filename in the cldr, contains HID code to physical key code LUT
 PLATFORM_FILENAME = "_platform.xml"
+# max number of unicode intervals in a generated layout: the firmware keeps their descriptors in RAM
+LAYOUT_MAX_NB_INTERVALS = 64
+# size of an interval descriptor and of a layout entry in the generated layouts
+LAYOUT_INTERVAL_DESC_SIZE = 6
+LAYOUT_ENTRY_SIZE = 2
+# flash header layout from custom_fs.h: magic, total size, crc32, signed hash, (count, offset) for the update/string/fonts/bitmap/binary files
+# and the language map, language bitmap starting id, then the keyboard layout magic, count and offset that this script adds
+BUNDLE_MAGIC_HEADER = 0x12345678
+BUNDLE_KEYBOARD_LAYOUT_MAGIC = 0x4B4C0001
+BUNDLE_MAX_FILE_COUNT = 0xFFFFFFFF
+BUNDLE_CRC32_START = 12
+BUNDLE_FIELDS_START = 76
+BUNDLE_NB_FILE_TABLES = 5
+BUNDLE_HEADER_SIZE = 128
+BUNDLE_KEYBOARD_FIELDS_SIZE = 12
 
 # These are the HID modifier keys.  We create a single byte value
 # with the combination of the modifier keys pressed.
 keys_map = {'ctrlL': 	1 << 0,
+			'ctrl':		1 << 0,
 			'shiftL':	1 << 1,
 			'shift':	1 << 1,
-			'atlL':		1 << 2,
+			'altL':		1 << 2,
+			'alt':		1 << 2,
 			'opt':		1 << 2,
+			'optL':		1 << 2,
 			'cmd':		1 << 3,
 			'ctrlR':	1 << 4,
 			'shiftR':	1 << 5,
 			'altR':		1 << 6,
+			'optR':		1 << 6,
 			'cmdR':		1 << 7
 			}
 
@@ -166,7 +188,7 @@ class CLDR():
 						# print intervals, debug
 						if False and obj.attrib.get('locale') == "fr-t-k0-windows":
 							print self.get_unicode_intervals(self.layouts[platform_name][layout_name], 100)
-						if True:
+						if False:
 							print len(self.get_unicode_intervals(self.layouts[platform_name][layout_name], 100))
 							print obj.attrib.get('locale'), self.get_unicode_intervals(self.layouts[platform_name][layout_name], 100)
 
@@ -306,12 +328,12 @@ class CLDR():
 		table = []
 		table.append(["Glyph", "Unicode", "modifier+keycode", "Description"])
 		for k, v in layout.iteritems():
-			mod, keycode = v
+			mod, keycode, iso = v
 			try:
 				des = unicodedata.name(unichr(k))
 			except:
 				des = "No Data"
-			table.append([unichr(k), k, mod + " " + keycode, des])
+			table.append([unichr(k), k, "+".join(mod) + " " + hex(keycode), des])
 		for row in table:
 			print("{0: <5} {1: >15} {2: >20} {3: >10}".format(*row))
 
@@ -351,20 +373,196 @@ class CLDR():
 		print " decomposition.  The code points can be represented with "
 		print " %s unique glyph images." % len(npoints)
 
-
+	# Returns the HID modifier byte for a list of modifier keys, None if one of them can't be expressed with the HID modifier bits
+	def get_modifier_byte(self, modifier_keys):
+		modifier_byte = 0
+		for key in modifier_keys:
+			if key not in keys_map:
+				return None
+			modifier_byte |= keys_map[key]
+		return modifier_byte
+
+	# Returns a layout as a dictionary: BMP unicode point -> (HID modifier byte, HID keycode)
+	def get_hid_layout(self, platform_name, layout_name):
+		hid_layout = {}
+		for point, (modifier_keys, keycode, iso) in self.layouts[platform_name][layout_name].iteritems():
+			modifier_byte = self.get_modifier_byte(modifier_keys)
+			if point <= 0xFFFF and modifier_byte is not None and 0 < keycode <= 0xFF:
+				hid_layout[point] = (modifier_byte, keycode)
+		return hid_layout
+
+	# Split the points of a layout into intervals: a new interval starts when more than max_gap points are missing
+	def get_layout_intervals(self, hid_layout, max_gap):
+		intervals = []
+		for point in sorted(hid_layout):
+			if len(intervals) > 0 and point - intervals[-1][1] <= max_gap + 1:
+				intervals[-1][1] = point
+			else:
+				intervals.append([point, point])
+		return intervals
+
+	# Returns the binary layout, as stored in the bundle:
+	# uint16 interval count, uint16 entry count
+	# interval descriptors: uint16 first point, uint16 last point, uint16 index of the first point entry
+	# entries for each point of each interval: uint8 HID modifier byte, uint8 HID keycode (0: can't be typed)
+	def get_layout_binary(self, hid_layout):
+		# an interval descriptor costs as much as LAYOUT_INTERVAL_DESC_SIZE/LAYOUT_ENTRY_SIZE missing points, widen gaps if we have too many intervals
+		max_gap = LAYOUT_INTERVAL_DESC_SIZE / LAYOUT_ENTRY_SIZE
+		intervals = self.get_layout_intervals(hid_layout, max_gap)
+		while len(intervals) > LAYOUT_MAX_NB_INTERVALS:
+			max_gap += 1
+			intervals = self.get_layout_intervals(hid_layout, max_gap)
+
+		descriptors = ""
+		entries = ""
+		entry_count = 0
+		for start, end in intervals:
+			descriptors += struct.pack('<HHH', start, end, entry_count)
+			for point in range(start, end + 1):
+				modifier_byte, keycode = hid_layout.get(point, (0, 0))
+				entries += struct.pack('<BB', modifier_byte, keycode)
+			entry_count += end - start + 1
+		return struct.pack('<HH', len(intervals), entry_count) + descriptors + entries
+
+	# Look a point up in a binary layout the way the firmware does: binary search on the interval descriptors then one entry read
+	# Returns (modifier byte, keycode) or None, and the number of descriptors looked at
+	def lookup_layout_binary(self, layout_binary, point):
+		interval_count, entry_count = struct.unpack('<HH', layout_binary[0:4])
+		low = 0
+		high = interval_count
+		nb_steps = 0
+		while low < high:
+			middle = (low + high) / 2
+			start, end, first_entry = struct.unpack('<HHH', layout_binary[4+middle*LAYOUT_INTERVAL_DESC_SIZE:4+(middle+1)*LAYOUT_INTERVAL_DESC_SIZE])
+			nb_steps += 1
+			if point < start:
+				high = middle
+			elif point > end:
+				low = middle + 1
+			else:
+				entry_offset = 4 + interval_count*LAYOUT_INTERVAL_DESC_SIZE + (first_entry + point - start)*LAYOUT_ENTRY_SIZE
+				modifier_byte, keycode = struct.unpack('<BB', layout_binary[entry_offset:entry_offset+LAYOUT_ENTRY_SIZE])
+				if keycode == 0:
+					return None, nb_steps
+				return (modifier_byte, keycode), nb_steps
+		return None, nb_steps
+
+	# Returns the (platform name, layout name) list, in layout file ID order
+	def get_sorted_layout_names(self):
+		names = []
+		for platform_name in sorted(self.layouts):
+			for layout_name in sorted(self.layouts[platform_name]):
+				names.append((platform_name, layout_name))
+		return names
+
+	# Generate the binary layout files for the bundle, with an index file giving the layout ID of each one
+	def generate_layout_files(self, output_dir):
+		if not os.path.isdir(output_dir):
+			os.makedirs(output_dir)
+		index_file = open(os.path.join(output_dir, "keyboard_layouts.txt"), "w")
+		sizes = []
+		max_nb_intervals = 0
+		for layout_id, (platform_name, layout_name) in enumerate(self.get_sorted_layout_names()):
+			layout_binary = self.get_layout_binary(self.get_hid_layout(platform_name, layout_name))
+			filename = "keyboard_%03d_%s_%s.bin" % (layout_id, platform_name, re.sub(r'[^0-9A-Za-z]+', '_', layout_name))
+			layout_file = open(os.path.join(output_dir, filename), "wb")
+			layout_file.write(layout_binary)
+			layout_file.close()
+			index_file.write("%d %s %s %s\n" % (layout_id, platform_name, layout_name, filename))
+			sizes.append(len(layout_binary))
+			max_nb_intervals = max(max_nb_intervals, struct.unpack('<H', layout_binary[0:2])[0])
+		index_file.close()
+
+		print "Generated %d layouts in %s" % (len(sizes), output_dir)
+		print "Total size: %d Bytes, mean: %d Bytes, max: %d Bytes" % (sum(sizes), sum(sizes) / len(sizes), max(sizes))
+		print "Max number of intervals: %d, lookup: at most %d descriptor compares + 1 entry read" % (max_nb_intervals, int(math.ceil(math.log(max_nb_intervals + 1, 2))))
+
+	# Add the keyboard layouts to a bundle generated without them: the keyboard layout fields are inserted after the flash header,
+	# every address in the bundle is moved accordingly and the layouts are appended with their file table. The signature isn't updated.
+	def add_layouts_to_bundle(self, input_filename, output_filename):
+		bundle = bytearray(open(input_filename, "rb").read())
+		magic_header, total_size = struct.unpack('<II', str(bundle[0:8]))
+		if magic_header != BUNDLE_MAGIC_HEADER or total_size > len(bundle):
+			print "Invalid bundle:", input_filename
+			return False
+		if struct.unpack('<I', str(bundle[BUNDLE_HEADER_SIZE:BUNDLE_HEADER_SIZE+4]))[0] == BUNDLE_KEYBOARD_LAYOUT_MAGIC:
+			print "Bundle already contains keyboard layouts:", input_filename
+			return False
+		fields = list(struct.unpack('<13I', str(bundle[BUNDLE_FIELDS_START:BUNDLE_HEADER_SIZE])))
+
+		# move the addresses stored in the file tables & the language map table address, then the offsets in the header
+		def move_address(position):
+			address = struct.unpack('<I', str(bundle[position:position+4]))[0]
+			bundle[position:position+4] = struct.pack('<I', address + BUNDLE_KEYBOARD_FIELDS_SIZE)
+		for table_id in range(BUNDLE_NB_FILE_TABLES):
+			file_count, table_offset = fields[2*table_id], fields[2*table_id+1]
+			if file_count != BUNDLE_MAX_FILE_COUNT:
+				for file_id in range(file_count):
+					move_address(table_offset + file_id*4)
+				fields[2*table_id+1] += BUNDLE_KEYBOARD_FIELDS_SIZE
+		if fields[2*BUNDLE_NB_FILE_TABLES] != BUNDLE_MAX_FILE_COUNT:
+			move_address(fields[2*BUNDLE_NB_FILE_TABLES+1])
+			fields[2*BUNDLE_NB_FILE_TABLES+1] += BUNDLE_KEYBOARD_FIELDS_SIZE
+
+		# layouts appended after the file table, in the keyboard_layouts.txt order
+		layout_binaries = [self.get_layout_binary(self.get_hid_layout(platform_name, layout_name)) for platform_name, layout_name in self.get_sorted_layout_names()]
+		layout_table_offset = total_size + BUNDLE_KEYBOARD_FIELDS_SIZE
+		layout_address = layout_table_offset + len(layout_binaries)*4
+		layout_table = ""
+		for layout_binary in layout_binaries:
+			layout_table += struct.pack('<I', layout_address)
+			layout_address += len(layout_binary)
+
+		new_bundle = str(bundle[0:BUNDLE_FIELDS_START]) + struct.pack('<13I', *fields) + struct.pack('<III', BUNDLE_KEYBOARD_LAYOUT_MAGIC, len(layout_binaries), layout_table_offset)
+		new_bundle += str(bundle[BUNDLE_HEADER_SIZE:total_size]) + layout_table + "".join(layout_binaries)
+		new_bundle = new_bundle[0:4] + struct.pack('<II', len(new_bundle), zlib.crc32(new_bundle[BUNDLE_CRC32_START:]) & 0xFFFFFFFF) + new_bundle[BUNDLE_CRC32_START:]
+		output_file = open(output_filename, "wb")
+		output_file.write(new_bundle)
+		output_file.close()
+
+		print "Added %d layouts (%d Bytes) to %s, written to %s" % (len(layout_binaries), len(new_bundle) - total_size, input_filename, output_filename)
+		print "The bundle signature needs to be generated again"
+		return True
+
+	# Round trip every layout of every platform: every BMP point must give back its parsed modifier & keycode, or nothing
+	def check_layouts(self):
+		nb_errors = 0
+		max_nb_steps = 0
+		for platform_name, layout_name in self.get_sorted_layout_names():
+			hid_layout = self.get_hid_layout(platform_name, layout_name)
+			layout_binary = self.get_layout_binary(hid_layout)
+			for point in range(0, 0x10000):
+				result, nb_steps = self.lookup_layout_binary(layout_binary, point)
+				max_nb_steps = max(max_nb_steps, nb_steps)
+				if result != hid_layout.get(point):
+					print "Mismatch in %s / %s for point %s: expected %s, got %s" % (platform_name, layout_name, hex(point), hid_layout.get(point), result)
+					nb_errors += 1
+		print "Checked %d layouts, %d errors, at most %d descriptor compares per lookup" % (len(self.get_sorted_layout_names()), nb_errors, max_nb_steps)
+		return nb_errors == 0
 
 
 # example usage below.
-
-cldr = CLDR()
-cldr.parse_cldr_xml()
-
-# now you can just access cldr.layouts directly if you want..
-
-#cldr.show_platforms()
-#cldr.show_layouts(1) # osx
-#
-#cldr.show_lut(1, 30) # German
-#
-#cldr.show_stats()
-
+# cldr_parser.py generate <output_dir>: generate the binary layouts for the bundle
+# cldr_parser.py check: round trip all the layouts
+# cldr_parser.py bundle <input_bundle> <output_bundle>: add the layouts to a bundle
+if __name__ == "__main__":
+	cldr = CLDR()
+	cldr.parse_cldr_xml()
+
+	# now you can just access cldr.layouts directly if you want..
+
+	#cldr.show_platforms()
+	#cldr.show_layouts(1) # osx
+	#
+	#cldr.show_lut(1, 30) # German
+	#
+	#cldr.show_stats()
+
+	if len(sys.argv) > 2 and sys.argv[1] == "generate":
+		cldr.generate_layout_files(sys.argv[2])
+	elif len(sys.argv) > 3 and sys.argv[1] == "bundle":
+		if not cldr.add_layouts_to_bundle(sys.argv[2], sys.argv[3]):
+			sys.exit(1)
+	elif len(sys.argv) > 1 and sys.argv[1] == "check":
+		if not cldr.check_layouts():
+			sys.exit(1)
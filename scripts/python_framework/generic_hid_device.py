@@ -31,6 +31,8 @@ class generic_hid_device:
 		self.flipbit = 0x00
 		# Set to true to enable ack flag request
 		self.ack_flag_in_comms = False
+		# Clock used for timings, replaced by the virtual one of a simulated device
+		self.getTime = time.time
 
 	# Catch CTRL-C interrupt
 	def signal_handler(self, signal, frame):
@@ -342,6 +344,23 @@ class generic_hid_device:
 		self.connected = True
 		return True
 
+	# Connect to a simulated device, see host_comms.py
+	def connectSimulated(self, simulated_device, read_timeout):
+		self.hid_device = simulated_device
+		self.epout = simulated_device.epout
+		self.epin = simulated_device.epin
+		self.read_timeout = read_timeout
+		self.getTime = simulated_device.getTime
+		self.connected = True
+		
+		# Set flip bit reset packet
+		flipbit_reset_packet = array('B')
+		flipbit_reset_packet.append(0xFF)
+		flipbit_reset_packet.append(0xFF)
+		self.epout.write(flipbit_reset_packet)
+		self.flipbit = 0x00
+		return True
+
 	# Disconnect from HID device
 	def disconnect(self):
 		# check that we're actually connected to a device
@@ -383,3 +402,21 @@ class generic_hid_device:
 				else:
 					print "Ping pong transfer speed (bidirectional cumulated):", data_counter*2 , "B/s"
 				data_counter = 0
+
+	# Measure round trip latencies of a message, returns them in seconds
+	def benchmarkMessageLatency(self, message, nb_iterations):
+		latencies = []
+		for i in range(0, nb_iterations):
+			start_time = self.getTime()
+			self.sendHidMessageWaitForAck(message)
+			latencies.append(self.getTime() - start_time)
+		return latencies
+
+	# Get latency percentiles in ms: min, 50th, 90th, 99th, max
+	def getLatencyPercentiles(self, latencies):
+		sorted_latencies = sorted(latencies)
+		percentiles = []
+		for percentile in [0, 50, 90, 99, 100]:
+			index = min(len(sorted_latencies) - 1, (len(sorted_latencies) * percentile) / 100)
+			percentiles.append(sorted_latencies[index] * 1000)
+		return percentiles
@@ -0,0 +1,398 @@
+#!/usr/bin/env python2
+from host_firmware import *
+from host_crypto import *
+import hashlib
+import random
+import struct
+import zlib
+import re
+import os
+from distutils.spawn import find_executable
+
+# Host checks of the bundle signature verification (custom_fs_compute_and_check_external_bundle_crc32()): SHA-256 of the
+# CRC32 DMA stream, Ed25519 (SECURITY/ed25519.c) against RFC 8032 and OpenSSL, good & tampered bundles, benchmark. Application
+# check before a firmware upgrade (custom_fs_check_external_bundle_signature()), bootloader size with the crc32 check only
+
+# Bootloader project, which must fit below the application start address
+BOOTLOADER_PROJECT				= join(SOURCE_CODE_DIR, "main_mcu", "bootloader.cproj")
+# Bundle shipped with the python framework, header layout from custom_fs.h
+BUNDLE_FILE_NAME				= join(dirname(realpath(__file__)), "bundle.img")
+BUNDLE_CRC32_START				= 12
+BUNDLE_SIGNATURE_LENGTH			= 64
+# Dataflash SPI clock: 48MHz / (2 * (DATAFLASH_BAUD_DIVIDER + 1)), main MCU clock
+SIM_SIG_SPI_CLOCK				= 12000000
+SIM_SIG_CPU_CLOCK				= 48000000
+
+HOST_SIGNATURE_HELPERS = r"""
+#include <openssl/evp.h>
+#include <string.h>
+#include "ed25519.h"
+#include "sha256.h"
+#include "sha512.h"
+
+/* dma_compute_crc32_from_spi() data flow: chunks received in alternating buffers, the first bytes not hashed */
+void host_stream_hash(uint8_t* stream, uint32_t size, uint32_t nb_bytes_not_hashed, uint8_t* digest)
+{
+	uint8_t hash_buffers[2][DMA_CRC32_HASH_CHUNK_SIZE];
+	uint16_t hash_buffer_id = 0;
+	uint32_t chunk_size;
+	sha256_context_t context;
+
+	sha256_init(&context);
+	while (size > 0)
+	{
+		chunk_size = (size > DMA_CRC32_HASH_CHUNK_SIZE)? DMA_CRC32_HASH_CHUNK_SIZE : size;
+		memcpy(hash_buffers[hash_buffer_id], stream, chunk_size);
+		if (nb_bytes_not_hashed >= chunk_size)
+		{
+			nb_bytes_not_hashed -= chunk_size;
+		}
+		else
+		{
+			sha256_update(&context, &hash_buffers[hash_buffer_id][nb_bytes_not_hashed], chunk_size - nb_bytes_not_hashed);
+			nb_bytes_not_hashed = 0;
+		}
+		hash_buffer_id ^= 1;
+		stream += chunk_size;
+		size -= chunk_size;
+	}
+	sha256_final(&context, digest);
+}
+
+/* Hash length bytes in DMA chunks nb_iterations times: returns ns, stores host cycles */
+uint64_t host_stream_hash_bench(uint8_t* stream, uint32_t length, uint32_t nb_iterations, uint64_t* cycles)
+{
+	uint8_t digest[SHA256_DIGEST_LENGTH];
+	uint64_t start_ns = host_ns();
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_iterations; i++)
+	{
+		host_stream_hash(stream, length, 0, digest);
+	}
+	*cycles = host_cycles() - start_cycles;
+	return host_ns() - start_ns;
+}
+
+/* Signature verifications: returns ns, stores host cycles */
+uint64_t host_ed25519_verify_bench(uint8_t* signature, uint8_t* message, uint16_t message_length, uint8_t* public_key, uint32_t nb_iterations, uint64_t* cycles)
+{
+	uint64_t start_ns = host_ns();
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_iterations; i++)
+	{
+		ed25519_verify(signature, message, message_length, public_key);
+	}
+	*cycles = host_cycles() - start_cycles;
+	return host_ns() - start_ns;
+}
+
+uint32_t host_sha256_context_size(void) { return sizeof(sha256_context_t); }
+uint32_t host_sha512_context_size(void) { return sizeof(sha512_context_t); }
+
+/* OpenSSL Ed25519 signature from a 32 bytes private key, stores the public key. Returns 1 on success */
+int host_openssl_ed25519_sign(uint8_t* private_key, uint8_t* message, uint32_t message_length, uint8_t* signature, uint8_t* public_key)
+{
+	EVP_PKEY* key = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, 0, private_key, 32);
+	EVP_MD_CTX* md_context = EVP_MD_CTX_new();
+	size_t signature_length = ED25519_SIGNATURE_LENGTH;
+	size_t public_key_length = ED25519_PUBLIC_KEY_LENGTH;
+	int result = 0;
+
+	if ((key != 0) && (md_context != 0) && EVP_PKEY_get_raw_public_key(key, public_key, &public_key_length) && EVP_DigestSignInit(md_context, 0, 0, 0, key) && EVP_DigestSign(md_context, signature, &signature_length, message, message_length))
+	{
+		result = 1;
+	}
+	EVP_MD_CTX_free(md_context);
+	EVP_PKEY_free(key);
+	return result;
+}
+"""
+
+
+# DMA chunk size from dma.h, which can't be included in host builds
+def getDmaHashChunkSize():
+	for line in open(join(MAIN_MCU_SRC_DIR, "DMA", "dma.h"), "r"):
+		match = re.match(r"#define\s+DMA_CRC32_HASH_CHUNK_SIZE\s+(\d+)", line)
+		if match:
+			return int(match.group(1))
+
+
+def loadSignatureLibrary():
+	library = loadFirmwareLibrary(["SECURITY/sha256.c", "SECURITY/sha512.c", "SECURITY/ed25519.c", "SECURITY/aes.c", "SECURITY/aes256_ctr.c"], HOST_AES_HELPERS + HOST_SIGNATURE_HELPERS, ["DMA_CRC32_HASH_CHUNK_SIZE=" + str(getDmaHashChunkSize())], ["crypto"])
+	library.host_stream_hash_bench.restype = ctypes.c_uint64
+	library.host_ed25519_verify_bench.restype = ctypes.c_uint64
+	return library
+
+
+def firmwareSha256(library, data, nb_bytes_not_hashed=0):
+	digest = ctypes.create_string_buffer(32)
+	library.host_stream_hash(data, len(data), nb_bytes_not_hashed, digest)
+	return digest.raw
+
+
+def firmwareSha512(library, data, splits):
+	context = ctypes.create_string_buffer(library.host_sha512_context_size())
+	digest = ctypes.create_string_buffer(64)
+	library.sha512_init(context)
+	start = 0
+	for split in sorted(splits) + [len(data)]:
+		library.sha512_update(context, data[start:split], split - start)
+		start = split
+	library.sha512_final(context, digest)
+	return digest.raw
+
+
+def firmwareEd25519Verify(library, signature, message, public_key):
+	return library.ed25519_verify(signature, message, len(message), public_key) == 0
+
+
+def opensslEd25519Sign(library, private_key, message):
+	signature = ctypes.create_string_buffer(64)
+	public_key = ctypes.create_string_buffer(32)
+	if library.host_openssl_ed25519_sign(private_key, message, len(message), signature, public_key) != 1:
+		return None, None
+	return signature.raw, public_key.raw
+
+
+def flipBit(data, bit_index):
+	return data[0:bit_index/8] + chr(ord(data[bit_index/8]) ^ (1 << (bit_index % 8))) + data[bit_index/8+1:]
+
+
+# FIPS 180-2 SHA-256 & SHA-512 examples, random lengths through the DMA chunking against hashlib
+def runHashTests(library):
+	result = firmwareSha256(library, "abc").encode("hex") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+	result = result and firmwareSha256(library, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").encode("hex") == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+	result = result and firmwareSha256(library, "a" * 1000000).encode("hex") == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+	result = result and firmwareSha256(library, "").encode("hex") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+	print "FIPS 180-2 SHA-256 examples:".ljust(40), "OK" if result else "FAILED"
+	all_ok = result
+
+	result = True
+	for i in range(0, 300):
+		data = os.urandom(random.randint(0, 2000))
+		nb_bytes_not_hashed = random.choice([0, 64, random.randint(0, len(data))])
+		result = result and firmwareSha256(library, data, nb_bytes_not_hashed) == hashlib.sha256(data[nb_bytes_not_hashed:]).digest()
+	print "SHA-256 of DMA chunks, skipped bytes:".ljust(40), "OK" if result else "FAILED"
+	all_ok = all_ok and result
+
+	result = firmwareSha512(library, "abc", []).encode("hex") == "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"
+	for i in range(0, 300):
+		data = os.urandom(random.randint(0, 400))
+		result = result and firmwareSha512(library, data, [random.randint(0, len(data)) for j in range(0, 3)]) == hashlib.sha512(data).digest()
+	print "SHA-512 example & random updates:".ljust(40), "OK" if result else "FAILED"
+	return all_ok and result
+
+
+# RFC 8032 7.1 tests 1 & 2, OpenSSL signatures of random messages, bit flips, non canonical S
+def runEd25519Tests(library, nb_cases=200):
+	rfc_vectors = [("d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", "", "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b"),
+				   ("3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c", "72", "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00")]
+	result = all(firmwareEd25519Verify(library, signature.decode("hex"), message.decode("hex"), public_key.decode("hex")) for public_key, message, signature in rfc_vectors)
+	print "RFC 8032 Ed25519 tests 1 & 2:".ljust(40), "OK" if result else "FAILED"
+	all_ok = result
+
+	nb_failed = 0
+	group_order = 2**252 + 27742317777372353535851937790883648493
+	for i in range(0, nb_cases):
+		message = os.urandom(random.choice([32, random.randint(0, 100)]))
+		signature, public_key = opensslEd25519Sign(library, os.urandom(32), message)
+		s = int(signature[32:][::-1].encode("hex"), 16)
+		malleable_signature = signature[0:32] + ("%064x" % (s + group_order)).decode("hex")[::-1]
+		expected_results = [(signature, message, public_key, True),
+							(flipBit(signature, random.randint(0, 511)), message, public_key, False),
+							(signature, flipBit(message, random.randint(0, len(message) * 8 - 1)) if len(message) > 0 else "\x00", public_key, False),
+							(signature, message, flipBit(public_key, random.randint(0, 254)), False),
+							(malleable_signature, message, public_key, False)]
+		for signature_to_check, message_to_check, public_key_to_check, expected in expected_results:
+			if firmwareEd25519Verify(library, signature_to_check, message_to_check, public_key_to_check) != expected:
+				nb_failed += 1
+	print "OpenSSL signatures, tampered ones:".ljust(40), str(nb_cases * 5) + " verifications, " + str(nb_failed) + " failed"
+	return all_ok and nb_failed == 0
+
+
+# custom_fs_compute_and_check_external_bundle_crc32(): CRC32 after the header fields, signature of the hash of what is after the signed hash
+def checkBundle(library, bundle, public_key):
+	total_size = struct.unpack("<I", bundle[4:8])[0]
+	crc32 = struct.unpack("<I", bundle[8:12])[0]
+	stream = bundle[BUNDLE_CRC32_START:total_size]
+	if zlib.crc32(stream) & 0xFFFFFFFF != crc32:
+		return "CRC32"
+	if not firmwareEd25519Verify(library, stream[0:BUNDLE_SIGNATURE_LENGTH], firmwareSha256(library, stream, BUNDLE_SIGNATURE_LENGTH), public_key):
+		return "signature"
+	return "OK"
+
+
+def updateBundleCrc32(bundle):
+	total_size = struct.unpack("<I", bundle[4:8])[0]
+	return bundle[0:8] + struct.pack("<I", zlib.crc32(bundle[BUNDLE_CRC32_START:total_size]) & 0xFFFFFFFF) + bundle[BUNDLE_CRC32_START:]
+
+
+def signBundle(library, bundle, private_key):
+	total_size = struct.unpack("<I", bundle[4:8])[0]
+	signature, public_key = opensslEd25519Sign(library, private_key, hashlib.sha256(bundle[BUNDLE_CRC32_START+BUNDLE_SIGNATURE_LENGTH:total_size]).digest())
+	return updateBundleCrc32(bundle[0:BUNDLE_CRC32_START] + signature + bundle[BUNDLE_CRC32_START+BUNDLE_SIGNATURE_LENGTH:]), public_key
+
+
+def runBundleTests(library):
+	bundle = open(BUNDLE_FILE_NAME, "rb").read()
+	total_size = struct.unpack("<I", bundle[4:8])[0]
+	result = zlib.crc32(bundle[BUNDLE_CRC32_START:total_size]) & 0xFFFFFFFF == struct.unpack("<I", bundle[8:12])[0]
+	print ("Shipped bundle, " + str(total_size) + " bytes, CRC32:").ljust(40), "OK" if result else "FAILED"
+	all_ok = result
+
+	private_key = os.urandom(32)
+	signed_bundle, public_key = signBundle(library, bundle, private_key)
+	data_offset = random.randint(BUNDLE_CRC32_START + BUNDLE_SIGNATURE_LENGTH, total_size - 1)
+	shorter_bundle = signed_bundle[0:4] + struct.pack("<I", total_size - 1) + signed_bundle[8:]
+	test_cases = [("Signed bundle", signed_bundle, public_key, "OK"),
+				  ("Unsigned shipped bundle", bundle, public_key, "signature"),
+				  ("Signed bundle, other key", signed_bundle, opensslEd25519Sign(library, os.urandom(32), "")[1], "signature"),
+				  ("Tampered data", flipBit(signed_bundle, data_offset * 8), public_key, "CRC32"),
+				  ("Tampered data, CRC32 updated", updateBundleCrc32(flipBit(signed_bundle, data_offset * 8)), public_key, "signature"),
+				  ("Tampered signature, CRC32 updated", updateBundleCrc32(flipBit(signed_bundle, BUNDLE_CRC32_START * 8 + random.randint(0, 511))), public_key, "signature"),
+				  ("Truncated, CRC32 updated", updateBundleCrc32(shorter_bundle), public_key, "signature")]
+	for name, bundle_to_check, public_key_to_check, expected in test_cases:
+		check_result = checkBundle(library, bundle_to_check, public_key_to_check)
+		result = check_result == expected
+		all_ok = all_ok and result
+		print (name + ":").ljust(40), ("rejected by " + check_result if check_result != "OK" else "accepted").ljust(24), "OK" if result else "FAILED"
+	return all_ok
+
+
+# FILESYSTEM/custom_fs.c stand-ins: the external flash is a host buffer, the DMA is never used by the application signature check
+HOST_APP_SIGNATURE_STANDINS = r"""
+#include "custom_fs.h"
+#include "dataflash.h"
+#include "dma.h"
+
+uint8_t host_dataflash[W25Q16_SIZE];
+uint32_t host_dataflash_nb_bytes_read = 0;
+
+void dataflash_read_data_array(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length)
+{
+	memcpy(data, &host_dataflash[address], length);
+	host_dataflash_nb_bytes_read += length;
+}
+void dataflash_read_data_array_start(spi_flash_descriptor_t* descriptor_pt, uint32_t address) {}
+void dataflash_read_bytes_from_opened_transfer(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length) {}
+void dataflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt) {}
+uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size, sha256_context_t* sha256_context, uint32_t nb_bytes_not_hashed) { return 0; }
+void dma_custom_fs_init_transfer(void* spi_data_p, void* datap, uint16_t size) {}
+void dma_set_custom_fs_flag_done(void) {}
+void dma_reset(void) {}
+"""
+
+
+# Application check run before setting the fw upgrade flag, built with the public key of a random private key: signed bundle
+# accepted, tampered ones rejected, an erased flash rejected from its header
+def runApplicationCheckTests(library):
+	bundle = open(BUNDLE_FILE_NAME, "rb").read()
+	total_size = struct.unpack("<I", bundle[4:8])[0]
+	private_key = os.urandom(32)
+	signed_bundle, public_key = signBundle(library, bundle, private_key)
+	key_define = "BUNDLE_SIGNING_PUBLIC_KEY={" + ",".join(str(ord(byte)) for byte in public_key) + "}"
+	app_library = loadHostFirmware(MAIN_MCU_PROJECT, ["FILESYSTEM/custom_fs.c", "FILESYSTEM/custom_fs_emergency_font.c", "SECURITY/sha256.c", "SECURITY/sha512.c", "SECURITY/ed25519.c"], HOST_APP_SIGNATURE_STANDINS, [key_define])
+	dataflash = (ctypes.c_uint8 * getFirmwareDefine(MAIN_MCU_PROJECT, "FLASH/dataflash.h", "W25Q16_SIZE")).in_dll(app_library, "host_dataflash")
+	nb_bytes_read = ctypes.c_uint32.in_dll(app_library, "host_dataflash_nb_bytes_read")
+	fw_offset = random.randint(BUNDLE_CRC32_START + BUNDLE_SIGNATURE_LENGTH, total_size - 1)
+	test_cases = [("Signed bundle", signed_bundle, True),
+				  ("Unsigned shipped bundle", bundle, False),
+				  ("Signed with another key", signBundle(library, bundle, os.urandom(32))[0], False),
+				  ("Tampered data, CRC32 updated", updateBundleCrc32(flipBit(signed_bundle, fw_offset * 8)), False),
+				  ("Erased flash", "\xFF" * BUNDLE_CRC32_START, False)]
+	all_ok = True
+	for name, bundle_to_check, expected in test_cases:
+		ctypes.memset(dataflash, 0xFF, ctypes.sizeof(dataflash))
+		ctypes.memmove(dataflash, bundle_to_check, len(bundle_to_check))
+		nb_bytes_read.value = 0
+		accepted = app_library.custom_fs_check_external_bundle_signature() == 0
+		result = accepted == expected
+		all_ok = all_ok and result
+		print ("Upgrade check, " + name + ":").ljust(48), ("accepted" if accepted else "rejected").ljust(10), (str(nb_bytes_read.value) + " bytes read").rjust(18), "OK" if result else "FAILED"
+	return all_ok
+
+
+# Host cycles per KB of the chunked stream hash, verification time, total for a 1MB bundle, SPI stream duration on the device
+def runSignatureBenchmark(library, nb_iterations=20):
+	cycles = ctypes.c_uint64(0)
+	stream = ctypes.create_string_buffer(os.urandom(1 << 20), 1 << 20)
+	hash_ns = library.host_stream_hash_bench(stream, 1 << 20, nb_iterations, ctypes.byref(cycles)) / nb_iterations
+	hash_cycles = cycles.value / nb_iterations
+	print "Host SHA-256 of the DMA chunks:".ljust(40), ("%.0f cycles/KB" % (hash_cycles / 1024.0)).rjust(20), ("%.2f ms/MB" % (hash_ns / 1e6)).rjust(14)
+
+	signature, public_key = opensslEd25519Sign(library, os.urandom(32), "\x00" * 32)
+	verify_ns = library.host_ed25519_verify_bench(signature, "\x00" * 32, 32, public_key, nb_iterations, ctypes.byref(cycles)) / nb_iterations
+	print "Host Ed25519 verification:".ljust(40), ("%.0f cycles" % (cycles.value / nb_iterations)).rjust(20), ("%.2f ms" % (verify_ns / 1e6)).rjust(14)
+	print "Host 1MB bundle verification:".ljust(40), ("%.2f ms" % ((hash_ns + verify_ns) / 1e6)).rjust(35)
+
+	spi_ms = (1 << 20) * 8 * 1000.0 / SIM_SIG_SPI_CLOCK
+	print "Device 1MB SPI stream:".ljust(40), ("%.0f ms" % spi_ms).rjust(35) + ", hashing hidden below %.0f cycles/byte" % (float(SIM_SIG_CPU_CLOCK) * 8 / SIM_SIG_SPI_CLOCK)
+
+
+# Bootloader size: bootloader.cproj sources built -Os, one section per function, linked from main() without the unused sections.
+# With arm-none-eabi-gcc & size installed, a Thumb build counting the C library. Otherwise a host gcc proxy: sources that don't build
+# on the host (main firmware COMMS, ARM assembly) are left out, as are the C library & compiler helpers, and x86-64 code isn't Thumb code
+def bootloaderSize(defines):
+	namespace = "{http://schemas.microsoft.com/developer/msbuild/2003}"
+	project_defines, include_dirs = parseProjectSettings(BOOTLOADER_PROJECT)
+	sources = [item.get("Include").replace("\\", "/") for item in ElementTree.parse(BOOTLOADER_PROJECT).getroot().iter(namespace + "Compile") if item.get("Include").endswith(".c")]
+	arm_build = find_executable("arm-none-eabi-gcc") is not None and find_executable("arm-none-eabi-size") is not None
+	build_dir = tempfile.mkdtemp()
+	try:
+		if arm_build:
+			compiler, size_tool = "arm-none-eabi-gcc", "arm-none-eabi-size"
+			flags = ["-mcpu=cortex-m0plus", "-mthumb", "-Os", "-std=gnu99", "-ffunction-sections", "-fdata-sections", "-w"]
+			link_flags = ["-mcpu=cortex-m0plus", "-mthumb", "--specs=nano.specs", "-nostartfiles"]
+		else:
+			header_file = join(build_dir, "host_firmware.h")
+			open(header_file, "w").write(HOST_FIRMWARE_HEADER)
+			compiler, size_tool = "gcc", "size"
+			flags = ["-Os", "-std=gnu99", "-fcommon", "-fno-pic", "-fno-asynchronous-unwind-tables", "-ffunction-sections", "-fdata-sections", "-w", "-include", header_file]
+			link_flags = ["-nostdlib", "-static", "-no-pie"]
+		flags += ["-D" + define for define in project_defines + defines]
+		flags += ["-I" + include_dir for include_dir in include_dirs]
+		object_files = []
+		nb_skipped = 0
+		for i, source in enumerate(sources):
+			object_file = join(build_dir, str(i) + ".o")
+			if subprocess.call([compiler] + flags + ["-c", "-o", object_file, join(dirname(BOOTLOADER_PROJECT), source)], stderr=open(os.devnull, "w")) == 0:
+				object_files.append(object_file)
+			else:
+				nb_skipped += 1
+		elf_file = join(build_dir, "bootloader.elf")
+		subprocess.check_call([compiler] + link_flags + ["-Wl,--gc-sections", "-Wl,-e,main", "-Wl,--unresolved-symbols=ignore-all", "-o", elf_file] + object_files)
+		sections = dict(re.findall(r"^(\.\w+)\s+(\d+)", subprocess.check_output([size_tool, "-A", elf_file]), re.MULTILINE))
+		return sum(int(sections.get(section, 0)) for section in [".text", ".rodata", ".data"]), nb_skipped, ("ARM build" if arm_build else "arm-none-eabi-gcc not found, host x86-64 -Os proxy")
+	finally:
+		shutil.rmtree(build_dir)
+
+
+# The bootloader keeps to the crc32 check when a key is provided: same size, below the application start address
+def runBootloaderSizeEstimate():
+	flash_limit = getFirmwareDefine(BOOTLOADER_PROJECT, "platform_defines.h", "APP_START_ADDR")
+	no_key_size, nb_skipped, build_name = bootloaderSize([])
+	key_size, nb_skipped, build_name = bootloaderSize(["BUNDLE_SIGNING_PUBLIC_KEY={0}"])
+	print "Bootloader size, " + build_name + ", " + str(nb_skipped) + " sources left out"
+	print "No key:".ljust(40), ("%d bytes" % no_key_size).rjust(20)
+	print "Key provided, crc32 check only:".ljust(40), ("%d bytes" % key_size).rjust(20), ("%d bytes limit" % flash_limit).rjust(32), "fits" if key_size <= flash_limit else "OVER THE LIMIT"
+	return key_size == no_key_size and key_size <= flash_limit
+
+
+def runBundleSignatureHostTest():
+	library = loadSignatureLibrary()
+	all_ok = runHashTests(library)
+	all_ok = runEd25519Tests(library) and all_ok
+	print ""
+	all_ok = runBundleTests(library) and all_ok
+	print ""
+	all_ok = runApplicationCheckTests(library) and all_ok
+	print ""
+	runSignatureBenchmark(library)
+	print ""
+	all_ok = runBootloaderSizeEstimate() and all_ok
+
+	if all_ok:
+		print "All bundle signature tests passed"
+	else:
+		print "Bundle signature tests failed"
+	return all_ok
@@ -0,0 +1,1071 @@
+#!/usr/bin/env python2
+from host_firmware import *
+from array import array
+import usb.core
+import _ctypes
+import random
+import ctypes
+import struct
+
+# Host builds of the main & aux MCU communication stacks driven back to back: the aux MCU USB reassembly (comms_usb.c)
+# and main MCU link (comms_main_mcu.c), the main MCU aux link, command parsers & streams (comms_aux_mcu.c,
+# comms_hid_msgs*.c, comms_stream.c), the BLE enabling (logic_aux_mcu.c) and the credential batch storage (logic_user.c, nodemgmt.c), both with their
+# DMA/dma.c. The DMA controller & the USART between them are simulated, as are the USB frames on the aux MCU side.
+# Simulated time only covers the bus transfers and the waits of the stand-ins: CPU time isn't simulated
+
+# USB full speed interrupt endpoints, bInterval = 1: one packet per frame and direction
+HOST_USB_FRAME_NS = 1000000
+HOST_USB_PACKET_SIZE = 64
+# HID message bytes per packet, after the payload length & flip bit and the packet id bytes
+HOST_USB_PACKET_PAYLOAD = HOST_USB_PACKET_SIZE - 2
+# Simulation step: MCU main loops & link transfers
+HOST_COMMS_STEP_NS = 20000
+# Main MCU main loop answer restriction, msg_restrict_type_te in defines.h
+MSG_NO_RESTRICT = 0
+# Aux <> main MCU messages, comms_aux_mcu.h
+AUX_MCU_MESSAGE_SIZE = 544
+AUX_MCU_MSG_TYPE_USB = 0x0000
+AUX_MCU_MSG_TYPE_BLE = 0x0001
+AUX_MCU_MSG_TYPE_PLAT_DETAILS = 0x0003
+AUX_MCU_MSG_TYPE_MAIN_MCU_CMD = 0x0004
+MAIN_MCU_COMMAND_PING = 0x0003
+HID_CMD_ID_PING = 0x0001
+HID_CMD_ID_PLAT_INFO = 0x0003
+# Aux MCU transactions, comms_aux_mcu.h
+AUX_MCU_NB_TRANSACTIONS = getFirmwareDefine(MAIN_MCU_PROJECT, "COMMS/comms_aux_mcu.h", "AUX_MCU_NB_TRANSACTIONS")
+AUX_MCU_INVALID_TRANS_HANDLE = -1
+AUX_MCU_TRANS_PENDING = 1
+AUX_MCU_TRANS_REPLIED = 2
+AUX_MCU_TRANS_TIMEOUT = 3
+AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS = getFirmwareDefine(MAIN_MCU_PROJECT, "defines.h", "AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS")
+BLE_ENABLE_TIMEOUT_MS = getFirmwareDefine(MAIN_MCU_PROJECT, "defines.h", "BLE_ENABLE_TIMEOUT_MS")
+# ATBTLC1000 chip ID given by the aux MCU stand-in
+HOST_ATBTLC_CHIP_ID = 0x2000B0
+# DB flash SPI byte time, SERCOM clocked by the 48MHz main clock, and AT45DB081E page erase & program through buffer, typical
+HOST_DBFLASH_BYTE_NS = 8 * 2 * (getFirmwareDefine(MAIN_MCU_PROJECT, "platform_defines.h", "DBFLASH_BAUD_DIVIDER") + 1) * 1000 / 48
+HOST_DBFLASH_PAGE_WRITE_NS = 15000000
+
+MAIN_COMMS_SOURCES = ["utils.c", "COMMS/comms_aux_mcu.c", "COMMS/comms_hid_msgs.c", "COMMS/comms_hid_msgs_debug.c", "COMMS/comms_stream.c", "../../common/COMMS/comms_trace.c",
+						"LOGIC/logic_aux_mcu.c", "LOGIC/logic_user.c", "LOGIC/logic_encryption.c", "LOGIC/logic_security.c", "NODEMGMT/nodemgmt.c", "SECURITY/aes.c", "SECURITY/aes256_ctr.c", "SECURITY/sha256.c",
+						"ASF/common/utils/interrupt/interrupt_sam_nvic.c"]
+AUX_COMMS_SOURCES = ["COMMS/comms_usb.c", "COMMS/comms_main_mcu.c", "../../common/COMMS/comms_trace.c", "ASF/common/utils/interrupt/interrupt_sam_nvic.c"]
+
+# DMA controller & USART link, compiled with the MCU DMA/dma.c. Channel registers are banked on CHID: each channel gets its
+# own copy of the register block, a CHID written in the current copy selects the one used by the next accesses.
+# Sent messages are copied to the link when the transfer starts, the link then stays busy for their duration. Received
+# bytes are written by the RX channel as they arrive, and lost if it isn't armed. Transfer complete interrupts are run
+# once interrupts are enabled, so the ones started in critical sections end when these sections do
+HOST_LINK_STANDINS = r"""
+#include <asf.h>
+#include "platform_defines.h"
+#include "defines.h"
+/* USART, 10 bits per byte */
+#define HOST_LINK_BYTES_NS(nb)      ((uint64_t)(nb) * 10ULL * 1000000000ULL / host_link_baudrate)
+#define HOST_LINK_QUEUE_LENGTH      16
+#define HOST_DMAC_NB_CHANNELS       12
+
+static Dmac host_dmac_banks[HOST_DMAC_NB_CHANNELS];
+static uint8_t host_dmac_channel = 0;
+
+static Dmac* host_dmac_bank(void)
+{
+	uint8_t channel = host_dmac_banks[host_dmac_channel].CHID.bit.ID;
+	if (channel != host_dmac_channel)
+	{
+		host_dmac_banks[channel].CHID.reg = host_dmac_banks[host_dmac_channel].CHID.reg;
+		host_dmac_channel = channel;
+	}
+	return &host_dmac_banks[channel];
+}
+
+#undef DMAC
+#define DMAC (host_dmac_bank())
+#define dma_dbflash_init_transfer host_unused_dma_dbflash_init_transfer
+#define dma_dbflash_check_and_clear_dma_transfer_flag host_unused_dma_dbflash_check_and_clear_dma_transfer_flag
+#include "dma.c"
+#undef dma_dbflash_init_transfer
+#undef dma_dbflash_check_and_clear_dma_transfer_flag
+
+typedef struct
+{
+	uint8_t data[sizeof(aux_mcu_message_t)];
+	uint16_t length;
+	uint64_t start_ns;
+} host_link_message_t;
+
+static host_link_message_t host_link_tx_queue[HOST_LINK_QUEUE_LENGTH];
+static host_link_message_t host_link_rx_queue[HOST_LINK_QUEUE_LENGTH];
+static uint16_t host_link_tx_write_seq = 0, host_link_tx_read_seq = 0;
+static uint16_t host_link_rx_write_seq = 0, host_link_rx_read_seq = 0, host_link_rx_offset = 0;
+static uint64_t host_link_tx_free_ns = 0;
+static BOOL host_dmac_rx_active = FALSE;
+static uint8_t* host_dmac_rx_dst;
+static BOOL host_dmac_pending[HOST_DMAC_NB_CHANNELS];
+static BOOL host_dmac_in_isr = FALSE;
+uint32_t host_link_nb_tx_messages = 0;
+uint32_t host_link_nb_dropped_bytes = 0;
+/* 48MHz, 8x oversampling, BAUD = 0 => 6Mbps. Sent messages start after a random idle time of up to host_link_jitter_ns */
+uint64_t host_link_baudrate = 6000000ULL;
+uint64_t host_link_jitter_ns = 0;
+uint32_t host_link_jitter_seed = 1;
+
+static void host_dmac_run_pending(void)
+{
+	if ((host_primask != 0) || (host_dmac_in_isr != FALSE))
+	{
+		return;
+	}
+	host_dmac_in_isr = TRUE;
+	for (uint16_t i = 0; i < HOST_DMAC_NB_CHANNELS; i++)
+	{
+		if (host_dmac_pending[i] != FALSE)
+		{
+			host_dmac_pending[i] = FALSE;
+			host_dmac_banks[i].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+			DMAC_Handler();
+			host_dmac_banks[i].CHINTFLAG.reg = 0;
+			i = (uint16_t)-1;
+		}
+	}
+	host_dmac_in_isr = FALSE;
+}
+
+static void host_dmac_start_channels(void)
+{
+	Dmac* tx_bank = &host_dmac_banks[DMA_DESCID_TX_COMMS];
+	Dmac* rx_bank = &host_dmac_banks[DMA_DESCID_RX_COMMS];
+
+	if ((tx_bank->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) != 0)
+	{
+		DmacDescriptor* descriptor_pt = &dma_descriptors[DMA_DESCID_TX_COMMS];
+		uint16_t length = descriptor_pt->BTCNT.reg;
+		if ((uint16_t)(host_link_tx_write_seq - host_link_tx_read_seq) >= HOST_LINK_QUEUE_LENGTH)
+		{
+			__builtin_trap();
+		}
+
+		/* Firmware waits for the previous transfer before starting this one */
+		if (host_sim_ns < host_link_tx_free_ns)
+		{
+			host_sim_ns = host_link_tx_free_ns;
+		}
+		uint64_t start_ns = host_sim_ns;
+		if (host_link_jitter_ns != 0)
+		{
+			host_link_jitter_seed = host_link_jitter_seed * 1103515245UL + 12345UL;
+			start_ns += (host_link_jitter_seed >> 8) % (host_link_jitter_ns + 1);
+		}
+		host_link_message_t* message_pt = &host_link_tx_queue[host_link_tx_write_seq++ % HOST_LINK_QUEUE_LENGTH];
+		memcpy(message_pt->data, (uint8_t*)(uintptr_t)(descriptor_pt->SRCADDR.reg - length), length);
+		message_pt->length = length;
+		message_pt->start_ns = start_ns;
+		host_link_tx_free_ns = start_ns + HOST_LINK_BYTES_NS(length);
+		host_link_nb_tx_messages++;
+		tx_bank->CHCTRLA.reg = 0;
+		host_dmac_pending[DMA_DESCID_TX_COMMS] = TRUE;
+	}
+
+	if ((rx_bank->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) == 0)
+	{
+		host_dmac_rx_active = FALSE;
+	}
+	else if (host_dmac_rx_active == FALSE)
+	{
+		DmacDescriptor* descriptor_pt = &dma_descriptors[DMA_DESCID_RX_COMMS];
+		host_dmac_rx_active = TRUE;
+		host_dmac_rx_dst = (uint8_t*)(uintptr_t)(descriptor_pt->DSTADDR.reg - descriptor_pt->BTCNT.reg);
+		dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg = descriptor_pt->BTCNT.reg;
+	}
+}
+
+static void host_link_irq_enabled(void)
+{
+	host_dmac_start_channels();
+	host_dmac_run_pending();
+}
+
+__attribute__((constructor)) static void host_link_init(void)
+{
+	host_irq_enabled_hook = host_link_irq_enabled;
+}
+
+/* Bytes received until the current simulated time */
+static void host_link_receive(void)
+{
+	while (host_link_rx_read_seq != host_link_rx_write_seq)
+	{
+		host_link_message_t* message_pt = &host_link_rx_queue[host_link_rx_read_seq % HOST_LINK_QUEUE_LENGTH];
+		while ((host_link_rx_offset < message_pt->length) && (message_pt->start_ns + HOST_LINK_BYTES_NS(host_link_rx_offset + 1) <= host_sim_ns))
+		{
+			host_dmac_start_channels();
+			if (host_dmac_rx_active == FALSE)
+			{
+				host_link_nb_dropped_bytes++;
+			}
+			else
+			{
+				*host_dmac_rx_dst++ = message_pt->data[host_link_rx_offset];
+				if (--dma_writeback_descriptors[DMA_DESCID_RX_COMMS].BTCNT.reg == 0)
+				{
+					host_dmac_rx_active = FALSE;
+					host_dmac_banks[DMA_DESCID_RX_COMMS].CHCTRLA.reg = 0;
+					host_dmac_pending[DMA_DESCID_RX_COMMS] = TRUE;
+					host_dmac_run_pending();
+				}
+			}
+			host_link_rx_offset++;
+		}
+		if (host_link_rx_offset < message_pt->length)
+		{
+			return;
+		}
+		host_link_rx_read_seq++;
+		host_link_rx_offset = 0;
+	}
+}
+
+/* Move the MCU to the given simulated time if it isn't past it: start armed transfers, receive bytes, run interrupts */
+void host_link_run(uint64_t now_ns)
+{
+	if (host_sim_ns < now_ns)
+	{
+		host_sim_ns = now_ns;
+	}
+	host_dmac_start_channels();
+	host_link_receive();
+	host_dmac_run_pending();
+}
+
+/* Oldest sent message: returns its length, 0 if none */
+uint16_t host_link_pop_tx(uint8_t* data, uint64_t* start_ns)
+{
+	if (host_link_tx_read_seq == host_link_tx_write_seq)
+	{
+		return 0;
+	}
+	host_link_message_t* message_pt = &host_link_tx_queue[host_link_tx_read_seq++ % HOST_LINK_QUEUE_LENGTH];
+	memcpy(data, message_pt->data, message_pt->length);
+	*start_ns = message_pt->start_ns;
+	return message_pt->length;
+}
+
+/* Message sent by the other MCU */
+void host_link_push_rx(uint8_t* data, uint16_t length, uint64_t start_ns)
+{
+	if ((uint16_t)(host_link_rx_write_seq - host_link_rx_read_seq) >= HOST_LINK_QUEUE_LENGTH)
+	{
+		__builtin_trap();
+	}
+	host_link_message_t* message_pt = &host_link_rx_queue[host_link_rx_write_seq++ % HOST_LINK_QUEUE_LENGTH];
+	memcpy(message_pt->data, data, length);
+	message_pt->length = length;
+	message_pt->start_ns = start_ns;
+}
+
+/* Nothing being sent or received */
+BOOL host_link_is_idle(void)
+{
+	return ((host_link_rx_read_seq == host_link_rx_write_seq) && (host_sim_ns >= host_link_tx_free_ns))? TRUE : FALSE;
+}
+
+BOOL host_no_comms = FALSE;
+BOOL host_no_comms_get(void) { return host_no_comms; }
+void host_no_comms_set(BOOL no_comms) { host_no_comms = no_comms; }
+"""
+
+# Main MCU: no comms line, OLED & dataflash used by the debug streams, smartcard, RNG and the rest of the platform
+HOST_MAIN_COMMS_STANDINS = r"""
+#include "logic_encryption.h"
+#include "logic_security.h"
+#include "gui_dispatcher.h"
+#include "logic_aux_mcu.h"
+#include "gui_prompts.h"
+#include "comms_aux_mcu.h"
+#include "driver_sercom.h"
+#include "dataflash.h"
+#include "smartcard_highlevel.h"
+#include "custom_fs.h"
+#include "nodemgmt.h"
+#include "lis2hh12.h"
+#include "sh1122.h"
+#include "utils.h"
+#include "main.h"
+#include "rng.h"
+/* SPI byte times, SERCOMs clocked by the 48MHz main clock */
+#define HOST_SPI_BYTE_NS(baud_div)  (8ULL * 2ULL * ((baud_div) + 1ULL) * 1000000000ULL / CPU_SPEED_HF)
+
+sh1122_descriptor_t plat_oled_descriptor = {.sercom_pt = OLED_SERCOM};
+spi_flash_descriptor_t dataflash_descriptor = {.sercom_pt = DATAFLASH_SERCOM};
+accelerometer_descriptor_t acc_descriptor;
+uint32_t host_oled_nb_bytes = 0;
+uint32_t host_dataflash_nb_bytes = 0;
+
+void platform_io_set_no_comms(void) { host_no_comms = TRUE; }
+void platform_io_clear_no_comms(void) { host_no_comms = FALSE; }
+void platform_io_enable_ble(void) {}
+BOOL platform_io_is_usb_3v3_present(void) { return TRUE; }
+
+void sh1122_set_row_address(sh1122_descriptor_t* oled_descriptor, uint8_t address) {}
+void sh1122_set_column_address(sh1122_descriptor_t* oled_descriptor, uint8_t start) {}
+void sh1122_start_data_sending(sh1122_descriptor_t* oled_descriptor) {}
+void sh1122_stop_data_sending(sh1122_descriptor_t* oled_descriptor) {}
+RET_TYPE sh1122_refresh_used_font(sh1122_descriptor_t* oled_descriptor, uint16_t font_id) { return RETURN_OK; }
+void sercom_spi_send_single_byte_without_receive_wait(Sercom* sercom_pt, uint8_t data) { host_oled_nb_bytes++; host_sim_ns += HOST_SPI_BYTE_NS(OLED_BAUD_DIVIDER); }
+void sercom_spi_wait_for_transmit_complete(Sercom* sercom_pt) {}
+void dataflash_write_array_to_memory(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length) { host_dataflash_nb_bytes += length; host_sim_ns += length * HOST_SPI_BYTE_NS(DATAFLASH_BAUD_DIVIDER); }
+RET_TYPE dataflash_is_busy(spi_flash_descriptor_t* descriptor_pt) { return RETURN_NOK; }
+void dataflash_bulk_erase_without_wait(spi_flash_descriptor_t* descriptor_pt) {}
+ret_type_te custom_fs_init(void) { return RETURN_OK; }
+RET_TYPE custom_fs_get_file_address(uint32_t file_id, custom_fs_address_t* address, custom_fs_file_type_te file_type) { return RETURN_NOK; }
+RET_TYPE custom_fs_read_from_flash(uint8_t* datap, custom_fs_address_t address, uint32_t size) { memset(datap, 0xFF, size); return RETURN_OK; }
+RET_TYPE custom_fs_check_external_bundle_signature(void) { return RETURN_NOK; }
+void custom_fs_settings_set_fw_upgrade_flag(void) {}
+uint16_t custom_fs_get_nb_free_cpz_lut_entries(uint8_t* first_available_user_id) { *first_available_user_id = 0; return 1; }
+RET_TYPE custom_fs_store_cpz_entry(cpz_lut_entry_t* cpz_entry, uint8_t user_id) { return RETURN_OK; }
+gui_render_stats_t* gui_dispatcher_get_render_stats(void) { static gui_render_stats_t stats; return &stats; }
+void gui_dispatcher_reset_render_stats(void) {}
+BOOL lis2hh12_check_data_received_flag_and_arm_other_transfer(accelerometer_descriptor_t* descriptor_pt) { return FALSE; }
+void smartcard_highlevel_write_security_code(volatile uint16_t* code) {}
+RET_TYPE smartcard_highlevel_write_aes_key(uint8_t* buffer) { return RETURN_OK; }
+void smartcard_highlevel_write_protected_zone(uint8_t* buffer) {}
+RET_TYPE rng_fill_array(uint8_t* array, uint16_t nb_bytes) { memset(array, 0x5A, nb_bytes); return RETURN_OK; }
+
+/* Blocking handlers wait for the message they were called for: the link runs until its last byte */
+extern volatile uint16_t aux_mcu_rx_dma_seq, aux_mcu_rx_read_seq;
+void comms_aux_mcu_wait_for_message_received(void)
+{
+	while (aux_mcu_rx_dma_seq == aux_mcu_rx_read_seq)
+	{
+		host_link_run(host_sim_ns + HOST_LINK_BYTES_NS(1));
+	}
+}
+
+/* User prompts: answered at once, last prompt string kept for the harness */
+mini_input_yes_no_ret_te host_prompt_answer = MINI_INPUT_RET_YES;
+uint32_t host_nb_prompts = 0;
+cust_char_t host_prompt_string[64];
+mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_string_confirmation(cust_char_t* string_to_display, BOOL flash_screen)
+{
+	memset(host_prompt_string, 0, sizeof(host_prompt_string));
+	memcpy(host_prompt_string, string_to_display, utils_strlen(string_to_display)*sizeof(cust_char_t));
+	host_nb_prompts++;
+	return host_prompt_answer;
+}
+
+/* Empty user profile, logged in as with an unlocked card */
+void host_comms_login_user(void)
+{
+	cpz_lut_entry_t cpz_entry;
+	uint8_t card_aes_key[AES_KEY_LENGTH/8];
+
+	host_dbflash_erase();
+	nodemgmt_format_user_profile(0);
+	nodemgmt_init_context(0);
+	memset(&cpz_entry, 0, sizeof(cpz_entry));
+	memset(card_aes_key, 0x5A, sizeof(card_aes_key));
+	logic_encryption_init_context(card_aes_key, &cpz_entry);
+	logic_security_smartcard_unlocked_actions();
+}
+"""
+
+# Aux MCU: USB endpoints served by the simulated frames, no comms line, BLE, battery & keyboard
+HOST_AUX_COMMS_STANDINS = r"""
+#include "hid_keyboard_app.h"
+#include "comms_main_mcu.h"
+#include "logic_keyboard.h"
+#include "logic_battery.h"
+#include "at_ble_api.h"
+#include "comms_usb.h"
+#include "logic.h"
+#include "main.h"
+#include "usb.h"
+#include "udc.h"
+
+#define HOST_USB_FRAME_NS           1000000ULL
+#define HOST_USB_IN_QUEUE_LENGTH    64
+
+static uint8_t* host_usb_recv_buffer = 0;
+static uint8_t host_usb_in_packets[HOST_USB_IN_QUEUE_LENGTH][USB_RAWHID_TX_SIZE];
+static uint16_t host_usb_in_sizes[HOST_USB_IN_QUEUE_LENGTH];
+static uint64_t host_usb_in_frames_ns[HOST_USB_IN_QUEUE_LENGTH];
+static uint16_t host_usb_in_write_seq = 0, host_usb_in_read_seq = 0;
+static uint64_t host_usb_in_last_frame_ns = 0;
+uint64_t host_usb_send_wait_ns = 0, host_usb_send_max_wait_ns = 0;
+
+void usb_recv(int ep, uint8_t* data, int size) { host_usb_recv_buffer = data; }
+BOOL platform_io_is_no_comms_asserted(void) { return host_no_comms; }
+static BOOL host_ble_enabled = FALSE;
+BOOL logic_is_ble_enabled(void) { return host_ble_enabled; }
+void logic_set_ble_enabled(void) { host_ble_enabled = TRUE; }
+void mini_ble_init(void) {}
+at_ble_status_t at_ble_addr_get(at_ble_addr_t *address) { memset(address, 0, sizeof(*address)); return AT_BLE_SUCCESS; }
+at_ble_status_t at_ble_chip_id_get(uint32_t *chip_id) { *chip_id = """ + str(HOST_ATBTLC_CHIP_ID) + r"""; return AT_BLE_SUCCESS; }
+at_ble_status_t at_ble_firmware_version_get(uint32_t *fw_version) { *fw_version = 0; return AT_BLE_SUCCESS; }
+at_ble_status_t at_ble_rf_version_get(uint32_t *rf_version) { *rf_version = 0; return AT_BLE_SUCCESS; }
+void logic_battery_start_charging(lb_nimh_charge_scheme_te charging_type) {}
+lb_state_machine_te logic_battery_get_charging_status(void) { return (lb_state_machine_te)0; }
+int16_t logic_battery_get_charging_current(void) { return 0; }
+uint16_t logic_battery_get_vbat(void) { return 0; }
+void logic_keyboard_deal_with_type_message(aux_mcu_message_t* message) {}
+void main_standby_sleep(BOOL startup_run) {}
+void main_set_bootloader_flag(void) {}
+void udc_attach(void) {}
+
+/* Message sent to the main MCU by the host harness, the DMA reads it from the low addresses the firmware runs at */
+void host_comms_send_to_main(uint8_t* message, uint16_t length)
+{
+	static aux_mcu_message_t host_message;
+	dma_wait_for_main_mcu_packet_sent();
+	memset(&host_message, 0, sizeof(host_message));
+	memcpy(&host_message, message, length);
+	comms_main_mcu_send_message(&host_message, sizeof(host_message));
+}
+
+/* IN packet: given the first USB frame it can be sent in, one packet per frame. The send callback is called at once so
+ * the firmware TX queue mirrors the packets queued here: when COMMS_USB_TX_QUEUE_SIZE of them aren't sent yet, the
+ * comms_usb_get_free_tx_packet() spin is simulated by moving the clock to the frame the oldest one is sent in */
+void usb_send(int ep, uint8_t* data, int size)
+{
+	if (host_usb_in_write_seq >= COMMS_USB_TX_QUEUE_SIZE)
+	{
+		uint64_t oldest_frame_ns = host_usb_in_frames_ns[(uint16_t)(host_usb_in_write_seq - COMMS_USB_TX_QUEUE_SIZE) % HOST_USB_IN_QUEUE_LENGTH];
+		if (oldest_frame_ns > host_sim_ns)
+		{
+			uint64_t wait_ns = oldest_frame_ns - host_sim_ns;
+			host_usb_send_wait_ns += wait_ns;
+			if (wait_ns > host_usb_send_max_wait_ns)
+			{
+				host_usb_send_max_wait_ns = wait_ns;
+			}
+			host_sim_ns = oldest_frame_ns;
+		}
+	}
+	uint64_t frame_ns = (host_sim_ns / HOST_USB_FRAME_NS + 1) * HOST_USB_FRAME_NS;
+	if ((uint16_t)(host_usb_in_write_seq - host_usb_in_read_seq) >= HOST_USB_IN_QUEUE_LENGTH)
+	{
+		__builtin_trap();
+	}
+	if ((host_usb_in_write_seq != 0) && (frame_ns <= host_usb_in_last_frame_ns))
+	{
+		frame_ns = host_usb_in_last_frame_ns + HOST_USB_FRAME_NS;
+	}
+	uint16_t index = host_usb_in_write_seq++ % HOST_USB_IN_QUEUE_LENGTH;
+	memcpy(host_usb_in_packets[index], data, size);
+	host_usb_in_sizes[index] = size;
+	host_usb_in_frames_ns[index] = frame_ns;
+	host_usb_in_last_frame_ns = frame_ns;
+	comms_usb_raw_hid_send_callback();
+}
+
+/* USB frame, OUT: packet received if the endpoint is armed, otherwise NAKed */
+BOOL host_usb_out(uint8_t* packet, uint16_t size)
+{
+	uint8_t* buffer = host_usb_recv_buffer;
+	if (buffer == 0)
+	{
+		return FALSE;
+	}
+	host_usb_recv_buffer = 0;
+	memcpy(buffer, packet, size);
+	comms_usb_raw_hid_recv_callback(size);
+	return TRUE;
+}
+
+/* USB frame, IN: packet sent in the given frame, if any */
+uint16_t host_usb_in(uint8_t* packet, uint64_t frame_ns)
+{
+	if ((host_usb_in_read_seq == host_usb_in_write_seq) || (host_usb_in_frames_ns[host_usb_in_read_seq % HOST_USB_IN_QUEUE_LENGTH] > frame_ns))
+	{
+		return 0;
+	}
+	uint16_t index = host_usb_in_read_seq++ % HOST_USB_IN_QUEUE_LENGTH;
+	memcpy(packet, host_usb_in_packets[index], host_usb_in_sizes[index]);
+	return host_usb_in_sizes[index];
+}
+"""
+
+
+def loadMainCommsLibrary(defines=[]):
+	return loadHostFirmware(MAIN_MCU_PROJECT, MAIN_COMMS_SOURCES, HOST_TIMER_STANDINS + HOST_DBFLASH_STANDINS + HOST_LINK_STANDINS + HOST_MAIN_COMMS_STANDINS, defines, replaced_functions=["comms_aux_mcu_wait_for_message_received"])
+
+
+def loadAuxCommsLibrary(defines=[]):
+	return loadHostFirmware(AUX_MCU_PROJECT, AUX_COMMS_SOURCES, HOST_TIMER_STANDINS + HOST_LINK_STANDINS + HOST_AUX_COMMS_STANDINS, defines)
+
+
+# Simulated endpoint, mimics the pyusb endpoint methods used by generic_hid_device
+class host_endpoint:
+
+	def __init__(self, write_function, read_function):
+		self.wMaxPacketSize = HOST_USB_PACKET_SIZE
+		self.write_function = write_function
+		self.read_function = read_function
+
+	def write(self, data, timeout=None):
+		return self.write_function(data)
+
+	def read(self, size, timeout=None):
+		return self.read_function(size, timeout)
+
+
+# Host built device: both MCU libraries run on a shared simulated clock, in steps of HOST_COMMS_STEP_NS. At each step the
+# messages sent on the link are moved to the other MCU, then the main loops of the MCUs that aren't busy are run.
+# Every USB frame, the host sends one OUT packet if the aux MCU endpoint is armed and receives one IN packet.
+# Limits: CPU time isn't simulated, only transfers & waits are, and as nothing runs the interrupts of an MCU while it
+# waits in a loop, waits on the other MCU within a call (e.g. comms_aux_mcu_active_wait) can't end. The time taken by
+# the rest of the main MCU main loop (GUI, smartcard...) is set by main_loop_ns: aux MCU messages are dealt with once per period.
+# The aux MCU main loop period is random, up to aux_loop_ns_max. callMainBlocking() runs a main MCU function that waits for
+# the aux MCU: the aux MCU and the link then run from the main MCU timer polls.
+# link_crc builds both MCUs with AUX_LINK_CRC_ENABLED. Each message moved on the link gets its data bits flipped with a
+# bit_error_rate probability, or is entirely lost with a message_loss_rate probability
+class host_device:
+
+	# Device constructor: libraries booted as the firmwares do, user logged in before the flash timings are set
+	def __init__(self, trace_enabled=False, main_loop_ns=0, baudrate=6000000, jitter_ns=0, aux_loop_ns_max=0, seed=1, link_crc=False, bit_error_rate=0, message_loss_rate=0):
+		defines = ["AUX_LINK_CRC_ENABLED"] if link_crc else []
+		self.main = loadMainCommsLibrary(defines)
+		self.aux = loadAuxCommsLibrary(defines)
+		for library in [self.main, self.aux]:
+			library.host_sim_get_ns.restype = ctypes.c_uint64
+			library.host_link_run.argtypes = [ctypes.c_uint64]
+			library.host_link_push_rx.argtypes = [ctypes.c_char_p, ctypes.c_uint16, ctypes.c_uint64]
+			library.host_link_pop_tx.restype = ctypes.c_uint16
+			ctypes.c_uint64.in_dll(library, "host_link_baudrate").value = baudrate
+			ctypes.c_uint64.in_dll(library, "host_link_jitter_ns").value = jitter_ns
+		self.aux.host_usb_in.argtypes = [ctypes.c_char_p, ctypes.c_uint64]
+		self.aux.host_usb_in.restype = ctypes.c_uint16
+		ctypes.c_uint32.in_dll(self.aux, "host_link_jitter_seed").value = 2
+		self.trace_enabled = trace_enabled
+		self.main_loop_ns = main_loop_ns
+		self.next_main_loop_ns = 0
+		self.aux_loop_ns_max = aux_loop_ns_max
+		self.next_aux_loop_ns = 0
+		self.random = random.Random(seed)
+		self.bit_error_rate = bit_error_rate
+		self.message_loss_rate = message_loss_rate
+		self.link_random = random.Random(seed)
+		self.nb_corrupted_messages = 0
+		self.nb_lost_messages = 0
+		self.now_ns = 0
+		# Aux MCU main loop not run when set. Log of the time spent in each main MCU main loop in the aux MCU routine, of the time spent in each aux MCU main loop
+		self.aux_silent = False
+		self.main_loop_stalls = None
+		self.aux_loop_stalls = None
+		# Messages the MCUs send one per main loop, the aux MCU when the main MCU doesn't ask to hold. Log of the link messages: (source is main, start, bytes)
+		self.aux_messages = []
+		self.main_messages = []
+		self.link_log = None
+		self.next_frame_ns = HOST_USB_FRAME_NS
+		self.out_packets = []
+		self.in_packets = []
+		self.nb_out_naks = 0
+		self.link_buffer = ctypes.create_string_buffer(1024)
+		self.link_start_ns = ctypes.c_uint64(0)
+		self.usb_buffer = ctypes.create_string_buffer(HOST_USB_PACKET_SIZE)
+		self.main.dma_init()
+		self.main.comms_aux_arm_rx_and_clear_no_comms()
+		self.main.host_comms_login_user()
+		ctypes.c_uint64.in_dll(self.main, "host_dbflash_byte_ns").value = HOST_DBFLASH_BYTE_NS
+		ctypes.c_uint64.in_dll(self.main, "host_dbflash_page_write_ns").value = HOST_DBFLASH_PAGE_WRITE_NS
+		self.aux.dma_init()
+		self.aux.comms_main_init_rx()
+		self.aux.comms_usb_configuration_callback(1)
+		self.epout = host_endpoint(self.usbPacketSent, None)
+		self.epin = host_endpoint(None, self.readUsbPacket)
+
+	# Current simulated time, in seconds
+	def getTime(self):
+		return self.now_ns / 1e9
+
+	# Nothing to reset
+	def reset(self):
+		pass
+
+	# Unload the libraries: they are all linked at the same low address, the next device can only be loaded there once they are gone
+	def close(self):
+		for library in [self.main, self.aux]:
+			_ctypes.dlclose(library._handle)
+		self.main = None
+		self.aux = None
+
+	# Move the messages sent by an MCU to the other one
+	def moveLinkMessages(self, source, destination):
+		while True:
+			length = source.host_link_pop_tx(self.link_buffer, ctypes.byref(self.link_start_ns))
+			if length == 0:
+				return
+			if self.link_log is not None:
+				self.link_log.append((source == self.main, self.link_start_ns.value, self.link_buffer.raw[0:length]))
+			if self.message_loss_rate != 0 and self.link_random.random() < self.message_loss_rate:
+				self.nb_lost_messages += 1
+				continue
+			data = self.link_buffer.raw[0:length]
+			if self.bit_error_rate != 0:
+				data = self.addBitErrors(data)
+			destination.host_link_push_rx(data, length, self.link_start_ns.value)
+
+	# Flip each data bit of a message with bit_error_rate probability: bit positions between errors are exponentially distributed
+	def addBitErrors(self, data):
+		message = array('B', data)
+		bit_position = int(self.link_random.expovariate(self.bit_error_rate))
+		if bit_position >= len(message) * 8:
+			return data
+		self.nb_corrupted_messages += 1
+		while bit_position < len(message) * 8:
+			message[bit_position / 8] ^= 1 << (bit_position % 8)
+			bit_position += 1 + int(self.link_random.expovariate(self.bit_error_rate))
+		return message.tostring()
+
+	# Simulation step, without the main MCU main loop while the main MCU waits in a blocking call
+	def step(self, run_main=True):
+		self.now_ns += HOST_COMMS_STEP_NS
+
+		# USB frame, OUT packet NAKed when the aux MCU endpoint isn't armed
+		if self.now_ns >= self.next_frame_ns:
+			self.aux.host_link_run(self.now_ns)
+			if len(self.out_packets) != 0:
+				if self.aux.host_usb_out(self.out_packets[0], len(self.out_packets[0])):
+					self.out_packets.pop(0)
+				else:
+					self.nb_out_naks += 1
+			length = self.aux.host_usb_in(self.usb_buffer, self.next_frame_ns)
+			if length != 0:
+				self.in_packets.append(array('B', self.usb_buffer.raw[0:length]))
+			self.next_frame_ns += HOST_USB_FRAME_NS
+
+		# Links, then main loops
+		self.main.host_link_run(self.now_ns)
+		self.aux.host_link_run(self.now_ns)
+		self.moveLinkMessages(self.main, self.aux)
+		self.moveLinkMessages(self.aux, self.main)
+		self.aux.host_no_comms_set(self.main.host_no_comms_get())
+		if self.aux.host_sim_get_ns() <= self.now_ns and self.now_ns >= self.next_aux_loop_ns and not self.aux_silent:
+			start_ns = self.aux.host_sim_get_ns()
+			self.aux.comms_main_mcu_routine()
+			self.aux.comms_usb_communication_routine()
+			# Forwarded like comms_usb_communication_routine() does, when the main MCU doesn't ask to hold
+			if len(self.aux_messages) != 0 and not self.aux.host_no_comms_get():
+				message = self.aux_messages.pop(0)
+				self.aux.host_comms_send_to_main(message, len(message))
+			if self.trace_enabled:
+				self.aux.comms_trace_routine()
+			if self.aux_loop_stalls is not None:
+				self.aux_loop_stalls.append(self.aux.host_sim_get_ns() - start_ns)
+			self.next_aux_loop_ns = self.now_ns + self.random.randint(0, self.aux_loop_ns_max)
+		if run_main and self.main.host_sim_get_ns() <= self.now_ns and self.now_ns >= self.next_main_loop_ns:
+			start_ns = self.main.host_sim_get_ns()
+			self.main.comms_aux_mcu_routine(MSG_NO_RESTRICT)
+			if self.main_loop_stalls is not None:
+				self.main_loop_stalls.append(self.main.host_sim_get_ns() - start_ns)
+			if len(self.main_messages) != 0:
+				ctypes.memmove(ctypes.addressof(ctypes.c_char.in_dll(self.main, "aux_mcu_send_message")), self.main_messages.pop(0), AUX_MCU_MESSAGE_SIZE)
+				self.main.comms_aux_mcu_send_message(0)
+			if self.trace_enabled:
+				self.main.comms_trace_routine()
+			self.next_main_loop_ns = self.now_ns + self.main_loop_ns
+
+	# Main MCU function waiting for the aux MCU: returns its return value and the simulated time it took
+	def callMainBlocking(self, function, *args):
+		def waitHook():
+			self.now_ns = max(self.now_ns, self.main.host_sim_get_ns())
+			self.step(run_main=False)
+		hook = ctypes.CFUNCTYPE(None)(waitHook)
+		start_ns = max(self.now_ns, self.main.host_sim_get_ns())
+		ctypes.c_void_p.in_dll(self.main, "host_sim_wait_hook").value = ctypes.cast(hook, ctypes.c_void_p).value
+		try:
+			return_value = function(*args)
+		finally:
+			ctypes.c_void_p.in_dll(self.main, "host_sim_wait_hook").value = None
+		self.now_ns = max(self.now_ns, self.main.host_sim_get_ns())
+		return return_value, self.main.host_sim_get_ns() - start_ns
+
+	# Host sends a packet: returns once the aux MCU received it, in a USB frame
+	def usbPacketSent(self, data):
+		packet = array('B', data)
+		packet.extend([0] * (HOST_USB_PACKET_SIZE - len(packet)))
+		self.out_packets.append(packet.tostring())
+		while len(self.out_packets) != 0:
+			self.step()
+		return len(data)
+
+	# Host reads a packet, simulated time moves until it is received or the timeout expires
+	def readUsbPacket(self, size, timeout):
+		timeout_ns = self.now_ns + (timeout if timeout is not None else 0) * 1000000
+		while len(self.in_packets) == 0:
+			if self.now_ns >= timeout_ns:
+				raise usb.core.USBError("Host device timeout")
+			self.step()
+		return self.in_packets.pop(0)
+
+
+# Aux <> main MCU message: payload length #1 set, payload padded
+def packAuxMcuMessage(message_type, payload):
+	return struct.pack("<HH", message_type, len(payload)) + payload + "\x00" * (AUX_MCU_MESSAGE_SIZE - 4 - len(payload))
+
+
+# Bursts on the aux <> main MCU link: the aux MCU forwards bursts of HID pings the main MCU answers, then the main MCU
+# sends bursts of pings the aux MCU echoes, one message per main loop. Messages/s from the first request start to the last reply end, latencies
+# from a request start to its reply start, bytes lost by a receiver that wasn't armed
+def runLinkBurstBenchmark(nb_bursts=10, burst_lengths=[1, 4, 8, 16], baudrates=[6000000, 1000000], jitters_us=[0, 50], main_loops_us=[0, 2000]):
+	print "Direction".ljust(12), "Baud".rjust(8), "Jitter us".rjust(10), "Loop us".rjust(8), "Burst".rjust(6), "msg/s".rjust(8), "p50 ms".rjust(8), "max ms".rjust(8), "Lost B".rjust(7)
+	all_ok = True
+	for baudrate in baudrates:
+		for jitter_us in jitters_us:
+			for main_loop_us in main_loops_us:
+				device = host_device(main_loop_ns=main_loop_us*1000, baudrate=baudrate, jitter_ns=jitter_us*1000)
+				message_ns = AUX_MCU_MESSAGE_SIZE * 10 * 1000000000 / baudrate
+				for from_main in [False, True]:
+					for burst_length in burst_lengths:
+						latencies = []
+						rates = []
+						for burst in range(0, nb_bursts):
+							device.link_log = []
+							for i in range(0, burst_length):
+								if from_main:
+									device.main_messages.append(packAuxMcuMessage(AUX_MCU_MSG_TYPE_MAIN_MCU_CMD, struct.pack("<HHH", MAIN_MCU_COMMAND_PING, 0, i)))
+								else:
+									device.aux_messages.append(packAuxMcuMessage(AUX_MCU_MSG_TYPE_USB, struct.pack("<HHH", HID_CMD_ID_PING, 2, i)))
+							# Until all replies are sent
+							timeout_ns = device.now_ns + 1000000000
+							while device.now_ns < timeout_ns and len([1 for source_main, start_ns, data in device.link_log if source_main != from_main]) < burst_length:
+								device.step()
+							# Burst index: after the HID header, after the main MCU command and padding
+							requests = dict((struct.unpack("<H", data[8:10])[0], start_ns) for source_main, start_ns, data in device.link_log if source_main == from_main)
+							replies = dict((struct.unpack("<H", data[8:10])[0], start_ns) for source_main, start_ns, data in device.link_log if source_main != from_main)
+							if sorted(replies.keys()) != range(0, burst_length):
+								all_ok = False
+								break
+							latencies.extend((replies[i] - requests[i]) / 1e6 for i in range(0, burst_length))
+							rates.append(burst_length * 1e9 / (max(replies.values()) + message_ns - min(requests.values())))
+							# Idle link between bursts
+							for i in range(0, 100):
+								device.step()
+						device.link_log = None
+						lost_bytes = sum(ctypes.c_uint32.in_dll(library, "host_link_nb_dropped_bytes").value for library in [device.main, device.aux])
+						if len(latencies) != burst_length * nb_bursts:
+							print ("main > aux" if from_main else "aux > main").ljust(12), str(baudrate).rjust(8), str(jitter_us).rjust(10), str(main_loop_us).rjust(8), str(burst_length).rjust(6), "missing replies".rjust(25), str(lost_bytes).rjust(7)
+							continue
+						latencies.sort()
+						print ("main > aux" if from_main else "aux > main").ljust(12), str(baudrate).rjust(8), str(jitter_us).rjust(10), str(main_loop_us).rjust(8), str(burst_length).rjust(6), str(int(min(rates))).rjust(8), ("%.2f" % latencies[len(latencies)/2]).rjust(8), ("%.2f" % latencies[-1]).rjust(8), str(lost_bytes).rjust(7)
+						all_ok = all_ok and lost_bytes == 0
+				device.close()
+	if all_ok:
+		print "All messages answered, no bytes lost"
+	else:
+		print "Messages lost"
+	return all_ok
+
+
+# HID replies sent by the main MCU, forwarded by the aux MCU to USB: bursts of replies sent one per main MCU main loop.
+# Replies/s from the first reply start on the link to its last IN packet frame, the USB bound being one packet per 1ms
+# frame. The aux MCU main loop is unavailable while comms_usb_get_free_tx_packet() waits for a free TX queue entry: time
+# spent in each aux MCU main loop, longest single wait, and share of the burst time the main loop could run. The main MCU
+# doesn't wait for the aux MCU before sending: replies received while the aux MCU RX ring is full are dropped (overflows)
+def runUsbReplyBenchmark(nb_bursts=5, reply_sizes=[58, 250, 500], burst_lengths=[1, 4, 16], main_loop_us=0):
+	print "Bytes".rjust(6), "Packets".rjust(8), "Burst".rjust(6), "replies/s".rjust(10), "USB bound".rjust(10), "B/s".rjust(8), "aux loop mean / stddev / max ms".rjust(32), "max wait ms".rjust(12), "available".rjust(10), "Overflows".rjust(10)
+	all_ok = True
+	for reply_size in reply_sizes:
+		nb_packets = (reply_size + 4 + HOST_USB_PACKET_PAYLOAD - 1) / HOST_USB_PACKET_PAYLOAD
+		for burst_length in burst_lengths:
+			device = host_device(main_loop_ns=main_loop_us*1000)
+			device.aux_loop_stalls = []
+			rates = []
+			wait_ns = 0
+			elapsed_ns = 0
+			for burst in range(0, nb_bursts):
+				device.link_log = []
+				device.in_packets = []
+				start_wait_ns = ctypes.c_uint64.in_dll(device.aux, "host_usb_send_wait_ns").value
+				for i in range(0, burst_length):
+					device.main_messages.append(packAuxMcuMessage(AUX_MCU_MSG_TYPE_USB, struct.pack("<HH", HID_CMD_ID_PING, reply_size) + "\xA5" * reply_size))
+				timeout_ns = device.now_ns + 1000000000
+				last_packet_ns = 0
+				while device.now_ns < timeout_ns and len(device.in_packets) < burst_length * nb_packets:
+					nb_in_packets = len(device.in_packets)
+					device.step()
+					if len(device.in_packets) != nb_in_packets:
+						# Received in the frame that just ended
+						last_packet_ns = device.next_frame_ns - HOST_USB_FRAME_NS
+				nb_replies = len(device.in_packets) / nb_packets
+				all_ok = all_ok and nb_replies == burst_length
+				burst_ns = last_packet_ns - min(start_ns for source_main, start_ns, data in device.link_log if source_main)
+				rates.append(nb_replies * 1e9 / burst_ns)
+				elapsed_ns += burst_ns
+				wait_ns += ctypes.c_uint64.in_dll(device.aux, "host_usb_send_wait_ns").value - start_wait_ns
+				# Idle between bursts
+				for i in range(0, 100):
+					device.step()
+			device.link_log = None
+			max_wait_ns = ctypes.c_uint64.in_dll(device.aux, "host_usb_send_max_wait_ns").value
+			nb_overflows = ctypes.c_uint16.in_dll(device.aux, "dma_main_mcu_nb_rcv_overflows").value
+			print str(reply_size).rjust(6), str(nb_packets).rjust(8), str(burst_length).rjust(6), str(int(min(rates))).rjust(10), str(1000 / nb_packets).rjust(10), str(int(min(rates) * reply_size)).rjust(8), durationStats(device.aux_loop_stalls).rjust(32), ("%.2f" % (max_wait_ns / 1e6)).rjust(12), ("%.1f%%" % (100 - 100.0 * wait_ns / elapsed_ns)).rjust(10), str(nb_overflows).rjust(10)
+			device.close()
+	if all_ok:
+		print "All replies sent"
+	else:
+		print "Replies lost"
+	return all_ok
+
+
+# HID message from the IN packets received by the host, None until one is complete: (command, payload)
+def popUsbMessage(in_packets):
+	payload = ""
+	for i in range(0, len(in_packets)):
+		packet = in_packets[i]
+		if packet[1] >> 4 == 0:
+			payload = ""
+		payload += packet[2:2 + (packet[0] & 0x3F)].tostring()
+		if packet[1] >> 4 == packet[1] & 0x0F:
+			del in_packets[0:i+1]
+			if len(payload) < 4:
+				return (None, "")
+			command, length = struct.unpack("<HH", payload[0:4])
+			return (command, payload[4:4+length])
+	return None
+
+
+# Pings forwarded by the aux MCU to the main MCU and echoed back to USB, on a link with bit errors or lost messages, with
+# and without AUX_LINK_CRC_ENABLED. Without a reply within host_retry_ms, or with a reply that doesn't match, the host
+# sends the ping again. Goodput: ping payload bytes echoed correctly per second, latencies from the first try to the
+# correct reply. Corrupted replies are the ones a host couldn't tell from correct ones, retransmits the link ones
+def runLinkErrorBenchmark(nb_requests=100, payload_size=250, bit_error_rates=[0, 1e-6, 1e-5, 1e-4], message_loss_rates=[0.01], host_retry_ms=2000):
+	print "Scheme".ljust(8), "BER".rjust(8), "Loss".rjust(6), "Goodput B/s".rjust(12), "p50 ms".rjust(8), "p99 ms".rjust(8), "max ms".rjust(8), "Bad msgs".rjust(9), "Corrupted".rjust(10), "Host retries".rjust(13), "Link retransmits".rjust(17)
+	configurations = [(bit_error_rate, 0) for bit_error_rate in bit_error_rates] + [(0, message_loss_rate) for message_loss_rate in message_loss_rates]
+	for bit_error_rate, message_loss_rate in configurations:
+		for link_crc in [False, True]:
+			device = host_device(link_crc=link_crc, bit_error_rate=bit_error_rate, message_loss_rate=message_loss_rate)
+			latencies = []
+			nb_corrupted_replies = 0
+			nb_host_retries = 0
+			answered_payloads = set()
+			start_ns = device.now_ns
+			for i in range(0, nb_requests):
+				payload = struct.pack("<H", i) + "".join(chr(device.random.randint(0, 255)) for j in range(0, payload_size - 2))
+				first_try_ns = device.now_ns
+				while True:
+					device.aux_messages.append(packAuxMcuMessage(AUX_MCU_MSG_TYPE_USB, struct.pack("<HH", HID_CMD_ID_PING, len(payload)) + payload))
+					timeout_ns = device.now_ns + host_retry_ms * 1000000
+					reply = None
+					while reply is None and device.now_ns < timeout_ns:
+						device.step()
+						reply = popUsbMessage(device.in_packets)
+						# Late echo of a ping that was sent twice
+						if reply is not None and reply[1] in answered_payloads:
+							reply = None
+					if reply == (HID_CMD_ID_PING, payload):
+						answered_payloads.add(payload)
+						break
+					if reply is None:
+						device.in_packets = []
+					else:
+						nb_corrupted_replies += 1
+					nb_host_retries += 1
+				latencies.append((device.now_ns - first_try_ns) / 1e6)
+			goodput = int(nb_requests * payload_size * 1e9 / (device.now_ns - start_ns))
+			nb_retransmits = 0
+			if link_crc:
+				nb_retransmits = ctypes.c_uint32.in_dll(device.main, "aux_mcu_link_nb_retransmits").value + ctypes.c_uint32.in_dll(device.aux, "comms_main_mcu_link_nb_retransmits").value
+			latencies.sort()
+			print ("CRC" if link_crc else "None").ljust(8), ("%g" % bit_error_rate).rjust(8), ("%g" % message_loss_rate).rjust(6), str(goodput).rjust(12), ("%.2f" % latencies[len(latencies)/2]).rjust(8), ("%.2f" % latencies[len(latencies)*99/100]).rjust(8), ("%.2f" % latencies[-1]).rjust(8), str(device.nb_corrupted_messages + device.nb_lost_messages).rjust(9), str(nb_corrupted_replies).rjust(10), str(nb_host_retries).rjust(13), str(nb_retransmits).rjust(17)
+			device.close()
+
+
+# Mean, standard deviation & max of a list of ns durations, in ms
+def durationStats(durations_ns):
+	mean = sum(durations_ns) / float(len(durations_ns))
+	stddev = (sum((duration - mean) ** 2 for duration in durations_ns) / len(durations_ns)) ** 0.5
+	return "%.3f / %.3f / %.3f" % (mean / 1e6, stddev / 1e6, max(durations_ns) / 1e6)
+
+
+# Aux MCU transactions against an aux MCU with a random main loop period: BLE enabling & its timeout, polled transactions,
+# reply timeouts, concurrent USB & BLE platform info requests answered on their own channel. The main MCU main loop
+# stalls are its time spent in comms_aux_mcu_routine(): with CPU time not simulated, they are the waits on the aux MCU
+# and the link a GUI frame would be delayed by
+def runAuxTransactionTest(nb_requests=200, burst_length=8, aux_loop_us_max=3000, main_loop_us=2000):
+	all_ok = True
+
+	def check(name, result, details=""):
+		print name.ljust(52), "OK" if result else "FAILED", details
+		return result
+
+	# Aux MCU that never answers: BLE enabling and transactions time out
+	device = host_device(main_loop_ns=main_loop_us*1000, aux_loop_ns_max=aux_loop_us_max*1000)
+	device.aux_silent = True
+	return_value, duration_ns = device.callMainBlocking(device.main.logic_aux_mcu_enable_ble, 1)
+	all_ok &= check("BLE enable, silent aux MCU: timeout", return_value == -1 and abs(duration_ns / 1e6 - BLE_ENABLE_TIMEOUT_MS) < 2, "%.1f ms" % (duration_ns / 1e6))
+	message_pt = ctypes.c_void_p()
+	device.main.comms_aux_mcu_get_empty_packet_ready_to_be_sent(ctypes.byref(message_pt), AUX_MCU_MSG_TYPE_PLAT_DETAILS, 1)
+	handle = device.main.comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_PLAT_DETAILS, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, None, None)
+	start_ns = device.now_ns
+	while device.main.comms_aux_mcu_get_transaction_state(handle) == AUX_MCU_TRANS_PENDING:
+		device.step()
+	all_ok &= check("Transaction, silent aux MCU: timeout", device.main.comms_aux_mcu_get_transaction_state(handle) == AUX_MCU_TRANS_TIMEOUT, "%.1f ms" % ((device.now_ns - start_ns) / 1e6))
+	device.main.comms_aux_mcu_free_transaction(handle)
+	# Next transaction gets its own reply, not the late one to the timed out transaction
+	device.link_log = []
+	reply_buffer = ctypes.create_string_buffer(AUX_MCU_MESSAGE_SIZE)
+	device.main.comms_aux_mcu_get_empty_packet_ready_to_be_sent(ctypes.byref(message_pt), AUX_MCU_MSG_TYPE_PLAT_DETAILS, 1)
+	handle = device.main.comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_PLAT_DETAILS, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, reply_buffer, None)
+	# The late BLE enabled event still gets in
+	device.aux_silent = False
+	while device.main.comms_aux_mcu_get_transaction_state(handle) == AUX_MCU_TRANS_PENDING:
+		device.step()
+	request_tags = [struct.unpack("<H", data[542:544])[0] for source_main, start_ns, data in device.link_log if source_main and struct.unpack("<H", data[0:2])[0] == AUX_MCU_MSG_TYPE_PLAT_DETAILS]
+	all_ok &= check("Late reply to a timed out transaction dropped", device.main.comms_aux_mcu_get_transaction_state(handle) == AUX_MCU_TRANS_REPLIED and request_tags[-1:] == [struct.unpack("<H", reply_buffer.raw[542:544])[0]])
+	device.main.comms_aux_mcu_free_transaction(handle)
+	device.link_log = None
+	for i in range(0, 10000):
+		device.step()
+	all_ok &= check("BLE enabled by the late aux MCU event", device.main.logic_aux_mcu_is_ble_enabled() != 0)
+
+	# Aux MCU answering with random delays
+	device = host_device(main_loop_ns=main_loop_us*1000, aux_loop_ns_max=aux_loop_us_max*1000)
+	return_value, duration_ns = device.callMainBlocking(device.main.logic_aux_mcu_enable_ble, 1)
+	all_ok &= check("BLE enable", return_value == 0 and device.main.logic_aux_mcu_is_ble_enabled() != 0, "%.1f ms" % (duration_ns / 1e6))
+	blocking_stalls = []
+	chip_ids_ok = True
+	for i in range(0, 20):
+		chip_id, duration_ns = device.callMainBlocking(device.main.logic_aux_mcu_get_ble_chip_id)
+		chip_ids_ok = chip_ids_ok and chip_id == HOST_ATBTLC_CHIP_ID
+		blocking_stalls.append(duration_ns)
+		for j in range(0, 100):
+			device.step()
+	all_ok &= check("BLE chip ID, blocking transaction", chip_ids_ok)
+
+	# Polled transactions: at most AUX_MCU_NB_TRANSACTIONS pending, replies delivered in order
+	handles = []
+	for i in range(0, AUX_MCU_NB_TRANSACTIONS + 1):
+		device.main.comms_aux_mcu_get_empty_packet_ready_to_be_sent(ctypes.byref(message_pt), AUX_MCU_MSG_TYPE_PLAT_DETAILS, 1)
+		handles.append(device.main.comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_PLAT_DETAILS, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, None, None))
+	all_ok &= check("Transactions: " + str(AUX_MCU_NB_TRANSACTIONS) + " pending at most", AUX_MCU_INVALID_TRANS_HANDLE not in handles[0:-1] and handles[-1] == AUX_MCU_INVALID_TRANS_HANDLE)
+	while AUX_MCU_TRANS_PENDING in [device.main.comms_aux_mcu_get_transaction_state(handle) for handle in handles[0:-1]]:
+		device.step()
+	all_ok &= check("Transactions: all replied", [device.main.comms_aux_mcu_get_transaction_state(handle) for handle in handles[0:-1]] == [AUX_MCU_TRANS_REPLIED] * AUX_MCU_NB_TRANSACTIONS)
+	for handle in handles[0:-1]:
+		device.main.comms_aux_mcu_free_transaction(handle)
+
+	# Concurrent platform info requests from both channels in bursts, answered by transaction callbacks or at once when none is free
+	device.link_log = []
+	device.main_loop_stalls = []
+	channels = []
+	replies = []
+	for burst in range(0, nb_requests / burst_length):
+		for i in range(0, burst_length):
+			channels.append(device.random.choice([AUX_MCU_MSG_TYPE_USB, AUX_MCU_MSG_TYPE_BLE]))
+			device.aux_messages.append(packAuxMcuMessage(channels[-1], struct.pack("<HH", HID_CMD_ID_PLAT_INFO, 0)))
+		timeout_ns = device.now_ns + 1000000000
+		while device.now_ns < timeout_ns and len(replies) < len(channels):
+			device.step()
+			replies = [struct.unpack("<HHHH", data[0:8]) for source_main, start_ns, data in device.link_log if source_main and struct.unpack("<H", data[0:2])[0] in [AUX_MCU_MSG_TYPE_USB, AUX_MCU_MSG_TYPE_BLE]]
+	# Aux MCU FW version in the reply when it came from a transaction
+	nb_with_details = len([1 for source_main, start_ns, data in device.link_log if source_main and struct.unpack("<H", data[0:2])[0] in [AUX_MCU_MSG_TYPE_USB, AUX_MCU_MSG_TYPE_BLE] and data[12:16] != "\x00" * 4])
+	all_ok &= check("Platform info: one reply per request", len(replies) == len(channels) and all(reply[2] == HID_CMD_ID_PLAT_INFO for reply in replies), str(nb_with_details) + " with aux MCU details")
+	all_ok &= check("Platform info: replies on the request channels", [reply[0] for reply in replies].count(AUX_MCU_MSG_TYPE_BLE) == channels.count(AUX_MCU_MSG_TYPE_BLE))
+	device.link_log = None
+	lost_bytes = sum(ctypes.c_uint32.in_dll(library, "host_link_nb_dropped_bytes").value for library in [device.main, device.aux])
+	all_ok &= check("No link bytes lost", lost_bytes == 0)
+
+	print ""
+	print "Main MCU main loop stalls, mean / stddev / max ms, aux MCU main loop up to " + str(aux_loop_us_max) + "us:"
+	print "  concurrent platform info transactions:".ljust(52), durationStats(device.main_loop_stalls), "(" + str(len(device.main_loop_stalls)) + " loops)"
+	print "  blocking BLE chip ID requests:".ljust(52), durationStats(blocking_stalls)
+	print ("  frame period for a " + str(main_loop_us) + "us main loop:").ljust(52), durationStats([main_loop_us * 1000 + stall for stall in device.main_loop_stalls])
+	device.main_loop_stalls = None
+
+	if all_ok:
+		print "All aux MCU transaction tests passed"
+	else:
+		print "Aux MCU transaction tests failed"
+	return all_ok
+
+
+# Trace entries on a host build of the trace ring: ring drained by 32 entries so that it never gets full. Printf paths
+# format their text with vsnprintf before sending it synchronously, only that formatting is measured here
+HOST_TRACE_BENCH_HELPERS = r"""
+#include <stdarg.h>
+#include <stdio.h>
+#include "comms_trace.h"
+
+extern volatile uint16_t comms_trace_write_seq, comms_trace_read_seq;
+static hid_message_t host_trace_message;
+hid_message_t* comms_trace_get_hid_message(void) { return &host_trace_message; }
+void comms_trace_send_hid_message(void) {}
+
+static void host_trace_printf(char* buf, uint16_t size, const char* fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+}
+
+/* Host cycles of nb_calls two argument entries and of as many printf formattings of the same text */
+void host_trace_bench(uint32_t nb_calls, uint64_t* trace_cycles, uint64_t* printf_cycles)
+{
+	char buf[64];
+	*trace_cycles = 0;
+	for (uint32_t i = 0; i < nb_calls; i += 32)
+	{
+		uint64_t start_cycles = host_cycles();
+		for (uint32_t j = i; j < i + 32; j++)
+		{
+			COMMS_TRACE_2(TRACE_ID_HID_CMD_RECEIVED, j, 64);
+		}
+		*trace_cycles += host_cycles() - start_cycles;
+		comms_trace_read_seq = comms_trace_write_seq;
+	}
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_calls; i++)
+	{
+		host_trace_printf(buf, sizeof(buf), "HID command 0x%04x received, %u bytes", i, 64);
+	}
+	*printf_cycles = host_cycles() - start_cycles;
+}
+"""
+
+HID_CMD_ID_DBG_TRACE = 0x800E
+
+
+# HID message sent by the host in USB packets, alternating flip bit
+def sendUsbMessage(device, message, flip_bit):
+	nb_packets = (len(message) + HOST_USB_PACKET_PAYLOAD - 1) / HOST_USB_PACKET_PAYLOAD
+	for i in range(0, nb_packets):
+		chunk = message[i*HOST_USB_PACKET_PAYLOAD:(i+1)*HOST_USB_PACKET_PAYLOAD]
+		device.usbPacketSent(chr(flip_bit | len(chunk)) + chr((i << 4) | (nb_packets - 1)) + chunk)
+
+
+# Trace overhead: x86 cycles per entry against printf formatting, then USB pings through both host built firmwares with
+# the trace rings drained to the host or not. CPU time isn't simulated: the round trips only show the link & USB time
+# taken by the trace messages, and the x86 cycles compare the two logging paths without giving Cortex-M0+ numbers
+def runTraceOverheadBenchmark(nb_calls=320000, nb_pings=50, payload_size=250):
+	library = loadHostFirmware(MAIN_MCU_PROJECT, ["../../common/COMMS/comms_trace.c", "ASF/common/utils/interrupt/interrupt_sam_nvic.c"], HOST_TIMER_STANDINS + HOST_TRACE_BENCH_HELPERS)
+	trace_cycles = ctypes.c_uint64()
+	printf_cycles = ctypes.c_uint64()
+	library.host_trace_bench(nb_calls, ctypes.byref(trace_cycles), ctypes.byref(printf_cycles))
+	_ctypes.dlclose(library._handle)
+	print "Host cycles per call: %.1f for a trace entry, %.1f for the printf formatting alone" % (float(trace_cycles.value) / nb_calls, float(printf_cycles.value) / nb_calls)
+
+	print ""
+	print str(payload_size) + " bytes pings over USB, round trip ms"
+	print "Traces".ljust(8), "p50".rjust(8), "p99".rjust(8), "max".rjust(8), "Trace msgs".rjust(11), "Entries dropped".rjust(16)
+	for trace_enabled in [False, True]:
+		device = host_device(trace_enabled=trace_enabled)
+		latencies = []
+		nb_trace_messages = 0
+		nb_dropped_entries = 0
+		for i in range(0, nb_pings):
+			payload = struct.pack("<H", i) + "\xA5" * (payload_size - 2)
+			start_ns = device.now_ns
+			sendUsbMessage(device, struct.pack("<HH", HID_CMD_ID_PING, len(payload)) + payload, 0x80 * (i % 2))
+			while True:
+				device.step()
+				reply = popUsbMessage(device.in_packets)
+				if reply is not None and reply[0] == HID_CMD_ID_DBG_TRACE:
+					nb_trace_messages += 1
+					nb_dropped_entries += struct.unpack("<H", reply[1][2:4])[0]
+				elif reply is not None:
+					break
+			latencies.append((device.now_ns - start_ns) / 1e6)
+		latencies.sort()
+		print ("on" if trace_enabled else "off").ljust(8), ("%.2f" % latencies[len(latencies)/2]).rjust(8), ("%.2f" % latencies[len(latencies)*99/100]).rjust(8), ("%.2f" % latencies[-1]).rjust(8), str(nb_trace_messages).rjust(11), str(nb_dropped_entries).rjust(16)
+		device.close()
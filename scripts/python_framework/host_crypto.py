@@ -0,0 +1,153 @@
+#!/usr/bin/env python2
+from os.path import dirname, join, realpath
+import subprocess
+import tempfile
+import ctypes
+import shutil
+
+# Host builds of the main MCU crypto sources: compiled with the host gcc into a shared library loaded with ctypes,
+# to check them against the NIST test vectors and benchmark them
+
+MAIN_MCU_SRC_DIR = join(dirname(realpath(__file__)), "..", "..", "source_code", "main_mcu", "src")
+HOST_INCLUDE_DIRS = ["", "SECURITY", "LOGIC", "NODEMGMT", "RNG"]
+
+# Host helpers compiled along the firmware sources: context sizes and timed loops
+HOST_AES_HELPERS = r"""
+#include <time.h>
+#include "aes256_ctr.h"
+#include "aes.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t host_cycles(void) { return __rdtsc(); }
+#else
+static uint64_t host_cycles(void) { return 0; }
+#endif
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint32_t host_aes256_ctr_context_size(void) { return sizeof(aes256_ctr_context_t); }
+uint32_t host_aes256_context_size(void) { return sizeof(aes256_context_t); }
+
+/* Encrypt a buffer in CTR mode nb_iterations times: returns ns, stores host cycles */
+uint64_t host_aes256_ctr_bench(aes256_ctr_context_t* context, uint8_t* buffer, uint16_t length, uint32_t nb_iterations, uint64_t* cycles)
+{
+	uint64_t start_ns = host_ns();
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_iterations; i++)
+	{
+		aes256_ctr_crypt(context, i, buffer, length);
+	}
+	*cycles = host_cycles() - start_cycles;
+	return host_ns() - start_ns;
+}
+
+/* Key expansions */
+uint64_t host_aes256_key_bench(aes256_context_t* context, uint8_t* key, uint32_t nb_iterations, uint64_t* cycles)
+{
+	uint64_t start_ns = host_ns();
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_iterations; i++)
+	{
+		key[0] = (uint8_t)i;
+		aes256_init_context(context, key);
+	}
+	*cycles = host_cycles() - start_cycles;
+	return host_ns() - start_ns;
+}
+"""
+
+
+# Compile firmware sources (relative to the main MCU src folder) and host helper code into a shared library
+def loadFirmwareLibrary(sources, helpers="", defines=[], libraries=[]):
+	build_dir = tempfile.mkdtemp()
+	try:
+		helpers_file = join(build_dir, "host_helpers.c")
+		open(helpers_file, "w").write(helpers)
+		library_file = join(build_dir, "host_firmware.so")
+		command = ["gcc", "-O2", "-shared", "-fPIC", "-std=gnu99", "-Wall", "-include", "stdint.h", "-o", library_file, helpers_file]
+		command += ["-I" + join(MAIN_MCU_SRC_DIR, include_dir) for include_dir in HOST_INCLUDE_DIRS]
+		command += ["-D" + define for define in defines]
+		command += [join(MAIN_MCU_SRC_DIR, source) for source in sources]
+		command += ["-l" + library for library in libraries]
+		subprocess.check_call(command)
+		return ctypes.CDLL(library_file)
+	finally:
+		shutil.rmtree(build_dir)
+
+
+def hexToBuffer(hex_string):
+	return ctypes.create_string_buffer(hex_string.decode("hex"), len(hex_string) / 2)
+
+
+def bufferToHex(buffer, length):
+	return buffer.raw[0:length].encode("hex")
+
+
+# FIPS-197 C.3 (AES-256 block) & SP800-38A F.5.5 (CTR-AES256.Encrypt) test vectors, CTR block index splits, benchmark
+def runAesHostTest(benchmark_length=128, nb_iterations=20000):
+	library = loadFirmwareLibrary(["SECURITY/aes.c", "SECURITY/aes256_ctr.c"], HOST_AES_HELPERS)
+	library.host_aes256_ctr_bench.restype = ctypes.c_uint64
+	library.host_aes256_key_bench.restype = ctypes.c_uint64
+	all_ok = True
+
+	# Single block
+	context = ctypes.create_string_buffer(library.host_aes256_context_size())
+	library.aes256_init_context(context, hexToBuffer("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"))
+	block = hexToBuffer("00112233445566778899aabbccddeeff")
+	library.aes256_encrypt_block(context, block, block)
+	result = bufferToHex(block, 16) == "8ea2b7ca516745bfeafc49904b496089"
+	all_ok = all_ok and result
+	print "FIPS-197 C.3 AES-256 block:".ljust(40), "OK" if result else "FAILED " + bufferToHex(block, 16)
+
+	# CTR mode: whole message, then per block with the block index, then keystream generation for odd lengths
+	key = "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4"
+	initial_counter = "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff"
+	plaintext = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710"
+	ciphertext = "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c52b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6"
+	ctr_context = ctypes.create_string_buffer(library.host_aes256_ctr_context_size())
+	library.aes256_ctr_init_context(ctr_context, hexToBuffer(key), hexToBuffer(initial_counter))
+	data = hexToBuffer(plaintext)
+	library.aes256_ctr_crypt(ctr_context, 0, data, 64)
+	result = bufferToHex(data, 64) == ciphertext
+	all_ok = all_ok and result
+	print "SP800-38A F.5.5 CTR-AES256 encrypt:".ljust(40), "OK" if result else "FAILED " + bufferToHex(data, 64)
+
+	library.aes256_ctr_crypt(ctr_context, 0, data, 64)
+	result = bufferToHex(data, 64) == plaintext
+	all_ok = all_ok and result
+	print "SP800-38A F.5.5 CTR-AES256 decrypt:".ljust(40), "OK" if result else "FAILED"
+
+	result = True
+	for block_index in range(0, 4):
+		data = hexToBuffer(ciphertext[block_index*32:block_index*32+32])
+		library.aes256_ctr_crypt(ctr_context, block_index, data, 16)
+		result = result and bufferToHex(data, 16) == plaintext[block_index*32:block_index*32+32]
+	for length in [1, 15, 17, 33, 63]:
+		keystream = ctypes.create_string_buffer(64)
+		library.aes256_ctr_generate_keystream(ctr_context, 0, keystream, length)
+		data = hexToBuffer(plaintext)
+		library.aes256_ctr_xor_keystream(data, keystream, length)
+		result = result and bufferToHex(data, length) == ciphertext[0:2*length] and bufferToHex(keystream, 64)[2*length:] == "00" * (64 - length)
+	all_ok = all_ok and result
+	print "CTR block indexes & keystream lengths:".ljust(40), "OK" if result else "FAILED"
+
+	# Benchmark: credential sized CTR encryptions, key expansions
+	cycles = ctypes.c_uint64(0)
+	data = ctypes.create_string_buffer(benchmark_length)
+	elapsed_ns = library.host_aes256_ctr_bench(ctr_context, data, benchmark_length, nb_iterations, ctypes.byref(cycles))
+	nb_bytes = benchmark_length * nb_iterations
+	print ""
+	print "Host CTR encryption, " + str(benchmark_length) + " bytes:".ljust(22), ("%.1f cycles/byte" % (float(cycles.value) / nb_bytes)).rjust(20), ("%.2f MB/s" % (nb_bytes * 1000.0 / elapsed_ns)).rjust(14)
+	elapsed_ns = library.host_aes256_key_bench(context, hexToBuffer(key), nb_iterations, ctypes.byref(cycles))
+	print "Host key expansion:".ljust(36), ("%.0f cycles" % (float(cycles.value) / nb_iterations)).rjust(20), ("%.2f us" % (elapsed_ns / 1000.0 / nb_iterations)).rjust(14)
+
+	if all_ok:
+		print "All AES test vectors passed"
+	else:
+		print "AES test vectors failed"
+	return all_ok
@@ -0,0 +1,365 @@
+#!/usr/bin/env python2
+from host_firmware import *
+from host_crypto import *
+import random
+import re
+import os
+
+# Host checks of the main MCU random generator: CTR_DRBG (SECURITY/ctr_drbg.c) against NIST CAVP vectors and OpenSSL,
+# statistical tests on its output, RNG/rng.c blocking behaviour with stand-in entropy sources, benchmark
+# Nothing here measures entropy: the stand-in sources only drive the code paths, the rng.h credits are design assumptions
+
+# CTR_DRBG output tested by the FIPS 140-2 tests, in 20000 bits blocks
+SIM_DRBG_NB_FIPS_BLOCKS			= 64
+# Stand-in source periods: LIS2HH12 FIFO of 32 samples at 400Hz, battery ADC conversion (assumed)
+SIM_RNG_ACC_READ_PERIOD_MS		= 80
+SIM_RNG_ADC_RESULT_PERIOD_MS	= 2
+
+# Host helpers: context size, timed generate loop, OpenSSL CTR-DRBG fed by a TEST-RAND parent as done by OpenSSL's evp_test
+HOST_DRBG_HELPERS = r"""
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/evp.h>
+#include "ctr_drbg.h"
+
+uint32_t host_ctr_drbg_context_size(void) { return sizeof(ctr_drbg_context_t); }
+
+/* Generate nb_iterations requests of length bytes: returns ns, stores host cycles */
+uint64_t host_ctr_drbg_bench(ctr_drbg_context_t* context, uint8_t* buffer, uint32_t length, uint32_t nb_iterations, uint64_t* cycles)
+{
+	uint64_t start_ns = host_ns();
+	uint64_t start_cycles = host_cycles();
+	for (uint32_t i = 0; i < nb_iterations; i++)
+	{
+		ctr_drbg_generate(context, buffer, length, 0, 0);
+	}
+	*cycles = host_cycles() - start_cycles;
+	return host_ns() - start_ns;
+}
+
+static int host_openssl_set_test_entropy(EVP_RAND_CTX* parent, uint8_t* entropy, uint32_t entropy_length, uint8_t* nonce, uint32_t nonce_length)
+{
+	OSSL_PARAM params[3];
+	params[0] = OSSL_PARAM_construct_octet_string(OSSL_RAND_PARAM_TEST_ENTROPY, entropy, entropy_length);
+	params[1] = OSSL_PARAM_construct_octet_string(OSSL_RAND_PARAM_TEST_NONCE, nonce, nonce_length);
+	params[2] = OSSL_PARAM_construct_end();
+	return EVP_RAND_CTX_set_params(parent, params);
+}
+
+/* Instantiate, optional reseed (entropy_reseed != 0), two generates: output of the second one. Returns 1 on success */
+int host_openssl_ctr_drbg(uint8_t* entropy, uint32_t entropy_length, uint8_t* nonce, uint32_t nonce_length, uint8_t* personalization, uint32_t personalization_length, uint8_t* entropy_reseed, uint32_t entropy_reseed_length, uint8_t* additional_reseed, uint32_t additional_reseed_length, uint8_t* additional1, uint32_t additional1_length, uint8_t* additional2, uint32_t additional2_length, uint8_t* output, uint32_t output_length)
+{
+	EVP_RAND* test_rand = EVP_RAND_fetch(0, "TEST-RAND", 0);
+	EVP_RAND* ctr_drbg = EVP_RAND_fetch(0, "CTR-DRBG", 0);
+	EVP_RAND_CTX* parent = 0;
+	EVP_RAND_CTX* drbg = 0;
+	unsigned int strength = 256;
+	int use_df = 1;
+	int result = 0;
+	OSSL_PARAM params[3];
+
+	if ((test_rand == 0) || (ctr_drbg == 0))
+		goto end;
+	parent = EVP_RAND_CTX_new(test_rand, 0);
+	params[0] = OSSL_PARAM_construct_uint(OSSL_RAND_PARAM_STRENGTH, &strength);
+	params[1] = OSSL_PARAM_construct_end();
+	if ((parent == 0) || !EVP_RAND_CTX_set_params(parent, params) || !EVP_RAND_instantiate(parent, strength, 0, 0, 0, 0))
+		goto end;
+	drbg = EVP_RAND_CTX_new(ctr_drbg, parent);
+	params[0] = OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_CIPHER, "AES-256-CTR", 0);
+	params[1] = OSSL_PARAM_construct_int(OSSL_DRBG_PARAM_USE_DF, &use_df);
+	params[2] = OSSL_PARAM_construct_end();
+	if ((drbg == 0) || !EVP_RAND_CTX_set_params(drbg, params))
+		goto end;
+	if (!host_openssl_set_test_entropy(parent, entropy, entropy_length, nonce, nonce_length) || !EVP_RAND_instantiate(drbg, strength, 0, personalization, personalization_length, 0))
+		goto end;
+	if ((entropy_reseed != 0) && (!host_openssl_set_test_entropy(parent, entropy_reseed, entropy_reseed_length, nonce, nonce_length) || !EVP_RAND_reseed(drbg, 0, 0, 0, additional_reseed, additional_reseed_length)))
+		goto end;
+	if (!EVP_RAND_generate(drbg, output, output_length, strength, 0, additional1, additional1_length) || !EVP_RAND_generate(drbg, output, output_length, strength, 0, additional2, additional2_length))
+		goto end;
+	result = 1;
+end:
+	EVP_RAND_CTX_free(drbg);
+	EVP_RAND_CTX_free(parent);
+	EVP_RAND_free(ctr_drbg);
+	EVP_RAND_free(test_rand);
+	return result;
+}
+"""
+
+
+# RNG/rng.c on the host: accelerometer FIFO reads & battery ADC results delivered every host_rng_*_period_ns (0: never),
+# each main loop iteration polling them takes HOST_RNG_POLL_NS
+HOST_RNG_STANDINS = r"""
+#include "platform_io.h"
+#include "lis2hh12.h"
+#include "rng.h"
+#define HOST_RNG_POLL_NS    10000ULL
+
+extern BOOL rng_drbg_instantiated;
+extern uint16_t rng_pool_nb_bytes;
+extern uint16_t rng_entropy_buffer_nb_bytes;
+extern uint16_t rng_entropy_nb_bits;
+accelerometer_descriptor_t acc_descriptor;
+uint64_t host_rng_acc_period_ns = 0;
+uint64_t host_rng_adc_period_ns = 0;
+static uint64_t host_rng_next_acc_ns;
+static uint64_t host_rng_next_adc_ns;
+static uint32_t host_rng_lcg = 1;
+
+static uint16_t host_rng_sample(void)
+{
+	host_rng_lcg = host_rng_lcg * 1103515245UL + 12345UL;
+	return (uint16_t)(host_rng_lcg >> 16);
+}
+
+BOOL lis2hh12_check_data_received_flag_and_arm_other_transfer(accelerometer_descriptor_t* descriptor_pt)
+{
+	host_sim_ns += HOST_RNG_POLL_NS;
+	if ((host_rng_acc_period_ns == 0) || (host_sim_ns < host_rng_next_acc_ns))
+	{
+		return FALSE;
+	}
+	host_rng_next_acc_ns = host_sim_ns + host_rng_acc_period_ns;
+	for (uint16_t i = 0; i < ARRAY_SIZE(descriptor_pt->fifo_read.acc_data_array); i++)
+	{
+		descriptor_pt->fifo_read.acc_data_array[i].acc_x = (int16_t)host_rng_sample();
+		descriptor_pt->fifo_read.acc_data_array[i].acc_y = (int16_t)host_rng_sample();
+		descriptor_pt->fifo_read.acc_data_array[i].acc_z = (int16_t)host_rng_sample();
+	}
+	return TRUE;
+}
+
+BOOL platform_io_is_voledin_conversion_result_ready(void)
+{
+	return ((host_rng_adc_period_ns != 0) && (host_sim_ns >= host_rng_next_adc_ns))? TRUE : FALSE;
+}
+
+uint16_t platform_io_get_voledin_conversion_result_and_trigger_conversion(void)
+{
+	host_rng_next_adc_ns = host_sim_ns + host_rng_adc_period_ns;
+	return 2800 + (host_rng_sample() & 0x03);
+}
+
+/* Power up: no entropy, no DRBG */
+void host_rng_reset(uint64_t acc_period_ns, uint64_t adc_period_ns)
+{
+	rng_drbg_instantiated = FALSE;
+	rng_pool_nb_bytes = rng_entropy_buffer_nb_bytes = rng_entropy_nb_bits = 0;
+	host_rng_acc_period_ns = acc_period_ns;
+	host_rng_adc_period_ns = adc_period_ns;
+	host_rng_next_acc_ns = host_rng_next_adc_ns = host_sim_ns;
+}
+"""
+
+
+def loadDrbgLibrary():
+	library = loadFirmwareLibrary(["SECURITY/aes.c", "SECURITY/aes256_ctr.c", "SECURITY/ctr_drbg.c"], HOST_AES_HELPERS + HOST_DRBG_HELPERS, libraries=["crypto"])
+	library.host_ctr_drbg_bench.restype = ctypes.c_uint64
+	library.ctr_drbg_generate.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p, ctypes.c_uint16]
+	return library
+
+
+# Firmware CTR_DRBG: instantiate with entropy || nonce, optional reseed, two generates, output of the second one
+def firmwareCtrDrbg(library, entropy, nonce, personalization, entropy_reseed, additional_reseed, additional1, additional2, output_length):
+	context = ctypes.create_string_buffer(library.host_ctr_drbg_context_size())
+	output = ctypes.create_string_buffer(output_length)
+	library.ctr_drbg_instantiate(context, entropy + nonce, len(entropy + nonce), personalization, len(personalization))
+	if entropy_reseed is not None:
+		library.ctr_drbg_reseed(context, entropy_reseed, len(entropy_reseed), additional_reseed, len(additional_reseed))
+	if library.ctr_drbg_generate(context, output, output_length, additional1, len(additional1)) != 0 or library.ctr_drbg_generate(context, output, output_length, additional2, len(additional2)) != 0:
+		return None
+	return output.raw
+
+
+def opensslCtrDrbg(library, entropy, nonce, personalization, entropy_reseed, additional_reseed, additional1, additional2, output_length):
+	output = ctypes.create_string_buffer(output_length)
+	if entropy_reseed is None:
+		entropy_reseed = additional_reseed = None
+	if library.host_openssl_ctr_drbg(entropy, len(entropy), nonce, len(nonce), personalization, len(personalization), entropy_reseed, len(entropy_reseed or ""), additional_reseed, len(additional_reseed or ""), additional1, len(additional1), additional2, len(additional2), output, output_length) != 1:
+		return None
+	return output.raw
+
+
+# NIST CAVP CTR_DRBG.rsp: [AES-256 use df] cases, without prediction resistance
+def parseCtrDrbgResponseFile(file_name):
+	cases = []
+	section_ok = False
+	current_case = None
+	for line in open(file_name, "r"):
+		line = line.strip()
+		if line.startswith("["):
+			if not "=" in line:
+				section_ok = line == "[AES-256 use df]"
+			elif line.startswith("[PredictionResistance"):
+				section_ok = section_ok and line == "[PredictionResistance = False]"
+			continue
+		if not section_ok or not "=" in line:
+			continue
+		field, value = [item.strip() for item in line.split("=", 1)]
+		if field == "COUNT":
+			current_case = {"AdditionalInput": [], "EntropyInputReseed": None, "AdditionalInputReseed": ""}
+		elif current_case is not None and field == "AdditionalInput":
+			current_case["AdditionalInput"].append(value.decode("hex"))
+		elif current_case is not None and field == "ReturnedBits":
+			current_case["ReturnedBits"] = value.decode("hex")
+			cases.append(current_case)
+			current_case = None
+		elif current_case is not None:
+			current_case[field] = value.decode("hex")
+	return cases
+
+
+def runCavpVectors(library, file_name):
+	cases = parseCtrDrbgResponseFile(file_name)
+	nb_failed = 0
+	for case in cases:
+		output = firmwareCtrDrbg(library, case["EntropyInput"], case["Nonce"], case["PersonalizationString"], case["EntropyInputReseed"], case["AdditionalInputReseed"], case["AdditionalInput"][0], case["AdditionalInput"][1], len(case["ReturnedBits"]))
+		if output != case["ReturnedBits"]:
+			nb_failed += 1
+	print ("CAVP " + os.path.basename(file_name) + ":").ljust(40), str(len(cases)) + " vectors, " + str(nb_failed) + " failed"
+	return len(cases) > 0 and nb_failed == 0
+
+
+# Random instantiate / reseed / generate sequences, compared with OpenSSL's CTR-DRBG (AES-256, derivation function)
+def runOpensslCrossCheck(library, nb_cases=300):
+	nb_failed = 0
+	for i in range(0, nb_cases):
+		entropy = os.urandom(random.choice([32, 48, 80, 128]))
+		nonce = os.urandom(random.choice([16, 32]))
+		personalization = os.urandom(random.choice([0, 16, 32, 37]))
+		entropy_reseed = os.urandom(random.choice([32, 48, 128])) if random.randint(0, 1) else None
+		additional_reseed = os.urandom(random.choice([0, 32]))
+		additional1 = os.urandom(random.choice([0, 32, 5]))
+		additional2 = os.urandom(random.choice([0, 32, 5]))
+		output_length = random.choice([64, 16, 1, 33, 100])
+		arguments = (entropy, nonce, personalization, entropy_reseed, additional_reseed, additional1, additional2, output_length)
+		expected = opensslCtrDrbg(library, *arguments)
+		if expected is None or firmwareCtrDrbg(library, *arguments) != expected:
+			nb_failed += 1
+	print "OpenSSL CTR-DRBG cross check:".ljust(40), str(nb_cases) + " sequences, " + str(nb_failed) + " failed"
+	return nb_failed == 0
+
+
+# Defines from rng.h
+def getRngDefines():
+	defines = {}
+	for line in open(join(MAIN_MCU_SRC_DIR, "RNG", "rng.h"), "r"):
+		match = re.match(r"#define\s+(RNG_\w+)\s+(\d+)", line)
+		if match:
+			defines[match.group(1)] = int(match.group(2))
+	return defines
+
+
+# rng_fill_array() from power up with the given sources: returns (status, array, simulated ms)
+def rngFillArray(library, nb_bytes, acc_period_ms, adc_period_ms):
+	library.host_rng_reset(ctypes.c_uint64(acc_period_ms * 1000000), ctypes.c_uint64(adc_period_ms * 1000000))
+	array = ctypes.create_string_buffer("\xEE" * nb_bytes, nb_bytes)
+	start_ns = library.host_sim_get_ns()
+	status = library.rng_fill_array(array, nb_bytes)
+	return status, array.raw[0:nb_bytes], (library.host_sim_get_ns() - start_ns) / 1000000.0
+
+
+# rng_fill_array() blocking behaviour: accelerometer and ADC fallback, timeout & cleared array without any source
+def runRngFillTests(defines):
+	library = loadHostFirmware(MAIN_MCU_PROJECT, ["RNG/rng.c", "SECURITY/ctr_drbg.c", "SECURITY/aes.c", "SECURITY/aes256_ctr.c"], HOST_TIMER_STANDINS + HOST_RNG_STANDINS)
+	library.host_sim_get_ns.restype = ctypes.c_uint64
+	timeout_ms = defines["RNG_FILL_ARRAY_TIMEOUT_MS"]
+	all_ok = True
+	for name, acc_period_ms, adc_period_ms in [("accelerometer & ADC", SIM_RNG_ACC_READ_PERIOD_MS, SIM_RNG_ADC_RESULT_PERIOD_MS), ("accelerometer only", SIM_RNG_ACC_READ_PERIOD_MS, 0), ("ADC only", 0, SIM_RNG_ADC_RESULT_PERIOD_MS)]:
+		status, array, elapsed_ms = rngFillArray(library, 32, acc_period_ms, adc_period_ms)
+		result = status == 0 and array != "\xEE" * 32 and array != "\x00" * 32 and elapsed_ms < timeout_ms
+		all_ok = all_ok and result
+		print ("rng_fill_array(), " + name + ":").ljust(40), ("seeded in %.0fms" % elapsed_ms).ljust(34), "OK" if result else "FAILED"
+
+	status, array, elapsed_ms = rngFillArray(library, 32, 0, 0)
+	result = status != 0 and array == "\x00" * 32 and timeout_ms <= elapsed_ms < timeout_ms + 10
+	all_ok = all_ok and result
+	print "rng_fill_array(), no source:".ljust(40), ("error after %.0fms, array cleared" % elapsed_ms if result else "returned %d after %.0fms" % (status, elapsed_ms)).ljust(34), "OK" if result else "FAILED"
+	return all_ok
+
+
+# FIPS 140-2 monobit, poker, runs & long run tests on a 20000 bits block
+def fips1402BlockTests(block):
+	bits = "".join(format(ord(byte), "08b") for byte in block)
+	monobit_ok = 9725 < bits.count("1") < 10275
+
+	nibble_counts = [0] * 16
+	for byte in block:
+		nibble_counts[ord(byte) >> 4] += 1
+		nibble_counts[ord(byte) & 0x0F] += 1
+	poker = 16.0 / 5000 * sum(count * count for count in nibble_counts) - 5000
+	poker_ok = 2.16 < poker < 46.17
+
+	run_intervals = [(2315, 2685), (1114, 1386), (527, 723), (240, 384), (103, 209), (103, 209)]
+	run_counts = {"0": [0] * 6, "1": [0] * 6}
+	longest_run = 0
+	for run in re.findall(r"0+|1+", bits):
+		run_counts[run[0]][min(len(run), 6) - 1] += 1
+		longest_run = max(longest_run, len(run))
+	runs_ok = all(run_intervals[i][0] <= run_counts[bit][i] <= run_intervals[i][1] for bit in "01" for i in range(0, 6))
+	return monobit_ok, poker_ok, runs_ok, longest_run < 26
+
+
+# Byte frequencies chi-square, 255 degrees of freedom: 330.5 is the 0.1% critical value
+def byteChiSquare(data):
+	counts = [0] * 256
+	for byte in data:
+		counts[ord(byte)] += 1
+	expected = len(data) / 256.0
+	return sum((count - expected) ** 2 / expected for count in counts)
+
+
+# FIPS 140-2 & chi-square on the generated pools: sanity checks of the DRBG output, not of the entropy sources
+def runOutputStatistics(library, defines):
+	context = ctypes.create_string_buffer(library.host_ctr_drbg_context_size())
+	library.ctr_drbg_instantiate(context, os.urandom(48), 48, None, 0)
+	pool = ctypes.create_string_buffer(defines["RNG_POOL_SIZE"])
+	output = []
+	for i in range(0, (SIM_DRBG_NB_FIPS_BLOCKS * 2500 + len(pool) - 1) / len(pool)):
+		library.ctr_drbg_generate(context, pool, len(pool), None, 0)
+		output.append(pool.raw)
+	output = "".join(output)
+	failures = [0, 0, 0, 0]
+	for i in range(0, SIM_DRBG_NB_FIPS_BLOCKS):
+		failures = [failures[j] + (0 if result else 1) for j, result in enumerate(fips1402BlockTests(output[i*2500:i*2500+2500]))]
+	chi_square = byteChiSquare(output)
+	result = sum(failures) == 0 and chi_square < 330.5
+	print "DRBG output:".ljust(40), ("FIPS 140-2 failures (monobit, poker, runs, long run) over %d blocks: %s, chi-square %.1f" % (SIM_DRBG_NB_FIPS_BLOCKS, str(failures), chi_square)), "OK" if result else "FAILED"
+	return result
+
+
+# Host generate throughput for pool refills and large requests, AES work per request to scale it to the main MCU
+def runDrbgBenchmark(library, defines, nb_bytes=1 << 22):
+	context = ctypes.create_string_buffer(library.host_ctr_drbg_context_size())
+	library.ctr_drbg_instantiate(context, os.urandom(48), 48, None, 0)
+	cycles = ctypes.c_uint64(0)
+	for length in [defines["RNG_POOL_SIZE"], 4096]:
+		buffer = ctypes.create_string_buffer(length)
+		nb_iterations = nb_bytes / length
+		elapsed_ns = library.host_ctr_drbg_bench(context, buffer, length, nb_iterations, ctypes.byref(cycles))
+		aes_blocks = (length + 15) / 16 + 3
+		print ("Host generate, " + str(length) + " bytes:").ljust(40), ("%.1f cycles/byte" % (float(cycles.value) / nb_bytes)).rjust(20), ("%.2f MB/s" % (nb_bytes * 1000.0 / elapsed_ns)).rjust(14), ("%d AES blocks + 1 key expansion per request" % aes_blocks).rjust(46)
+
+
+def runDrbgHostTest(rsp_file_name=None):
+	library = loadDrbgLibrary()
+	defines = getRngDefines()
+	all_ok = True
+	if rsp_file_name is not None:
+		all_ok = runCavpVectors(library, rsp_file_name) and all_ok
+	else:
+		print "No CAVP CTR_DRBG.rsp given, cross checking with OpenSSL only"
+	all_ok = runOpensslCrossCheck(library) and all_ok
+	print ""
+	all_ok = runRngFillTests(defines) and all_ok
+	print ""
+	all_ok = runOutputStatistics(library, defines) and all_ok
+	print ""
+	runDrbgBenchmark(library, defines)
+
+	if all_ok:
+		print "All DRBG tests passed"
+	else:
+		print "DRBG tests failed"
+	return all_ok
@@ -0,0 +1,317 @@
+#!/usr/bin/env python2
+from os.path import dirname, join, normpath, realpath
+import xml.etree.ElementTree as ElementTree
+import subprocess
+import tempfile
+import ctypes
+import shutil
+import re
+
+# Host builds of the firmware: MCU sources compiled with the host gcc using the symbols & include paths of their Atmel Studio
+# project, into a shared library loaded with ctypes. The peripheral address space is backed by host memory, so register
+# accesses land in RAM, and the code that talks to the hardware is replaced by stand-ins in the host helpers
+
+SOURCE_CODE_DIR = join(dirname(realpath(__file__)), "..", "..", "source_code")
+MAIN_MCU_PROJECT = join(SOURCE_CODE_DIR, "main_mcu", "mini_ble.cproj")
+AUX_MCU_PROJECT = join(SOURCE_CODE_DIR, "aux_mcu_v2", "aux_mcu.cproj")
+
+# Libraries are linked below 4GB, as the firmware stores pointers in uint32_t. One slot per library loaded in the process
+HOST_BUILD_FIRST_BASE_ADDR = 0x48000000
+HOST_BUILD_BASE_ADDR_STEP = 0x01000000
+HOST_BUILD_NB_BASE_ADDR = 23
+host_build_nb_libraries = 0
+
+# Forced include: host versions of the CMSIS core intrinsics, which are Cortex-M0+ assembly. Interrupt stand-ins
+# pending while interrupts were disabled are run by the hook called when they're enabled again
+HOST_FIRMWARE_HEADER = r"""
+#ifndef HOST_FIRMWARE_H_
+#define HOST_FIRMWARE_H_
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <endian.h>
+#undef __always_inline
+#undef LITTLE_ENDIAN
+#define __CORE_CMFUNC_H
+#define __CORE_CMINSTR_H
+extern uint32_t host_primask;
+extern void (*host_irq_enabled_hook)(void);
+static inline void __enable_irq(void) { host_primask = 0; if (host_irq_enabled_hook != 0) host_irq_enabled_hook(); }
+static inline void __disable_irq(void) { host_primask = 1; }
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t priMask) { host_primask = priMask; }
+static inline uint32_t __get_IPSR(void) { return 0; }
+static inline uint32_t __get_CONTROL(void) { return 0; }
+static inline void __set_CONTROL(uint32_t control) { (void)control; }
+static inline uint32_t __get_MSP(void) { return 0; }
+static inline void __set_MSP(uint32_t topOfMainStack) { (void)topOfMainStack; }
+static inline void __NOP(void) {}
+static inline void __WFI(void) {}
+static inline void __WFE(void) {}
+static inline void __SEV(void) {}
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+static inline uint32_t __REV16(uint32_t value) { return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8); }
+static inline int32_t __REVSH(int32_t value) { return (int16_t)__builtin_bswap16((uint16_t)value); }
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2) { op2 &= 31; return op2 ? (op1 >> op2) | (op1 << (32 - op2)) : op1; }
+#endif
+"""
+
+# Peripheral address space mapped at load time: NVM user row & calibration, end of the internal flash, APB bridges, IOBUS, private peripheral bus
+HOST_PERIPHERAL_HELPERS = r"""
+#include <sys/mman.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t host_cycles(void) { return __rdtsc(); }
+#else
+static uint64_t host_cycles(void) { return 0; }
+#endif
+
+uint32_t host_primask = 0;
+void (*host_irq_enabled_hook)(void) = 0;
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void host_map_region(uintptr_t address, size_t size, uint8_t fill)
+{
+	void* region = mmap((void*)address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (region == (void*)address)
+	{
+		memset(region, fill, size);
+	}
+}
+
+__attribute__((constructor)) static void host_map_peripherals(void)
+{
+	host_map_region(0x00010000, 0x00030000, 0xFF);
+	host_map_region(0x00800000, 0x00010000, 0xFF);
+	host_map_region(0x40000000, 0x03000000, 0x00);
+	host_map_region(0x60000000, 0x00001000, 0x00);
+	host_map_region(0xE0000000, 0x00100000, 0x00);
+}
+"""
+
+# Simulated time base replacing TIMER/driver_timer.c: delays advance it, so do SPI transfers through host_sim_advance_ns(),
+# and every timer poll advances it by HOST_SIM_POLL_NS so busy waits on a timer end
+HOST_TIMER_STANDINS = r"""
+#include "platform_defines.h"
+#include "driver_timer.h"
+#define HOST_SIM_POLL_NS    10000ULL
+
+uint64_t host_sim_ns = 0;
+/* Called by the timer polls when set: lets the host run the other MCU while the firmware waits for it */
+void (*host_sim_wait_hook)(void) = 0;
+static uint64_t host_timer_deadlines_ns[TOTAL_NUMBER_OF_TIMERS];
+static BOOL host_timer_armed[TOTAL_NUMBER_OF_TIMERS];
+static timer_flag_te host_timer_flags[TOTAL_NUMBER_OF_TIMERS];
+
+void host_sim_advance_ns(uint64_t nb_ns) { host_sim_ns += nb_ns; }
+uint64_t host_sim_get_ns(void) { return host_sim_ns; }
+
+void host_timer_reset(void)
+{
+	memset(host_timer_deadlines_ns, 0, sizeof(host_timer_deadlines_ns));
+	memset(host_timer_armed, 0, sizeof(host_timer_armed));
+	memset(host_timer_flags, 0, sizeof(host_timer_flags));
+}
+
+static void host_timer_update(timer_id_te uid)
+{
+	if ((host_timer_armed[uid] != FALSE) && (host_sim_ns >= host_timer_deadlines_ns[uid]))
+	{
+		host_timer_armed[uid] = FALSE;
+		host_timer_flags[uid] = TIMER_EXPIRED;
+	}
+}
+
+timer_flag_te timer_has_timer_expired(timer_id_te uid, BOOL clear)
+{
+	if (host_sim_wait_hook != 0)
+	{
+		host_sim_wait_hook();
+	}
+	host_sim_ns += HOST_SIM_POLL_NS;
+	host_timer_update(uid);
+	timer_flag_te flag = host_timer_flags[uid];
+	if ((clear != FALSE) && (flag == TIMER_EXPIRED))
+	{
+		host_timer_flags[uid] = TIMER_RUNNING;
+	}
+	return flag;
+}
+
+void timer_start_timer(timer_id_te uid, uint32_t val)
+{
+	host_timer_deadlines_ns[uid] = host_sim_ns + (uint64_t)val * 1000000ULL;
+	host_timer_armed[uid] = (val != 0)? TRUE : FALSE;
+	host_timer_flags[uid] = (val != 0)? TIMER_RUNNING : TIMER_EXPIRED;
+}
+
+uint32_t timer_get_timer_val(timer_id_te uid)
+{
+	host_timer_update(uid);
+	return (host_timer_armed[uid] != FALSE)? (uint32_t)((host_timer_deadlines_ns[uid] - host_sim_ns + 999999ULL) / 1000000ULL) : 0;
+}
+
+void timer_delay_ms(uint32_t ms) { host_sim_ns += (uint64_t)ms * 1000000ULL; }
+uint32_t timer_get_systick(void)
+{
+	if (host_sim_wait_hook != 0)
+	{
+		host_sim_wait_hook();
+	}
+	return (uint32_t)(host_sim_ns / 1000000ULL);
+}
+uint32_t timer_get_cycle_count(void) { return (uint32_t)(host_sim_ns * (CPU_SPEED_HF / 1000000UL) / 1000ULL); }
+void timer_get_calendar(calendar_t* calendar_pt) { calendar_pt->reg = 0; }
+void timer_initialize_timebase(void) {}
+void timer_ms_tick(void) { host_sim_ns += 1000000ULL; }
+"""
+
+# DB flash replacing FLASH/dbflash.c: pages held in host memory, DMA reads served from the opened read. Counts transactions & bytes,
+# simulated time is only charged for them when host_dbflash_byte_ns / host_dbflash_page_write_ns are set
+HOST_DBFLASH_STANDINS = r"""
+#include "dbflash.h"
+#include "dma.h"
+
+spi_flash_descriptor_t dbflash_descriptor = {.sercom_pt = DBFLASH_SERCOM, .cs_pin_group = DBFLASH_nCS_GROUP, .cs_pin_mask = DBFLASH_nCS_MASK};
+uint8_t host_dbflash[PAGE_COUNT][BYTES_PER_PAGE];
+static uint32_t host_dbflash_read_address;
+static BOOL host_dbflash_dma_done = FALSE;
+uint32_t host_dbflash_nb_reads = 0;
+uint32_t host_dbflash_nb_bytes_read = 0;
+uint32_t host_dbflash_nb_writes = 0;
+uint32_t host_dbflash_nb_bytes_written = 0;
+uint64_t host_dbflash_byte_ns = 0;
+uint64_t host_dbflash_page_write_ns = 0;
+
+void host_dbflash_erase(void)
+{
+	memset(host_dbflash, 0xFF, sizeof(host_dbflash));
+	host_dbflash_nb_reads = host_dbflash_nb_bytes_read = host_dbflash_nb_writes = host_dbflash_nb_bytes_written = 0;
+}
+
+static uint8_t* host_dbflash_pointer(uint32_t address, uint32_t size)
+{
+	if (address + size > sizeof(host_dbflash))
+	{
+		dbflash_memory_boundary_error_callblack();
+	}
+	return &((uint8_t*)host_dbflash)[address];
+}
+
+void dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
+{
+	host_dbflash_nb_reads++;
+	host_dbflash_nb_bytes_read += dataSize;
+	host_sim_ns += (dataSize + 4) * host_dbflash_byte_ns;
+	memcpy(data, host_dbflash_pointer((uint32_t)pageNumber*BYTES_PER_PAGE + offset, dataSize), dataSize);
+}
+
+void dbflash_read_data_start(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize)
+{
+	host_dbflash_nb_reads++;
+	host_dbflash_read_address = (uint32_t)pageNumber*BYTES_PER_PAGE + offset;
+}
+
+void dma_dbflash_init_transfer(void* spi_data_p, void* datap, uint16_t size)
+{
+	host_dbflash_nb_bytes_read += size;
+	host_sim_ns += (size + 4) * host_dbflash_byte_ns;
+	memcpy(datap, host_dbflash_pointer(host_dbflash_read_address, size), size);
+	host_dbflash_read_address += size;
+	host_dbflash_dma_done = TRUE;
+}
+
+BOOL dma_dbflash_check_and_clear_dma_transfer_flag(void)
+{
+	BOOL done = host_dbflash_dma_done;
+	host_dbflash_dma_done = FALSE;
+	return done;
+}
+
+void dbflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt) {}
+
+void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
+{
+	host_dbflash_nb_writes++;
+	host_dbflash_nb_bytes_written += dataSize;
+	host_sim_ns += (dataSize + 4) * host_dbflash_byte_ns + host_dbflash_page_write_ns;
+	memcpy(host_dbflash_pointer((uint32_t)pageNumber*BYTES_PER_PAGE + offset, dataSize), data, dataSize);
+}
+
+void dbflash_write_data_pattern_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, uint8_t pattern)
+{
+	host_dbflash_nb_writes++;
+	host_dbflash_nb_bytes_written += dataSize;
+	host_sim_ns += (dataSize + 4) * host_dbflash_byte_ns + host_dbflash_page_write_ns;
+	memset(host_dbflash_pointer((uint32_t)pageNumber*BYTES_PER_PAGE + offset, dataSize), pattern, dataSize);
+}
+
+void dbflash_memory_boundary_error_callblack(void) { __builtin_trap(); }
+"""
+
+
+# Release configuration of an Atmel Studio project: device define, symbols, absolute include paths
+# Include paths are relative to the output folder, paths in the Atmel pack repository are skipped
+def parseProjectSettings(project_file):
+	namespace = "{http://schemas.microsoft.com/developer/msbuild/2003}"
+	root = ElementTree.parse(project_file).getroot()
+	device = root.find(".//" + namespace + "avrdevice").text
+	defines = ["__" + device.replace("AT", "", 1) + "__"]
+	defines += [value.text for value in root.find(".//" + namespace + "armgcc.compiler.symbols.DefSymbols").iter(namespace + "Value")]
+	include_dirs = [normpath(join(dirname(project_file), "Release", value.text)) for value in root.find(".//" + namespace + "armgcc.compiler.directories.IncludePaths").iter(namespace + "Value") if "PackRepoDir" not in value.text]
+	return defines, include_dirs
+
+
+# Compile MCU sources (relative to the project src folder) and host helpers into a shared library. Helpers can use host_ns() & host_cycles()
+# Firmware functions listed in replaced_functions are made weak, for the helpers to provide their own version
+def loadHostFirmware(project_file, sources, helpers="", defines=[], libraries=[], extra_include_dirs=[], replaced_functions=[]):
+	global host_build_nb_libraries
+	project_defines, include_dirs = parseProjectSettings(project_file)
+	src_dir = join(dirname(project_file), "src")
+	base_address = HOST_BUILD_FIRST_BASE_ADDR + (host_build_nb_libraries % HOST_BUILD_NB_BASE_ADDR) * HOST_BUILD_BASE_ADDR_STEP
+	host_build_nb_libraries += 1
+
+	build_dir = tempfile.mkdtemp()
+	try:
+		header_file = join(build_dir, "host_firmware.h")
+		open(header_file, "w").write(HOST_FIRMWARE_HEADER)
+		helpers_file = join(build_dir, "host_helpers.c")
+		open(helpers_file, "w").write(HOST_PERIPHERAL_HELPERS + helpers)
+		library_file = join(build_dir, "host_firmware.so")
+		flags = ["-O2", "-fPIC", "-std=gnu99", "-fcommon", "-fno-strict-aliasing", "-Wall", "-Wno-unused-function", "-Wno-pointer-to-int-cast", "-Wno-int-to-pointer-cast", "-Wno-address-of-packed-member", "-Wno-array-bounds"]
+		flags += ["-include", header_file]
+		flags += ["-D" + define for define in project_defines + defines]
+		flags += ["-I" + include_dir for include_dir in extra_include_dirs + include_dirs]
+		source_files = [join(src_dir, source) for source in sources]
+		if len(replaced_functions) != 0:
+			object_files = [join(build_dir, str(i) + ".o") for i in range(0, len(source_files))]
+			for source_file, object_file in zip(source_files, object_files):
+				subprocess.check_call(["gcc"] + flags + ["-c", "-o", object_file, source_file])
+				subprocess.check_call(["objcopy"] + ["--weaken-symbol=" + function for function in replaced_functions] + [object_file])
+			source_files = object_files
+		command = ["gcc", "-shared"] + flags + ["-Wl,-Ttext-segment=" + hex(base_address), "-o", library_file, helpers_file]
+		command += source_files
+		command += ["-l" + library for library in libraries]
+		subprocess.check_call(command)
+		return ctypes.CDLL(library_file)
+	finally:
+		shutil.rmtree(build_dir)
+
+
+# Value of a #define in a firmware header
+def getFirmwareDefine(project_file, header, name):
+	for line in open(join(dirname(project_file), "src", header), "r"):
+		match = re.match(r"#define\s+" + name + r"\s+\(?([0-9A-Fa-fx]+)", line)
+		if match:
+			return int(match.group(1), 0)
+	return None
@@ -0,0 +1,828 @@
+#!/usr/bin/env python2
+from host_firmware import *
+import random
+import time
+import sys
+import os
+
+# Host build of the main MCU rendering path: GUI/*.c, OLED/sh1122.c, FILESYSTEM/*.c and NODEMGMT/nodemgmt.c compiled with
+# host_firmware, rendering bundle.img through an SH1122 model fed by the OLED SPI & DMA stand-ins. Each scenario
+# compares the SH1122 GDDRAM with a golden image and reports the simulated render time & flash traffic
+
+GUI_GOLDEN_DIR = join(dirname(realpath(__file__)), "gui_golden")
+GUI_BUNDLE_FILE = join(dirname(realpath(__file__)), "bundle.img")
+GUI_SOURCES = ["utils.c", "OLED/sh1122.c", "FILESYSTEM/custom_bitstream.c", "FILESYSTEM/custom_fs.c", "FILESYSTEM/custom_fs_emergency_font.c",
+				"GUI/gui_carousel.c", "GUI/gui_dispatcher.c", "GUI/gui_list_view.c", "GUI/gui_menu.c",
+				"NODEMGMT/nodemgmt.c", "LOGIC/logic_encryption.c", "LOGIC/logic_security.c", "SECURITY/aes.c", "SECURITY/aes256_ctr.c"]
+GUI_SCREEN_NAMES = ["NINSERTED", "INSERTED_LCK", "INSERTED_INVALID", "INSERTED_UNKNOWN", "MEMORY_MGMT", "CATEGORIES", "FAVORITES", "LOGIN", "LOCK", "MAIN_MENU", "BT", "OPERATIONS", "SETTINGS"]
+GUI_OLED_WIDTH = 256
+GUI_OLED_HEIGHT = 64
+GUI_DMA_MEMSET_WORD_NS = 2 * 1000000000.0 / 48000000
+
+# Wheel actions, screens, transitions & message types, from defines.h, gui_dispatcher.h and sh1122.h
+WHEEL_ACTION_NONE = 0
+WHEEL_ACTION_UP = 1
+WHEEL_ACTION_DOWN = 2
+WHEEL_ACTION_SHORT_CLICK = 3
+WHEEL_ACTION_LONG_CLICK = 4
+OLED_TRANS_NONE = 0
+DISP_MSG_INFO = 0
+DISP_MSG_WARNING = 1
+DISP_MSG_ACTION = 2
+
+# Stand-ins for the OLED, dataflash, DMA, inputs and the rest of the platform used by the GUI
+HOST_GUI_STANDINS = r"""
+#include "gui_dispatcher.h"
+#include "logic_encryption.h"
+#include "logic_security.h"
+#include "gui_prompts.h"
+#include "comms_trace.h"
+#include "logic_power.h"
+#include "dataflash.h"
+#include "nodemgmt.h"
+#include "inputs.h"
+#include "main.h"
+#include <stdio.h>
+
+/* Bus time of a SPI byte, SERCOM clocked by the 48MHz main clock */
+#define HOST_SPI_BYTE_NS(baud_div)  (8ULL * 2ULL * ((baud_div) + 1ULL) * 1000000000ULL / CPU_SPEED_HF)
+#define HOST_DATAFLASH_SIZE         (1UL << 20)
+#define HOST_DATAFLASH_READ_CMD_LEN 4
+#define HOST_INPUTS_QUEUE_LENGTH    32
+/* DMA memset: one beat read & one beat write on the 48MHz AHB per word */
+#define HOST_DMA_MEMSET_WORD_NS     (2ULL * 1000000000ULL / CPU_SPEED_HF)
+
+sh1122_descriptor_t plat_oled_descriptor = {.sercom_pt = OLED_SERCOM, .dma_trigger_id = OLED_DMA_SERCOM_TX_TRIG, .sh1122_cs_pin_group = OLED_nCS_GROUP, .sh1122_cs_pin_mask = OLED_nCS_MASK, .sh1122_cd_pin_group = OLED_CD_GROUP, .sh1122_cd_pin_mask = OLED_CD_MASK};
+spi_flash_descriptor_t dataflash_descriptor = {.sercom_pt = DATAFLASH_SERCOM, .cs_pin_group = DATAFLASH_nCS_GROUP, .cs_pin_mask = DATAFLASH_nCS_MASK};
+BOOL special_dev_card_inserted = FALSE;
+
+/* SH1122 model: GDDRAM written by data bytes, D/C level taken from the CD pin OUTSET/OUTCLR writes before each byte */
+uint8_t host_sh1122_gddram[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/2];
+uint8_t host_sh1122_display[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/2];
+static uint8_t host_sh1122_row, host_sh1122_col, host_sh1122_start_line;
+static uint8_t host_sh1122_cmd, host_sh1122_nb_args;
+static BOOL host_sh1122_data_mode;
+uint32_t host_sh1122_nb_spi_bytes = 0;
+// Simulated time of the first & last GDDRAM writes since the scenario start, 0 if none
+uint64_t host_sh1122_first_data_ns = 0;
+uint64_t host_sh1122_last_data_ns = 0;
+
+static void host_sh1122_update_dc(void)
+{
+	PortGroup* group = &PORT->Group[plat_oled_descriptor.sh1122_cd_pin_group];
+
+	/* Both set: the data mode set by a data sending start without bytes was left behind by a command */
+	if ((group->OUTCLR.reg & plat_oled_descriptor.sh1122_cd_pin_mask) != 0)
+	{
+		host_sh1122_data_mode = FALSE;
+	}
+	else if ((group->OUTSET.reg & plat_oled_descriptor.sh1122_cd_pin_mask) != 0)
+	{
+		host_sh1122_data_mode = TRUE;
+	}
+	group->OUTCLR.reg = 0;
+	group->OUTSET.reg = 0;
+}
+
+static void host_sh1122_byte(uint8_t byte)
+{
+	host_sh1122_nb_spi_bytes++;
+	host_sim_advance_ns(HOST_SPI_BYTE_NS(OLED_BAUD_DIVIDER));
+
+	if (host_sh1122_data_mode != FALSE)
+	{
+		if (host_sh1122_first_data_ns == 0)
+		{
+			host_sh1122_first_data_ns = host_sim_get_ns();
+		}
+		host_sh1122_last_data_ns = host_sim_get_ns();
+		host_sh1122_gddram[host_sh1122_row][host_sh1122_col] = byte;
+		if (++host_sh1122_col == SH1122_OLED_WIDTH/2)
+		{
+			host_sh1122_col = 0;
+			host_sh1122_row = (host_sh1122_row + 1) % SH1122_OLED_HEIGHT;
+		}
+	}
+	else if (host_sh1122_nb_args != 0)
+	{
+		host_sh1122_nb_args--;
+		if (host_sh1122_cmd == SH1122_CMD_SET_ROW_ADDR)
+		{
+			host_sh1122_row = byte % SH1122_OLED_HEIGHT;
+		}
+	}
+	else if (byte < SH1122_CMD_SET_HIGH_COLUMN_ADDR)
+	{
+		host_sh1122_col = (host_sh1122_col & 0x70) | (byte & 0x0F);
+	}
+	else if (byte < SH1122_CMD_SET_HIGH_COLUMN_ADDR + 8)
+	{
+		host_sh1122_col = ((byte & 0x07) << 4) | (host_sh1122_col & 0x0F);
+	}
+	else if ((byte & 0xC0) == SH1122_CMD_SET_DISPLAY_START_LINE)
+	{
+		host_sh1122_start_line = byte & 0x3F;
+	}
+	else
+	{
+		host_sh1122_cmd = byte;
+		switch (byte)
+		{
+			case SH1122_CMD_SET_ROW_ADDR:
+			case SH1122_CMD_SET_CONTRAST_CURRENT:
+			case SH1122_CMD_SET_MULTIPLEX_RATIO:
+			case SH1122_CMD_SET_DCDC_SETTING:
+			case SH1122_CMD_SET_DISPLAY_OFFSET:
+			case SH1122_CMD_SET_CLOCK_DIVIDER:
+			case 0xD9:
+			case SH1122_CMD_SET_VCOM_DESELECT_LEVEL:
+			case SH1122_CMD_SET_VSEGM_LEVEL:   host_sh1122_nb_args = 1; break;
+			default: break;
+		}
+	}
+}
+
+/* Panel contents: the panel is mounted flipped, the start line of 32 set at init shows GDDRAM row 0 on the top line */
+uint8_t* host_sh1122_get_display(void)
+{
+	for (uint16_t y = 0; y < SH1122_OLED_HEIGHT; y++)
+	{
+		memcpy(host_sh1122_display[y], host_sh1122_gddram[(y + host_sh1122_start_line + SH1122_OLED_HEIGHT - 32) % SH1122_OLED_HEIGHT], sizeof(host_sh1122_display[y]));
+	}
+	return &host_sh1122_display[0][0];
+}
+
+uint8_t sercom_spi_send_single_byte(Sercom* sercom_pt, uint8_t data)
+{
+	if (sercom_pt == plat_oled_descriptor.sercom_pt)
+	{
+		host_sh1122_update_dc();
+		host_sh1122_byte(data);
+	}
+	return 0xFF;
+}
+
+void sercom_spi_send_single_byte_without_receive_wait(Sercom* sercom_pt, uint8_t data) { sercom_spi_send_single_byte(sercom_pt, data); }
+void sercom_spi_wait_for_transmit_complete(Sercom* sercom_pt) {}
+
+/* DMA: OLED frame buffer flush, memset */
+static BOOL host_dma_oled_done = FALSE;
+static BOOL host_dma_memset_done = FALSE;
+static BOOL host_dma_custom_fs_done = FALSE;
+
+void dma_oled_init_transfer(void* spi_data_p, void* datap, uint16_t size, uint16_t dma_trigger)
+{
+	host_sh1122_update_dc();
+	for (uint16_t i = 0; i < size; i++)
+	{
+		host_sh1122_byte(((uint8_t*)datap)[i]);
+	}
+	host_dma_oled_done = TRUE;
+}
+
+BOOL dma_oled_check_and_clear_dma_transfer_flag(void)
+{
+	BOOL done = host_dma_oled_done;
+	host_dma_oled_done = FALSE;
+	return done;
+}
+
+/* DMA memset: done when waited for, so a frame buffer access before the wait gets overwritten. Runs at HOST_DMA_MEMSET_WORD_NS per word */
+static uint32_t* host_dma_memset_address;
+static uint32_t host_dma_memset_value;
+static uint16_t host_dma_memset_nb_words;
+static uint64_t host_dma_memset_end_ns;
+uint64_t host_dma_memset_wait_ns = 0;
+uint32_t host_dma_memset_nb_transfers = 0;
+
+void dma_memset_init_transfer(void* datap, uint32_t value, uint16_t nb_words)
+{
+	host_dma_memset_address = (uint32_t*)datap;
+	host_dma_memset_value = value;
+	host_dma_memset_nb_words = nb_words;
+	host_dma_memset_end_ns = host_sim_get_ns() + nb_words * HOST_DMA_MEMSET_WORD_NS;
+	host_dma_memset_nb_transfers++;
+	host_dma_memset_done = TRUE;
+}
+
+BOOL dma_memset_check_and_clear_dma_transfer_flag(void)
+{
+	BOOL done = host_dma_memset_done;
+	if (done != FALSE)
+	{
+		for (uint16_t i = 0; i < host_dma_memset_nb_words; i++)
+		{
+			host_dma_memset_address[i] = host_dma_memset_value;
+		}
+		if (host_sim_get_ns() < host_dma_memset_end_ns)
+		{
+			host_dma_memset_wait_ns += host_dma_memset_end_ns - host_sim_get_ns();
+			host_sim_advance_ns(host_dma_memset_end_ns - host_sim_get_ns());
+		}
+	}
+	host_dma_memset_done = FALSE;
+	return done;
+}
+
+/* Dataflash holding the bundle: bytes past the loaded image read as erased */
+uint8_t host_dataflash[HOST_DATAFLASH_SIZE];
+static uint32_t host_dataflash_read_address;
+uint32_t host_dataflash_nb_reads = 0;
+uint32_t host_dataflash_nb_bytes_read = 0;
+
+void host_dataflash_load(uint8_t* data, uint32_t size)
+{
+	memset(host_dataflash, 0xFF, sizeof(host_dataflash));
+	memcpy(host_dataflash, data, (size < sizeof(host_dataflash))? size : sizeof(host_dataflash));
+}
+
+static void host_dataflash_read(uint8_t* data, uint32_t length)
+{
+	host_dataflash_nb_bytes_read += length;
+	host_sim_advance_ns(length * HOST_SPI_BYTE_NS(DATAFLASH_BAUD_DIVIDER));
+	for (uint32_t i = 0; i < length; i++)
+	{
+		data[i] = host_dataflash[(host_dataflash_read_address++) % HOST_DATAFLASH_SIZE];
+	}
+}
+
+void dataflash_read_data_array_start(spi_flash_descriptor_t* descriptor_pt, uint32_t address)
+{
+	host_dataflash_nb_reads++;
+	host_sim_advance_ns(HOST_DATAFLASH_READ_CMD_LEN * HOST_SPI_BYTE_NS(DATAFLASH_BAUD_DIVIDER));
+	host_dataflash_read_address = address;
+}
+
+void dataflash_read_data_array(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length)
+{
+	dataflash_read_data_array_start(descriptor_pt, address);
+	host_dataflash_read(data, length);
+}
+
+void dataflash_read_bytes_from_opened_transfer(spi_flash_descriptor_t* descriptor_pt, uint8_t* data, uint32_t length) { host_dataflash_read(data, length); }
+void dataflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt) {}
+
+void dma_custom_fs_init_transfer(void* spi_data_p, void* datap, uint16_t size)
+{
+	host_dataflash_read((uint8_t*)datap, size);
+	host_dma_custom_fs_done = TRUE;
+}
+
+BOOL dma_custom_fs_check_and_clear_dma_transfer_flag(void)
+{
+	BOOL done = host_dma_custom_fs_done;
+	host_dma_custom_fs_done = FALSE;
+	return done;
+}
+
+void dma_set_custom_fs_flag_done(void) { host_dma_custom_fs_done = TRUE; }
+uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size, sha256_context_t* sha256_context, uint32_t nb_bytes_not_hashed) { return 0; }
+void dma_reset(void) {}
+
+/* Scripted wheel: UP/DOWN are increments, the GDDRAM is captured when a prompt polls an empty queue, then left with a long click */
+static wheel_action_ret_te host_inputs_queue[HOST_INPUTS_QUEUE_LENGTH];
+static uint16_t host_inputs_queue_start, host_inputs_queue_end;
+BOOL host_inputs_captured = FALSE;
+uint8_t host_inputs_capture[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/2];
+
+void host_inputs_push(wheel_action_ret_te action)
+{
+	if (host_inputs_queue_end < HOST_INPUTS_QUEUE_LENGTH)
+	{
+		host_inputs_queue[host_inputs_queue_end++] = action;
+	}
+}
+
+wheel_action_ret_te inputs_get_wheel_action(BOOL wait_for_action, BOOL ignore_incdec)
+{
+	if (host_inputs_queue_start == host_inputs_queue_end)
+	{
+		if (host_inputs_captured == FALSE)
+		{
+			memcpy(host_inputs_capture, host_sh1122_get_display(), sizeof(host_inputs_capture));
+			host_inputs_captured = TRUE;
+		}
+		return WHEEL_ACTION_LONG_CLICK;
+	}
+	wheel_action_ret_te action = host_inputs_queue[host_inputs_queue_start];
+	if ((ignore_incdec != FALSE) && ((action == WHEEL_ACTION_UP) || (action == WHEEL_ACTION_DOWN)))
+	{
+		return WHEEL_ACTION_NONE;
+	}
+	host_inputs_queue_start++;
+	return action;
+}
+
+int16_t inputs_get_wheel_increment(void)
+{
+	if ((host_inputs_queue_start == host_inputs_queue_end) || ((host_inputs_queue[host_inputs_queue_start] != WHEEL_ACTION_UP) && (host_inputs_queue[host_inputs_queue_start] != WHEEL_ACTION_DOWN)))
+	{
+		return 0;
+	}
+	return (host_inputs_queue[host_inputs_queue_start++] == WHEEL_ACTION_UP)? 1 : -1;
+}
+
+void inputs_clear_detections(void) {}
+
+/* Rest of the platform */
+void logic_device_activity_detected(void) { timer_start_timer(TIMER_USER_INTERACTION, 30000); timer_start_timer(TIMER_SCREEN, 60000); }
+power_source_te logic_power_get_power_source(void) { return USB_POWERED; }
+void comms_aux_mcu_routine(msg_restrict_type_te answer_restrict_type) {}
+RET_TYPE comms_hid_msgs_cancel_request_received(void) { return RETURN_NOK; }
+void comms_trace_log_1(comms_trace_id_te id, uint32_t arg1) {}
+RET_TYPE rng_fill_array(uint8_t* array, uint16_t nb_bytes) { memset(array, 0, nb_bytes); return RETURN_OK; }
+void platform_io_power_down_oled(void) {}
+void main_standby_sleep(void) {}
+void debug_debug_menu(void) {}
+
+/* Scenario start: empty input queue, timers & counters reset, frame buffer & GDDRAM left as they are */
+void host_gui_scenario_start(void)
+{
+	host_inputs_queue_start = host_inputs_queue_end = 0;
+	host_inputs_captured = FALSE;
+	host_timer_reset();
+	logic_device_activity_detected();
+	host_sh1122_nb_spi_bytes = host_dataflash_nb_reads = host_dataflash_nb_bytes_read = 0;
+	host_sh1122_first_data_ns = host_sh1122_last_data_ns = 0;
+	host_dbflash_nb_reads = host_dbflash_nb_bytes_read = 0;
+}
+
+/* Bundle & display init, as main_platform_init() does */
+RET_TYPE host_gui_init(void)
+{
+	memset(host_sh1122_gddram, 0, sizeof(host_sh1122_gddram));
+	custom_fs_set_dataflash_descriptor(&dataflash_descriptor);
+	if (custom_fs_init() != RETURN_OK)
+	{
+		return RETURN_NOK;
+	}
+	sh1122_init_display(&plat_oled_descriptor);
+	return RETURN_OK;
+}
+
+/* Logged in user with nb_services credentials, stored with the batch API */
+RET_TYPE host_gui_create_user(uint16_t nb_services)
+{
+	static cust_char_t services[NODEMGMT_BATCH_MAX_NB_CREDS][24];
+	static cust_char_t logins[NODEMGMT_BATCH_MAX_NB_CREDS][24];
+	static uint8_t passwords[NODEMGMT_BATCH_MAX_NB_CREDS][8];
+	nodemgmt_batch_cred_t creds[NODEMGMT_BATCH_MAX_NB_CREDS];
+	cpz_lut_entry_t cpz_entry;
+	uint8_t card_aes_key[AES_KEY_LENGTH/8];
+	uint16_t nb_stored;
+
+	host_dbflash_erase();
+	nodemgmt_format_user_profile(0);
+	nodemgmt_init_context(0);
+	memset(&cpz_entry, 0, sizeof(cpz_entry));
+	memset(card_aes_key, 0x5A, sizeof(card_aes_key));
+	logic_encryption_init_context(card_aes_key, &cpz_entry);
+	logic_security_smartcard_unlocked_actions();
+
+	for (uint16_t i = 0; i < nb_services; i += NODEMGMT_BATCH_MAX_NB_CREDS)
+	{
+		uint16_t nb_creds = ((nb_services - i) < NODEMGMT_BATCH_MAX_NB_CREDS)? (nb_services - i) : NODEMGMT_BATCH_MAX_NB_CREDS;
+		for (uint16_t j = 0; j < nb_creds; j++)
+		{
+			char temp_string[24];
+			snprintf(temp_string, sizeof(temp_string), "service%04u.com", i + j);
+			for (uint16_t k = 0; k < sizeof(temp_string); k++) services[j][k] = (cust_char_t)temp_string[k];
+			snprintf(temp_string, sizeof(temp_string), "user%04u", (i + j) * 7 % 1000);
+			for (uint16_t k = 0; k < sizeof(temp_string); k++) logins[j][k] = (cust_char_t)temp_string[k];
+			memset(passwords[j], 'p', sizeof(passwords[j]));
+			creds[j].service = services[j];
+			creds[j].login = logins[j];
+			creds[j].password = passwords[j];
+			creds[j].password_length = sizeof(passwords[j]);
+		}
+		if ((nodemgmt_store_credentials_batch(creds, nb_creds, &nb_stored) != RETURN_OK) || (nb_stored != nb_creds))
+		{
+			return RETURN_NOK;
+		}
+	}
+	return RETURN_OK;
+}
+
+/* Scenarios */
+void host_gui_show_screen(gui_screen_te screen)
+{
+	gui_dispatcher_set_current_screen(screen, TRUE, OLED_TRANS_NONE);
+	gui_dispatcher_get_back_to_current_screen();
+}
+
+void host_gui_render_pin(uint16_t selected_digit, uint16_t string_id)
+{
+	uint8_t pin[4] = {0x01, 0x02, 0x03, 0x04};
+	gui_prompts_render_pin_enter_screen(pin, selected_digit, string_id, 0, 0);
+}
+
+/* PIN prompt steps, as gui_prompts_get_user_pin() does them */
+static uint8_t host_gui_pin[4];
+
+void host_gui_pin_start(uint16_t string_id)
+{
+	memset(host_gui_pin, 0, sizeof(host_gui_pin));
+	sh1122_load_transition(&plat_oled_descriptor, OLED_OUT_IN_TRANS);
+	gui_prompts_render_pin_enter_screen(host_gui_pin, 0, string_id, 0, 0);
+}
+
+void host_gui_pin_step(uint16_t selected_digit, int16_t vert_anim_direction, int16_t hor_anim_direction, uint16_t string_id)
+{
+	gui_prompts_render_pin_enter_screen(host_gui_pin, selected_digit, string_id, vert_anim_direction, hor_anim_direction);
+	host_gui_pin[selected_digit] = (host_gui_pin[selected_digit] + vert_anim_direction) & 0x0F;
+}
+
+mini_input_yes_no_ret_te host_gui_ask_for_confirmation(uint16_t nb_lines)
+{
+	confirmationText_t text = {.lines = {u"Approve login for", u"service0001.com", u"with user0007?", u"Fourth line"}};
+	return gui_prompts_ask_for_confirmation(nb_lines, &text, FALSE);
+}
+
+/* Text layouts of arbitrary strings in a given text box, displayed like information notifications. gui_prompts.c is built here for its static layout functions */
+#include "gui_prompts.c"
+text_layout_t host_text_layout;
+
+void host_gui_render_text_layout(const cust_char_t* string, int16_t min_text_x, int16_t max_text_x, uint16_t max_nb_lines)
+{
+	sh1122_load_transition(&plat_oled_descriptor, OLED_TRANS_NONE);
+	sh1122_clear_frame_buffer(&plat_oled_descriptor);
+	sh1122_set_min_text_x(&plat_oled_descriptor, min_text_x);
+	sh1122_set_max_text_x(&plat_oled_descriptor, max_text_x);
+	memset(&host_text_layout, 0, sizeof(host_text_layout));
+	gui_prompts_update_text_layout(&host_text_layout, string, TEXT_LAYOUT_NO_STRING_ID, FONT_UBUNTU_MEDIUM_16_ID, max_nb_lines);
+	gui_prompts_render_text_layout(&host_text_layout, INF_DISPLAY_TEXT_Y);
+	sh1122_reset_min_text_x(&plat_oled_descriptor);
+	sh1122_reset_max_text_x(&plat_oled_descriptor);
+	sh1122_flush_frame_buffer(&plat_oled_descriptor);
+}
+
+/* Cost of a layout: first computation, re-validation on the next redraw, render. Simulated ns & dataflash reads */
+void host_text_layout_bench(const cust_char_t* string, uint16_t font_id, uint16_t max_nb_lines, uint64_t* results)
+{
+	uint32_t start_reads = host_dataflash_nb_reads;
+	uint64_t start_ns = host_sim_get_ns();
+	memset(&host_text_layout, 0, sizeof(host_text_layout));
+	sh1122_set_max_text_x(&plat_oled_descriptor, CONF_PROMPT_MAX_TEXT_X);
+	gui_prompts_update_text_layout(&host_text_layout, string, TEXT_LAYOUT_NO_STRING_ID, font_id, max_nb_lines);
+	results[0] = host_sim_get_ns() - start_ns;
+	results[1] = host_dataflash_nb_reads - start_reads;
+	start_reads = host_dataflash_nb_reads;
+	start_ns = host_sim_get_ns();
+	gui_prompts_update_text_layout(&host_text_layout, string, TEXT_LAYOUT_NO_STRING_ID, font_id, max_nb_lines);
+	results[2] = host_sim_get_ns() - start_ns;
+	results[3] = host_dataflash_nb_reads - start_reads;
+	start_reads = host_dataflash_nb_reads;
+	start_ns = host_sim_get_ns();
+	gui_prompts_render_text_layout(&host_text_layout, 0);
+	results[4] = host_sim_get_ns() - start_ns;
+	results[5] = host_dataflash_nb_reads - start_reads;
+	start_reads = host_dataflash_nb_reads;
+	start_ns = host_sim_get_ns();
+	sh1122_get_string_width(&plat_oled_descriptor, string);
+	results[6] = host_sim_get_ns() - start_ns;
+	results[7] = host_dataflash_nb_reads - start_reads;
+	sh1122_reset_max_text_x(&plat_oled_descriptor);
+}
+
+/* Frame buffer checks against a pixel per byte reference, fill timings in host cycles */
+static uint8_t host_fb_reference[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH];
+
+static uint64_t host_fb_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+void host_fb_clear(void)
+{
+	sh1122_clear_frame_buffer(&plat_oled_descriptor);
+	memset(host_fb_reference, 0, sizeof(host_fb_reference));
+}
+
+void host_fb_rectangle(int16_t x, int16_t y, uint16_t width, uint16_t height, uint8_t color)
+{
+	sh1122_draw_rectangle(&plat_oled_descriptor, x, y, width, height, color, TRUE);
+	for (int16_t j = y; j < y + (int16_t)height; j++)
+	{
+		for (int16_t i = x; i < x + (int16_t)width; i++)
+		{
+			if ((i >= 0) && (i < SH1122_OLED_WIDTH) && (j >= 0) && (j < SH1122_OLED_HEIGHT))
+			{
+				host_fb_reference[j][i] = color & 0x0F;
+			}
+		}
+	}
+}
+
+void host_fb_vertical_line(int16_t x, int16_t ystart, int16_t yend, uint8_t color)
+{
+	sh1122_draw_vertical_line(&plat_oled_descriptor, x, ystart, yend, color, TRUE);
+	for (int16_t j = (ystart < 0)? 0 : ystart; (j <= yend) && (j < SH1122_OLED_HEIGHT); j++)
+	{
+		host_fb_reference[j][x] |= color & 0x0F;
+	}
+}
+
+/* Number of pixels differing from the reference, the frame buffer clear being waited for */
+uint32_t host_fb_compare(void)
+{
+	uint32_t nb_differences = 0;
+	sh1122_flush_frame_buffer_window(&plat_oled_descriptor, 0, 0, 0, 0);
+	for (uint16_t j = 0; j < SH1122_OLED_HEIGHT; j++)
+	{
+		for (uint16_t i = 0; i < SH1122_OLED_WIDTH; i++)
+		{
+			uint8_t pixel = ((i & 0x01) == 0)? (plat_oled_descriptor.frame_buffer[j][i/2] >> 4) : (plat_oled_descriptor.frame_buffer[j][i/2] & 0x0F);
+			if (pixel != host_fb_reference[j][i])
+			{
+				nb_differences++;
+			}
+		}
+	}
+	return nb_differences;
+}
+
+/* Host cycles for nb_iterations full screen rectangles: firmware line fill, then a pixel per pixel nibble fill */
+void host_fb_fill_bench(uint32_t nb_iterations, uint64_t* fill_cycles, uint64_t* nibble_cycles)
+{
+	uint64_t start_cycles = host_fb_cycles();
+	for (uint32_t k = 0; k < nb_iterations; k++)
+	{
+		sh1122_draw_rectangle(&plat_oled_descriptor, 1, 0, SH1122_OLED_WIDTH-2, SH1122_OLED_HEIGHT, k & 0x0F, TRUE);
+	}
+	*fill_cycles = host_fb_cycles() - start_cycles;
+	start_cycles = host_fb_cycles();
+	for (uint32_t k = 0; k < nb_iterations; k++)
+	{
+		for (uint16_t j = 0; j < SH1122_OLED_HEIGHT; j++)
+		{
+			volatile uint8_t* line = plat_oled_descriptor.frame_buffer[j];
+			for (uint16_t i = 1; i < SH1122_OLED_WIDTH-1; i++)
+			{
+				line[i/2] = ((i & 0x01) == 0)? ((line[i/2] & 0x0F) | (uint8_t)(k << 4)) : ((line[i/2] & 0xF0) | (k & 0x0F));
+			}
+		}
+	}
+	*nibble_cycles = host_fb_cycles() - start_cycles;
+}
+"""
+
+
+def loadGuiLibrary():
+	library = loadHostFirmware(MAIN_MCU_PROJECT, GUI_SOURCES, HOST_TIMER_STANDINS + HOST_DBFLASH_STANDINS + HOST_GUI_STANDINS, extra_include_dirs=[join(SOURCE_CODE_DIR, "main_mcu", "src", "GUI")])
+	library.host_sh1122_get_display.restype = ctypes.POINTER(ctypes.c_uint8 * (GUI_OLED_HEIGHT * GUI_OLED_WIDTH / 2))
+	library.host_sim_get_ns.restype = ctypes.c_uint64
+	library.gui_dispatcher_get_render_stats.restype = ctypes.POINTER(ctypes.c_uint32 * (5 * len(GUI_SCREEN_NAMES)))
+	bundle = open(GUI_BUNDLE_FILE, "rb").read()
+	library.host_dataflash_load(ctypes.create_string_buffer(bundle, len(bundle)), len(bundle))
+	if library.host_gui_init() != 0:
+		print "Couldn't initialize the custom fs from " + GUI_BUNDLE_FILE
+		return None
+	return library
+
+
+# Null terminated cust_char_t string
+def custCharString(text):
+	return (ctypes.c_uint16 * (len(text) + 1))(*([ord(c) for c in text] + [0]))
+
+
+# 4bpp GDDRAM, even pixel in the upper nibble, to 8 bits PGM
+def gddramToPgm(gddram):
+	pixels = bytearray()
+	for byte in gddram:
+		pixels.append((byte >> 4) * 17)
+		pixels.append((byte & 0x0F) * 17)
+	return "P5\n%d %d\n255\n" % (GUI_OLED_WIDTH, GUI_OLED_HEIGHT) + str(pixels)
+
+
+# Scenarios: name, list of (function name, arguments) calls. Snapshot is the display when the first empty input queue poll happens, or at the end
+def getGuiScenarios():
+	scenarios = []
+	for screen in ["NINSERTED", "INSERTED_LCK", "INSERTED_INVALID", "INSERTED_UNKNOWN", "MAIN_MENU", "BT", "OPERATIONS", "SETTINGS"]:
+		scenarios.append(("screen_" + screen.lower(), [("host_gui_show_screen", [GUI_SCREEN_NAMES.index(screen)])]))
+	scenarios.append(("main_menu_next", [("host_gui_show_screen", [GUI_SCREEN_NAMES.index("MAIN_MENU")]), ("gui_dispatcher_event_dispatch", [WHEEL_ACTION_DOWN])]))
+	scenarios.append(("main_menu_previous", [("host_gui_show_screen", [GUI_SCREEN_NAMES.index("MAIN_MENU")]), ("gui_dispatcher_event_dispatch", [WHEEL_ACTION_UP])]))
+	scenarios.append(("main_menu_next_twice", [("host_gui_show_screen", [GUI_SCREEN_NAMES.index("MAIN_MENU")]), ("gui_dispatcher_event_dispatch", [WHEEL_ACTION_DOWN]), ("gui_dispatcher_event_dispatch", [WHEEL_ACTION_DOWN])]))
+	for digit in range(0, 4):
+		scenarios.append(("pin_digit_" + str(digit), [("host_gui_render_pin", [digit, 0])]))
+	scenarios.append(("pin_incremental_steps", [("host_gui_pin_start", [0]), ("host_gui_pin_step", [0, 1, 0, 0]), ("host_gui_pin_step", [0, 1, 0, 0]), ("host_gui_pin_step", [1, 0, 1, 0]), ("host_gui_pin_step", [1, -1, 0, 0])]))
+	for nb_lines in range(1, 5):
+		scenarios.append(("confirmation_" + str(nb_lines) + "_lines", [("host_gui_ask_for_confirmation", [nb_lines])]))
+	scenarios.append(("confirmation_no_selected", [("host_inputs_push", [WHEEL_ACTION_UP]), ("host_gui_ask_for_confirmation", [2])]))
+	scenarios.append(("one_line_confirmation", [("gui_prompts_ask_for_one_line_confirmation", [36, 0])]))
+	for name, message_type in [("info", DISP_MSG_INFO), ("warning", DISP_MSG_WARNING), ("action", DISP_MSG_ACTION)]:
+		scenarios.append(("message_" + name, [("gui_prompts_display_information_on_screen", [37, message_type])]))
+	scenarios.append(("layout_single_line", [("host_gui_render_text_layout", [custCharString(u"Card Removed"), 40, 256, 2])]))
+	scenarios.append(("layout_two_lines", [("host_gui_render_text_layout", [custCharString(u"Wrong Pin, 3 Tries Left"), 64, 192, 2])]))
+	scenarios.append(("layout_forced_break", [("host_gui_render_text_layout", [custCharString(u"Line one\nLine two"), 40, 256, 2])]))
+	scenarios.append(("layout_truncated", [("host_gui_render_text_layout", [custCharString(u"Please insert your card and enter your PIN to unlock the device"), 40, 256, 2])]))
+	scenarios.append(("layout_long_word", [("host_gui_render_text_layout", [custCharString(u"averyveryverylongservicename.example.com"), 64, 192, 2])]))
+	scenarios.append(("credential_list_logged_out", [("logic_security_clear_security_bools", []), ("host_gui_show_screen", [GUI_SCREEN_NAMES.index("LOGIN")]), ("logic_security_smartcard_unlocked_actions", [])]))
+	scenarios.append(("credential_list", [("host_gui_show_screen", [GUI_SCREEN_NAMES.index("LOGIN")])]))
+	scenarios.append(("credential_list_scrolled", [("host_gui_show_screen", [GUI_SCREEN_NAMES.index("LOGIN")])] + [("gui_dispatcher_event_dispatch", [WHEEL_ACTION_DOWN])] * 6))
+	return scenarios
+
+
+# Render every scenario, compare with the golden images (or store them), print per scenario & per screen render figures
+def runGuiRenderHostTest(update_golden=False, nb_services=20):
+	library = loadGuiLibrary()
+	if library is None:
+		return False
+	if library.host_gui_create_user(nb_services) != 0:
+		print "Couldn't store " + str(nb_services) + " credentials"
+		return False
+	if update_golden and not os.path.isdir(GUI_GOLDEN_DIR):
+		os.makedirs(GUI_GOLDEN_DIR)
+	library.gui_dispatcher_reset_render_stats()
+
+	nb_failed = 0
+	print "Scenario".ljust(28), "Result".ljust(10), "Sim ms".rjust(8), "Flash rd".rjust(9), "Flash B".rjust(9), "DB rd".rjust(6), "OLED B".rjust(8), "Host us".rjust(9)
+	for name, calls in getGuiScenarios():
+		library.host_gui_scenario_start()
+		start_sim_ns = library.host_sim_get_ns()
+		start_ns = time.time()
+		for function_name, arguments in calls:
+			getattr(library, function_name)(*arguments)
+		host_us = (time.time() - start_ns) * 1000000
+		sim_ms = (library.host_sim_get_ns() - start_sim_ns) / 1000000.0
+		if ctypes.c_int.in_dll(library, "host_inputs_captured").value != 0:
+			gddram = bytearray((ctypes.c_uint8 * (GUI_OLED_HEIGHT * GUI_OLED_WIDTH / 2)).in_dll(library, "host_inputs_capture"))
+		else:
+			gddram = bytearray(library.host_sh1122_get_display().contents)
+		image = gddramToPgm(gddram)
+
+		golden_file = join(GUI_GOLDEN_DIR, name + ".pgm")
+		if update_golden:
+			open(golden_file, "wb").write(image)
+			result = "STORED"
+		elif not os.path.isfile(golden_file):
+			result = "NO GOLDEN"
+			nb_failed += 1
+		elif open(golden_file, "rb").read() != image:
+			open(join(tempfile.gettempdir(), name + ".pgm"), "wb").write(image)
+			result = "DIFFERS"
+			nb_failed += 1
+		else:
+			result = "OK"
+		print name.ljust(28), result.ljust(10), ("%.1f" % sim_ms).rjust(8), str(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_reads").value).rjust(9), str(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_bytes_read").value).rjust(9),
+		print str(ctypes.c_uint32.in_dll(library, "host_dbflash_nb_reads").value).rjust(6), str(ctypes.c_uint32.in_dll(library, "host_sh1122_nb_spi_bytes").value).rjust(8), ("%.0f" % host_us).rjust(9)
+
+	# Firmware render statistics (DEBUG_RENDER_STATS_ENABLED), simulated systick: SPI bus time & delays, CPU time excluded
+	print ""
+	print "Screen".ljust(20), "Renders".rjust(8), "Avg ms".rjust(8), "Max ms".rjust(8), "Flash rd".rjust(9), "Flash B".rjust(9)
+	stats = library.gui_dispatcher_get_render_stats().contents
+	for i in range(0, len(GUI_SCREEN_NAMES)):
+		nb_renders, total_ms, max_ms, nb_reads, nb_bytes = stats[i*5:i*5+5]
+		if nb_renders != 0:
+			print GUI_SCREEN_NAMES[i].ljust(20), str(nb_renders).rjust(8), ("%.1f" % (float(total_ms) / nb_renders)).rjust(8), str(max_ms).rjust(8), str(nb_reads / nb_renders).rjust(9), str(nb_bytes / nb_renders).rjust(9)
+
+	# DMA frame buffer clears: CPU time spent waiting with the wait deferred to the next frame buffer access, vs waiting right away
+	nb_clears = ctypes.c_uint32.in_dll(library, "host_dma_memset_nb_transfers").value
+	print ""
+	print "DMA frame buffer clears: " + str(nb_clears) + ", CPU wait " + ("%.1f" % (ctypes.c_uint64.in_dll(library, "host_dma_memset_wait_ns").value / 1000.0)) + "us",
+	print "(" + ("%.1f" % (nb_clears * GUI_OLED_HEIGHT * GUI_OLED_WIDTH / 8 * GUI_DMA_MEMSET_WORD_NS / 1000.0)) + "us when waiting after starting each clear)"
+
+	if update_golden:
+		print "Golden images stored in " + GUI_GOLDEN_DIR
+	elif nb_failed == 0:
+		print "All renders match their golden image"
+	else:
+		print str(nb_failed) + " renders differ, stored in " + tempfile.gettempdir()
+	return nb_failed == 0
+
+
+# Scroll through the whole credential list at several wheel speeds: a detent every period_ms, processed one by one as the
+# firmware does. A frame is dropped when the next detent arrives before the current step is rendered & flushed
+def runCredentialListBenchmark(nb_services=500, periods_ms=[50, 20, 10]):
+	library = loadGuiLibrary()
+	if library is None:
+		return False
+	if library.host_gui_create_user(nb_services) != 0:
+		print "Couldn't store " + str(nb_services) + " credentials"
+		return False
+	nb_steps = nb_services - 1
+
+	print str(nb_services) + " services, " + str(nb_steps) + " wheel steps from the first to the last one"
+	print "Detent ms".rjust(10), "Avg ms".rjust(8), "Max ms".rjust(8), "Dropped".rjust(8), "Lag ms".rjust(8), "Flash rd/step".rjust(14), "Flash B/step".rjust(13), "DB rd/step".rjust(11), "DB B/step".rjust(10)
+	for period_ms in periods_ms:
+		library.host_gui_scenario_start()
+		library.host_gui_show_screen(GUI_SCREEN_NAMES.index("LOGIN"))
+		library.host_gui_scenario_start()
+		step_times_ms = []
+		for step in range(0, nb_steps):
+			start_sim_ns = library.host_sim_get_ns()
+			library.gui_dispatcher_event_dispatch(WHEEL_ACTION_DOWN)
+			step_times_ms.append((library.host_sim_get_ns() - start_sim_ns) / 1000000.0)
+
+		# Timeline: step k starts when its detent arrived and the previous step is done
+		end_ms = 0.0
+		nb_dropped = 0
+		for step in range(0, nb_steps):
+			end_ms = max(end_ms, step * period_ms) + step_times_ms[step]
+			if step + 1 < nb_steps and end_ms > (step + 1) * period_ms:
+				nb_dropped += 1
+		lag_ms = end_ms - (nb_steps - 1) * period_ms
+
+		print str(period_ms).rjust(10), ("%.2f" % (sum(step_times_ms) / nb_steps)).rjust(8), ("%.2f" % max(step_times_ms)).rjust(8), str(nb_dropped).rjust(8), ("%.1f" % lag_ms).rjust(8),
+		print ("%.1f" % (float(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_reads").value) / nb_steps)).rjust(14), ("%.0f" % (float(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_bytes_read").value) / nb_steps)).rjust(13),
+		print ("%.2f" % (float(ctypes.c_uint32.in_dll(library, "host_dbflash_nb_reads").value) / nb_steps)).rjust(11), ("%.0f" % (float(ctypes.c_uint32.in_dll(library, "host_dbflash_nb_bytes_read").value) / nb_steps)).rjust(10)
+
+	# Scrolls shift the frame buffer and render a single line: each frame must match a full render, both ways
+	library.host_gui_scenario_start()
+	library.host_gui_show_screen(GUI_SCREEN_NAMES.index("LOGIN"))
+	nb_checked_steps = min(nb_steps, 12)
+	nb_failed = 0
+	for wheel_action in [WHEEL_ACTION_DOWN] * nb_checked_steps + [WHEEL_ACTION_UP] * nb_checked_steps:
+		library.gui_dispatcher_event_dispatch(wheel_action)
+		shifted_frame = bytearray(library.host_sh1122_get_display().contents)
+		library.gui_dispatcher_event_dispatch(WHEEL_ACTION_NONE)
+		if bytearray(library.host_sh1122_get_display().contents) != shifted_frame:
+			nb_failed += 1
+	print "Scrolled frames matching a full render:".ljust(40), "OK" if nb_failed == 0 else (str(nb_failed) + " of " + str(2 * nb_checked_steps) + " FAILED")
+	return nb_failed == 0
+
+
+# Frame buffer fills checked pixel for pixel against a reference over random rectangles & vertical lines, fill timings
+def runFrameBufferHostTest(nb_iterations=2000, seed=0):
+	library = loadGuiLibrary()
+	if library is None:
+		return False
+	rng = random.Random(seed)
+	nb_failed = 0
+	for iteration in range(0, nb_iterations):
+		library.host_fb_clear()
+		for shape in range(0, rng.randint(1, 8)):
+			if rng.randint(0, 3) == 0:
+				ystart = rng.randint(-4, GUI_OLED_HEIGHT + 4)
+				library.host_fb_vertical_line(rng.randint(0, GUI_OLED_WIDTH - 1), ystart, ystart + rng.randint(0, GUI_OLED_HEIGHT), rng.randint(0, 15))
+			else:
+				library.host_fb_rectangle(rng.randint(-20, GUI_OLED_WIDTH + 4), rng.randint(-4, GUI_OLED_HEIGHT + 4), rng.randint(0, GUI_OLED_WIDTH + 40), rng.randint(0, 12), rng.randint(0, 15))
+		if library.host_fb_compare() != 0:
+			nb_failed += 1
+	print "Random frame buffer fills:".ljust(40), "OK" if nb_failed == 0 else (str(nb_failed) + " of " + str(nb_iterations) + " FAILED")
+
+	fill_cycles = ctypes.c_uint64(0)
+	nibble_cycles = ctypes.c_uint64(0)
+	library.host_fb_fill_bench(200, ctypes.byref(fill_cycles), ctypes.byref(nibble_cycles))
+	print "Host full screen fill, firmware:".ljust(40), ("%.0f cycles" % (fill_cycles.value / 200.0)).rjust(16)
+	print "Host full screen fill, pixel per pixel:".ljust(40), ("%.0f cycles" % (nibble_cycles.value / 200.0)).rjust(16)
+	return nb_failed == 0
+
+
+# Cost of the text layouts used by the confirmation prompt (font 0, single scrolled line) and the notifications (font 1, 2 lines):
+# first layout, re-validation done on each redraw, render from the layout, and the plain width measure the layout replaces
+def runTextLayoutBenchmark():
+	library = loadGuiLibrary()
+	if library is None:
+		return False
+	strings = [(u"Approve login for", 0, 0), (u"service0001.com", 0, 0), (u"averyveryverylongservicename.example.com", 0, 0),
+				(u"Wrong Pin, 3 Tries Left", 1, 2), (u"Please insert your card and enter your PIN to unlock the device", 1, 2)]
+	results = (ctypes.c_uint64 * 8)()
+	print "String".ljust(42), "Font".rjust(4), "Lines".rjust(5), "Layout us/rd".rjust(13), "Redraw us/rd".rjust(13), "Render us/rd".rjust(13), "Width us/rd".rjust(13)
+	for text, font_id, max_nb_lines in strings:
+		string = custCharString(text)
+		library.host_gui_scenario_start()
+		library.host_text_layout_bench(string, font_id, max_nb_lines, results)
+		print (text if len(text) <= 40 else text[0:37] + "...").ljust(42), str(font_id).rjust(4), str(max_nb_lines).rjust(5),
+		print " ".join([("%.0f/%d" % (results[i] / 1000.0, results[i+1])).rjust(13) for i in range(0, 8, 2)])
+
+	# Notification shown again after a language switch: its layout must be redone, the string buffer & font being the same
+	switch_ok = True
+	if library.custom_fs_get_number_of_languages() > 1:
+		library.host_gui_scenario_start()
+		frames = []
+		for language_id, string_ids in [(0, [37]), (1, [37]), (1, [36, 37])]:
+			library.custom_fs_set_current_language(language_id)
+			for string_id in string_ids:
+				library.gui_prompts_display_information_on_screen(string_id, 0)
+			frames.append(bytearray(library.host_sh1122_get_display().contents))
+		library.custom_fs_set_current_language(0)
+		switch_ok = (frames[1] == frames[2]) and (frames[0] != frames[1])
+		print "Layout after a language switch:".ljust(42), "OK" if switch_ok else "FAILED"
+	return switch_ok
+
+
+# PIN prompt wheel-to-photon: each step of a PIN entry, from the wheel action to the first & last GDDRAM writes. The full redraw
+# step renders the whole screen again, as every wheel action did before the incremental rendering
+def runPinEntryBenchmark(string_id=0):
+	library = loadGuiLibrary()
+	if library is None:
+		return False
+	steps = [("first display", "host_gui_pin_start", [string_id]), ("digit 0 up", "host_gui_pin_step", [0, 1, 0, string_id]),
+			("digit 0 down", "host_gui_pin_step", [0, -1, 0, string_id]), ("next digit", "host_gui_pin_step", [1, 0, 1, string_id]),
+			("digit 1 up", "host_gui_pin_step", [1, 1, 0, string_id]), ("previous digit", "host_gui_pin_step", [0, 0, -1, string_id]),
+			("full redraw", "host_gui_pin_step", [0, 0, 0, string_id])]
+	print "Step".ljust(16), "1st pixel ms".rjust(13), "Done ms".rjust(8), "Last px ms".rjust(11), "OLED B".rjust(8), "Flash rd".rjust(9), "Flash B".rjust(8)
+	for name, function_name, arguments in steps:
+		library.host_gui_scenario_start()
+		start_ns = library.host_sim_get_ns()
+		getattr(library, function_name)(*arguments)
+		done_ms = (library.host_sim_get_ns() - start_ns) / 1000000.0
+		first_ns = ctypes.c_uint64.in_dll(library, "host_sh1122_first_data_ns").value
+		last_ns = ctypes.c_uint64.in_dll(library, "host_sh1122_last_data_ns").value
+		print name.ljust(16), ("%.2f" % ((first_ns - start_ns) / 1000000.0) if first_ns != 0 else "-").rjust(13), ("%.2f" % done_ms).rjust(8), ("%.2f" % ((last_ns - start_ns) / 1000000.0) if last_ns != 0 else "-").rjust(11),
+		print str(ctypes.c_uint32.in_dll(library, "host_sh1122_nb_spi_bytes").value).rjust(8), str(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_reads").value).rjust(9), str(ctypes.c_uint32.in_dll(library, "host_dataflash_nb_bytes_read").value).rjust(8)
+	return True
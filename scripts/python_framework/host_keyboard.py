@@ -0,0 +1,423 @@
+#!/usr/bin/env python2
+from host_firmware import *
+import random
+import ctypes
+
+# Keyboard typing on the host: the aux MCU typing engine (aux_mcu_v2/src/LOGIC/logic_keyboard.c) runs on a virtual clock,
+# with the host polling the keyboard endpoint once per USB frame or the BLE chip sending notifications at each connection
+# event, and a host-side keyboard state machine decoding the reports
+
+# USB full speed interrupt endpoint, bInterval = 1
+SIM_USB_FRAME_TIME			= 0.001
+# From logic_keyboard.h / comms_main_mcu.h
+SIM_REPORT_NB_KEYS			= getFirmwareDefine(AUX_MCU_PROJECT, "LOGIC/logic_keyboard.h", "LOGIC_KEYBOARD_REPORT_NB_KEYS")
+SIM_REPORT_TIMEOUT_MS		= getFirmwareDefine(AUX_MCU_PROJECT, "LOGIC/logic_keyboard.h", "LOGIC_KEYBOARD_REPORT_TIMEOUT_MS")
+SIM_BLE_MAX_IN_FLIGHT		= getFirmwareDefine(AUX_MCU_PROJECT, "LOGIC/logic_keyboard.h", "LOGIC_KEYBOARD_BLE_MAX_IN_FLIGHT")
+SIM_TYPE_MAX_NB_KEYS		= getFirmwareDefine(AUX_MCU_PROJECT, "COMMS/comms_main_mcu.h", "KEYBOARD_TYPE_MAX_NB_KEYS")
+SIM_REPORT_QUEUE_SIZE		= 2*SIM_TYPE_MAX_NB_KEYS + 1
+SIM_INTERFACE_USB			= getFirmwareDefine(AUX_MCU_PROJECT, "COMMS/comms_main_mcu.h", "KEYBOARD_TYPE_INTERFACE_USB")
+SIM_INTERFACE_BLE			= getFirmwareDefine(AUX_MCU_PROJECT, "COMMS/comms_main_mcu.h", "KEYBOARD_TYPE_INTERFACE_BLE")
+SIM_STATUS_FAILED			= getFirmwareDefine(AUX_MCU_PROJECT, "COMMS/comms_main_mcu.h", "KEYBOARD_TYPE_STATUS_FAILED")
+SIM_STATUS_TYPED			= getFirmwareDefine(AUX_MCU_PROJECT, "COMMS/comms_main_mcu.h", "KEYBOARD_TYPE_STATUS_TYPED")
+
+# BLE notification path: aux MCU <> BLE chip UART command round trip, two commands per report (characteristic value set, notification send)
+SIM_BLE_CMD_TIME			= 0.0005
+# Notifications the BLE chip sends in a connection event: depends on the chip and on the host stack, 4 is a common minimum
+SIM_BLE_NOTIFS_PER_EVENT	= 4
+# Former mini_ble_task() demo typing: delays before the press report, before the release report and after it
+SIM_BLE_DEMO_DELAYS			= [0.200 + 0.020, 0.020]
+
+# HID modifier bits
+SIM_MODIFIER_NONE			= 0x00
+SIM_MODIFIER_LEFT_SHIFT		= 0x02
+
+# Aux MCU stand-ins: keyboard endpoint served by the simulated frames, BLE chip queueing the notifications it's given,
+# typed status kept for the harness. The host loops run the main loop between frames or connection events
+HOST_KEYBOARD_STANDINS = r"""
+#include "hid_keyboard_app.h"
+#include "comms_main_mcu.h"
+#include "logic_keyboard.h"
+#include "comms_trace.h"
+#include "comms_usb.h"
+#include "logic.h"
+#include "usb.h"
+#include "dma.h"
+
+#define HOST_USB_FRAME_NS               1000000ULL
+#define HOST_MAIN_LOOP_NS               100000ULL
+#define HOST_BLE_QUEUE_LENGTH           16
+#define HOST_KEYBOARD_MAX_NB_REPORTS    (LOGIC_KEYBOARD_REPORT_QUEUE_SIZE + 1)
+#define HOST_KEYBOARD_NO_STATUS         0xFFFF
+
+BOOL host_keyboard_usb_configured = TRUE;
+BOOL host_keyboard_ble_connected = TRUE;
+uint64_t host_keyboard_ble_cmd_ns = 0;
+uint16_t host_keyboard_typed_status = HOST_KEYBOARD_NO_STATUS;
+keyboard_report_t host_keyboard_received[HOST_KEYBOARD_MAX_NB_REPORTS];
+uint16_t host_keyboard_nb_received = 0;
+static uint8_t* host_keyboard_usb_report = 0;
+static keyboard_report_t host_keyboard_ble_queue[HOST_BLE_QUEUE_LENGTH];
+static uint64_t host_keyboard_ble_queue_ns[HOST_BLE_QUEUE_LENGTH];
+static uint16_t host_keyboard_ble_write_seq = 0, host_keyboard_ble_read_seq = 0;
+static aux_mcu_message_t host_keyboard_tx_message;
+
+void usb_send(int ep, uint8_t* data, int size) { if (ep == USB_KEYBOARD_ENDPOINT) host_keyboard_usb_report = data; }
+BOOL comms_usb_is_configured(void) { return host_keyboard_usb_configured; }
+BOOL logic_is_ble_enabled(void) { return TRUE; }
+BOOL mini_ble_is_keyboard_connected(void) { return host_keyboard_ble_connected; }
+aux_mcu_message_t* comms_main_mcu_get_temp_tx_message_object_pt(void) { return &host_keyboard_tx_message; }
+void dma_wait_for_main_mcu_packet_sent(void) {}
+void comms_main_mcu_send_message(aux_mcu_message_t* message, uint16_t message_length) { host_keyboard_typed_status = message->keyboard_type_message.typed_status; }
+void comms_trace_log_3(comms_trace_id_te id, uint32_t arg1, uint32_t arg2, uint32_t arg3) {}
+
+/* Report copied into the BLE chip, sent at the first connection event after the UART commands are done */
+void mini_ble_send_keyboard_report(uint8_t* report, uint16_t length)
+{
+	if ((uint16_t)(host_keyboard_ble_write_seq - host_keyboard_ble_read_seq) >= HOST_BLE_QUEUE_LENGTH)
+	{
+		__builtin_trap();
+	}
+	host_sim_ns += host_keyboard_ble_cmd_ns;
+	host_keyboard_ble_queue_ns[host_keyboard_ble_write_seq % HOST_BLE_QUEUE_LENGTH] = host_sim_ns;
+	memcpy(&host_keyboard_ble_queue[host_keyboard_ble_write_seq++ % HOST_BLE_QUEUE_LENGTH], report, length);
+}
+
+/* Type message from the main MCU */
+void host_keyboard_type(keyboard_key_t* keys, uint16_t nb_keys, uint16_t interface_id, uint16_t delay_between_reports)
+{
+	static aux_mcu_message_t message;
+
+	memset(&message, 0, sizeof(message));
+	message.message_type = AUX_MCU_MSG_TYPE_KEYBOARD_TYPE;
+	message.payload_length1 = sizeof(keyboard_type_message_t) + nb_keys*sizeof(keyboard_key_t);
+	message.keyboard_type_message.interface_identifier = interface_id;
+	message.keyboard_type_message.delay_between_reports = delay_between_reports;
+	message.keyboard_type_message.nb_keys = nb_keys;
+	memcpy(message.keyboard_type_message.keys, keys, nb_keys*sizeof(keyboard_key_t));
+	host_sim_ns = 0;
+	host_keyboard_usb_report = 0;
+	host_keyboard_nb_received = 0;
+	host_keyboard_ble_read_seq = host_keyboard_ble_write_seq = 0;
+	host_keyboard_typed_status = HOST_KEYBOARD_NO_STATUS;
+	logic_keyboard_deal_with_type_message(&message);
+}
+
+/* USB: at each frame the host fetches the armed report, and the endpoint interrupt fires. The host stops fetching after
+ * max_nb_fetches reports. Returns when done typing, with the time the last report was fetched at */
+uint64_t host_keyboard_usb_run(uint16_t max_nb_fetches)
+{
+	uint64_t last_fetch_ns = 0;
+
+	while (logic_keyboard_is_typing() != FALSE)
+	{
+		host_sim_ns += HOST_USB_FRAME_NS;
+		logic_keyboard_routine();
+		if ((host_keyboard_usb_report != 0) && (host_keyboard_nb_received < max_nb_fetches))
+		{
+			memcpy(&host_keyboard_received[host_keyboard_nb_received++], host_keyboard_usb_report, sizeof(keyboard_report_t));
+			host_keyboard_usb_report = 0;
+			last_fetch_ns = host_sim_ns;
+			logic_keyboard_usb_send_callback();
+		}
+	}
+	return last_fetch_ns;
+}
+
+/* USB: report left on the keyboard endpoint, if any */
+BOOL host_keyboard_usb_get_armed_report(keyboard_report_t* report)
+{
+	if (host_keyboard_usb_report == 0)
+	{
+		return FALSE;
+	}
+	memcpy(report, host_keyboard_usb_report, sizeof(*report));
+	return TRUE;
+}
+
+/* BLE: the main loop runs every HOST_MAIN_LOOP_NS, at each connection event the chip sends up to notifs_per_event queued
+ * reports and confirms them. Notification number failed_notification fails. Returns when done typing and all queued reports
+ * are sent, with the time the last report was sent at */
+uint64_t host_keyboard_ble_run(uint64_t conn_interval_ns, uint16_t notifs_per_event, uint16_t failed_notification)
+{
+	uint64_t next_event_ns = conn_interval_ns;
+	uint64_t last_sent_ns = 0;
+	uint16_t nb_notifications = 0;
+
+	while ((logic_keyboard_is_typing() != FALSE) || (host_keyboard_ble_read_seq != host_keyboard_ble_write_seq))
+	{
+		logic_keyboard_routine();
+		host_sim_ns += HOST_MAIN_LOOP_NS;
+		if (host_sim_ns >= next_event_ns)
+		{
+			for (uint16_t i = 0; (i < notifs_per_event) && (host_keyboard_ble_read_seq != host_keyboard_ble_write_seq) && (host_keyboard_ble_queue_ns[host_keyboard_ble_read_seq % HOST_BLE_QUEUE_LENGTH] <= next_event_ns); i++)
+			{
+				uint16_t index = host_keyboard_ble_read_seq++ % HOST_BLE_QUEUE_LENGTH;
+				if (nb_notifications++ != failed_notification)
+				{
+					memcpy(&host_keyboard_received[host_keyboard_nb_received++], &host_keyboard_ble_queue[index], sizeof(keyboard_report_t));
+					last_sent_ns = next_event_ns;
+					logic_keyboard_ble_notification_confirmed_callback(TRUE);
+				}
+				else
+				{
+					logic_keyboard_ble_notification_confirmed_callback(FALSE);
+				}
+			}
+			next_event_ns += conn_interval_ns;
+		}
+	}
+	return last_sent_ns;
+}
+"""
+
+
+class keyboard_key_t(ctypes.Structure):
+	_fields_ = [("modifier", ctypes.c_uint8), ("keycode", ctypes.c_uint8)]
+
+
+class keyboard_report_t(ctypes.Structure):
+	_fields_ = [("modifier", ctypes.c_uint8), ("reserved", ctypes.c_uint8), ("keys", ctypes.c_uint8 * SIM_REPORT_NB_KEYS)]
+
+
+def loadKeyboardLibrary():
+	library = loadHostFirmware(AUX_MCU_PROJECT, ["LOGIC/logic_keyboard.c"], HOST_TIMER_STANDINS + HOST_KEYBOARD_STANDINS)
+	library.host_keyboard_usb_run.restype = ctypes.c_uint64
+	library.host_keyboard_ble_run.restype = ctypes.c_uint64
+	library.host_keyboard_ble_run.argtypes = [ctypes.c_uint64, ctypes.c_uint16, ctypes.c_uint16]
+	return library
+
+
+# Report as a (modifier, [keycodes]) tuple
+def reportTuple(report):
+	return (report.modifier, [keycode for keycode in report.keys if keycode != 0])
+
+
+# US QWERTY layout: char -> (modifier byte, keycode), as logic_keyboard_get_hid_key_for_char() returns them on the main MCU
+def getUsLayout():
+	layout = {}
+	for i, c in enumerate("abcdefghijklmnopqrstuvwxyz"):
+		layout[c] = (SIM_MODIFIER_NONE, 0x04 + i)
+		layout[c.upper()] = (SIM_MODIFIER_LEFT_SHIFT, 0x04 + i)
+	for i, (c, shifted_c) in enumerate(zip("1234567890", "!@#$%^&*()")):
+		layout[c] = (SIM_MODIFIER_NONE, 0x1E + i)
+		layout[shifted_c] = (SIM_MODIFIER_LEFT_SHIFT, 0x1E + i)
+	for keycode, c, shifted_c in [(0x2C, " ", None), (0x2D, "-", "_"), (0x2E, "=", "+"), (0x2F, "[", "{"), (0x30, "]", "}"), (0x31, "\\", "|"), (0x33, ";", ":"), (0x34, "'", "\""), (0x35, "`", "~"), (0x36, ",", "<"), (0x37, ".", ">"), (0x38, "/", "?")]:
+		layout[c] = (SIM_MODIFIER_NONE, keycode)
+		if shifted_c is not None:
+			layout[shifted_c] = (SIM_MODIFIER_LEFT_SHIFT, keycode)
+	return layout
+
+
+# Reports built by logic_keyboard_build_reports(): (modifier, [keycodes]) tuples, None if they don't fit
+def buildReports(library, keys, max_nb_reports=SIM_REPORT_QUEUE_SIZE):
+	key_array = (keyboard_key_t * len(keys))(*[keyboard_key_t(modifier, keycode) for modifier, keycode in keys])
+	reports = (keyboard_report_t * max_nb_reports)()
+	nb_reports = library.logic_keyboard_build_reports(key_array, len(keys), reports, max_nb_reports)
+	if nb_reports == 0:
+		return None
+	return [reportTuple(report) for report in reports[0:nb_reports]]
+
+
+# Baseline: reports for a press and a release per key, which is what typing engines without key merging do
+def buildPressReleaseReports(keys):
+	reports = []
+	for key_modifier, keycode in keys:
+		reports.append((key_modifier, [keycode]))
+		reports.append((SIM_MODIFIER_NONE, []))
+	return reports
+
+
+# Host side keyboard: decodes reports into text, as a host keyboard driver would
+class simulated_host_keyboard:
+
+	def __init__(self, layout):
+		self.reverse_layout = dict((key, c) for c, key in layout.iteritems())
+		self.previous_keys = []
+		self.text = ""
+		self.errors = []
+
+	def reportReceived(self, report):
+		modifier, keys = report
+		# A key is typed when it appears in a report: more than one new key in a report gives an undefined typing order
+		new_keys = [keycode for keycode in keys if keycode not in self.previous_keys]
+		if len(new_keys) > 1:
+			self.errors.append("several keys pressed in the same report: " + str(report))
+		if len(keys) > SIM_REPORT_NB_KEYS:
+			self.errors.append("report too long: " + str(report))
+		for keycode in new_keys:
+			if (modifier, keycode) in self.reverse_layout:
+				self.text += self.reverse_layout[(modifier, keycode)]
+			else:
+				self.errors.append("unknown key: " + str((modifier, keycode)))
+		self.previous_keys = list(keys)
+
+
+# Baseline endpoint model: one report per frame, or after the delay set between reports
+def sendReports(reports, host_keyboard, delay_between_reports_ms):
+	now = 0.0
+	for report in reports:
+		host_keyboard.reportReceived(report)
+		# Next report is armed right away or once the delay elapsed, and is fetched by the host at the next frame
+		armed_time = now + delay_between_reports_ms / 1000.0
+		now = max(now + SIM_USB_FRAME_TIME, SIM_USB_FRAME_TIME * int((armed_time + SIM_USB_FRAME_TIME - 1e-9) / SIM_USB_FRAME_TIME))
+	return now
+
+
+# Baseline BLE model of the former mini_ble_task() demo typing: each report queued in the BLE chip after its delay, the chip
+# sending up to SIM_BLE_NOTIFS_PER_EVENT of them at each connection event
+def sendBleDemoReports(reports, host_keyboard, conn_interval_ms, delays):
+	conn_interval = conn_interval_ms / 1000.0
+	next_event_time = conn_interval
+	aux_time = 0.0
+	chip_queue = []
+	report_index = 0
+	last_delivery_time = 0.0
+	while report_index < len(reports) or len(chip_queue) != 0:
+		if report_index < len(reports):
+			queue_time = aux_time + delays[report_index % len(delays)] + 2 * SIM_BLE_CMD_TIME
+			if queue_time <= next_event_time:
+				aux_time = queue_time
+				chip_queue.append(reports[report_index])
+				report_index += 1
+				continue
+		for report in chip_queue[0:SIM_BLE_NOTIFS_PER_EVENT]:
+			host_keyboard.reportReceived(report)
+			last_delivery_time = next_event_time
+		chip_queue = chip_queue[SIM_BLE_NOTIFS_PER_EVENT:]
+		next_event_time += conn_interval
+	return last_delivery_time
+
+
+# Have the firmware type keys: returns (typed status, received reports, time the last report was received at)
+# USB: the host stops fetching reports after abort_after reports, BLE: notification number abort_after fails
+def typeKeys(library, keys, interface_id, delay_between_reports_ms=0, conn_interval_ms=7.5, abort_after=0xFFFF):
+	key_array = (keyboard_key_t * len(keys))(*[keyboard_key_t(modifier, keycode) for modifier, keycode in keys])
+	library.host_keyboard_type(key_array, len(keys), interface_id, delay_between_reports_ms)
+	if interface_id == SIM_INTERFACE_USB:
+		typing_time_ns = library.host_keyboard_usb_run(abort_after)
+	else:
+		typing_time_ns = library.host_keyboard_ble_run(int(conn_interval_ms * 1000000), SIM_BLE_NOTIFS_PER_EVENT, abort_after)
+	nb_reports = ctypes.c_uint16.in_dll(library, "host_keyboard_nb_received").value
+	reports = (keyboard_report_t * nb_reports).in_dll(library, "host_keyboard_received")
+	return ctypes.c_uint16.in_dll(library, "host_keyboard_typed_status").value, [reportTuple(report) for report in reports], typing_time_ns / 1e9
+
+
+# Type a string: returns (typed text, host errors, number of reports, typing time)
+def typeString(library, layout, text, interface_id, delay_between_reports_ms=0, conn_interval_ms=7.5):
+	status, reports, typing_time = typeKeys(library, [layout[c] for c in text], interface_id, delay_between_reports_ms, conn_interval_ms)
+	host_keyboard = simulated_host_keyboard(layout)
+	for report in reports:
+		host_keyboard.reportReceived(report)
+	if status != SIM_STATUS_TYPED:
+		host_keyboard.errors.append("typed status " + str(status))
+	return host_keyboard.text, host_keyboard.errors, len(reports), typing_time
+
+
+# Build reports corner cases: reports that don't fit and keys that need a release first
+def runBuildReportsTests(library, layout):
+	nb_failures = 0
+	keys = [layout[c] for c in "aab"]
+	expected = [(0, [0x04]), (0, []), (0, [0x04]), (0, [0x04, 0x05]), (0, [])]
+	if buildReports(library, keys) != expected:
+		print "Unexpected reports for 'aab': " + str(buildReports(library, keys))
+		nb_failures += 1
+	if buildReports(library, keys, len(expected) - 1) is not None or buildReports(library, keys, len(expected)) != expected:
+		print "Reports not fitting the report buffer aren't refused"
+		nb_failures += 1
+	if buildReports(library, [layout["a"]] * SIM_TYPE_MAX_NB_KEYS) is None:
+		print "Reports for " + str(SIM_TYPE_MAX_NB_KEYS) + " repeated keys don't fit the report queue"
+		nb_failures += 1
+	return nb_failures
+
+
+# Host stops fetching reports (USB) or a notification fails (BLE): failed status, all keys released
+def runAbortTests(library, layout):
+	nb_failures = 0
+	keys = [layout[c] for c in "abcdefgh"]
+	for interface_id, name in [(SIM_INTERFACE_USB, "USB"), (SIM_INTERFACE_BLE, "BLE")]:
+		status, reports, typing_time = typeKeys(library, keys, interface_id, abort_after=3)
+		if interface_id == SIM_INTERFACE_USB:
+			armed_report = keyboard_report_t()
+			if library.host_keyboard_usb_get_armed_report(ctypes.byref(armed_report)) != 0:
+				reports.append(reportTuple(armed_report))
+		abort_time = ctypes.c_uint64.in_dll(library, "host_sim_ns").value / 1e6
+		print name + ": aborted after 3 reports, typing ended at " + ("%.1f" % abort_time) + "ms, last report " + str(reports[-1])
+		if status != SIM_STATUS_FAILED or reports[-1] != (SIM_MODIFIER_NONE, []):
+			print name + ": expected failed status and all keys released, got status " + str(status)
+			nb_failures += 1
+	return nb_failures
+
+
+# Check that the typed text matches for corner cases and random strings, then report typing speeds
+def runKeyboardSimulation(delay_between_reports_ms, nb_random_strings=1000):
+	library = loadKeyboardLibrary()
+	layout = getUsLayout()
+	chars = "".join(sorted(layout.keys()))
+	random_generator = random.Random(0)
+	test_strings = ["a", "aa", "aaaa", "aA", "Aa", "AAbbCC", "abcdefghijkl", "abcdefabcdef", "password", "P@ssw0rd!", "The quick brown fox jumps over the lazy dog.", chars[0:SIM_TYPE_MAX_NB_KEYS]]
+	test_strings += ["".join(random_generator.choice(chars) for j in range(0, 64)) for i in range(0, nb_random_strings)]
+
+	# Round trip
+	nb_failures = runBuildReportsTests(library, layout)
+	for text in test_strings:
+		typed_text, errors, nb_reports, typing_time = typeString(library, layout, text, SIM_INTERFACE_USB, delay_between_reports_ms)
+		if typed_text != text or len(errors) != 0:
+			nb_failures += 1
+			print "Mismatch: typed " + repr(typed_text) + " instead of " + repr(text) + " " + str(errors)
+	nb_failures += runAbortTests(library, layout)
+	print "Typed " + str(len(test_strings)) + " strings, " + str(nb_failures) + " failures"
+
+	# Typing speed on 64 chars strings
+	print "Delay between reports: " + str(delay_between_reports_ms) + "ms"
+	print "Engine".ljust(24), "reports/char".rjust(14), "ms/64 chars".rjust(14), "chars/s".rjust(10)
+	random_strings = test_strings[-nb_random_strings:]
+	for name, press_release in [("Press + release (model)", True), ("Merged reports", False)]:
+		total_reports = 0
+		total_time = 0
+		for text in random_strings:
+			if press_release:
+				reports = buildPressReleaseReports([layout[c] for c in text])
+				nb_reports, typing_time = len(reports), sendReports(reports, simulated_host_keyboard(layout), delay_between_reports_ms)
+			else:
+				typed_text, errors, nb_reports, typing_time = typeString(library, layout, text, SIM_INTERFACE_USB, delay_between_reports_ms)
+			total_reports += nb_reports
+			total_time += typing_time
+		total_chars = 64 * len(random_strings)
+		print name.ljust(24), ("%.2f" % (float(total_reports) / total_chars)).rjust(14), ("%.1f" % (total_time * 1000 / len(random_strings))).rjust(14), str(int(total_chars / total_time)).rjust(10)
+	return nb_failures == 0
+
+
+# Check that the typed text matches over BLE, then report typing speeds for the former delay paced demo and the queued engine
+def runBleKeyboardSimulation(conn_intervals_ms, nb_random_strings=1000):
+	library = loadKeyboardLibrary()
+	ctypes.c_uint64.in_dll(library, "host_keyboard_ble_cmd_ns").value = int(2 * SIM_BLE_CMD_TIME * 1e9)
+	layout = getUsLayout()
+	chars = "".join(sorted(layout.keys()))
+	random_generator = random.Random(0)
+	random_strings = ["".join(random_generator.choice(chars) for j in range(0, 64)) for i in range(0, nb_random_strings)]
+
+	# Round trip
+	nb_failures = 0
+	for conn_interval_ms in conn_intervals_ms:
+		for text in random_strings:
+			typed_text, errors, nb_reports, typing_time = typeString(library, layout, text, SIM_INTERFACE_BLE, 0, conn_interval_ms)
+			if typed_text != text or len(errors) != 0:
+				nb_failures += 1
+				print "Mismatch: typed " + repr(typed_text) + " instead of " + repr(text) + " " + str(errors)
+	print "Typed " + str(len(random_strings) * len(conn_intervals_ms)) + " strings, " + str(nb_failures) + " failures"
+
+	# Typing speed on 64 chars strings
+	print "Notifications per connection event: " + str(SIM_BLE_NOTIFS_PER_EVENT)
+	print "Interval".ljust(10), "Engine".ljust(28), "ms/64 chars".rjust(14), "chars/s".rjust(10)
+	for conn_interval_ms in conn_intervals_ms:
+		for name, queued in [("Delay paced demo (model)", False), ("Queued, " + str(SIM_BLE_MAX_IN_FLIGHT) + " in flight", True)]:
+			total_time = 0
+			for text in random_strings:
+				if queued:
+					typed_text, errors, nb_reports, typing_time = typeString(library, layout, text, SIM_INTERFACE_BLE, 0, conn_interval_ms)
+				else:
+					typing_time = sendBleDemoReports(buildPressReleaseReports([layout[c] for c in text]), simulated_host_keyboard(layout), conn_interval_ms, SIM_BLE_DEMO_DELAYS)
+				total_time += typing_time
+			total_chars = 64 * len(random_strings)
+			print (str(conn_interval_ms) + "ms").ljust(10), name.ljust(28), ("%.1f" % (total_time * 1000 / len(random_strings))).rjust(14), str(int(total_chars / total_time)).rjust(10)
+	return nb_failures == 0
@@ -0,0 +1,603 @@
+#!/usr/bin/env python2
+from host_firmware import *
+import ctypes
+
+# Smartcard on the host: the main MCU smartcard drivers (SMARTCARD/smartcard_lowlevel.c & smartcard_highlevel.c) run against a
+# simulated AT88SC102 wired to their pins. Port writes are trapped as they happen and time stamped on a virtual clock advanced by
+# the half pulse delays, the bit banging timer periods, the SPI bytes, the millisecond delays and the 1ms tick interrupts
+
+# Card memory map, see smartcard_lowlevel.h
+SIM_SMC_MEM_BIT_LENGTH		= getFirmwareDefine(MAIN_MCU_PROJECT, "SMARTCARD/smartcard_lowlevel.h", "SMARTCARD_MEM_BIT_LENGTH")
+SIM_SMC_SC_BIT_START		= 80
+SIM_SMC_SCAC_BIT_START		= 96
+SIM_SMC_CPZ_BIT_START		= 112
+SIM_SMC_AZ1_BIT_START		= 176
+SIM_SMC_EZ1_BIT_START		= 688
+SIM_SMC_AZ2_BIT_START		= 736
+SIM_SMC_EZ2_BIT_START		= 1248
+SIM_SMC_MTZ_BIT_START		= 1408
+SIM_SMC_MFZ_BIT_START		= 1424
+SIM_SMC_AES_KEY_LENGTH		= getFirmwareDefine(MAIN_MCU_PROJECT, "defines.h", "AES_KEY_LENGTH")
+SIM_SMC_CPZ_LENGTH			= getFirmwareDefine(MAIN_MCU_PROJECT, "SMARTCARD/smartcard_lowlevel.h", "SMARTCARD_CPZ_LENGTH")
+SIM_SMC_DEFAULT_PIN			= getFirmwareDefine(MAIN_MCU_PROJECT, "SMARTCARD/smartcard_lowlevel.h", "SMARTCARD_DEFAULT_PIN")
+SIM_SMC_LOGIN_LENGTH		= getFirmwareDefine(MAIN_MCU_PROJECT, "SMARTCARD/smartcard_lowlevel.h", "SMARTCARD_AZ_BIT_LENGTH") - getFirmwareDefine(MAIN_MCU_PROJECT, "SMARTCARD/smartcard_lowlevel.h", "SMARTCARD_AZ2_BIT_RESERVED")
+
+# SPI SCK = 48M / (2*(SMARTCARD_BAUD_DIVIDER+1))
+SIM_SMC_SPI_FREQUENCY		= 48000000 / (2 * (getFirmwareDefine(MAIN_MCU_PROJECT, "platform_defines.h", "SMARTCARD_BAUD_DIVIDER") + 1))
+# AT88SC102 datasheet: min clock half pulse (3.3us min pulse) & setup times, min tchp
+SIM_SMC_MIN_HPULSE_NS		= 1650
+SIM_SMC_MIN_TCHP_NS			= 3000000
+
+# mooltipass_card_detect_return_te, see defines.h
+SIM_SMC_RETURN_BLANK		= 3
+SIM_SMC_RETURN_USER			= 4
+SIM_SMC_RETURN_0_TRIES_LEFT	= 5
+SIM_SMC_RETURN_4_TRIES_LEFT	= 9
+
+# Pin levels bits, mirror HOST_SMC_xxx below
+SIM_SMC_SCK					= 0x01
+SIM_SMC_MOSI				= 0x02
+SIM_SMC_PGM					= 0x04
+SIM_SMC_RST					= 0x08
+SIM_SMC_PIN_NAMES			= [(SIM_SMC_SCK, "SCK"), (SIM_SMC_MOSI, "MOSI"), (SIM_SMC_PGM, "PGM"), (SIM_SMC_RST, "RST")]
+
+# Main MCU stand-ins. Port writes: the PORT page is made read only, a write faults, is single stepped, and the new pin levels are
+# queued with the time they were set at. The queue is given to the card when the firmware waits, which is when the card
+# output it may then read gets updated. Bit banging timer: the interrupt is run when the firmware enables interrupts in its
+# sleep loop, a period after the last edge. 1ms tick interrupt: served when the clock goes past a tick, it stretches the busy
+# loops and delays the end of a timer wait it overlaps. CPU busy time is counted for the delays, SPI transfers & interrupts
+HOST_SMARTCARD_STANDINS = r"""
+#include <signal.h>
+#include <sys/ucontext.h>
+#include "smartcard_highlevel.h"
+#include "smartcard_lowlevel.h"
+#include "logic_security.h"
+#include "driver_sercom.h"
+#include "platform_io.h"
+#include "main.h"
+#if !defined(__x86_64__)
+#error "Port writes are single stepped using the x86-64 trap flag"
+#endif
+
+#define HOST_SMC_SCK                0x01
+#define HOST_SMC_MOSI               0x02
+#define HOST_SMC_PGM                0x04
+#define HOST_SMC_RST                0x08
+#define HOST_SMC_PORT_PAGE          ((void*)((uintptr_t)PORT & ~0xFFFUL))
+#define HOST_SMC_MAX_NB_EVENTS      16
+/* DELAYUS(2) */
+#define HOST_SMC_HPULSE_NS          2000ULL
+/* 8 SPI clocks at 48M / (2*(SMARTCARD_BAUD_DIVIDER+1)) */
+#define HOST_SMC_SPI_BYTE_NS        (16ULL * (SMARTCARD_BAUD_DIVIDER + 1) * 1000000000ULL / CPU_SPEED_HF)
+/* Bit banging timer clocked at 48M / 16 */
+#define HOST_SMC_TIMER_TICK_PS      333333ULL
+/* Interrupt entry & edge drive (32 cycles), whole interrupt (64 cycles) */
+#define HOST_SMC_IRQ_EDGE_NS        667ULL
+#define HOST_SMC_IRQ_NS             1333ULL
+/* 1ms tick interrupt: ms tick, card detect & buttons scan (200 cycles) */
+#define HOST_SMC_TICK_NS            1000000ULL
+#define HOST_SMC_TICK_IRQ_NS        4167ULL
+
+#ifdef SMARTCARD_TIMER_BITBANG
+extern volatile BOOL smartcard_lowlevel_timer_running;
+#endif
+extern uint8_t smartcard_highlevel_shadow[SMARTCARD_MEM_BIT_LENGTH/8];
+extern volatile BOOL smartcard_highlevel_shadow_valid;
+volatile bool g_interrupt_enabled = true;
+BOOL special_dev_card_inserted = FALSE;
+uint64_t host_sim_ns = 0;
+uint64_t host_smc_busy_ns = 0;
+uint32_t host_smc_nb_ticks = 0;
+BOOL host_smc_shadow_enabled = TRUE;
+/* Card side: gets the pin levels when they change and returns its output, gets SPI bytes */
+uint32_t (*host_smc_pins_callback)(uint64_t time_ns, uint32_t levels) = 0;
+uint8_t (*host_smc_spi_callback)(void) = 0;
+static const uint8_t host_smc_pin_groups[] = {SMC_SCK_GROUP, SMC_MOSI_GROUP, SMC_PGM_GROUP, SMC_RST_GROUP};
+static const uint32_t host_smc_pin_masks[] = {SMC_SCK_MASK, SMC_MOSI_MASK, SMC_PGM_MASK, SMC_RST_MASK};
+static uint32_t host_smc_levels = HOST_SMC_RST;
+static uint64_t host_smc_event_ns[HOST_SMC_MAX_NB_EVENTS];
+static uint32_t host_smc_event_levels[HOST_SMC_MAX_NB_EVENTS];
+static uint16_t host_smc_nb_events = 0;
+static uint64_t host_smc_next_tick_ns = HOST_SMC_TICK_NS;
+
+/* Faulting write to the PORT page: let it through for one instruction */
+static void host_smc_port_write_fault(int signal_number, siginfo_t* info, void* context)
+{
+    if (((uintptr_t)info->si_addr & ~0xFFFUL) != (uintptr_t)HOST_SMC_PORT_PAGE)
+    {
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ | PROT_WRITE);
+    ((ucontext_t*)context)->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+/* Write done: apply the set & clear registers to the pin levels */
+static void host_smc_port_write_done(int signal_number, siginfo_t* info, void* context)
+{
+    uint32_t levels = host_smc_levels;
+
+    ((ucontext_t*)context)->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+    for (uint16_t i = 0; i < sizeof(host_smc_pin_masks)/sizeof(host_smc_pin_masks[0]); i++)
+    {
+        if ((PORT->Group[host_smc_pin_groups[i]].OUTSET.reg & host_smc_pin_masks[i]) != 0)
+        {
+            levels |= (1UL << i);
+        }
+        if ((PORT->Group[host_smc_pin_groups[i]].OUTCLR.reg & host_smc_pin_masks[i]) != 0)
+        {
+            levels &= ~(1UL << i);
+        }
+    }
+    for (uint16_t i = 0; i < PORT_GROUPS; i++)
+    {
+        PORT->Group[i].OUTSET.reg = 0;
+        PORT->Group[i].OUTCLR.reg = 0;
+    }
+    if (levels != host_smc_levels)
+    {
+        if (host_smc_nb_events == HOST_SMC_MAX_NB_EVENTS)
+        {
+            __builtin_trap();
+        }
+        host_smc_event_ns[host_smc_nb_events] = host_sim_ns;
+        host_smc_event_levels[host_smc_nb_events++] = levels;
+        host_smc_levels = levels;
+    }
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ);
+}
+
+/* Give the queued pin levels to the card, update its output */
+static void host_smc_sync(void)
+{
+    uint32_t miso = 0;
+
+    if (host_smc_nb_events == 0)
+    {
+        return;
+    }
+    for (uint16_t i = 0; i < host_smc_nb_events; i++)
+    {
+        miso = host_smc_pins_callback(host_smc_event_ns[i], host_smc_event_levels[i]);
+    }
+    host_smc_nb_events = 0;
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ | PROT_WRITE);
+    if (miso != 0)
+    {
+        *(volatile uint32_t*)&PORT->Group[SMC_MISO_GROUP].IN.reg |= SMC_MISO_MASK;
+    }
+    else
+    {
+        *(volatile uint32_t*)&PORT->Group[SMC_MISO_GROUP].IN.reg &= ~SMC_MISO_MASK;
+    }
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ);
+}
+
+/* Move the clock on, serving the tick interrupts on the way: they stretch a busy loop, and delay the end of a timer wait when still running */
+static void host_smc_advance_ns(uint64_t nb_ns, BOOL busy_loop)
+{
+    uint64_t end_ns = host_sim_ns + nb_ns;
+
+    while (host_smc_next_tick_ns <= end_ns)
+    {
+        host_sim_ns = host_smc_next_tick_ns;
+        smartcard_lowlevel_detect();
+        host_smc_busy_ns += HOST_SMC_TICK_IRQ_NS;
+        host_smc_next_tick_ns += HOST_SMC_TICK_NS;
+        host_smc_nb_ticks++;
+        if (busy_loop != FALSE)
+        {
+            end_ns += HOST_SMC_TICK_IRQ_NS;
+        }
+        else if (end_ns < host_sim_ns + HOST_SMC_TICK_IRQ_NS)
+        {
+            end_ns = host_sim_ns + HOST_SMC_TICK_IRQ_NS;
+        }
+    }
+    host_sim_ns = end_ns;
+}
+
+/* Bit banging timer interrupt, run when the firmware enables interrupts */
+static void host_smc_irq_enabled(void)
+{
+    host_smc_sync();
+    #ifdef SMARTCARD_TIMER_BITBANG
+    if (smartcard_lowlevel_timer_running != FALSE)
+    {
+        host_smc_advance_ns(((uint64_t)SMARTCARD_BB_TC->COUNT16.CC[0].reg + 1) * HOST_SMC_TIMER_TICK_PS / 1000ULL + HOST_SMC_IRQ_EDGE_NS, FALSE);
+        host_smc_busy_ns += HOST_SMC_IRQ_NS;
+        smartcard_lowlevel_timer_callback();
+    }
+    #endif
+}
+
+void smartcard_lowlevel_hpulse_delay(void)
+{
+    host_smc_sync();
+    host_smc_advance_ns(HOST_SMC_HPULSE_NS, TRUE);
+    host_smc_busy_ns += HOST_SMC_HPULSE_NS;
+}
+
+/* Timer based: over once the ms+1th tick interrupt decremented the wait timer, the CPU polling it all along */
+void timer_delay_ms(uint32_t ms)
+{
+    uint64_t start_ns = host_sim_ns;
+    uint64_t start_busy_ns = host_smc_busy_ns;
+
+    host_smc_sync();
+    host_smc_advance_ns(host_smc_next_tick_ns + (uint64_t)ms * HOST_SMC_TICK_NS - host_sim_ns, FALSE);
+    host_smc_busy_ns = start_busy_ns + (host_sim_ns - start_ns);
+}
+
+uint8_t sercom_spi_send_single_byte(Sercom* sercom_pt, uint8_t data)
+{
+    host_smc_sync();
+    host_smc_advance_ns(HOST_SMC_SPI_BYTE_NS, TRUE);
+    host_smc_busy_ns += HOST_SMC_SPI_BYTE_NS;
+    return host_smc_spi_callback();
+}
+
+/* Shadow left invalid when disabled, for the reads to go to the card and the writes to erase & program every word */
+void smartcard_highlevel_fill_shadow(void)
+{
+    if (host_smc_shadow_enabled != FALSE)
+    {
+        smartcard_lowlevel_read_smc(SMARTCARD_MEM_BIT_LENGTH/8, 0, smartcard_highlevel_shadow);
+        smartcard_highlevel_shadow_valid = TRUE;
+    }
+}
+
+void platform_io_smc_inserted_function(void) {}
+void platform_io_smc_remove_function(void) {}
+void platform_io_smc_switch_to_bb(void) {}
+void platform_io_smc_switch_to_spi(void) {}
+void logic_security_clear_security_bools(void) {}
+void cpu_irq_enter_critical(void) {}
+void cpu_irq_leave_critical(void) {}
+
+/* New card in the slot: standby pin levels, card detected, clock & counters reset. The port write handlers are
+   installed again, as the peripherals are shared with the other smartcard libraries loaded in the process */
+void host_smc_insert_card(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = host_smc_port_write_fault;
+    sigaction(SIGSEGV, &action, 0);
+    action.sa_sigaction = host_smc_port_write_done;
+    sigaction(SIGTRAP, &action, 0);
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ | PROT_WRITE);
+    memset((void*)PORT, 0, sizeof(Port));
+    mprotect(HOST_SMC_PORT_PAGE, 0x1000, PROT_READ);
+    host_smc_levels = HOST_SMC_RST;
+    host_smc_nb_events = 0;
+    host_sim_ns = 0;
+    host_smc_busy_ns = 0;
+    host_smc_next_tick_ns = HOST_SMC_TICK_NS;
+    host_smc_nb_ticks = 0;
+    host_irq_enabled_hook = host_smc_irq_enabled;
+    smartcard_highlevel_invalidate_shadow();
+}
+"""
+
+
+# Simulated AT88SC102 at pin level: memory & security state, address counter, program cycles, datasheet timing checks, counters
+class simulated_at88sc102:
+
+	def __init__(self, security_code, cpz=None, aes_key=None):
+		# Mooltipass card: issuer fuse blown (security mode 2), AZ1 & AZ2 only readable when authenticated. Blank cards have an erased CPZ & AES key
+		self.memory = [1] * SIM_SMC_MEM_BIT_LENGTH
+		self.setBytes(0, [0x0F, 0x0F])
+		self.setBytes(16, map(ord, "limpkin\x00"))
+		self.setBytes(SIM_SMC_SC_BIT_START, [security_code >> 8, security_code & 0xFF])
+		if cpz is not None:
+			self.setBytes(SIM_SMC_CPZ_BIT_START, cpz)
+		self.setBytes(SIM_SMC_AZ1_BIT_START, [0x80, 0x00])
+		if aes_key is not None:
+			self.setBytes(SIM_SMC_AZ1_BIT_START + 16, aes_key)
+		self.setBytes(SIM_SMC_AZ2_BIT_START, [0x80, 0x00])
+		self.setBytes(SIM_SMC_MTZ_BIT_START, [0x00, 0x00])
+		self.setBytes(SIM_SMC_MFZ_BIT_START, [0x07, 0xE1])
+		self.authenticated = False
+		self.security_code_matches = [False] * 16
+		self.levels = SIM_SMC_RST
+		self.last_edge_ns = dict((pin, None) for pin, name in SIM_SMC_PIN_NAMES)
+		self.address = 0
+		self.program_cycle = False
+		self.program_write = False
+		self.violations = []
+		self.resetCounters()
+
+	def resetCounters(self):
+		self.bitbang_clocks = 0
+		self.program_pulses = 0
+		self.bytes_read = 0
+		self.nb_edges = 0
+
+	def setBytes(self, start_bit, data):
+		for i, byte in enumerate(data):
+			for j in range(0, 8):
+				self.memory[start_bit + i*8 + j] = (byte >> (7-j)) & 0x01
+
+	def getBytes(self, start_bit, nb_bytes):
+		return [int("".join(map(str, self.memory[start_bit + i*8:start_bit + i*8 + 8])), 2) for i in range(0, nb_bytes)]
+
+	# Bit as output by the card: the security code and the application zones read as 0s when not authenticated
+	def outputBit(self, address):
+		if not self.authenticated and (SIM_SMC_SC_BIT_START <= address < SIM_SMC_SCAC_BIT_START or SIM_SMC_AZ1_BIT_START <= address < SIM_SMC_EZ1_BIT_START or SIM_SMC_AZ2_BIT_START <= address < SIM_SMC_EZ2_BIT_START):
+			return 0
+		return self.memory[address]
+
+	# Bits the main MCU can change: the test zone, attempts counter bits written to 0, the attempts counter erased after the presented
+	# security code matched, the rest when authenticated except the manufacturer zone (security mode 2)
+	def isWritable(self, address, is_write):
+		if SIM_SMC_MTZ_BIT_START <= address < SIM_SMC_MFZ_BIT_START:
+			return True
+		if SIM_SMC_MFZ_BIT_START <= address < SIM_SMC_MFZ_BIT_START + 16:
+			return False
+		if SIM_SMC_SCAC_BIT_START <= address < SIM_SMC_SCAC_BIT_START + 16:
+			return is_write or all(self.security_code_matches)
+		return self.authenticated
+
+	# End of a program cycle: write a 0 or erase the 16 bits word. A successful attempts counter erase authenticates
+	def program(self):
+		self.program_pulses += 1
+		if not self.isWritable(self.address, self.program_write):
+			return
+		if self.program_write:
+			self.memory[self.address] = 0
+		else:
+			word_start = self.address & ~0x0F
+			self.memory[word_start:word_start+16] = [1] * 16
+			if word_start == SIM_SMC_SCAC_BIT_START:
+				self.authenticated = True
+
+	def violation(self, time_ns, text):
+		self.violations.append("%.3fus: %s" % (time_ns / 1000.0, text))
+
+	# Time since the last edge of a pin
+	def sinceEdge(self, time_ns, pin):
+		if self.last_edge_ns[pin] is None:
+			return float("inf")
+		return time_ns - self.last_edge_ns[pin]
+
+	# Clock edges: clock high & low times, program signal & data setup times, tchp before the end of a program cycle
+	def clockEdge(self, time_ns, levels):
+		if self.sinceEdge(time_ns, SIM_SMC_SCK) < SIM_SMC_MIN_HPULSE_NS:
+			self.violation(time_ns, "SCK %s for %.3fus" % ("low" if levels & SIM_SMC_SCK else "high", self.sinceEdge(time_ns, SIM_SMC_SCK) / 1000.0))
+		if levels & SIM_SMC_SCK:
+			self.program_cycle = (levels & SIM_SMC_PGM) != 0
+			self.program_write = (levels & SIM_SMC_MOSI) != 0
+			for pin, name in SIM_SMC_PIN_NAMES[1:3] if self.program_cycle else []:
+				if self.sinceEdge(time_ns, pin) < SIM_SMC_MIN_HPULSE_NS:
+					self.violation(time_ns, "%s setup %.3fus" % (name, self.sinceEdge(time_ns, pin) / 1000.0))
+			if not self.program_cycle and (levels & SIM_SMC_RST) == 0:
+				self.bitbang_clocks += 1
+				# Security code presented inverted by smartcard_lowlevel_validate_code(), compared as it is clocked in
+				if SIM_SMC_SC_BIT_START <= self.address < SIM_SMC_SCAC_BIT_START:
+					self.security_code_matches[self.address - SIM_SMC_SC_BIT_START] = self.program_write != self.memory[self.address]
+		elif self.program_cycle:
+			if levels & SIM_SMC_PGM or self.sinceEdge(time_ns, SIM_SMC_PGM) < SIM_SMC_MIN_TCHP_NS:
+				self.violation(time_ns, "tchp too short")
+			else:
+				self.program()
+			self.program_cycle = False
+		elif (levels & SIM_SMC_RST) == 0:
+			self.address += 1
+
+	# Pin levels changed: returns the card output
+	def pinsChanged(self, time_ns, levels):
+		changed = self.levels ^ levels
+		self.nb_edges += 1
+		if changed & SIM_SMC_SCK:
+			self.clockEdge(time_ns, levels)
+		if changed & levels & SIM_SMC_RST:
+			self.address = 0
+			self.security_code_matches = [False] * 16
+		for pin, name in SIM_SMC_PIN_NAMES:
+			if changed & pin:
+				self.last_edge_ns[pin] = time_ns
+		self.levels = levels
+		return self.outputBit(self.address)
+
+	# Byte clocked out by the SPI peripheral
+	def spiByte(self):
+		byte = 0
+		for i in range(0, 8):
+			byte = (byte << 1) | self.outputBit(self.address)
+			self.address += 1
+		self.bytes_read += 1
+		return byte
+
+
+# Main MCU smartcard drivers built for the host, callbacks to the card inserted. Busy loop back end unless timer_bitbang is set
+class host_smartcard_library:
+
+	PINS_CALLBACK = ctypes.CFUNCTYPE(ctypes.c_uint32, ctypes.c_uint64, ctypes.c_uint32)
+	SPI_CALLBACK = ctypes.CFUNCTYPE(ctypes.c_uint8)
+
+	def __init__(self, timer_bitbang=False):
+		defines = ["_GNU_SOURCE"] + (["SMARTCARD_TIMER_BITBANG"] if timer_bitbang else [])
+		self.library = loadHostFirmware(MAIN_MCU_PROJECT, ["SMARTCARD/smartcard_lowlevel.c", "SMARTCARD/smartcard_highlevel.c"], HOST_SMARTCARD_STANDINS, defines, replaced_functions=["smartcard_lowlevel_hpulse_delay", "smartcard_highlevel_fill_shadow"])
+		self.card = None
+		self.pins_callback = self.PINS_CALLBACK(lambda time_ns, levels: self.card.pinsChanged(time_ns, levels))
+		self.spi_callback = self.SPI_CALLBACK(lambda: self.card.spiByte())
+		ctypes.c_void_p.in_dll(self.library, "host_smc_pins_callback").value = ctypes.cast(self.pins_callback, ctypes.c_void_p).value
+		ctypes.c_void_p.in_dll(self.library, "host_smc_spi_callback").value = ctypes.cast(self.spi_callback, ctypes.c_void_p).value
+
+	def insertCard(self, card, shadow_enabled=True):
+		self.card = card
+		ctypes.c_int32.in_dll(self.library, "host_smc_shadow_enabled").value = 1 if shadow_enabled else 0
+		self.library.host_smc_insert_card()
+
+	# Time & CPU busy time since the card was inserted, in ms
+	def getTimes(self):
+		return ctypes.c_uint64.in_dll(self.library, "host_sim_ns").value / 1e6, ctypes.c_uint64.in_dll(self.library, "host_smc_busy_ns").value / 1e6
+
+	# Number of 1ms tick interrupts served since the card was inserted
+	def getNbTicks(self):
+		return ctypes.c_uint32.in_dll(self.library, "host_smc_nb_ticks").value
+
+	def readBuffer(self, function, length):
+		buffer = (ctypes.c_uint8 * length)()
+		function(buffer)
+		return list(buffer)
+
+	def validPin(self, pin):
+		return self.library.smartcard_high_level_mooltipass_card_detected_routine(ctypes.byref(ctypes.c_uint16(pin)))
+
+	# Insert a Mooltipass card and unlock it as logic_smartcard_handle_inserted() would: blank cards are unlocked by the detection routine
+	def insertAndUnlock(self, card, pin, shadow_enabled=True):
+		self.insertCard(card, shadow_enabled)
+		detection_result = self.library.smartcard_highlevel_card_detected_routine()
+		if detection_result == SIM_SMC_RETURN_BLANK:
+			return True
+		return detection_result == SIM_SMC_RETURN_USER and self.validPin(pin) == SIM_SMC_RETURN_4_TRIES_LEFT
+
+
+# Unlock flow of a known user card, as logic_smartcard_handle_inserted() & logic_smartcard_valid_card_unlock() run it: returns
+# the detection & unlock results, and the AES key read
+def runUnlockFlow(smartcard, pin):
+	detection_result = smartcard.library.smartcard_highlevel_card_detected_routine()
+	smartcard.readBuffer(smartcard.library.smartcard_highlevel_read_code_protected_zone, SIM_SMC_CPZ_LENGTH)
+	smartcard.library.smartcard_highlevel_get_nb_sec_tries_left()
+	unlock_result = smartcard.validPin(pin)
+	return detection_result, unlock_result, smartcard.readBuffer(smartcard.library.smartcard_highlevel_read_aes_key, SIM_SMC_AES_KEY_LENGTH/8)
+
+
+# Run the unlock flow with and without shadow, check they read the card AES key and report the card time
+def runSmartcardUnlockTest(smartcard):
+	pin = 0x1234
+	cpz = [0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88]
+	aes_key = range(0, SIM_SMC_AES_KEY_LENGTH/8)
+	all_ok = True
+
+	print "Unlock flow".ljust(16), "BB clocks".rjust(12), "prog pulses".rjust(12), "bytes read".rjust(12), "read ms".rjust(10), "card ms".rjust(10)
+	for name, shadow_enabled in [("Direct reads", False), ("Shadowed reads", True)]:
+		card = simulated_at88sc102(pin, cpz, aes_key)
+		smartcard.insertCard(card, shadow_enabled)
+		result = runUnlockFlow(smartcard, pin)
+		card_time, busy_time = smartcard.getTimes()
+		read_time = card.bytes_read * 8 * 1000.0 / SIM_SMC_SPI_FREQUENCY
+		print name.ljust(16), str(card.bitbang_clocks).rjust(12), str(card.program_pulses).rjust(12), str(card.bytes_read).rjust(12), ("%.1f" % read_time).rjust(10), ("%.1f" % card_time).rjust(10)
+		if result != (SIM_SMC_RETURN_USER, SIM_SMC_RETURN_4_TRIES_LEFT, aes_key) or len(card.violations) != 0:
+			print name + ": unexpected detection / unlock results or AES key: " + str(result) + " " + str(card.violations[0:1])
+			all_ok = False
+
+	# Wrong PIN: one try less, then unlocked with the right one and the tries counter restored
+	card = simulated_at88sc102(pin, cpz, aes_key)
+	smartcard.insertCard(card)
+	results = [smartcard.library.smartcard_highlevel_card_detected_routine(), smartcard.validPin(pin ^ 0x0101), smartcard.validPin(pin)]
+	if results != [SIM_SMC_RETURN_USER, SIM_SMC_RETURN_0_TRIES_LEFT + 3, SIM_SMC_RETURN_4_TRIES_LEFT] or card.getBytes(SIM_SMC_SCAC_BIT_START, 1) != [0xFF]:
+		print "Wrong PIN: unexpected results " + str(results)
+		all_ok = False
+	if all_ok:
+		print "Both flows read the card AES key, a wrong PIN costs one try"
+	print ""
+	return all_ok
+
+
+# Card part of logic_user_create_new_user() on a blank Mooltipass card: CPZ, AES key & new PIN writes
+def runUserCreationFlow(smartcard, cpz, aes_key, new_pin):
+	smartcard.library.smartcard_highlevel_write_protected_zone((ctypes.c_uint8 * len(cpz))(*cpz))
+	if smartcard.library.smartcard_highlevel_write_aes_key((ctypes.c_uint8 * len(aes_key))(*aes_key)) != 0:
+		return False
+	smartcard.library.smartcard_highlevel_write_security_code(ctypes.byref(ctypes.c_uint16(new_pin)))
+	return smartcard.readBuffer(smartcard.library.smartcard_highlevel_read_code_protected_zone, SIM_SMC_CPZ_LENGTH) == cpz
+
+
+# Run the card write flows with and without shadow (full writes), check the card contents and report the card time
+def runSmartcardWriteTest(smartcard):
+	new_pin = 0x1234
+	cpz = [0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88]
+	old_aes_key = [(i * 37 + 11) & 0xFF for i in range(0, SIM_SMC_AES_KEY_LENGTH/8)]
+	aes_key = [(i * 91 + 5) & 0xFF for i in range(0, SIM_SMC_AES_KEY_LENGTH/8)]
+	write_aes_key = lambda: smartcard.library.smartcard_highlevel_write_aes_key((ctypes.c_uint8 * len(aes_key))(*aes_key)) == 0
+	all_ok = True
+
+	# Flows: name, card setup, unlock PIN, function run once unlocked
+	flows = [("User creation", lambda: simulated_at88sc102(SIM_SMC_DEFAULT_PIN), SIM_SMC_DEFAULT_PIN, lambda: runUserCreationFlow(smartcard, cpz, aes_key, new_pin)),
+			 ("AES key, blank", lambda: simulated_at88sc102(new_pin, cpz), new_pin, write_aes_key),
+			 ("AES key, new", lambda: simulated_at88sc102(new_pin, cpz, old_aes_key), new_pin, write_aes_key),
+			 ("AES key, same", lambda: simulated_at88sc102(new_pin, cpz, aes_key), new_pin, write_aes_key)]
+
+	print "Write flow".ljust(16), "Writes".ljust(14), "BB clocks".rjust(12), "prog pulses".rjust(12), "bytes read".rjust(12), "card ms".rjust(10)
+	for flow_name, new_card, pin, flow_function in flows:
+		for name, shadow_enabled in [("full", False), ("differential", True)]:
+			card = new_card()
+			unlocked = smartcard.insertAndUnlock(card, pin, shadow_enabled)
+			# Only count the flow itself
+			card.resetCounters()
+			start_time = smartcard.getTimes()[0]
+			flow_ok = unlocked and flow_function()
+			card_time = smartcard.getTimes()[0] - start_time
+			contents_ok = card.getBytes(SIM_SMC_CPZ_BIT_START, SIM_SMC_CPZ_LENGTH) == cpz and card.getBytes(SIM_SMC_AZ1_BIT_START + 16, len(aes_key)) == aes_key and card.getBytes(SIM_SMC_SC_BIT_START, 2) == [new_pin >> 8, new_pin & 0xFF]
+			if not flow_ok or not contents_ok or len(card.violations) != 0:
+				all_ok = False
+				print flow_name + ": failed with " + name + " writes " + str(card.violations[0:1])
+			print flow_name.ljust(16), name.ljust(14), str(card.bitbang_clocks).rjust(12), str(card.program_pulses).rjust(12), str(card.bytes_read).rjust(12), ("%.1f" % card_time).rjust(10)
+	if all_ok:
+		print "Card contents match with full & differential writes"
+	print ""
+	return all_ok
+
+
+# The timing checks catch a clock half pulse and a tchp that are too short
+def runTimingChecksTest():
+	card = simulated_at88sc102(0x1234)
+	for time_ns, levels in [(0, 0), (10000, SIM_SMC_SCK), (11000, 0), (20000, SIM_SMC_PGM), (30000, SIM_SMC_PGM | SIM_SMC_SCK), (40000, SIM_SMC_SCK), (1040000, 0)]:
+		card.pinsChanged(time_ns, levels)
+	return len(card.violations) == 2 and "SCK" in card.violations[0] and "tchp" in card.violations[1]
+
+
+# Run card operations with a smartcard back end: check the card timings & contents, report the time, CPU time & tick interrupts taken
+def runSmartcardTimingTest(smartcard, back_end_name):
+	pin = 0x1234
+	cpz = [0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88]
+	aes_key = [(i * 91 + 5) & 0xFF for i in range(0, SIM_SMC_AES_KEY_LENGTH/8)]
+	login = map(ord, "limpkin@example.com".ljust(SIM_SMC_LOGIN_LENGTH/8, "\x00"))
+	operations = [("PIN check", lambda: smartcard.validPin(pin) == SIM_SMC_RETURN_4_TRIES_LEFT, lambda card: card.authenticated),
+				  ("Card read", lambda: len(smartcard.readBuffer(lambda buffer: smartcard.library.smartcard_lowlevel_read_smc(SIM_SMC_MEM_BIT_LENGTH/8, 0, buffer), SIM_SMC_MEM_BIT_LENGTH/8)) != 0, lambda card: card.bytes_read == SIM_SMC_MEM_BIT_LENGTH/8),
+				  ("AES key write", lambda: smartcard.library.smartcard_highlevel_write_aes_key((ctypes.c_uint8 * len(aes_key))(*aes_key)) == 0, lambda card: card.getBytes(SIM_SMC_AZ1_BIT_START + 16, len(aes_key)) == aes_key),
+				  ("Login write", lambda: smartcard.library.smartcard_highlevel_write_card_login((ctypes.c_uint8 * len(login))(*login)) == 0, lambda card: card.getBytes(SIM_SMC_AZ2_BIT_START + 16, len(login)) == login)]
+	all_ok = True
+
+	print (back_end_name + " back end").ljust(24), "edges".rjust(8), "violations".rjust(11), "card ok".rjust(8), "op ms".rjust(9), "CPU ms".rjust(9), "ticks".rjust(7)
+	for operation_name, operation, check_card in operations:
+		card = simulated_at88sc102(pin, cpz)
+		# Full writes, for every bit to be programmed
+		unlocked = smartcard.insertAndUnlock(card, pin, False)
+		card.resetCounters()
+		start_time, start_busy_time = smartcard.getTimes()
+		start_nb_ticks = smartcard.getNbTicks()
+		card_ok = unlocked and operation() and check_card(card)
+		op_time, busy_time = smartcard.getTimes()
+		print operation_name.ljust(24), str(card.nb_edges).rjust(8), str(len(card.violations)).rjust(11), str(card_ok).rjust(8), ("%.2f" % (op_time - start_time)).rjust(9), ("%.2f" % (busy_time - start_busy_time)).rjust(9), str(smartcard.getNbTicks() - start_nb_ticks).rjust(7)
+		if len(card.violations) != 0:
+			print card.violations[0]
+		all_ok = all_ok and card_ok and len(card.violations) == 0
+
+	if all_ok:
+		print back_end_name + " back end meets the card timings"
+	else:
+		print back_end_name + " back end timing test failed"
+	print ""
+	return all_ok
+
+
+# Run the smartcard flows
+def runSmartcardHostTest():
+	smartcard = host_smartcard_library()
+	all_ok = runSmartcardUnlockTest(smartcard)
+	return runSmartcardWriteTest(smartcard) and all_ok
+
+
+# Run the smartcard timing checks on the busy loop back end and on the SMARTCARD_TIMER_BITBANG one
+def runSmartcardTimingHostTest():
+	all_ok = runTimingChecksTest()
+	if not all_ok:
+		print "Timing checks don't catch a short half pulse or tchp"
+	for back_end_name, timer_bitbang in [("Busy loop", False), ("Timer", True)]:
+		all_ok = runSmartcardTimingTest(host_smartcard_library(timer_bitbang), back_end_name) and all_ok
+	return all_ok
@@ -29,6 +29,7 @@ UID_REQUEST_KEY_SIZE		= 16
 UID_KEY_SIZE				= 6
 AES_KEY_SIZE				= 32
 AES_BLOCK_SIZE				= 16
+HID_MSG_MAX_PAYLOAD_SIZE	= 532
 
 # Ack / Nack defines
 CMD_HID_ACK					= 0x01
@@ -36,6 +37,28 @@ CMD_HID_NACK				= 0x00
 
 # New Command IDs
 CMD_PING                	= 0x0001
+CMD_RETRY					= 0x0002
+CMD_STREAM_START			= 0x0006
+CMD_STREAM_DATA				= 0x0007
+
+# Stream types
+STREAM_TYPE_DISPLAY			= 0x0001
+STREAM_TYPE_DATAFLASH		= 0x0002
+STREAM_TYPE_CRED_BATCH		= 0x0003
+
+# Credential batches
+CRED_BATCH_MAX_LENGTH		= 2048
+CRED_BATCH_MAX_NB_CREDS		= 32
+
+# Stream data acknowledgement status
+STREAM_STATUS_ABORTED		= 0x0000
+STREAM_STATUS_ACK			= 0x0001
+STREAM_STATUS_GO_BACK		= 0x0002
+
+# User prompt answers, mini_input_yes_no_ret_te in the main MCU defines.h, set on the simulated device
+MINI_INPUT_RET_TIMEOUT		= -1
+MINI_INPUT_RET_NO			= 1
+MINI_INPUT_RET_YES			= 2
 
 # New Debug Command IDs
 CMD_DBG_MESSAGE					= 0x8000
@@ -50,6 +73,9 @@ CMD_DBG_GET_ACC_32_SAMPLES		= 0x8008
 CMD_DBG_FLASH_AUX_MCU			= 0x8009
 CMD_DBG_GET_PLAT_INFO			= 0x800A
 CMD_DBG_REINDEX_BUNDLE			= 0x800B
+CMD_DBG_GET_RENDER_STATS		= 0x800C
+CMD_DBG_GET_CMD_STATS			= 0x800D
+CMD_DBG_TRACE					= 0x800E
 
 # OLD Command IDs
 CMD_EXPORT_FLASH_START  = 0x8A
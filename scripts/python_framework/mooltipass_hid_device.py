@@ -3,6 +3,8 @@ from os.path import isfile, join, isdir
 from resizeimage import resizeimage
 from mooltipass_defines import *
 from generic_hid_device import *
+from host_comms import *
+from trace_decoder import *
 from pprint import pprint
 from array import array
 from PIL import Image
@@ -24,6 +26,12 @@ class mooltipass_hid_device:
 	def connect(self, verbose):
 		return self.device.connect(verbose, USB_VID, USB_PID, USB_READ_TIMEOUT, self.createPingPacket());
 		
+	# Connect to the host built device firmwares, see host_comms.py for the device parameters
+	def connectSimulated(self, **device_parameters):
+		if isinstance(getattr(self.device, "hid_device", None), host_device):
+			self.device.hid_device.close()
+		return self.device.connectSimulated(host_device(**device_parameters), USB_READ_TIMEOUT)
+		
 	# Disconnect
 	def disconnect(self):
 		self.device.disconnect()
@@ -235,6 +243,142 @@ class mooltipass_hid_device:
 		print "Sending done!"
 		
 	
+	# Stream data to a consumer on the device, keeping up to "window" chunks unacknowledged
+	def streamData(self, stream_type, data, verbose=True):
+		# No ack flag: echoed packets would get mixed with the stream acknowledgements
+		ack_flag_in_comms = self.device.ack_flag_in_comms
+		self.device.ack_flag_in_comms = False
+		
+		# Consumer result in the last acknowledgement
+		self.stream_result = 0
+		
+		# Start stream, device answers with the window and max chunk length
+		start_time = self.device.getTime()
+		packet = self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_STREAM_START, array('B', struct.pack('HHI', stream_type, 0, len(data)))))
+		status, window, max_chunk_length = struct.unpack('HHH', packet["data"][0:6])
+		if status != CMD_HID_ACK:
+			print "Stream refused by device"
+			self.device.ack_flag_in_comms = ack_flag_in_comms
+			return False
+		
+		# Chunk IDs: all chunks below acked_chunk_id were consumed by the device
+		nb_chunks = (len(data) + max_chunk_length - 1) / max_chunk_length
+		acked_chunk_id = 0
+		next_chunk_id = 0
+		nb_go_backs = 0
+		
+		while acked_chunk_id < nb_chunks:
+			# Fill the window
+			while next_chunk_id < nb_chunks and next_chunk_id < acked_chunk_id + window:
+				chunk = array('B', struct.pack('H', next_chunk_id))
+				chunk.extend(data[next_chunk_id*max_chunk_length:(next_chunk_id+1)*max_chunk_length])
+				self.device.sendHidMessage(self.getPacketForCommand(CMD_STREAM_DATA, chunk))
+				next_chunk_id += 1
+				
+			# Wait for an acknowledgement
+			packet = self.device.receiveHidMessage()
+			if packet["cmd"] == CMD_RETRY:
+				# Device busy: send the unacknowledged chunks again
+				time.sleep(0.01)
+				next_chunk_id = acked_chunk_id
+				nb_go_backs += 1
+			elif packet["cmd"] == CMD_STREAM_DATA:
+				status, chunk_id, self.stream_result = struct.unpack('HHH', packet["data"][0:6])
+				if status == STREAM_STATUS_ACK:
+					acked_chunk_id = chunk_id
+				elif status == STREAM_STATUS_GO_BACK:
+					next_chunk_id = chunk_id
+					nb_go_backs += 1
+				else:
+					if verbose:
+						print "Stream aborted by device at chunk", chunk_id
+					self.device.ack_flag_in_comms = ack_flag_in_comms
+					return False
+					
+		# Throughput report
+		self.device.ack_flag_in_comms = ack_flag_in_comms
+		self.stream_nb_go_backs = nb_go_backs
+		self.stream_max_chunk_length = max_chunk_length
+		elapsed_time = self.device.getTime() - start_time
+		if verbose:
+			print "Streamed " + str(len(data)) + " bytes in " + str(int(elapsed_time*1000)) + "ms (" + str(int(len(data)/elapsed_time)) + "B/s, " + str(nb_chunks) + " chunks, " + str(nb_go_backs) + " go backs)"
+		return True
+		
+	# Send bundle to the dataflash as a stream
+	def streamDebugBundle(self, filename):
+		# Check for file
+		if not isfile(filename):
+			print "File \"" + filename + "\" does not exist"
+			return
+			
+		# Read file
+		bundlefile = open(filename, 'rb')
+		bundle_data = array('B', bundlefile.read())
+		bundlefile.close()
+		
+		# Send erase dataflash command to usb
+		print "Sending erase dataflash command.."
+		self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_DBG_ERASE_DATA_FLASH, None))
+		
+		# Wait for erase done
+		print "Waiting for erase done..."
+		while True:
+			time.sleep(.1)
+			if self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_DBG_IS_DATA_FLASH_READY, None))["data"][0] == CMD_HID_ACK:
+				break;
+				
+		# Stream it, device reindexes the bundle once it is fully received
+		print "Streaming bundle data..."
+		self.streamData(STREAM_TYPE_DATAFLASH, bundle_data)
+		
+	# Pack a credential for a batch: service & login lengths in characters including terminating 0, password length, reserved byte, then data padded to an even length
+	def packBatchCredential(self, service, login, password):
+		service_data = array('B', (service + u"\0").encode('utf-16-le'))
+		login_data = array('B', (login + u"\0").encode('utf-16-le'))
+		password_data = array('B', password.encode('utf-8'))
+		record = array('B', struct.pack('BBBB', len(service_data)/2, len(login_data)/2, len(password_data), 0))
+		record.extend(service_data)
+		record.extend(login_data)
+		record.extend(password_data)
+		if len(record) % 2 != 0:
+			record.append(0)
+		return record
+		
+	# Import a service,login,password CSV file as credential batches
+	def importCredentialsBatch(self, filename):
+		# Check for file
+		if not isfile(filename):
+			print "File \"" + filename + "\" does not exist"
+			return
+			
+		# Pack credentials
+		records = []
+		csvfile = open(filename, 'r')
+		for line in csvfile:
+			fields = line.decode('utf-8').rstrip('\r\n').split(',', 2)
+			if len(fields) != 3:
+				continue
+			records.append(self.packBatchCredential(fields[0], fields[1], fields[2]))
+		csvfile.close()
+		
+		# Send them in batches the device can buffer
+		nb_stored = 0
+		while len(records) > 0:
+			batch = array('B')
+			nb_creds = 0
+			while len(records) > 0 and nb_creds < CRED_BATCH_MAX_NB_CREDS and len(batch) + len(records[0]) <= CRED_BATCH_MAX_LENGTH:
+				batch.extend(records.pop(0))
+				nb_creds += 1
+			if nb_creds == 0:
+				print "Credential too long, aborting"
+				break
+			stored = self.streamData(STREAM_TYPE_CRED_BATCH, batch)
+			nb_stored += self.stream_result
+			if not stored:
+				print "Batch refused on the device or not fully stored"
+				break
+		print "Imported " + str(nb_stored) + " credentials"
+		
 	# Reboot to bootloader, no answer from device.
 	def rebootToBootloader(self):
 		self.device.sendHidMessage(self.getPacketForCommand(CMD_DBG_REBOOT_TO_BOOTLOADER, None))	
@@ -259,6 +403,253 @@ class mooltipass_hid_device:
 		print "Main MCU minor:", struct.unpack('H', packet["data"][66:68])[0]
 
 		
+	# Get per screen render statistics since last call
+	def getRenderStats(self):
+		# Screen names, in gui_screen_te order
+		screen_names = ["not inserted", "inserted locked", "invalid card", "unknown card", "memory mgmt", "categories", "favorites", "login", "lock", "main menu", "bluetooth", "operations", "settings"]
+		
+		# Ask for the stats
+		packet = self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_DBG_GET_RENDER_STATS, None))
+		
+		# Print them!
+		print ""
+		print "Screen".ljust(16), "renders".rjust(8), "avg ms".rjust(8), "max ms".rjust(8), "reads/rdr".rjust(10), "bytes/rdr".rjust(10)
+		for i in range(0, len(packet["data"])/20):
+			nb_renders, total_ms, max_ms, nb_reads, nb_bytes = struct.unpack('IIIII', packet["data"][i*20:i*20+20])
+			if nb_renders != 0:
+				print screen_names[i].ljust(16), str(nb_renders).rjust(8), str(total_ms/nb_renders).rjust(8), str(max_ms).rjust(8), str(nb_reads/nb_renders).rjust(10), str(nb_bytes/nb_renders).rjust(10)
+
+		
+	# Get per command call count & cycles since last call
+	def getCommandStats(self):
+		# Command names
+		command_names = {CMD_PING: "ping", 0x0003: "plat info", 0x0004: "set date", 0x0005: "cancel request", CMD_STREAM_START: "stream start", CMD_STREAM_DATA: "stream data",
+						 CMD_DBG_OPEN_DISP_BUFFER: "open disp buffer", CMD_DBG_SEND_TO_DISP_BUFFER: "send to disp buffer", CMD_DBG_CLOSE_DISP_BUFFER: "close disp buffer",
+						 CMD_DBG_ERASE_DATA_FLASH: "erase dataflash", CMD_DBG_IS_DATA_FLASH_READY: "is dataflash ready", CMD_DBG_DATAFLASH_WRITE_256B: "dataflash write 256B",
+						 CMD_DBG_REBOOT_TO_BOOTLOADER: "reboot to bootloader", CMD_DBG_GET_ACC_32_SAMPLES: "get acc samples", CMD_DBG_FLASH_AUX_MCU: "flash aux mcu",
+						 CMD_DBG_GET_PLAT_INFO: "get plat info", CMD_DBG_REINDEX_BUNDLE: "reindex bundle", CMD_DBG_GET_RENDER_STATS: "get render stats", CMD_DBG_GET_CMD_STATS: "get cmd stats"}
+		
+		# Ask for the stats
+		packet = self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_DBG_GET_CMD_STATS, None))
+		
+		# Print them! Device runs at 48MHz
+		print ""
+		print "Command".ljust(24), "calls".rjust(8), "avg us".rjust(10), "max us".rjust(10), "blocking".rjust(9)
+		for i in range(0, len(packet["data"])/16):
+			command_id, flags, nb_calls, total_cycles, max_cycles = struct.unpack('HHIII', packet["data"][i*16:i*16+16])
+			name = command_names.get(command_id, hex(command_id))
+			print name.ljust(24), str(nb_calls).rjust(8), str(total_cycles/nb_calls/48).rjust(10), str(max_cycles/48).rjust(10), ("yes" if flags & 0x0001 else "no").rjust(9)
+			
+	# Feed random and valid frames to the command parser, checking that the device still answers pings
+	def fuzzCommandParser(self, nb_frames):
+		# Commands we don't fuzz: streams write to the dataflash
+		excluded_commands = [CMD_STREAM_START, CMD_STREAM_DATA]
+		
+		# Frames to which no reply is expected are drained with a short timeout
+		self.device.setReadTimeout(50)
+		
+		nb_valid_frames = 0
+		nb_replies = 0
+		start_time = self.device.getTime()
+		for i in range(0, nb_frames):
+			if random.randint(0, 1) == 0:
+				# Valid frame: ping with a random payload
+				payload = [random.randint(0, 255) for j in range(0, random.randint(0, HID_MSG_MAX_PAYLOAD_SIZE))]
+				packet = self.getPacketForCommand(CMD_PING, payload)
+				nb_valid_frames += 1
+			else:
+				# Random command outside of the debug range, random payload, sometimes with a wrong length field
+				command = random.randint(0, CMD_DBG_MESSAGE-1)
+				while command in excluded_commands:
+					command = random.randint(0, CMD_DBG_MESSAGE-1)
+				payload = [random.randint(0, 255) for j in range(0, random.randint(0, HID_MSG_MAX_PAYLOAD_SIZE))]
+				packet = self.getPacketForCommand(command, payload)
+				if random.randint(0, 3) == 0:
+					packet["len"] = array('B')
+					packet["len"].fromstring(struct.pack('H', random.randint(0, 0xFFFF)))
+			self.device.sendHidMessage(packet)
+			
+			# Drain possible replies
+			while self.device.receiveHidPacketWithTimeout() is not None:
+				nb_replies += 1
+				
+			# Check that the device is still alive
+			if i % 100 == 99:
+				self.device.setReadTimeout(USB_READ_TIMEOUT)
+				reply = self.device.sendHidMessageWaitForAck(self.createPingPacket())
+				if reply is None or reply["cmd"] != CMD_PING:
+					print "Device didn't answer ping after", i+1, "frames"
+					return
+				self.device.setReadTimeout(50)
+				print i+1, "frames sent"
+		
+		self.device.setReadTimeout(USB_READ_TIMEOUT)
+		elapsed_time = self.device.getTime() - start_time
+		print nb_frames, "frames (" + str(nb_valid_frames), "valid) in", round(elapsed_time, 1), "s:", int(nb_frames/elapsed_time), "frames/s,", nb_replies, "reply packets"
+		
+	# Benchmark the transport: latency percentiles and throughput for pings, streams and credential batches
+	def benchmarkTransport(self, nb_iterations):
+		print "Round trip latencies in ms over " + str(nb_iterations) + " iterations"
+		print "Command".ljust(24), "Bytes".rjust(6), "min".rjust(8), "p50".rjust(8), "p90".rjust(8), "p99".rjust(8), "max".rjust(8), "B/s".rjust(12)
+		
+		# Pings: single packet, packet boundaries and full multi packet messages
+		for payload_size in [4, 58, 59, 120, 250, HID_MSG_MAX_PAYLOAD_SIZE]:
+			ping_message = self.getPacketForCommand(CMD_PING, [random.randint(0, 255) for i in range(0, payload_size)])
+			latencies = self.device.benchmarkMessageLatency(ping_message, nb_iterations)
+			self.printBenchmarkResult("Ping", payload_size, latencies)
+			
+		# Streams: full display frame
+		frame_data = array('B', [random.randint(0, 255) for i in range(0, 256*64/2)])
+		latencies = []
+		for i in range(0, nb_iterations):
+			start_time = self.device.getTime()
+			if not self.streamData(STREAM_TYPE_DISPLAY, frame_data, False):
+				return
+			latencies.append(self.device.getTime() - start_time)
+		self.printBenchmarkResult("Display stream", len(frame_data), latencies)
+		
+		# Database: credential batches, storing the same credentials at each iteration
+		for nb_creds in [1, 8, CRED_BATCH_MAX_NB_CREDS]:
+			batch = array('B')
+			for i in range(0, nb_creds):
+				batch.extend(self.packBatchCredential(u"benchmark" + unicode(i), u"login", u"password" + unicode(i)))
+			latencies = []
+			for i in range(0, nb_iterations):
+				start_time = self.device.getTime()
+				if not self.streamData(STREAM_TYPE_CRED_BATCH, batch, False):
+					return
+				latencies.append(self.device.getTime() - start_time)
+			self.printBenchmarkResult("Batch of " + str(nb_creds) + " creds", len(batch), latencies)
+		
+	# Sustained USB to main MCU forwarding: pings sent back to back without waiting for their replies, messages/s from
+	# the first OUT packet to the last message received by the main MCU. OUT packets NAKed by the aux MCU show USB
+	# reception waiting on the link, the USB bound is one 64B packet per 1ms frame
+	def benchmarkUsbForwarding(self, nb_messages):
+		print "Pings sent back to back, " + str(nb_messages) + " per configuration"
+		print "Baud".rjust(8), "Loop us".rjust(8), "Bytes".rjust(6), "Packets".rjust(8), "msg/s".rjust(8), "USB msg/s".rjust(10), "B/s".rjust(8), "NAKs".rjust(6)
+		for baudrate in [6000000, 1000000]:
+			for main_loop_us in [0, 2000]:
+				for payload_size in [4, 120, 250, HID_MSG_MAX_PAYLOAD_SIZE]:
+					self.connectSimulated(baudrate=baudrate, main_loop_ns=main_loop_us*1000)
+					device = self.device.hid_device
+					ping_message = self.getPacketForCommand(CMD_PING, [random.randint(0, 255) for i in range(0, payload_size)])
+					nb_packets = (payload_size + 4 + HID_PACKET_DATA_PAYLOAD - 1) / HID_PACKET_DATA_PAYLOAD
+					device.link_log = []
+					device.nb_out_naks = 0
+					start_time = self.device.getTime()
+					for i in range(0, nb_messages):
+						self.device.sendHidMessage(ping_message)
+						device.in_packets = []
+					while len([1 for source_main, start_ns, data in device.link_log if not source_main and data[0:2] == "\x00\x00"]) < nb_messages:
+						device.step()
+					last_start_ns = max(start_ns for source_main, start_ns, data in device.link_log if not source_main)
+					elapsed_time = (last_start_ns + AUX_MCU_MESSAGE_SIZE * 10 * 1000000000 / baudrate) / 1e9 - start_time
+					print str(baudrate).rjust(8), str(main_loop_us).rjust(8), str(payload_size).rjust(6), str(nb_packets).rjust(8), str(int(nb_messages / elapsed_time)).rjust(8), str(1000 / nb_packets).rjust(10), str(int(nb_messages * payload_size / elapsed_time)).rjust(8), str(device.nb_out_naks).rjust(6)
+					device.link_log = None
+		
+	# Streams through the three hops (USB, aux MCU, link, main MCU) for different link speeds & main MCU main loop periods:
+	# B/s of a dataflash stream, of a display frame stream and, as a baseline, of the same bytes sent as pings each waiting
+	# for its reply. The link bound is one chunk per link message, the USB bound one 64B packet per 1ms frame
+	def benchmarkStreaming(self, nb_bytes):
+		data = array('B', [random.randint(0, 255) for i in range(0, nb_bytes)])
+		frame_data = array('B', [random.randint(0, 255) for i in range(0, 256*64/2)])
+		print "Streaming " + str(nb_bytes) + " bytes, B/s"
+		print "Baud".rjust(8), "Loop us".rjust(8), "Dataflash".rjust(10), "Display".rjust(8), "Pings".rjust(8), "Link bound".rjust(11), "USB bound".rjust(10), "Go backs".rjust(9)
+		for baudrate in [6000000, 3000000, 1000000, 500000]:
+			for main_loop_us in [0, 2000, 10000]:
+				self.connectSimulated(baudrate=baudrate, main_loop_ns=main_loop_us*1000)
+				results = []
+				nb_go_backs = 0
+				for stream_type, stream_data in [(STREAM_TYPE_DATAFLASH, data), (STREAM_TYPE_DISPLAY, frame_data)]:
+					start_time = self.device.getTime()
+					if not self.streamData(stream_type, stream_data, False):
+						return
+					results.append(int(len(stream_data) / (self.device.getTime() - start_time)))
+					nb_go_backs += self.stream_nb_go_backs
+				start_time = self.device.getTime()
+				for i in range(0, nb_bytes, HID_MSG_MAX_PAYLOAD_SIZE):
+					self.device.sendHidMessageWaitForAck(self.getPacketForCommand(CMD_PING, data[i:i+HID_MSG_MAX_PAYLOAD_SIZE]))
+				results.append(int(nb_bytes / (self.device.getTime() - start_time)))
+				chunk_length = self.stream_max_chunk_length
+				usb_bound = chunk_length * 1000 / ((chunk_length + 2 + 4 + HID_PACKET_DATA_PAYLOAD - 1) / HID_PACKET_DATA_PAYLOAD)
+				link_bound = chunk_length * baudrate / (AUX_MCU_MESSAGE_SIZE * 10)
+				print str(baudrate).rjust(8), str(main_loop_us).rjust(8), str(results[0]).rjust(10), str(results[1]).rjust(8), str(results[2]).rjust(8), str(link_bound).rjust(11), str(usb_bound).rjust(10), str(nb_go_backs).rjust(9)
+		
+	# Credential import through the host built firmwares: one credential per batch as when a command is sent per credential,
+	# then batches as large as the device buffers. Flash programs are DB flash page writes, the time is the simulated one
+	def benchmarkCredentialImport(self, nb_creds):
+		records = [self.packBatchCredential(u"service" + unicode(i / 4), u"login" + unicode(i % 4), u"password" + unicode(i)) for i in range(0, nb_creds)]
+		random.Random(1).shuffle(records)
+
+		# Batches are refused once the user context is gone
+		self.connectSimulated()
+		self.device.hid_device.main.logic_encryption_delete_context()
+		refused = not self.streamData(STREAM_TYPE_CRED_BATCH, records[0], False)
+		print "Batch refused without encryption context:", refused
+
+		# One prompt per batch with the new & updated credential counts, nothing stored when the user denies
+		self.connectSimulated()
+		main = self.device.hid_device.main
+		prompt_answer = ctypes.c_int.in_dll(main, "host_prompt_answer")
+		prompt_string = lambda: ctypes.string_at(ctypes.addressof(ctypes.c_uint16.in_dll(main, "host_prompt_string")), 128).decode('utf-16-le').split(u"\0")[0]
+		batch = array('B')
+		for record in records[0:8]:
+			batch.extend(record)
+		ctypes.c_uint32.in_dll(main, "host_dbflash_nb_writes").value = 0
+		refused = True
+		for answer in [MINI_INPUT_RET_NO, MINI_INPUT_RET_TIMEOUT]:
+			prompt_answer.value = answer
+			refused = refused and not self.streamData(STREAM_TYPE_CRED_BATCH, batch, False) and self.stream_result == 0
+		refused = refused and ctypes.c_uint32.in_dll(main, "host_dbflash_nb_writes").value == 0
+		print "Batch denied or prompt timed out, nothing written:", refused, "(" + prompt_string() + ")"
+		prompt_answer.value = MINI_INPUT_RET_YES
+		stored = self.streamData(STREAM_TYPE_CRED_BATCH, batch, False) and self.stream_result == 8
+		print "Batch approved, stored count reported:", stored, "(" + prompt_string() + ")"
+		stored = self.streamData(STREAM_TYPE_CRED_BATCH, batch, False) and self.stream_result == 8
+		print "Same batch again, stored count reported:", stored, "(" + prompt_string() + ", " + str(ctypes.c_uint32.in_dll(main, "host_nb_prompts").value) + " prompts)"
+
+		print "Importing " + str(nb_creds) + " credentials"
+		print "Mode".ljust(16), "Batches".rjust(8), "Programs".rjust(9), "Reads".rjust(9), "Time s".rjust(8), "creds/s".rjust(8)
+		for batched in [False, True]:
+			self.connectSimulated()
+			main = self.device.hid_device.main
+			ctypes.c_uint32.in_dll(main, "host_dbflash_nb_writes").value = 0
+			ctypes.c_uint32.in_dll(main, "host_dbflash_nb_reads").value = 0
+			start_time = self.device.getTime()
+			nb_batches = 0
+			i = 0
+			while i < nb_creds:
+				batch = array('B', records[i])
+				nb_batch_creds = 1
+				while batched and i + nb_batch_creds < nb_creds and nb_batch_creds < CRED_BATCH_MAX_NB_CREDS and len(batch) + len(records[i + nb_batch_creds]) <= CRED_BATCH_MAX_LENGTH:
+					batch.extend(records[i + nb_batch_creds])
+					nb_batch_creds += 1
+				if not self.streamData(STREAM_TYPE_CRED_BATCH, batch, False):
+					return
+				i += nb_batch_creds
+				nb_batches += 1
+			elapsed_time = self.device.getTime() - start_time
+			nb_programs = ctypes.c_uint32.in_dll(main, "host_dbflash_nb_writes").value
+			nb_reads = ctypes.c_uint32.in_dll(main, "host_dbflash_nb_reads").value
+			print ("batched" if batched else "one at a time").ljust(16), str(nb_batches).rjust(8), str(nb_programs).rjust(9), str(nb_reads).rjust(9), ("%.1f" % elapsed_time).rjust(8), str(int(nb_creds / elapsed_time)).rjust(8)
+
+	# Print a benchmark line: latency percentiles and throughput
+	def printBenchmarkResult(self, name, nb_bytes, latencies):
+		percentiles = self.device.getLatencyPercentiles(latencies)
+		throughput = int(nb_bytes * len(latencies) / sum(latencies))
+		print name.ljust(24), str(nb_bytes).rjust(6), " ".join(("%.2f" % percentile).rjust(8) for percentile in percentiles), str(throughput).rjust(12)
+		
+	# Print the traces sent by the device
+	def traceListen(self):
+		decoder = trace_decoder()
+		# No read timeout: traces are only sent when something happens
+		self.device.setReadTimeout(0)
+		while True:
+			packet = self.device.receiveHidMessage()
+			if packet is not None and packet["cmd"] == CMD_DBG_TRACE:
+				for line in decoder.decodeMessage(packet["data"]):
+					print line
+		
 	# Get accelerometer data
 	def getAccData(self):
 		# Random bytes file
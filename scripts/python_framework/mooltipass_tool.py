@@ -1,5 +1,12 @@
 #!/usr/bin/env python2
 from mooltipass_hid_device import *
+from host_keyboard import *
+from host_smartcard import *
+from host_crypto import *
+from simulated_credential_recall import *
+from host_drbg import *
+from host_bundle_signature import *
+from host_gui_render import *
 from datetime import datetime
 from array import array
 import platform
@@ -8,7 +15,7 @@ import usb.util
 import random
 import time
 import sys
-nonConnectionCommands = []
+nonConnectionCommands = ["benchmarkSimulated", "keyboardSimulated", "bleKeyboardSimulated", "smartcardSimulated", "smartcardTimingSimulated", "aesHostTest", "credentialRecallSimulated", "drbgHostTest", "bundleSignatureHostTest", "guiRenderHostTest", "credentialListBenchmark", "frameBufferHostTest", "textLayoutBenchmark", "pinEntryBenchmark", "linkBurstBenchmark", "auxTransactionHostTest", "usbForwardingBenchmark", "usbReplyBenchmark", "streamingBenchmark", "linkErrorBenchmark", "fuzzSimulated", "credentialImportBenchmark", "traceOverheadBenchmark"]
 
 def main():
 	skipConnection = False
@@ -62,6 +69,21 @@ def main():
 			else:
 				print "Please specify bundle filename"
 		
+		elif sys.argv[1] == "streamDebugBundle":
+			# mooltipass_tool.py streamDebugBundle filename
+			if len(sys.argv) > 2:
+				filename = sys.argv[2]
+				mooltipass_device.streamDebugBundle(filename)
+			else:
+				print "Please specify bundle filename"
+		
+		elif sys.argv[1] == "importCredentials":
+			# mooltipass_tool.py importCredentials file.csv
+			if len(sys.argv) > 2:
+				mooltipass_device.importCredentialsBatch(sys.argv[2])
+			else:
+				print "Please specify the CSV file"
+		
 		elif sys.argv[1] == "rebootToBootloader":
 			mooltipass_device.rebootToBootloader()
 			
@@ -71,9 +93,161 @@ def main():
 		elif sys.argv[1] == "platInfo":
 			mooltipass_device.getPlatInfo()
 			
+		elif sys.argv[1] == "renderStats":
+			mooltipass_device.getRenderStats()
+			
+		elif sys.argv[1] == "cmdStats":
+			mooltipass_device.getCommandStats()
+			
+		elif sys.argv[1] == "fuzzCommands":
+			# mooltipass_tool.py fuzzCommands [nb_frames]
+			if len(sys.argv) > 2:
+				mooltipass_device.fuzzCommandParser(int(sys.argv[2]))
+			else:
+				mooltipass_device.fuzzCommandParser(1000)
+			
+		elif sys.argv[1] == "benchmark":
+			# mooltipass_tool.py benchmark [nb_iterations]
+			if len(sys.argv) > 2:
+				mooltipass_device.benchmarkTransport(int(sys.argv[2]))
+			else:
+				mooltipass_device.benchmarkTransport(100)
+			
+		elif sys.argv[1] == "benchmarkSimulated":
+			# mooltipass_tool.py benchmarkSimulated [nb_iterations]
+			mooltipass_device = mooltipass_hid_device()
+			mooltipass_device.connectSimulated()
+			if len(sys.argv) > 2:
+				mooltipass_device.benchmarkTransport(int(sys.argv[2]))
+			else:
+				mooltipass_device.benchmarkTransport(100)
+			
+		elif sys.argv[1] == "keyboardSimulated":
+			# mooltipass_tool.py keyboardSimulated [delay_between_reports_ms]
+			if len(sys.argv) > 2:
+				runKeyboardSimulation(int(sys.argv[2]))
+			else:
+				runKeyboardSimulation(0)
+			
+		elif sys.argv[1] == "bleKeyboardSimulated":
+			# mooltipass_tool.py bleKeyboardSimulated [connection_interval_ms]
+			if len(sys.argv) > 2:
+				runBleKeyboardSimulation([float(sys.argv[2])])
+			else:
+				runBleKeyboardSimulation([7.5, 15, 30, 50])
+			
+		elif sys.argv[1] == "smartcardSimulated":
+			runSmartcardHostTest()
+			
+		elif sys.argv[1] == "smartcardTimingSimulated":
+			runSmartcardTimingHostTest()
+			
+		elif sys.argv[1] == "aesHostTest":
+			runAesHostTest()
+			
+		elif sys.argv[1] == "credentialRecallSimulated":
+			runCredentialRecallSimulation()
+			
+		elif sys.argv[1] == "drbgHostTest":
+			# mooltipass_tool.py drbgHostTest [CTR_DRBG.rsp]
+			if len(sys.argv) > 2:
+				runDrbgHostTest(sys.argv[2])
+			else:
+				runDrbgHostTest()
+			
+		elif sys.argv[1] == "bundleSignatureHostTest":
+			runBundleSignatureHostTest()
+			
+		elif sys.argv[1] == "guiRenderHostTest":
+			# mooltipass_tool.py guiRenderHostTest [--update-golden]
+			runGuiRenderHostTest(len(sys.argv) > 2 and sys.argv[2] == "--update-golden")
+			
+		elif sys.argv[1] == "credentialListBenchmark":
+			# mooltipass_tool.py credentialListBenchmark [nb_services]
+			if len(sys.argv) > 2:
+				runCredentialListBenchmark(int(sys.argv[2]))
+			else:
+				runCredentialListBenchmark()
+			
+		elif sys.argv[1] == "frameBufferHostTest":
+			runFrameBufferHostTest()
+			
+		elif sys.argv[1] == "textLayoutBenchmark":
+			runTextLayoutBenchmark()
+			
+		elif sys.argv[1] == "pinEntryBenchmark":
+			runPinEntryBenchmark()
+			
+		elif sys.argv[1] == "linkBurstBenchmark":
+			# mooltipass_tool.py linkBurstBenchmark [nb_bursts]
+			if len(sys.argv) > 2:
+				runLinkBurstBenchmark(int(sys.argv[2]))
+			else:
+				runLinkBurstBenchmark()
+			
+		elif sys.argv[1] == "linkErrorBenchmark":
+			# mooltipass_tool.py linkErrorBenchmark [nb_requests]
+			if len(sys.argv) > 2:
+				runLinkErrorBenchmark(int(sys.argv[2]))
+			else:
+				runLinkErrorBenchmark()
+			
+		elif sys.argv[1] == "auxTransactionHostTest":
+			# mooltipass_tool.py auxTransactionHostTest [nb_requests]
+			if len(sys.argv) > 2:
+				runAuxTransactionTest(int(sys.argv[2]))
+			else:
+				runAuxTransactionTest()
+			
+		elif sys.argv[1] == "traceOverheadBenchmark":
+			runTraceOverheadBenchmark()
+			
+		elif sys.argv[1] == "usbForwardingBenchmark":
+			# mooltipass_tool.py usbForwardingBenchmark [nb_messages]
+			mooltipass_device = mooltipass_hid_device()
+			if len(sys.argv) > 2:
+				mooltipass_device.benchmarkUsbForwarding(int(sys.argv[2]))
+			else:
+				mooltipass_device.benchmarkUsbForwarding(30)
+			
+		elif sys.argv[1] == "usbReplyBenchmark":
+			# mooltipass_tool.py usbReplyBenchmark [nb_bursts]
+			if len(sys.argv) > 2:
+				runUsbReplyBenchmark(int(sys.argv[2]))
+			else:
+				runUsbReplyBenchmark()
+			
+		elif sys.argv[1] == "streamingBenchmark":
+			# mooltipass_tool.py streamingBenchmark [nb_bytes]
+			mooltipass_device = mooltipass_hid_device()
+			if len(sys.argv) > 2:
+				mooltipass_device.benchmarkStreaming(int(sys.argv[2]))
+			else:
+				mooltipass_device.benchmarkStreaming(65536)
+			
+		elif sys.argv[1] == "credentialImportBenchmark":
+			# mooltipass_tool.py credentialImportBenchmark [nb_creds]
+			mooltipass_device = mooltipass_hid_device()
+			if len(sys.argv) > 2:
+				mooltipass_device.benchmarkCredentialImport(int(sys.argv[2]))
+			else:
+				mooltipass_device.benchmarkCredentialImport(1000)
+			
+		elif sys.argv[1] == "fuzzSimulated":
+			# mooltipass_tool.py fuzzSimulated [nb_frames]: command parser fuzzing against the host built firmwares
+			mooltipass_device = mooltipass_hid_device()
+			mooltipass_device.connectSimulated()
+			if len(sys.argv) > 2:
+				mooltipass_device.fuzzCommandParser(int(sys.argv[2]))
+			else:
+				mooltipass_device.fuzzCommandParser(1000)
+			
 		elif sys.argv[1] == "accGet":
 			mooltipass_device.getAccData()
 			
+		elif sys.argv[1] == "traceListen":
+			mooltipass_device.traceListen()
+			
 		elif sys.argv[1] == "debugListen":
 			while True:
 				try:
@@ -0,0 +1,251 @@
+#!/usr/bin/env python2
+from host_firmware import *
+from host_crypto import *
+import random
+import os
+
+# Credential recall latency: DB flash read of a child_cred_node_t followed by the password decryption, with and without
+# generating the keystream while the DMA controller reads the end of the node (readCredChildNode())
+
+# Emulated main MCU clock, DB flash SPI at 48MHz / (2 * (DBFLASH_BAUD_DIVIDER + 1)), in ns
+SIM_RC_CPU_CYCLE_NS				= 1e9 / 48000000
+SIM_RC_SPI_BYTE_NS				= 8 * 1e9 / 12000000
+# Opcode bytes sent before the data
+SIM_RC_OPCODE_BYTES				= 4
+# sercom_spi_send_single_byte() loop overhead per byte on top of the 8 SPI clocks
+SIM_RC_POLL_BYTE_CYCLES			= 12
+# dma_dbflash_init_transfer(), DMAC_Handler() + flag polling exit
+SIM_RC_DMA_SETUP_CYCLES			= 50
+SIM_RC_DMA_IRQ_CYCLES			= 80
+# Bus cycles taken from the CPU by the RX & TX beats of each byte
+SIM_RC_DMA_STOLEN_CYCLES		= 4
+# aes256_encrypt_block() estimates for the Cortex-M0+, counter block increment & copy of the keystream block
+SIM_RC_AES_BLOCK_CYCLES			= [1800, 2600, 3600]
+SIM_RC_CTR_BLOCK_CYCLES			= 80
+# aes256_ctr_xor_keystream() per byte
+SIM_RC_XOR_BYTE_CYCLES			= 6
+# child_cred_node_t passwordFormat
+PWD_FORMAT_AES256_CTR			= 0x01
+
+# Main MCU sources for the firmware recall checks: readCredChildNode() on the host flash & DMA stand-ins
+RECALL_SOURCES = ["NODEMGMT/nodemgmt.c", "LOGIC/logic_encryption.c", "SECURITY/aes.c", "SECURITY/aes256_ctr.c", "utils.c"]
+
+HOST_RECALL_STANDINS = r"""
+#include "logic_encryption.h"
+#include "nodemgmt.h"
+
+static child_cred_node_t host_recall_node;
+
+/* Logged in user with a single credential stored through the batch API, returns the child node address */
+uint16_t host_recall_create_user(uint8_t* password, uint16_t password_length)
+{
+	static cust_char_t service[] = {'s', 'e', 'r', 'v', 'i', 'c', 'e', '.', 'c', 'o', 'm', 0};
+	static cust_char_t login[] = {'u', 's', 'e', 'r', 0};
+	nodemgmt_batch_cred_t cred = {.service = service, .login = login, .password = password, .password_length = password_length};
+	uint8_t card_aes_key[AES_KEY_LENGTH/8];
+	cpz_lut_entry_t cpz_entry;
+	parent_node_t parent_node;
+	uint16_t nb_stored;
+
+	host_dbflash_erase();
+	nodemgmt_format_user_profile(0);
+	nodemgmt_init_context(0);
+	memset(&cpz_entry, 0xA5, sizeof(cpz_entry));
+	memset(card_aes_key, 0x5A, sizeof(card_aes_key));
+	logic_encryption_init_context(card_aes_key, &cpz_entry);
+	if ((nodemgmt_store_credentials_batch(&cred, 1, &nb_stored) != RETURN_OK) || (nb_stored != 1))
+	{
+		return NODE_ADDR_NULL;
+	}
+	readParentNode(getStartingParentAddress(), &parent_node, FALSE);
+	return parent_node.cred_parent.nextChildAddress;
+}
+
+/* Direct access to the child node in flash */
+child_cred_node_t* host_recall_flash_node(uint16_t address)
+{
+	return (child_cred_node_t*)&host_dbflash[address >> NODEMGMT_ADDR_PAGE_BITSHIFT][BASE_NODE_SIZE * (address & NODEMGMT_ADDR_NODE_MASK)];
+}
+
+/* Rewrite the node as stored before encryption was introduced */
+void host_recall_make_plaintext(uint16_t address, uint8_t* password, uint16_t password_length)
+{
+	child_cred_node_t* node = host_recall_flash_node(address);
+	memset(node->password, 0, sizeof(node->password));
+	memcpy(node->password, password, password_length);
+	memset(node->ctr, 0, sizeof(node->ctr));
+	node->passwordFormat = NODEMGMT_PWD_FORMAT_PLAINTEXT;
+}
+
+/* readCredChildNode(): returns its status, the password is copied out */
+RET_TYPE host_recall_read(uint16_t address, uint8_t* password)
+{
+	RET_TYPE ret_val = readCredChildNode(address, &host_recall_node);
+	memcpy(password, host_recall_node.password, sizeof(host_recall_node.password));
+	return ret_val;
+}
+
+uint8_t host_recall_flash_format(uint16_t address) { return host_recall_flash_node(address)->passwordFormat; }
+void host_recall_flash_password(uint16_t address, uint8_t* password) { memcpy(password, host_recall_flash_node(address)->password, sizeof(host_recall_node.password)); }
+"""
+
+# child_cred_node_t layout from nodemgmt.h
+HOST_RECALL_HELPERS = r"""
+#include <stddef.h>
+#include "nodemgmt.h"
+uint32_t host_cred_node_size(void) { return sizeof(child_cred_node_t); }
+uint32_t host_cred_node_ctr_offset(void) { return offsetof(child_cred_node_t, ctr); }
+uint32_t host_cred_node_ctr_size(void) { return sizeof(((child_cred_node_t*)0)->ctr); }
+uint32_t host_cred_node_password_offset(void) { return offsetof(child_cred_node_t, password); }
+uint32_t host_cred_node_password_size(void) { return sizeof(((child_cred_node_t*)0)->password); }
+"""
+
+
+# Main MCU timeline: CPU work is slowed down by the DMA beats while a transfer is ongoing
+class emulated_recall_mcu:
+	def __init__(self):
+		self.time = 0.0
+		self.dma_end = 0.0
+
+	def cpu(self, nb_cycles):
+		remaining = nb_cycles * SIM_RC_CPU_CYCLE_NS
+		if self.time < self.dma_end:
+			rate = 1.0 - SIM_RC_DMA_STOLEN_CYCLES * SIM_RC_CPU_CYCLE_NS / SIM_RC_SPI_BYTE_NS
+			if remaining <= (self.dma_end - self.time) * rate:
+				self.time += remaining / rate
+				return
+			remaining -= (self.dma_end - self.time) * rate
+			self.time = self.dma_end
+		self.time += remaining
+
+	def polledBytes(self, nb_bytes):
+		self.time += nb_bytes * (SIM_RC_SPI_BYTE_NS + SIM_RC_POLL_BYTE_CYCLES * SIM_RC_CPU_CYCLE_NS)
+
+	def dmaStart(self, nb_bytes):
+		self.cpu(SIM_RC_DMA_SETUP_CYCLES)
+		self.dma_end = self.time + nb_bytes * SIM_RC_SPI_BYTE_NS
+
+	def dmaWait(self):
+		self.time = max(self.time, self.dma_end)
+		self.cpu(SIM_RC_DMA_IRQ_CYCLES)
+
+	def keystream(self, nb_bytes, aes_block_cycles):
+		self.cpu(((nb_bytes + 15) / 16) * (aes_block_cycles + SIM_RC_CTR_BLOCK_CYCLES))
+
+	def xor(self, nb_bytes):
+		self.cpu(nb_bytes * SIM_RC_XOR_BYTE_CYCLES)
+
+
+# Recall latencies in ns: polled read then decryption, DMA read then decryption, DMA read overlapped with the keystream
+def recallLatencies(node_size, ctr_end, password_size, aes_block_cycles):
+	polled = emulated_recall_mcu()
+	polled.polledBytes(SIM_RC_OPCODE_BYTES + node_size)
+	polled.keystream(password_size, aes_block_cycles)
+	polled.xor(password_size)
+
+	dma = emulated_recall_mcu()
+	dma.polledBytes(SIM_RC_OPCODE_BYTES)
+	dma.dmaStart(node_size)
+	dma.dmaWait()
+	dma.keystream(password_size, aes_block_cycles)
+	dma.xor(password_size)
+
+	overlapped = emulated_recall_mcu()
+	overlapped.polledBytes(SIM_RC_OPCODE_BYTES)
+	overlapped.dmaStart(ctr_end)
+	overlapped.dmaWait()
+	overlapped.dmaStart(node_size - ctr_end)
+	overlapped.keystream(password_size, aes_block_cycles)
+	overlapped.dmaWait()
+	overlapped.xor(password_size)
+	return polled.time, dma.time, overlapped.time
+
+
+# Check the recall data flow with the firmware AES: the keystream is generated from the first transfer only, then XORed
+def checkRecallDataFlow(library, node_size, ctr_offset, ctr_size, password_offset, password_size, nb_nodes=200):
+	ctr_context = ctypes.create_string_buffer(library.host_aes256_ctr_context_size())
+	ctr_end = ctr_offset + ctr_size
+	for i in range(0, nb_nodes):
+		library.aes256_ctr_init_context(ctr_context, ctypes.create_string_buffer(os.urandom(32), 32), ctypes.create_string_buffer(os.urandom(16), 16))
+		ctr_val = random.randint(0, 0xFFFFFF - password_size / 16)
+		password = os.urandom(random.randint(1, password_size))
+		password = password + "\x00" * (password_size - len(password))
+		encrypted_password = ctypes.create_string_buffer(password, password_size)
+		library.aes256_ctr_crypt(ctr_context, ctr_val, encrypted_password, password_size)
+		ctr = chr((ctr_val >> 16) & 0xFF) + chr((ctr_val >> 8) & 0xFF) + chr(ctr_val & 0xFF)
+		flash_node = os.urandom(ctr_offset) + ctr + os.urandom(password_offset - ctr_end) + encrypted_password.raw[0:password_size] + os.urandom(node_size - password_offset - password_size)
+
+		# First transfer, keystream while the end of the node isn't there yet
+		node = flash_node[0:ctr_end] + "\xEE" * (node_size - ctr_end)
+		node_ctr = node[ctr_offset:ctr_end]
+		keystream = ctypes.create_string_buffer(password_size)
+		library.aes256_ctr_generate_keystream(ctr_context, (ord(node_ctr[0]) << 16) | (ord(node_ctr[1]) << 8) | ord(node_ctr[2]), keystream, password_size)
+
+		# Second transfer, XOR
+		node = node[0:ctr_end] + flash_node[ctr_end:]
+		recalled_password = ctypes.create_string_buffer(node[password_offset:password_offset + password_size], password_size)
+		library.aes256_ctr_xor_keystream(recalled_password, keystream, password_size)
+		if recalled_password.raw[0:password_size] != password or node != flash_node:
+			return False
+	return True
+
+
+# readCredChildNode() on the firmware: encrypted password, plaintext password migration and card removal
+def checkFirmwareRecall(password_size):
+	library = loadHostFirmware(MAIN_MCU_PROJECT, RECALL_SOURCES, HOST_TIMER_STANDINS + HOST_DBFLASH_STANDINS + HOST_RECALL_STANDINS)
+	password = os.urandom(20)
+	padded_password = password + "\x00" * (password_size - len(password))
+	recalled = ctypes.create_string_buffer(password_size)
+	stored = ctypes.create_string_buffer(password_size)
+	all_ok = True
+
+	address = library.host_recall_create_user(ctypes.create_string_buffer(password, len(password)), len(password))
+	library.host_recall_flash_password(address, stored)
+	encrypted_ok = address != 0 and library.host_recall_flash_format(address) == PWD_FORMAT_AES256_CTR and stored.raw != padded_password
+	recall_ok = library.host_recall_read(address, recalled) == 0 and recalled.raw == padded_password
+	print "Stored password encrypted:", "OK" if encrypted_ok else "FAILED"
+	print "Encrypted password recalled:", "OK" if recall_ok else "FAILED"
+	all_ok = all_ok and encrypted_ok and recall_ok
+
+	library.host_recall_make_plaintext(address, ctypes.create_string_buffer(password, len(password)), len(password))
+	recall_ok = library.host_recall_read(address, recalled) == 0 and recalled.raw == padded_password
+	library.host_recall_flash_password(address, stored)
+	migration_ok = library.host_recall_flash_format(address) == PWD_FORMAT_AES256_CTR and stored.raw != padded_password
+	second_recall_ok = library.host_recall_read(address, recalled) == 0 and recalled.raw == padded_password
+	print "Plaintext password recalled:", "OK" if recall_ok else "FAILED"
+	print "Plaintext password encrypted in flash:", "OK" if migration_ok else "FAILED"
+	print "Migrated password recalled:", "OK" if second_recall_ok else "FAILED"
+	all_ok = all_ok and recall_ok and migration_ok and second_recall_ok
+
+	library.logic_encryption_delete_context()
+	no_context_ok = library.host_recall_read(address, recalled) != 0 and recalled.raw == "\x00" * password_size
+	print "No password without encryption context:", "OK" if no_context_ok else "FAILED"
+	return all_ok and no_context_ok
+
+
+def runCredentialRecallSimulation():
+	library = loadFirmwareLibrary(["SECURITY/aes.c", "SECURITY/aes256_ctr.c"], HOST_AES_HELPERS + HOST_RECALL_HELPERS)
+	node_size = library.host_cred_node_size()
+	ctr_offset = library.host_cred_node_ctr_offset()
+	ctr_size = library.host_cred_node_ctr_size()
+	password_offset = library.host_cred_node_password_offset()
+	password_size = library.host_cred_node_password_size()
+	print "child_cred_node_t: " + str(node_size) + " bytes, CTR end at byte " + str(ctr_offset + ctr_size) + ", " + str(password_size) + " bytes password"
+
+	data_flow_ok = checkRecallDataFlow(library, node_size, ctr_offset, ctr_size, password_offset, password_size)
+	print "Keystream from the first transfer decrypts the password:", "OK" if data_flow_ok else "FAILED"
+	firmware_ok = checkFirmwareRecall(password_size)
+	print ""
+
+	print "AES cycles/block".ljust(18), "Polled + decrypt".rjust(18), "DMA + decrypt".rjust(15), "DMA overlapped".rjust(16), "Saved".rjust(8)
+	all_ok = data_flow_ok and firmware_ok
+	for aes_block_cycles in SIM_RC_AES_BLOCK_CYCLES:
+		polled_ns, dma_ns, overlapped_ns = recallLatencies(node_size, ctr_offset + ctr_size, password_size, aes_block_cycles)
+		print str(aes_block_cycles).ljust(18), ("%.0fus" % (polled_ns / 1000)).rjust(18), ("%.0fus" % (dma_ns / 1000)).rjust(15), ("%.0fus" % (overlapped_ns / 1000)).rjust(16), ("%.0f%%" % (100.0 * (polled_ns - overlapped_ns) / polled_ns)).rjust(8)
+		all_ok = all_ok and overlapped_ns < dma_ns < polled_ns
+
+	if all_ok:
+		print "Overlapped recall is the fastest"
+	else:
+		print "Credential recall simulation failed"
+	return all_ok
@@ -0,0 +1,78 @@
+#!/usr/bin/env python2
+from os.path import dirname, join, realpath
+import struct
+import re
+
+# Trace format ID files, parsed to get the format strings: see comms_trace_ids.h
+TRACE_IDS_FILES = [join(dirname(realpath(__file__)), "..", "..", "source_code", "main_mcu", "src", "COMMS", "comms_trace_ids.h"),
+                   join(dirname(realpath(__file__)), "..", "..", "source_code", "aux_mcu_v2", "src", "COMMS", "comms_trace_ids.h")]
+TRACE_SOURCE_NAMES = ["main", "aux"]
+
+
+# Trace decoder class: formats the binary traces sent by both MCUs
+class trace_decoder:
+
+	# Decoder constructor
+	def __init__(self):
+		# Per source: format strings, last decoded tick
+		self.formats = []
+		self.last_ticks = []
+		for filename in TRACE_IDS_FILES:
+			self.formats.append(self.parseTraceIdsFile(filename))
+			self.last_ticks.append(None)
+
+	# Get the format strings from a trace IDs file, in ID order
+	def parseTraceIdsFile(self, filename):
+		ids_file = open(filename, 'r')
+		contents = ids_file.read()
+		ids_file.close()
+		return [format.decode('string_escape') for name, format in re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', contents)]
+
+	# Unwrap the 16 bits ms tick of an entry
+	def unwrapTick(self, source, tick):
+		last_tick = self.last_ticks[source]
+		if last_tick is None:
+			full_tick = tick
+		else:
+			full_tick = last_tick + ((tick - last_tick) & 0xFFFF)
+		self.last_ticks[source] = full_tick
+		return full_tick
+
+	# Format an entry: arguments are 32 bit words, signed for %d & %i
+	def formatEntry(self, format, args):
+		conversions = re.findall(r'%[-+ #0]*\d*(?:\.\d+)?([diouxXc%])', format)
+		conversions = [conversion for conversion in conversions if conversion != '%']
+		if len(conversions) != len(args):
+			return format + " " + str(args)
+		values = []
+		for conversion, arg in zip(conversions, args):
+			if conversion in "di" and arg >= 0x80000000:
+				arg -= 0x100000000
+			elif conversion == "c":
+				arg = unichr(arg)
+			values.append(arg)
+		return format % tuple(values)
+
+	# Decode a trace message payload, returns the formatted lines
+	def decodeMessage(self, data):
+		lines = []
+		source, nb_dropped_entries = struct.unpack('HH', data[0:4].tostring())
+		words = struct.unpack('I' * ((len(data) - 4) / 4), data[4:4+((len(data) - 4) / 4)*4].tostring())
+		source_name = TRACE_SOURCE_NAMES[source] if source < len(TRACE_SOURCE_NAMES) else str(source)
+		if nb_dropped_entries != 0:
+			lines.append("[" + source_name + "] " + str(nb_dropped_entries) + " entries dropped")
+
+		index = 0
+		while index < len(words):
+			header = words[index]
+			format_id = header & 0x0FFF
+			nb_args = (header >> 12) & 0x0F
+			args = list(words[index+1:index+1+nb_args])
+			index += 1 + nb_args
+			tick = self.unwrapTick(source, header >> 16) if source < len(self.last_ticks) else header >> 16
+			if source < len(self.formats) and format_id < len(self.formats[source]):
+				text = self.formatEntry(self.formats[source][format_id], args)
+			else:
+				text = "unknown format " + str(format_id) + " " + str(args)
+			lines.append("[" + source_name + " " + str(tick).rjust(8) + "ms] " + text)
+		return lines
@@ -162,6 +162,7 @@
 #include "timer_hw.h"
 #include "conf_extint.h"
 #include "hid_device.h"
+#include "logic_keyboard.h"
 
 
 /* =========================== GLOBALS ============================================================ */
@@ -181,17 +182,15 @@ hid_proto_mode_ntf_t hid_proto_mode_value;
 /* HID profile structure for application */
 hid_prf_info_t hid_prf_data;
 
-/* Keyboard character info to be displayed during demo */
-uint8_t keyb_disp[12] = {0x0B, 0x08, 0x0F, 0x0F, 0x12, 0x2C, 0x04, 0x17, 0x10, 0x08, 0x0F, 0x28};
-
-/* Keyboard character to be printed */
-uint8_t keyb_id = 0;
-
 /* Profile connection status */
 uint8_t conn_status = 0;
 
 /* Keyboard report value */
-uint8_t app_keyb_report[8] = {0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00};
+uint8_t app_keyb_report[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+/* BLE event being processed by mini_ble_task(), parameters buffer is the BLE manager one */
+at_ble_events_t mini_ble_event;
+extern uint32_t ble_event_params[BLE_EVENT_PARAM_MAX_SIZE/sizeof(uint32_t)];
 
 /* Keyboard key status */
 volatile uint8_t key_status = 0;
@@ -269,7 +268,6 @@ static at_ble_status_t hid_connect_cb(void *params)
 {
 	at_ble_handle_t *handle;
 	handle = (at_ble_handle_t *)params;
-	keyb_id = 0;
 	conn_status = 1;
 	ALL_UNUSED(&handle);
 
@@ -281,7 +279,6 @@ static at_ble_status_t hid_disconnect_cb(void *params)
 {
 	at_ble_handle_t *handle;
 	handle =(at_ble_handle_t *)params;
-	keyb_id = 0;
 	conn_status = 0;
     ALL_UNUSED(&handle);
 	return AT_BLE_SUCCESS;
@@ -328,6 +325,7 @@ static at_ble_status_t hid_notification_confirmed_cb(void *params)
 	at_ble_cmd_complete_event_t *notification_status;
 	notification_status = (at_ble_cmd_complete_event_t *)params;
 	DBG_LOG_DEV("Keyboard report send to host status %d", notification_status->status);
+	logic_keyboard_ble_notification_confirmed_callback((notification_status->status == AT_BLE_SUCCESS)? TRUE : FALSE);
 	return AT_BLE_SUCCESS;
 }
 
@@ -419,35 +417,39 @@ void mini_ble_init(void)
 									&hid_custom_event_cb);
 }
 
-void mini_ble_task(void){
-    /* Capturing the events  */
-    if(app_exec){
-        ble_event_task();
-
-        /* Check for key status */
-        if(conn_status){
-            DBG_LOG("Key Pressed...");
-            delay_ms(KEY_PAD_DEBOUNCE_TIME);
-            if((keyb_id == POSITION_ZERO) || (keyb_id == POSITION_SIX)){
-                app_keyb_report[0] = CAPS_ON;
-                }else{
-                app_keyb_report[0] = CAPS_OFF;
-            }
-
-            app_keyb_report[2] = keyb_disp[keyb_id];
-            hid_prf_report_update(report_ntf_info.conn_handle, report_ntf_info.serv_inst, 1, app_keyb_report, sizeof(app_keyb_report));
-            delay_ms(20);
-            app_keyb_report[2] = 0x00;
-            hid_prf_report_update(report_ntf_info.conn_handle, report_ntf_info.serv_inst, 1, app_keyb_report, sizeof(app_keyb_report));
-            delay_ms(20);
-            key_status = 0;
-
-            if(keyb_id == MAX_TEXT_LEN){
-                keyb_id = 0;
-            }
-            else{
-                ++keyb_id;
-            }
-        }
-    } /* endif app_exec */
+/*! \fn     mini_ble_is_keyboard_connected(void)
+*   \brief  Check if a host is connected and listens to our keyboard reports
+*   \return TRUE if keyboard reports can be sent
+*/
+BOOL mini_ble_is_keyboard_connected(void)
+{
+	if ((conn_status != 0) && ((report_ntf_info.ntf_conf & HID_APP_CCCD_NOTIFICATION) != 0))
+	{
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*! \fn     mini_ble_send_keyboard_report(uint8_t* report, uint16_t length)
+*   \brief  Notify a keyboard report to the connected host
+*   \param  report  The report
+*   \param  length  Report length
+*   \note   The report is copied into the characteristic value before returning: several notifications can be queued,
+*   \note   each is confirmed through hid_notification_confirmed_cb() once sent over the air
+*/
+void mini_ble_send_keyboard_report(uint8_t* report, uint16_t length)
+{
+	hid_prf_report_update(report_ntf_info.conn_handle, report_ntf_info.serv_inst, 1, report, length);
+}
+
+/*! \fn     mini_ble_task(void)
+*   \brief  Process a pending BLE event, if any
+*   \note   Doesn't block: ble_event_task() waits up to BLE_EVENT_TIMEOUT for an event, which would stall the main loop
+*/
+void mini_ble_task(void)
+{
+	if (app_exec && (at_ble_event_get(&mini_ble_event, ble_event_params, 0) == AT_BLE_SUCCESS))
+	{
+		ble_event_manager(mini_ble_event, ble_event_params);
+	}
 }
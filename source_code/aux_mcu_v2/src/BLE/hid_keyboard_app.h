@@ -51,27 +51,13 @@
 #include "stdio.h"
 
 #include "at_ble_api.h"
+#include "defines.h"
 
 /****************************************************************************************
 *							        Macros	                                     							*
 ****************************************************************************************/
-/** @brief Key pad debounce time */
-#define KEY_PAD_DEBOUNCE_TIME	(200)
-
-/** @brief Maximum text length */
-#define MAX_TEXT_LEN			(11)
-
-/** @brief Represent zero position */
-#define POSITION_ZERO			(0)
-
-/** @brief Represent six position */
-#define POSITION_SIX			(6)
-
-/** @brief Enable caps */
-#define CAPS_ON					(2)
-
-/** @brief Disable caps */
-#define CAPS_OFF				(0)
+/** @brief Notifications enabled bit of a client characteristic configuration */
+#define HID_APP_CCCD_NOTIFICATION	(0x0001)
 
 /** @brief Button event ID */
 #define APP_BUTTON_EVENT_ID		(1)
@@ -92,6 +78,8 @@ static at_ble_status_t hid_disconnect_cb(void *params);
 /** @brief Callback call during notification confirmation */
 static at_ble_status_t hid_notification_confirmed_cb(void *params);
 
+void mini_ble_send_keyboard_report(uint8_t* report, uint16_t length);
+BOOL mini_ble_is_keyboard_connected(void);
 void mini_ble_init(void);
 void mini_ble_task(void);
 
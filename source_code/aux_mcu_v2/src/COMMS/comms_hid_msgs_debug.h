@@ -24,6 +24,7 @@
 #define HID_CMD_ID_GET_ACC_32_SAMPLES       0x8008
 #define HID_CMD_ID_FLASH_AUX_MCU            0x8009
 #define HID_CMD_ID_GET_DBG_PLAT_INFO        0x800A
+#define HID_CMD_ID_DBG_TRACE                0x800E
 
 /* Prototypes */
 int16_t comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg);
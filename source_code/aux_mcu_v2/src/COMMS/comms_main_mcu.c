@@ -10,6 +10,8 @@
 #include "hid_keyboard_app.h"
 #include "comms_hid_msgs.h"
 #include "comms_main_mcu.h"
+#include "comms_trace.h"
+#include "logic_keyboard.h"
 #include "logic_battery.h"
 #include "driver_timer.h"
 #include "at_ble_api.h"
@@ -24,10 +26,23 @@
 aux_mcu_message_t main_mcu_send_message;
 /* Temporary message, used when dealing with message shorter than max size */
 volatile aux_mcu_message_t comms_main_mcu_temp_message;
-/* Flag set if we have treated a message by only looking at its first bytes */
-volatile BOOL comms_main_mcu_usb_msg_answered_using_first_bytes = FALSE;
-volatile BOOL comms_main_mcu_ble_msg_answered_using_first_bytes = FALSE;
-volatile BOOL comms_main_mcu_other_msg_answered_using_first_bytes = FALSE;
+/* Flag set if we have treated the message being received by only looking at its first bytes */
+volatile BOOL comms_main_mcu_msg_answered_using_first_bytes = FALSE;
+#ifdef AUX_LINK_CRC_ENABLED
+/* Sent messages kept for retransmission, sequence number of the next message to send */
+aux_mcu_message_t comms_main_mcu_link_tx_history[AUX_LINK_TX_HISTORY_LENGTH];
+uint16_t comms_main_mcu_link_tx_seq = 0;
+/* Sequence number of the next message we expect, set when we already asked for it */
+uint16_t comms_main_mcu_link_rx_expected_seq = 0;
+BOOL comms_main_mcu_link_nack_sent = FALSE;
+/* Retransmission request, not part of the sequenced messages */
+aux_mcu_message_t comms_main_mcu_link_nack_message;
+/* Link statistics */
+uint32_t comms_main_mcu_link_nb_crc_errors = 0;
+uint32_t comms_main_mcu_link_nb_retransmits = 0;
+/* CRC16 CCITT lookup table, one nibble at a time */
+const uint16_t comms_main_mcu_link_crc_table[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+#endif
 
 /*! \fn     comms_main_init_rx(void)
 *   \brief  Init communications with aux MCU
@@ -45,6 +60,125 @@ aux_mcu_message_t* comms_main_mcu_get_temp_tx_message_object_pt(void)
     return (aux_mcu_message_t*)&main_mcu_send_message;
 }
 
+#ifdef AUX_LINK_CRC_ENABLED
+/*! \fn     comms_main_mcu_link_compute_crc(aux_mcu_message_t* message)
+*   \brief  Compute the CRC16 CCITT of a message, link_crc excluded
+*   \param  message     Pointer to the message
+*   \return The CRC
+*/
+static uint16_t comms_main_mcu_link_compute_crc(aux_mcu_message_t* message)
+{
+    uint8_t* data_pt = (uint8_t*)message;
+    uint16_t crc = 0xFFFF;
+    
+    for (uint16_t i = 0; i < offsetof(aux_mcu_message_t, link_crc); i++)
+    {
+        crc = (crc << 4) ^ comms_main_mcu_link_crc_table[(crc >> 12) ^ (data_pt[i] >> 4)];
+        crc = (crc << 4) ^ comms_main_mcu_link_crc_table[(crc >> 12) ^ (data_pt[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/*! \fn     comms_main_mcu_link_send_nack(void)
+*   \brief  Ask the main MCU to send again the messages from the one we expect, only once per expected message
+*/
+static void comms_main_mcu_link_send_nack(void)
+{
+    if (comms_main_mcu_link_nack_sent != FALSE)
+    {
+        return;
+    }
+    comms_main_mcu_link_nack_sent = TRUE;
+    timer_start_timer(TIMER_AUX_LINK_NACK, AUX_LINK_NACK_RETRY_MS);
+    COMMS_TRACE_1(TRACE_ID_AUX_LINK_NACK, comms_main_mcu_link_rx_expected_seq);
+    
+    /* Previous request may still be being sent */
+    dma_wait_for_main_mcu_packet_sent();
+    memset((void*)&comms_main_mcu_link_nack_message, 0, sizeof(comms_main_mcu_link_nack_message));
+    comms_main_mcu_link_nack_message.message_type = AUX_MCU_MSG_TYPE_LINK_NACK;
+    comms_main_mcu_link_nack_message.payload_length1 = sizeof(comms_main_mcu_link_nack_message.link_nack_message);
+    comms_main_mcu_link_nack_message.link_nack_message.expected_seq = comms_main_mcu_link_rx_expected_seq;
+    comms_main_mcu_link_nack_message.link_crc = comms_main_mcu_link_compute_crc(&comms_main_mcu_link_nack_message);
+    dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&comms_main_mcu_link_nack_message, sizeof(comms_main_mcu_link_nack_message));
+}
+
+/*! \fn     comms_main_mcu_link_retransmit(uint16_t seq)
+*   \brief  Send again our messages, starting from a given one
+*   \param  seq     Sequence number of the first message to send again
+*   \note   Nothing is sent if that message isn't in our history anymore
+*/
+static void comms_main_mcu_link_retransmit(uint16_t seq)
+{
+    uint16_t nb_messages = comms_main_mcu_link_tx_seq - seq;
+    
+    if ((nb_messages == 0) || (nb_messages > AUX_LINK_TX_HISTORY_LENGTH))
+    {
+        return;
+    }
+    COMMS_TRACE_2(TRACE_ID_AUX_LINK_RETRANSMIT, nb_messages, seq);
+    
+    /* The function below does wait for a previous transfer to finish */
+    for (; seq != comms_main_mcu_link_tx_seq; seq++)
+    {
+        comms_main_mcu_link_nb_retransmits++;
+        dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&comms_main_mcu_link_tx_history[seq % AUX_LINK_TX_HISTORY_LENGTH], sizeof(aux_mcu_message_t));
+    }
+}
+
+/*! \fn     comms_main_mcu_link_nack_routine(void)
+*   \brief  Ask again for the message we expect when our request or the retransmission got lost or corrupted
+*/
+static void comms_main_mcu_link_nack_routine(void)
+{
+    if ((comms_main_mcu_link_nack_sent != FALSE) && (timer_has_timer_expired(TIMER_AUX_LINK_NACK, TRUE) == TIMER_EXPIRED))
+    {
+        comms_main_mcu_link_nack_sent = FALSE;
+        comms_main_mcu_link_send_nack();
+    }
+}
+
+/*! \fn     comms_main_mcu_link_accept_message(aux_mcu_message_t* message)
+*   \brief  Check a fully received message CRC and sequence number
+*   \param  message     Pointer to the message
+*   \return TRUE if the message should be dealt with
+*   \note   A corrupted or missing message triggers a retransmission request, duplicates are dropped
+*/
+static BOOL comms_main_mcu_link_accept_message(aux_mcu_message_t* message)
+{
+    /* Corrupted message */
+    if (message->link_crc != comms_main_mcu_link_compute_crc(message))
+    {
+        comms_main_mcu_link_nb_crc_errors++;
+        comms_main_mcu_link_send_nack();
+        return FALSE;
+    }
+    
+    /* Retransmission requests aren't sequenced */
+    if (message->message_type == AUX_MCU_MSG_TYPE_LINK_NACK)
+    {
+        return TRUE;
+    }
+    
+    /* Expected message, or main MCU restarted its sequence numbers */
+    int16_t seq_diff = (int16_t)(message->link_seq - comms_main_mcu_link_rx_expected_seq);
+    if ((seq_diff == 0) || (seq_diff > AUX_LINK_TX_HISTORY_LENGTH) || (seq_diff < -AUX_LINK_TX_HISTORY_LENGTH))
+    {
+        comms_main_mcu_link_rx_expected_seq = message->link_seq + 1;
+        comms_main_mcu_link_nack_sent = FALSE;
+        return TRUE;
+    }
+    
+    /* We missed a message */
+    if (seq_diff > 0)
+    {
+        comms_main_mcu_link_send_nack();
+    }
+    
+    /* Out of sequence or duplicate */
+    return FALSE;
+}
+#endif
+
 /*! \fn     comms_main_mcu_send_message(aux_mcu_message_t* message, uint16_t message_length)
 *   \brief  Send a message to the MCU
 *   \param  message         Pointer to the message to send
@@ -53,10 +187,20 @@ aux_mcu_message_t* comms_main_mcu_get_temp_tx_message_object_pt(void)
 */
 void comms_main_mcu_send_message(aux_mcu_message_t* message, uint16_t message_length)
 {
-    /* To implement here in the future: no comms check */
+    /* No comms signal is checked by comms_usb_communication_routine() before forwarding host messages */
     
+    #ifdef AUX_LINK_CRC_ENABLED
+    /* Sequence number & CRC, send from our history so the message can be sent again */
+    aux_mcu_message_t* history_pt = &comms_main_mcu_link_tx_history[comms_main_mcu_link_tx_seq % AUX_LINK_TX_HISTORY_LENGTH];
+    message->link_seq = comms_main_mcu_link_tx_seq++;
+    message->link_crc = comms_main_mcu_link_compute_crc(message);
+    dma_wait_for_main_mcu_packet_sent();
+    memcpy((void*)history_pt, (void*)message, sizeof(aux_mcu_message_t));
+    dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)history_pt, sizeof(aux_mcu_message_t));
+    #else
     /* The function below does wait for a previous transfer to finish */
     dma_main_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)message, sizeof(aux_mcu_message_t));    
+    #endif
 }
 
 /*! \fn     comms_main_mcu_deal_with_non_usb_non_ble_message(void)
@@ -73,6 +217,7 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
         memset((void*)&main_mcu_send_message, 0x00, sizeof(aux_mcu_message_t));
         main_mcu_send_message.message_type = message->message_type;
         main_mcu_send_message.payload_length1 = sizeof(aux_plat_details_message_t);
+        main_mcu_send_message.tx_reply_request_flag = message->tx_reply_request_flag;
         main_mcu_send_message.aux_details_message.aux_fw_ver_major = FW_MAJOR;
         main_mcu_send_message.aux_details_message.aux_fw_ver_minor = FW_MINOR;
         main_mcu_send_message.aux_details_message.aux_did_register = DSU->DID.reg;
@@ -119,6 +264,7 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
         memset((void*)&main_mcu_send_message, 0x00, sizeof(aux_mcu_message_t));
         main_mcu_send_message.message_type = message->message_type;
         main_mcu_send_message.payload_length1 = sizeof(nimh_charge_message_t);
+        main_mcu_send_message.tx_reply_request_flag = message->tx_reply_request_flag;
         main_mcu_send_message.nimh_charge_message.charge_status = logic_battery_get_charging_status();
         main_mcu_send_message.nimh_charge_message.battery_voltage = logic_battery_get_vbat();
         main_mcu_send_message.nimh_charge_message.charge_current = logic_battery_get_charging_current();
@@ -142,13 +288,13 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
             case MAIN_MCU_COMMAND_SLEEP:
             {
                 /* Wait for interrupt to clear this flag if set (wait for full packet receive) */
-                while (comms_main_mcu_other_msg_answered_using_first_bytes != FALSE);                
+                while (comms_main_mcu_msg_answered_using_first_bytes != FALSE);                
                 main_standby_sleep(FALSE);
                 break;
             }
             case MAIN_MCU_COMMAND_PING:
             {
-                /* Resend same message */
+                /* Resend same message, reply request flag included */
                 comms_main_mcu_send_message((void*)message, (uint16_t)sizeof(aux_mcu_message_t));
                 break;
             }
@@ -185,6 +331,11 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
             }
         }
     }
+    else if (message->message_type == AUX_MCU_MSG_TYPE_KEYBOARD_TYPE)
+    {
+        /* Start typing, status is sent back once done */
+        logic_keyboard_deal_with_type_message(message);
+    }
 }
 
 /*! \fn     comms_main_mcu_routine(void)
@@ -192,71 +343,67 @@ void comms_main_mcu_deal_with_non_usb_non_ble_message(aux_mcu_message_t* message
 */
 void comms_main_mcu_routine(void)
 {	
-    /* First: deal with fully received messages */
-    if (dma_main_mcu_usb_msg_received != FALSE)
+    aux_mcu_message_t* received_message;
+    
+    #ifdef AUX_LINK_CRC_ENABLED
+    /* Retransmission request follow up */
+    comms_main_mcu_link_nack_routine();
+    #endif
+    
+    /* First: deal with fully received messages, in reception order */
+    while (dma_main_mcu_get_received_message(&received_message) != FALSE)
     {
-        /* Set bool and do necessary action: no point in setting the bool after the function call as the dma receiver will overwrite the packet anyways */
-        dma_main_mcu_usb_msg_received = FALSE;
-        
-        if (comms_main_mcu_usb_msg_answered_using_first_bytes == FALSE)
+        COMMS_TRACE_1(TRACE_ID_MAIN_MSG_RECEIVED, received_message->message_type);
+        #ifdef AUX_LINK_CRC_ENABLED
+        if (comms_main_mcu_link_accept_message(received_message) == FALSE)
         {
-            comms_usb_send_hid_message((aux_mcu_message_t*)&dma_main_mcu_usb_rcv_message);
+            /* Corrupted, missed or duplicate message: drop it */
         }
-    }
-    if (dma_main_mcu_ble_msg_received != FALSE)
-    {
-        /* Set bool and do necessary action: no point in setting the bool after the function call as the dma receiver will overwrite the packet anyways */
-        dma_main_mcu_ble_msg_received = FALSE;
-        
-        if (comms_main_mcu_ble_msg_answered_using_first_bytes == FALSE)
+        else if (received_message->message_type == AUX_MCU_MSG_TYPE_LINK_NACK)
+        {
+            /* Main MCU didn't get some of our messages */
+            comms_main_mcu_link_retransmit(received_message->link_nack_message.expected_seq);
+        }
+        else
+        #endif
+        if (received_message->message_type == AUX_MCU_MSG_TYPE_USB)
+        {
+            comms_usb_send_hid_message(received_message);
+        }
+        else if (received_message->message_type == AUX_MCU_MSG_TYPE_BLE)
         {
             // TBD
         }
-    }
-    if (dma_main_mcu_other_msg_received != FALSE)
-    {
-        /* Set bool and do necessary action: no point in setting the bool after the function call as the dma receiver will overwrite the packet anyways */
-        dma_main_mcu_other_msg_received = FALSE;
-        
-        if (comms_main_mcu_other_msg_answered_using_first_bytes == FALSE)
+        else
         {
-            comms_main_mcu_deal_with_non_usb_non_ble_message((aux_mcu_message_t*)&dma_main_mcu_other_message);
+            comms_main_mcu_deal_with_non_usb_non_ble_message(received_message);
         }
+        
+        /* Give the slot back to the DMA receiver */
+        dma_main_mcu_release_received_message();
     }
     
-    /* Second: see if we could deal with a packet in advance */
+    /* Second: see if we could deal with the message being received in advance, not possible when its CRC covers it entirely */
+    #ifndef AUX_LINK_CRC_ENABLED
     /* Ongoing RX transfer received bytes */
-    uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(dma_main_mcu_temp_rcv_message) - dma_main_mcu_get_remaining_bytes_for_rx_transfer();
-    
-    /* Depending on the message type, set the correct bool pointers */
-    volatile BOOL* answered_with_the_first_bytes_pointer = &comms_main_mcu_other_msg_answered_using_first_bytes;
-    volatile BOOL* packet_fully_received_in_the_mean_time_pointer = &dma_main_mcu_other_msg_received;
-    if (dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_USB)
-    {
-        answered_with_the_first_bytes_pointer = &comms_main_mcu_usb_msg_answered_using_first_bytes;
-        packet_fully_received_in_the_mean_time_pointer = &dma_main_mcu_usb_msg_received;
-    } 
-    else if (dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_BLE)
-    {
-        answered_with_the_first_bytes_pointer = &comms_main_mcu_ble_msg_answered_using_first_bytes;
-        packet_fully_received_in_the_mean_time_pointer = &dma_main_mcu_ble_msg_received;
-    }
+    uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(aux_mcu_message_t) - dma_main_mcu_get_remaining_bytes_for_rx_transfer();
     
     /* Check if we should deal with this packet */    
     cpu_irq_enter_critical();
     BOOL should_deal_with_packet = FALSE;
+    volatile aux_mcu_message_t* rcv_message_pt = dma_main_mcu_cur_rcv_message_pt;
     
-    /* Conditions: received more bytes than the payload length, didn't already reply using this method, received flag didn't arrive in the mean time */
-    if ((nb_received_bytes_for_ongoing_transfer >= sizeof(dma_main_mcu_temp_rcv_message.message_type) + sizeof(dma_main_mcu_temp_rcv_message.payload_length1) + dma_main_mcu_temp_rcv_message.payload_length1) && (*answered_with_the_first_bytes_pointer == FALSE) && ((sizeof(aux_mcu_message_t) - nb_received_bytes_for_ongoing_transfer) > 20) && (*packet_fully_received_in_the_mean_time_pointer == FALSE))
+    /* Conditions: USB / BLE message as the reply request flag of the other ones is at their end, no older message waiting, received more bytes than the payload length, didn't already reply using this method, enough bytes left so the transfer doesn't complete in the mean time */
+    if (((rcv_message_pt->message_type == AUX_MCU_MSG_TYPE_USB) || (rcv_message_pt->message_type == AUX_MCU_MSG_TYPE_BLE)) && (dma_main_mcu_rcv_dma_seq == dma_main_mcu_rcv_read_seq) && (rcv_message_pt->payload_length1 != 0) && (nb_received_bytes_for_ongoing_transfer >= sizeof(rcv_message_pt->message_type) + sizeof(rcv_message_pt->payload_length1) + rcv_message_pt->payload_length1) && (comms_main_mcu_msg_answered_using_first_bytes == FALSE) && ((sizeof(aux_mcu_message_t) - nb_received_bytes_for_ongoing_transfer) > 20))
     {
         should_deal_with_packet = TRUE;
         
-        /* Set bool and do necessary action: no point in setting the bool after the function call as the dma receiver will overwrite the packet anyways */
-        *answered_with_the_first_bytes_pointer = TRUE;
+        /* Set bool so the DMA interrupt reuses the slot once the message is fully received */
+        comms_main_mcu_msg_answered_using_first_bytes = TRUE;
         
-        /* Copy message into dedicated buffer, as the message currently is in the dma temporary buffer. */
+        /* Copy message into dedicated buffer, as the message currently is being written by DMA */
         memset((void*)&comms_main_mcu_temp_message, 0, sizeof(comms_main_mcu_temp_message));
-        memcpy((void*)&comms_main_mcu_temp_message, (void*)&dma_main_mcu_temp_rcv_message, nb_received_bytes_for_ongoing_transfer);
+        memcpy((void*)&comms_main_mcu_temp_message, (void*)rcv_message_pt, nb_received_bytes_for_ongoing_transfer);
     }
     cpu_irq_leave_critical();
     
@@ -271,9 +418,6 @@ void comms_main_mcu_routine(void)
         {
             // TBD
         }
-        else
-        {
-            comms_main_mcu_deal_with_non_usb_non_ble_message((aux_mcu_message_t*)&comms_main_mcu_temp_message);  
-        }
     }
-}
\ No newline at end of file
+    #endif
+}
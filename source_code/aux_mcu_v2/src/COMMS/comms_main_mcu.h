@@ -13,9 +13,7 @@
 #include "comms_hid_msgs.h"
 
 /* Share vars */
-extern volatile BOOL comms_main_mcu_usb_msg_answered_using_first_bytes;
-extern volatile BOOL comms_main_mcu_ble_msg_answered_using_first_bytes;
-extern volatile BOOL comms_main_mcu_other_msg_answered_using_first_bytes;
+extern volatile BOOL comms_main_mcu_msg_answered_using_first_bytes;
 
 /* Defines */
 // Aux MCU Message Type
@@ -26,6 +24,8 @@ extern volatile BOOL comms_main_mcu_other_msg_answered_using_first_bytes;
 #define AUX_MCU_MSG_TYPE_MAIN_MCU_CMD   0x0004
 #define AUX_MCU_MSG_TYPE_AUX_MCU_EVENT  0x0005
 #define AUX_MCU_MSG_TYPE_NIMH_CHARGE    0x0006
+#define AUX_MCU_MSG_TYPE_LINK_NACK      0x0007
+#define AUX_MCU_MSG_TYPE_KEYBOARD_TYPE  0x0008
 
 // Main MCU commands
 #define MAIN_MCU_COMMAND_SLEEP          0x0001
@@ -37,9 +37,17 @@ extern volatile BOOL comms_main_mcu_other_msg_answered_using_first_bytes;
 // Aux MCU events
 #define AUX_MCU_EVENT_BLE_ENABLED       0x0001
 
-// Flags
+// Keyboard typing: interfaces, max number of keys in a message, status sent back once done
+#define KEYBOARD_TYPE_INTERFACE_USB     0x0000
+#define KEYBOARD_TYPE_INTERFACE_BLE     0x0001
+#define KEYBOARD_TYPE_MAX_NB_KEYS       128
+#define KEYBOARD_TYPE_STATUS_FAILED     0x0000
+#define KEYBOARD_TYPE_STATUS_TYPED      0x0001
+
+// Flags: a reply request with the tag bit set carries a transaction tag, echoed in the reply
 #define TX_NO_REPLY_REQUEST_FLAG        0x0000
 #define TX_REPLY_REQUEST_FLAG           0x0001
+#define TX_REPLY_REQUEST_TAG_FLAG       0x8000
 
 /* Typedefs */
 typedef struct
@@ -77,6 +85,26 @@ typedef struct
     int16_t charge_current;
 } nimh_charge_message_t;
 
+typedef struct  
+{
+    uint16_t expected_seq;
+} aux_link_nack_message_t;
+
+typedef struct
+{
+    uint8_t modifier;
+    uint8_t keycode;
+} keyboard_key_t;
+
+typedef struct
+{
+    uint16_t interface_identifier;
+    uint16_t delay_between_reports;
+    uint16_t typed_status;
+    uint16_t nb_keys;
+    keyboard_key_t keys[];
+} keyboard_type_message_t;
+
 typedef struct
 {
     uint16_t message_type;
@@ -88,6 +116,8 @@ typedef struct
         main_mcu_command_message_t main_mcu_command_message;
         aux_mcu_event_message_t aux_mcu_event_message;
         nimh_charge_message_t nimh_charge_message;
+        aux_link_nack_message_t link_nack_message;
+        keyboard_type_message_t keyboard_type_message;
         hid_message_t hid_message;
         uint8_t payload[AUX_MCU_MSG_PAYLOAD_LENGTH];
         uint32_t payload_as_uint32[AUX_MCU_MSG_PAYLOAD_LENGTH/4];    
@@ -98,6 +128,10 @@ typedef struct
         uint16_t rx_payload_valid_flag;
         uint16_t tx_reply_request_flag;        
     };
+    #ifdef AUX_LINK_CRC_ENABLED
+    uint16_t link_seq;
+    uint16_t link_crc;
+    #endif
 } aux_mcu_message_t;
 
 /* Prototypes */
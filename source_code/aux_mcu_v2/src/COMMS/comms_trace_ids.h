@@ -0,0 +1,29 @@
+/*!  \file     comms_trace_ids.h
+*    \brief    Trace format IDs and their format strings
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+/*  Format strings are only used by the host decoder (scripts/python_framework/trace_decoder.py), which parses this file:
+ *  add new formats at the end to keep the IDs of older ones, arguments are 32 bit words (%u, %d, %x, %c...)
+ */
+
+
+#ifndef COMMS_TRACE_IDS_H_
+#define COMMS_TRACE_IDS_H_
+
+// Source of our traces
+#define COMMS_TRACE_SOURCE  COMMS_TRACE_SOURCE_AUX_MCU
+
+#define COMMS_TRACE_FORMATS(X)                                                                  \
+    X(TRACE_ID_USB_MSG_FORWARDED,   "USB message forwarded to main MCU, %u bytes")               \
+    X(TRACE_ID_USB_PACKET_DROPPED,  "USB packet dropped, packet id %u")                          \
+    X(TRACE_ID_MAIN_MSG_RECEIVED,   "Main MCU message type 0x%04x received")                     \
+    X(TRACE_ID_AUX_LINK_NACK,       "Main link: sent NACK, expecting message %u")                \
+    X(TRACE_ID_AUX_LINK_RETRANSMIT, "Main link: sending again %u messages from message %u")      \
+    X(TRACE_ID_KEYBOARD_TYPED,      "Keyboard: %u keys typed with %u reports, status %u")
+
+#define COMMS_TRACE_ENUM_ENTRY(id, format)  id,
+typedef enum {COMMS_TRACE_FORMATS(COMMS_TRACE_ENUM_ENTRY) TRACE_NB_IDS} comms_trace_id_te;
+
+
+#endif /* COMMS_TRACE_IDS_H_ */
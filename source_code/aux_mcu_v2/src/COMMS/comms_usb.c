@@ -5,18 +5,28 @@
 */
 #include <stdarg.h>
 #include <string.h>
+#include <asf.h>
 #include "platform_defines.h"
 #include "comms_main_mcu.h"
+#include "comms_trace.h"
 #include "comms_usb.h"
+#include "platform_io.h"
 #include "defines.h"
 #include "usb.h"
 #include "dma.h"
 
-/* USB comms buffers */
-static __attribute__((aligned(4))) hid_packet_t raw_hid_recv_buffer;
-static __attribute__((aligned(4))) hid_packet_t raw_hid_send_buffer;
-/* Future message to be sent to MCU */
-aux_mcu_message_t comms_usb_temp_mcu_message_to_send;
+/* USB comms buffers: a packet is received in one receive buffer while the other one is dealt with */
+static __attribute__((aligned(4))) hid_packet_t raw_hid_recv_buffers[2];
+/* USB TX queue: packets are built in advance and sent one after the other from the USB interrupt */
+static __attribute__((aligned(4))) hid_packet_t comms_usb_tx_queue[COMMS_USB_TX_QUEUE_SIZE];
+uint16_t comms_usb_tx_queue_packet_sizes[COMMS_USB_TX_QUEUE_SIZE];
+/* Number of packets pushed in / sent from the TX queue, the packet being sent is at the read index */
+volatile uint16_t comms_usb_tx_queue_write_seq = 0;
+volatile uint16_t comms_usb_tx_queue_read_seq = 0;
+/* Messages to be sent to MCU: one is reassembled while the other one is being sent */
+aux_mcu_message_t comms_usb_mcu_messages_to_send[2];
+/* Index of the message being reassembled */
+uint16_t comms_usb_mcu_message_fill_slot = 0;
 /* Packet number we're expecting to receive */
 uint16_t comms_usb_expected_packet_number = 0;
 /* Total number of packets for current message */
@@ -25,10 +35,21 @@ uint16_t comms_usb_total_expected_packets;
 uint16_t comms_usb_temp_mcu_message_fill_index = 0;
 /* Expected flip bit state */
 BOOL comms_usb_expect_flip_bit_state_set = FALSE;
-/* Set when we received/send a USB message */
-volatile BOOL comms_usb_raw_hid_packet_received = FALSE;
-volatile BOOL comms_usb_raw_hid_packet_receive_length = 0;
+/* Set when a receive buffer holds a packet, with its length */
+volatile BOOL comms_usb_raw_hid_packet_received[2] = {FALSE, FALSE};
+volatile uint16_t comms_usb_raw_hid_packet_receive_length[2];
+#ifdef DEBUG_TRACE_ENABLED
+/* Message our trace entries are sent in */
+aux_mcu_message_t comms_usb_trace_message;
+#endif
+/* Receive buffer armed in the USB controller, receive buffer to deal with next */
+volatile uint16_t comms_usb_recv_buffer_armed_index = 0;
+uint16_t comms_usb_recv_buffer_read_index = 0;
+volatile BOOL comms_usb_recv_buffer_armed = FALSE;
+/* Set when a packet from the TX queue is being sent */
 volatile BOOL comms_usb_raw_hid_packet_being_sent = FALSE;
+/* Set once the host configured us */
+BOOL comms_usb_configured = FALSE;
 
 /* Debug vars */
 uint16_t dbg_mcu_hid_msg_sent = 0;
@@ -40,11 +61,21 @@ uint16_t dbg_mcu_hid_msg_recv = 0;
 */
 void comms_usb_raw_hid_recv_callback(uint16_t recv_bytes)
 {
+    uint16_t filled_index = comms_usb_recv_buffer_armed_index;
+    
     /* Set number of received bytes */
-    comms_usb_raw_hid_packet_receive_length = recv_bytes;
+    comms_usb_raw_hid_packet_receive_length[filled_index] = recv_bytes;
     
     /* Set flag */
-    comms_usb_raw_hid_packet_received = TRUE;
+    comms_usb_raw_hid_packet_received[filled_index] = TRUE;
+    comms_usb_recv_buffer_armed = FALSE;
+    
+    /* Keep on receiving in the other buffer if it was dealt with */
+    if (comms_usb_raw_hid_packet_received[filled_index ^ 1] == FALSE)
+    {
+        comms_usb_recv_buffer_armed_index = filled_index ^ 1;
+        comms_usb_arm_packet_receive();
+    }
 }
 
 /*! \fn     comms_usb_raw_hid_send_callback(void)
@@ -52,40 +83,110 @@ void comms_usb_raw_hid_recv_callback(uint16_t recv_bytes)
 */
 void comms_usb_raw_hid_send_callback(void)
 {
-    /* Set flag */
-    comms_usb_raw_hid_packet_being_sent = FALSE;
+    /* Packet sent, move on to the next one in the queue */
+    comms_usb_tx_queue_read_seq++;
+    if (comms_usb_tx_queue_read_seq != comms_usb_tx_queue_write_seq)
+    {
+        uint16_t queue_index = comms_usb_tx_queue_read_seq % COMMS_USB_TX_QUEUE_SIZE;
+        usb_send(USB_RAWHID_RX_ENDPOINT, (uint8_t*)&comms_usb_tx_queue[queue_index], comms_usb_tx_queue_packet_sizes[queue_index]);
+    }
+    else
+    {
+        /* Set flag */
+        comms_usb_raw_hid_packet_being_sent = FALSE;
+    }
+}
+
+/*! \fn     comms_usb_get_free_tx_packet(void)
+*   \brief  Get the next free packet in the TX queue, waiting for one to be sent if the queue is full
+*   \return Pointer to the packet to fill
+*/
+static hid_packet_t* comms_usb_get_free_tx_packet(void)
+{
+    while ((uint16_t)(comms_usb_tx_queue_write_seq - comms_usb_tx_queue_read_seq) >= COMMS_USB_TX_QUEUE_SIZE);
+    return &comms_usb_tx_queue[comms_usb_tx_queue_write_seq % COMMS_USB_TX_QUEUE_SIZE];
+}
+
+/*! \fn     comms_usb_push_tx_packet(uint16_t packet_size)
+*   \brief  Push the packet filled after comms_usb_get_free_tx_packet in the TX queue, start sending if idle
+*   \param  packet_size     Number of bytes to send
+*/
+static void comms_usb_push_tx_packet(uint16_t packet_size)
+{
+    comms_usb_tx_queue_packet_sizes[comms_usb_tx_queue_write_seq % COMMS_USB_TX_QUEUE_SIZE] = packet_size;
+    
+    cpu_irq_enter_critical();
+    comms_usb_tx_queue_write_seq++;
+    if (comms_usb_raw_hid_packet_being_sent == FALSE)
+    {
+        uint16_t queue_index = comms_usb_tx_queue_read_seq % COMMS_USB_TX_QUEUE_SIZE;
+        comms_usb_raw_hid_packet_being_sent = TRUE;
+        usb_send(USB_RAWHID_RX_ENDPOINT, (uint8_t*)&comms_usb_tx_queue[queue_index], comms_usb_tx_queue_packet_sizes[queue_index]);
+    }
+    cpu_irq_leave_critical();
 }
 
 /*! \fn     comms_usb_arm_packet_receive(void)
-*   \brief  Arm packet receive
+*   \brief  Arm packet receive in the current receive buffer
 */
 void comms_usb_arm_packet_receive(void)
 {
-    usb_recv(USB_RAWHID_TX_ENDPOINT, (uint8_t*)&raw_hid_recv_buffer, sizeof(raw_hid_recv_buffer));
+    comms_usb_recv_buffer_armed = TRUE;
+    usb_recv(USB_RAWHID_TX_ENDPOINT, (uint8_t*)&raw_hid_recv_buffers[comms_usb_recv_buffer_armed_index], sizeof(raw_hid_recv_buffers[0]));
+}
+
+/*! \fn     comms_usb_release_packet(void)
+*   \brief  Release the receive buffer we dealt with, rearm packet receive in it if reception was stopped
+*/
+static void comms_usb_release_packet(void)
+{
+    cpu_irq_enter_critical();
+    comms_usb_raw_hid_packet_received[comms_usb_recv_buffer_read_index] = FALSE;
+    if (comms_usb_recv_buffer_armed == FALSE)
+    {
+        /* Both buffers were full: the next packet goes in the one we just released */
+        comms_usb_recv_buffer_armed_index = comms_usb_recv_buffer_read_index;
+        comms_usb_arm_packet_receive();
+    }
+    comms_usb_recv_buffer_read_index ^= 1;
+    cpu_irq_leave_critical();
+}
+
+/*! \fn     comms_usb_is_configured(void)
+*   \brief  Check if the host configured us
+*   \return TRUE if configured
+*/
+BOOL comms_usb_is_configured(void)
+{
+    return comms_usb_configured;
+}
+
+/*! \fn     comms_usb_is_tx_idle(void)
+*   \brief  Check if we're configured and have nothing to send to the host
+*   \return TRUE if the TX queue is empty
+*/
+BOOL comms_usb_is_tx_idle(void)
+{
+    return ((comms_usb_configured != FALSE) && (comms_usb_tx_queue_write_seq == comms_usb_tx_queue_read_seq))? TRUE : FALSE;
 }
 
 /*! \fn     comms_usb_send_raw_hid_packet(hid_packet_t* packet, BOOL wait_send, uint16_t payload_size)
 *   \brief  send raw hid packet
-*   \param  packet          Packet to send (must be 4 bytes aligned!)
+*   \param  packet          Packet to send, copied to the TX queue
 *   \param  wait_send       Set to wait for end of packet transmission
 *   \param  payload_size    Payload size
 */
 void comms_usb_send_raw_hid_packet(hid_packet_t* packet, BOOL wait_send, uint16_t payload_size)
 {
-    /* Wait for possible previous packet to be sent */
-    while(comms_usb_raw_hid_packet_being_sent == TRUE);
-    
-    /* Reset flag */
-    comms_usb_raw_hid_packet_being_sent = TRUE;
-    
     /* Check payload size parameter */
     if (payload_size > sizeof(hid_packet_t))
     {
         payload_size = sizeof(hid_packet_t);
     }
     
-    /* Send packet */
-    usb_send(USB_RAWHID_RX_ENDPOINT, (uint8_t*)packet, payload_size);
+    /* Queue packet */
+    memcpy((void*)comms_usb_get_free_tx_packet(), (void*)packet, payload_size);
+    comms_usb_push_tx_packet(payload_size);
     
     /* If asked, wait */
     if (wait_send != FALSE)
@@ -97,56 +198,76 @@ void comms_usb_send_raw_hid_packet(hid_packet_t* packet, BOOL wait_send, uint16_
 /*! \fn     comms_usb_send_hid_message(aux_mcu_message_t* message)
 *   \brief  send HID message to PC
 *   \param  message     Message to send
+*   \note   Packets are built in the TX queue and sent from the USB interrupt: message can be reused once this function returns
 */
 void comms_usb_send_hid_message(aux_mcu_message_t* message)
 {
     dbg_mcu_hid_msg_recv++;
-    uint8_t total_number_of_packets = ((message->payload_length1 + sizeof(raw_hid_send_buffer.payload) - 1)/sizeof(raw_hid_send_buffer.payload))-1;
+    uint8_t total_number_of_packets = ((message->payload_length1 + sizeof(comms_usb_tx_queue[0].payload) - 1)/sizeof(comms_usb_tx_queue[0].payload))-1;
     uint16_t remaining_payload_to_send = message->payload_length1;
     uint16_t payload_offset = 0;
     uint8_t packet_id = 0;
     
-    /* Generate and send packets */
+    /* Generate and queue packets */
     while(remaining_payload_to_send > 0)
     {
-        /* Wait for a possible previous packet to be sent as we do buffer re-use */
-        while(comms_usb_raw_hid_packet_being_sent == TRUE);
-        
-        /* Generate packet */
-        memset((void*)&raw_hid_send_buffer, 0, sizeof(raw_hid_send_buffer));
-        raw_hid_send_buffer.byte1.total_packets = total_number_of_packets;
-        raw_hid_send_buffer.byte1.packet_id = packet_id;
+        /* Next free packet in the queue */
+        hid_packet_t* packet_pt = comms_usb_get_free_tx_packet();
+        uint16_t payload_len = sizeof(packet_pt->payload);
         
         /* We do not care about the flip bit */
-        if (remaining_payload_to_send > sizeof(raw_hid_send_buffer.payload))
+        if (remaining_payload_to_send < sizeof(packet_pt->payload))
         {
-            raw_hid_send_buffer.byte0.payload_len = sizeof(raw_hid_send_buffer.payload);
-        }
-        else
-        {
-            raw_hid_send_buffer.byte0.payload_len = remaining_payload_to_send;            
+            payload_len = remaining_payload_to_send;
         }
+        packet_pt->byte0.payload_len = payload_len;
+        packet_pt->byte0.ack_flag_or_req = 0;
+        packet_pt->byte0.flip_bit = 0;
+        packet_pt->byte1.total_packets = total_number_of_packets;
+        packet_pt->byte1.packet_id = packet_id;
         
         /* Copy payload */
-        memcpy(raw_hid_send_buffer.payload, &(message->payload[payload_offset]), raw_hid_send_buffer.byte0.payload_len);
+        memcpy(packet_pt->payload, &(message->payload[payload_offset]), payload_len);
         
-        /* 0-fill padding */
-        uint16_t padding_length = sizeof(raw_hid_send_buffer.payload) - raw_hid_send_buffer.byte0.payload_len;
-        if (padding_length != 0)
+        /* 0-fill padding, only for the last packet */
+        if (payload_len != sizeof(packet_pt->payload))
         {
-            memset((void*)(&raw_hid_send_buffer.payload[raw_hid_send_buffer.byte0.payload_len]), 0x00, padding_length);
+            memset((void*)(&packet_pt->payload[payload_len]), 0x00, sizeof(packet_pt->payload) - payload_len);
         }
         
         /* update local vars */
-        remaining_payload_to_send -= raw_hid_send_buffer.byte0.payload_len;
-        payload_offset += raw_hid_send_buffer.byte0.payload_len;
+        remaining_payload_to_send -= payload_len;
+        payload_offset += payload_len;
         packet_id += 1;
         
-        /* Send packet: always send 64B due to some strange windows receive trigger thingy */
-        //comms_usb_send_raw_hid_packet(&raw_hid_send_buffer, TRUE, sizeof(raw_hid_send_buffer.byte0) + sizeof(raw_hid_send_buffer.byte1) + raw_hid_send_buffer.byte0.payload_len);
-        comms_usb_send_raw_hid_packet(&raw_hid_send_buffer, TRUE, USB_RAWHID_RX_SIZE);
+        /* Queue packet: always send 64B due to some strange windows receive trigger thingy */
+        comms_usb_push_tx_packet(USB_RAWHID_RX_SIZE);
+    }
+}
+
+#ifdef DEBUG_TRACE_ENABLED
+/*! \fn     comms_trace_get_hid_message(void)
+*   \brief  Get the HID message to write trace entries in
+*   \return 0 if the TX queue isn't empty
+*/
+hid_message_t* comms_trace_get_hid_message(void)
+{
+    if (comms_usb_is_tx_idle() == FALSE)
+    {
+        return 0;
     }
+    return &comms_usb_trace_message.hid_message;
+}
+
+/*! \fn     comms_trace_send_hid_message(void)
+*   \brief  Send the trace HID message, packets are copied to the TX queue
+*/
+void comms_trace_send_hid_message(void)
+{
+    comms_usb_trace_message.payload_length1 = comms_usb_trace_message.hid_message.payload_length + sizeof(comms_usb_trace_message.hid_message.payload_length) + sizeof(comms_usb_trace_message.hid_message.message_type);
+    comms_usb_send_hid_message(&comms_usb_trace_message);
 }
+#endif
 
 /*! \fn     comms_usb_configuration_callback(int config)
 *   \brief  Called when device is configured, initialize USB comms
@@ -157,9 +278,21 @@ void comms_usb_configuration_callback(int config)
     (void)config;
     
     /* Reset global vars */
+    comms_usb_configured = TRUE;
     comms_usb_expect_flip_bit_state_set = FALSE;
     comms_usb_temp_mcu_message_fill_index = 0;
     comms_usb_expected_packet_number = 0;
+    comms_usb_raw_hid_packet_received[0] = FALSE;
+    comms_usb_raw_hid_packet_received[1] = FALSE;
+    comms_usb_recv_buffer_armed_index = 0;
+    comms_usb_recv_buffer_read_index = 0;
+    
+    /* Flush the TX queue */
+    cpu_irq_enter_critical();
+    comms_usb_tx_queue_write_seq = 0;
+    comms_usb_tx_queue_read_seq = 0;
+    comms_usb_raw_hid_packet_being_sent = FALSE;
+    cpu_irq_leave_critical();
     
     /* Start receiving raw HID packets */
     comms_usb_arm_packet_receive();
@@ -170,70 +303,79 @@ void comms_usb_configuration_callback(int config)
 */
 void comms_usb_communication_routine(void)
 {
+    /* Main MCU asks us to hold its messages: leave packets in our buffers, the USB controller will NAK the host once they're full */
+    if (platform_io_is_no_comms_asserted() != FALSE)
+    {
+        return;
+    }
+    
     /* Did we receive a packet? */
-    if (comms_usb_raw_hid_packet_received != FALSE)
+    if (comms_usb_raw_hid_packet_received[comms_usb_recv_buffer_read_index] != FALSE)
     {
-        /* Reset flag */
-        comms_usb_raw_hid_packet_received = FALSE;
+        /* Oldest received packet, message being reassembled */
+        hid_packet_t* raw_hid_recv_buffer_pt = &raw_hid_recv_buffers[comms_usb_recv_buffer_read_index];
+        aux_mcu_message_t* mcu_message_pt = &comms_usb_mcu_messages_to_send[comms_usb_mcu_message_fill_slot];
         
         /* Special case: first two bytes set to 0xFF 0xFF, reset flip bit */
-        uint8_t* usb_recast = (uint8_t*)&raw_hid_recv_buffer;
+        uint8_t* usb_recast = (uint8_t*)raw_hid_recv_buffer_pt;
         if ((usb_recast[0] == 0xFF) && (usb_recast[1] == 0xFF))
         {
             comms_usb_expect_flip_bit_state_set = FALSE;
             comms_usb_temp_mcu_message_fill_index = 0;
             comms_usb_expected_packet_number = 0;
-            comms_usb_arm_packet_receive();
+            comms_usb_release_packet();
             return;
         }        
         
         /* Check for bit flip state: if it doesn't match, reset fill indexes */
-        if (((comms_usb_expect_flip_bit_state_set != FALSE) && (raw_hid_recv_buffer.byte0.flip_bit == 0)) || ((comms_usb_expect_flip_bit_state_set == FALSE) && (raw_hid_recv_buffer.byte0.flip_bit != 0)))
+        if (((comms_usb_expect_flip_bit_state_set != FALSE) && (raw_hid_recv_buffer_pt->byte0.flip_bit == 0)) || ((comms_usb_expect_flip_bit_state_set == FALSE) && (raw_hid_recv_buffer_pt->byte0.flip_bit != 0)))
         {
+            COMMS_TRACE_1(TRACE_ID_USB_PACKET_DROPPED, raw_hid_recv_buffer_pt->byte1.packet_id);
             comms_usb_temp_mcu_message_fill_index = 0;
             comms_usb_expected_packet_number = 0;
-            comms_usb_arm_packet_receive();
+            comms_usb_release_packet();
             return;
         }
         
         /* Check for expected packet number */
-        if ((comms_usb_expected_packet_number != 0) && (raw_hid_recv_buffer.byte1.packet_id != comms_usb_expected_packet_number))
+        if ((comms_usb_expected_packet_number != 0) && (raw_hid_recv_buffer_pt->byte1.packet_id != comms_usb_expected_packet_number))
         {
+            COMMS_TRACE_1(TRACE_ID_USB_PACKET_DROPPED, raw_hid_recv_buffer_pt->byte1.packet_id);
             comms_usb_temp_mcu_message_fill_index = 0;
             comms_usb_expected_packet_number = 0;
-            comms_usb_arm_packet_receive();
+            comms_usb_release_packet();
             return;            
         }
         
         /* If first packet, store total number of packets for this hid message */
-        if (raw_hid_recv_buffer.byte1.packet_id == 0)
+        if (raw_hid_recv_buffer_pt->byte1.packet_id == 0)
         {
-            comms_usb_total_expected_packets = raw_hid_recv_buffer.byte1.total_packets;
+            comms_usb_total_expected_packets = raw_hid_recv_buffer_pt->byte1.total_packets;
             
             /* Reset index to fill temp message payload */
             comms_usb_temp_mcu_message_fill_index = 0;
             
-            /* Prepare future packet to send to main MCU */
-            memset((void*)&comms_usb_temp_mcu_message_to_send, 0, sizeof(comms_usb_temp_mcu_message_to_send));
-            comms_usb_temp_mcu_message_to_send.message_type = AUX_MCU_MSG_TYPE_USB;
+            /* Prepare future packet to send to main MCU: DMA is done sending this slot as the other one was sent after it */
+            memset((void*)mcu_message_pt, 0, sizeof(*mcu_message_pt));
+            mcu_message_pt->message_type = AUX_MCU_MSG_TYPE_USB;
         }
         
         /* Check for overflow tentative */
-        if ((size_t)(comms_usb_temp_mcu_message_fill_index + raw_hid_recv_buffer.byte0.payload_len) > sizeof(comms_usb_temp_mcu_message_to_send.payload))
+        if ((size_t)(comms_usb_temp_mcu_message_fill_index + raw_hid_recv_buffer_pt->byte0.payload_len) > sizeof(mcu_message_pt->payload))
         {
             comms_usb_temp_mcu_message_fill_index = 0;
             comms_usb_expected_packet_number = 0;
-            comms_usb_arm_packet_receive();
+            comms_usb_release_packet();
             return;
         }
         
-        /* Fill temp mcu message payload */
-        memcpy((void*)&comms_usb_temp_mcu_message_to_send.payload[comms_usb_temp_mcu_message_fill_index], (void*)raw_hid_recv_buffer.payload, raw_hid_recv_buffer.byte0.payload_len);
-        comms_usb_temp_mcu_message_fill_index += raw_hid_recv_buffer.byte0.payload_len;
+        /* Fill mcu message payload */
+        memcpy((void*)&mcu_message_pt->payload[comms_usb_temp_mcu_message_fill_index], (void*)raw_hid_recv_buffer_pt->payload, raw_hid_recv_buffer_pt->byte0.payload_len);
+        comms_usb_temp_mcu_message_fill_index += raw_hid_recv_buffer_pt->byte0.payload_len;
         comms_usb_expected_packet_number++;
         
         /* Check for last message */
-        if (raw_hid_recv_buffer.byte1.packet_id == comms_usb_total_expected_packets)
+        if (raw_hid_recv_buffer_pt->byte1.packet_id == comms_usb_total_expected_packets)
         {
             /* Switch flip bit */
             if (comms_usb_expect_flip_bit_state_set == FALSE)
@@ -246,17 +388,18 @@ void comms_usb_communication_routine(void)
             }
             
             /* If ack is requested from host */
-            if (raw_hid_recv_buffer.byte0.ack_flag_or_req != 0)
+            if (raw_hid_recv_buffer_pt->byte0.ack_flag_or_req != 0)
             {
                 /* Send the same message */
-                memcpy((void*)&raw_hid_send_buffer, (void*)&raw_hid_recv_buffer, sizeof(raw_hid_send_buffer));
-                comms_usb_send_raw_hid_packet(&raw_hid_send_buffer, TRUE, comms_usb_raw_hid_packet_receive_length);
+                comms_usb_send_raw_hid_packet(raw_hid_recv_buffer_pt, FALSE, comms_usb_raw_hid_packet_receive_length[comms_usb_recv_buffer_read_index]);
             }
             
-            /* Prepare and send message to main MCU */
-            comms_usb_temp_mcu_message_to_send.payload_length1 = comms_usb_temp_mcu_message_fill_index;
-            comms_main_mcu_send_message(&comms_usb_temp_mcu_message_to_send, (uint16_t)sizeof(comms_usb_temp_mcu_message_to_send));
-            comms_usb_arm_packet_receive();
+            /* Prepare and send message to main MCU, next message is reassembled in the other slot while this one is sent */
+            mcu_message_pt->payload_length1 = comms_usb_temp_mcu_message_fill_index;
+            COMMS_TRACE_1(TRACE_ID_USB_MSG_FORWARDED, comms_usb_temp_mcu_message_fill_index);
+            comms_main_mcu_send_message(mcu_message_pt, (uint16_t)sizeof(*mcu_message_pt));
+            comms_usb_mcu_message_fill_slot ^= 1;
+            comms_usb_release_packet();
             dbg_mcu_hid_msg_sent++;
             
             /* Reset vars */            
@@ -265,8 +408,8 @@ void comms_usb_communication_routine(void)
         }
         else
         {
-            /* here we should implement in the future transfers in multiple chunks */
-            comms_usb_arm_packet_receive();
+            /* Wait for the next packet of this message, longer transfers are streamed as several messages (see comms_stream on the main MCU) */
+            comms_usb_release_packet();
         }
     }
 }
@@ -291,21 +434,22 @@ void comms_usb_debug_printf(const char *fmt, ...)
         /* Compute number of chars printed to our buffer */
         uint16_t actual_printed_chars = (uint16_t)hypothetical_nb_chars < sizeof(buf)-1? (uint16_t)hypothetical_nb_chars : sizeof(buf)-1;
         
-        /* Use message to send to aux mcu as temporary buffer */
+        /* Use the message slot not being reassembled as temporary buffer, once it is sent */
+        aux_mcu_message_t* comms_usb_temp_mcu_message_pt = &comms_usb_mcu_messages_to_send[comms_usb_mcu_message_fill_slot ^ 1];
         dma_wait_for_main_mcu_packet_sent();
-        memset((void*)&comms_usb_temp_mcu_message_to_send, 0, sizeof(comms_usb_temp_mcu_message_to_send));
-        comms_usb_temp_mcu_message_to_send.hid_message.message_type = HID_CMD_ID_DEBUG_MSG;
-        comms_usb_temp_mcu_message_to_send.hid_message.payload_length = actual_printed_chars*2 + 2;
-        comms_usb_temp_mcu_message_to_send.payload_length1 = comms_usb_temp_mcu_message_to_send.hid_message.payload_length + sizeof(comms_usb_temp_mcu_message_to_send.hid_message.payload_length) + sizeof(comms_usb_temp_mcu_message_to_send.hid_message.message_type);
+        memset((void*)comms_usb_temp_mcu_message_pt, 0, sizeof(*comms_usb_temp_mcu_message_pt));
+        comms_usb_temp_mcu_message_pt->hid_message.message_type = HID_CMD_ID_DEBUG_MSG;
+        comms_usb_temp_mcu_message_pt->hid_message.payload_length = actual_printed_chars*2 + 2;
+        comms_usb_temp_mcu_message_pt->payload_length1 = comms_usb_temp_mcu_message_pt->hid_message.payload_length + sizeof(comms_usb_temp_mcu_message_pt->hid_message.payload_length) + sizeof(comms_usb_temp_mcu_message_pt->hid_message.message_type);
         
         /* Copy to message payload */
         for (uint16_t i = 0; i < actual_printed_chars; i++)
         {
-            comms_usb_temp_mcu_message_to_send.hid_message.payload_as_uint16[i] = buf[i];
+            comms_usb_temp_mcu_message_pt->hid_message.payload_as_uint16[i] = buf[i];
         }
         
         /* Send message */
-        comms_usb_send_hid_message(&comms_usb_temp_mcu_message_to_send);
+        comms_usb_send_hid_message(comms_usb_temp_mcu_message_pt);
     }
     va_end(ap);
 }
@@ -12,6 +12,13 @@
 #include "defines.h"
 #include "comms_main_mcu.h"
 
+/* Defines */
+// Number of packets in the USB TX queue, power of 2
+#define COMMS_USB_TX_QUEUE_SIZE     8
+#if (COMMS_USB_TX_QUEUE_SIZE & (COMMS_USB_TX_QUEUE_SIZE - 1)) != 0
+    #error "COMMS_USB_TX_QUEUE_SIZE must be a power of 2"
+#endif
+
 /* Type defs */
 typedef struct
 {
@@ -38,6 +45,8 @@ void comms_usb_configuration_callback(int config);
 void comms_usb_raw_hid_send_callback(void);
 void comms_usb_communication_routine(void);
 void comms_usb_arm_packet_receive(void);
+BOOL comms_usb_is_tx_idle(void);
+BOOL comms_usb_is_configured(void);
 
 
 #endif /* COMMS_USB_H_ */
\ No newline at end of file
@@ -23,15 +23,17 @@ DmacDescriptor dma_descriptors[7] __attribute__ ((aligned (16)));
 volatile BOOL dma_aux_mcu_packet_received = FALSE;
 /* Boolean to specify if we sent a packet to main MCU */
 volatile BOOL dma_main_mcu_packet_sent = TRUE;
+/* Ring of messages filled back to back by DMA */
+volatile aux_mcu_message_t dma_main_mcu_rcv_messages[DMA_MAIN_MCU_RX_NB_SLOTS];
+/* Message received while all ring slots are in use: dropped */
+volatile aux_mcu_message_t dma_main_mcu_overflow_rcv_message;
 /* Message we're currently receiving through DMA */
-volatile aux_mcu_message_t dma_main_mcu_temp_rcv_message;
-volatile aux_mcu_message_t dma_main_mcu_usb_rcv_message;
-volatile aux_mcu_message_t dma_main_mcu_ble_rcv_message;
-volatile aux_mcu_message_t dma_main_mcu_other_message;
-/* Message received flags */
-volatile BOOL dma_main_mcu_usb_msg_received = FALSE;
-volatile BOOL dma_main_mcu_ble_msg_received = FALSE;
-volatile BOOL dma_main_mcu_other_msg_received = FALSE;
+volatile aux_mcu_message_t* dma_main_mcu_cur_rcv_message_pt = &dma_main_mcu_rcv_messages[0];
+/* Sequence number of the slot being filled by DMA, and of the oldest slot not released yet */
+volatile uint16_t dma_main_mcu_rcv_dma_seq = 0;
+volatile uint16_t dma_main_mcu_rcv_read_seq = 0;
+/* Number of messages dropped because the ring was full */
+volatile uint16_t dma_main_mcu_nb_rcv_overflows = 0;
 
 /*! \fn     DMAC_Handler(void)
 *   \brief  Function called by interrupt when RX is done
@@ -46,54 +48,27 @@ void DMAC_Handler(void)
         dma_aux_mcu_packet_received = TRUE;
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
         
-        /* Arm next transfer: leave this here! */
-        dma_main_mcu_init_rx_transfer();        
+        /* Check if received message has already been dealt with using its first bytes: its slot can then be reused */
+        #ifndef BOOTLOADER
+        BOOL message_already_dealt_with = comms_main_mcu_msg_answered_using_first_bytes;
+        comms_main_mcu_msg_answered_using_first_bytes = FALSE;
+        #else
+        BOOL message_already_dealt_with = FALSE;
+        #endif
         
-        #ifndef BOOTLOADER        
-        /* Depending on message received, copy to the right rcv buffer and set flag */
-        if (dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_USB)
+        if (dma_main_mcu_cur_rcv_message_pt == &dma_main_mcu_overflow_rcv_message)
         {
-            memcpy((void*)&dma_main_mcu_usb_rcv_message, (void*)&dma_main_mcu_temp_rcv_message, sizeof(dma_main_mcu_temp_rcv_message));
-            /* Check if received message has already been dealt with, do not set received flag if so */
-            if (comms_main_mcu_usb_msg_answered_using_first_bytes != FALSE)
-            {
-                comms_main_mcu_usb_msg_answered_using_first_bytes = FALSE;
-            } 
-            else
-            {
-                dma_main_mcu_usb_msg_received = TRUE;
-            }
+            /* No slot was available for that message */
+            dma_main_mcu_nb_rcv_overflows++;
         }
-        else if (dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_BLE)
+        else if (message_already_dealt_with == FALSE)
         {
-            memcpy((void*)&dma_main_mcu_ble_rcv_message, (void*)&dma_main_mcu_temp_rcv_message, sizeof(dma_main_mcu_temp_rcv_message));
-            /* Check if received message has already been dealt with, do not set received flag if so */
-            if (comms_main_mcu_ble_msg_answered_using_first_bytes != FALSE)
-            {
-                comms_main_mcu_ble_msg_answered_using_first_bytes = FALSE;
-            }
-            else
-            {
-                dma_main_mcu_ble_msg_received = TRUE;
-            }
+            /* Hand the slot over to the main routine */
+            dma_main_mcu_rcv_dma_seq++;
         }
-        else
-        {
-            memcpy((void*)&dma_main_mcu_other_message, (void*)&dma_main_mcu_temp_rcv_message, sizeof(dma_main_mcu_temp_rcv_message));
-            /* Check if received message has already been dealt with, do not set received flag if so */
-            if (comms_main_mcu_other_msg_answered_using_first_bytes != FALSE)
-            {
-                comms_main_mcu_other_msg_answered_using_first_bytes = FALSE;
-            }
-            else
-            {
-                dma_main_mcu_other_msg_received = TRUE;
-            }    
-        }
-        #else
-            /* Bootloader: we're only receiving other messages :D */
-            dma_main_mcu_other_msg_received = TRUE;
-        #endif
+        
+        /* Arm next transfer in the next free slot: leave this here! */
+        dma_main_mcu_init_rx_transfer();
     }
     
     /* MAIN MCU TX routine */
@@ -223,6 +198,42 @@ BOOL dma_main_mcu_check_and_clear_dma_transfer_flag(void)
     return FALSE;
 }
 
+/*! \fn     dma_main_mcu_get_received_message(aux_mcu_message_t** message_pt_pt)
+*   \brief  Get the oldest fully received message from main MCU
+*   \param  message_pt_pt   Pointer to where to store the message pointer
+*   \return TRUE if a message was received
+*   \note   Message slot is only reused by DMA once dma_main_mcu_release_received_message() is called
+*/
+BOOL dma_main_mcu_get_received_message(aux_mcu_message_t** message_pt_pt)
+{
+    /* Read seq is only modified by us, dma seq only increases */
+    if (dma_main_mcu_rcv_dma_seq == dma_main_mcu_rcv_read_seq)
+    {
+        return FALSE;
+    }
+    *message_pt_pt = (aux_mcu_message_t*)&dma_main_mcu_rcv_messages[dma_main_mcu_rcv_read_seq % DMA_MAIN_MCU_RX_NB_SLOTS];
+    return TRUE;
+}
+
+/*! \fn     dma_main_mcu_release_received_message(void)
+*   \brief  Release the oldest fully received message, so DMA can use its slot again
+*/
+void dma_main_mcu_release_received_message(void)
+{
+    /* Disable IRQs */
+    __disable_irq();
+    __DMB();
+    
+    if (dma_main_mcu_rcv_dma_seq != dma_main_mcu_rcv_read_seq)
+    {
+        dma_main_mcu_rcv_read_seq++;
+    }
+    
+    /* Re-enable IRQs */
+    __DMB();
+    __enable_irq();
+}
+
 /*! \fn     dma_main_mcu_init_tx_transfer(void* spi_data_p, void* datap, uint16_t size)
 *   \brief  Initialize a DMA transfer to the AUX MCU
 *   \param  spi_data_p  Pointer to the SPI data register
@@ -289,15 +300,29 @@ void dma_main_mcu_disable_transfer(void)
 }
 
 /*! \fn     dma_main_mcu_init_rx_transfer(void)
-*   \brief  Initialize a DMA transfer from the main MCU
+*   \brief  Initialize a DMA transfer from the main MCU, in the next free ring slot
 *   \note   We are not disabling IRQs as this is called from an IRQ
+*   \note   When all slots are in use the message is received in a dedicated buffer and dropped, so we stay in sync with the message boundaries
 */
 void dma_main_mcu_init_rx_transfer(void)
 {
+    /* Select target: next slot if the main routine released it */
+    if ((uint16_t)(dma_main_mcu_rcv_dma_seq - dma_main_mcu_rcv_read_seq) < DMA_MAIN_MCU_RX_NB_SLOTS)
+    {
+        dma_main_mcu_cur_rcv_message_pt = &dma_main_mcu_rcv_messages[dma_main_mcu_rcv_dma_seq % DMA_MAIN_MCU_RX_NB_SLOTS];
+    } 
+    else
+    {
+        dma_main_mcu_cur_rcv_message_pt = &dma_main_mcu_overflow_rcv_message;
+    }
+    
+    /* Stale payload length from a previous message mustn't be used for early answers */
+    dma_main_mcu_cur_rcv_message_pt->payload_length1 = 0;
+    
     /* Setup transfer size */
-    dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)sizeof(dma_main_mcu_temp_rcv_message);
+    dma_descriptors[DMA_DESCID_RX_COMMS].BTCNT.bit.BTCNT = (uint16_t)sizeof(aux_mcu_message_t);
     /* Source address: DATA register from SPI */
-    dma_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg = (uint32_t)(&dma_main_mcu_temp_rcv_message) + sizeof(dma_main_mcu_temp_rcv_message);
+    dma_descriptors[DMA_DESCID_RX_COMMS].DSTADDR.reg = (uint32_t)dma_main_mcu_cur_rcv_message_pt + sizeof(aux_mcu_message_t);
     /* Destination address: given value */
     dma_descriptors[DMA_DESCID_RX_COMMS].SRCADDR.reg = (uint32_t)((void*)&AUXMCU_SERCOM->USART.DATA.reg);
     
@@ -13,21 +13,27 @@
 #include "comms_main_mcu.h"
 #include "defines.h"
 
+/* Defines */
+// Number of messages from main MCU that can be queued, must be a power of 2
+#define DMA_MAIN_MCU_RX_NB_SLOTS    4
+#if (DMA_MAIN_MCU_RX_NB_SLOTS & (DMA_MAIN_MCU_RX_NB_SLOTS - 1)) != 0
+    #error "DMA_MAIN_MCU_RX_NB_SLOTS must be a power of 2"
+#endif
+
 /* Global vars */
-extern volatile aux_mcu_message_t dma_main_mcu_temp_rcv_message;
-extern volatile aux_mcu_message_t dma_main_mcu_usb_rcv_message;
-extern volatile aux_mcu_message_t dma_main_mcu_ble_rcv_message;
-extern volatile aux_mcu_message_t dma_main_mcu_other_message;
-extern volatile BOOL dma_main_mcu_other_msg_received;
-extern volatile BOOL dma_main_mcu_usb_msg_received;
-extern volatile BOOL dma_main_mcu_ble_msg_received;
+extern volatile aux_mcu_message_t* dma_main_mcu_cur_rcv_message_pt;
+extern volatile uint16_t dma_main_mcu_nb_rcv_overflows;
+extern volatile uint16_t dma_main_mcu_rcv_read_seq;
+extern volatile uint16_t dma_main_mcu_rcv_dma_seq;
 
 /* Prototypes */
+BOOL dma_main_mcu_get_received_message(aux_mcu_message_t** message_pt_pt);
 void dma_main_mcu_init_tx_transfer(void* spi_data_p, void* datap, uint16_t size);
 uint16_t dma_main_mcu_get_remaining_bytes_for_rx_transfer(void);
 BOOL dma_main_mcu_check_and_clear_dma_transfer_flag(void);
 void dma_wait_for_main_mcu_packet_sent(void);
 void dma_main_mcu_init_rx_transfer(void);
+void dma_main_mcu_release_received_message(void);
 void dma_main_mcu_disable_transfer(void);
 void dma_init(void);
 
@@ -0,0 +1,338 @@
+/*!  \file     logic_keyboard.c
+*    \brief    Keyboard typing engine: key sequences to HID keyboard reports
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include <asf.h>
+#include "platform_defines.h"
+#include "hid_keyboard_app.h"
+#include "logic_keyboard.h"
+#include "comms_main_mcu.h"
+#include "driver_timer.h"
+#include "comms_trace.h"
+#include "comms_usb.h"
+#include "defines.h"
+#include "logic.h"
+#include "usb.h"
+#include "dma.h"
+/* Reports to send for the current typing request */
+static __attribute__((aligned(4))) keyboard_report_t logic_keyboard_reports[LOGIC_KEYBOARD_REPORT_QUEUE_SIZE];
+/* Nothing pressed, sent when typing is aborted */
+static __attribute__((aligned(4))) keyboard_report_t logic_keyboard_release_report;
+uint16_t logic_keyboard_nb_reports = 0;
+uint16_t logic_keyboard_nb_keys = 0;
+/* Interface we're typing on, reply request flag of the typing request, echoed with its status */
+uint16_t logic_keyboard_interface = KEYBOARD_TYPE_INTERFACE_USB;
+uint16_t logic_keyboard_reply_request_flag = TX_NO_REPLY_REQUEST_FLAG;
+/* Index of the report being sent, reports are sent from the endpoint interrupt (USB) or queued by the routine (BLE) */
+volatile uint16_t logic_keyboard_report_index = 0;
+/* BLE: number of notifications not confirmed yet, number of reports sent over the air, set when a notification failed */
+uint16_t logic_keyboard_ble_nb_in_flight = 0;
+uint16_t logic_keyboard_ble_nb_confirmed = 0;
+BOOL logic_keyboard_ble_notification_failed = FALSE;
+/* Delay between reports in ms, 0 to send a report per USB frame */
+uint16_t logic_keyboard_delay_between_reports = 0;
+/* Set by the endpoint interrupt when the next report waits for the delay to be elapsed */
+volatile BOOL logic_keyboard_report_delayed = FALSE;
+/* Systick at which the last report was sent */
+volatile uint32_t logic_keyboard_last_report_systick = 0;
+/* Set while typing */
+volatile BOOL logic_keyboard_typing = FALSE;
+
+
+/*! \fn     logic_keyboard_build_reports(keyboard_key_t* keys, uint16_t nb_keys, keyboard_report_t* reports, uint16_t max_nb_reports)
+*   \brief  Build the HID keyboard reports to type a key sequence
+*   \param  keys            Keys to type, with their modifier byte
+*   \param  nb_keys         Number of keys
+*   \param  reports         Where to store the reports
+*   \param  max_nb_reports  Max number of reports that can be stored
+*   \return Number of reports, 0 if they don't fit
+*   \note   Keys are pressed one per report and only released when needed: when a key is pressed again, when the report is full
+*   \note   or when the modifier byte changes. A modifier change is sent with the key press that needs it, once other keys are released
+*/
+uint16_t logic_keyboard_build_reports(keyboard_key_t* keys, uint16_t nb_keys, keyboard_report_t* reports, uint16_t max_nb_reports)
+{
+    keyboard_report_t current_report;
+    uint16_t nb_pressed_keys = 0;
+    uint16_t nb_reports = 0;
+    
+    /* Nothing pressed */
+    memset((void*)&current_report, 0x00, sizeof(current_report));
+    
+    for (uint16_t i = 0; i < nb_keys; i++)
+    {
+        BOOL key_already_pressed = FALSE;
+        
+        /* Is this key already pressed? */
+        for (uint16_t j = 0; j < nb_pressed_keys; j++)
+        {
+            if (current_report.keys[j] == keys[i].keycode)
+            {
+                key_already_pressed = TRUE;
+            }
+        }
+        
+        /* Release the pressed keys if needed */
+        if ((key_already_pressed != FALSE) || (nb_pressed_keys == LOGIC_KEYBOARD_REPORT_NB_KEYS) || ((nb_pressed_keys != 0) && (keys[i].modifier != current_report.modifier)))
+        {
+            if (nb_reports == max_nb_reports)
+            {
+                return 0;
+            }
+            memset((void*)current_report.keys, 0x00, sizeof(current_report.keys));
+            reports[nb_reports++] = current_report;
+            nb_pressed_keys = 0;
+        }
+        
+        /* Press key */
+        if (nb_reports == max_nb_reports)
+        {
+            return 0;
+        }
+        current_report.modifier = keys[i].modifier;
+        current_report.keys[nb_pressed_keys++] = keys[i].keycode;
+        reports[nb_reports++] = current_report;
+    }
+    
+    /* Release everything */
+    if (nb_reports != 0)
+    {
+        if (nb_reports == max_nb_reports)
+        {
+            return 0;
+        }
+        memset((void*)&current_report, 0x00, sizeof(current_report));
+        reports[nb_reports++] = current_report;
+    }
+    
+    return nb_reports;
+}
+
+/*! \fn     logic_keyboard_send_typed_status(uint16_t typed_status, uint16_t reply_request_flag)
+*   \brief  Let the main MCU know how a typing request went
+*   \param  typed_status        KEYBOARD_TYPE_STATUS_xxx
+*   \param  reply_request_flag  Reply request flag of the typing request, its transaction tag
+*/
+static void logic_keyboard_send_typed_status(uint16_t typed_status, uint16_t reply_request_flag)
+{
+    aux_mcu_message_t* message_pt = comms_main_mcu_get_temp_tx_message_object_pt();
+    
+    dma_wait_for_main_mcu_packet_sent();
+    memset((void*)message_pt, 0x00, sizeof(*message_pt));
+    message_pt->message_type = AUX_MCU_MSG_TYPE_KEYBOARD_TYPE;
+    message_pt->payload_length1 = sizeof(keyboard_type_message_t);
+    message_pt->keyboard_type_message.typed_status = typed_status;
+    message_pt->tx_reply_request_flag = reply_request_flag;
+    comms_main_mcu_send_message(message_pt, (uint16_t)sizeof(*message_pt));
+}
+
+/*! \fn     logic_keyboard_is_interface_connected(uint16_t interface_id)
+*   \brief  Check if we can type on a given interface
+*   \param  interface_id    KEYBOARD_TYPE_INTERFACE_xxx
+*   \return TRUE if a host is listening to our keyboard reports on that interface
+*/
+static BOOL logic_keyboard_is_interface_connected(uint16_t interface_id)
+{
+    if (interface_id == KEYBOARD_TYPE_INTERFACE_USB)
+    {
+        return comms_usb_is_configured();
+    }
+    else if ((interface_id == KEYBOARD_TYPE_INTERFACE_BLE) && (logic_is_ble_enabled() != FALSE))
+    {
+        return mini_ble_is_keyboard_connected();
+    }
+    return FALSE;
+}
+
+/*! \fn     logic_keyboard_deal_with_type_message(aux_mcu_message_t* message)
+*   \brief  Start typing the keys of a message from the main MCU, status is sent back once done
+*   \param  message     Keyboard type message
+*/
+void logic_keyboard_deal_with_type_message(aux_mcu_message_t* message)
+{
+    keyboard_type_message_t* type_message_pt = &message->keyboard_type_message;
+    
+    /* Check that we can type, and for a valid message */
+    if ((logic_keyboard_typing != FALSE) || (logic_keyboard_is_interface_connected(type_message_pt->interface_identifier) == FALSE) || (type_message_pt->nb_keys == 0) || (type_message_pt->nb_keys > KEYBOARD_TYPE_MAX_NB_KEYS) || (message->payload_length1 < sizeof(keyboard_type_message_t) + type_message_pt->nb_keys*sizeof(keyboard_key_t)))
+    {
+        logic_keyboard_send_typed_status(KEYBOARD_TYPE_STATUS_FAILED, message->tx_reply_request_flag);
+        return;
+    }
+    
+    /* Build all the reports beforehand */
+    logic_keyboard_nb_reports = logic_keyboard_build_reports(type_message_pt->keys, type_message_pt->nb_keys, logic_keyboard_reports, LOGIC_KEYBOARD_REPORT_QUEUE_SIZE);
+    if (logic_keyboard_nb_reports == 0)
+    {
+        logic_keyboard_send_typed_status(KEYBOARD_TYPE_STATUS_FAILED, message->tx_reply_request_flag);
+        return;
+    }
+    
+    logic_keyboard_interface = type_message_pt->interface_identifier;
+    logic_keyboard_reply_request_flag = message->tx_reply_request_flag;
+    logic_keyboard_nb_keys = type_message_pt->nb_keys;
+    logic_keyboard_delay_between_reports = type_message_pt->delay_between_reports;
+    logic_keyboard_last_report_systick = timer_get_systick();
+    logic_keyboard_ble_notification_failed = FALSE;
+    logic_keyboard_report_delayed = FALSE;
+    logic_keyboard_ble_nb_in_flight = 0;
+    logic_keyboard_ble_nb_confirmed = 0;
+    logic_keyboard_report_index = 0;
+    logic_keyboard_typing = TRUE;
+    
+    /* USB: send first report, the next ones are sent from the endpoint interrupt. BLE: reports are queued by logic_keyboard_routine() */
+    if (logic_keyboard_interface == KEYBOARD_TYPE_INTERFACE_USB)
+    {
+        usb_send(USB_KEYBOARD_ENDPOINT, (uint8_t*)&logic_keyboard_reports[0], sizeof(logic_keyboard_reports[0]));
+    }
+}
+
+/*! \fn     logic_keyboard_ble_notification_confirmed_callback(BOOL notification_sent)
+*   \brief  Function called when a report notification was sent over the air, or failed to be
+*   \param  notification_sent   TRUE if the notification was sent
+*   \note   Confirmations come in the order the notifications were queued, frees a slot for logic_keyboard_routine()
+*/
+void logic_keyboard_ble_notification_confirmed_callback(BOOL notification_sent)
+{
+    /* Not typing over BLE, or not ours */
+    if ((logic_keyboard_typing == FALSE) || (logic_keyboard_interface != KEYBOARD_TYPE_INTERFACE_BLE) || (logic_keyboard_ble_nb_in_flight == 0))
+    {
+        return;
+    }
+    
+    logic_keyboard_last_report_systick = timer_get_systick();
+    logic_keyboard_ble_nb_in_flight--;
+    
+    if (notification_sent != FALSE)
+    {
+        logic_keyboard_ble_nb_confirmed++;
+    }
+    else
+    {
+        logic_keyboard_ble_notification_failed = TRUE;
+    }
+}
+
+/*! \fn     logic_keyboard_usb_send_callback(void)
+*   \brief  Function called when a report is sent on the keyboard endpoint, sends the next one
+*/
+void logic_keyboard_usb_send_callback(void)
+{
+    /* Typing aborted, or not over USB */
+    if ((logic_keyboard_typing == FALSE) || (logic_keyboard_interface != KEYBOARD_TYPE_INTERFACE_USB))
+    {
+        return;
+    }
+    
+    logic_keyboard_last_report_systick = timer_get_systick();
+    
+    /* Report sent, move on to the next one */
+    if (++logic_keyboard_report_index < logic_keyboard_nb_reports)
+    {
+        if (logic_keyboard_delay_between_reports == 0)
+        {
+            usb_send(USB_KEYBOARD_ENDPOINT, (uint8_t*)&logic_keyboard_reports[logic_keyboard_report_index], sizeof(logic_keyboard_reports[0]));
+        }
+        else
+        {
+            /* Sent by logic_keyboard_routine() */
+            logic_keyboard_report_delayed = TRUE;
+        }
+    }
+}
+
+/*! \fn     logic_keyboard_release_all_keys(void)
+*   \brief  Release all keys on the interface we were typing on, so the host doesn't keep repeating a pressed key
+*   \note   USB: the release report replaces the report waiting to be fetched, if any
+*/
+static void logic_keyboard_release_all_keys(void)
+{
+    memset((void*)&logic_keyboard_release_report, 0x00, sizeof(logic_keyboard_release_report));
+    
+    if ((logic_keyboard_interface == KEYBOARD_TYPE_INTERFACE_USB) && (comms_usb_is_configured() != FALSE))
+    {
+        usb_send(USB_KEYBOARD_ENDPOINT, (uint8_t*)&logic_keyboard_release_report, sizeof(logic_keyboard_release_report));
+    }
+    else if ((logic_keyboard_interface == KEYBOARD_TYPE_INTERFACE_BLE) && (mini_ble_is_keyboard_connected() != FALSE))
+    {
+        mini_ble_send_keyboard_report((uint8_t*)&logic_keyboard_release_report, sizeof(logic_keyboard_release_report));
+    }
+}
+
+/*! \fn     logic_keyboard_is_typing(void)
+*   \brief  Check if we're typing
+*   \return TRUE if a typing request is ongoing
+*/
+BOOL logic_keyboard_is_typing(void)
+{
+    return logic_keyboard_typing;
+}
+
+/*! \fn     logic_keyboard_routine(void)
+*   \brief  Send the delayed reports, tell the main MCU when we're done typing
+*   \note   BLE reports are queued without waiting for the previous ones to be confirmed, up to LOGIC_KEYBOARD_BLE_MAX_IN_FLIGHT:
+*   \note   the BLE chip builds each notification when it processes our command, so queued reports go out in order and several
+*   \note   of them can be sent in a single connection interval. With a delay set, a report is queued once the previous one was sent
+*/
+void logic_keyboard_routine(void)
+{
+    BOOL interface_stalled = FALSE;
+    uint16_t nb_reports_sent;
+    
+    if (logic_keyboard_typing == FALSE)
+    {
+        return;
+    }
+    
+    if (logic_keyboard_interface == KEYBOARD_TYPE_INTERFACE_BLE)
+    {
+        /* Queue as many reports as we can */
+        while ((logic_keyboard_report_index < logic_keyboard_nb_reports) && (logic_keyboard_ble_nb_in_flight < LOGIC_KEYBOARD_BLE_MAX_IN_FLIGHT) && ((logic_keyboard_delay_between_reports == 0) || ((logic_keyboard_ble_nb_in_flight == 0) && ((timer_get_systick() - logic_keyboard_last_report_systick) >= logic_keyboard_delay_between_reports))))
+        {
+            if (logic_keyboard_ble_nb_in_flight == 0)
+            {
+                logic_keyboard_last_report_systick = timer_get_systick();
+            }
+            mini_ble_send_keyboard_report((uint8_t*)&logic_keyboard_reports[logic_keyboard_report_index++], sizeof(logic_keyboard_reports[0]));
+            logic_keyboard_ble_nb_in_flight++;
+        }
+        
+        /* Host disconnected, notification failed or not confirmed */
+        nb_reports_sent = logic_keyboard_ble_nb_confirmed;
+        if ((logic_keyboard_ble_notification_failed != FALSE) || (mini_ble_is_keyboard_connected() == FALSE) || ((logic_keyboard_ble_nb_in_flight != 0) && ((timer_get_systick() - logic_keyboard_last_report_systick) > LOGIC_KEYBOARD_REPORT_TIMEOUT_MS)))
+        {
+            interface_stalled = TRUE;
+        }
+    }
+    else
+    {
+        /* Report waiting for the delay to be elapsed */
+        if ((logic_keyboard_report_delayed != FALSE) && ((timer_get_systick() - logic_keyboard_last_report_systick) >= logic_keyboard_delay_between_reports))
+        {
+            logic_keyboard_report_delayed = FALSE;
+            usb_send(USB_KEYBOARD_ENDPOINT, (uint8_t*)&logic_keyboard_reports[logic_keyboard_report_index], sizeof(logic_keyboard_reports[0]));
+        }
+        
+        /* Host not fetching reports anymore */
+        nb_reports_sent = logic_keyboard_report_index;
+        if ((logic_keyboard_report_delayed == FALSE) && ((timer_get_systick() - logic_keyboard_last_report_systick) > LOGIC_KEYBOARD_REPORT_TIMEOUT_MS))
+        {
+            interface_stalled = TRUE;
+        }
+    }
+    
+    /* All reports sent, or interface stalled */
+    if (nb_reports_sent >= logic_keyboard_nb_reports)
+    {
+        logic_keyboard_typing = FALSE;
+        COMMS_TRACE_3(TRACE_ID_KEYBOARD_TYPED, logic_keyboard_nb_keys, logic_keyboard_nb_reports, KEYBOARD_TYPE_STATUS_TYPED);
+        logic_keyboard_send_typed_status(KEYBOARD_TYPE_STATUS_TYPED, logic_keyboard_reply_request_flag);
+    }
+    else if (interface_stalled != FALSE)
+    {
+        logic_keyboard_typing = FALSE;
+        logic_keyboard_release_all_keys();
+        COMMS_TRACE_3(TRACE_ID_KEYBOARD_TYPED, logic_keyboard_nb_keys, nb_reports_sent, KEYBOARD_TYPE_STATUS_FAILED);
+        logic_keyboard_send_typed_status(KEYBOARD_TYPE_STATUS_FAILED, logic_keyboard_reply_request_flag);
+    }
+}
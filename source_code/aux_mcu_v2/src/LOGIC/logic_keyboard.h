@@ -0,0 +1,41 @@
+/*!  \file     logic_keyboard.h
+*    \brief    Keyboard typing engine: key sequences to HID keyboard reports
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef LOGIC_KEYBOARD_H_
+#define LOGIC_KEYBOARD_H_
+
+#include "comms_main_mcu.h"
+#include "defines.h"
+
+/* Defines */
+// Number of keys in a HID boot keyboard report
+#define LOGIC_KEYBOARD_REPORT_NB_KEYS       6
+// Worst case: a release report before each key press, plus the final release
+#define LOGIC_KEYBOARD_REPORT_QUEUE_SIZE    (2*KEYBOARD_TYPE_MAX_NB_KEYS + 1)
+// Typing is aborted when the host doesn't fetch a report for that long
+#define LOGIC_KEYBOARD_REPORT_TIMEOUT_MS    500
+// Max number of BLE report notifications waiting to be sent over the air: several can go in one connection interval
+#define LOGIC_KEYBOARD_BLE_MAX_IN_FLIGHT    4
+
+/* Typedefs */
+typedef struct
+{
+    uint8_t modifier;
+    uint8_t reserved;
+    uint8_t keys[LOGIC_KEYBOARD_REPORT_NB_KEYS];
+} keyboard_report_t;
+
+/* Prototypes */
+uint16_t logic_keyboard_build_reports(keyboard_key_t* keys, uint16_t nb_keys, keyboard_report_t* reports, uint16_t max_nb_reports);
+void logic_keyboard_deal_with_type_message(aux_mcu_message_t* message);
+void logic_keyboard_ble_notification_confirmed_callback(BOOL notification_sent);
+void logic_keyboard_usb_send_callback(void);
+BOOL logic_keyboard_is_typing(void);
+void logic_keyboard_routine(void);
+
+
+#endif /* LOGIC_KEYBOARD_H_ */
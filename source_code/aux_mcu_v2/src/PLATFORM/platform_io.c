@@ -312,6 +312,22 @@ void platform_io_disable_no_comms_int(void)
     EIC->WAKEUP.reg &= ~(1 << NOCOMMS_EXTINT_NUM);                                                          // Disable wakeup from ext pin 
 }
 
+/*! \fn     platform_io_is_no_comms_asserted(void)
+*   \brief  Check if the main MCU asks us to hold our messages
+*   \return TRUE if no comms signal is set
+*/
+BOOL platform_io_is_no_comms_asserted(void)
+{
+    if ((PORT->Group[AUX_MCU_NOCOMMS_GROUP].IN.reg & AUX_MCU_NOCOMMS_MASK) != 0)
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
 /*! \fn     platform_io_disable_main_comms(void)
 *   \brief  Disable ports dedicated to aux comms
 */
@@ -18,6 +18,7 @@ void platform_io_prepare_ports_for_sleep(void);
 void platform_io_disable_charge_mosfets(void);
 void platform_io_enable_charge_mosfets(void);
 void platform_io_disable_no_comms_int(void);
+BOOL platform_io_is_no_comms_asserted(void);
 void platform_io_enable_no_comms_int(void);
 void platform_io_init_no_comms_input(void);
 void platform_io_disable_main_comms(void);
@@ -34,6 +34,7 @@
 #include "usb.h"
 #include "usb_utils.h"
 #include "comms_usb.h"
+#include "logic_keyboard.h"
 #include "usb_descriptors.h"
 #include "platform_defines.h"
 
@@ -395,6 +396,10 @@ void USB_Handler(void)
       {
           comms_usb_raw_hid_send_callback();
       }
+      else if (i == USB_KEYBOARD_ENDPOINT)
+      {
+          logic_keyboard_usb_send_callback();
+      }
       //udc_send_callback(i);
     }
   }
@@ -68,16 +68,17 @@ int main(void)
     while (1) 
     {
         /* Did we receive a message? */
-        if (dma_main_mcu_other_msg_received != FALSE)
+        aux_mcu_message_t* received_message;
+        if (dma_main_mcu_get_received_message(&received_message) != FALSE)
         {
             /* Check for write message and payload is a multiple of the nvm row size */
-            if ((dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_BOOTLOADER) && (dma_main_mcu_temp_rcv_message.bootloader_message.command == BOOTLOADER_WRITE_COMMAND) && ((dma_main_mcu_temp_rcv_message.bootloader_message.write_command.size & (NVMCTRL_ROW_SIZE - 1)) == 0))
+            if ((received_message->message_type == AUX_MCU_MSG_TYPE_BOOTLOADER) && (received_message->bootloader_message.command == BOOTLOADER_WRITE_COMMAND) && ((received_message->bootloader_message.write_command.size & (NVMCTRL_ROW_SIZE - 1)) == 0))
             {
                 /* Program one or more rows */
-                for (uint16_t offset = 0; offset < dma_main_mcu_temp_rcv_message.bootloader_message.write_command.size; offset+=NVMCTRL_ROW_SIZE)
+                for (uint16_t offset = 0; offset < received_message->bootloader_message.write_command.size; offset+=NVMCTRL_ROW_SIZE)
                 {
                     /* Compute write address */
-                    uint32_t write_adddress = APP_START_ADDR + dma_main_mcu_temp_rcv_message.bootloader_message.write_command.address + offset;
+                    uint32_t write_adddress = APP_START_ADDR + received_message->bootloader_message.write_command.address + offset;
                     
                     /* Erase complete row, composed of 4 pages */
                     while ((NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY) == 0);
@@ -91,7 +92,7 @@ int main(void)
                         while ((NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY) == 0);
                         for(uint32_t i = 0; i < NVMCTRL_ROW_SIZE/4; i+=2)
                         {                            
-                            NVM_MEMORY[(write_adddress+j*(NVMCTRL_ROW_SIZE/4)+i)/2] = dma_main_mcu_temp_rcv_message.bootloader_message.write_command.payload_as_uint16_t[(offset+j*(NVMCTRL_ROW_SIZE/4)+i)/2];
+                            NVM_MEMORY[(write_adddress+j*(NVMCTRL_ROW_SIZE/4)+i)/2] = received_message->bootloader_message.write_command.payload_as_uint16_t[(offset+j*(NVMCTRL_ROW_SIZE/4)+i)/2];
                         }
                     }
                 }
@@ -105,7 +106,7 @@ int main(void)
             }
             
             /* Start app? */
-            if ((dma_main_mcu_temp_rcv_message.message_type == AUX_MCU_MSG_TYPE_BOOTLOADER) && (dma_main_mcu_temp_rcv_message.bootloader_message.command == BOOTLOADER_START_APP_COMMAND))
+            if ((received_message->message_type == AUX_MCU_MSG_TYPE_BOOTLOADER) && (received_message->bootloader_message.command == BOOTLOADER_START_APP_COMMAND))
             {
                 bootloader_flag = 0;
                 __disable_irq();
@@ -113,8 +114,8 @@ int main(void)
                 NVIC_SystemReset();
             }  
             
-            /* Clear bool */
-            dma_main_mcu_other_msg_received = FALSE; 
+            /* Release message slot */
+            dma_main_mcu_release_received_message();
         }
     }
 }
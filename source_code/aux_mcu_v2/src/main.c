@@ -2,10 +2,13 @@
 #include "platform_defines.h"
 #include "hid_keyboard_app.h"
 #include "comms_main_mcu.h"
+#include "logic_keyboard.h"
 #include "logic_battery.h"
+#include "logic.h"
 #include "driver_clocks.h"
 #include "driver_timer.h"
 #include "platform_io.h"
+#include "comms_trace.h"
 #include "comms_usb.h"
 #include "defines.h"
 #include "fuses.h"
@@ -153,6 +156,14 @@ int main(void)
         logic_battery_task();
         comms_main_mcu_routine();
         comms_usb_communication_routine();
+        if (logic_is_ble_enabled() != FALSE)
+        {
+            mini_ble_task();
+        }
+        logic_keyboard_routine();
+        #ifdef DEBUG_TRACE_ENABLED
+        comms_trace_routine();
+        #endif
     }
     
     /* Test code: remove later */
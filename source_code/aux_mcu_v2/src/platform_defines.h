@@ -38,6 +38,7 @@ v0.4: discarding USB messages having the incorrect flip bit
 /* Features depending on the defined platform */
 #if defined(PLAT_V3_SETUP)
      #define NO_SECURITY_BIT_CHECK
+     #define DEBUG_TRACE_ENABLED
 #endif
 
 /* USB defines */
@@ -0,0 +1,153 @@
+/*!  \file     comms_trace.c
+*    \brief    Binary trace ring, formatted by the host. Shared by both MCUs, each sending the messages with its own transport
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include <asf.h>
+#include "comms_hid_msgs_debug.h"
+#include "platform_defines.h"
+#include "driver_timer.h"
+#include "comms_trace.h"
+#include "defines.h"
+#ifdef DEBUG_TRACE_ENABLED
+/* Trace ring: entries are a header word followed by their arguments */
+uint32_t comms_trace_ring[COMMS_TRACE_RING_NB_WORDS];
+/* Number of words pushed in / sent from the ring, only written with interrupts disabled / from the main loop */
+volatile uint16_t comms_trace_write_seq = 0;
+volatile uint16_t comms_trace_read_seq = 0;
+/* Number of entries dropped because the ring was full */
+uint16_t comms_trace_nb_dropped_entries = 0;
+
+
+/*! \fn     comms_trace_push(comms_trace_id_te id, uint16_t nb_args, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+*   \brief  Push an entry in the trace ring, dropping it if the ring is full
+*   \param  id          Format ID
+*   \param  nb_args     Number of arguments
+*   \param  arg1        First argument
+*   \param  arg2        Second argument
+*   \param  arg3        Third argument
+*   \note   Inlined in the comms_trace_log_x functions so that the unused arguments disappear
+*/
+static inline __attribute__((always_inline)) void comms_trace_push(comms_trace_id_te id, uint16_t nb_args, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+    uint32_t header = COMMS_TRACE_HEADER(id, nb_args, timer_get_systick());
+    irqflags_t flags = cpu_irq_save();
+    uint16_t write_seq = comms_trace_write_seq;
+    
+    /* Ring full */
+    if ((uint16_t)(write_seq - comms_trace_read_seq) > COMMS_TRACE_RING_NB_WORDS - 1 - nb_args)
+    {
+        comms_trace_nb_dropped_entries++;
+        cpu_irq_restore(flags);
+        return;
+    }
+    
+    comms_trace_ring[write_seq++ % COMMS_TRACE_RING_NB_WORDS] = header;
+    if (nb_args > 0)
+    {
+        comms_trace_ring[write_seq++ % COMMS_TRACE_RING_NB_WORDS] = arg1;
+    }
+    if (nb_args > 1)
+    {
+        comms_trace_ring[write_seq++ % COMMS_TRACE_RING_NB_WORDS] = arg2;
+    }
+    if (nb_args > 2)
+    {
+        comms_trace_ring[write_seq++ % COMMS_TRACE_RING_NB_WORDS] = arg3;
+    }
+    comms_trace_write_seq = write_seq;
+    cpu_irq_restore(flags);
+}
+
+/*! \fn     comms_trace_log_0(comms_trace_id_te id)
+*   \brief  Log a trace without argument, use COMMS_TRACE_0()
+*   \param  id      Format ID
+*/
+void comms_trace_log_0(comms_trace_id_te id)
+{
+    comms_trace_push(id, 0, 0, 0, 0);
+}
+
+/*! \fn     comms_trace_log_1(comms_trace_id_te id, uint32_t arg1)
+*   \brief  Log a trace with one argument, use COMMS_TRACE_1()
+*   \param  id      Format ID
+*   \param  arg1    First argument
+*/
+void comms_trace_log_1(comms_trace_id_te id, uint32_t arg1)
+{
+    comms_trace_push(id, 1, arg1, 0, 0);
+}
+
+/*! \fn     comms_trace_log_2(comms_trace_id_te id, uint32_t arg1, uint32_t arg2)
+*   \brief  Log a trace with two arguments, use COMMS_TRACE_2()
+*   \param  id      Format ID
+*   \param  arg1    First argument
+*   \param  arg2    Second argument
+*/
+void comms_trace_log_2(comms_trace_id_te id, uint32_t arg1, uint32_t arg2)
+{
+    comms_trace_push(id, 2, arg1, arg2, 0);
+}
+
+/*! \fn     comms_trace_log_3(comms_trace_id_te id, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+*   \brief  Log a trace with three arguments, use COMMS_TRACE_3()
+*   \param  id      Format ID
+*   \param  arg1    First argument
+*   \param  arg2    Second argument
+*   \param  arg3    Third argument
+*/
+void comms_trace_log_3(comms_trace_id_te id, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+    comms_trace_push(id, 3, arg1, arg2, arg3);
+}
+
+/*! \fn     comms_trace_routine(void)
+*   \brief  Send the logged entries to the host when the MCU transport is idle
+*   \note   Called from the main loop, only whole entries are sent
+*/
+void comms_trace_routine(void)
+{
+    uint16_t read_seq = comms_trace_read_seq;
+    uint16_t write_seq = comms_trace_write_seq;
+    hid_message_t* hid_message_pt;
+    
+    /* Nothing to send or transport busy */
+    if (((read_seq == write_seq) && (comms_trace_nb_dropped_entries == 0)) || ((hid_message_pt = comms_trace_get_hid_message()) == 0))
+    {
+        return;
+    }
+    
+    /* Prepare message */
+    comms_trace_message_t* trace_message_pt = (comms_trace_message_t*)hid_message_pt->payload;
+    uint16_t max_nb_words = (sizeof(hid_message_pt->payload) - sizeof(comms_trace_message_t)) / sizeof(uint32_t);
+    uint16_t nb_words = 0;
+    
+    /* Copy whole entries */
+    while (read_seq != write_seq)
+    {
+        uint16_t entry_nb_words = 1 + COMMS_TRACE_HEADER_NB_ARGS(comms_trace_ring[read_seq % COMMS_TRACE_RING_NB_WORDS]);
+        if (nb_words + entry_nb_words > max_nb_words)
+        {
+            break;
+        }
+        for (uint16_t i = 0; i < entry_nb_words; i++)
+        {
+            trace_message_pt->words[nb_words++] = comms_trace_ring[read_seq++ % COMMS_TRACE_RING_NB_WORDS];
+        }
+    }
+    
+    /* Free space in the ring, fetch & reset dropped entries counter */
+    cpu_irq_enter_critical();
+    comms_trace_read_seq = read_seq;
+    trace_message_pt->nb_dropped_entries = comms_trace_nb_dropped_entries;
+    comms_trace_nb_dropped_entries = 0;
+    cpu_irq_leave_critical();
+    trace_message_pt->source = COMMS_TRACE_SOURCE;
+    
+    /* Send message */
+    hid_message_pt->message_type = HID_CMD_ID_DBG_TRACE;
+    hid_message_pt->payload_length = sizeof(comms_trace_message_t) + nb_words*sizeof(uint32_t);
+    comms_trace_send_hid_message();
+}
+#endif
@@ -0,0 +1,61 @@
+/*!  \file     comms_trace.h
+*    \brief    Binary trace ring, formatted by the host
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef COMMS_TRACE_H_
+#define COMMS_TRACE_H_
+
+#include "platform_defines.h"
+#include "comms_trace_ids.h"
+#include "comms_hid_msgs.h"
+#include "defines.h"
+
+/* Defines */
+// Ring size in 32 bit words, power of 2
+#define COMMS_TRACE_RING_NB_WORDS   256
+#if (COMMS_TRACE_RING_NB_WORDS & (COMMS_TRACE_RING_NB_WORDS - 1)) != 0
+    #error "COMMS_TRACE_RING_NB_WORDS must be a power of 2"
+#endif
+// Trace sources, COMMS_TRACE_SOURCE is set to ours in comms_trace_ids.h
+#define COMMS_TRACE_SOURCE_MAIN_MCU 0
+#define COMMS_TRACE_SOURCE_AUX_MCU  1
+// Entry header word: format ID, number of argument words following the header, 16 LSBs of the ms tick
+#define COMMS_TRACE_HEADER(id, nb_args, tick)   ((uint32_t)(id) | ((uint32_t)(nb_args) << 12) | ((uint32_t)(tick) << 16))
+#define COMMS_TRACE_HEADER_NB_ARGS(header)      (((header) >> 12) & 0x0F)
+
+/* Typedefs */
+// Trace message payload: whole entries only
+typedef struct
+{
+    uint16_t source;
+    uint16_t nb_dropped_entries;
+    uint32_t words[];
+} comms_trace_message_t;
+
+/* Trace calls, compiled out when traces are disabled */
+#ifdef DEBUG_TRACE_ENABLED
+    #define COMMS_TRACE_0(id)               comms_trace_log_0(id)
+    #define COMMS_TRACE_1(id, a)            comms_trace_log_1(id, (uint32_t)(a))
+    #define COMMS_TRACE_2(id, a, b)         comms_trace_log_2(id, (uint32_t)(a), (uint32_t)(b))
+    #define COMMS_TRACE_3(id, a, b, c)      comms_trace_log_3(id, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#else
+    #define COMMS_TRACE_0(id)
+    #define COMMS_TRACE_1(id, a)
+    #define COMMS_TRACE_2(id, a, b)
+    #define COMMS_TRACE_3(id, a, b, c)
+#endif
+
+/* Prototypes, the trace message ones are implemented by each MCU with its transport */
+hid_message_t* comms_trace_get_hid_message(void);
+void comms_trace_send_hid_message(void);
+void comms_trace_log_3(comms_trace_id_te id, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+void comms_trace_log_2(comms_trace_id_te id, uint32_t arg1, uint32_t arg2);
+void comms_trace_log_1(comms_trace_id_te id, uint32_t arg1);
+void comms_trace_log_0(comms_trace_id_te id);
+void comms_trace_routine(void);
+
+
+#endif /* COMMS_TRACE_H_ */
@@ -10,35 +10,293 @@
 #include "comms_hid_msgs.h"
 #include "logic_aux_mcu.h"
 #include "comms_aux_mcu.h"
+#include "comms_trace.h"
 #include "driver_timer.h"
 #include "platform_io.h"
 #include "defines.h"
 #include "dma.h"
-/* Received and sent MCU messages */
-aux_mcu_message_t aux_mcu_receive_message;
+/* Ring of received messages, filled back to back by DMA */
+aux_mcu_message_t aux_mcu_receive_messages[AUX_MCU_RX_NB_SLOTS];
+/* Sent MCU message */
 aux_mcu_message_t aux_mcu_send_message;
-/* Flag set if we have treated a message by only looking at its first bytes */
-BOOL aux_mcu_message_answered_using_first_bytes = FALSE;
+/* Sequence number of the slot being filled by DMA, and of the oldest slot not released yet */
+volatile uint16_t aux_mcu_rx_dma_seq = 0;
+volatile uint16_t aux_mcu_rx_read_seq = 0;
+/* Flags set if we have treated a message by only looking at its first bytes */
+BOOL aux_mcu_message_answered_using_first_bytes[AUX_MCU_RX_NB_SLOTS];
+/* Pending requests to the aux MCU, and correlation ID for the next one */
+aux_mcu_transaction_t aux_mcu_transactions[AUX_MCU_NB_TRANSACTIONS];
+uint16_t aux_mcu_next_correlation_id = 0;
+/* Message type (USB / BLE) of the HID request being parsed, carried by the transactions it starts */
+uint16_t aux_mcu_parsed_hid_message_type = AUX_MCU_MSG_TYPE_USB;
+#ifdef AUX_LINK_CRC_ENABLED
+/* Sent messages kept for retransmission, sequence number of the next message to send */
+aux_mcu_message_t aux_mcu_link_tx_history[AUX_LINK_TX_HISTORY_LENGTH];
+uint16_t aux_mcu_link_tx_seq = 0;
+/* Sequence number of the next message we expect, set when we already asked for it */
+uint16_t aux_mcu_link_rx_expected_seq = 0;
+BOOL aux_mcu_link_nack_sent = FALSE;
+/* Retransmission request, not part of the sequenced messages */
+aux_mcu_message_t aux_mcu_link_nack_message;
+/* Link statistics */
+uint32_t aux_mcu_link_nb_crc_errors = 0;
+uint32_t aux_mcu_link_nb_retransmits = 0;
+/* CRC16 CCITT lookup table, one nibble at a time */
+const uint16_t aux_mcu_link_crc_table[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+#endif
 
 
+/*! \fn     comms_aux_mcu_get_rx_slot(uint16_t seq)
+*   \brief  Get the ring slot for a given sequence number
+*   \param  seq     Sequence number
+*   \return Pointer to the message
+*/
+static inline aux_mcu_message_t* comms_aux_mcu_get_rx_slot(uint16_t seq)
+{
+    return &aux_mcu_receive_messages[seq % AUX_MCU_RX_NB_SLOTS];
+}
+
+/*! \fn     comms_aux_mcu_arm_rx_slot(uint16_t seq)
+*   \brief  Arm DMA reception in the slot for a given sequence number
+*   \param  seq     Sequence number
+*/
+static void comms_aux_mcu_arm_rx_slot(uint16_t seq)
+{
+    aux_mcu_message_t* slot_pt = comms_aux_mcu_get_rx_slot(seq);
+    
+    /* Stale payload length from a previous message mustn't be used for early answers */
+    aux_mcu_message_answered_using_first_bytes[seq % AUX_MCU_RX_NB_SLOTS] = FALSE;
+    slot_pt->payload_length1 = 0;
+    dma_aux_mcu_init_rx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)slot_pt, sizeof(*slot_pt));
+}
+
+#ifdef AUX_LINK_CRC_ENABLED
+/*! \fn     comms_aux_mcu_link_compute_crc(aux_mcu_message_t* message_pt)
+*   \brief  Compute the CRC16 CCITT of a message, link_crc excluded
+*   \param  message_pt  Pointer to the message
+*   \return The CRC
+*/
+static uint16_t comms_aux_mcu_link_compute_crc(aux_mcu_message_t* message_pt)
+{
+    uint8_t* data_pt = (uint8_t*)message_pt;
+    uint16_t crc = 0xFFFF;
+    
+    for (uint16_t i = 0; i < offsetof(aux_mcu_message_t, link_crc); i++)
+    {
+        crc = (crc << 4) ^ aux_mcu_link_crc_table[(crc >> 12) ^ (data_pt[i] >> 4)];
+        crc = (crc << 4) ^ aux_mcu_link_crc_table[(crc >> 12) ^ (data_pt[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/*! \fn     comms_aux_mcu_link_send_nack(void)
+*   \brief  Ask the aux MCU to send again the messages from the one we expect, only once per expected message
+*/
+static void comms_aux_mcu_link_send_nack(void)
+{
+    if (aux_mcu_link_nack_sent != FALSE)
+    {
+        return;
+    }
+    aux_mcu_link_nack_sent = TRUE;
+    timer_start_timer(TIMER_AUX_LINK_NACK, AUX_LINK_NACK_RETRY_MS);
+    COMMS_TRACE_1(TRACE_ID_AUX_LINK_NACK, aux_mcu_link_rx_expected_seq);
+    
+    /* Previous request may still be being sent */
+    dma_wait_for_aux_mcu_packet_sent();
+    memset((void*)&aux_mcu_link_nack_message, 0, sizeof(aux_mcu_link_nack_message));
+    aux_mcu_link_nack_message.message_type = AUX_MCU_MSG_TYPE_LINK_NACK;
+    aux_mcu_link_nack_message.payload_length1 = sizeof(aux_mcu_link_nack_message.link_nack_message);
+    aux_mcu_link_nack_message.link_nack_message.expected_seq = aux_mcu_link_rx_expected_seq;
+    aux_mcu_link_nack_message.link_crc = comms_aux_mcu_link_compute_crc(&aux_mcu_link_nack_message);
+    dma_aux_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_link_nack_message, sizeof(aux_mcu_link_nack_message));
+}
+
+/*! \fn     comms_aux_mcu_link_retransmit(uint16_t seq)
+*   \brief  Send again our messages, starting from a given one
+*   \param  seq     Sequence number of the first message to send again
+*   \note   Nothing is sent if that message isn't in our history anymore
+*/
+static void comms_aux_mcu_link_retransmit(uint16_t seq)
+{
+    uint16_t nb_messages = aux_mcu_link_tx_seq - seq;
+    
+    if ((nb_messages == 0) || (nb_messages > AUX_LINK_TX_HISTORY_LENGTH))
+    {
+        return;
+    }
+    COMMS_TRACE_2(TRACE_ID_AUX_LINK_RETRANSMIT, nb_messages, seq);
+    
+    /* The function below does wait for a previous transfer to finish */
+    for (; seq != aux_mcu_link_tx_seq; seq++)
+    {
+        aux_mcu_link_nb_retransmits++;
+        dma_aux_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_link_tx_history[seq % AUX_LINK_TX_HISTORY_LENGTH], sizeof(aux_mcu_message_t));
+    }
+}
+
+/*! \fn     comms_aux_mcu_link_nack_routine(void)
+*   \brief  Ask again for the message we expect when our request or the retransmission got lost or corrupted
+*/
+static void comms_aux_mcu_link_nack_routine(void)
+{
+    if ((aux_mcu_link_nack_sent != FALSE) && (timer_has_timer_expired(TIMER_AUX_LINK_NACK, TRUE) == TIMER_EXPIRED))
+    {
+        aux_mcu_link_nack_sent = FALSE;
+        comms_aux_mcu_link_send_nack();
+    }
+}
+
+/*! \fn     comms_aux_mcu_link_accept_message(aux_mcu_message_t* message_pt)
+*   \brief  Check a fully received message CRC and sequence number
+*   \param  message_pt  Pointer to the message
+*   \return TRUE if the message should be dealt with
+*   \note   A corrupted or missing message triggers a retransmission request, duplicates are dropped
+*/
+static BOOL comms_aux_mcu_link_accept_message(aux_mcu_message_t* message_pt)
+{
+    /* Aux MCU bootloader doesn't frame its messages */
+    if (message_pt->message_type == AUX_MCU_MSG_TYPE_BOOTLOADER)
+    {
+        return TRUE;
+    }
+    
+    /* Corrupted message */
+    if (message_pt->link_crc != comms_aux_mcu_link_compute_crc(message_pt))
+    {
+        aux_mcu_link_nb_crc_errors++;
+        comms_aux_mcu_link_send_nack();
+        return FALSE;
+    }
+    
+    /* Retransmission requests aren't sequenced */
+    if (message_pt->message_type == AUX_MCU_MSG_TYPE_LINK_NACK)
+    {
+        return TRUE;
+    }
+    
+    /* Expected message, or aux MCU restarted its sequence numbers */
+    int16_t seq_diff = (int16_t)(message_pt->link_seq - aux_mcu_link_rx_expected_seq);
+    if ((seq_diff == 0) || (seq_diff > AUX_LINK_TX_HISTORY_LENGTH) || (seq_diff < -AUX_LINK_TX_HISTORY_LENGTH))
+    {
+        aux_mcu_link_rx_expected_seq = message_pt->link_seq + 1;
+        aux_mcu_link_nack_sent = FALSE;
+        return TRUE;
+    }
+    
+    /* We missed a message */
+    if (seq_diff > 0)
+    {
+        comms_aux_mcu_link_send_nack();
+    }
+    
+    /* Out of sequence or duplicate */
+    return FALSE;
+}
+#endif
+
+/*! \fn     comms_aux_mcu_get_nb_reserved_rx_slots(void)
+*   \brief  Get the number of ring slots in use or kept for the replies to our pending requests
+*   \return Number of slots
+*   \note   The aux MCU sends its replies even when asked to hold its messages: the ring must have room for them
+*/
+static uint16_t comms_aux_mcu_get_nb_reserved_rx_slots(void)
+{
+    uint16_t nb_reserved_slots = aux_mcu_rx_dma_seq - aux_mcu_rx_read_seq;
+    
+    for (uint16_t i = 0; i < AUX_MCU_NB_TRANSACTIONS; i++)
+    {
+        if (aux_mcu_transactions[i].state == AUX_MCU_TRANS_PENDING)
+        {
+            nb_reserved_slots++;
+        }
+    }
+    return nb_reserved_slots;
+}
+
+/*! \fn     comms_aux_mcu_clear_no_comms_if_rx_room(void)
+*   \brief  Let the aux MCU send again if the ring has room
+*/
+static void comms_aux_mcu_clear_no_comms_if_rx_room(void)
+{
+    if (comms_aux_mcu_get_nb_reserved_rx_slots() < AUX_MCU_RX_NB_SLOTS-1)
+    {
+        platform_io_clear_no_comms();
+    }
+}
+
+/*! \fn     comms_aux_mcu_rx_transfer_done_irq_handler(void)
+*   \brief  Called by the DMA interrupt when a message is fully received
+*   \note   Reception continues in the next slot if the main routine released it, the aux MCU is asked to hold its messages when the ring is almost full
+*/
+void comms_aux_mcu_rx_transfer_done_irq_handler(void)
+{
+    /* Hand the slot over to the main routine */
+    aux_mcu_rx_dma_seq++;
+    
+    uint16_t nb_used_slots = aux_mcu_rx_dma_seq - aux_mcu_rx_read_seq;
+    if (nb_used_slots < AUX_MCU_RX_NB_SLOTS)
+    {
+        comms_aux_mcu_arm_rx_slot(aux_mcu_rx_dma_seq);
+    }
+    
+    /* Ask the aux MCU to hold its messages one slot early, as it may have started sending the next one already */
+    if (comms_aux_mcu_get_nb_reserved_rx_slots() >= AUX_MCU_RX_NB_SLOTS-1)
+    {
+        platform_io_set_no_comms();
+    }
+}
+
+/*! \fn     comms_aux_mcu_release_rx_message(uint16_t seq)
+*   \brief  Release a fully received message so its slot can be used again, rearm reception if it was stopped
+*   \param  seq     Message sequence number
+*   \note   Does nothing if that message was already released or isn't fully received
+*/
+static void comms_aux_mcu_release_rx_message(uint16_t seq)
+{
+    cpu_irq_enter_critical();
+    
+    /* Only the oldest message can be released */
+    if ((seq == aux_mcu_rx_read_seq) && (aux_mcu_rx_dma_seq != aux_mcu_rx_read_seq))
+    {
+        aux_mcu_rx_read_seq++;
+    }
+    
+    /* Reception stopped: all slots were in use, or transfers were disabled */
+    if (dma_aux_mcu_is_rx_transfer_to_be_rearmed() != FALSE)
+    {
+        comms_aux_mcu_arm_rx_slot(aux_mcu_rx_dma_seq);
+    }
+    
+    cpu_irq_leave_critical();
+}
+
 /*! \fn     comms_aux_arm_rx_and_clear_no_comms(void)
-*   \brief  Init RX communications with aux MCU
+*   \brief  Release the oldest received message, make sure RX communications with aux MCU are armed
 */
 void comms_aux_arm_rx_and_clear_no_comms(void)
 {
-    dma_aux_mcu_init_rx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_receive_message, sizeof(aux_mcu_receive_message));
+    comms_aux_mcu_release_rx_message(aux_mcu_rx_read_seq);
     platform_io_clear_no_comms();
 }
 
 /*! \fn     comms_aux_arm_rx_and_set_no_comms(void)
-*   \brief  Init RX communications with aux MCU
+*   \brief  Release the oldest received message, make sure RX communications with aux MCU are armed
 */
 void comms_aux_arm_rx_and_set_no_comms(void)
 {
-    dma_aux_mcu_init_rx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_receive_message, sizeof(aux_mcu_receive_message));
+    comms_aux_mcu_release_rx_message(aux_mcu_rx_read_seq);
     platform_io_set_no_comms();
 }
 
+/*! \fn     comms_aux_mcu_wait_for_message_received(void)
+*   \brief  Wait for the oldest message, possibly being dealt with using its first bytes, to be fully received
+*/
+void comms_aux_mcu_wait_for_message_received(void)
+{
+    while (aux_mcu_rx_dma_seq == aux_mcu_rx_read_seq);
+}
+
 /*! \fn     comms_aux_mcu_get_temp_tx_message_object_pt(void)
 *   \brief  Get a pointer to our temporary tx message object
 */
@@ -54,8 +312,18 @@ aux_mcu_message_t* comms_aux_mcu_get_temp_tx_message_object_pt(void)
 */
 void comms_aux_mcu_send_message(BOOL wait_for_send)
 {    
+    #ifdef AUX_LINK_CRC_ENABLED
+    /* Sequence number & CRC, send from our history so the message can be sent again */
+    aux_mcu_message_t* history_pt = &aux_mcu_link_tx_history[aux_mcu_link_tx_seq % AUX_LINK_TX_HISTORY_LENGTH];
+    aux_mcu_send_message.link_seq = aux_mcu_link_tx_seq++;
+    aux_mcu_send_message.link_crc = comms_aux_mcu_link_compute_crc(&aux_mcu_send_message);
+    dma_wait_for_aux_mcu_packet_sent();
+    memcpy((void*)history_pt, (void*)&aux_mcu_send_message, sizeof(aux_mcu_send_message));
+    dma_aux_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)history_pt, sizeof(aux_mcu_send_message));
+    #else
     /* The function below does wait for a previous transfer to finish */
     dma_aux_mcu_init_tx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_send_message, sizeof(aux_mcu_send_message));
+    #endif
     
     /* If asked, wait for message sent */
     if (wait_for_send != FALSE)
@@ -111,18 +379,215 @@ void comms_aux_mcu_get_empty_packet_ready_to_be_sent(aux_mcu_message_t** message
     *message_pt_pt = temp_tx_message_pt;
 }
 
+/*! \fn     comms_aux_mcu_send_hid_reply(int16_t hid_reply_payload_length, uint16_t reply_message_type)
+*   \brief  Send the HID reply written in aux_mcu_send_message.hid_message
+*   \param  hid_reply_payload_length    HID reply payload length
+*   \param  reply_message_type          AUX_MCU_MSG_TYPE_USB / AUX_MCU_MSG_TYPE_BLE: channel the request came from
+*   \note   Can be used to answer a request later on, for example from a transaction callback
+*/
+void comms_aux_mcu_send_hid_reply(int16_t hid_reply_payload_length, uint16_t reply_message_type)
+{
+    /* Set message type and compute payload size */
+    aux_mcu_send_message.message_type = reply_message_type;
+    aux_mcu_send_message.payload_length1 = hid_reply_payload_length + sizeof(aux_mcu_send_message.hid_message.message_type) + sizeof(aux_mcu_send_message.hid_message.payload_length);
+    aux_mcu_send_message.tx_reply_request_flag = TX_NO_REPLY_REQUEST_FLAG;
+    
+    /* Send message */
+    comms_aux_mcu_send_message(FALSE);
+}
+
+/*! \fn     comms_aux_mcu_send_transaction(uint16_t expected_reply_type, uint16_t timeout_ms, aux_mcu_message_t* reply_pt, aux_mcu_trans_callback_t callback)
+*   \brief  Send aux_mcu_send_message to the aux MCU and track its reply without waiting for it
+*   \param  expected_reply_type     Message type of the reply
+*   \param  timeout_ms              Reply timeout
+*   \param  reply_pt                Where to copy the reply for a polled transaction, may be 0
+*   \param  callback                Function called by comms_aux_mcu_routine() with the reply, 0 for a polled transaction
+*   \return Transaction handle, AUX_MCU_INVALID_TRANS_HANDLE if too many requests are pending (nothing is sent then)
+*   \note   The reply request flag is set to the transaction tag: the aux MCU echoes it in its reply, a late reply can't be taken for another one
+*   \note   Transactions with a callback are freed after the callback, polled ones with comms_aux_mcu_free_transaction()
+*   \note   When started while parsing a HID request, the callback gets the channel that request came from
+*/
+int16_t comms_aux_mcu_send_transaction(uint16_t expected_reply_type, uint16_t timeout_ms, aux_mcu_message_t* reply_pt, aux_mcu_trans_callback_t callback)
+{
+    for (int16_t i = 0; i < AUX_MCU_NB_TRANSACTIONS; i++)
+    {
+        if (aux_mcu_transactions[i].state == AUX_MCU_TRANS_FREE)
+        {
+            /* Tag transaction */
+            aux_mcu_transactions[i].correlation_id = TX_REPLY_REQUEST_TAG_FLAG | (aux_mcu_next_correlation_id++ & ~TX_REPLY_REQUEST_TAG_FLAG);
+            aux_mcu_transactions[i].expected_reply_type = expected_reply_type;
+            aux_mcu_transactions[i].timeout_systick = timer_get_systick() + timeout_ms;
+            aux_mcu_transactions[i].reply_pt = reply_pt;
+            aux_mcu_transactions[i].callback = callback;
+            aux_mcu_transactions[i].hid_reply_message_type = aux_mcu_parsed_hid_message_type;
+            aux_mcu_transactions[i].state = AUX_MCU_TRANS_PENDING;
+            
+            /* Keep a slot for the reply */
+            if (comms_aux_mcu_get_nb_reserved_rx_slots() >= AUX_MCU_RX_NB_SLOTS-1)
+            {
+                platform_io_set_no_comms();
+            }
+            
+            /* Send request, tagged for its reply */
+            aux_mcu_send_message.tx_reply_request_flag = aux_mcu_transactions[i].correlation_id;
+            comms_aux_mcu_send_message(FALSE);
+            return i;
+        }
+    }
+    
+    return AUX_MCU_INVALID_TRANS_HANDLE;
+}
+
+/*! \fn     comms_aux_mcu_get_transaction_state(int16_t handle)
+*   \brief  Get the state of a polled transaction
+*   \param  handle  Transaction handle
+*   \return Transaction state
+*/
+aux_mcu_trans_state_te comms_aux_mcu_get_transaction_state(int16_t handle)
+{
+    if ((handle < 0) || (handle >= AUX_MCU_NB_TRANSACTIONS))
+    {
+        return AUX_MCU_TRANS_FREE;
+    }
+    return aux_mcu_transactions[handle].state;
+}
+
+/*! \fn     comms_aux_mcu_free_transaction(int16_t handle)
+*   \brief  Free a polled transaction, a late reply to a pending one will then be dropped
+*   \param  handle  Transaction handle
+*/
+void comms_aux_mcu_free_transaction(int16_t handle)
+{
+    if ((handle >= 0) && (handle < AUX_MCU_NB_TRANSACTIONS))
+    {
+        aux_mcu_transactions[handle].state = AUX_MCU_TRANS_FREE;
+    }
+}
+
+/*! \fn     comms_aux_mcu_wait_for_transaction(int16_t handle, msg_restrict_type_te answer_restrict_type)
+*   \brief  Wait for a polled transaction to complete, while still dealing with other aux MCU messages
+*   \param  handle                  Transaction handle
+*   \param  answer_restrict_type    Enum restricting which messages we can answer in the mean time
+*   \return AUX_MCU_TRANS_REPLIED or AUX_MCU_TRANS_TIMEOUT, AUX_MCU_TRANS_FREE for a transaction with a callback
+*   \note   Must not be called while dealing with an aux MCU message: use a callback there
+*/
+aux_mcu_trans_state_te comms_aux_mcu_wait_for_transaction(int16_t handle, msg_restrict_type_te answer_restrict_type)
+{
+    while (comms_aux_mcu_get_transaction_state(handle) == AUX_MCU_TRANS_PENDING)
+    {
+        comms_aux_mcu_routine(answer_restrict_type);
+    }
+    return comms_aux_mcu_get_transaction_state(handle);
+}
+
+/*! \fn     comms_aux_mcu_is_reply_expected(uint16_t message_type)
+*   \brief  Know if a pending transaction expects a reply of a given type
+*   \param  message_type    Message type
+*   \return TRUE if so: such a message is only dealt with once fully received, as its tag is at its end
+*/
+static BOOL comms_aux_mcu_is_reply_expected(uint16_t message_type)
+{
+    for (uint16_t i = 0; i < AUX_MCU_NB_TRANSACTIONS; i++)
+    {
+        if ((aux_mcu_transactions[i].state == AUX_MCU_TRANS_PENDING) && (aux_mcu_transactions[i].expected_reply_type == message_type))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*! \fn     comms_aux_mcu_deliver_transaction_reply(aux_mcu_message_t* message_pt)
+*   \brief  Deliver a received message to the pending transaction whose tag it echoes
+*   \param  message_pt  Received message
+*   \return TRUE if the message is a tagged reply: delivered, or dropped if its transaction timed out or was freed
+*/
+static BOOL comms_aux_mcu_deliver_transaction_reply(aux_mcu_message_t* message_pt)
+{
+    aux_mcu_transaction_t* replied_transaction_pt = 0;
+    
+    /* Not a reply to a transaction */
+    if ((message_pt->tx_reply_request_flag & TX_REPLY_REQUEST_TAG_FLAG) == 0)
+    {
+        return FALSE;
+    }
+    
+    /* Find the pending transaction with that tag */
+    for (uint16_t i = 0; i < AUX_MCU_NB_TRANSACTIONS; i++)
+    {
+        aux_mcu_transaction_t* transaction_pt = &aux_mcu_transactions[i];
+        if ((transaction_pt->state == AUX_MCU_TRANS_PENDING) && (transaction_pt->correlation_id == message_pt->tx_reply_request_flag) && (transaction_pt->expected_reply_type == message_pt->message_type))
+        {
+            replied_transaction_pt = transaction_pt;
+            break;
+        }
+    }
+    
+    /* Late reply */
+    if (replied_transaction_pt == 0)
+    {
+        return TRUE;
+    }
+    
+    if (replied_transaction_pt->callback != 0)
+    {
+        /* Free before the call so the callback can start another transaction */
+        replied_transaction_pt->state = AUX_MCU_TRANS_FREE;
+        replied_transaction_pt->callback(message_pt, replied_transaction_pt->hid_reply_message_type);
+    }
+    else
+    {
+        if (replied_transaction_pt->reply_pt != 0)
+        {
+            memcpy((void*)replied_transaction_pt->reply_pt, (void*)message_pt, sizeof(aux_mcu_message_t));
+        }
+        replied_transaction_pt->state = AUX_MCU_TRANS_REPLIED;
+    }
+    return TRUE;
+}
+
+/*! \fn     comms_aux_mcu_check_transaction_timeouts(void)
+*   \brief  Time out pending transactions whose reply didn't arrive in time
+*/
+static void comms_aux_mcu_check_transaction_timeouts(void)
+{
+    uint32_t cur_systick = timer_get_systick();
+    BOOL timed_out = FALSE;
+    
+    for (uint16_t i = 0; i < AUX_MCU_NB_TRANSACTIONS; i++)
+    {
+        aux_mcu_transaction_t* transaction_pt = &aux_mcu_transactions[i];
+        if ((transaction_pt->state == AUX_MCU_TRANS_PENDING) && ((int32_t)(cur_systick - transaction_pt->timeout_systick) >= 0))
+        {
+            timed_out = TRUE;
+            if (transaction_pt->callback != 0)
+            {
+                transaction_pt->state = AUX_MCU_TRANS_FREE;
+                transaction_pt->callback(0, transaction_pt->hid_reply_message_type);
+            }
+            else
+            {
+                transaction_pt->state = AUX_MCU_TRANS_TIMEOUT;
+            }
+        }
+    }
+    
+    /* The slots kept for their replies are free again */
+    if (timed_out != FALSE)
+    {
+        comms_aux_mcu_clear_no_comms_if_rx_room();
+    }
+}
+
 /*! \fn     comms_aux_mcu_send_receive_ping(void)
 *   \brief  Try to ping the aux MCU
 *   \return Success or not
 */
 RET_TYPE comms_aux_mcu_send_receive_ping(void)
 {
-    aux_mcu_message_t* temp_rx_message_pt;
     aux_mcu_message_t* temp_tx_message_pt;
-    RET_TYPE return_val = RETURN_OK;
-
-    /* Tell the aux MCU to not send us messages */
-    platform_io_set_no_comms();    
+    int16_t transaction_handle;
+    RET_TYPE return_val = RETURN_NOK;
     
     /* Get an empty packet ready to be sent */
     comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_MAIN_MCU_CMD, TX_REPLY_REQUEST_FLAG);
@@ -130,13 +595,14 @@ RET_TYPE comms_aux_mcu_send_receive_ping(void)
     /* Fill missing fields */
     temp_tx_message_pt->payload_length1 = sizeof(temp_tx_message_pt->main_mcu_command_message.command);
     temp_tx_message_pt->main_mcu_command_message.command = MAIN_MCU_COMMAND_PING;
-    comms_aux_mcu_send_message(TRUE);
     
-    /* Wait for answer: no need to parse answer as filter is done in comms_aux_mcu_active_wait */
-    return_val = comms_aux_mcu_active_wait(&temp_rx_message_pt, FALSE, AUX_MCU_MSG_TYPE_MAIN_MCU_CMD);
-    
-    /* Rearm receive */
-    comms_aux_arm_rx_and_clear_no_comms();
+    /* Send and wait for answer: no need to parse answer as filter is done on the reply type */
+    transaction_handle = comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_MAIN_MCU_CMD, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, 0, 0);
+    if (comms_aux_mcu_wait_for_transaction(transaction_handle, MSG_RESTRICT_ALL) == AUX_MCU_TRANS_REPLIED)
+    {
+        return_val = RETURN_OK;
+    }
+    comms_aux_mcu_free_transaction(transaction_handle);
     
     return return_val;
 }
@@ -147,162 +613,164 @@ RET_TYPE comms_aux_mcu_send_receive_ping(void)
 */
 void comms_aux_mcu_routine(msg_restrict_type_te answer_restrict_type)
 {	
-    /* Ongoing RX transfer received bytes */
-    uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(aux_mcu_receive_message) - dma_aux_mcu_get_remaining_bytes_for_rx_transfer();
+    #ifdef AUX_LINK_CRC_ENABLED
+    /* Retransmission request follow up */
+    comms_aux_mcu_link_nack_routine();
+    #endif
+    
+    /* Oldest message, either fully received or being received */
+    cpu_irq_enter_critical();
+    uint16_t message_seq = aux_mcu_rx_read_seq;
+    BOOL message_fully_received = (aux_mcu_rx_dma_seq != message_seq)? TRUE : FALSE;
+    BOOL message_being_received = (dma_aux_mcu_is_rx_transfer_to_be_rearmed() == FALSE)? TRUE : FALSE;
+    uint16_t nb_received_bytes_for_ongoing_transfer = sizeof(aux_mcu_message_t) - dma_aux_mcu_get_remaining_bytes_for_rx_transfer();
+    cpu_irq_leave_critical();
+    aux_mcu_message_t* aux_mcu_receive_message_pt = comms_aux_mcu_get_rx_slot(message_seq);
+    BOOL* answered_using_first_bytes_pt = &aux_mcu_message_answered_using_first_bytes[message_seq % AUX_MCU_RX_NB_SLOTS];
     
     /* Bool to treat packet */
     BOOL should_deal_with_packet = FALSE;
     
-    /* Bool to specify if we should rearm RX DMA transfer */
-    BOOL arm_rx_transfer = FALSE;
-    
     /* Received message payload length */
-    uint16_t payload_length;
+    uint16_t payload_length = 0;
     
-    /* First part of message */
-    if ((nb_received_bytes_for_ongoing_transfer >= sizeof(aux_mcu_receive_message.message_type) + sizeof(aux_mcu_receive_message.payload_length1)) && (aux_mcu_message_answered_using_first_bytes == FALSE))
+    if (message_fully_received != FALSE)
     {
-        /* Check if we were too slow to deal with the message before complete packet transfer */
-        if (dma_aux_mcu_check_and_clear_dma_transfer_flag() != FALSE)
+        /* Message integrity & sequence number check */
+        BOOL message_accepted = TRUE;
+        #ifdef AUX_LINK_CRC_ENABLED
+        message_accepted = comms_aux_mcu_link_accept_message(aux_mcu_receive_message_pt);
+        #endif
+        
+        /* Complete packet receive, treat packet if not already dealt with and valid flag is set or payload length #1 != 0 */
+        if ((*answered_using_first_bytes_pt == FALSE) && (message_accepted != FALSE))
         {
-            /* Complete packet receive, treat packet if valid flag is set or payload length #1 != 0 */
-            aux_mcu_message_answered_using_first_bytes = FALSE;            
-            
-            if (aux_mcu_receive_message.payload_length1 != 0)
+            if (aux_mcu_receive_message_pt->payload_length1 != 0)
             {
-                arm_rx_transfer = TRUE;
                 should_deal_with_packet = TRUE;
-                payload_length = aux_mcu_receive_message.payload_length1;
+                payload_length = aux_mcu_receive_message_pt->payload_length1;
             }
-            else if (aux_mcu_receive_message.rx_payload_valid_flag != 0)
+            else if (aux_mcu_receive_message_pt->rx_payload_valid_flag != 0)
             {
-                arm_rx_transfer = TRUE;
                 should_deal_with_packet = TRUE;
-                payload_length = aux_mcu_receive_message.payload_length2;                
-            }
-            else
-            {
-                /* Arm next RX DMA transfer */
-                comms_aux_arm_rx_and_clear_no_comms();
+                payload_length = aux_mcu_receive_message_pt->payload_length2;
             }
-        } 
-        else if ((aux_mcu_receive_message.payload_length1 != 0) && (nb_received_bytes_for_ongoing_transfer >= sizeof(aux_mcu_receive_message.message_type) + sizeof(aux_mcu_receive_message.payload_length1) + aux_mcu_receive_message.payload_length1))
-        {
-            /* First part receive, payload is small enough so we can answer */
-            should_deal_with_packet = TRUE;
-            aux_mcu_message_answered_using_first_bytes = TRUE;
-            payload_length = aux_mcu_receive_message.payload_length1;
-        } 
+        }
     }
-    else if (dma_aux_mcu_check_and_clear_dma_transfer_flag() != FALSE)
+    #ifndef AUX_LINK_CRC_ENABLED
+    else if ((message_being_received != FALSE) && (*answered_using_first_bytes_pt == FALSE) && (aux_mcu_receive_message_pt->payload_length1 != 0) && (nb_received_bytes_for_ongoing_transfer >= sizeof(aux_mcu_receive_message_pt->message_type) + sizeof(aux_mcu_receive_message_pt->payload_length1) + aux_mcu_receive_message_pt->payload_length1) && (comms_aux_mcu_is_reply_expected(aux_mcu_receive_message_pt->message_type) == FALSE))
     {
-        /* Second part transfer, check if we have already dealt with this packet and if it is valid */
-        if ((aux_mcu_message_answered_using_first_bytes == FALSE) && ((aux_mcu_receive_message.payload_length1 != 0) || ((aux_mcu_receive_message.payload_length1 == 0) && (aux_mcu_receive_message.rx_payload_valid_flag != 0))))
-        {
-            arm_rx_transfer = TRUE;
-            should_deal_with_packet = TRUE;            
-            if (aux_mcu_receive_message.payload_length1 == 0)
-            {
-                payload_length = aux_mcu_receive_message.payload_length2;
-            } 
-            else
-            {
-                payload_length = aux_mcu_receive_message.payload_length1;
-            }            
-        }
-        else
-        {
-            /* Arm next RX DMA transfer */
-            comms_aux_arm_rx_and_clear_no_comms();
-        }
-        
-        /* Reset bool */
-        aux_mcu_message_answered_using_first_bytes = FALSE;
+        /* First part receive, payload is small enough so we can answer */
+        should_deal_with_packet = TRUE;
+        *answered_using_first_bytes_pt = TRUE;
+        payload_length = aux_mcu_receive_message_pt->payload_length1;
     }
+    #else
+    /* Messages are only dealt with once fully received, as their CRC covers them entirely */
+    (void)message_being_received;
+    (void)nb_received_bytes_for_ongoing_transfer;
+    #endif
     
-    /* Return if we shouldn't deal with packet, or if payload has the incorrect size */
-    if ((should_deal_with_packet == FALSE) || (payload_length > AUX_MCU_MSG_PAYLOAD_LENGTH))
+    /* Check payload size */
+    if (payload_length > AUX_MCU_MSG_PAYLOAD_LENGTH)
     {
-        /* Note: there's a case where we don't rearm DMA if the message is valid but payload is too long... was lazy to implement it */
-        return;
+        should_deal_with_packet = FALSE;
     }
-            
-    /* USB / BLE Messages */
-    if ((aux_mcu_receive_message.message_type == AUX_MCU_MSG_TYPE_USB) || (aux_mcu_receive_message.message_type == AUX_MCU_MSG_TYPE_BLE))
+    
+    if (should_deal_with_packet != FALSE)
     {
-        /* Cast payloads into correct type */
-        int16_t hid_reply_payload_length = -1;
-        
-        /* Store message type */
-        uint16_t receive_message_type = aux_mcu_receive_message.message_type;
-                
-        /* Clear TX message just in case */
-        memset((void*)&aux_mcu_send_message, 0, sizeof(aux_mcu_send_message));
-                
-        /* Parse message */
-        #ifndef DEBUG_USB_COMMANDS_ENABLED
-        hid_reply_payload_length = comms_hid_msgs_parse(&aux_mcu_receive_message.hid_message, payload_length - sizeof(aux_mcu_receive_message.hid_message.message_type) - sizeof(aux_mcu_receive_message.hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
-        #else
-        if (aux_mcu_receive_message.hid_message.message_type >= HID_MESSAGE_START_CMD_ID_DBG)
+        /* Reply to one of our requests: only for its transaction, the tag is at the end of the message */
+        if ((message_fully_received != FALSE) && (comms_aux_mcu_deliver_transaction_reply(aux_mcu_receive_message_pt) != FALSE))
         {
-            hid_reply_payload_length = comms_hid_msgs_parse_debug(&aux_mcu_receive_message.hid_message, payload_length - sizeof(aux_mcu_receive_message.hid_message.message_type) - sizeof(aux_mcu_receive_message.hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
+            asm("Nop");
         }
-        else
-        {
-            hid_reply_payload_length = comms_hid_msgs_parse(&aux_mcu_receive_message.hid_message, payload_length - sizeof(aux_mcu_receive_message.hid_message.message_type) - sizeof(aux_mcu_receive_message.hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
-        }
-        #endif
-                
-        /* Send reply if needed */
-        if (hid_reply_payload_length >= 0)
+        /* USB / BLE Messages */
+        else if ((aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_USB) || (aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_BLE))
         {
-            /* Set same message type and compute payload size */
-            aux_mcu_send_message.message_type = receive_message_type;
-            aux_mcu_send_message.payload_length1 = hid_reply_payload_length + sizeof(aux_mcu_receive_message.hid_message.message_type) + sizeof(aux_mcu_receive_message.hid_message.payload_length);
+            /* Cast payloads into correct type */
+            int16_t hid_reply_payload_length = -1;
+            
+            /* Message type kept for our reply: a handler that blocks releases the message first */
+            uint16_t hid_message_type = aux_mcu_receive_message_pt->message_type;
+            
+            /* Store message type, for the replies sent later by the transactions the request starts */
+            aux_mcu_parsed_hid_message_type = hid_message_type;
                     
-            /* Send message */
-            comms_aux_mcu_send_message(FALSE);
+            /* Clear TX message just in case */
+            memset((void*)&aux_mcu_send_message, 0, sizeof(aux_mcu_send_message));
+                    
+            /* Parse message */
+            #ifndef DEBUG_USB_COMMANDS_ENABLED
+            hid_reply_payload_length = comms_hid_msgs_parse(&aux_mcu_receive_message_pt->hid_message, payload_length - sizeof(aux_mcu_receive_message_pt->hid_message.message_type) - sizeof(aux_mcu_receive_message_pt->hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
+            #else
+            if (aux_mcu_receive_message_pt->hid_message.message_type >= HID_MESSAGE_START_CMD_ID_DBG)
+            {
+                hid_reply_payload_length = comms_hid_msgs_parse_debug(&aux_mcu_receive_message_pt->hid_message, payload_length - sizeof(aux_mcu_receive_message_pt->hid_message.message_type) - sizeof(aux_mcu_receive_message_pt->hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
+            }
+            else
+            {
+                hid_reply_payload_length = comms_hid_msgs_parse(&aux_mcu_receive_message_pt->hid_message, payload_length - sizeof(aux_mcu_receive_message_pt->hid_message.message_type) - sizeof(aux_mcu_receive_message_pt->hid_message.payload_length), &aux_mcu_send_message.hid_message, answer_restrict_type);
+            }
+            #endif
+                    
+            /* Send reply if needed */
+            if (hid_reply_payload_length >= 0)
+            {
+                comms_aux_mcu_send_hid_reply(hid_reply_payload_length, hid_message_type);
+            }
+        } 
+        else if (aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_BOOTLOADER)
+        {
+            asm("Nop");
+        }   
+        else if (aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_MAIN_MCU_CMD)
+        {
+            asm("Nop");
         }
-    } 
-    else if (aux_mcu_receive_message.message_type == AUX_MCU_MSG_TYPE_BOOTLOADER)
-    {
-        asm("Nop");
-    }   
-    else if (aux_mcu_receive_message.message_type == AUX_MCU_MSG_TYPE_MAIN_MCU_CMD)
-    {
-        asm("Nop");
-    }
-    else if (aux_mcu_receive_message.message_type == AUX_MCU_MSG_TYPE_AUX_MCU_EVENT)
-    {
-        if (aux_mcu_receive_message.main_mcu_command_message.command == AUX_MCU_EVENT_BLE_ENABLED)
+        else if (aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_AUX_MCU_EVENT)
+        {
+            if (aux_mcu_receive_message_pt->main_mcu_command_message.command == AUX_MCU_EVENT_BLE_ENABLED)
+            {
+                /* BLE just got enabled */
+                logic_aux_mcu_set_ble_enabled_bool(TRUE);
+            }
+        }  
+        #ifdef AUX_LINK_CRC_ENABLED
+        else if (aux_mcu_receive_message_pt->message_type == AUX_MCU_MSG_TYPE_LINK_NACK)
         {
-            /* BLE just got enabled */
-            logic_aux_mcu_set_ble_enabled_bool(TRUE);
+            /* Aux MCU didn't get some of our messages */
+            comms_aux_mcu_link_retransmit(aux_mcu_receive_message_pt->link_nack_message.expected_seq);
         }
-    }  
-    else
-    {
-        asm("Nop");        
-    } 
+        #endif
+        else
+        {
+            asm("Nop");        
+        } 
+    }
     
-    /* If we need to rearm RX */
-    if (arm_rx_transfer != FALSE)
+    /* Fully received message dealt with (or invalid): release its slot, unless the parser already did */
+    if (message_fully_received != FALSE)
     {
-        comms_aux_arm_rx_and_clear_no_comms();
-    }          
+        comms_aux_mcu_release_rx_message(message_seq);
+        
+        /* Aux MCU can send again once the ring has room */
+        comms_aux_mcu_clear_no_comms_if_rx_room();
+    }
+    
+    /* Requests that didn't get a reply in time */
+    comms_aux_mcu_check_transaction_timeouts();
 }
 
-/*! \fn     comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, BOOL do_not_touch_dma_flags, uint16_t expected_packet)
+/*! \fn     comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, uint16_t expected_packet)
 *   \brief  Active wait for a message from the aux MCU. 
 *   \param  rx_message_pt_pt        Pointer to where to store the pointer to the received message
-*   \param  do_not_touch_dma_logic  Set to TRUE to not mess with the DMA flags
 *   \param  expected_packet         Expected packet
 *   \return OK if a message was received
 *   \note   Special care must be taken to discard other message we don't want (either with a please_retry or other mechanisms)
-*   \note   DMA RX arm must be called to rearm message receive as a rearm in this code would enable data to be overwritten
+*   \note   Received message stays in its ring slot until comms_aux_arm_rx_and_clear_no_comms / comms_aux_arm_rx_and_set_no_comms is called
 *   \note   This function is not touching the no comms signal
 */
-RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, BOOL do_not_touch_dma_flags, uint16_t expected_packet)
+RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, uint16_t expected_packet)
 {
     /* Bool for the do{} */
     BOOL reloop = FALSE;
@@ -316,68 +784,81 @@ RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, BOOL do
         reloop = FALSE;
         
         /* Wait for complete message to be received */
-        BOOL dma_check_return = FALSE;
         timer_flag_te timer_flag_return = TIMER_RUNNING;
-        while((dma_check_return == FALSE) && (timer_flag_return == TIMER_RUNNING))
+        while((aux_mcu_rx_dma_seq == aux_mcu_rx_read_seq) && (timer_flag_return == TIMER_RUNNING))
         {
-            if (do_not_touch_dma_flags == FALSE)
-            {
-                dma_check_return = dma_aux_mcu_check_and_clear_dma_transfer_flag();                
-            } 
-            else
-            {
-                dma_check_return = dma_aux_mcu_check_dma_transfer_flag();
-            }
             timer_flag_return = timer_has_timer_expired(TIMER_TIMEOUT_FUNCTS, FALSE);
         }
         
         /* Did the timer expire? */
-        if (dma_check_return == FALSE)
+        if (aux_mcu_rx_dma_seq == aux_mcu_rx_read_seq)
         {
             return RETURN_NOK;
         }
         
+        /* Oldest received message */
+        aux_mcu_message_t* aux_mcu_receive_message_pt = comms_aux_mcu_get_rx_slot(aux_mcu_rx_read_seq);
+        
         /* Get payload length */
         uint16_t payload_length;
-        if (aux_mcu_receive_message.payload_length1 != 0)
+        if (aux_mcu_receive_message_pt->payload_length1 != 0)
         {
-            payload_length = aux_mcu_receive_message.payload_length1;
+            payload_length = aux_mcu_receive_message_pt->payload_length1;
         }
         else
         {
-            payload_length = aux_mcu_receive_message.payload_length2;
+            payload_length = aux_mcu_receive_message_pt->payload_length2;
         }
         
-        /* Check if message is invalid */
-        if ((payload_length > AUX_MCU_MSG_PAYLOAD_LENGTH) || ((aux_mcu_receive_message.payload_length1 == 0) && (aux_mcu_receive_message.rx_payload_valid_flag == 0)))
-        {
-            /* Reloop, rearm receive */
-            reloop = TRUE;
-            if (do_not_touch_dma_flags != FALSE)
-            {
-                dma_aux_mcu_check_and_clear_dma_transfer_flag();
-            }
-            dma_aux_mcu_init_rx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_receive_message, sizeof(aux_mcu_receive_message));
-        }        
+        /* Message integrity & sequence number check */
+        BOOL message_accepted = TRUE;
+        #ifdef AUX_LINK_CRC_ENABLED
+        message_accepted = comms_aux_mcu_link_accept_message(aux_mcu_receive_message_pt);
+        #endif
         
-        /* Check if received message is the one we expected */
-        if (aux_mcu_receive_message.message_type != expected_packet)
+        /* Check if message is invalid or if received message isn't the one we expected */
+        if ((message_accepted == FALSE) || (payload_length > AUX_MCU_MSG_PAYLOAD_LENGTH) || ((aux_mcu_receive_message_pt->payload_length1 == 0) && (aux_mcu_receive_message_pt->rx_payload_valid_flag == 0)) || (aux_mcu_receive_message_pt->message_type != expected_packet))
         {
-            /* Reloop, rearm receive */
+            /* Reloop, release message */
             reloop = TRUE;
-            if (do_not_touch_dma_flags != FALSE)
-            {
-                dma_aux_mcu_check_and_clear_dma_transfer_flag();
-            }
-            dma_aux_mcu_init_rx_transfer((void*)&AUXMCU_SERCOM->USART.DATA.reg, (void*)&aux_mcu_receive_message, sizeof(aux_mcu_receive_message));
+            comms_aux_mcu_release_rx_message(aux_mcu_rx_read_seq);
             
             // TODO: take necessary action in case we received an unwanted message
         }
+        else
+        {
+            /* Store pointer to message */
+            *rx_message_pt_pt = aux_mcu_receive_message_pt;
+        }
     }while (reloop != FALSE);
         
-    /* Store pointer to message */
-    *rx_message_pt_pt = &aux_mcu_receive_message;
-        
     /* Return OK */
     return RETURN_OK;
 }
+
+#ifdef DEBUG_TRACE_ENABLED
+/*! \fn     comms_trace_get_hid_message(void)
+*   \brief  Get the HID message to write trace entries in, forwarded to the USB host by the aux MCU
+*   \return 0 if the aux MCU link is busy
+*/
+hid_message_t* comms_trace_get_hid_message(void)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    
+    if (dma_aux_mcu_is_tx_transfer_done() == FALSE)
+    {
+        return 0;
+    }
+    comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_USB, 0);
+    return &temp_tx_message_pt->hid_message;
+}
+
+/*! \fn     comms_trace_send_hid_message(void)
+*   \brief  Send the trace HID message, without waiting for the transfer to end
+*/
+void comms_trace_send_hid_message(void)
+{
+    aux_mcu_send_message.payload_length1 = aux_mcu_send_message.hid_message.payload_length + sizeof(aux_mcu_send_message.hid_message.payload_length) + sizeof(aux_mcu_send_message.hid_message.message_type);
+    comms_aux_mcu_send_message(FALSE);
+}
+#endif
@@ -14,6 +14,12 @@
 #include "defines.h"
 
 /* Defines */
+// Number of messages from aux MCU that can be queued, must be a power of 2
+#define AUX_MCU_RX_NB_SLOTS             4
+#if (AUX_MCU_RX_NB_SLOTS & (AUX_MCU_RX_NB_SLOTS - 1)) != 0
+    #error "AUX_MCU_RX_NB_SLOTS must be a power of 2"
+#endif
+
 // Aux MCU Message Type
 #define AUX_MCU_MSG_TYPE_USB            0x0000
 #define AUX_MCU_MSG_TYPE_BLE            0x0001
@@ -22,6 +28,8 @@
 #define AUX_MCU_MSG_TYPE_MAIN_MCU_CMD   0x0004
 #define AUX_MCU_MSG_TYPE_AUX_MCU_EVENT  0x0005
 #define AUX_MCU_MSG_TYPE_NIMH_CHARGE    0x0006
+#define AUX_MCU_MSG_TYPE_LINK_NACK      0x0007
+#define AUX_MCU_MSG_TYPE_KEYBOARD_TYPE  0x0008
 
 // Main MCU commands
 #define MAIN_MCU_COMMAND_SLEEP          0x0001
@@ -33,9 +41,24 @@
 // Aux MCU events
 #define AUX_MCU_EVENT_BLE_ENABLED       0x0001
 
-// Flags
+// Keyboard typing: interfaces, max number of keys in a message, status sent back once done
+#define KEYBOARD_TYPE_INTERFACE_USB     0x0000
+#define KEYBOARD_TYPE_INTERFACE_BLE     0x0001
+#define KEYBOARD_TYPE_MAX_NB_KEYS       128
+#define KEYBOARD_TYPE_STATUS_FAILED     0x0000
+#define KEYBOARD_TYPE_STATUS_TYPED      0x0001
+
+// Flags: a reply request with the tag bit set carries a transaction tag, echoed in the reply
 #define TX_NO_REPLY_REQUEST_FLAG        0x0000
 #define TX_REPLY_REQUEST_FLAG           0x0001
+#define TX_REPLY_REQUEST_TAG_FLAG       0x8000
+
+// Number of requests to the aux MCU that can be pending at the same time
+#define AUX_MCU_NB_TRANSACTIONS         4
+#define AUX_MCU_INVALID_TRANS_HANDLE    -1
+
+/* Enums */
+typedef enum {AUX_MCU_TRANS_FREE = 0, AUX_MCU_TRANS_PENDING = 1, AUX_MCU_TRANS_REPLIED = 2, AUX_MCU_TRANS_TIMEOUT = 3} aux_mcu_trans_state_te;
 
 /* Typedefs */
 typedef struct
@@ -73,6 +96,26 @@ typedef struct
     int16_t charge_current;
 } nimh_charge_message_t;
 
+typedef struct  
+{
+    uint16_t expected_seq;
+} aux_link_nack_message_t;
+
+typedef struct
+{
+    uint8_t modifier;
+    uint8_t keycode;
+} keyboard_key_t;
+
+typedef struct
+{
+    uint16_t interface_identifier;
+    uint16_t delay_between_reports;
+    uint16_t typed_status;
+    uint16_t nb_keys;
+    keyboard_key_t keys[];
+} keyboard_type_message_t;
+
 typedef struct
 {
     uint16_t message_type;
@@ -84,6 +127,8 @@ typedef struct
         main_mcu_command_message_t main_mcu_command_message;
         aux_mcu_event_message_t aux_mcu_event_message;
         nimh_charge_message_t nimh_charge_message;
+        aux_link_nack_message_t link_nack_message;
+        keyboard_type_message_t keyboard_type_message;
         hid_message_t hid_message;
         uint8_t payload[AUX_MCU_MSG_PAYLOAD_LENGTH];
         uint32_t payload_as_uint32[AUX_MCU_MSG_PAYLOAD_LENGTH/4];    
@@ -94,12 +139,38 @@ typedef struct
         uint16_t rx_payload_valid_flag;
         uint16_t tx_reply_request_flag;        
     };
+    #ifdef AUX_LINK_CRC_ENABLED
+    uint16_t link_seq;
+    uint16_t link_crc;
+    #endif
 } aux_mcu_message_t;
 
+// Reply callback: reply_pt is 0 if no reply arrived before the timeout, reply is released once the callback returns
+// hid_reply_message_type is the channel (USB / BLE) of the HID request that started the transaction
+typedef void (*aux_mcu_trans_callback_t)(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type);
+
+typedef struct
+{
+    aux_mcu_trans_state_te state;
+    uint16_t correlation_id;
+    uint16_t expected_reply_type;
+    uint32_t timeout_systick;
+    aux_mcu_message_t* reply_pt;
+    aux_mcu_trans_callback_t callback;
+    uint16_t hid_reply_message_type;
+} aux_mcu_transaction_t;
+
 
 /* Prototypes */
 void comms_aux_mcu_get_empty_packet_ready_to_be_sent(aux_mcu_message_t** message_pt_pt, uint16_t message_type, uint16_t tx_reply_request_flag);
-RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, BOOL do_not_touch_dma_flags, uint16_t expected_packet);
+int16_t comms_aux_mcu_send_transaction(uint16_t expected_reply_type, uint16_t timeout_ms, aux_mcu_message_t* reply_pt, aux_mcu_trans_callback_t callback);
+aux_mcu_trans_state_te comms_aux_mcu_wait_for_transaction(int16_t handle, msg_restrict_type_te answer_restrict_type);
+RET_TYPE comms_aux_mcu_active_wait(aux_mcu_message_t** rx_message_pt_pt, uint16_t expected_packet);
+aux_mcu_trans_state_te comms_aux_mcu_get_transaction_state(int16_t handle);
+void comms_aux_mcu_send_hid_reply(int16_t hid_reply_payload_length, uint16_t reply_message_type);
+void comms_aux_mcu_free_transaction(int16_t handle);
+void comms_aux_mcu_rx_transfer_done_irq_handler(void);
+void comms_aux_mcu_wait_for_message_received(void);
 void comms_aux_mcu_routine(msg_restrict_type_te answer_restrict_type);
 aux_mcu_message_t* comms_aux_mcu_get_temp_tx_message_object_pt(void);
 void comms_aux_mcu_send_simple_command_message(uint16_t command);
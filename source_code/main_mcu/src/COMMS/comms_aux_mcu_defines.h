@@ -14,5 +14,14 @@
 // HID payload size
 #define HID_PAYLOAD_SIZE            64
 
+// Uncomment to add a sequence number & CRC to aux link messages, with retransmission of corrupted ones. Changes the message size: both MCUs (and the aux MCU bootloader) must be built with it
+//#define AUX_LINK_CRC_ENABLED
+
+// Number of sent messages kept for retransmission
+#define AUX_LINK_TX_HISTORY_LENGTH  2
+
+// Delay after which a retransmission request is sent again if the message it asked for didn't arrive
+#define AUX_LINK_NACK_RETRY_MS      20
+
 
 #endif /* COMMS_AUX_MCU_DEFINES_H_ */
\ No newline at end of file
@@ -7,22 +7,162 @@
 #include <string.h>
 #include "comms_hid_msgs.h" 
 #include "comms_aux_mcu.h"
+#include "comms_stream.h"
+#include "comms_trace.h"
+#include "driver_timer.h"
 #include "nodemgmt.h"
 #include "defines.h"
 #include "dbflash.h"
 #include "dma.h"
+/* Command handlers */
+static int16_t comms_hid_msgs_ping(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_set_date(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_cancel_request(hid_message_t* rcv_msg, hid_message_t* send_msg);
+/* Set when the computer asks us to cancel the ongoing prompt */
+BOOL comms_hid_msgs_cancel_request_flag = FALSE;
+/* Command table: payload lengths are the ones each handler reads, PLAT_INFO takes no payload and SET_DATE a single uint16_t date. Frames with other lengths were previously handled regardless of their payload: they are now silently dropped like frames with an inconsistent length field */
+const hid_cmd_entry_t comms_hid_msgs_cmd_table[] = 
+{
+    {HID_CMD_ID_PING,          0,                                   HID_MSG_MAX_PAYLOAD_LENGTH,          HID_CMD_ALLOW_ALWAYS,        HID_CMD_FLAG_NONE,       comms_hid_msgs_ping},
+    {HID_CMD_ID_PLAT_INFO,     0,                                   0,                                   HID_CMD_ALLOW_UNRESTRICTED,  HID_CMD_FLAG_NONE,       comms_hid_msgs_plat_info},
+    {HID_CMD_ID_SET_DATE,      sizeof(uint16_t),                    sizeof(uint16_t),                    HID_CMD_ALLOW_UNRESTRICTED,  HID_CMD_FLAG_NONE,       comms_hid_msgs_set_date},
+    {HID_CMD_ID_CANCEL_REQ,    0,                                   0,                                   HID_CMD_ALLOW_UNRESTRICTED | HID_CMD_ALLOW(MSG_RESTRICT_ALLBUT_CANCEL), HID_CMD_FLAG_NONE, comms_hid_msgs_cancel_request},
+    {HID_CMD_ID_STREAM_START,  sizeof(hid_message_stream_start_t),  sizeof(hid_message_stream_start_t),  HID_CMD_ALLOW_UNRESTRICTED,  HID_CMD_FLAG_NONE,       comms_stream_start},
+    {HID_CMD_ID_STREAM_DATA,   sizeof(hid_message_stream_data_t),   HID_MSG_MAX_PAYLOAD_LENGTH,          HID_CMD_ALLOW_UNRESTRICTED,  HID_CMD_FLAG_MAY_BLOCK,  comms_stream_data},
+    {0,                        0,                                   0,                                   HID_CMD_ALLOW_UNRESTRICTED,  HID_CMD_FLAG_NONE,       0}
+};
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+/* Per command statistics, same order as the table above */
+hid_cmd_stats_t comms_hid_msgs_cmd_stats[sizeof(comms_hid_msgs_cmd_table)/sizeof(comms_hid_msgs_cmd_table[0])];
+#endif
 
 
-/*! \fn     comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
-*   \brief  Parse an incoming message from USB or BLE
+/*! \fn     comms_hid_msgs_fill_plat_info(hid_message_t* send_msg, aux_mcu_message_t* reply_pt)
+*   \brief  Write a platform info reply
+*   \param  send_msg    Where to write the reply
+*   \param  reply_pt    Aux MCU details, 0 to leave the aux MCU versions to 0
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_fill_plat_info(hid_message_t* send_msg, aux_mcu_message_t* reply_pt)
+{
+    send_msg->platform_info.main_mcu_fw_major = FW_MAJOR;
+    send_msg->platform_info.main_mcu_fw_minor = FW_MINOR;
+    if (reply_pt != 0)
+    {
+        send_msg->platform_info.aux_mcu_fw_major = reply_pt->aux_details_message.aux_fw_ver_major;
+        send_msg->platform_info.aux_mcu_fw_minor = reply_pt->aux_details_message.aux_fw_ver_minor;
+    }
+    send_msg->platform_info.plat_serial_number = 12345678;
+    send_msg->platform_info.memory_size = DBFLASH_CHIP;
+    send_msg->payload_length = sizeof(send_msg->platform_info);
+    return sizeof(send_msg->platform_info);
+}
+
+/*! \fn     comms_hid_msgs_plat_info_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+*   \brief  Answer a platform info request once the aux MCU details arrived
+*   \param  reply_pt                Aux MCU details, 0 if they didn't arrive in time
+*   \param  hid_reply_message_type  Channel the request came from
+*/
+static void comms_hid_msgs_plat_info_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    
+    /* Get an empty packet, aux MCU versions left to 0 if no reply */
+    comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, hid_reply_message_type, TX_NO_REPLY_REQUEST_FLAG);
+    temp_tx_message_pt->hid_message.message_type = HID_CMD_ID_PLAT_INFO;
+    comms_aux_mcu_send_hid_reply(comms_hid_msgs_fill_plat_info(&temp_tx_message_pt->hid_message, reply_pt), hid_reply_message_type);
+}
+
+/*! \fn     comms_hid_msgs_ping(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Simple ping: copy the message contents
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_ping(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    memcpy((void*)send_msg->payload, (void*)rcv_msg->payload, rcv_msg->payload_length);
+    send_msg->payload_length = rcv_msg->payload_length;
+    return send_msg->payload_length;
+}
+
+/*! \fn     comms_hid_msgs_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Ask the aux MCU for its details: the reply is sent by the callback, main loop keeps running in the mean time
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply if it can't wait
+*   \return -1 as the reply is sent later, or reply payload length
+*/
+static int16_t comms_hid_msgs_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    
+    comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
+    if (comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_PLAT_DETAILS, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, 0, comms_hid_msgs_plat_info_callback) == AUX_MCU_INVALID_TRANS_HANDLE)
+    {
+        /* Too many pending requests, answer now without aux MCU details in the packet we just cleared */
+        send_msg->message_type = rcv_msg->message_type;
+        return comms_hid_msgs_fill_plat_info(send_msg, 0);
+    }
+    return -1;
+}
+
+/*! \fn     comms_hid_msgs_set_date(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Set current date
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_set_date(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    nodemgmt_set_current_date(rcv_msg->payload_as_uint16[0]);
+    
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_cancel_request(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Cancel request, allowed while prompting the user: the prompt picks it up through comms_hid_msgs_cancel_request_received()
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Unused
+*   \return -1, no reply
+*/
+static int16_t comms_hid_msgs_cancel_request(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    (void)send_msg;
+    comms_hid_msgs_cancel_request_flag = TRUE;
+    return -1;
+}
+
+/*! \fn     comms_hid_msgs_cancel_request_received(void)
+*   \brief  Check if the computer asked to cancel the ongoing prompt, clearing the request
+*   \return RETURN_OK if a cancel request was received
+*/
+RET_TYPE comms_hid_msgs_cancel_request_received(void)
+{
+    if (comms_hid_msgs_cancel_request_flag != FALSE)
+    {
+        comms_hid_msgs_cancel_request_flag = FALSE;
+        return RETURN_OK;
+    }
+    return RETURN_NOK;
+}
+
+/*! \fn     comms_hid_msgs_dispatch(const hid_cmd_entry_t* cmd_table, hid_cmd_stats_t* cmd_stats, hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+*   \brief  Check an incoming message against a command table and call its handler
+*   \param  cmd_table               Command table
+*   \param  cmd_stats               Per command statistics, same length as the table (unused if stats aren't enabled)
 *   \param  rcv_msg                 Received message
 *   \param  supposed_payload_length Supposed payload length
 *   \param  send_msg                Where to write a possible reply
 *   \param  answer_restrict_type    Enum restricting which messages we can answer
 *   \return something >= 0 if an answer needs to be sent, otherwise -1
 */
-int16_t comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
-{    
+int16_t comms_hid_msgs_dispatch(const hid_cmd_entry_t* cmd_table, hid_cmd_stats_t* cmd_stats, hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+{
     /* Check correct payload length */
     if ((supposed_payload_length != rcv_msg->payload_length) || (supposed_payload_length > sizeof(rcv_msg->payload)))
     {
@@ -30,85 +170,90 @@ int16_t comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_l
         return -1;
     }
     
-    /* Checks based on restriction type */
-    BOOL should_ignore_message = FALSE;
-    if ((answer_restrict_type == MSG_RESTRICT_ALL) && (rcv_msg->message_type != HID_CMD_ID_PING))
-    {
-        should_ignore_message = TRUE;
-    }
-    if ((answer_restrict_type == MSG_RESTRICT_ALLBUT_CANCEL) && (rcv_msg->message_type != HID_CMD_ID_PING) && (rcv_msg->message_type != HID_CMD_ID_CANCEL_REQ))
-    {
-        should_ignore_message = TRUE;
-    }
-    // TODO: deal with all but bundle
+    /* Look for the command, stopping at the terminating entry */
+    uint16_t cmd_index;
+    for (cmd_index = 0; (cmd_table[cmd_index].handler != 0) && (cmd_table[cmd_index].command_id != rcv_msg->message_type); cmd_index++);
+    const hid_cmd_entry_t* cmd_entry = &cmd_table[cmd_index];
     
     /* Depending on restriction, answer please retry */
-    if (should_ignore_message != FALSE)
+    if ((cmd_entry->allowed_restrict_types & HID_CMD_ALLOW(answer_restrict_type)) == 0)
     {
-        /* Send please retry */
         send_msg->message_type = HID_CMD_ID_RETRY;
         send_msg->payload_length = 0;
         return 0;
     }
     
+    /* Unknown command or wrong payload length for this command: silent error */
+    if ((cmd_entry->handler == 0) || (supposed_payload_length < cmd_entry->min_payload_length) || (supposed_payload_length > cmd_entry->max_payload_length))
+    {
+        return -1;
+    }
+    
     /* By default: copy the same CMD identifier for TX message */
     send_msg->message_type = rcv_msg->message_type;
-    uint16_t rcv_message_type = rcv_msg->message_type;
     
-    /* Switch on command id */
-    switch (rcv_msg->message_type)
+    #ifdef DEBUG_HID_CMD_STATS_ENABLED
+    hid_cmd_stats_t* stats = &cmd_stats[cmd_index];
+    uint32_t start_cycles = timer_get_cycle_count();
+    int16_t ret_val = cmd_entry->handler(rcv_msg, send_msg);
+    uint32_t nb_cycles = timer_get_cycle_count() - start_cycles;
+    stats->command_id = cmd_entry->command_id;
+    stats->flags = cmd_entry->flags;
+    stats->nb_calls++;
+    stats->total_cycles += nb_cycles;
+    if (nb_cycles > stats->max_cycles)
     {
-        case HID_CMD_ID_PING:
-        {
-            /* Simple ping: copy the message contents */
-            memcpy((void*)send_msg->payload, (void*)rcv_msg->payload, rcv_msg->payload_length);
-            send_msg->payload_length = rcv_msg->payload_length;
-            return send_msg->payload_length;
-        }
-        
-        case HID_CMD_ID_PLAT_INFO:
-        {
-            aux_mcu_message_t* temp_rx_message;
-            aux_mcu_message_t* temp_tx_message_pt;
-            
-            /* Generate our packet */
-            comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
-            
-            /* Wait for current packet reception and arm reception */
-            dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag();
-            comms_aux_arm_rx_and_set_no_comms();
-            
-            /* Send message */
-            comms_aux_mcu_send_message(TRUE);
-            
-            /* Wait for message from aux MCU */
-            while(comms_aux_mcu_active_wait(&temp_rx_message, TRUE, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
-            
-            /* Copy message contents into send packet */
-            send_msg->platform_info.main_mcu_fw_major = FW_MAJOR;
-            send_msg->platform_info.main_mcu_fw_minor = FW_MINOR;
-            send_msg->platform_info.aux_mcu_fw_major = temp_rx_message->aux_details_message.aux_fw_ver_major;
-            send_msg->platform_info.aux_mcu_fw_minor = temp_rx_message->aux_details_message.aux_fw_ver_minor;
-            send_msg->platform_info.plat_serial_number = 12345678;
-            send_msg->platform_info.memory_size = DBFLASH_CHIP;            
-            send_msg->payload_length = sizeof(send_msg->platform_info);
-            send_msg->message_type = rcv_message_type;
-            return sizeof(send_msg->platform_info);            
-        }
-        
-        case HID_CMD_ID_SET_DATE:
+        stats->max_cycles = nb_cycles;
+    }
+    return ret_val;
+    #else
+    (void)cmd_stats;
+    return cmd_entry->handler(rcv_msg, send_msg);
+    #endif
+}
+
+/*! \fn     comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+*   \brief  Parse an incoming message from USB or BLE
+*   \param  rcv_msg                 Received message
+*   \param  supposed_payload_length Supposed payload length
+*   \param  send_msg                Where to write a possible reply
+*   \param  answer_restrict_type    Enum restricting which messages we can answer
+*   \return something >= 0 if an answer needs to be sent, otherwise -1
+*/
+int16_t comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+{
+    uint16_t command_id = rcv_msg->message_type;
+    int16_t ret_val;
+    
+    COMMS_TRACE_2(TRACE_ID_HID_CMD_RECEIVED, command_id, supposed_payload_length);
+    #ifdef DEBUG_HID_CMD_STATS_ENABLED
+    ret_val = comms_hid_msgs_dispatch(comms_hid_msgs_cmd_table, comms_hid_msgs_cmd_stats, rcv_msg, supposed_payload_length, send_msg, answer_restrict_type);
+    #else
+    ret_val = comms_hid_msgs_dispatch(comms_hid_msgs_cmd_table, 0, rcv_msg, supposed_payload_length, send_msg, answer_restrict_type);
+    #endif
+    COMMS_TRACE_2(TRACE_ID_HID_CMD_ANSWERED, command_id, ret_val);
+    return ret_val;
+}
+
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+/*! \fn     comms_hid_msgs_copy_cmd_stats(hid_cmd_stats_t* dest, uint16_t max_nb_stats)
+*   \brief  Copy the statistics of the commands called at least once, then reset them
+*   \param  dest            Where to copy the statistics
+*   \param  max_nb_stats    Maximum number of statistics to copy
+*   \return Number of statistics copied
+*/
+uint16_t comms_hid_msgs_copy_cmd_stats(hid_cmd_stats_t* dest, uint16_t max_nb_stats)
+{
+    uint16_t nb_stats = 0;
+    
+    for (uint16_t i = 0; (i < sizeof(comms_hid_msgs_cmd_stats)/sizeof(comms_hid_msgs_cmd_stats[0])) && (nb_stats < max_nb_stats); i++)
+    {
+        if (comms_hid_msgs_cmd_stats[i].nb_calls != 0)
         {
-            /* Set Date */
-            nodemgmt_set_current_date(rcv_msg->payload_as_uint16[0]);
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
+            memcpy((void*)&dest[nb_stats++], (void*)&comms_hid_msgs_cmd_stats[i], sizeof(hid_cmd_stats_t));
         }
-        
-        default: break;
     }
-    
-    return -1;
+    memset((void*)comms_hid_msgs_cmd_stats, 0, sizeof(comms_hid_msgs_cmd_stats));
+    return nb_stats;
 }
+#endif
@@ -9,11 +9,22 @@
 #define COMMS_HID_MSGS_H_
 
 #include "comms_aux_mcu_defines.h"
+#include "platform_defines.h"
 #include "defines.h"
 
 /* Defines */
 #define HID_1BYTE_NACK      0x00
 #define HID_1BYTE_ACK       0x01
+#define HID_MSG_MAX_PAYLOAD_LENGTH  (AUX_MCU_MSG_PAYLOAD_LENGTH-sizeof(uint16_t)-sizeof(uint16_t))
+
+/* Command table flags */
+#define HID_CMD_FLAG_NONE       0x0000
+#define HID_CMD_FLAG_MAY_BLOCK  0x0001
+
+/* Restriction types in which a command is answered, see msg_restrict_type_te */
+#define HID_CMD_ALLOW(restrict_type)    (1 << (restrict_type))
+#define HID_CMD_ALLOW_ALWAYS            (HID_CMD_ALLOW(MSG_NO_RESTRICT) | HID_CMD_ALLOW(MSG_RESTRICT_ALL) | HID_CMD_ALLOW(MSG_RESTRICT_ALLBUT_BUNDLE) | HID_CMD_ALLOW(MSG_RESTRICT_ALLBUT_CANCEL))
+#define HID_CMD_ALLOW_UNRESTRICTED      (HID_CMD_ALLOW(MSG_NO_RESTRICT) | HID_CMD_ALLOW(MSG_RESTRICT_ALLBUT_BUNDLE))
 
 /* Command defines */
 #define HID_CMD_ID_PING         0x0001
@@ -21,6 +32,8 @@
 #define HID_CMD_ID_PLAT_INFO    0x0003
 #define HID_CMD_ID_SET_DATE     0x0004
 #define HID_CMD_ID_CANCEL_REQ   0x0005
+#define HID_CMD_ID_STREAM_START 0x0006
+#define HID_CMD_ID_STREAM_DATA  0x0007
 
 /* Typedefs */
 typedef struct
@@ -40,22 +53,79 @@ typedef struct
     uint16_t memory_size;
 } hid_message_plat_info_t;
 
+typedef struct
+{
+    uint16_t stream_type;
+    uint16_t reserved;
+    uint32_t total_length;
+} hid_message_stream_start_t;
+
+typedef struct
+{
+    uint16_t status;
+    uint16_t window;
+    uint16_t max_chunk_length;
+} hid_message_stream_start_reply_t;
+
+typedef struct
+{
+    uint16_t chunk_id;
+    uint8_t data[];
+} hid_message_stream_data_t;
+
+typedef struct
+{
+    uint16_t status;
+    uint16_t next_chunk_id;
+    uint16_t result;            // Consumer result in the last acknowledgement, e.g. number of stored credentials
+} hid_message_stream_ack_t;
+
 typedef struct
 {
     uint16_t message_type;
     uint16_t payload_length;
     union
     {
-        uint8_t payload[AUX_MCU_MSG_PAYLOAD_LENGTH-sizeof(uint16_t)-sizeof(uint16_t)];
-        uint16_t payload_as_uint16[(AUX_MCU_MSG_PAYLOAD_LENGTH-sizeof(uint16_t)-sizeof(uint16_t))/2];
-        uint32_t payload_as_uint32[(AUX_MCU_MSG_PAYLOAD_LENGTH-sizeof(uint16_t)-sizeof(uint16_t))/4];
+        uint8_t payload[HID_MSG_MAX_PAYLOAD_LENGTH];
+        uint16_t payload_as_uint16[HID_MSG_MAX_PAYLOAD_LENGTH/2];
+        uint32_t payload_as_uint32[HID_MSG_MAX_PAYLOAD_LENGTH/4];
         hid_message_detailed_plat_info_t detailed_platform_info;
         hid_message_plat_info_t platform_info;
+        hid_message_stream_start_t stream_start;
+        hid_message_stream_start_reply_t stream_start_reply;
+        hid_message_stream_data_t stream_data;
+        hid_message_stream_ack_t stream_ack;
     };
 } hid_message_t;
 
+/* Command table entry, a table is terminated by an entry with a null handler */
+typedef struct
+{
+    uint16_t command_id;
+    uint16_t min_payload_length;
+    uint16_t max_payload_length;
+    uint16_t allowed_restrict_types;    // HID_CMD_ALLOW() bitmask, terminating entry: used for unknown commands
+    uint16_t flags;                     // HID_CMD_FLAG_xxx
+    int16_t (*handler)(hid_message_t* rcv_msg, hid_message_t* send_msg);
+} hid_cmd_entry_t;
+
+/* Per command statistics, in CPU cycles */
+typedef struct
+{
+    uint16_t command_id;
+    uint16_t flags;
+    uint32_t nb_calls;
+    uint32_t total_cycles;
+    uint32_t max_cycles;
+} hid_cmd_stats_t;
+
 /* Prototypes */
+int16_t comms_hid_msgs_dispatch(const hid_cmd_entry_t* cmd_table, hid_cmd_stats_t* cmd_stats, hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type);
+RET_TYPE comms_hid_msgs_cancel_request_received(void);
 int16_t comms_hid_msgs_parse(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type);
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+uint16_t comms_hid_msgs_copy_cmd_stats(hid_cmd_stats_t* dest, uint16_t max_nb_stats);
+#endif
 
 
 #endif /* COMMS_HID_MSGS_H_ */
\ No newline at end of file
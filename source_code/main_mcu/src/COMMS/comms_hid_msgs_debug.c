@@ -12,10 +12,56 @@
 #include "comms_aux_mcu.h"
 #include "driver_sercom.h"
 #include "platform_io.h"
+#include "gui_dispatcher.h"
 #include "dataflash.h"
 #include "sh1122.h"
+#include "driver_timer.h"
 #include "main.h"
 #include "dma.h"
+/* Command handlers */
+static int16_t comms_hid_msgs_debug_open_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_send_to_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_close_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_erase_dataflash(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_is_dataflash_ready(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_dataflash_write_256b(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_reindex_bundle(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_start_bootloader(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_get_acc_32_samples(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_flash_aux_mcu(hid_message_t* rcv_msg, hid_message_t* send_msg);
+static int16_t comms_hid_msgs_debug_get_dbg_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg);
+#ifdef DEBUG_RENDER_STATS_ENABLED
+static int16_t comms_hid_msgs_debug_get_render_stats(hid_message_t* rcv_msg, hid_message_t* send_msg);
+#endif
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+static int16_t comms_hid_msgs_debug_get_cmd_stats(hid_message_t* rcv_msg, hid_message_t* send_msg);
+#endif
+/* Debug command table */
+const hid_cmd_entry_t comms_hid_msgs_debug_cmd_table[] = 
+{
+    {HID_CMD_ID_OPEN_DISP_BUFFER,      0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_open_disp_buffer},
+    {HID_CMD_ID_SEND_TO_DISP_BUFFER,   0,                     HID_MSG_MAX_PAYLOAD_LENGTH,  HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_send_to_disp_buffer},
+    {HID_CMD_ID_CLOSE_DISP_BUFFER,     0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_close_disp_buffer},
+    {HID_CMD_ID_ERASE_DATA_FLASH,      0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_erase_dataflash},
+    {HID_CMD_ID_IS_DATA_FLASH_READY,   0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_is_dataflash_ready},
+    {HID_CMD_ID_DATAFLASH_WRITE_256B,  sizeof(uint32_t)+256,  sizeof(uint32_t)+256,        HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_dataflash_write_256b},
+    {HID_CMD_ID_REINDEX_BUNDLE,        0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_reindex_bundle},
+    #ifdef DEBUG_RENDER_STATS_ENABLED
+    {HID_CMD_ID_GET_RENDER_STATS,      0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_get_render_stats},
+    #endif
+    #ifdef DEBUG_HID_CMD_STATS_ENABLED
+    {HID_CMD_ID_GET_CMD_STATS,         0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       comms_hid_msgs_debug_get_cmd_stats},
+    #endif
+    {HID_CMD_ID_START_BOOTLOADER,      0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_start_bootloader},
+    {HID_CMD_ID_GET_ACC_32_SAMPLES,    0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_get_acc_32_samples},
+    {HID_CMD_ID_FLASH_AUX_MCU,         0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_flash_aux_mcu},
+    {HID_CMD_ID_GET_DBG_PLAT_INFO,     0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_MAY_BLOCK,  comms_hid_msgs_debug_get_dbg_plat_info},
+    {0,                                0,                     0,                           HID_CMD_ALLOW_DEBUG,  HID_CMD_FLAG_NONE,       0}
+};
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+/* Per command statistics, same order as the table above */
+hid_cmd_stats_t comms_hid_msgs_debug_cmd_stats[sizeof(comms_hid_msgs_debug_cmd_table)/sizeof(comms_hid_msgs_debug_cmd_table[0])];
+#endif
 
 
 #ifdef DEBUG_USB_PRINTF_ENABLED
@@ -62,185 +108,399 @@ void comms_hid_msgs_debug_printf(const char *fmt, ...)
 #pragma GCC diagnostic pop
 #endif
 
-/*! \fn     comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
-*   \brief  Parse an incoming message from USB or BLE
-*   \param  rcv_msg                 Received message
-*   \param  supposed_payload_length Supposed payload length
-*   \param  send_msg                Where to write a possible reply
-*   \param  answer_restrict_type    Enum restricting which messages we can answer
-*   \return something >= 0 if an answer needs to be sent, otherwise -1
+/*! \fn     comms_hid_msgs_debug_display_stream_start(uint32_t total_length)
+*   \brief  Start streaming a full frame to the display
+*   \param  total_length    Stream length
+*   \return RETURN_OK if the stream is accepted
 */
-int16_t comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
-{    
-    /* Check correct payload length */
-    if ((supposed_payload_length != rcv_msg->payload_length) || (supposed_payload_length > sizeof(rcv_msg->payload)))
+RET_TYPE comms_hid_msgs_debug_display_stream_start(uint32_t total_length)
+{
+    /* 4 bits per pixel */
+    if (total_length != SH1122_OLED_WIDTH*SH1122_OLED_HEIGHT/2)
     {
-        /* Silent error */
-        return -1;
+        return RETURN_NOK;
     }
     
-    /* Checks based on restriction type */
-    BOOL should_ignore_message = FALSE;
-    if (answer_restrict_type == MSG_RESTRICT_ALL)
+    /* Set pixel write window, start filling the display RAM */
+    sh1122_set_row_address(&plat_oled_descriptor, 0);
+    sh1122_set_column_address(&plat_oled_descriptor, 0);
+    sh1122_start_data_sending(&plat_oled_descriptor);
+    return RETURN_OK;
+}
+
+/*! \fn     comms_hid_msgs_debug_display_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+*   \brief  Send streamed pixels to the display
+*   \param  data    Pixels
+*   \param  length  Number of bytes
+*   \param  offset  Offset in the stream
+*   \return RETURN_OK
+*/
+RET_TYPE comms_hid_msgs_debug_display_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+{
+    (void)offset;
+    for (uint16_t i = 0; i < length; i++)
     {
-        should_ignore_message = TRUE;
+        sercom_spi_send_single_byte_without_receive_wait(plat_oled_descriptor.sercom_pt, data[i]);
     }
+    return RETURN_OK;
+}
+
+/*! \fn     comms_hid_msgs_debug_display_stream_end(BOOL stream_complete)
+*   \brief  Stop streaming to the display
+*   \param  stream_complete FALSE if the stream was aborted
+*   \return 0
+*/
+uint16_t comms_hid_msgs_debug_display_stream_end(BOOL stream_complete)
+{
+    (void)stream_complete;
+    sercom_spi_wait_for_transmit_complete(plat_oled_descriptor.sercom_pt);
+    sh1122_stop_data_sending(&plat_oled_descriptor);
+    return 0;
+}
+
+/*! \fn     comms_hid_msgs_debug_dataflash_stream_start(uint32_t total_length)
+*   \brief  Start streaming a bundle to the (previously erased) dataflash
+*   \param  total_length    Stream length
+*   \return RETURN_OK
+*/
+RET_TYPE comms_hid_msgs_debug_dataflash_stream_start(uint32_t total_length)
+{
+    (void)total_length;
+    return RETURN_OK;
+}
+
+/*! \fn     comms_hid_msgs_debug_dataflash_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+*   \brief  Write streamed bundle bytes to the dataflash
+*   \param  data    Bundle bytes
+*   \param  length  Number of bytes
+*   \param  offset  Offset in the stream, written at the same dataflash address
+*   \return RETURN_OK
+*/
+RET_TYPE comms_hid_msgs_debug_dataflash_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+{
+    dataflash_write_array_to_memory(&dataflash_descriptor, offset, data, length);
+    return RETURN_OK;
+}
+
+/*! \fn     comms_hid_msgs_debug_dataflash_stream_end(BOOL stream_complete)
+*   \brief  Reindex the bundle once fully streamed
+*   \param  stream_complete FALSE if the stream was aborted
+*   \return 0
+*/
+uint16_t comms_hid_msgs_debug_dataflash_stream_end(BOOL stream_complete)
+{
+    if (stream_complete != FALSE)
+    {
+        /* Refresh file system and font */
+        custom_fs_init();
+        sh1122_refresh_used_font(&plat_oled_descriptor, DEFAULT_FONT_ID);
+    }
+    return 0;
+}
+
+/*! \fn     comms_hid_msgs_debug_open_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Start sending pixels to the display
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_open_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    /* Set pixel write window */
+    sh1122_set_row_address(&plat_oled_descriptor, 0);
+    sh1122_set_column_address(&plat_oled_descriptor, 0);
     
-    /* If do_not_deal_with is set, send please retry...  */
-    if (should_ignore_message != FALSE)
+    /* Start filling the SSD1322 RAM */
+    sh1122_start_data_sending(&plat_oled_descriptor);
+    
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_send_to_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Send pixels to the display
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_send_to_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    /* Send all pixels */
+    for (uint16_t i = 0; i < rcv_msg->payload_length; i++)
     {
-        /* Send please retry */
-        send_msg->message_type = HID_CMD_ID_RETRY;
-        send_msg->payload_length = 0;
-        return 0;
+        sercom_spi_send_single_byte_without_receive_wait(plat_oled_descriptor.sercom_pt, rcv_msg->payload[i]);
     }
     
-    /* By default: copy the same CMD identifier for TX message */
-    send_msg->message_type = rcv_msg->message_type;
-    uint16_t rcv_message_type = rcv_msg->message_type;
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_close_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Stop sending pixels to the display
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_close_disp_buffer(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    /* Wait for spi buffer to be sent */
+    sercom_spi_wait_for_transmit_complete(plat_oled_descriptor.sercom_pt);
+    
+    /* Stop sending data */
+    sh1122_stop_data_sending(&plat_oled_descriptor);
     
-    /* Switch on command id */
-    switch (rcv_msg->message_type)
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_erase_dataflash(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Start erasing the data flash
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_erase_dataflash(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    /* Erase data flash */
+    dataflash_bulk_erase_without_wait(&dataflash_descriptor);
+    
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_is_dataflash_ready(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Check if the data flash is done erasing
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_is_dataflash_ready(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    /* Set ack or nack, leave same command id */
+    if (dataflash_is_busy(&dataflash_descriptor) != FALSE)
     {
-        case HID_CMD_ID_OPEN_DISP_BUFFER:
-        {
-            /* Set pixel write window */
-            sh1122_set_row_address(&plat_oled_descriptor, 0);
-            sh1122_set_column_address(&plat_oled_descriptor, 0);
-            
-            /* Start filling the SSD1322 RAM */
-            sh1122_start_data_sending(&plat_oled_descriptor);
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
-        }    
-        case HID_CMD_ID_SEND_TO_DISP_BUFFER:
-        {            
-            /* Send all pixels */
-            for (uint16_t i = 0; i < supposed_payload_length; i++)
-            {
-                sercom_spi_send_single_byte_without_receive_wait(plat_oled_descriptor.sercom_pt, rcv_msg->payload[i]);
-            }
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
-        }  
-        case HID_CMD_ID_CLOSE_DISP_BUFFER:
-        {            
-            /* Wait for spi buffer to be sent */
-            sercom_spi_wait_for_transmit_complete(plat_oled_descriptor.sercom_pt);
-            
-            /* Stop sending data */
-            sh1122_stop_data_sending(&plat_oled_descriptor);            
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
-        }          
-        case HID_CMD_ID_ERASE_DATA_FLASH:
-        {
-            /* Erase data flash */
-            dataflash_bulk_erase_without_wait(&dataflash_descriptor);
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;            
-        }
-        case HID_CMD_ID_IS_DATA_FLASH_READY:
-        {
-            if (dataflash_is_busy(&dataflash_descriptor) != FALSE)
-            {
-                /* Set nack, leave same command id */
-                send_msg->payload[0] = HID_1BYTE_NACK;
-                send_msg->payload_length = 1;
-                return 1;                
-            }
-            else
-            {
-                /* Set ack, leave same command id */
-                send_msg->payload[0] = HID_1BYTE_ACK;
-                send_msg->payload_length = 1;
-                return 1;                
-            }
-        }
-        case HID_CMD_ID_DATAFLASH_WRITE_256B:
-        {
-            /* First 4 bytes is the write address, remaining 256 bytes is the payload */
-            uint32_t* write_address = (uint32_t*)&rcv_msg->payload_as_uint32[0];
-            dataflash_write_array_to_memory(&dataflash_descriptor, *write_address, &rcv_msg->payload[4], 256);
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
-        }
-        case HID_CMD_ID_REINDEX_BUNDLE:
-        {
-            /* Refresh file system and font */
-            custom_fs_init();
-            sh1122_refresh_used_font(&plat_oled_descriptor, DEFAULT_FONT_ID);
-            
-            /* Set ack, leave same command id */
-            send_msg->payload[0] = HID_1BYTE_ACK;
-            send_msg->payload_length = 1;
-            return 1;
-        }
-        case HID_CMD_ID_START_BOOTLOADER:
-        {
-            custom_fs_settings_set_fw_upgrade_flag();
-            cpu_irq_disable();
-            NVIC_SystemReset();
-            while(1);            
-        }
-        case HID_CMD_ID_GET_ACC_32_SAMPLES:
-        {
-            while (lis2hh12_check_data_received_flag_and_arm_other_transfer(&acc_descriptor) == FALSE);
-            memcpy((void*)send_msg->payload, (void*)acc_descriptor.fifo_read.acc_data_array, sizeof(acc_descriptor.fifo_read.acc_data_array));            
-            send_msg->payload_length = sizeof(acc_descriptor.fifo_read.acc_data_array);
-            return sizeof(acc_descriptor.fifo_read.acc_data_array);
-        }
-        case HID_CMD_ID_FLASH_AUX_MCU:
-        {            
-            /* Wait for current packet reception and arm reception */
-            dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag();
-            comms_aux_arm_rx_and_set_no_comms();            
-            logic_aux_mcu_flash_firmware_update();            
-            return -1;
-        }
-        case HID_CMD_ID_GET_DBG_PLAT_INFO:
+        send_msg->payload[0] = HID_1BYTE_NACK;
+    }
+    else
+    {
+        send_msg->payload[0] = HID_1BYTE_ACK;
+    }
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_dataflash_write_256b(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Write 256 bytes to the data flash
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_dataflash_write_256b(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    /* First 4 bytes is the write address, remaining 256 bytes is the payload */
+    uint32_t* write_address = (uint32_t*)&rcv_msg->payload_as_uint32[0];
+    dataflash_write_array_to_memory(&dataflash_descriptor, *write_address, &rcv_msg->payload[4], 256);
+    
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+/*! \fn     comms_hid_msgs_debug_reindex_bundle(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Refresh file system and font after a bundle upload
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_reindex_bundle(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    custom_fs_init();
+    sh1122_refresh_used_font(&plat_oled_descriptor, DEFAULT_FONT_ID);
+    
+    /* Set ack, leave same command id */
+    send_msg->payload[0] = HID_1BYTE_ACK;
+    send_msg->payload_length = 1;
+    return 1;
+}
+
+#ifdef DEBUG_RENDER_STATS_ENABLED
+/*! \fn     comms_hid_msgs_debug_get_render_stats(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Copy per screen render stats, then reset them
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_get_render_stats(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    memcpy((void*)send_msg->payload, (void*)gui_dispatcher_get_render_stats(), GUI_NB_SCREENS*sizeof(gui_render_stats_t));
+    gui_dispatcher_reset_render_stats();
+    send_msg->payload_length = GUI_NB_SCREENS*sizeof(gui_render_stats_t);
+    return GUI_NB_SCREENS*sizeof(gui_render_stats_t);
+}
+#endif
+
+#ifdef DEBUG_HID_CMD_STATS_ENABLED
+/*! \fn     comms_hid_msgs_debug_get_cmd_stats(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Copy per command statistics of the commands called since last request, then reset them
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_get_cmd_stats(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    hid_cmd_stats_t* stats_pt = (hid_cmd_stats_t*)send_msg->payload;
+    uint16_t max_nb_stats = sizeof(send_msg->payload)/sizeof(hid_cmd_stats_t);
+    uint16_t nb_stats = comms_hid_msgs_copy_cmd_stats(stats_pt, max_nb_stats);
+    
+    /* Append debug commands statistics */
+    for (uint16_t i = 0; (i < sizeof(comms_hid_msgs_debug_cmd_stats)/sizeof(comms_hid_msgs_debug_cmd_stats[0])) && (nb_stats < max_nb_stats); i++)
+    {
+        if (comms_hid_msgs_debug_cmd_stats[i].nb_calls != 0)
         {
-            aux_mcu_message_t* temp_rx_message;
-            aux_mcu_message_t* temp_tx_message_pt;
-            
-            /* Generate our packet */
-            comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
-            
-            /* Wait for current packet reception and arm reception */
-            dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag();
-            comms_aux_arm_rx_and_set_no_comms();
-            
-            /* Send message */
-            comms_aux_mcu_send_message(TRUE);
-            
-            /* Wait for message from aux MCU */
-            while(comms_aux_mcu_active_wait(&temp_rx_message, TRUE, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
-                
-            /* Copy message contents into send packet */
-            memcpy((void*)send_msg->detailed_platform_info.aux_mcu_infos, (void*)&temp_rx_message->aux_details_message, sizeof(temp_rx_message->aux_details_message));
-            send_msg->detailed_platform_info.main_mcu_fw_major = FW_MAJOR;
-            send_msg->detailed_platform_info.main_mcu_fw_minor = FW_MINOR;
-            send_msg->payload_length = sizeof(send_msg->detailed_platform_info);
-            send_msg->message_type = rcv_message_type;
-            return sizeof(send_msg->detailed_platform_info);
+            memcpy((void*)&stats_pt[nb_stats++], (void*)&comms_hid_msgs_debug_cmd_stats[i], sizeof(hid_cmd_stats_t));
         }
-        default: break;
     }
+    memset((void*)comms_hid_msgs_debug_cmd_stats, 0, sizeof(comms_hid_msgs_debug_cmd_stats));
     
+    send_msg->payload_length = nb_stats*sizeof(hid_cmd_stats_t);
+    return send_msg->payload_length;
+}
+#endif
+
+/*! \fn     comms_hid_msgs_debug_start_bootloader(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Check the bundle signature, set the firmware upgrade flag and reboot
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Doesn't return, or NACK reply payload length when the bundle signature isn't valid
+*/
+static int16_t comms_hid_msgs_debug_start_bootloader(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    /* The bootloader only checks the bundle crc32. Reading the bundle takes a while: release the message first */
+    comms_aux_mcu_wait_for_message_received();
+    comms_aux_arm_rx_and_clear_no_comms();
+    if (custom_fs_check_external_bundle_signature() != RETURN_OK)
+    {
+        send_msg->payload[0] = HID_1BYTE_NACK;
+        send_msg->payload_length = 1;
+        return 1;
+    }
+    
+    custom_fs_settings_set_fw_upgrade_flag();
+    cpu_irq_disable();
+    NVIC_SystemReset();
+    while(1);
+    return -1;
+}
+
+/*! \fn     comms_hid_msgs_debug_get_acc_32_samples(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Wait for and send 32 accelerometer samples
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_get_acc_32_samples(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    
+    while (lis2hh12_check_data_received_flag_and_arm_other_transfer(&acc_descriptor) == FALSE);
+    memcpy((void*)send_msg->payload, (void*)acc_descriptor.fifo_read.acc_data_array, sizeof(acc_descriptor.fifo_read.acc_data_array));
+    send_msg->payload_length = sizeof(acc_descriptor.fifo_read.acc_data_array);
+    return sizeof(acc_descriptor.fifo_read.acc_data_array);
+}
+
+/*! \fn     comms_hid_msgs_debug_flash_aux_mcu(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Flash the aux MCU with the firmware stored in the bundle
+*   \param  rcv_msg     Unused
+*   \param  send_msg    Unused
+*   \return -1, no reply
+*/
+static int16_t comms_hid_msgs_debug_flash_aux_mcu(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    (void)rcv_msg;
+    (void)send_msg;
+    
+    /* Wait for current packet reception and arm reception */
+    comms_aux_mcu_wait_for_message_received();
+    comms_aux_arm_rx_and_set_no_comms();
+    logic_aux_mcu_flash_firmware_update();
     return -1;
 }
+
+/*! \fn     comms_hid_msgs_debug_get_dbg_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Get detailed platform info, waiting for the aux MCU reply
+*   \param  rcv_msg     Received message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+static int16_t comms_hid_msgs_debug_get_dbg_plat_info(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    aux_mcu_message_t* temp_rx_message;
+    aux_mcu_message_t* temp_tx_message_pt;
+    uint16_t rcv_message_type = rcv_msg->message_type;
+    
+    /* Generate our packet */
+    comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
+    
+    /* Wait for current packet reception and arm reception */
+    comms_aux_mcu_wait_for_message_received();
+    comms_aux_arm_rx_and_set_no_comms();
+    
+    /* Send message */
+    comms_aux_mcu_send_message(TRUE);
+    
+    /* Wait for message from aux MCU */
+    while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
+        
+    /* Copy message contents into send packet */
+    memcpy((void*)send_msg->detailed_platform_info.aux_mcu_infos, (void*)&temp_rx_message->aux_details_message, sizeof(temp_rx_message->aux_details_message));
+    
+    /* Release aux MCU reply */
+    comms_aux_arm_rx_and_clear_no_comms();
+    send_msg->detailed_platform_info.main_mcu_fw_major = FW_MAJOR;
+    send_msg->detailed_platform_info.main_mcu_fw_minor = FW_MINOR;
+    send_msg->payload_length = sizeof(send_msg->detailed_platform_info);
+    send_msg->message_type = rcv_message_type;
+    return sizeof(send_msg->detailed_platform_info);
+}
+
+/*! \fn     comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+*   \brief  Parse an incoming message from USB or BLE
+*   \param  rcv_msg                 Received message
+*   \param  supposed_payload_length Supposed payload length
+*   \param  send_msg                Where to write a possible reply
+*   \param  answer_restrict_type    Enum restricting which messages we can answer
+*   \return something >= 0 if an answer needs to be sent, otherwise -1
+*/
+int16_t comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type)
+{
+    #ifdef DEBUG_HID_CMD_STATS_ENABLED
+    return comms_hid_msgs_dispatch(comms_hid_msgs_debug_cmd_table, comms_hid_msgs_debug_cmd_stats, rcv_msg, supposed_payload_length, send_msg, answer_restrict_type);
+    #else
+    return comms_hid_msgs_dispatch(comms_hid_msgs_debug_cmd_table, 0, rcv_msg, supposed_payload_length, send_msg, answer_restrict_type);
+    #endif
+}
@@ -26,8 +26,19 @@
 #define HID_CMD_ID_FLASH_AUX_MCU            0x8009
 #define HID_CMD_ID_GET_DBG_PLAT_INFO        0x800A
 #define HID_CMD_ID_REINDEX_BUNDLE           0x800B
+#define HID_CMD_ID_GET_RENDER_STATS         0x800C
+#define HID_CMD_ID_GET_CMD_STATS            0x800D
+#define HID_CMD_ID_DBG_TRACE                0x800E
+// Debug commands are answered unless all messages are restricted
+#define HID_CMD_ALLOW_DEBUG                 (HID_CMD_ALLOW_ALWAYS & ~HID_CMD_ALLOW(MSG_RESTRICT_ALL))
 
 /* Prototypes */
+RET_TYPE comms_hid_msgs_debug_dataflash_stream_data(uint8_t* data, uint16_t length, uint32_t offset);
+RET_TYPE comms_hid_msgs_debug_display_stream_data(uint8_t* data, uint16_t length, uint32_t offset);
+RET_TYPE comms_hid_msgs_debug_dataflash_stream_start(uint32_t total_length);
+RET_TYPE comms_hid_msgs_debug_display_stream_start(uint32_t total_length);
+uint16_t comms_hid_msgs_debug_dataflash_stream_end(BOOL stream_complete);
+uint16_t comms_hid_msgs_debug_display_stream_end(BOOL stream_complete);
 int16_t comms_hid_msgs_parse_debug(hid_message_t* rcv_msg, uint16_t supposed_payload_length, hid_message_t* send_msg, msg_restrict_type_te answer_restrict_type);
 #ifdef DEBUG_USB_PRINTF_ENABLED
     void comms_hid_msgs_debug_printf(const char *fmt, ...);
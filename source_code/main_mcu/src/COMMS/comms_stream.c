@@ -0,0 +1,179 @@
+/*!  \file     comms_stream.c
+*    \brief    Chunked streams from the host, with windowed acknowledgements
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include <asf.h>
+#include "comms_hid_msgs_debug.h"
+#include "platform_defines.h"
+#include "comms_hid_msgs.h"
+#include "comms_stream.h"
+#include "comms_trace.h"
+#include "logic_user.h"
+#include "defines.h"
+/* Stream consumers, terminated by a COMMS_STREAM_TYPE_NONE entry */
+const comms_stream_consumer_t comms_stream_consumers[] = 
+{
+    #ifdef DEBUG_USB_COMMANDS_ENABLED
+    {COMMS_STREAM_TYPE_DISPLAY, comms_hid_msgs_debug_display_stream_start, comms_hid_msgs_debug_display_stream_data, comms_hid_msgs_debug_display_stream_end},
+    {COMMS_STREAM_TYPE_DATAFLASH, comms_hid_msgs_debug_dataflash_stream_start, comms_hid_msgs_debug_dataflash_stream_data, comms_hid_msgs_debug_dataflash_stream_end},
+    #endif
+    {COMMS_STREAM_TYPE_CRED_BATCH, logic_user_cred_batch_stream_start, logic_user_cred_batch_stream_data, logic_user_cred_batch_stream_end},
+    {COMMS_STREAM_TYPE_NONE, 0, 0, 0}
+};
+/* Ongoing stream, consumer_pt set to 0 if none */
+comms_stream_t comms_stream_current;
+
+
+/*! \fn     comms_stream_end(BOOL stream_complete)
+*   \brief  End the ongoing stream
+*   \param  stream_complete FALSE if the stream is aborted
+*   \return Consumer result, for the last acknowledgement
+*/
+static uint16_t comms_stream_end(BOOL stream_complete)
+{
+    uint16_t result = comms_stream_current.consumer_pt->end_callback(stream_complete);
+    comms_stream_current.consumer_pt = 0;
+    return result;
+}
+
+/*! \fn     comms_stream_abort(void)
+*   \brief  Abort the ongoing stream, if any
+*/
+void comms_stream_abort(void)
+{
+    if (comms_stream_current.consumer_pt != 0)
+    {
+        COMMS_TRACE_1(TRACE_ID_STREAM_ABORTED, comms_stream_current.next_chunk_id);
+        comms_stream_end(FALSE);
+    }
+}
+
+/*! \fn     comms_stream_fill_ack(hid_message_t* send_msg, uint16_t status, uint16_t result)
+*   \brief  Fill a stream data acknowledgement
+*   \param  send_msg    Where to write the acknowledgement
+*   \param  status      COMMS_STREAM_STATUS_xxx
+*   \param  result      Consumer result once the stream ended, 0 otherwise
+*   \return Acknowledgement payload length
+*   \note   Message type is set again, as a consumer that blocks lets other messages be answered in the mean time
+*/
+static int16_t comms_stream_fill_ack(hid_message_t* send_msg, uint16_t status, uint16_t result)
+{
+    comms_stream_current.nb_chunks_since_ack = 0;
+    send_msg->message_type = HID_CMD_ID_STREAM_DATA;
+    send_msg->stream_ack.status = status;
+    send_msg->stream_ack.next_chunk_id = comms_stream_current.next_chunk_id;
+    send_msg->stream_ack.result = result;
+    send_msg->payload_length = sizeof(send_msg->stream_ack);
+    return sizeof(send_msg->stream_ack);
+}
+
+/*! \fn     comms_stream_start(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Start a new stream, aborting the ongoing one
+*   \param  rcv_msg     Received stream start message
+*   \param  send_msg    Where to write the reply
+*   \return Reply payload length
+*/
+int16_t comms_stream_start(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    const comms_stream_consumer_t* consumer_pt = 0;
+    
+    /* Default answer: nack */
+    send_msg->stream_start_reply.status = HID_1BYTE_NACK;
+    send_msg->stream_start_reply.window = COMMS_STREAM_WINDOW;
+    send_msg->stream_start_reply.max_chunk_length = COMMS_STREAM_MAX_CHUNK_LENGTH;
+    send_msg->payload_length = sizeof(send_msg->stream_start_reply);
+    
+    /* Only one stream at a time */
+    comms_stream_abort();
+    
+    /* Check payload length */
+    if (rcv_msg->payload_length != sizeof(rcv_msg->stream_start))
+    {
+        return sizeof(send_msg->stream_start_reply);
+    }
+    
+    /* Look for the consumer */
+    for (uint16_t i = 0; comms_stream_consumers[i].stream_type != COMMS_STREAM_TYPE_NONE; i++)
+    {
+        if (comms_stream_consumers[i].stream_type == rcv_msg->stream_start.stream_type)
+        {
+            consumer_pt = &comms_stream_consumers[i];
+        }
+    }
+    
+    /* Let it accept the stream */
+    if ((consumer_pt != 0) && (consumer_pt->start_callback(rcv_msg->stream_start.total_length) == RETURN_OK))
+    {
+        memset((void*)&comms_stream_current, 0, sizeof(comms_stream_current));
+        comms_stream_current.consumer_pt = consumer_pt;
+        comms_stream_current.total_length = rcv_msg->stream_start.total_length;
+        send_msg->stream_start_reply.status = HID_1BYTE_ACK;
+        COMMS_TRACE_2(TRACE_ID_STREAM_STARTED, consumer_pt->stream_type, comms_stream_current.total_length);
+    }
+    
+    return sizeof(send_msg->stream_start_reply);
+}
+
+/*! \fn     comms_stream_data(hid_message_t* rcv_msg, hid_message_t* send_msg)
+*   \brief  Hand a stream chunk over to the consumer
+*   \param  rcv_msg     Received stream data message
+*   \param  send_msg    Where to write a possible acknowledgement
+*   \return Acknowledgement payload length, -1 if the chunk is not acknowledged yet
+*   \note   Acknowledgements are sent every COMMS_STREAM_ACK_INTERVAL chunks and on the last chunk. An unexpected chunk
+*           triggers a single go back with the chunk we expect, following chunks are dropped until the host sends it again
+*/
+int16_t comms_stream_data(hid_message_t* rcv_msg, hid_message_t* send_msg)
+{
+    /* No ongoing stream */
+    if ((comms_stream_current.consumer_pt == 0) || (rcv_msg->payload_length < sizeof(rcv_msg->stream_data.chunk_id)))
+    {
+        comms_stream_current.next_chunk_id = 0;
+        return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_ABORTED, 0);
+    }
+    
+    /* Unexpected chunk: go back to the one we expect */
+    if (rcv_msg->stream_data.chunk_id != comms_stream_current.next_chunk_id)
+    {
+        if (comms_stream_current.nack_sent == FALSE)
+        {
+            comms_stream_current.nack_sent = TRUE;
+            return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_GO_BACK, 0);
+        }
+        return -1;
+    }
+    
+    /* Check for overflow */
+    uint16_t chunk_length = rcv_msg->payload_length - sizeof(rcv_msg->stream_data.chunk_id);
+    if (comms_stream_current.received_length + chunk_length > comms_stream_current.total_length)
+    {
+        comms_stream_abort();
+        return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_ABORTED, 0);
+    }
+    
+    /* Hand it over to the consumer */
+    if (comms_stream_current.consumer_pt->data_callback(rcv_msg->stream_data.data, chunk_length, comms_stream_current.received_length) != RETURN_OK)
+    {
+        COMMS_TRACE_1(TRACE_ID_STREAM_ABORTED, comms_stream_current.next_chunk_id);
+        return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_ABORTED, comms_stream_end(FALSE));
+    }
+    comms_stream_current.received_length += chunk_length;
+    comms_stream_current.next_chunk_id++;
+    comms_stream_current.nb_chunks_since_ack++;
+    comms_stream_current.nack_sent = FALSE;
+    
+    /* Last chunk */
+    if (comms_stream_current.received_length == comms_stream_current.total_length)
+    {
+        return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_ACK, comms_stream_end(TRUE));
+    }
+    
+    /* Acknowledge every few chunks */
+    if (comms_stream_current.nb_chunks_since_ack >= COMMS_STREAM_ACK_INTERVAL)
+    {
+        return comms_stream_fill_ack(send_msg, COMMS_STREAM_STATUS_ACK, 0);
+    }
+    
+    return -1;
+}
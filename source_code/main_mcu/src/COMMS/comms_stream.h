@@ -0,0 +1,63 @@
+/*!  \file     comms_stream.h
+*    \brief    Chunked streams from the host, with windowed acknowledgements
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef COMMS_STREAM_H_
+#define COMMS_STREAM_H_
+
+#include "comms_hid_msgs.h"
+#include "defines.h"
+
+/* Defines */
+// Stream types
+#define COMMS_STREAM_TYPE_NONE          0x0000
+#define COMMS_STREAM_TYPE_DISPLAY       0x0001
+#define COMMS_STREAM_TYPE_DATAFLASH     0x0002
+#define COMMS_STREAM_TYPE_CRED_BATCH    0x0003
+
+// Stream data acknowledgement status
+#define COMMS_STREAM_STATUS_ABORTED     0x0000
+#define COMMS_STREAM_STATUS_ACK         0x0001
+#define COMMS_STREAM_STATUS_GO_BACK     0x0002
+
+// Number of chunks the host can send ahead of our acknowledgements
+#define COMMS_STREAM_WINDOW             4
+// Number of consumed chunks between two acknowledgements
+#define COMMS_STREAM_ACK_INTERVAL       2
+// Maximum data length in a chunk: HID message payload minus chunk ID
+#define COMMS_STREAM_MAX_CHUNK_LENGTH   (AUX_MCU_MSG_PAYLOAD_LENGTH-sizeof(uint16_t)-sizeof(uint16_t)-sizeof(uint16_t))
+
+/* Typedefs */
+// Consumer callbacks: start & data callbacks return RETURN_NOK to abort the stream, end callback is called once per started stream and returns the result sent in the last acknowledgement
+typedef RET_TYPE (*comms_stream_start_callback_t)(uint32_t total_length);
+typedef RET_TYPE (*comms_stream_data_callback_t)(uint8_t* data, uint16_t length, uint32_t offset);
+typedef uint16_t (*comms_stream_end_callback_t)(BOOL stream_complete);
+
+typedef struct
+{
+    uint16_t stream_type;
+    comms_stream_start_callback_t start_callback;
+    comms_stream_data_callback_t data_callback;
+    comms_stream_end_callback_t end_callback;
+} comms_stream_consumer_t;
+
+typedef struct
+{
+    const comms_stream_consumer_t* consumer_pt;
+    uint32_t total_length;
+    uint32_t received_length;
+    uint16_t next_chunk_id;
+    uint16_t nb_chunks_since_ack;
+    BOOL nack_sent;
+} comms_stream_t;
+
+/* Prototypes */
+int16_t comms_stream_start(hid_message_t* rcv_msg, hid_message_t* send_msg);
+int16_t comms_stream_data(hid_message_t* rcv_msg, hid_message_t* send_msg);
+void comms_stream_abort(void);
+
+
+#endif /* COMMS_STREAM_H_ */
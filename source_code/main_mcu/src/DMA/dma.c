@@ -6,7 +6,6 @@
 #include <asf.h>
 #include "platform_defines.h"
 #include "comms_aux_mcu.h"
-#include "platform_io.h"
 #include "defines.h"
 #include "dma.h"
 /* DMA Descriptors for our transfers and their DMA priority levels (highest number is higher priority, contrary to what is written in some datasheets) */
@@ -18,16 +17,23 @@
 // SPI RX routine for transfer from accelerometer: level 2
 // SPI TX routine for transfer to accelerometer: level 2
 // SPI TX routine for transfer to a display: level 1
-DmacDescriptor dma_writeback_descriptors[7] __attribute__ ((aligned (16)));
-DmacDescriptor dma_descriptors[7] __attribute__ ((aligned (16)));
+// Software triggered memset: level 0
+// SPI RX routine for DB flash reads: level 0
+// SPI TX routine for DB flash reads: level 0
+DmacDescriptor dma_writeback_descriptors[DMA_NB_DESCIDS] __attribute__ ((aligned (16)));
+DmacDescriptor dma_descriptors[DMA_NB_DESCIDS] __attribute__ ((aligned (16)));
 /* Boolean to specify if the last DMA transfer for the custom_fs is done */
 volatile BOOL dma_custom_fs_transfer_done = FALSE;
+/* Boolean to specify if the last DMA transfer for the DB flash is done */
+volatile BOOL dma_dbflash_transfer_done = FALSE;
 /* Boolean to specify if the last DMA transfer for the oled display is done */
 volatile BOOL dma_oled_transfer_done = FALSE;
+/* Boolean to specify if the last DMA memset is done */
+volatile BOOL dma_memset_transfer_done = FALSE;
+/* Value used as fixed source for DMA memsets */
+volatile uint32_t dma_memset_value = 0;
 /* Boolean to specify if the last DMA transfer for the accelerometer is done */
 volatile BOOL dma_acc_transfer_done = FALSE;
-/* Boolean to specify if we received a packet from aux MCU */
-volatile BOOL dma_aux_mcu_packet_received = FALSE;
 /* Boolean to specify if we sent a packet to aux MCU */
 volatile BOOL dma_aux_mcu_packet_sent = TRUE;
 /* Boolean to specify if DMA needs to be rearmed to receive an aux MCU packet (use with caution) */
@@ -43,11 +49,10 @@ void DMAC_Handler(void)
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_COMMS);
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
     {
-        /* Set transfer done boolean, clear interrupt */
-        platform_io_set_no_comms();
-        dma_aux_mcu_packet_received = TRUE;
+        /* Clear interrupt, hand the message over and arm next transfer if a slot is available */
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
         dma_aux_mcu_rx_transfer_to_be_rearmed = TRUE;
+        comms_aux_mcu_rx_transfer_done_irq_handler();
     }
     
     /* AUX MCU RX routine */
@@ -68,6 +73,15 @@ void DMAC_Handler(void)
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
     }
     
+    /* RX routine for DB flash */
+    DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_DBFLASH);
+    if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
+    {
+        /* Set transfer done boolean, clear interrupt */
+        dma_dbflash_transfer_done = TRUE;
+        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    }
+    
     /* OLED TX routine */
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_TX_OLED);
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
@@ -77,6 +91,15 @@ void DMAC_Handler(void)
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
     }
     
+    /* Memset routine */
+    DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_MEMSET);
+    if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
+    {
+        /* Set transfer done boolean, clear interrupt */
+        dma_memset_transfer_done = TRUE;
+        DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    }
+    
     /* Accelerometer RX routine */
     DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_ACC);
     if ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) != 0)
@@ -109,6 +132,15 @@ void dma_wait_for_aux_mcu_packet_sent(void)
     while (dma_aux_mcu_packet_sent == FALSE);
 }
 
+/*! \fn     dma_aux_mcu_is_tx_transfer_done(void)
+*   \brief  Check if the last packet to aux mcu was sent
+*   \return TRUE if it was, FALSE if it is still being sent
+*/
+BOOL dma_aux_mcu_is_tx_transfer_done(void)
+{
+    return dma_aux_mcu_packet_sent;
+}
+
 /*! \fn     dma_reset(void)
 *   \brief  Reset DMA controller
 */
@@ -190,6 +222,41 @@ void dma_init(void)
     dma_chctrlb_reg.bit.TRIGSRC = DATAFLASH_DMA_SERCOM_TXTRIG;                              // Select RX trigger
     DMAC->CHCTRLB = dma_chctrlb_reg;                                                        // Write register
 
+    /* Setup transfer descriptor for DB flash RX */
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.reg = DMAC_BTCTRL_VALID;                       // Valid descriptor
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.bit.STEPSIZE = DMAC_BTCTRL_STEPSIZE_X1_Val;    // 1 byte address increment
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_DST_Val;     // Step selection for destination
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.bit.DSTINC = 1;                                // Destination Address Increment is enabled.
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.bit.BEATSIZE = DMAC_BTCTRL_BEATSIZE_BYTE_Val;  // Byte data transfer
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;   // Once data block is transferred, generate interrupt
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].DESCADDR.reg = 0;                                     // No next descriptor address
+    
+    /* Setup DMA channel */
+    DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_RX_DBFLASH);                                        // Select channel
+    dma_chctrlb_reg.reg = 0;                                                                     // Clear it
+    dma_chctrlb_reg.bit.LVL = 0;                                                                 // Priority level
+    dma_chctrlb_reg.bit.TRIGACT = DMAC_CHCTRLB_TRIGACT_BEAT_Val;                                 // One trigger required for each beat transfer
+    dma_chctrlb_reg.bit.TRIGSRC = DBFLASH_DMA_SERCOM_RXTRIG;                                     // Select RX trigger
+    DMAC->CHCTRLB = dma_chctrlb_reg;                                                             // Write register
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;                                                // Enable channel transfer complete interrupt
+
+    /* Setup transfer descriptor for DB flash TX */
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.reg = DMAC_BTCTRL_VALID;                       // Valid descriptor
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.bit.STEPSIZE = DMAC_BTCTRL_STEPSIZE_X1_Val;    // 1 byte address increment
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_SRC_Val;     // Step selection for source
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.bit.SRCINC = 1;                                // Source Address Increment is enabled.
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.bit.BEATSIZE = DMAC_BTCTRL_BEATSIZE_BYTE_Val;  // Byte data transfer
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_NOACT_Val; // Once data block is transferred, do nothing
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].DESCADDR.reg = 0;                                     // No next descriptor address
+    
+    /* Setup DMA channel */
+    DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_TX_DBFLASH);                                        // Select channel
+    dma_chctrlb_reg.reg = 0;                                                                     // Clear it
+    dma_chctrlb_reg.bit.LVL = 0;                                                                 // Priority level
+    dma_chctrlb_reg.bit.TRIGACT = DMAC_CHCTRLB_TRIGACT_BEAT_Val;                                 // One trigger required for each beat transfer
+    dma_chctrlb_reg.bit.TRIGSRC = DBFLASH_DMA_SERCOM_TXTRIG;                                     // Select TX trigger
+    DMAC->CHCTRLB = dma_chctrlb_reg;                                                             // Write register
+
     /* Setup transfer descriptor for oled TX */
     dma_descriptors[DMA_DESCID_TX_OLED].BTCTRL.reg = DMAC_BTCTRL_VALID;                     // Valid descriptor
     dma_descriptors[DMA_DESCID_TX_OLED].BTCTRL.bit.STEPSIZE = DMAC_BTCTRL_STEPSIZE_X1_Val;  // 1 byte address increment
@@ -273,6 +340,26 @@ void dma_init(void)
     DMAC->CHCTRLB = dma_chctrlb_reg;                                                        // Write register
     DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;                                           // Enable channel transfer complete interrupt
 
+    /* Setup transfer descriptor for memset */
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.reg = DMAC_BTCTRL_VALID;                       // Valid descriptor
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.STEPSIZE = DMAC_BTCTRL_STEPSIZE_X1_Val;    // 1 beat address increment
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.STEPSEL = DMAC_BTCTRL_STEPSEL_DST_Val;     // Step selection for destination
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.SRCINC = 0;                                // Source Address Increment is disabled.
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.DSTINC = 1;                                // Destination Address Increment is enabled.
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.BEATSIZE = DMAC_BTCTRL_BEATSIZE_WORD_Val;  // Word data transfer
+    dma_descriptors[DMA_DESCID_MEMSET].BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_INT_Val;   // Once data block is transferred, generate interrupt
+    dma_descriptors[DMA_DESCID_MEMSET].SRCADDR.reg = (uint32_t)&dma_memset_value;            // Fixed source
+    dma_descriptors[DMA_DESCID_MEMSET].DESCADDR.reg = 0;                                     // No next descriptor address
+    
+    /* Setup DMA channel */
+    DMAC->CHID.reg = DMAC_CHID_ID(DMA_DESCID_MEMSET);                                       // Select channel
+    dma_chctrlb_reg.reg = 0;                                                                // Clear temp register
+    dma_chctrlb_reg.bit.LVL = 0;                                                            // Priority level
+    dma_chctrlb_reg.bit.TRIGACT = DMAC_CHCTRLB_TRIGACT_BLOCK_Val;                           // One software trigger for the whole block
+    dma_chctrlb_reg.bit.TRIGSRC = 0;                                                        // Software trigger only
+    DMAC->CHCTRLB = dma_chctrlb_reg;                                                        // Write register
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;                                           // Enable channel transfer complete interrupt
+
     /* Enable IRQ */
     NVIC_EnableIRQ(DMAC_IRQn);
 }
@@ -293,6 +380,38 @@ BOOL dma_custom_fs_check_and_clear_dma_transfer_flag(void)
     return FALSE;
 }
 
+/*! \fn     dma_dbflash_check_and_clear_dma_transfer_flag(void)
+*   \brief  Check if a DMA transfer that we requested for a DB flash read is done
+*   \note   If the flag is true, flag will be cleared to false
+*   \return TRUE or FALSE
+*/
+BOOL dma_dbflash_check_and_clear_dma_transfer_flag(void)
+{
+    /* flag can't be set twice, code is safe */
+    if (dma_dbflash_transfer_done != FALSE)
+    {
+        dma_dbflash_transfer_done = FALSE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/*! \fn     dma_memset_check_and_clear_dma_transfer_flag(void)
+*   \brief  Check if a DMA memset is done
+*   \note   If the flag is true, flag will be cleared to false
+*   \return TRUE or FALSE
+*/
+BOOL dma_memset_check_and_clear_dma_transfer_flag(void)
+{
+    /* flag can't be set twice, code is safe */
+    if (dma_memset_transfer_done != FALSE)
+    {
+        dma_memset_transfer_done = FALSE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /*! \fn     dma_oled_check_and_clear_dma_transfer_flag(void)
 *   \brief  Check if a DMA transfer that we requested for led transfer is done
 *   \note   If the flag is true, flag will be cleared to false
@@ -343,38 +462,13 @@ uint16_t dma_aux_mcu_get_remaining_bytes_for_rx_transfer(void)
     }
 }
 
-/*! \fn     dma_aux_mcu_check_and_clear_dma_transfer_flag(void)
-*   \brief  Check if a DMA transfer from aux MCU comms has been done
-*   \note   If the flag is true, flag will be cleared to false
-*   \return TRUE or FALSE
-*/
-BOOL dma_aux_mcu_check_and_clear_dma_transfer_flag(void)
-{
-    /* flag can't be set twice, code is safe */
-    if (dma_aux_mcu_packet_received != FALSE)
-    {
-        dma_aux_mcu_packet_received = FALSE;
-        return TRUE;
-    }
-    return FALSE;
-}
-
-/*! \fn     dma_aux_mcu_check_dma_transfer_flag(void)
-*   \brief  Check if a DMA transfer from aux MCU comms has been done
+/*! \fn     dma_aux_mcu_is_rx_transfer_to_be_rearmed(void)
+*   \brief  Check if the DMA transfer from aux MCU is stopped and needs to be rearmed
 *   \return TRUE or FALSE
 */
-BOOL dma_aux_mcu_check_dma_transfer_flag(void)
+BOOL dma_aux_mcu_is_rx_transfer_to_be_rearmed(void)
 {
-    return dma_aux_mcu_packet_received;
-}
-
-/*! \fn     dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag(void)
-*   \brief  Wait for the complete reception of current AUX MCU packet
-*/
-void dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag(void)
-{
-    while (dma_aux_mcu_rx_transfer_to_be_rearmed == FALSE);
-    dma_aux_mcu_packet_received = FALSE;
+    return dma_aux_mcu_rx_transfer_to_be_rearmed;
 }
 
 /*! \fn     dma_custom_fs_init_transfer(void* spi_data_p, void* datap, uint16_t size)
@@ -414,18 +508,109 @@ void dma_custom_fs_init_transfer(void* spi_data_p, void* datap, uint16_t size)
     cpu_irq_leave_critical();
 }
 
-/*! \fn     dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
-*   \brief  Use the DMA controller to compute a CRC32 from a spi transfer
+/*! \fn     dma_dbflash_init_transfer(void* spi_data_p, void* datap, uint16_t size)
+*   \brief  Initialize a DMA transfer from the DB flash bus to the array
 *   \param  spi_data_p  Pointer to the SPI data register
+*   \param  datap       Pointer to where to store the data
 *   \param  size        Number of bytes to transfer
+*   \note   The read must already be opened on the flash, the CPU is free until dma_dbflash_check_and_clear_dma_transfer_flag() returns TRUE
+*/
+void dma_dbflash_init_transfer(void* spi_data_p, void* datap, uint16_t size)
+{
+    cpu_irq_enter_critical();
+    
+    /* SPI RX DMA TRANSFER */
+    /* Setup transfer size */
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].BTCNT.bit.BTCNT = (uint16_t)size;
+    /* Source address: DATA register from SPI */
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].SRCADDR.reg = (uint32_t)spi_data_p;
+    /* Destination address: given value */
+    dma_descriptors[DMA_DESCID_RX_DBFLASH].DSTADDR.reg = (uint32_t)datap + size;
+    
+    /* Resume DMA channel operation */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_RX_DBFLASH);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+
+    /* SPI TX DMA TRANSFER */
+    /* Setup transfer size */
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].BTCNT.bit.BTCNT = (uint16_t)size;
+    /* Destination address: DATA register from SPI */
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].DSTADDR.reg = (uint32_t)spi_data_p;
+    /* Source address: given value, dummy bytes for the flash */
+    dma_descriptors[DMA_DESCID_TX_DBFLASH].SRCADDR.reg = (uint32_t)datap + size;
+    
+    /* Resume DMA channel operation */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_TX_DBFLASH);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    
+    cpu_irq_leave_critical();
+}
+
+/*! \fn     dma_memset_init_transfer(void* datap, uint32_t value, uint16_t nb_words)
+*   \brief  Fill a word aligned array with a given 32-bit value, using the DMA controller
+*   \param  datap       Pointer to the word aligned array
+*   \param  value       Value to fill the array with
+*   \param  nb_words    Number of 32-bit words to fill
+*   \note   Use dma_memset_check_and_clear_dma_transfer_flag() to know when the fill is done
+*/
+void dma_memset_init_transfer(void* datap, uint32_t value, uint16_t nb_words)
+{
+    cpu_irq_enter_critical();
+    
+    /* Fixed source value */
+    dma_memset_value = value;
+    /* Setup transfer size */
+    dma_descriptors[DMA_DESCID_MEMSET].BTCNT.bit.BTCNT = nb_words;
+    /* Destination address: end of the array */
+    dma_descriptors[DMA_DESCID_MEMSET].DSTADDR.reg = (uint32_t)datap + nb_words*sizeof(uint32_t);
+    
+    /* Enable DMA channel & trigger it */
+    DMAC->CHID.reg= DMAC_CHID_ID(DMA_DESCID_MEMSET);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    DMAC->SWTRIGCTRL.reg = (1 << DMA_DESCID_MEMSET);
+    
+    cpu_irq_leave_critical();
+}
+
+/*! \fn     dma_hash_received_chunk(sha256_context_t* sha256_context, uint8_t* chunk, uint32_t chunk_size, uint32_t* nb_bytes_not_hashed)
+*   \brief  Hash a chunk received by dma_compute_crc32_from_spi()
+*   \param  sha256_context      Hash context
+*   \param  chunk               The received bytes
+*   \param  chunk_size          Number of bytes
+*   \param  nb_bytes_not_hashed Remaining number of stream bytes to leave out of the hash, updated
+*/
+static inline void dma_hash_received_chunk(sha256_context_t* sha256_context, uint8_t* chunk, uint32_t chunk_size, uint32_t* nb_bytes_not_hashed)
+{
+    if (*nb_bytes_not_hashed >= chunk_size)
+    {
+        *nb_bytes_not_hashed -= chunk_size;
+        return;
+    }
+    sha256_update(sha256_context, &chunk[*nb_bytes_not_hashed], chunk_size - *nb_bytes_not_hashed);
+    *nb_bytes_not_hashed = 0;
+}
+
+/*! \fn     dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size, sha256_context_t* sha256_context, uint32_t nb_bytes_not_hashed)
+*   \brief  Use the DMA controller to compute a CRC32 from a spi transfer, optionally hashing the same stream
+*   \param  spi_data_p          Pointer to the SPI data register
+*   \param  size                Number of bytes to transfer
+*   \param  sha256_context      Initialized hash context to update with the received bytes, or 0 for a CRC32 only
+*   \param  nb_bytes_not_hashed Number of bytes at the start of the stream not to hash
 *   \return the crc32
 *   \note   DMA controller must be disabled and reset before calling this function!
+*   \note   When hashing, bytes are received in two alternating buffers: a chunk is hashed while the next one is transferred
 */
-uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
+uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size, sha256_context_t* sha256_context, uint32_t nb_bytes_not_hashed)
 {
     /* The byte that will be used to read/write spi data */
     volatile uint8_t temp_src_dst_reg = 0;
     
+    /* Received chunks when hashing */
+    uint8_t hash_buffers[2][DMA_CRC32_HASH_CHUNK_SIZE];
+    uint16_t hash_buffer_id = 0;
+    uint8_t* received_chunk = 0;
+    uint32_t received_chunk_size = 0;
+    
     /* Setup CRC32 */
     DMAC_CRCCTRL_Type crc_ctrl_reg;
     crc_ctrl_reg.reg = 0;
@@ -454,7 +639,7 @@ uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
     /* Setup transfer descriptor for custom fs RX */
     dma_descriptors[0].BTCTRL.reg = DMAC_BTCTRL_VALID;                                      // Valid descriptor
     dma_descriptors[0].BTCTRL.bit.STEPSIZE = DMAC_BTCTRL_STEPSIZE_X1_Val;                   // 1 byte address increment
-    dma_descriptors[0].BTCTRL.bit.DSTINC = 0;                                               // Destination Address Increment is not enabled.
+    dma_descriptors[0].BTCTRL.bit.DSTINC = (sha256_context != 0)? 1 : 0;                    // Destination Address Increment is only enabled when hashing.
     dma_descriptors[0].BTCTRL.bit.SRCINC = 0;                                               // Source Address Increment is not enabled.
     dma_descriptors[0].BTCTRL.bit.BEATSIZE = DMAC_BTCTRL_BEATSIZE_BYTE_Val;                 // Byte data transfer
     dma_descriptors[0].BTCTRL.bit.BLOCKACT = DMAC_BTCTRL_BLOCKACT_NOACT_Val;                // Once data block is transferred, do not generate interrupt
@@ -487,13 +672,14 @@ uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
     dma_chctrlb_reg.bit.TRIGSRC = DATAFLASH_DMA_SERCOM_TXTRIG;                              // Select RX trigger
     DMAC->CHCTRLB = dma_chctrlb_reg;                                                        // Write register
 
+    uint32_t max_nb_bytes_per_transfer = (sha256_context != 0)? DMA_CRC32_HASH_CHUNK_SIZE : UINT16_MAX;
     uint32_t nb_bytes_to_transfer = size;
     while (size > 0)
     {
         /* Compute nb bytes to transfer */
-        if (size > UINT16_MAX)
+        if (size > max_nb_bytes_per_transfer)
         {
-            nb_bytes_to_transfer = UINT16_MAX;
+            nb_bytes_to_transfer = max_nb_bytes_per_transfer;
         } 
         else
         {
@@ -506,8 +692,15 @@ uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
         dma_descriptors[0].BTCNT.bit.BTCNT = (uint16_t)nb_bytes_to_transfer;
         /* Source address: DATA register from SPI */
         dma_descriptors[0].SRCADDR.reg = (uint32_t)spi_data_p;
-        /* Destination address: given value */
-        dma_descriptors[0].DSTADDR.reg = (uint32_t)&temp_src_dst_reg;
+        /* Destination address: given value, or end of the free hash buffer */
+        if (sha256_context != 0)
+        {
+            dma_descriptors[0].DSTADDR.reg = (uint32_t)hash_buffers[hash_buffer_id] + nb_bytes_to_transfer;
+        }
+        else
+        {
+            dma_descriptors[0].DSTADDR.reg = (uint32_t)&temp_src_dst_reg;
+        }
         /* Resume DMA channel operation */
         DMAC->CHID.reg= DMAC_CHID_ID(0);
         DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
@@ -523,15 +716,35 @@ uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size)
         DMAC->CHID.reg= DMAC_CHID_ID(1);
         DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
         
+        /* Hash the previous chunk during the transfer */
+        if (received_chunk_size != 0)
+        {
+            dma_hash_received_chunk(sha256_context, received_chunk, received_chunk_size, &nb_bytes_not_hashed);
+        }
+        
         /* Wait for transfer to finish */
         DMAC->CHID.reg = DMAC_CHID_ID(0);
         while ((DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL) == 0);
         DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
         
+        /* Received chunk to hash, switch buffers */
+        if (sha256_context != 0)
+        {
+            received_chunk = hash_buffers[hash_buffer_id];
+            received_chunk_size = nb_bytes_to_transfer;
+            hash_buffer_id ^= 1;
+        }
+        
         /* Update size */
         size -= nb_bytes_to_transfer;
     }
     
+    /* Hash the last chunk */
+    if (received_chunk_size != 0)
+    {
+        dma_hash_received_chunk(sha256_context, received_chunk, received_chunk_size, &nb_bytes_not_hashed);
+    }
+    
     /* Get crc32 from dma */
     while ((DMAC->CRCSTATUS.reg & DMAC_CRCSTATUS_CRCBUSY) == DMAC_CRCSTATUS_CRCBUSY);    
     return DMAC->CRCCHKSUM.reg;
@@ -692,8 +905,8 @@ void dma_aux_mcu_disable_transfer(void)
     /* Wait for bit clear */
     while(DMAC->CHCTRLA.reg != 0);
     
-    /* Reset bool */
-    dma_aux_mcu_packet_received = FALSE;
+    /* Set bool */
+    dma_aux_mcu_rx_transfer_to_be_rearmed = TRUE;
     
     cpu_irq_leave_critical();    
 }
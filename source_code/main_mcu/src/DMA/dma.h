@@ -11,21 +11,29 @@
 
 #include "platform_defines.h"
 #include "defines.h"
+#include "sha256.h"
+
+/* Defines */
+// Chunk size of the double buffered SPI stream when hashing along the CRC32
+#define DMA_CRC32_HASH_CHUNK_SIZE   256
 
 /* Prototypes */
 void dma_oled_init_transfer(void* spi_data_p, void* datap, uint16_t size, uint16_t dma_trigger);
+void dma_memset_init_transfer(void* datap, uint32_t value, uint16_t nb_words);
 void dma_acc_init_transfer(void* spi_data_p, void* datap, uint16_t size, uint8_t* read_cmd);
-uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size);
+uint32_t dma_compute_crc32_from_spi(void* spi_data_p, uint32_t size, sha256_context_t* sha256_context, uint32_t nb_bytes_not_hashed);
 void dma_aux_mcu_init_tx_transfer(void* spi_data_p, void* datap, uint16_t size);
 void dma_aux_mcu_init_rx_transfer(void* spi_data_p, void* datap, uint16_t size);
 void dma_custom_fs_init_transfer(void* spi_data_p, void* datap, uint16_t size);
-void dma_aux_mcu_wait_for_current_packet_reception_and_clear_flag(void);
+void dma_dbflash_init_transfer(void* spi_data_p, void* datap, uint16_t size);
 uint16_t dma_aux_mcu_get_remaining_bytes_for_rx_transfer(void);
 BOOL dma_custom_fs_check_and_clear_dma_transfer_flag(void);
-BOOL dma_aux_mcu_check_and_clear_dma_transfer_flag(void);
+BOOL dma_dbflash_check_and_clear_dma_transfer_flag(void);
+BOOL dma_memset_check_and_clear_dma_transfer_flag(void);
 BOOL dma_oled_check_and_clear_dma_transfer_flag(void);
 BOOL dma_acc_check_and_clear_dma_transfer_flag(void);
-BOOL dma_aux_mcu_check_dma_transfer_flag(void);
+BOOL dma_aux_mcu_is_tx_transfer_done(void);
+BOOL dma_aux_mcu_is_rx_transfer_to_be_rearmed(void);
 void dma_wait_for_aux_mcu_packet_sent(void);
 void dma_aux_mcu_disable_transfer(void);
 void dma_set_custom_fs_flag_done(void);
@@ -12,6 +12,8 @@
 #include "driver_sercom.h"
 #include "custom_fs.h"
 #include "dataflash.h"
+#include "ed25519.h"
+#include "sha256.h"
 #include "dma.h"
 
 /* Current selected language entry */
@@ -31,6 +33,15 @@ BOOL custom_fs_data_bus_opened = FALSE;
 uint16_t custom_fs_temp_string1[128];
 /* CPZ look up table */
 cpz_lut_entry_t* custom_fs_cpz_lut;
+#ifndef NO_BUNDLE_SIGNATURE_CHECK
+/* Ed25519 public key checking the bundle signature */
+const uint8_t custom_fs_bundle_signing_public_key[ED25519_PUBLIC_KEY_LENGTH] = BUNDLE_SIGNING_PUBLIC_KEY;
+#endif
+#ifdef DEBUG_RENDER_STATS_ENABLED
+/* External flash traffic counters */
+uint32_t custom_fs_nb_flash_reads = 0;
+uint32_t custom_fs_nb_flash_bytes_read = 0;
+#endif
 
 
 /*! \fn     custom_fs_read_from_flash(uint8_t* datap, custom_fs_address_t address, uint32_t size)
@@ -49,6 +60,10 @@ RET_TYPE custom_fs_read_from_flash(uint8_t* datap, custom_fs_address_t address,
     } 
     else
     {
+        #ifdef DEBUG_RENDER_STATS_ENABLED
+        custom_fs_nb_flash_reads++;
+        custom_fs_nb_flash_bytes_read += size;
+        #endif
         dataflash_read_data_array(custom_fs_dataflash_desc, address, datap, size);
         //memcpy(datap, &mooltipass_bundle[address], size);
     }
@@ -83,7 +98,13 @@ RET_TYPE custom_fs_continuous_read_from_flash(uint8_t* datap, custom_fs_address_
         {
             dataflash_read_data_array_start(custom_fs_dataflash_desc, address);
             custom_fs_data_bus_opened = TRUE;
+            #ifdef DEBUG_RENDER_STATS_ENABLED
+            custom_fs_nb_flash_reads++;
+            #endif
         }
+        #ifdef DEBUG_RENDER_STATS_ENABLED
+        custom_fs_nb_flash_bytes_read += size;
+        #endif
         
         /* If we are using DMA */
         if (use_dma != FALSE)
@@ -102,11 +123,18 @@ RET_TYPE custom_fs_continuous_read_from_flash(uint8_t* datap, custom_fs_address_
 }
 
 /*! \fn     custom_fs_compute_and_check_external_bundle_crc32(void)
-*   \brief  Compute the crc32 of our bundle
+*   \brief  Compute the crc32 of our bundle, check its signature
 *   \return Success status
+*   \note   The signature is an Ed25519 signature of the SHA-256 of what is after the signed hash, hashed from the crc32 DMA stream
 */
 RET_TYPE custom_fs_compute_and_check_external_bundle_crc32(void)
 {
+    #ifndef NO_BUNDLE_SIGNATURE_CHECK
+    uint8_t bundle_hash[SHA256_DIGEST_LENGTH];
+    sha256_context_t bundle_hash_context;
+    sha256_init(&bundle_hash_context);
+    #endif
+    
     /* Start a read on external flash */
     dataflash_read_data_array_start(custom_fs_dataflash_desc, CUSTOM_FS_FILES_ADDR_OFFSET + sizeof(custom_fs_flash_header.magic_header) + sizeof(custom_fs_flash_header.total_size) + sizeof(custom_fs_flash_header.crc32));
 
@@ -115,8 +143,12 @@ RET_TYPE custom_fs_compute_and_check_external_bundle_crc32(void)
     dma_reset();
     #endif
 
-    /* Use the DMA controller to compute the crc32 */
-    uint32_t crc32 = dma_compute_crc32_from_spi((void*)&custom_fs_dataflash_desc->sercom_pt->SPI.DATA.reg, custom_fs_flash_header.total_size - sizeof(custom_fs_flash_header.magic_header) - sizeof(custom_fs_flash_header.total_size) - sizeof(custom_fs_flash_header.crc32));
+    /* Use the DMA controller to compute the crc32, and the hash of the same stream */
+    #ifndef NO_BUNDLE_SIGNATURE_CHECK
+    uint32_t crc32 = dma_compute_crc32_from_spi((void*)&custom_fs_dataflash_desc->sercom_pt->SPI.DATA.reg, custom_fs_flash_header.total_size - sizeof(custom_fs_flash_header.magic_header) - sizeof(custom_fs_flash_header.total_size) - sizeof(custom_fs_flash_header.crc32), &bundle_hash_context, sizeof(custom_fs_flash_header.signed_hash));
+    #else
+    uint32_t crc32 = dma_compute_crc32_from_spi((void*)&custom_fs_dataflash_desc->sercom_pt->SPI.DATA.reg, custom_fs_flash_header.total_size - sizeof(custom_fs_flash_header.magic_header) - sizeof(custom_fs_flash_header.total_size) - sizeof(custom_fs_flash_header.crc32), 0, 0);
+    #endif
     
     /* Stop transfer */
     dataflash_stop_ongoing_transfer(custom_fs_dataflash_desc);
@@ -127,14 +159,64 @@ RET_TYPE custom_fs_compute_and_check_external_bundle_crc32(void)
     #endif
     
     /* Do the final check */
-    if (custom_fs_flash_header.crc32 == crc32)
+    if (custom_fs_flash_header.crc32 != crc32)
     {
-        return RETURN_OK;
-    } 
-    else
+        return RETURN_NOK;
+    }
+    
+    /* Signature check */
+    #ifndef NO_BUNDLE_SIGNATURE_CHECK
+    sha256_final(&bundle_hash_context, bundle_hash);
+    return ed25519_verify(custom_fs_flash_header.signed_hash, bundle_hash, sizeof(bundle_hash), (uint8_t*)custom_fs_bundle_signing_public_key);
+    #else
+    return RETURN_OK;
+    #endif
+}
+
+/*! \fn     custom_fs_check_external_bundle_signature(void)
+*   \brief  Check the signature of the bundle in the external flash, firmware update file included
+*   \return Success status, RETURN_OK when the signature check is disabled
+*   \note   The bootloader only checks the bundle crc32: to be called before setting the fw upgrade flag
+*   \note   The bundle may have changed since boot, its header is read again. CPU reads leave the DMA controller to the running firmware
+*/
+RET_TYPE custom_fs_check_external_bundle_signature(void)
+{
+    #ifndef NO_BUNDLE_SIGNATURE_CHECK
+    uint32_t hashed_start = CUSTOM_FS_FILES_ADDR_OFFSET + sizeof(custom_fs_flash_header.magic_header) + sizeof(custom_fs_flash_header.total_size) + sizeof(custom_fs_flash_header.crc32) + sizeof(custom_fs_flash_header.signed_hash);
+    uint8_t read_buffer[DMA_CRC32_HASH_CHUNK_SIZE];
+    uint8_t bundle_hash[SHA256_DIGEST_LENGTH];
+    custom_file_flash_header_t bundle_header;
+    sha256_context_t bundle_hash_context;
+    uint32_t nb_bytes_to_read;
+    
+    /* Close a continuous read left opened */
+    custom_fs_stop_continuous_read_from_flash();
+    
+    /* Read the header */
+    custom_fs_read_from_flash((uint8_t*)&bundle_header, CUSTOM_FS_FILES_ADDR_OFFSET, sizeof(bundle_header));
+    if ((bundle_header.total_size <= hashed_start - CUSTOM_FS_FILES_ADDR_OFFSET) || (bundle_header.total_size > W25Q16_SIZE - CUSTOM_FS_FILES_ADDR_OFFSET))
     {
         return RETURN_NOK;
     }
+    
+    /* Hash what is after the signed hash */
+    sha256_init(&bundle_hash_context);
+    for (uint32_t address = hashed_start; address < CUSTOM_FS_FILES_ADDR_OFFSET + bundle_header.total_size; address += nb_bytes_to_read)
+    {
+        nb_bytes_to_read = CUSTOM_FS_FILES_ADDR_OFFSET + bundle_header.total_size - address;
+        if (nb_bytes_to_read > sizeof(read_buffer))
+        {
+            nb_bytes_to_read = sizeof(read_buffer);
+        }
+        custom_fs_read_from_flash(read_buffer, address, nb_bytes_to_read);
+        sha256_update(&bundle_hash_context, read_buffer, nb_bytes_to_read);
+    }
+    sha256_final(&bundle_hash_context, bundle_hash);
+    
+    return ed25519_verify(bundle_header.signed_hash, bundle_hash, sizeof(bundle_hash), (uint8_t*)custom_fs_bundle_signing_public_key);
+    #else
+    return RETURN_OK;
+    #endif
 }
 
 /*! \fn     custom_fs_stop_continuous_read_from_flash(void)
@@ -192,6 +274,24 @@ cust_char_t* custom_fs_get_current_language_text_desc(void)
     return custom_fs_cur_language_entry.language_descr;
 }
 
+/*! \fn     custom_fs_get_current_text_file_address(void)
+*   \brief  Get the address of the current language string file
+*   \return The address, 0 if the language doesn't have one
+*/
+custom_fs_address_t custom_fs_get_current_text_file_address(void)
+{
+    return custom_fs_current_text_file_addr;
+}
+
+/*! \fn     custom_fs_get_recommended_layout_for_current_language(void)
+*   \brief  Get the recommended keyboard layout for the current language
+*   \return Keyboard layout file ID
+*/
+uint16_t custom_fs_get_recommended_layout_for_current_language(void)
+{
+    return custom_fs_cur_language_entry.keyboard_layout_id;
+}
+
 /*! \fn     custom_fs_set_current_language(uint16_t language_id)
 *   \brief  Set current language
 *   \param  language_id     Language ID
@@ -383,6 +483,18 @@ RET_TYPE custom_fs_get_file_address(uint32_t file_id, custom_fs_address_t* addre
             file_table_address = custom_fs_flash_header.update_file_offset;
         }
     }
+    else if (file_type == CUSTOM_FS_KEYBOARD_TYPE)
+    {
+        /* Bundles generated before keyboard layouts were added have file tables in place of these fields */
+        if ((custom_fs_flash_header.keyboard_layout_magic != CUSTOM_FS_KEYBOARD_LAYOUT_MAGIC) || (file_id >= custom_fs_flash_header.keyboard_layout_file_count) || (custom_fs_flash_header.keyboard_layout_file_count == CUSTOM_FS_MAX_FILE_COUNT) || (custom_fs_flash_header.keyboard_layout_file_offset >= custom_fs_flash_header.total_size))
+        {
+            return RETURN_NOK;
+        }
+        else
+        {
+            file_table_address = custom_fs_flash_header.keyboard_layout_file_offset;
+        }
+    }
     else
     {
         return RETURN_NOK;
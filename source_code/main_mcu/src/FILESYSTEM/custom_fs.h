@@ -21,6 +21,8 @@
 #define CUSTOM_FS_EMERGENCY_FONT_FILE_ADDR  0x80000000UL
 // Magic number at the beginning of the flash header
 #define CUSTOM_FS_MAGIC_HEADER              0x12345678UL
+// Magic number & format version preceding the keyboard layout fields in the flash header
+#define CUSTOM_FS_KEYBOARD_LAYOUT_MAGIC     0x4B4C0001UL
 // Custom file flags
 #define CUSTOM_FS_BITMAP_RLE_FLAG           0x01
 // Flag to use provisioned key
@@ -43,7 +45,7 @@ typedef uint16_t custom_fs_string_offset_t;
 typedef uint32_t custom_fs_binfile_size_t;
 
 /* Enums */
-typedef enum {CUSTOM_FS_STRING_TYPE = 0, CUSTOM_FS_FONTS_TYPE = 1, CUSTOM_FS_BITMAP_TYPE = 2, CUSTOM_FS_BINARY_TYPE = 3, CUSTOM_FS_FW_UPDATE_TYPE = 4} custom_fs_file_type_te;
+typedef enum {CUSTOM_FS_STRING_TYPE = 0, CUSTOM_FS_FONTS_TYPE = 1, CUSTOM_FS_BITMAP_TYPE = 2, CUSTOM_FS_BINARY_TYPE = 3, CUSTOM_FS_FW_UPDATE_TYPE = 4, CUSTOM_FS_KEYBOARD_TYPE = 5} custom_fs_file_type_te;
     
 /* Structs */
 
@@ -51,13 +53,15 @@ typedef enum {CUSTOM_FS_STRING_TYPE = 0, CUSTOM_FS_FONTS_TYPE = 1, CUSTOM_FS_BIT
 // magic number: to indicate the presence of something in the flash
 // total size: total size of the bundle
 // crc32: crc32 of what is after the signed hash
-// signed hash: guess what it is...
+// signed hash: Ed25519 signature of the SHA-256 of what is after the signed hash
 // string file count: number of string files
 // string file offset: starting address at which to find the address of each string file
 // same for fonts, bitmaps, binary imgs...
 // language map items : number of language map items
 // language map offset: starting adress at which to find the address of the language map
 // language specific start id : starting ID at which a language specific bitmap is needed
+// keyboard layout magic: CUSTOM_FS_KEYBOARD_LAYOUT_MAGIC if the keyboard layout fields below are present
+// keyboard layout file count / offset: appended last to keep the previous fields in place
 typedef struct
 {
     uint32_t magic_header;
@@ -77,6 +81,9 @@ typedef struct
     custom_fs_file_count_t language_map_item_count;
     custom_fs_address_t language_map_offset;
     uint32_t language_bitmap_starting_id;
+    uint32_t keyboard_layout_magic;
+    custom_fs_file_count_t keyboard_layout_file_count;
+    custom_fs_address_t keyboard_layout_file_offset;
 } custom_file_flash_header_t;
 
 // Platform settings
@@ -127,6 +134,28 @@ typedef struct
     custom_fs_address_t glyph_data_offset;  // offset to glyph data
 } font_glyph_t;
 
+// Keyboard layout header, followed by the interval descriptors then the layout entries of each interval
+typedef struct
+{
+    uint16_t interval_count;        //*< Number of unicode intervals
+    uint16_t entry_count;           //*< Number of layout entries
+} keyboard_layout_header_t;
+
+// Keyboard layout unicode interval descriptor
+typedef struct
+{
+    uint16_t interval_start;        //*< First unicode point of the interval
+    uint16_t interval_end;          //*< Last unicode point of the interval
+    uint16_t first_entry;           //*< Index of the layout entry for interval_start
+} keyboard_layout_interval_desc_t;
+
+// Keyboard layout entry
+typedef struct
+{
+    uint8_t modifier;               //*< HID modifier byte
+    uint8_t keycode;                //*< HID keycode, 0 if the unicode point can't be typed
+} keyboard_layout_entry_t;
+
 // Language map entry
 typedef struct
 {
@@ -162,8 +191,11 @@ void custom_fs_set_dataflash_descriptor(spi_flash_descriptor_t* desc);
 uint8_t custom_fs_settings_get_device_setting(uint16_t setting_id);
 uint32_t custom_fs_get_custom_storage_slot_addr(uint32_t slot_id);
 RET_TYPE custom_fs_compute_and_check_external_bundle_crc32(void);
+RET_TYPE custom_fs_check_external_bundle_signature(void);
 ret_type_te custom_fs_set_current_language(uint16_t language_id);
 cust_char_t* custom_fs_get_current_language_text_desc(void);
+uint16_t custom_fs_get_recommended_layout_for_current_language(void);
+custom_fs_address_t custom_fs_get_current_text_file_address(void);
 void custom_fs_detele_user_cpz_lut_entry(uint8_t user_id);
 custom_fs_init_ret_type_te custom_fs_settings_init(void);
 void custom_fs_stop_continuous_read_from_flash(void);
@@ -180,5 +212,9 @@ ret_type_te custom_fs_init(void);
     extern custom_file_flash_header_t custom_fs_flash_header;
     extern language_map_entry_t custom_fs_cur_language_entry;
 #endif   
+#if defined(DEBUG_RENDER_STATS_ENABLED)
+    extern uint32_t custom_fs_nb_flash_bytes_read;
+    extern uint32_t custom_fs_nb_flash_reads;
+#endif
 
 #endif /* CUSTOM_FS_H_ */
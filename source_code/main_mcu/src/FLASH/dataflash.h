@@ -11,6 +11,7 @@
 
 /* Defines */
 #define W25Q16_PAGE_SIZE    256
+#define W25Q16_SIZE         (2UL*1024UL*1024UL)
 
 /* Prototypes */
 void dataflash_write_array_to_memory(spi_flash_descriptor_t* descriptor_pt, uint32_t address, uint8_t* data, uint32_t length);
@@ -435,6 +435,39 @@ void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t
     dbflash_wait_for_not_busy(descriptor_pt);
 }
 
+#ifdef DBFLASH_MEMORY_BOUNDARY_CHECKS
+/*! \fn     dbflash_check_read_boundaries(uint16_t pageNumber, uint16_t offset, uint16_t dataSize)
+*   \brief  Check that a read stays inside the flash
+*   \param  pageNumber      The target page number of flash memory
+*   \param  offset          The starting byte offset to begin reading in pageNumber
+*   \param  dataSize        The number of bytes to read
+*   \note   boundary checks are done for a maximum of 3 pages read (maximum abuse that a faulty address could do)
+*/
+static inline void dbflash_check_read_boundaries(uint16_t pageNumber, uint16_t offset, uint16_t dataSize)
+{
+    /* Use of ifs for speed */
+    uint16_t pages_used_for_command = offset + dataSize;
+    if (pages_used_for_command > 2*BYTES_PER_PAGE)
+    {
+        pages_used_for_command = 3;
+    } 
+    else if (pages_used_for_command > 1*BYTES_PER_PAGE)
+    {
+        pages_used_for_command = 2;
+    }
+    else
+    {
+        pages_used_for_command = 1;
+    }
+    
+    // Error check the parameter pageNumber
+    if(pageNumber + pages_used_for_command > PAGE_COUNT) // Ex: 1M -> PAGE_COUNT = 512.. valid pageNumber 0-511
+    {
+        dbflash_memory_boundary_error_callblack();
+    }
+}
+#endif
+
 /*! \fn     dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
 *   \brief  Reads a data buffer of flash memory. The data is read starting at offset of a page.
 *   \param  descriptor_pt   Pointer to dbflash descriptor
@@ -447,26 +480,7 @@ void dbflash_write_data_to_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t
 void dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize, void *data)
 {        
     #ifdef DBFLASH_MEMORY_BOUNDARY_CHECKS
-        /* Use of ifs for speed */
-        uint16_t pages_used_for_command = offset + dataSize;
-        if (pages_used_for_command > 2*BYTES_PER_PAGE)
-        {
-            pages_used_for_command = 3;
-        } 
-        else if (pages_used_for_command > 1*BYTES_PER_PAGE)
-        {
-            pages_used_for_command = 2;
-        }
-        else
-        {
-            pages_used_for_command = 1;
-        }
-    
-        // Error check the parameter pageNumber
-        if(pageNumber + pages_used_for_command > PAGE_COUNT) // Ex: 1M -> PAGE_COUNT = 512.. valid pageNumber 0-511
-        {
-            dbflash_memory_boundary_error_callblack();
-        }
+        dbflash_check_read_boundaries(pageNumber, offset, dataSize);
     #endif
     
     uint8_t opcode[4] = {DBFLASH_OPCODE_LOWF_READ};
@@ -474,6 +488,43 @@ void dbflash_read_data_from_flash(spi_flash_descriptor_t* descriptor_pt, uint16_
     dbflash_send_data_with_four_bytes_opcode(descriptor_pt, opcode, data, dataSize);
 } 
 
+/*! \fn     dbflash_read_data_start(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize)
+*   \brief  Open a read on the flash, the data bytes can then be clocked by the DMA controller
+*   \param  descriptor_pt   Pointer to dbflash descriptor
+*   \param  pageNumber      The target page number of flash memory
+*   \param  offset          The starting byte offset to begin reading in pageNumber
+*   \param  dataSize        The total number of bytes that will be read, for boundary checks
+*   \note   Call dbflash_stop_ongoing_transfer() once all the bytes are read
+*/
+void dbflash_read_data_start(spi_flash_descriptor_t* descriptor_pt, uint16_t pageNumber, uint16_t offset, uint16_t dataSize)
+{
+    #ifdef DBFLASH_MEMORY_BOUNDARY_CHECKS
+        dbflash_check_read_boundaries(pageNumber, offset, dataSize);
+    #endif
+    
+    uint8_t opcode[4] = {DBFLASH_OPCODE_LOWF_READ};
+    dbflash_fill_page_read_write_erase_opcode_from_address(pageNumber, offset, &opcode[1]);
+    
+    /* SS low */
+    PORT->Group[descriptor_pt->cs_pin_group].OUTCLR.reg = descriptor_pt->cs_pin_mask;
+    
+    /* Send opcode */
+    for (uint16_t i = 0; i < sizeof(opcode); i++)
+    {
+        sercom_spi_send_single_byte(descriptor_pt->sercom_pt, opcode[i]);
+    }
+}
+
+/*! \fn     dbflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt)
+*   \brief  End a read opened by dbflash_read_data_start()
+*   \param  descriptor_pt   Pointer to dbflash descriptor
+*/
+void dbflash_stop_ongoing_transfer(spi_flash_descriptor_t* descriptor_pt)
+{
+    /* SS high */
+    PORT->Group[descriptor_pt->cs_pin_group].OUTSET.reg = descriptor_pt->cs_pin_mask;
+}
+
 /*! \fn     dbflash_raw_read(spi_flash_descriptor_t* descriptor_pt, uint8_t* datap, uint16_t addr, uint16_t size)
 *   \brief  Contiguous data read across flash page boundaries with a max 65k bytes addressing space
 *   \param  descriptor_pt   Pointer to dbflash descriptor
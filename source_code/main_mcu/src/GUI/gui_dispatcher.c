@@ -3,14 +3,20 @@
 *    Created:  16/11/2018
 *    Author:   Mathieu Stephan
 */
+#include <string.h>
 #include "comms_hid_msgs_debug.h"
 #include "gui_dispatcher.h"
+#include "gui_list_view.h"
+#include "logic_security.h"
+#include "comms_trace.h"
 #include "driver_timer.h"
 #include "gui_carousel.h"
 #include "logic_device.h"
 #include "gui_prompts.h"
 #include "logic_power.h"
 #include "platform_io.h"
+#include "custom_fs.h"
+#include "nodemgmt.h"
 #include "gui_menu.h"
 #include "defines.h"
 #include "inputs.h"
@@ -18,6 +24,76 @@
 #include "main.h"
 // Current screen
 gui_screen_te gui_dispatcher_current_screen = GUI_SCREEN_NINSERTED;
+#ifdef DEBUG_RENDER_STATS_ENABLED
+// Per screen render statistics
+gui_render_stats_t gui_dispatcher_render_stats[GUI_NB_SCREENS];
+// Measurement in progress, to not count nested renders twice
+BOOL gui_dispatcher_render_measure_in_progress = FALSE;
+// Screen, systick & flash counters at measurement start
+gui_screen_te gui_dispatcher_render_measured_screen;
+uint32_t gui_dispatcher_render_start_systick;
+uint32_t gui_dispatcher_render_start_nb_reads;
+uint32_t gui_dispatcher_render_start_nb_bytes;
+#endif
+
+
+#ifdef DEBUG_RENDER_STATS_ENABLED
+/*! \fn     gui_dispatcher_render_stats_start(void)
+*   \brief  Start measuring a render for the current screen
+*   \return TRUE if a measurement was started, FALSE if one was already in progress
+*/
+static BOOL gui_dispatcher_render_stats_start(void)
+{
+    if (gui_dispatcher_render_measure_in_progress != FALSE)
+    {
+        return FALSE;
+    }
+    
+    gui_dispatcher_render_measure_in_progress = TRUE;
+    gui_dispatcher_render_measured_screen = gui_dispatcher_current_screen;
+    gui_dispatcher_render_start_nb_bytes = custom_fs_nb_flash_bytes_read;
+    gui_dispatcher_render_start_nb_reads = custom_fs_nb_flash_reads;
+    gui_dispatcher_render_start_systick = timer_get_systick();
+    return TRUE;
+}
+
+/*! \fn     gui_dispatcher_render_stats_stop(void)
+*   \brief  Stop measuring a render and store results for the screen it started on
+*   \note   Doesn't wait for an ongoing DMA frame buffer flush
+*/
+static void gui_dispatcher_render_stats_stop(void)
+{
+    gui_render_stats_t* stats = &gui_dispatcher_render_stats[gui_dispatcher_render_measured_screen];
+    uint32_t render_time = timer_get_systick() - gui_dispatcher_render_start_systick;
+    
+    stats->nb_renders++;
+    stats->total_render_time_ms += render_time;
+    if (render_time > stats->max_render_time_ms)
+    {
+        stats->max_render_time_ms = render_time;
+    }
+    stats->nb_flash_reads += custom_fs_nb_flash_reads - gui_dispatcher_render_start_nb_reads;
+    stats->nb_flash_bytes_read += custom_fs_nb_flash_bytes_read - gui_dispatcher_render_start_nb_bytes;
+    gui_dispatcher_render_measure_in_progress = FALSE;
+}
+
+/*! \fn     gui_dispatcher_get_render_stats(void)
+*   \brief  Get the per screen render statistics
+*   \return Pointer to an array of GUI_NB_SCREENS stats, indexed by gui_screen_te
+*/
+gui_render_stats_t* gui_dispatcher_get_render_stats(void)
+{
+    return gui_dispatcher_render_stats;
+}
+
+/*! \fn     gui_dispatcher_reset_render_stats(void)
+*   \brief  Reset the per screen render statistics
+*/
+void gui_dispatcher_reset_render_stats(void)
+{
+    memset((void*)gui_dispatcher_render_stats, 0, sizeof(gui_dispatcher_render_stats));
+}
+#endif
 
 
 /*! \fn     gui_dispatcher_set_current_screen(gui_screen_te screen)
@@ -27,10 +103,17 @@ gui_screen_te gui_dispatcher_current_screen = GUI_SCREEN_NINSERTED;
 */
 void gui_dispatcher_set_current_screen(gui_screen_te screen, BOOL reset_states, oled_transition_te transition)
 {
+    /* The credential list is only available to a logged in user */
+    if ((screen == GUI_SCREEN_LOGIN) && (logic_security_is_smc_inserted_unlocked() == FALSE))
+    {
+        screen = GUI_SCREEN_MAIN_MENU;
+    }
+    
     /* Store transition, screen, call menu reset routine */
     plat_oled_descriptor.loaded_transition = transition;
     gui_dispatcher_current_screen = screen;    
     gui_menu_reset_selected_items(reset_states);
+    COMMS_TRACE_1(TRACE_ID_GUI_SCREEN, screen);
     
     /* If we're going into a menu, set the selected menu */
     if ((screen >= GUI_SCREEN_MAIN_MENU) && (screen <= GUI_SCREEN_SETTINGS))
@@ -38,6 +121,12 @@ void gui_dispatcher_set_current_screen(gui_screen_te screen, BOOL reset_states,
         gui_menu_set_selected_menu(screen-GUI_SCREEN_MAIN_MENU+MAIN_MENU);
         gui_menu_update_menus();
     }
+    
+    /* If we're going into the credential list, decode the rows around the user's first credential */
+    if (screen == GUI_SCREEN_LOGIN)
+    {
+        gui_list_view_init(getStartingParentAddress());
+    }
 }
 
 /*! \fn     gui_dispatcher_get_back_to_current_screen(void)
@@ -45,6 +134,10 @@ void gui_dispatcher_set_current_screen(gui_screen_te screen, BOOL reset_states,
 */
 void gui_dispatcher_get_back_to_current_screen(void)
 {
+    #ifdef DEBUG_RENDER_STATS_ENABLED
+    BOOL render_measured = gui_dispatcher_render_stats_start();
+    #endif
+    
     /* switch to let the compiler optimize instead of function pointer array */
     switch (gui_dispatcher_current_screen)
     {
@@ -61,7 +154,7 @@ void gui_dispatcher_get_back_to_current_screen(void)
         case GUI_SCREEN_MEMORY_MGMT:        break;
         case GUI_SCREEN_CATEGORIES:         break;
         case GUI_SCREEN_FAVORITES:          break;
-        case GUI_SCREEN_LOGIN:              break;
+        case GUI_SCREEN_LOGIN:              gui_list_view_event_render(WHEEL_ACTION_NONE); break;
         case GUI_SCREEN_LOCK:               break;
         /* Common menu architecture */
         case GUI_SCREEN_MAIN_MENU:
@@ -70,6 +163,13 @@ void gui_dispatcher_get_back_to_current_screen(void)
         case GUI_SCREEN_SETTINGS:           gui_menu_event_render(WHEEL_ACTION_NONE);break;
         default: break;
     }
+    
+    #ifdef DEBUG_RENDER_STATS_ENABLED
+    if (render_measured != FALSE)
+    {
+        gui_dispatcher_render_stats_stop();
+    }
+    #endif
 }
 
 /*! \fn     gui_dispatcher_event_dispatch(wheel_action_ret_te wheel_action)
@@ -81,6 +181,10 @@ void gui_dispatcher_event_dispatch(wheel_action_ret_te wheel_action)
     /* Bool to know if we should rerender */
     BOOL rerender_bool = FALSE;
     
+    #ifdef DEBUG_RENDER_STATS_ENABLED
+    BOOL render_measured = gui_dispatcher_render_stats_start();
+    #endif
+    
     /* switch to let the compiler optimize instead of function pointer array */
     switch (gui_dispatcher_current_screen)
     {
@@ -102,7 +206,7 @@ void gui_dispatcher_event_dispatch(wheel_action_ret_te wheel_action)
         case GUI_SCREEN_MEMORY_MGMT:        break;
         case GUI_SCREEN_CATEGORIES:         break;
         case GUI_SCREEN_FAVORITES:          break;
-        case GUI_SCREEN_LOGIN:              break;
+        case GUI_SCREEN_LOGIN:              rerender_bool = gui_list_view_event_render(wheel_action); break;
         case GUI_SCREEN_LOCK:               break;
         /* Common menu architecture */        
         case GUI_SCREEN_MAIN_MENU:
@@ -117,6 +221,13 @@ void gui_dispatcher_event_dispatch(wheel_action_ret_te wheel_action)
     {
         gui_dispatcher_get_back_to_current_screen();
     }
+    
+    #ifdef DEBUG_RENDER_STATS_ENABLED
+    if (render_measured != FALSE)
+    {
+        gui_dispatcher_render_stats_stop();
+    }
+    #endif
 }
 
 /*! \fn     gui_dispatcher_main_loop(void)
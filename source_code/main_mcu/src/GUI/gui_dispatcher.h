@@ -36,6 +36,19 @@ typedef enum {  GUI_SCREEN_NINSERTED = 0,
                 GUI_SCREEN_OPERATIONS,
                 GUI_SCREEN_SETTINGS
              } gui_screen_te;
+#define GUI_NB_SCREENS  (GUI_SCREEN_SETTINGS+1)
+
+/* Structs */
+#ifdef DEBUG_RENDER_STATS_ENABLED
+typedef struct
+{
+    uint32_t nb_renders;
+    uint32_t total_render_time_ms;
+    uint32_t max_render_time_ms;
+    uint32_t nb_flash_reads;
+    uint32_t nb_flash_bytes_read;
+} gui_render_stats_t;
+#endif
              
 /* Transitions */
 #define     GUI_INTO_MENU_TRANSITION    OLED_IN_OUT_TRANS
@@ -46,6 +59,10 @@ void gui_dispatcher_set_current_screen(gui_screen_te screen, BOOL reset_states,
 void gui_dispatcher_event_dispatch(wheel_action_ret_te wheel_action);
 void gui_dispatcher_get_back_to_current_screen(void);
 void gui_dispatcher_main_loop(void);
+#ifdef DEBUG_RENDER_STATS_ENABLED
+gui_render_stats_t* gui_dispatcher_get_render_stats(void);
+void gui_dispatcher_reset_render_stats(void);
+#endif
 
 
 #endif /* GUI_DISPATCHER_H_ */
\ No newline at end of file
@@ -0,0 +1,277 @@
+/*!  \file     gui_list_view.c
+*    \brief    Scrollable credential list, with a ring of decoded rows
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include "platform_defines.h"
+#include "gui_dispatcher.h"
+#include "gui_list_view.h"
+#include "nodemgmt.h"
+#include "defines.h"
+#include "sh1122.h"
+#include "main.h"
+/* Ring of decoded rows: slot 0 is the row above the first displayed line, slot LIST_VIEW_NB_LINES+1 the one below the last */
+list_view_row_t gui_list_view_rows[LIST_VIEW_NB_CACHED_ROWS];
+// Index in the array above of slot 0
+uint16_t gui_list_view_ring_start = 0;
+// Selected line on screen
+uint16_t gui_list_view_selected_line = 0;
+
+
+/*! \fn     gui_list_view_get_slot(uint16_t slot)
+*   \brief  Get the decoded row stored in a given ring slot
+*   \param  slot    Slot number, 0 being the row above the first line
+*   \return Pointer to the row
+*/
+static inline list_view_row_t* gui_list_view_get_slot(uint16_t slot)
+{
+    return &gui_list_view_rows[(gui_list_view_ring_start + slot) % LIST_VIEW_NB_CACHED_ROWS];
+}
+
+/*! \fn     gui_list_view_copy_string(cust_char_t* dest, cust_char_t* src)
+*   \brief  Copy a string to a row buffer, truncating it if needed
+*   \param  dest    Row buffer (LIST_VIEW_STR_LGTH long)
+*   \param  src     Source string, 0 terminated
+*/
+static void gui_list_view_copy_string(cust_char_t* dest, cust_char_t* src)
+{
+    uint16_t i;
+
+    for (i = 0; (i < LIST_VIEW_STR_LGTH-1) && (src[i] != 0); i++)
+    {
+        dest[i] = src[i];
+    }
+    dest[i] = 0;
+}
+
+/*! \fn     gui_list_view_fetch_row(list_view_row_t* row, uint16_t parent_addr)
+*   \brief  Decode a parent node and its first child login into a row
+*   \param  row             Where to store the decoded data
+*   \param  parent_addr     Parent node address, may be NODE_ADDR_NULL
+*/
+static void gui_list_view_fetch_row(list_view_row_t* row, uint16_t parent_addr)
+{
+    parent_node_t temp_parent_node;
+
+    /* Empty row */
+    row->parent_addr = parent_addr;
+    row->prev_parent_addr = NODE_ADDR_NULL;
+    row->next_parent_addr = NODE_ADDR_NULL;
+    row->service[0] = 0;
+    row->login[0] = 0;
+
+    if (parent_addr == NODE_ADDR_NULL)
+    {
+        return;
+    }
+
+    /* Parent node: service & links to its neighbors */
+    readParentNode(parent_addr, &temp_parent_node, TRUE);
+    row->prev_parent_addr = temp_parent_node.cred_parent.prevParentAddress;
+    row->next_parent_addr = temp_parent_node.cred_parent.nextParentAddress;
+    gui_list_view_copy_string(row->service, temp_parent_node.cred_parent.service);
+
+    /* First child: login only */
+    if (temp_parent_node.cred_parent.nextChildAddress != NODE_ADDR_NULL)
+    {
+        readCredChildNodeLogin(temp_parent_node.cred_parent.nextChildAddress, row->login, LIST_VIEW_STR_LGTH);
+    }
+}
+
+/*! \fn     gui_list_view_render_selection_bar(uint16_t line, BOOL selected)
+*   \brief  Draw or erase the selection bar in front of a line
+*   \param  line        Line number on screen
+*   \param  selected    TRUE to draw the bar, FALSE to erase it
+*/
+static void gui_list_view_render_selection_bar(uint16_t line, BOOL selected)
+{
+    sh1122_draw_rectangle(&plat_oled_descriptor, 0, line*LIST_VIEW_LINE_HEIGHT, LIST_VIEW_SEL_BAR_WIDTH, LIST_VIEW_LINE_HEIGHT, (selected != FALSE)? 0x0F : 0x00, TRUE);
+}
+
+/*! \fn     gui_list_view_render_line(uint16_t line)
+*   \brief  Render a line from its decoded row, without any flash access
+*   \param  line        Line number on screen
+*/
+static void gui_list_view_render_line(uint16_t line)
+{
+    list_view_row_t* row = gui_list_view_get_slot(line+1);
+    uint16_t y = line*LIST_VIEW_LINE_HEIGHT;
+
+    /* Clear line */
+    sh1122_draw_rectangle(&plat_oled_descriptor, 0, y, SH1122_OLED_WIDTH, LIST_VIEW_LINE_HEIGHT, 0x00, TRUE);
+
+    if (row->parent_addr == NODE_ADDR_NULL)
+    {
+        return;
+    }
+
+    /* Selection bar */
+    if (line == gui_list_view_selected_line)
+    {
+        gui_list_view_render_selection_bar(line, TRUE);
+    }
+
+    /* Service on the left, login on the right */
+    sh1122_prevent_partial_text_x_draw(&plat_oled_descriptor);
+    sh1122_set_max_text_x(&plat_oled_descriptor, LIST_VIEW_SERVICE_MAX_X);
+    sh1122_put_string_xy(&plat_oled_descriptor, LIST_VIEW_SERVICE_X, y, OLED_ALIGN_LEFT, row->service, TRUE);
+    sh1122_reset_max_text_x(&plat_oled_descriptor);
+    sh1122_set_min_text_x(&plat_oled_descriptor, LIST_VIEW_LOGIN_MIN_X);
+    sh1122_put_string_xy(&plat_oled_descriptor, SH1122_OLED_WIDTH, y, OLED_ALIGN_RIGHT, row->login, TRUE);
+    sh1122_reset_min_text_x(&plat_oled_descriptor);
+    sh1122_allow_partial_text_x_draw(&plat_oled_descriptor);
+}
+
+/*! \fn     gui_list_view_render_all_lines(void)
+*   \brief  Render all the lines from the decoded rows and flush them
+*/
+static void gui_list_view_render_all_lines(void)
+{
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_check_for_flush_and_terminate(&plat_oled_descriptor);
+    #endif
+
+    sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MEDIUM_16_ID);
+    for (uint16_t i = 0; i < LIST_VIEW_NB_LINES; i++)
+    {
+        gui_list_view_render_line(i);
+    }
+
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_flush_frame_buffer(&plat_oled_descriptor);
+    #endif
+}
+
+/*! \fn     gui_list_view_scroll(BOOL scroll_down)
+*   \brief  Scroll the displayed lines by one after the ring was shifted: only the newly exposed line is rendered
+*   \param  scroll_down     TRUE when scrolling down, FALSE when scrolling up
+*   \note   The selected line stays the same, the bar shifted along with its former row is erased
+*/
+static void gui_list_view_scroll(BOOL scroll_down)
+{
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    uint16_t new_line = (scroll_down != FALSE)? LIST_VIEW_NB_LINES-1 : 0;
+    uint16_t shifted_bar_line = (scroll_down != FALSE)? gui_list_view_selected_line-1 : gui_list_view_selected_line+1;
+    
+    /* Waits for the previous flush */
+    sh1122_shift_frame_buffer(&plat_oled_descriptor, (scroll_down != FALSE)? -LIST_VIEW_LINE_HEIGHT : LIST_VIEW_LINE_HEIGHT);
+    gui_list_view_render_selection_bar(shifted_bar_line, FALSE);
+    
+    sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MEDIUM_16_ID);
+    gui_list_view_render_line(new_line);
+    sh1122_flush_frame_buffer(&plat_oled_descriptor);
+    #else
+    gui_list_view_render_all_lines();
+    #endif
+}
+
+/*! \fn     gui_list_view_move_selection(uint16_t new_line)
+*   \brief  Move the selection bar to another line: only the two bars are redrawn
+*   \param  new_line    New selected line
+*/
+static void gui_list_view_move_selection(uint16_t new_line)
+{
+    uint16_t old_line = gui_list_view_selected_line;
+
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_check_for_flush_and_terminate(&plat_oled_descriptor);
+    #endif
+
+    gui_list_view_selected_line = new_line;
+    gui_list_view_render_selection_bar(old_line, FALSE);
+    gui_list_view_render_selection_bar(new_line, TRUE);
+
+    #ifdef OLED_INTERNAL_FRAME_BUFFER
+    sh1122_flush_frame_buffer_window(&plat_oled_descriptor, 0, old_line*LIST_VIEW_LINE_HEIGHT, LIST_VIEW_SEL_BAR_WIDTH, LIST_VIEW_LINE_HEIGHT);
+    sh1122_flush_frame_buffer_window(&plat_oled_descriptor, 0, new_line*LIST_VIEW_LINE_HEIGHT, LIST_VIEW_SEL_BAR_WIDTH, LIST_VIEW_LINE_HEIGHT);
+    #endif
+}
+
+/*! \fn     gui_list_view_init(uint16_t parent_addr)
+*   \brief  Decode the rows around a given parent node, which will be displayed on the first line
+*   \param  parent_addr     Parent node address, usually the first one of the user
+*/
+void gui_list_view_init(uint16_t parent_addr)
+{
+    gui_list_view_ring_start = 0;
+    gui_list_view_selected_line = 0;
+
+    /* First displayed line, then the row above it, then the rows below */
+    gui_list_view_fetch_row(gui_list_view_get_slot(1), parent_addr);
+    gui_list_view_fetch_row(gui_list_view_get_slot(0), gui_list_view_get_slot(1)->prev_parent_addr);
+    for (uint16_t i = 2; i < LIST_VIEW_NB_CACHED_ROWS; i++)
+    {
+        gui_list_view_fetch_row(gui_list_view_get_slot(i), gui_list_view_get_slot(i-1)->next_parent_addr);
+    }
+}
+
+/*! \fn     gui_list_view_get_selected_parent_address(void)
+*   \brief  Get the parent node address of the selected line
+*   \return The address, NODE_ADDR_NULL if the list is empty
+*/
+uint16_t gui_list_view_get_selected_parent_address(void)
+{
+    return gui_list_view_get_slot(gui_list_view_selected_line+1)->parent_addr;
+}
+
+/*! \fn     gui_list_view_event_render(wheel_action_ret_te wheel_action)
+*   \brief  Render the credential list depending on event received
+*   \param  wheel_action    Wheel action received
+*   \return TRUE if screen rendering is required
+*   \note   Moving the selection only redraws the selection bars. Scrolling shifts the ring and the frame buffer,
+*           renders the newly exposed line and decodes a single new row while the frame is being flushed
+*/
+BOOL gui_list_view_event_render(wheel_action_ret_te wheel_action)
+{
+    if (wheel_action == WHEEL_ACTION_NONE)
+    {
+        gui_list_view_render_all_lines();
+    }
+    else if (wheel_action == WHEEL_ACTION_UP)
+    {
+        /* Nothing above the selected row */
+        if (gui_list_view_get_slot(gui_list_view_selected_line)->parent_addr == NODE_ADDR_NULL)
+        {
+            return FALSE;
+        }
+
+        if (gui_list_view_selected_line > 0)
+        {
+            gui_list_view_move_selection(gui_list_view_selected_line-1);
+        }
+        else
+        {
+            /* Scroll up: former last slot becomes slot 0, prefetched once the display is on its way */
+            gui_list_view_ring_start = (gui_list_view_ring_start + LIST_VIEW_NB_CACHED_ROWS - 1) % LIST_VIEW_NB_CACHED_ROWS;
+            gui_list_view_scroll(FALSE);
+            gui_list_view_fetch_row(gui_list_view_get_slot(0), gui_list_view_get_slot(1)->prev_parent_addr);
+        }
+    }
+    else if (wheel_action == WHEEL_ACTION_DOWN)
+    {
+        /* Nothing below the selected row */
+        if (gui_list_view_get_slot(gui_list_view_selected_line+2)->parent_addr == NODE_ADDR_NULL)
+        {
+            return FALSE;
+        }
+
+        if (gui_list_view_selected_line < LIST_VIEW_NB_LINES-1)
+        {
+            gui_list_view_move_selection(gui_list_view_selected_line+1);
+        }
+        else
+        {
+            /* Scroll down: former slot 0 becomes the last slot, prefetched once the display is on its way */
+            gui_list_view_ring_start = (gui_list_view_ring_start + 1) % LIST_VIEW_NB_CACHED_ROWS;
+            gui_list_view_scroll(TRUE);
+            gui_list_view_fetch_row(gui_list_view_get_slot(LIST_VIEW_NB_CACHED_ROWS-1), gui_list_view_get_slot(LIST_VIEW_NB_CACHED_ROWS-2)->next_parent_addr);
+        }
+    }
+    else if (wheel_action == WHEEL_ACTION_LONG_CLICK)
+    {
+        gui_dispatcher_set_current_screen(GUI_SCREEN_MAIN_MENU, FALSE, GUI_OUTOF_MENU_TRANSITION);
+        return TRUE;
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,42 @@
+/*!  \file     gui_list_view.h
+*    \brief    Scrollable credential list, with a ring of decoded rows
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef GUI_LIST_VIEW_H_
+#define GUI_LIST_VIEW_H_
+
+#include "defines.h"
+
+/* Defines */
+// Number of lines displayed on the screen
+#define LIST_VIEW_NB_LINES          4
+#define LIST_VIEW_LINE_HEIGHT       16
+// Decoded rows: displayed lines + one prefetched above & below
+#define LIST_VIEW_NB_CACHED_ROWS    (LIST_VIEW_NB_LINES+2)
+// Number of characters stored for service & login
+#define LIST_VIEW_STR_LGTH          32
+// Layout
+#define LIST_VIEW_SEL_BAR_WIDTH     3
+#define LIST_VIEW_SERVICE_X         6
+#define LIST_VIEW_SERVICE_MAX_X     150
+#define LIST_VIEW_LOGIN_MIN_X       156
+
+/* Structs */
+typedef struct
+{
+    uint16_t parent_addr;
+    uint16_t prev_parent_addr;
+    uint16_t next_parent_addr;
+    cust_char_t service[LIST_VIEW_STR_LGTH];
+    cust_char_t login[LIST_VIEW_STR_LGTH];
+} list_view_row_t;
+
+/* Prototypes */
+BOOL gui_list_view_event_render(wheel_action_ret_te wheel_action);
+uint16_t gui_list_view_get_selected_parent_address(void);
+void gui_list_view_init(uint16_t parent_addr);
+
+#endif /* GUI_LIST_VIEW_H_ */
@@ -146,6 +146,7 @@ BOOL gui_menu_event_render(wheel_action_ret_te wheel_action)
             case GUI_OPR_ICON_ID:           gui_dispatcher_set_current_screen(GUI_SCREEN_OPERATIONS, FALSE, GUI_INTO_MENU_TRANSITION); return TRUE;
             case GUI_SETTINGS_ICON_ID:      gui_dispatcher_set_current_screen(GUI_SCREEN_SETTINGS, FALSE, GUI_INTO_MENU_TRANSITION); return TRUE;
             case GUI_BT_ICON_ID:            gui_dispatcher_set_current_screen(GUI_SCREEN_BT, FALSE, GUI_INTO_MENU_TRANSITION); return TRUE;
+            case GUI_LOGIN_ICON_ID:         gui_dispatcher_set_current_screen(GUI_SCREEN_LOGIN, FALSE, GUI_INTO_MENU_TRANSITION); return TRUE;
             
             /* Common to all sub-menus */
             case GUI_BACK_ICON_ID:
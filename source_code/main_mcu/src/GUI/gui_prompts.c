@@ -5,6 +5,7 @@
 */
 #include <string.h>
 #include "smartcard_lowlevel.h"
+#include "comms_hid_msgs.h"
 #include "comms_aux_mcu.h"
 #include "driver_timer.h"
 #include "logic_device.h"
@@ -43,6 +44,242 @@ const uint16_t gui_prompts_notif_popup_anim_length[3] = {INFO_NOTIF_ANIM_LGTH, W
 const uint16_t gui_prompts_notif_popup_anim_bitmap[3] = {BITMAP_INFO_NOTIF_POPUP_ID, BITMAP_WARNING_NOTIF_POPUP_ID, BITMAP_ACTION_NOTIF_POPUP_ID};
 const uint16_t gui_prompts_notif_idle_anim_length[3] = {INFO_NOTIF_IDLE_ANIM_LGTH, WARNING_NOTIF_IDLE_ANIM_LGTH, ACTION_NOTIF_IDLE_ANIM_LGTH};
 const uint16_t gui_prompts_notif_idle_anim_bitmap[3] = {BITMAP_INFO_NOTIF_IDLE_ID, BITMAP_WARNING_NOTIF_IDLE_ID, BITMAP_ACTION_NOTIF_IDLE_ID};
+// Layout of the last displayed information string
+text_layout_t gui_prompts_info_text_layout = {.string = 0, .string_id = TEXT_LAYOUT_NO_STRING_ID, .text_file_address = 0, .font_address = 0};
+
+
+/*! \fn     gui_prompts_center_text_layout_x(text_layout_t* layout, uint16_t width)
+*   \brief  X to display a given width centered in the layout text box, as sh1122_put_string_xy() would
+*   \param  layout      Pointer to the layout
+*   \param  width       Width in pixels
+*   \return The x
+*/
+static int16_t gui_prompts_center_text_layout_x(text_layout_t* layout, uint16_t width)
+{
+    if ((layout->min_text_x + width) < layout->max_text_x)
+    {
+        return layout->min_text_x + (layout->max_text_x - layout->min_text_x - width)/2;
+    }
+    else
+    {
+        return layout->min_text_x;
+    }
+}
+
+/*! \fn     gui_prompts_break_text_layout_lines(text_layout_t* layout)
+*   \brief  Break a layout string into lines fitting the text box, truncate the last one with an ellipsis if needed
+*   \param  layout      Pointer to the layout, with its key set
+*   \note   Lines are broken on '\n', else on the last space fitting in the text box, else on the last fitting character
+*/
+static void gui_prompts_break_text_layout_lines(text_layout_t* layout)
+{
+    uint16_t box_width = layout->max_text_x - layout->min_text_x;
+    uint16_t line_widths[TEXT_LAYOUT_MAX_NB_LINES];
+    uint16_t glyph_height;
+    uint16_t index = 0;
+    
+    layout->nb_lines = 0;
+    layout->truncated = FALSE;
+    while ((layout->nb_lines < layout->max_nb_lines) && (layout->string[index] != 0))
+    {
+        uint16_t line_start = index;
+        uint16_t line_width = 0;
+        uint16_t space_index = UINT16_MAX;
+        uint16_t width_before_space = 0;
+        
+        /* Add characters until the line is full */
+        while ((layout->string[index] != 0) && (layout->string[index] != '\n'))
+        {
+            uint16_t glyph_width = sh1122_get_glyph_width(&plat_oled_descriptor, layout->string[index], &glyph_height);
+            if (((line_width + glyph_width) > box_width) && (index != line_start))
+            {
+                break;
+            }
+            if (layout->string[index] == ' ')
+            {
+                space_index = index;
+                width_before_space = line_width;
+            }
+            line_width += glyph_width;
+            index++;
+        }
+        
+        /* Line full: break on its last space if there's one */
+        if ((layout->string[index] != 0) && (layout->string[index] != '\n') && (space_index != UINT16_MAX))
+        {
+            layout->line_length[layout->nb_lines] = space_index - line_start;
+            line_widths[layout->nb_lines] = width_before_space;
+            index = space_index + 1;
+        }
+        else
+        {
+            layout->line_length[layout->nb_lines] = index - line_start;
+            line_widths[layout->nb_lines] = line_width;
+            if (layout->string[index] == '\n')
+            {
+                index++;
+            }
+        }
+        layout->line_start[layout->nb_lines++] = line_start;
+    }
+    
+    /* Remaining characters: make room for the ellipsis on the last line */
+    if ((layout->string[index] != 0) && (layout->nb_lines != 0))
+    {
+        uint16_t last_line = layout->nb_lines - 1;
+        uint16_t ellipsis_width = TEXT_LAYOUT_ELLIPSIS_LENGTH * sh1122_get_glyph_width(&plat_oled_descriptor, TEXT_LAYOUT_ELLIPSIS_CHAR, &glyph_height);
+        
+        while ((layout->line_length[last_line] != 0) && ((line_widths[last_line] + ellipsis_width) > box_width))
+        {
+            layout->line_length[last_line]--;
+            line_widths[last_line] -= sh1122_get_glyph_width(&plat_oled_descriptor, layout->string[layout->line_start[last_line] + layout->line_length[last_line]], &glyph_height);
+        }
+        line_widths[last_line] += ellipsis_width;
+        layout->truncated = TRUE;
+    }
+    
+    /* Center each line, string measures from the widest one */
+    layout->string_width = 0;
+    for (uint16_t i = 0; i < layout->nb_lines; i++)
+    {
+        layout->line_x[i] = gui_prompts_center_text_layout_x(layout, line_widths[i]);
+        if (line_widths[i] > layout->string_width)
+        {
+            layout->string_width = line_widths[i];
+        }
+    }
+    layout->centered_x = gui_prompts_center_text_layout_x(layout, layout->string_width);
+    layout->overflows = layout->truncated;
+}
+
+/*! \fn     gui_prompts_update_text_layout(text_layout_t* layout, const cust_char_t* string, uint32_t string_id, uint16_t font_id, uint16_t max_nb_lines)
+*   \brief  Lay out a string in the current text box, unless the layout is already valid
+*   \param  layout          Pointer to the layout, zero initialized before its first use
+*   \param  string          Null terminated string
+*   \param  string_id       Bundle string ID, TEXT_LAYOUT_NO_STRING_ID if the string isn't fetched from the bundle
+*   \param  font_id         Font ID
+*   \param  max_nb_lines    Max number of lines (up to TEXT_LAYOUT_MAX_NB_LINES), or TEXT_LAYOUT_NO_LINE_BREAK for a single line scrolled by the caller
+*   \note   Bundle strings are all fetched in the same buffer: they are told apart by their ID and the current language string file,
+*           as languages may share their fonts. Other strings by their address only, their contents mustn't change while the layout
+*           is in use. Layout is also invalidated by font or text box changes. Checking it costs a single font address lookup
+*/
+static void gui_prompts_update_text_layout(text_layout_t* layout, const cust_char_t* string, uint32_t string_id, uint16_t font_id, uint16_t max_nb_lines)
+{
+    custom_fs_address_t text_file_address = custom_fs_get_current_text_file_address();
+    custom_fs_address_t font_address;
+    
+    /* Font address for that ID: changes with the language */
+    if (custom_fs_get_file_address(font_id, &font_address, CUSTOM_FS_FONTS_TYPE) != RETURN_OK)
+    {
+        font_address = 0;
+    }
+    
+    /* Still valid? */
+    if ((layout->string == string) && (layout->string_id == string_id) && (layout->text_file_address == text_file_address) && (layout->font_id == font_id) && (layout->font_address == font_address) && (font_address != 0) && 
+        (layout->min_text_x == plat_oled_descriptor.min_text_x) && (layout->max_text_x == plat_oled_descriptor.max_text_x) && (layout->max_nb_lines == max_nb_lines))
+    {
+        return;
+    }
+    
+    /* Load font to measure the string */
+    if ((font_address == 0) || (plat_oled_descriptor.currentFontAddress != font_address))
+    {
+        sh1122_refresh_used_font(&plat_oled_descriptor, font_id);
+    }
+    
+    /* Store layout key */
+    layout->string = string;
+    layout->string_id = string_id;
+    layout->text_file_address = text_file_address;
+    layout->font_id = font_id;
+    layout->font_address = font_address;
+    layout->min_text_x = plat_oled_descriptor.min_text_x;
+    layout->max_text_x = plat_oled_descriptor.max_text_x;
+    layout->max_nb_lines = (max_nb_lines > TEXT_LAYOUT_MAX_NB_LINES)? TEXT_LAYOUT_MAX_NB_LINES : max_nb_lines;
+    layout->line_height = plat_oled_descriptor.current_font_header.height;
+    
+    /* Single line: measure the whole string, scrolled by the caller when overflowing */
+    layout->string_length = utils_strlen((cust_char_t*)string);
+    if (layout->max_nb_lines == TEXT_LAYOUT_NO_LINE_BREAK)
+    {
+        layout->string_width = sh1122_get_string_width(&plat_oled_descriptor, string);
+        layout->centered_x = gui_prompts_center_text_layout_x(layout, layout->string_width);
+        layout->overflows = ((layout->min_text_x + layout->string_width) > layout->max_text_x)? TRUE : FALSE;
+        layout->nb_lines = 1;
+        layout->line_start[0] = 0;
+        layout->line_length[0] = layout->string_length;
+        layout->line_x[0] = layout->centered_x;
+        layout->truncated = FALSE;
+    }
+    else
+    {
+        gui_prompts_break_text_layout_lines(layout);
+    }
+}
+
+/*! \fn     gui_prompts_render_text_layout(text_layout_t* layout, uint16_t y)
+*   \brief  Display the lines of a laid out string, without measuring it again
+*   \param  layout      Pointer to the layout
+*   \param  y           Y of a single line: multiple lines are vertically centered on it
+*   \return How many characters were printed, ellipsis excluded
+*/
+static uint16_t gui_prompts_render_text_layout(text_layout_t* layout, uint16_t y)
+{
+    uint16_t nb_printed_chars = 0;
+    
+    /* Only load the font if another one is in use */
+    if (plat_oled_descriptor.currentFontAddress != layout->font_address)
+    {
+        sh1122_refresh_used_font(&plat_oled_descriptor, layout->font_id);
+    }
+    
+    if (layout->nb_lines > 1)
+    {
+        y -= (layout->nb_lines - 1) * layout->line_height / 2;
+    }
+    for (uint16_t i = 0; i < layout->nb_lines; i++)
+    {
+        sh1122_set_xy(&plat_oled_descriptor, layout->line_x[i], y + i*layout->line_height);
+        for (uint16_t j = 0; j < layout->line_length[i]; j++)
+        {
+            if (sh1122_put_char(&plat_oled_descriptor, layout->string[layout->line_start[i] + j], TRUE) != RETURN_OK)
+            {
+                break;
+            }
+            nb_printed_chars++;
+        }
+    }
+    
+    /* Truncated string */
+    if (layout->truncated != FALSE)
+    {
+        for (uint16_t i = 0; i < TEXT_LAYOUT_ELLIPSIS_LENGTH; i++)
+        {
+            sh1122_put_char(&plat_oled_descriptor, TEXT_LAYOUT_ELLIPSIS_CHAR, TRUE);
+        }
+    }
+    
+    return nb_printed_chars;
+}
+
+/*! \fn     gui_prompts_render_scrolled_text_layout(text_layout_t* layout, int16_t x, uint16_t y)
+*   \brief  Display a whole laid out string at a given x, for overflowing strings scrolled by the caller
+*   \param  layout      Pointer to the layout
+*   \param  x           Starting x
+*   \param  y           Starting y
+*   \return How many characters were printed
+*/
+static uint16_t gui_prompts_render_scrolled_text_layout(text_layout_t* layout, int16_t x, uint16_t y)
+{
+    /* Only load the font if another one is in use */
+    if (plat_oled_descriptor.currentFontAddress != layout->font_address)
+    {
+        sh1122_refresh_used_font(&plat_oled_descriptor, layout->font_id);
+    }
+    
+    sh1122_set_xy(&plat_oled_descriptor, x, y);
+    return sh1122_put_string(&plat_oled_descriptor, layout->string, TRUE);
+}
 
 
 /*! \fn     gui_prompts_display_information_on_screen(uint16_t string_id, display_message_te message_type)
@@ -65,10 +302,10 @@ void gui_prompts_display_information_on_screen(uint16_t string_id, display_messa
     /* Try to fetch the string to display */
     custom_fs_get_string_from_file(string_id, &string_to_display, TRUE);
     
-    /* Display string */
-    sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MEDIUM_16_ID);
+    /* Display string, only measured when it changed */
     sh1122_set_min_text_x(&plat_oled_descriptor, gui_prompts_notif_min_x[message_type]);
-    sh1122_put_centered_string(&plat_oled_descriptor, INF_DISPLAY_TEXT_Y, string_to_display, TRUE);
+    gui_prompts_update_text_layout(&gui_prompts_info_text_layout, string_to_display, string_id, FONT_UBUNTU_MEDIUM_16_ID, INF_DISPLAY_MAX_NB_LINES);
+    gui_prompts_render_text_layout(&gui_prompts_info_text_layout, INF_DISPLAY_TEXT_Y);
     sh1122_reset_min_text_x(&plat_oled_descriptor);
     
     /* Flush frame buffer */
@@ -122,6 +359,94 @@ void gui_prompts_display_information_on_screen_and_wait(uint16_t string_id, disp
     }
 }
 
+/*! \fn     gui_prompts_wait_for_animation_frame_end(void)
+*   \brief  Wait for the end of the current animation frame slot
+*   \note   Frame slots are opened by arming TIMER_ANIMATIONS before rendering, so rendering time is absorbed in the frame period
+*/
+static void gui_prompts_wait_for_animation_frame_end(void)
+{
+    while (timer_has_timer_expired(TIMER_ANIMATIONS, TRUE) != TIMER_EXPIRED);
+}
+
+/*! \fn     gui_prompts_render_pin_digit_column(uint16_t column, cust_char_t current_char, cust_char_t next_char, BOOL is_selected, BOOL display_arrows, int16_t anim_step, int16_t vert_anim_direction)
+*   \brief  Redraw a single digit column of the pin entering screen in the frame buffer
+*   \param  column              Digit column (0 to 3)
+*   \param  current_char        Currently displayed char for this column
+*   \param  next_char           Char rolling in when animating
+*   \param  is_selected         Set to TRUE if this is the selected digit
+*   \param  display_arrows      Set to TRUE to display the arrows above & below the selected digit
+*   \param  anim_step           Current vertical animation step
+*   \param  vert_anim_direction Vertical anim direction (wheel up or down)
+*   \note   Digits font must already be loaded
+*/
+static void gui_prompts_render_pin_digit_column(uint16_t column, cust_char_t current_char, cust_char_t next_char, BOOL is_selected, BOOL display_arrows, int16_t anim_step, int16_t vert_anim_direction)
+{
+    int16_t column_x = PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*column;
+    
+    /* Erase the column only: the rest of the screen stays as is */
+    sh1122_draw_rectangle(&plat_oled_descriptor, column_x, PIN_PROMPT_UP_ARROW_Y, PIN_PROMPT_DIGIT_X_SPC, PIN_PROMPT_COLUMN_HEIGHT, 0x00, TRUE);
+    
+    if (is_selected == FALSE)
+    {
+        /* Display '*' */
+        sh1122_set_xy(&plat_oled_descriptor, column_x + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_DIGIT_Y + PIN_PROMPT_ASTX_Y_INC);
+        sh1122_put_char(&plat_oled_descriptor, u'*', TRUE);
+        return;
+    }
+    
+    /* Arrows potential animations for scrolling digits */
+    if (display_arrows != FALSE)
+    {
+        if (vert_anim_direction > 0)
+        {
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, column_x, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_ACTIVATE_ID+(anim_step-1)/2, TRUE);
+        }
+        else
+        {
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, column_x, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_POP_ID+PIN_PROMPT_POPUP_ANIM_LGTH-1, TRUE);
+        }
+        if (vert_anim_direction < 0)
+        {
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, column_x, PIN_PROMPT_DN_ARROW_Y, BITMAP_PIN_DN_ARROW_ACTIVATE_ID+(anim_step-1)/2, TRUE);
+        }
+        else
+        {
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, column_x, PIN_PROMPT_DN_ARROW_Y, BITMAP_PIN_DN_ARROW_POP_ID+PIN_PROMPT_POPUP_ANIM_LGTH-1, TRUE);
+        }
+    }
+    
+    /* Digits display with animation */
+    sh1122_allow_partial_text_y_draw(&plat_oled_descriptor);
+    sh1122_set_min_display_y(&plat_oled_descriptor, PIN_PROMPT_DIGIT_Y);
+    sh1122_set_max_display_y(&plat_oled_descriptor, PIN_PROMPT_DIGIT_Y+PIN_PROMPT_DIGIT_HEIGHT);
+    sh1122_set_xy(&plat_oled_descriptor, column_x + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_DIGIT_Y + anim_step*vert_anim_direction);
+    sh1122_put_char(&plat_oled_descriptor, current_char, TRUE);
+    if (vert_anim_direction != 0)
+    {
+        sh1122_set_xy(&plat_oled_descriptor, column_x + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_DIGIT_Y + anim_step*vert_anim_direction + (PIN_PROMPT_DIGIT_HEIGHT+1)*vert_anim_direction*-1);
+        sh1122_put_char(&plat_oled_descriptor, next_char, TRUE);
+    }
+    sh1122_reset_lim_display_y(&plat_oled_descriptor);
+    sh1122_prevent_partial_text_y_draw(&plat_oled_descriptor);
+}
+
+/*! \fn     gui_prompts_pin_digit_to_char(uint8_t digit)
+*   \brief  Convert a pin digit into its displayed char
+*   \param  digit   Pin digit (0x0 to 0xF)
+*   \return The char to display
+*/
+static cust_char_t gui_prompts_pin_digit_to_char(uint8_t digit)
+{
+    if (digit >= 0x0A)
+    {
+        return digit + u'A' - 0x0A;
+    }
+    else
+    {
+        return digit + u'0';
+    }
+}
+
 /*! \fn     gui_prompts_render_pin_enter_screen(uint8_t* current_pin, uint16_t selected_digit, uint16_t stringID, int16_t anim_direction, int16_t vert_anim_direction, int16_t hor_anim_direction)
 *   \brief  Overwrite the digits on the current pin entering screen
 *   \param  current_pin         Array containing the pin
@@ -129,14 +454,10 @@ void gui_prompts_display_information_on_screen_and_wait(uint16_t string_id, disp
 *   \param  stringID            String ID for text query
 *   \param  vert_anim_direction Vertical anim direction (wheel up or down)
 *   \param  hor_anim_direction  Horizontal anim direction (next/previous digit)
+*   \note   Only the first display (no animation) renders the complete screen. Subsequent calls only regenerate and flush the digit columns that change
 */
 void gui_prompts_render_pin_enter_screen(uint8_t* current_pin, uint16_t selected_digit, uint16_t stringID, int16_t vert_anim_direction, int16_t hor_anim_direction)
 {
-    cust_char_t* string_to_display;
-    
-    /* Try to fetch the string to display */
-    custom_fs_get_string_from_file(stringID, &string_to_display, TRUE);
-    
     /* Animation: get current digit and the next one */
     int16_t next_digit = current_pin[selected_digit] + vert_anim_direction;
     if (next_digit == 0x10)
@@ -149,140 +470,101 @@ void gui_prompts_render_pin_enter_screen(uint8_t* current_pin, uint16_t selected
     }
     
     /* Convert current digit and next one into chars */
-    cust_char_t current_char = current_pin[selected_digit] + u'0';
-    cust_char_t next_char = next_digit + u'0';
-    if (current_pin[selected_digit] >= 0x0A)
-    {
-        current_char = current_pin[selected_digit] + u'A' - 0x0A;
-    }
-    if (next_digit >= 0x0A)
-    {
-        next_char = next_digit + u'A' - 0x0A;
-    }
+    cust_char_t current_char = gui_prompts_pin_digit_to_char(current_pin[selected_digit]);
+    cust_char_t next_char = gui_prompts_pin_digit_to_char((uint8_t)next_digit);
     
-    /* Number of animation steps */
-    int16_t nb_animation_steps = PIN_PROMPT_DIGIT_HEIGHT + 2;
-    if (vert_anim_direction == 0)
+    /* First display: render the complete screen */
+    if ((hor_anim_direction == 0) && (vert_anim_direction == 0))
     {
-        nb_animation_steps = 1;
+        cust_char_t* string_to_display;
+        
+        /* Try to fetch the string to display */
+        custom_fs_get_string_from_file(stringID, &string_to_display, TRUE);
+        
+        /* Clear frame buffer */
+        #ifdef OLED_INTERNAL_FRAME_BUFFER
+        sh1122_clear_frame_buffer(&plat_oled_descriptor);
+        #else
+        sh1122_clear_current_screen(&plat_oled_descriptor);
+        #endif
+        
+        /* Write prompt text, centered on the left part */
+        sh1122_allow_line_feed(&plat_oled_descriptor);
+        sh1122_refresh_used_font(&plat_oled_descriptor, 1);
+        sh1122_set_max_text_x(&plat_oled_descriptor, PIN_PROMPT_MAX_TEXT_X);
+        sh1122_put_centered_string(&plat_oled_descriptor, PIN_PROMPT_TEXT_Y, string_to_display, TRUE);
+        sh1122_prevent_line_feed(&plat_oled_descriptor);
+        sh1122_reset_max_text_x(&plat_oled_descriptor);
+        
+        /* Display the 4 digits, arrows will pop up later */
+        sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MONO_BOLD_30_ID);
+        for (uint16_t i = 0; i < 4; i++)
+        {
+            gui_prompts_render_pin_digit_column(i, current_char, next_char, (i == selected_digit), FALSE, 0, 0);
+        }
+        
+        /* Flush complete screen */
+        #ifdef OLED_INTERNAL_FRAME_BUFFER
+        sh1122_flush_frame_buffer(&plat_oled_descriptor);
+        #endif
+        
+        /* Arrows appearing */
+        for (uint16_t i = 0; i < PIN_PROMPT_POPUP_ANIM_LGTH; i++)
+        {
+            timer_start_timer(TIMER_ANIMATIONS, PIN_PROMPT_ARROW_POP_FRAME_MS);
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*selected_digit, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_POP_ID+i, FALSE);
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*selected_digit, PIN_PROMPT_DN_ARROW_Y, BITMAP_PIN_DN_ARROW_POP_ID+i, FALSE);
+            gui_prompts_wait_for_animation_frame_end();
+        }
+        return;
     }
     
-    /* Clear frame buffer */
+    /* From here on, the prompt text and the unchanged digits are kept in the frame buffer */
     #ifdef OLED_INTERNAL_FRAME_BUFFER
-    sh1122_clear_frame_buffer(&plat_oled_descriptor);
-    #else
-    sh1122_clear_current_screen(&plat_oled_descriptor);
+    sh1122_check_for_flush_and_terminate(&plat_oled_descriptor);
     #endif
     
-    /* Write prompt text, centered on the left part */
-    sh1122_allow_line_feed(&plat_oled_descriptor);
-    sh1122_refresh_used_font(&plat_oled_descriptor, 1);
-    sh1122_set_max_text_x(&plat_oled_descriptor, PIN_PROMPT_MAX_TEXT_X);
-    sh1122_put_centered_string(&plat_oled_descriptor, PIN_PROMPT_TEXT_Y, string_to_display, TRUE);
-    sh1122_prevent_line_feed(&plat_oled_descriptor);
-    sh1122_reset_max_text_x(&plat_oled_descriptor);
-    
     /* Horizontal animation when changing selected digit */
     if (hor_anim_direction != 0)
     {
+        uint16_t previous_digit = selected_digit - hor_anim_direction;
+        uint16_t first_column = (previous_digit < selected_digit)? previous_digit : selected_digit;
+        
         for (uint16_t i = 0; i < PIN_PROMPT_ARROW_MOV_LGTH; i++)
         {
+            timer_start_timer(TIMER_ANIMATIONS, PIN_PROMPT_ARROW_MOV_FRAME_MS);
             sh1122_draw_rectangle(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT, 0x00, TRUE);
-            sh1122_draw_rectangle(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT, 0x00, TRUE);
-            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*(selected_digit-hor_anim_direction) + PIN_PROMPT_ARROW_HOR_ANIM_STEP*i*hor_anim_direction, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_MOVE_ID+i, TRUE);
-            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*(selected_digit-hor_anim_direction) + PIN_PROMPT_ARROW_HOR_ANIM_STEP*i*hor_anim_direction, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, BITMAP_PIN_DN_ARROW_MOVE_ID+i, TRUE);
+            sh1122_draw_rectangle(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_DN_ARROW_Y, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT, 0x00, TRUE);
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*previous_digit + PIN_PROMPT_ARROW_HOR_ANIM_STEP*i*hor_anim_direction, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_MOVE_ID+i, TRUE);
+            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*previous_digit + PIN_PROMPT_ARROW_HOR_ANIM_STEP*i*hor_anim_direction, PIN_PROMPT_DN_ARROW_Y, BITMAP_PIN_DN_ARROW_MOVE_ID+i, TRUE);
             #ifdef OLED_INTERNAL_FRAME_BUFFER
             sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT);
-            sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT);
+            sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_DN_ARROW_Y, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_ARROW_HEIGHT);
             #endif
-            timer_delay_ms(20);            
-        }
-    }
-    
-    /* Prepare for digits display */
-    sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MONO_BOLD_30_ID);
-    sh1122_allow_partial_text_y_draw(&plat_oled_descriptor);
-    
-    /* Animation code */
-    for (int16_t anim_step = 0; anim_step < nb_animation_steps; anim_step+=2)
-    {        
-        /* Why erase a small box when you can erase the screen? */
-        #ifdef OLED_INTERNAL_FRAME_BUFFER
-        if (anim_step != 0)
-        {
-            sh1122_clear_frame_buffer(&plat_oled_descriptor);
+            gui_prompts_wait_for_animation_frame_end();
         }
-        #endif
         
-        /* Display the 4 digits */
-        for (uint16_t i = 0; i < 4; i++)
-        {
-            if (i != selected_digit)
-            {
-                /* Display '*' */
-                sh1122_set_xy(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_ASTX_Y_INC);
-                sh1122_put_char(&plat_oled_descriptor, u'*', TRUE);
-            }
-            else
-            {
-                /* Arrows potential animations for scrolling digits */
-                if ((hor_anim_direction != 0) || (vert_anim_direction != 0))
-                {
-                    if (vert_anim_direction > 0)
-                    {
-                        sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_ACTIVATE_ID+(anim_step-1)/2, TRUE);                        
-                    }
-                    else
-                    {
-                        sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_POP_ID+PIN_PROMPT_POPUP_ANIM_LGTH-1, TRUE);                        
-                    }                    
-                    if (vert_anim_direction < 0)
-                    {
-                        sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, BITMAP_PIN_DN_ARROW_ACTIVATE_ID+(anim_step-1)/2, TRUE);
-                    }
-                    else
-                    {
-                        sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, BITMAP_PIN_DN_ARROW_POP_ID+PIN_PROMPT_POPUP_ANIM_LGTH-1, TRUE);
-                    }
-                }
-                
-                /* Digits display with animation */
-                sh1122_set_min_display_y(&plat_oled_descriptor, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING);
-                sh1122_set_max_display_y(&plat_oled_descriptor, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT);
-                sh1122_set_xy(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING + anim_step*vert_anim_direction);
-                sh1122_put_char(&plat_oled_descriptor, current_char, TRUE);
-                sh1122_set_xy(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*i + PIN_PROMPT_DIGIT_X_ADJ, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING + anim_step*vert_anim_direction + (PIN_PROMPT_DIGIT_HEIGHT+1)*vert_anim_direction*-1);
-                sh1122_put_char(&plat_oled_descriptor, next_char, TRUE);
-                sh1122_reset_lim_display_y(&plat_oled_descriptor);
-            }
-        }
-        
-        /* Flush updated part */
+        /* Only the previously selected digit and the newly selected one change */
+        sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MONO_BOLD_30_ID);
+        gui_prompts_render_pin_digit_column(previous_digit, current_char, next_char, FALSE, TRUE, 0, 0);
+        gui_prompts_render_pin_digit_column(selected_digit, current_char, next_char, TRUE, TRUE, 0, 0);
         #ifdef OLED_INTERNAL_FRAME_BUFFER
-        if (anim_step == 0)
-        {
-            sh1122_flush_frame_buffer(&plat_oled_descriptor);
-        } 
-        else
-        {
-            sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y, SH1122_OLED_WIDTH-PIN_PROMPT_DIGIT_X_OFFS, 2*PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT);
-        }
+        sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*first_column, PIN_PROMPT_UP_ARROW_Y, 2*PIN_PROMPT_DIGIT_X_SPC, PIN_PROMPT_COLUMN_HEIGHT);
         #endif
+        return;
     }
-        
-    /* Reset temporary graphics settings */
-    sh1122_prevent_partial_text_y_draw(&plat_oled_descriptor);
     
-    /* Special case: first display of pin entering screen, arrows appearing */
-    if ((hor_anim_direction == 0) && (vert_anim_direction == 0))
+    /* Vertical animation: digit roll, only the selected column is regenerated and flushed */
+    sh1122_refresh_used_font(&plat_oled_descriptor, FONT_UBUNTU_MONO_BOLD_30_ID);
+    for (int16_t anim_step = 0; anim_step < PIN_PROMPT_DIGIT_HEIGHT + 2; anim_step+=2)
     {
-        for (uint16_t i = 0; i < PIN_PROMPT_POPUP_ANIM_LGTH; i++)
-        {
-            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y, BITMAP_PIN_UP_ARROW_POP_ID+i, FALSE);
-            sh1122_display_bitmap_from_flash(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS, PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT, BITMAP_PIN_DN_ARROW_POP_ID+i, FALSE);
-            timer_delay_ms(30);
-        }
-    }    
+        timer_start_timer(TIMER_ANIMATIONS, PIN_PROMPT_DIGIT_ROLL_FRAME_MS);
+        gui_prompts_render_pin_digit_column(selected_digit, current_char, next_char, TRUE, TRUE, anim_step, vert_anim_direction);
+        #ifdef OLED_INTERNAL_FRAME_BUFFER
+        sh1122_flush_frame_buffer_window(&plat_oled_descriptor, PIN_PROMPT_DIGIT_X_OFFS + PIN_PROMPT_DIGIT_X_SPC*selected_digit, PIN_PROMPT_UP_ARROW_Y, PIN_PROMPT_DIGIT_X_SPC, PIN_PROMPT_COLUMN_HEIGHT);
+        #endif
+        gui_prompts_wait_for_animation_frame_end();
+    }
 }
 
 
@@ -316,6 +598,7 @@ RET_TYPE gui_prompts_get_user_pin(volatile uint16_t* pin_code, uint16_t stringID
     }
     else
     {
+        // Cleared on failure: starts at 0000
         rng_fill_array(current_pin, sizeof(current_pin));
         for (uint16_t i = 0; i < sizeof(current_pin); i++)
         {
@@ -429,13 +712,25 @@ RET_TYPE gui_prompts_get_user_pin(volatile uint16_t* pin_code, uint16_t stringID
 mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_confirmation(uint16_t string_id, BOOL flash_screen)
 {
     cust_char_t* string_to_display;
-    BOOL approve_selected = TRUE;
-    BOOL flash_flag = FALSE;
-    uint16_t flash_sm = 0;
     
     /* Try to fetch the string to display */
     custom_fs_get_string_from_file(string_id, &string_to_display, TRUE);
     
+    return gui_prompts_ask_for_one_line_string_confirmation(string_to_display, flash_screen);
+}
+
+/*! \fn     gui_prompts_ask_for_one_line_string_confirmation(cust_char_t* string_to_display, BOOL flash_screen)
+*   \brief  Ask for user confirmation with a string built at run time, for example one including numbers
+*   \param  string_to_display   String to display
+*   \param  flash_screen        Boolean to flash screen
+*   \return See enum
+*/
+mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_string_confirmation(cust_char_t* string_to_display, BOOL flash_screen)
+{
+    BOOL approve_selected = TRUE;
+    BOOL flash_flag = FALSE;
+    uint16_t flash_sm = 0;
+    
     /* Check the user hasn't disabled the flash screen feature */
     if ((flash_screen != FALSE) && ((BOOL)custom_fs_settings_get_device_setting(SETTING_FLASH_SCREEN_ID) != FALSE))
     {
@@ -477,8 +772,9 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_confirmation(uint16_t stri
     /* Activity detected */
     logic_device_activity_detected();
     
-    /* Clear possible remaining detection */
+    /* Clear possible remaining detection & cancel request */
     inputs_clear_detections();
+    comms_hid_msgs_cancel_request_received();
 
     /* Arm timer for flashing */
     timer_start_timer(TIMER_ANIMATIONS, 1000);
@@ -500,10 +796,10 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_confirmation(uint16_t stri
         
         // Read usb comms as the plugin could ask to cancel the request
         comms_aux_mcu_routine(MSG_RESTRICT_ALLBUT_CANCEL);
-        /*if (usbCancelRequestReceived() == RETURN_OK)
+        if (comms_hid_msgs_cancel_request_received() == RETURN_OK)
         {
             input_answer = MINI_INPUT_RET_TIMEOUT;
-        }*/
+        }
         
         // Check if something has been pressed
         detect_result = inputs_get_wheel_action(FALSE, TRUE);
@@ -616,8 +912,7 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
     }
 
     // Variables for scrolling
-    BOOL string_scrolling[4];
-    uint16_t string_lengths[4];
+    text_layout_t line_layouts[4];
     int16_t string_offset_cntrs[4] = {0,0,0,0};
     BOOL string_scrolling_left[4] = {TRUE, TRUE, TRUE, TRUE};
         
@@ -635,27 +930,13 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
     /* Set text display preferences */
     sh1122_set_max_text_x(&plat_oled_descriptor, CONF_PROMPT_MAX_TEXT_X);   
     
-    /* Compute lines lengths, display them, set scrolling bools */
+    /* Lay out lines once: widths, centering & scrolling needs, then display them */
+    memset((void*)line_layouts, 0, sizeof(line_layouts));
+    sh1122_allow_partial_text_x_draw(&plat_oled_descriptor);
     for (uint16_t i = 0; i < nb_args; i++)
     {
-        /* Set correct font */
-        sh1122_refresh_used_font(&plat_oled_descriptor, gui_prompts_conf_prompt_fonts[nb_args-1][i]);
-            
-        /* Is scrolling needed for that string? */
-        string_lengths[i] = utils_strlen(text_object->lines[i]);
-        sh1122_prevent_partial_text_x_draw(&plat_oled_descriptor);
-        if (string_lengths[i] != sh1122_put_centered_string(&plat_oled_descriptor, gui_prompts_conf_prompt_y_positions[nb_args-1][i], text_object->lines[i], TRUE))
-        {
-            string_scrolling[i] = TRUE;
-        }
-        else
-        {
-            string_scrolling[i] = FALSE;
-        }
-            
-        /* Now allow partial X text display and display partial text if there's any */
-        sh1122_allow_partial_text_x_draw(&plat_oled_descriptor);
-        sh1122_put_centered_string(&plat_oled_descriptor, gui_prompts_conf_prompt_y_positions[nb_args-1][i], text_object->lines[i], TRUE);
+        gui_prompts_update_text_layout(&line_layouts[i], text_object->lines[i], TEXT_LAYOUT_NO_STRING_ID, gui_prompts_conf_prompt_fonts[nb_args-1][i], TEXT_LAYOUT_NO_LINE_BREAK);
+        gui_prompts_render_text_layout(&line_layouts[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i]);
     }
     
     /* Flush to display */
@@ -669,7 +950,7 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
         sh1122_display_bitmap_from_flash_at_recommended_position(&plat_oled_descriptor, BITMAP_POPUP_3LINES_ID+j, TRUE);
         for (uint16_t i = 0; i < nb_args; i++)
         {            
-            sh1122_put_centered_string(&plat_oled_descriptor, gui_prompts_conf_prompt_y_positions[nb_args-1][i], text_object->lines[i], TRUE);
+            gui_prompts_render_text_layout(&line_layouts[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i]);
         }
         #ifdef OLED_INTERNAL_FRAME_BUFFER
         sh1122_flush_frame_buffer(&plat_oled_descriptor);
@@ -684,8 +965,9 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
     /* Activity detected */
     logic_device_activity_detected();
     
-    /* Clear possible remaining detection */
+    /* Clear possible remaining detection & cancel request */
     inputs_clear_detections();
+    comms_hid_msgs_cancel_request_received();
     
     /* Arm timer for scrolling */
     timer_start_timer(TIMER_SCROLLING, SCROLLING_DEL);
@@ -710,10 +992,10 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
         
         // Read usb comms as the plugin could ask to cancel the request
         comms_aux_mcu_routine(MSG_RESTRICT_ALLBUT_CANCEL);
-        /*if (usbCancelRequestReceived() == RETURN_OK)
+        if (comms_hid_msgs_cancel_request_received() == RETURN_OK)
         {
             input_answer = MINI_INPUT_RET_TIMEOUT;
-        }*/
+        }
         
         // Check if something has been pressed
         detect_result = inputs_get_wheel_action(FALSE, TRUE);
@@ -803,19 +1085,18 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
             /* Display all strings */
             for (uint16_t i = 0; i < nb_args; i++)
             {
-                if (string_scrolling[i] != FALSE)
+                /* Relayout only on language or font change */
+                gui_prompts_update_text_layout(&line_layouts[i], text_object->lines[i], TEXT_LAYOUT_NO_STRING_ID, gui_prompts_conf_prompt_fonts[nb_args-1][i], TEXT_LAYOUT_NO_LINE_BREAK);
+                
+                if (line_layouts[i].overflows != FALSE)
                 {
                     /* Erase previous part */
                     #ifndef OLED_INTERNAL_FRAME_BUFFER
                     sh1122_draw_rectangle(&plat_oled_descriptor, 0, gui_prompts_conf_prompt_y_positions[nb_args-1][i], CONF_PROMPT_MAX_TEXT_X, gui_prompts_conf_prompt_line_heights[nb_args-1][i], 0x00, TRUE);
                     #endif
                     
-                    /* Set correct font */
-                    sh1122_refresh_used_font(&plat_oled_descriptor, gui_prompts_conf_prompt_fonts[nb_args-1][i]);
-                    
-                    /* Check if scrolling is not needed anymore */
-                    sh1122_prevent_partial_text_x_draw(&plat_oled_descriptor);
-                    if (sh1122_put_string_xy(&plat_oled_descriptor, string_offset_cntrs[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i], OLED_ALIGN_LEFT, text_object->lines[i], TRUE) == string_lengths[i])
+                    /* Check if scrolling is not needed anymore: end of the string is displayed */
+                    if ((string_offset_cntrs[i] + line_layouts[i].string_width) <= line_layouts[i].max_text_x)
                     {
                         string_scrolling_left[i] = FALSE;
                     } 
@@ -824,9 +1105,8 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
                         string_scrolling_left[i] = TRUE;
                     }
                     
-                    /* Now allow partial X text display and display partial text if there's any */
-                    sh1122_allow_partial_text_x_draw(&plat_oled_descriptor);
-                    sh1122_put_string_xy(&plat_oled_descriptor, string_offset_cntrs[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i], OLED_ALIGN_LEFT, text_object->lines[i], TRUE);
+                    /* Display text, including partial glyphs */
+                    gui_prompts_render_scrolled_text_layout(&line_layouts[i], string_offset_cntrs[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i]);
                     
                     /* Increment or decrement X offset */
                     if (string_scrolling_left[i] == FALSE)
@@ -840,7 +1120,7 @@ mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, conf
                 }
                 else
                 {
-                    sh1122_put_centered_string(&plat_oled_descriptor, gui_prompts_conf_prompt_y_positions[nb_args-1][i], text_object->lines[i], TRUE);                    
+                    gui_prompts_render_text_layout(&line_layouts[i], gui_prompts_conf_prompt_y_positions[nb_args-1][i]);
                 }
             }
             
@@ -8,6 +8,7 @@
 #ifndef GUI_PROMPTS_H_
 #define GUI_PROMPTS_H_
 
+#include "custom_fs.h"
 #include "defines.h"
 
 /* Defines */
@@ -54,6 +55,12 @@
 #define BITMAP_PIN_DN_ARROW_MOVE_ID     635
 #define BITMAP_PIN_UP_ARROW_ACTIVATE_ID 642
 #define BITMAP_PIN_DN_ARROW_ACTIVATE_ID 652
+#define PIN_PROMPT_DIGIT_Y              (PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+PIN_PROMPT_DIGIT_Y_SPACING)
+#define PIN_PROMPT_DN_ARROW_Y           (PIN_PROMPT_UP_ARROW_Y+PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT)
+#define PIN_PROMPT_COLUMN_HEIGHT        (2*PIN_PROMPT_ARROW_HEIGHT+2*PIN_PROMPT_DIGIT_Y_SPACING+PIN_PROMPT_DIGIT_HEIGHT)
+#define PIN_PROMPT_ARROW_MOV_FRAME_MS   20
+#define PIN_PROMPT_ARROW_POP_FRAME_MS   30
+#define PIN_PROMPT_DIGIT_ROLL_FRAME_MS  3
 
 // Confirmation prompt
 #define ONE_LINE_TEXT_FIRST_POS         5
@@ -73,6 +80,7 @@
 
 // Information display
 #define INF_DISPLAY_TEXT_Y              24
+#define INF_DISPLAY_MAX_NB_LINES        2
 #define INFO_NOTIF_ANIM_LGTH            12
 #define ACTION_NOTIF_ANIM_LGTH          11
 #define WARNING_NOTIF_ANIM_LGTH         14
@@ -89,16 +97,50 @@
 // Delay when scrolling a text
 #define SCROLLING_DEL                   33
 
+// No string ID for a text layout
+#define TEXT_LAYOUT_NO_STRING_ID        UINT32_MAX
+// Max number of lines a text layout breaks a string into
+#define TEXT_LAYOUT_MAX_NB_LINES        2
+// Single line layout, overflowing strings are left to the caller to scroll
+#define TEXT_LAYOUT_NO_LINE_BREAK       0
+// Appended to truncated layouts
+#define TEXT_LAYOUT_ELLIPSIS_CHAR       '.'
+#define TEXT_LAYOUT_ELLIPSIS_LENGTH     3
+
 /* Structs */
 typedef struct
 {
     cust_char_t* lines[4];
 } confirmationText_t;
 
+// Text layout, computed once per (string, string file, font, text box) and reused across redraws
+typedef struct
+{
+    const cust_char_t* string;          // Laid out string
+    uint32_t string_id;                 // Bundle string ID, TEXT_LAYOUT_NO_STRING_ID if not fetched from the bundle
+    custom_fs_address_t text_file_address;  // Current language string file address at layout time: bundle strings share one buffer
+    custom_fs_address_t font_address;   // Font file address at layout time, changes with language or bundle
+    uint16_t font_id;                   // Font ID
+    int16_t min_text_x;                 // Text box left limit
+    int16_t max_text_x;                 // Text box right limit
+    uint16_t max_nb_lines;              // Max number of lines, TEXT_LAYOUT_NO_LINE_BREAK for a single scrolled line
+    uint16_t string_length;             // Number of characters
+    uint16_t string_width;              // Width in pixels, of the widest line when broken into lines
+    int16_t centered_x;                 // X to display the string centered in the text box
+    BOOL overflows;                     // String doesn't fit in the text box (in max_nb_lines when broken into lines)
+    uint16_t nb_lines;                  // Number of lines the string is broken into
+    uint16_t line_start[TEXT_LAYOUT_MAX_NB_LINES];  // Index of each line first character
+    uint16_t line_length[TEXT_LAYOUT_MAX_NB_LINES]; // Number of characters of each line
+    int16_t line_x[TEXT_LAYOUT_MAX_NB_LINES];       // X to display each line centered in the text box
+    uint16_t line_height;               // Font height, lines spacing
+    BOOL truncated;                     // String didn't fit in max_nb_lines: last line ends with an ellipsis
+} text_layout_t;
+
 /* Prototypes */
 void gui_prompts_render_pin_enter_screen(uint8_t* current_pin, uint16_t selected_digit, uint16_t stringID, int16_t vert_anim_direction, int16_t hor_anim_direction);
 mini_input_yes_no_ret_te gui_prompts_ask_for_confirmation(uint16_t nb_args, confirmationText_t* text_object, BOOL flash_screen);
 void gui_prompts_display_information_on_screen_and_wait(uint16_t string_id, display_message_te message_type);
+mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_string_confirmation(cust_char_t* string_to_display, BOOL flash_screen);
 mini_input_yes_no_ret_te gui_prompts_ask_for_one_line_confirmation(uint16_t string_id, BOOL flash_screen);
 void gui_prompts_display_information_on_screen(uint16_t string_id, display_message_te message_type);
 RET_TYPE gui_prompts_get_user_pin(volatile uint16_t* pin_code, uint16_t stringID);
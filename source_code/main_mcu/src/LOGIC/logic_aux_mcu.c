@@ -14,6 +14,8 @@
 #include "dma.h"
 /* BLE enabled bool */
 BOOL logic_aux_mcu_ble_enabled = FALSE;
+/* ATBTLC1000 chip ID, received from aux MCU */
+uint32_t logic_aux_mcu_ble_chip_id = 0;
 
 
 /*! \fn     logic_aux_mcu_set_ble_enabled_bool(BOOL ble_enabled)
@@ -37,30 +39,47 @@ BOOL logic_aux_mcu_is_ble_enabled(void)
 /*! \fn     logic_aux_mcu_enable_ble(BOOL wait_for_enabled)
 *   \brief  Enable bluetooth
 *   \param  wait_for_enabled    Set to true to wait for BLE enabled
+*   \return RETURN_NOK if BLE wasn't enabled within BLE_ENABLE_TIMEOUT_MS
 */
-void logic_aux_mcu_enable_ble(BOOL wait_for_enabled)
+RET_TYPE logic_aux_mcu_enable_ble(BOOL wait_for_enabled)
 {
     if (logic_aux_mcu_ble_enabled == FALSE)
     {
-        aux_mcu_message_t* temp_rx_message;
-        
-        /* Enable BLE */
+        /* Enable BLE: the AUX_MCU_EVENT_BLE_ENABLED event sets our boolean in comms_aux_mcu_routine() */
         platform_io_enable_ble();
         comms_aux_mcu_send_simple_command_message(MAIN_MCU_COMMAND_ENABLE_BLE);
         
         if (wait_for_enabled != FALSE)
         {
-            /* wait for BLE to bootup */
-            comms_aux_mcu_wait_for_message_sent();
-            while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_AUX_MCU_EVENT) == RETURN_NOK){}
-            
-            /* Rearm DMA RX */
-            comms_aux_arm_rx_and_clear_no_comms();
+            /* wait for BLE to bootup, other aux MCU messages are still dealt with */
+            timer_start_timer(TIMER_WAIT_FUNCTS, BLE_ENABLE_TIMEOUT_MS);
+            while ((logic_aux_mcu_ble_enabled == FALSE) && (timer_has_timer_expired(TIMER_WAIT_FUNCTS, TRUE) == TIMER_RUNNING))
+            {
+                comms_aux_mcu_routine(MSG_RESTRICT_ALL);
+            }
             
-            /* Set boolean */
-            logic_aux_mcu_ble_enabled = TRUE;
+            if (logic_aux_mcu_ble_enabled == FALSE)
+            {
+                return RETURN_NOK;
+            }
         }
     }
+    return RETURN_OK;
+}
+
+/*! \fn     logic_aux_mcu_ble_chip_id_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+*   \brief  Store ATBTLC1000 chip ID from the aux MCU platform details
+*   \param  reply_pt                Platform details, 0 if they didn't arrive in time
+*   \param  hid_reply_message_type  Unused
+*/
+static void logic_aux_mcu_ble_chip_id_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+{
+    (void)hid_reply_message_type;
+    
+    if (reply_pt != 0)
+    {
+        logic_aux_mcu_ble_chip_id = reply_pt->aux_details_message.atbtlc_chip_id;
+    }
 }
 
 /*! \fn     comms_aux_mcu_get_ble_chip_id(void)
@@ -76,26 +95,16 @@ uint32_t logic_aux_mcu_get_ble_chip_id(void)
     }
     else
     {
-        aux_mcu_message_t* temp_rx_message;
         aux_mcu_message_t* temp_tx_message;
-        uint32_t return_val;
         
         /* Get an empty packet ready to be sent */
         comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
         
-        /* Send message */
-        comms_aux_mcu_send_message(TRUE);
-        
-        /* Wait for message from aux MCU */
-        while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
-        
-        /* Output debug info */
-        return_val = temp_rx_message->aux_details_message.atbtlc_chip_id;
-
-        /* Info gotten, rearm DMA RX */
-        comms_aux_arm_rx_and_clear_no_comms();
+        /* Send message, wait for the callback to store the chip ID */
+        logic_aux_mcu_ble_chip_id = 0;
+        comms_aux_mcu_wait_for_transaction(comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_PLAT_DETAILS, AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS, 0, logic_aux_mcu_ble_chip_id_callback), MSG_RESTRICT_ALL);
         
-        return return_val;
+        return logic_aux_mcu_ble_chip_id;
     }
 }
 
@@ -131,7 +140,7 @@ RET_TYPE logic_aux_mcu_flash_firmware_update(void)
     comms_aux_mcu_send_message(TRUE);
     
     /* Wait for message from aux MCU */
-    while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_BOOTLOADER) == RETURN_NOK){}
+    while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_BOOTLOADER) == RETURN_NOK){}
     
     /* Answer checked, rearm RX */    
     comms_aux_arm_rx_and_clear_no_comms();
@@ -173,7 +182,7 @@ RET_TYPE logic_aux_mcu_flash_firmware_update(void)
         comms_aux_mcu_send_message(TRUE);
         
         /* Wait for message from aux MCU */
-        while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_BOOTLOADER) == RETURN_NOK){}
+        while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_BOOTLOADER) == RETURN_NOK){}
         
         /* Answer checked, rearm RX */
         comms_aux_arm_rx_and_clear_no_comms();
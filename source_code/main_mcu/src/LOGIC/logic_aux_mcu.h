@@ -11,7 +11,7 @@
 
 /* Prototypes */
 void logic_aux_mcu_set_ble_enabled_bool(BOOL ble_enabled);
-void logic_aux_mcu_enable_ble(BOOL wait_for_enabled);
+RET_TYPE logic_aux_mcu_enable_ble(BOOL wait_for_enabled);
 RET_TYPE logic_aux_mcu_flash_firmware_update(void);
 uint32_t logic_aux_mcu_get_ble_chip_id(void);
 BOOL logic_aux_mcu_is_ble_enabled(void);
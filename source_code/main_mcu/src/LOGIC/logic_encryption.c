@@ -0,0 +1,132 @@
+/*!  \file     logic_encryption.c
+*    \brief    Credential encryption: AES-256 CTR with the card key, the user nonce & the profile CTR
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "logic_encryption.h"
+#include "aes256_ctr.h"
+#include "nodemgmt.h"
+#include "defines.h"
+// CTR context: card AES key & user nonce
+aes256_ctr_context_t logic_encryption_ctr_context;
+// Next CTR value to use
+uint32_t logic_encryption_next_ctr;
+// CTR value stored in the user profile: values below it may have been used
+uint32_t logic_encryption_reserved_ctr;
+// Set when the encryption context is initialized
+BOOL logic_encryption_context_valid = FALSE;
+
+
+/*! \fn     logic_encryption_ctr_to_u32(uint8_t* ctr)
+*   \brief  Convert a stored CTR, MSB first
+*   \param  ctr     The 3 bytes CTR
+*   \return The CTR value
+*/
+static inline uint32_t logic_encryption_ctr_to_u32(uint8_t* ctr)
+{
+    return ((uint32_t)ctr[0] << 16) | ((uint32_t)ctr[1] << 8) | (uint32_t)ctr[2];
+}
+
+/*! \fn     logic_encryption_u32_to_ctr(uint32_t ctr_val, uint8_t* ctr)
+*   \brief  Convert a CTR value to its stored format, MSB first
+*   \param  ctr_val The CTR value
+*   \param  ctr     Where to store the 3 bytes CTR
+*/
+static inline void logic_encryption_u32_to_ctr(uint32_t ctr_val, uint8_t* ctr)
+{
+    ctr[0] = (uint8_t)(ctr_val >> 16);
+    ctr[1] = (uint8_t)(ctr_val >> 8);
+    ctr[2] = (uint8_t)ctr_val;
+}
+
+/*! \fn     logic_encryption_init_context(uint8_t* card_aes_key, cpz_lut_entry_t* cpz_user_entry)
+*   \brief  Initialize the encryption context once the user is logged in
+*   \param  card_aes_key    The AES key read from the card
+*   \param  cpz_user_entry  The user CPZ LUT entry, holding the nonce
+*   \note   The node management context must be initialized: the CTR is read from the user profile
+*/
+void logic_encryption_init_context(uint8_t* card_aes_key, cpz_lut_entry_t* cpz_user_entry)
+{
+    uint8_t profile_ctr[MEMBER_SIZE(nodemgmt_profile_main_data_t, current_ctr)];
+    
+    aes256_ctr_init_context(&logic_encryption_ctr_context, card_aes_key, cpz_user_entry->nonce);
+    nodemgmt_read_profile_ctr((void*)profile_ctr);
+    logic_encryption_next_ctr = logic_encryption_ctr_to_u32(profile_ctr);
+    logic_encryption_reserved_ctr = logic_encryption_next_ctr;
+    logic_encryption_context_valid = TRUE;
+}
+
+/*! \fn     logic_encryption_delete_context(void)
+*   \brief  Clear the encryption context, on card removal
+*/
+void logic_encryption_delete_context(void)
+{
+    aes256_ctr_clear_context(&logic_encryption_ctr_context);
+    logic_encryption_context_valid = FALSE;
+    logic_encryption_reserved_ctr = 0;
+    logic_encryption_next_ctr = 0;
+}
+
+/*! \fn     logic_encryption_is_context_valid(void)
+*   \brief  Know if the encryption context is initialized
+*   \return TRUE once a user is logged in, FALSE after card removal
+*/
+BOOL logic_encryption_is_context_valid(void)
+{
+    return logic_encryption_context_valid;
+}
+
+/*! \fn     logic_encryption_ctr_encrypt(uint8_t* data, uint16_t length, uint8_t* ctr)
+*   \brief  Encrypt data in place with the next CTR values
+*   \param  data    Data to encrypt
+*   \param  length  Number of bytes
+*   \param  ctr     Where to store the 3 bytes CTR used, to be stored along the data
+*   \return RETURN_NOK if no user is logged in or if the CTR values are exhausted
+*   \note   CTR values are reserved in the user profile by chunks, values reserved before a reboot are never reused
+*/
+RET_TYPE logic_encryption_ctr_encrypt(uint8_t* data, uint16_t length, uint8_t* ctr)
+{
+    uint8_t profile_ctr[MEMBER_SIZE(nodemgmt_profile_main_data_t, current_ctr)];
+    uint32_t nb_blocks = (length + (AES_BLOCK_SIZE/8) - 1) / (AES_BLOCK_SIZE/8);
+    
+    if ((logic_encryption_context_valid == FALSE) || (logic_encryption_next_ctr + nb_blocks > LOGIC_ENCRYPTION_MAX_CTR_VAL))
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Reserve CTR values in the user profile before using them */
+    if (logic_encryption_next_ctr + nb_blocks > logic_encryption_reserved_ctr)
+    {
+        logic_encryption_reserved_ctr = logic_encryption_next_ctr + nb_blocks + LOGIC_ENCRYPTION_CTR_RESERVATION;
+        if (logic_encryption_reserved_ctr > LOGIC_ENCRYPTION_MAX_CTR_VAL)
+        {
+            logic_encryption_reserved_ctr = LOGIC_ENCRYPTION_MAX_CTR_VAL;
+        }
+        logic_encryption_u32_to_ctr(logic_encryption_reserved_ctr, profile_ctr);
+        nodemgmt_set_profile_ctr((void*)profile_ctr);
+    }
+    
+    logic_encryption_u32_to_ctr(logic_encryption_next_ctr, ctr);
+    aes256_ctr_crypt(&logic_encryption_ctr_context, logic_encryption_next_ctr, data, length);
+    logic_encryption_next_ctr += nb_blocks;
+    return RETURN_OK;
+}
+
+/*! \fn     logic_encryption_generate_keystream(uint8_t* ctr, uint8_t* keystream, uint16_t length)
+*   \brief  Generate the keystream of encrypted data from its CTR only, for example while the data is still being read from flash
+*   \param  ctr         The 3 bytes CTR stored along the data
+*   \param  keystream   Where to store the keystream, to be XORed with the data
+*   \param  length      Number of bytes
+*   \return RETURN_NOK if no user is logged in
+*/
+RET_TYPE logic_encryption_generate_keystream(uint8_t* ctr, uint8_t* keystream, uint16_t length)
+{
+    if (logic_encryption_context_valid == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    aes256_ctr_generate_keystream(&logic_encryption_ctr_context, logic_encryption_ctr_to_u32(ctr), keystream, length);
+    return RETURN_OK;
+}
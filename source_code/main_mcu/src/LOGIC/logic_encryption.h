@@ -0,0 +1,28 @@
+/*!  \file     logic_encryption.h
+*    \brief    Credential encryption: AES-256 CTR with the card key, the user nonce & the profile CTR
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef LOGIC_ENCRYPTION_H_
+#define LOGIC_ENCRYPTION_H_
+
+#include "custom_fs.h"
+#include "defines.h"
+
+/* Defines */
+// CTR values count AES blocks, stored on 24 bits
+#define LOGIC_ENCRYPTION_MAX_CTR_VAL            0x00FFFFFFUL
+// Number of CTR values reserved in the user profile with one write
+#define LOGIC_ENCRYPTION_CTR_RESERVATION        256
+
+/* Prototypes */
+RET_TYPE logic_encryption_generate_keystream(uint8_t* ctr, uint8_t* keystream, uint16_t length);
+void logic_encryption_init_context(uint8_t* card_aes_key, cpz_lut_entry_t* cpz_user_entry);
+RET_TYPE logic_encryption_ctr_encrypt(uint8_t* data, uint16_t length, uint8_t* ctr);
+void logic_encryption_delete_context(void);
+BOOL logic_encryption_is_context_valid(void);
+
+
+#endif /* LOGIC_ENCRYPTION_H_ */
@@ -0,0 +1,172 @@
+/*!  \file     logic_keyboard.c
+*    \brief    Keyboard layout logic: unicode char to HID key
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include "logic_keyboard.h"
+#include "comms_aux_mcu.h"
+#include "custom_fs.h"
+#include "defines.h"
+// Current layout interval descriptors, sorted by unicode point
+keyboard_layout_interval_desc_t logic_keyboard_intervals[LOGIC_KEYBOARD_MAX_NB_INTERVALS];
+// Number of intervals in the current layout
+uint16_t logic_keyboard_nb_intervals = 0;
+// Address of the current layout entries, 0 if no layout is loaded
+custom_fs_address_t logic_keyboard_entries_address = 0;
+// Typing status sent back by the aux MCU
+uint16_t logic_keyboard_typed_status = KEYBOARD_TYPE_STATUS_FAILED;
+
+
+/*! \fn     logic_keyboard_set_layout(uint16_t layout_id)
+*   \brief  Load a keyboard layout interval descriptors from the bundle
+*   \param  layout_id   Keyboard layout file ID
+*   \return RETURN_(N)OK
+*/
+RET_TYPE logic_keyboard_set_layout(uint16_t layout_id)
+{
+    keyboard_layout_header_t layout_header;
+    custom_fs_address_t layout_address;
+    
+    /* No layout until this one is loaded */
+    logic_keyboard_entries_address = 0;
+    logic_keyboard_nb_intervals = 0;
+    
+    /* Get file address */
+    if (custom_fs_get_file_address(layout_id, &layout_address, CUSTOM_FS_KEYBOARD_TYPE) == RETURN_NOK)
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Read header, check interval count */
+    custom_fs_read_from_flash((uint8_t*)&layout_header, layout_address, sizeof(layout_header));
+    if (layout_header.interval_count > LOGIC_KEYBOARD_MAX_NB_INTERVALS)
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Read interval descriptors */
+    custom_fs_read_from_flash((uint8_t*)logic_keyboard_intervals, layout_address + sizeof(layout_header), layout_header.interval_count*sizeof(logic_keyboard_intervals[0]));
+    logic_keyboard_entries_address = layout_address + sizeof(layout_header) + layout_header.interval_count*sizeof(logic_keyboard_intervals[0]);
+    logic_keyboard_nb_intervals = layout_header.interval_count;
+    return RETURN_OK;
+}
+
+/*! \fn     logic_keyboard_get_hid_key_for_char(cust_char_t unicode_char, uint8_t* modifier, uint8_t* keycode)
+*   \brief  Get the HID key to press to type a given char with the current layout
+*   \param  unicode_char    BMP unicode char
+*   \param  modifier        Where to store the HID modifier byte
+*   \param  keycode         Where to store the HID keycode
+*   \return RETURN_OK if the char can be typed
+*   \note   Binary search on the intervals stored in RAM (at most 6 compares for the 40 intervals of the largest CLDR 33.1 layout, 7 for the 64 intervals cap) then a single flash read
+*/
+RET_TYPE logic_keyboard_get_hid_key_for_char(cust_char_t unicode_char, uint8_t* modifier, uint8_t* keycode)
+{
+    keyboard_layout_entry_t layout_entry;
+    uint16_t high = logic_keyboard_nb_intervals;
+    uint16_t low = 0;
+    
+    /* Layout loaded? */
+    if (logic_keyboard_entries_address == 0)
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Find the interval containing our char */
+    while (low < high)
+    {
+        uint16_t middle = (low + high) / 2;
+        
+        if (unicode_char < logic_keyboard_intervals[middle].interval_start)
+        {
+            high = middle;
+        }
+        else if (unicode_char > logic_keyboard_intervals[middle].interval_end)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            /* Read layout entry: keycode 0 is a point without key in an interval */
+            custom_fs_read_from_flash((uint8_t*)&layout_entry, logic_keyboard_entries_address + (logic_keyboard_intervals[middle].first_entry + unicode_char - logic_keyboard_intervals[middle].interval_start)*sizeof(layout_entry), sizeof(layout_entry));
+            if (layout_entry.keycode == 0)
+            {
+                return RETURN_NOK;
+            }
+            *modifier = layout_entry.modifier;
+            *keycode = layout_entry.keycode;
+            return RETURN_OK;
+        }
+    }
+    
+    return RETURN_NOK;
+}
+
+/*! \fn     logic_keyboard_typed_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+*   \brief  Store the typing status sent back by the aux MCU
+*   \param  reply_pt                Aux MCU reply, 0 if it didn't arrive in time
+*   \param  hid_reply_message_type  Unused
+*/
+static void logic_keyboard_typed_callback(aux_mcu_message_t* reply_pt, uint16_t hid_reply_message_type)
+{
+    (void)hid_reply_message_type;
+    
+    if (reply_pt != 0)
+    {
+        logic_keyboard_typed_status = reply_pt->keyboard_type_message.typed_status;
+    }
+}
+
+/*! \fn     logic_keyboard_type_string(cust_char_t* string, uint16_t interface_id, uint16_t delay_between_reports)
+*   \brief  Type a string with the current keyboard layout
+*   \param  string                  0 terminated string
+*   \param  interface_id            KEYBOARD_TYPE_INTERFACE_xxx
+*   \param  delay_between_reports   Delay between two keyboard reports in ms, 0 for one report per USB frame
+*   \return RETURN_OK if the string was typed
+*   \note   Nothing is typed if one of the chars can't be typed with the current layout
+*/
+RET_TYPE logic_keyboard_type_string(cust_char_t* string, uint16_t interface_id, uint16_t delay_between_reports)
+{
+    aux_mcu_message_t* temp_tx_message_pt;
+    uint16_t nb_keys = 0;
+    
+    /* Check that all the chars can be typed */
+    for (cust_char_t* char_pt = string; *char_pt != 0; char_pt++)
+    {
+        uint8_t modifier, keycode;
+        if (logic_keyboard_get_hid_key_for_char(*char_pt, &modifier, &keycode) == RETURN_NOK)
+        {
+            return RETURN_NOK;
+        }
+    }
+    
+    /* Keys are sent in chunks of at most KEYBOARD_TYPE_MAX_NB_KEYS, the aux MCU answers once a chunk is typed */
+    while (*string != 0)
+    {
+        comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_KEYBOARD_TYPE, TX_REPLY_REQUEST_FLAG);
+        temp_tx_message_pt->keyboard_type_message.interface_identifier = interface_id;
+        temp_tx_message_pt->keyboard_type_message.delay_between_reports = delay_between_reports;
+        for (nb_keys = 0; (nb_keys < KEYBOARD_TYPE_MAX_NB_KEYS) && (*string != 0); nb_keys++, string++)
+        {
+            logic_keyboard_get_hid_key_for_char(*string, &temp_tx_message_pt->keyboard_type_message.keys[nb_keys].modifier, &temp_tx_message_pt->keyboard_type_message.keys[nb_keys].keycode);
+        }
+        temp_tx_message_pt->keyboard_type_message.nb_keys = nb_keys;
+        temp_tx_message_pt->payload_length1 = sizeof(keyboard_type_message_t) + nb_keys*sizeof(keyboard_key_t);
+        
+        /* Worst case: two reports per key, one per ms if no delay is set */
+        uint32_t timeout_ms = AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS + (2*(uint32_t)nb_keys + 1)*(delay_between_reports + 1);
+        if (timeout_ms > UINT16_MAX)
+        {
+            timeout_ms = UINT16_MAX;
+        }
+        
+        /* Send and wait for the callback to store the typing status */
+        logic_keyboard_typed_status = KEYBOARD_TYPE_STATUS_FAILED;
+        comms_aux_mcu_wait_for_transaction(comms_aux_mcu_send_transaction(AUX_MCU_MSG_TYPE_KEYBOARD_TYPE, (uint16_t)timeout_ms, 0, logic_keyboard_typed_callback), MSG_RESTRICT_ALL);
+        if (logic_keyboard_typed_status != KEYBOARD_TYPE_STATUS_TYPED)
+        {
+            return RETURN_NOK;
+        }
+    }
+    
+    return RETURN_OK;
+}
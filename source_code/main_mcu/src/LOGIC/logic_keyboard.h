@@ -0,0 +1,24 @@
+/*!  \file     logic_keyboard.h
+*    \brief    Keyboard layout logic: unicode char to HID key
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+
+
+#ifndef LOGIC_KEYBOARD_H_
+#define LOGIC_KEYBOARD_H_
+
+#include "custom_fs.h"
+#include "defines.h"
+
+/* Defines */
+// Max number of unicode intervals in a layout, must match LAYOUT_MAX_NB_INTERVALS in cldr_parser.py
+#define LOGIC_KEYBOARD_MAX_NB_INTERVALS     64
+
+/* Prototypes */
+RET_TYPE logic_keyboard_type_string(cust_char_t* string, uint16_t interface_id, uint16_t delay_between_reports);
+RET_TYPE logic_keyboard_get_hid_key_for_char(cust_char_t unicode_char, uint8_t* modifier, uint8_t* keycode);
+RET_TYPE logic_keyboard_set_layout(uint16_t layout_id);
+
+
+#endif /* LOGIC_KEYBOARD_H_ */
@@ -5,6 +5,8 @@
 */
 #include "logic_security.h"
 #include "defines.h"
+// Set once the inserted card is unlocked, cleared on card removal
+volatile BOOL logic_security_smartcard_inserted_unlocked = FALSE;
 
 
 /*! \fn     logic_security_clear_security_bools(void)
@@ -21,9 +23,9 @@ void logic_security_clear_security_bools(void)
     data_context_valid_flag = FALSE;
     current_adding_data_flag = FALSE;
     activateTimer(TIMER_CREDENTIALS, 0);
-    smartcard_inserted_unlocked = FALSE;
     currently_writing_first_block = FALSE;
     */
+    logic_security_smartcard_inserted_unlocked = FALSE;
 }
 
 /*! \fn     logic_security_smartcard_unlocked_actions(void)
@@ -31,11 +33,14 @@ void logic_security_clear_security_bools(void)
 */
 void logic_security_smartcard_unlocked_actions(void)
 {
-    // TODO        
-    /*
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-    {
-    smartcard_inserted_unlocked = TRUE;
-    }
-    */
+    logic_security_smartcard_inserted_unlocked = TRUE;
+}
+
+/*! \fn     logic_security_is_smc_inserted_unlocked(void)
+*   \brief  Know if a user is logged in: smartcard inserted & unlocked
+*   \return TRUE if the inserted card is unlocked
+*/
+BOOL logic_security_is_smc_inserted_unlocked(void)
+{
+    return logic_security_smartcard_inserted_unlocked;
 }
\ No newline at end of file
@@ -3,14 +3,17 @@
 *    Created:  16/02/2019
 *    Author:   Mathieu Stephan
 */
+#include <string.h>
 #include "smartcard_highlevel.h"
 #include "smartcard_lowlevel.h"
+#include "logic_encryption.h"
 #include "logic_smartcard.h"
 #include "gui_dispatcher.h"
 #include "logic_security.h"
 #include "gui_prompts.h"
 #include "platform_io.h"
 #include "logic_user.h"
+#include "nodemgmt.h"
 #include "defines.h"
 
 
@@ -49,18 +52,14 @@ RET_TYPE logic_smartcard_ask_for_new_pin(volatile uint16_t* new_pin, uint16_t me
 */
 void logic_smartcard_handle_removed(void)
 {
-    // TODO    
-    /*uint8_t temp_ctr_val[AES256_CTR_LENGTH];
-    uint8_t temp_buffer[AES_KEY_LENGTH/8];*/
-
-    /* Remove power and flags */
+    /* Remove power, flags and card image */
     platform_io_smc_remove_function();
+    smartcard_highlevel_invalidate_shadow();
     logic_security_clear_security_bools();
     
-    // Clear encryption context
-    /*memset((void*)temp_buffer, 0, AES_KEY_LENGTH/8);
-    memset((void*)temp_ctr_val, 0, AES256_CTR_LENGTH);
-    initEncryptionHandling(temp_buffer, temp_ctr_val);*/
+    // Clear user & encryption contexts
+    nodemgmt_delete_context();
+    logic_encryption_delete_context();
 }
 
 /*! \fn     logic_smartcard_handle_inserted(void)
@@ -208,7 +207,8 @@ valid_card_det_return_te logic_smartcard_valid_card_unlock(BOOL hash_allow_flag)
 
             /* Init user flash context and encryption handling, set smartcard unlocked flag */             
             logic_user_init_context(cpz_user_entry->user_id);
-            //initEncryptionHandling(temp_buffer, temp_ctr_val);
+            logic_encryption_init_context(temp_buffer, cpz_user_entry);
+            memset((void*)temp_buffer, 0, sizeof(temp_buffer));
             logic_security_smartcard_unlocked_actions();
             return RETURN_VCARD_OK;
         }
@@ -5,13 +5,21 @@
 */
 #include <string.h>
 #include "smartcard_highlevel.h"
+#include "logic_encryption.h"
+#include "logic_security.h"
+#include "comms_aux_mcu.h"
+#include "gui_prompts.h"
 #include "logic_user.h"
 #include "custom_fs.h"
 #include "nodemgmt.h"
 #include "defines.h"
+#include "utils.h"
 #include "rng.h"
-// Next CTR value for our AES encryption
-uint8_t logic_user_next_ctr_val[MEMBER_SIZE(nodemgmt_profile_main_data_t,current_ctr)];
+// Credential batch being received
+uint8_t logic_user_cred_batch_buffer[LOGIC_USER_CRED_BATCH_BUFFER_SIZE];
+uint16_t logic_user_cred_batch_length;
+// Number of credentials of the batch stored, reported to the host when the stream ends
+uint16_t logic_user_cred_batch_nb_stored;
 
 
 /*! \fn     logic_user_init_context(uint8_t user_id)
@@ -21,7 +29,6 @@ uint8_t logic_user_next_ctr_val[MEMBER_SIZE(nodemgmt_profile_main_data_t,current
 void logic_user_init_context(uint8_t user_id)
 {
     nodemgmt_init_context(user_id);
-    nodemgmt_read_profile_ctr((void*)logic_user_next_ctr_val);
 }
 
 /*! \fn     logic_user_create_new_user(volatile uint16_t* pin_code, BOOL use_provisioned_key, volatile uint8_t* aes_key)
@@ -61,12 +68,18 @@ ret_type_te logic_user_create_new_user(volatile uint16_t* pin_code, BOOL use_pro
     else
     {
         user_profile.use_provisioned_key_flag = 0;
-        rng_fill_array(user_profile.provisioned_key, sizeof(user_profile.provisioned_key));
+        if (rng_fill_array(user_profile.provisioned_key, sizeof(user_profile.provisioned_key)) != RETURN_OK)
+        {
+            return RETURN_NOK;
+        }
     }
     
-    /* Nonce & Cards CPZ: random numbers */
-    rng_fill_array(user_profile.cards_cpz, sizeof(user_profile.cards_cpz));
-    rng_fill_array(user_profile.nonce, sizeof(user_profile.nonce));
+    /* Nonce, Cards CPZ & card AES key: random numbers, generated before anything is written */
+    if ((rng_fill_array(user_profile.cards_cpz, sizeof(user_profile.cards_cpz)) != RETURN_OK) || (rng_fill_array(user_profile.nonce, sizeof(user_profile.nonce)) != RETURN_OK) || (rng_fill_array(temp_buffer, sizeof(temp_buffer)) != RETURN_OK))
+    {
+        memset((void*)&user_profile, 0, sizeof(user_profile));
+        return RETURN_NOK;
+    }
     
     /* Reserved field: set to 0 */
     memset(user_profile.reserved, 0, sizeof(user_profile.reserved));
@@ -81,18 +94,154 @@ ret_type_te logic_user_create_new_user(volatile uint16_t* pin_code, BOOL use_pro
     smartcard_highlevel_write_protected_zone(user_profile.cards_cpz);
     
     /* Write card random AES key */
-    rng_fill_array(temp_buffer, sizeof(temp_buffer));
     if (smartcard_highlevel_write_aes_key(temp_buffer) != RETURN_OK)
     {
+        memset(temp_buffer, 0, sizeof(temp_buffer));
         return RETURN_NOK;
     }
-    memset(temp_buffer, 0, sizeof(temp_buffer));
     
-    // TODO: Initialize encryption handling
-    //initEncryptionHandling(temp_buffer, temp_nonce);
+    /* Initialize encryption handling */
+    logic_encryption_init_context(temp_buffer, &user_profile);
+    memset(temp_buffer, 0, sizeof(temp_buffer));
     
     // Write new pin code
     smartcard_highlevel_write_security_code(pin_code);
     
     return custom_fs_store_cpz_entry(&user_profile, new_user_id);
-}
\ No newline at end of file
+}
+
+/*! \fn     logic_user_is_logged_in(void)
+*   \brief  Know if credentials can be stored: unlocked card, user & encryption contexts initialized
+*   \return TRUE if a user is logged in
+*/
+static BOOL logic_user_is_logged_in(void)
+{
+    if ((logic_security_is_smc_inserted_unlocked() == FALSE) || (nodemgmt_is_context_valid() == FALSE) || (logic_encryption_is_context_valid() == FALSE))
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*! \fn     logic_user_store_cred_batch(void)
+*   \brief  Parse the received credential batch and store it once the user approved it
+*   \return success or not, logic_user_cred_batch_nb_stored set to the number of stored credentials
+*   \note   Called while dealing with the last batch chunk, which is released before the prompt
+*/
+static RET_TYPE logic_user_store_cred_batch(void)
+{
+    nodemgmt_batch_cred_t batch_creds[NODEMGMT_BATCH_MAX_NB_CREDS];
+    cust_char_t prompt_string[40];
+    uint16_t nb_creds = 0;
+    uint16_t nb_updated;
+    uint16_t offset = 0;
+    uint16_t nb_new;
+    
+    /* Parse & check records */
+    while (offset < logic_user_cred_batch_length)
+    {
+        logic_user_cred_batch_record_t* record_pt = (logic_user_cred_batch_record_t*)&logic_user_cred_batch_buffer[offset];
+        uint16_t record_length = sizeof(logic_user_cred_batch_record_t) + (record_pt->service_length + record_pt->login_length)*sizeof(cust_char_t) + record_pt->password_length;
+        record_length = (record_length + 1) & ~1;
+        
+        /* Boundaries & field sizes */
+        if ((nb_creds == NODEMGMT_BATCH_MAX_NB_CREDS) || (offset + sizeof(logic_user_cred_batch_record_t) > logic_user_cred_batch_length) || (offset + record_length > logic_user_cred_batch_length) || \
+            (record_pt->service_length == 0) || (record_pt->service_length > MEMBER_ARRAY_SIZE(parent_cred_node_t, service)) || \
+            (record_pt->login_length == 0) || (record_pt->login_length > MEMBER_ARRAY_SIZE(child_cred_node_t, login)) || \
+            (record_pt->password_length > MEMBER_SIZE(child_cred_node_t, password)))
+        {
+            return RETURN_NOK;
+        }
+        
+        /* Strings must be 0 terminated */
+        batch_creds[nb_creds].service = (cust_char_t*)&logic_user_cred_batch_buffer[offset + sizeof(logic_user_cred_batch_record_t)];
+        batch_creds[nb_creds].login = &batch_creds[nb_creds].service[record_pt->service_length];
+        batch_creds[nb_creds].password = (uint8_t*)&batch_creds[nb_creds].login[record_pt->login_length];
+        batch_creds[nb_creds].password_length = record_pt->password_length;
+        if ((batch_creds[nb_creds].service[record_pt->service_length-1] != 0) || (batch_creds[nb_creds].login[record_pt->login_length-1] != 0))
+        {
+            return RETURN_NOK;
+        }
+        
+        nb_creds++;
+        offset += record_length;
+    }
+    
+    /* Card may have been removed while the batch was streamed */
+    if (logic_user_is_logged_in() == FALSE)
+    {
+        return RETURN_NOK;
+    }
+    
+    /* Ask the user, once for the whole batch: existing passwords get overwritten */
+    nodemgmt_count_credentials_batch(batch_creds, nb_creds, &nb_new, &nb_updated);
+    prompt_string[0] = 0;
+    utils_custchar_append_uint16(prompt_string, nb_new);
+    utils_custchar_strcat(prompt_string, u" new, ");
+    utils_custchar_append_uint16(prompt_string, nb_updated);
+    utils_custchar_strcat(prompt_string, u" updated: store?");
+    
+    /* The prompt answers other messages: release the chunk we were called for, its data is in our buffer */
+    comms_aux_mcu_wait_for_message_received();
+    comms_aux_arm_rx_and_clear_no_comms();
+    mini_input_yes_no_ret_te prompt_answer = gui_prompts_ask_for_one_line_string_confirmation(prompt_string, TRUE);
+    
+    /* Our acknowledgement goes in the message buffer the prompt may have used */
+    comms_aux_mcu_wait_for_message_sent();
+    
+    /* Denied, timed out, or card removed in the mean time */
+    if ((prompt_answer != MINI_INPUT_RET_YES) || (logic_user_is_logged_in() == FALSE))
+    {
+        return RETURN_NOK;
+    }
+    
+    return nodemgmt_store_credentials_batch(batch_creds, nb_creds, &logic_user_cred_batch_nb_stored);
+}
+
+/*! \fn     logic_user_cred_batch_stream_start(uint32_t total_length)
+*   \brief  Start receiving a credential batch
+*   \param  total_length    Batch length
+*   \return RETURN_OK if a user is logged in and the batch fits in our buffer
+*/
+RET_TYPE logic_user_cred_batch_stream_start(uint32_t total_length)
+{
+    if ((logic_user_is_logged_in() == FALSE) || (total_length == 0) || (total_length > sizeof(logic_user_cred_batch_buffer)))
+    {
+        return RETURN_NOK;
+    }
+    logic_user_cred_batch_length = (uint16_t)total_length;
+    logic_user_cred_batch_nb_stored = 0;
+    return RETURN_OK;
+}
+
+/*! \fn     logic_user_cred_batch_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+*   \brief  Store streamed batch bytes, store the credentials once the batch is complete
+*   \param  data    Batch bytes
+*   \param  length  Number of bytes
+*   \param  offset  Offset in the stream
+*   \return RETURN_NOK to abort the stream: batch invalid, refused by the user or not fully stored
+*/
+RET_TYPE logic_user_cred_batch_stream_data(uint8_t* data, uint16_t length, uint32_t offset)
+{
+    /* Stream module already checked we won't go over total length */
+    memcpy((void*)&logic_user_cred_batch_buffer[offset], (void*)data, length);
+    
+    /* Last chunk: store batch */
+    if (offset + length == logic_user_cred_batch_length)
+    {
+        return logic_user_store_cred_batch();
+    }
+    return RETURN_OK;
+}
+
+/*! \fn     logic_user_cred_batch_stream_end(BOOL stream_complete)
+*   \brief  Clear the batch buffer, as it contains passwords
+*   \param  stream_complete FALSE if the stream was aborted
+*   \return Number of stored credentials, so the host knows how far a batch failing mid way got
+*/
+uint16_t logic_user_cred_batch_stream_end(BOOL stream_complete)
+{
+    (void)stream_complete;
+    memset((void*)logic_user_cred_batch_buffer, 0, sizeof(logic_user_cred_batch_buffer));
+    return logic_user_cred_batch_nb_stored;
+}
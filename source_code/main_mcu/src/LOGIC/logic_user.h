@@ -10,7 +10,23 @@
 
 #include "defines.h"
 
+/* Defines */
+// Credential batch stream: records of a logic_user_cred_batch_record_t header followed by the 0 terminated service, the 0 terminated login and the password, padded to an even length
+#define LOGIC_USER_CRED_BATCH_BUFFER_SIZE   2048
+
+/* Typedefs */
+typedef struct
+{
+    uint8_t service_length;     // In characters, including terminating 0
+    uint8_t login_length;       // In characters, including terminating 0
+    uint8_t password_length;    // In bytes
+    uint8_t reserved;
+} logic_user_cred_batch_record_t;
+
 /* Prototypes */
+RET_TYPE logic_user_cred_batch_stream_data(uint8_t* data, uint16_t length, uint32_t offset);
+RET_TYPE logic_user_cred_batch_stream_start(uint32_t total_length);
+uint16_t logic_user_cred_batch_stream_end(BOOL stream_complete);
 ret_type_te logic_user_create_new_user(volatile uint16_t* pin_code, BOOL use_provisioned_key, uint8_t* aes_key);
 void logic_user_init_context(uint8_t user_id);
 
@@ -6,13 +6,18 @@
 #include <assert.h>
 #include <string.h>
 #include "comms_hid_msgs_debug.h"
+#include "logic_encryption.h"
+#include "aes256_ctr.h"
 #include "nodemgmt.h"
 #include "dbflash.h"
+#include "dma.h"
 #include "utils.h"
 #include "main.h"
 
 // Current node management handle
 nodemgmtHandle_t nodemgmt_current_handle;
+// Set once the handle is initialized for a user, cleared on card removal
+BOOL nodemgmt_context_valid = FALSE;
 // Current date
 uint16_t nodemgmt_current_date;
 
@@ -275,21 +280,65 @@ void readChildNodeDataBlockFromFlash(uint16_t address, child_node_t* child_node)
 }
 
 /*! \fn     readCredChildNode(uint16_t address, child_cred_node_t* child_node)
-*   \brief  Read a child node
+*   \brief  Read a child node and decrypt its password
 *   \param  address     Where to read
 *   \param  child_node  Pointer to the node
-*   \note   what's different from function above: sec checks & timestamp updates
+*   \return RETURN_NOK if no user is logged in: the password is then cleared
+*   \note   what's different from function above: sec checks, timestamp updates & password decryption
+*   \note   The password keystream only depends on the node CTR: it is generated while the DMA controller reads the rest of the node
+*   \note   Plaintext passwords, stored before encryption was introduced, are encrypted in flash when first read
 */
-void readCredChildNode(uint16_t address, child_cred_node_t* child_node)
+RET_TYPE readCredChildNode(uint16_t address, child_cred_node_t* child_node)
 {
-    readChildNodeDataBlockFromFlash(address, (child_node_t*)child_node);
+    child_cred_node_t* const dirty_address_finding_trick = (child_cred_node_t*)0;
+    uint16_t nb_bytes_until_ctr_end = (size_t)&(dirty_address_finding_trick->ctr) + sizeof(dirty_address_finding_trick->ctr);
+    uint8_t password_buffer[MEMBER_SIZE(child_cred_node_t, password)];
+    uint8_t* node_as_bytes = ((child_node_t*)child_node)->node_as_bytes;
+    BOOL plaintext_password = FALSE;
+    BOOL write_back = FALSE;
+    RET_TYPE keystream_ret;
+    
+    /* Read the node up to its CTR */
+    dbflash_read_data_start(&dbflash_descriptor, pageNumberFromAddress(address), BASE_NODE_SIZE * nodeNumberFromAddress(address), sizeof(((child_node_t*)child_node)->node_as_bytes));
+    dma_dbflash_init_transfer((void*)&dbflash_descriptor.sercom_pt->SPI.DATA.reg, (void*)node_as_bytes, nb_bytes_until_ctr_end);
+    while (dma_dbflash_check_and_clear_dma_transfer_flag() == FALSE);
+    
+    /* Read the rest of the node while generating the keystream */
+    dma_dbflash_init_transfer((void*)&dbflash_descriptor.sercom_pt->SPI.DATA.reg, (void*)&node_as_bytes[nb_bytes_until_ctr_end], sizeof(((child_node_t*)child_node)->node_as_bytes) - nb_bytes_until_ctr_end);
+    keystream_ret = logic_encryption_generate_keystream(child_node->ctr, password_buffer, sizeof(password_buffer));
+    while (dma_dbflash_check_and_clear_dma_transfer_flag() == FALSE);
+    dbflash_stop_ongoing_transfer(&dbflash_descriptor);
     checkUserPermissionFromFlagsAndLock(child_node->flags);
     
+    // No encryption context: never return the stored password
+    if (keystream_ret != RETURN_OK)
+    {
+        memset((void*)child_node->password, 0, sizeof(child_node->password));
+        return RETURN_NOK;
+    }
+    
+    // Plaintext password: keep it for the caller, store it encrypted
+    if (child_node->passwordFormat == NODEMGMT_PWD_FORMAT_PLAINTEXT)
+    {
+        plaintext_password = TRUE;
+        memcpy((void*)password_buffer, (void*)child_node->password, sizeof(password_buffer));
+        if (logic_encryption_ctr_encrypt(child_node->password, sizeof(child_node->password), child_node->ctr) == RETURN_OK)
+        {
+            child_node->passwordFormat = NODEMGMT_PWD_FORMAT_AES256_CTR;
+            write_back = TRUE;
+        }
+    }
+    
     // If we have a date, update last used field
     if (nodemgmt_current_date != 0x0000)
     {
         // Just update the good field and write at the same place
         child_node->dateLastUsed = nodemgmt_current_date;
+        write_back = TRUE;
+    }
+    
+    if (write_back != FALSE)
+    {
         writeChildNodeDataBlockToFlash(address, (child_node_t*)child_node);
     }
     
@@ -297,6 +346,45 @@ void readCredChildNode(uint16_t address, child_cred_node_t* child_node)
     child_node->login[(sizeof(child_node->login)/sizeof(child_node->login[0]))-1] = 0;
     child_node->thirdField[(sizeof(child_node->thirdField)/sizeof(child_node->thirdField[0]))-1] = 0;
     child_node->description[(sizeof(child_node->description)/sizeof(child_node->description[0]))-1] = 0;
+    
+    // Password decryption, once the node was written back
+    if (plaintext_password != FALSE)
+    {
+        memcpy((void*)child_node->password, (void*)password_buffer, sizeof(child_node->password));
+    }
+    else
+    {
+        aes256_ctr_xor_keystream(child_node->password, password_buffer, sizeof(child_node->password));
+    }
+    memset((void*)password_buffer, 0, sizeof(password_buffer));
+    return RETURN_OK;
+}
+
+/*! \fn     readCredChildNodeLogin(uint16_t address, cust_char_t* login, uint16_t login_length)
+*   \brief  Read only the login field of a child node, for display purposes
+*   \param  address         Where to read
+*   \param  login           Where to store the login
+*   \param  login_length    Size of the login buffer, in characters
+*   \note   Doesn't update the last used date, login is always 0 terminated
+*/
+void readCredChildNodeLogin(uint16_t address, cust_char_t* login, uint16_t login_length)
+{
+    child_cred_node_t* const dirty_address_finding_trick = (child_cred_node_t*)0;
+    uint16_t flags;
+
+    // Sec checks on the flags
+    dbflash_read_data_from_flash(&dbflash_descriptor, pageNumberFromAddress(address), BASE_NODE_SIZE * nodeNumberFromAddress(address), sizeof(flags), (void*)&flags);
+    checkUserPermissionFromFlagsAndLock(flags);
+
+    // Only fetch what we can store, login field is contained in the first half of the node
+    if (login_length > (sizeof(dirty_address_finding_trick->login)/sizeof(dirty_address_finding_trick->login[0])))
+    {
+        login_length = sizeof(dirty_address_finding_trick->login)/sizeof(dirty_address_finding_trick->login[0]);
+    }
+    dbflash_read_data_from_flash(&dbflash_descriptor, pageNumberFromAddress(address), BASE_NODE_SIZE * nodeNumberFromAddress(address) + (size_t)&(dirty_address_finding_trick->login), login_length*sizeof(cust_char_t), (void*)login);
+
+    // String cleaning
+    login[login_length-1] = 0;
 }
 
 /*! \fn     userProfileStartingOffset(uint8_t uid, uint16_t *page, uint16_t *pageOffset)
@@ -574,11 +662,11 @@ void nodemgmt_read_profile_ctr(void* buf)
     dbflash_read_data_from_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)&(dirty_address_finding_trick->main_data.current_ctr), sizeof(dirty_address_finding_trick->main_data.current_ctr), buf);
 }
 
-/**
- * Sets the user DB change number in the user profile flash memory
- * @param   buf             The buffer containing the user db change number
+/*! \fn     nodemgmt_set_profile_ctr(void* buf)
+ *  \brief  Sets the users base CTR in the user profile flash memory
+ *  \param  buf             The buffer containing the CTR
  */
-void setProfileCtr(void *buf)
+void nodemgmt_set_profile_ctr(void* buf)
 {
     nodemgmt_userprofile_t* const dirty_address_finding_trick = (nodemgmt_userprofile_t*)0;
     dbflash_write_data_to_flash(&dbflash_descriptor, nodemgmt_current_handle.pageUserProfile, nodemgmt_current_handle.offsetUserProfile + (size_t)&(dirty_address_finding_trick->main_data.current_ctr), sizeof(dirty_address_finding_trick->main_data.current_ctr), buf);
@@ -688,6 +776,7 @@ void nodemgmt_init_context(uint16_t userIdNum)
     nodemgmt_current_handle.firstParentNode = getStartingParentAddress();
     nodemgmt_current_handle.currentUserId = userIdNum;
     nodemgmt_current_handle.datadbChanged = FALSE;
+    nodemgmt_current_handle.deferNodeUsageScan = FALSE;
     nodemgmt_current_handle.dbChanged = FALSE;
     
     // Get starting data parents
@@ -698,10 +787,28 @@ void nodemgmt_init_context(uint16_t userIdNum)
     
     // scan for next free parent and child nodes from the start of the memory
     scanNodeUsage();
+    nodemgmt_context_valid = TRUE;
     
     // To think about: the old service LUT from the mini isn't needed as we support unicode now
 }
 
+/*! \fn     nodemgmt_delete_context(void)
+ *  \brief  Invalidate the Node Management Handle, on card removal
+ */
+void nodemgmt_delete_context(void)
+{
+    nodemgmt_context_valid = FALSE;
+}
+
+/*! \fn     nodemgmt_is_context_valid(void)
+ *  \brief  Know if the Node Management Handle is initialized for a user
+ *  \return TRUE if it is
+ */
+BOOL nodemgmt_is_context_valid(void)
+{
+    return nodemgmt_context_valid;
+}
+
 /*! \fn     userDBChangedActions(BOOL dataChanged)
  *  \brief  Function called to inform that the DB has been changed
  *  \param  dataChanged  FALSE when a standard credential is changed, something else when it is a data node that is changed
@@ -1000,8 +1107,11 @@ RET_TYPE createGenericNode(generic_node_t* g, node_type_te node_type, uint16_t f
         } // end while
     } // end if first parent
     
-    // Rescan node usage
-    scanNodeUsage();
+    // Rescan node usage, unless the caller provides free nodes
+    if (nodemgmt_current_handle.deferNodeUsageScan == FALSE)
+    {
+        scanNodeUsage();
+    }
     
     // Store the address
     *storedAddress = freeNodeAddress;
@@ -1095,4 +1205,285 @@ RET_TYPE createChildNode(uint16_t pAddr, child_cred_node_t* c, uint16_t* storedA
     }
     
     return temprettype;
-}  
\ No newline at end of file
+}  
+
+/*! \fn     nodemgmt_compare_batch_creds(nodemgmt_batch_cred_t* first_cred, nodemgmt_batch_cred_t* second_cred)
+ *  \brief  Compare two batch credentials, by service then login
+ *  \param  first_cred      First credential
+ *  \param  second_cred     Second credential
+ *  \return positive if first_cred comes after second_cred, negative if not, 0 if same service & login
+ */
+static int16_t nodemgmt_compare_batch_creds(nodemgmt_batch_cred_t* first_cred, nodemgmt_batch_cred_t* second_cred)
+{
+    int16_t res = utils_custchar_strncmp(first_cred->service, second_cred->service, MEMBER_ARRAY_SIZE(parent_cred_node_t, service));
+    
+    if (res == 0)
+    {
+        res = utils_custchar_strncmp(first_cred->login, second_cred->login, MEMBER_ARRAY_SIZE(child_cred_node_t, login));
+    }
+    return res;
+}
+
+/*! \fn     nodemgmt_sort_batch_creds(nodemgmt_batch_cred_t* creds, uint16_t nb_creds)
+ *  \brief  Sort batch credentials by service then login
+ *  \param  creds           Credentials
+ *  \param  nb_creds        Number of credentials
+ *  \note   Insertion sort: batches are small and often already sorted
+ */
+static void nodemgmt_sort_batch_creds(nodemgmt_batch_cred_t* creds, uint16_t nb_creds)
+{
+    nodemgmt_batch_cred_t temp_cred;
+    
+    for (uint16_t i = 1; i < nb_creds; i++)
+    {
+        temp_cred = creds[i];
+        int16_t j = i-1;
+        while ((j >= 0) && (nodemgmt_compare_batch_creds(&creds[j], &temp_cred) > 0))
+        {
+            creds[j+1] = creds[j];
+            j--;
+        }
+        creds[j+1] = temp_cred;
+    }
+}
+
+/*! \fn     nodemgmt_count_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_new, uint16_t* nb_updated)
+ *  \brief  Count the credentials of a batch that would be added and the ones that would be updated
+ *  \param  creds           Credentials, sorted in place by service then login
+ *  \param  nb_creds        Number of credentials, up to NODEMGMT_BATCH_MAX_NB_CREDS
+ *  \param  nb_new          Where to store the number of new credentials
+ *  \param  nb_updated      Where to store the number of credentials whose password would be overwritten
+ *  \note   Same single ordered pass over the parent list as nodemgmt_store_credentials_batch(), without writes
+ */
+void nodemgmt_count_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_new, uint16_t* nb_updated)
+{
+    parent_node_t temp_parent_node;
+    child_cred_node_t* temp_half_child_node_pt = (child_cred_node_t*)&temp_parent_node;
+    uint16_t cursor_parent_addr = NODE_ADDR_NULL;
+    
+    *nb_new = 0;
+    *nb_updated = 0;
+    nodemgmt_sort_batch_creds(creds, nb_creds);
+    
+    for (uint16_t i = 0; i < nb_creds; i++)
+    {
+        nodemgmt_batch_cred_t* cred = &creds[i];
+        uint16_t parent_addr = NODE_ADDR_NULL;
+        uint16_t child_addr = NODE_ADDR_NULL;
+        
+        // Same service & login than the next credential: only stored once
+        if ((i+1 < nb_creds) && (nodemgmt_compare_batch_creds(cred, &creds[i+1]) == 0))
+        {
+            continue;
+        }
+        
+        // Walk the parent list from our cursor
+        uint16_t addr = (cursor_parent_addr == NODE_ADDR_NULL)? nodemgmt_current_handle.firstParentNode : cursor_parent_addr;
+        while (addr != NODE_ADDR_NULL)
+        {
+            readParentNode(addr, &temp_parent_node, TRUE);
+            int16_t res = utils_custchar_strncmp(cred->service, temp_parent_node.cred_parent.service, MEMBER_ARRAY_SIZE(parent_cred_node_t, service));
+            
+            if (res == 0)
+            {
+                parent_addr = addr;
+                break;
+            }
+            else if (res < 0)
+            {
+                break;
+            }
+            cursor_parent_addr = addr;
+            addr = temp_parent_node.cred_parent.nextParentAddress;
+        }
+        
+        // Look for the login among the children of a known service
+        if (parent_addr != NODE_ADDR_NULL)
+        {
+            child_addr = temp_parent_node.cred_parent.nextChildAddress;
+            while (child_addr != NODE_ADDR_NULL)
+            {
+                readParentNode(child_addr, &temp_parent_node, FALSE);
+                if (utils_custchar_strncmp(cred->login, temp_half_child_node_pt->login, MEMBER_ARRAY_SIZE(child_cred_node_t, login)) == 0)
+                {
+                    break;
+                }
+                child_addr = temp_half_child_node_pt->nextChildAddress;
+            }
+        }
+        
+        if (child_addr != NODE_ADDR_NULL)
+        {
+            (*nb_updated)++;
+        }
+        else
+        {
+            (*nb_new)++;
+        }
+    }
+}
+
+/*! \fn     nodemgmt_store_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_stored)
+ *  \brief  Add or update a batch of credentials in a single ordered pass over the parent list
+ *  \param  creds           Credentials, sorted in place by service then login
+ *  \param  nb_creds        Number of credentials, up to NODEMGMT_BATCH_MAX_NB_CREDS
+ *  \param  nb_stored       Where to store the number of credentials added or updated
+ *  \return success status
+ *  \note   Free nodes are found with a single memory scan and the change number is updated once, for the whole batch
+ *  \note   Passwords are padded with 0s and encrypted with the logged in user context
+ */
+RET_TYPE nodemgmt_store_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_stored)
+{
+    uint16_t free_parent_addresses[NODEMGMT_BATCH_MAX_NB_CREDS];
+    uint16_t free_child_addresses[NODEMGMT_BATCH_MAX_NB_CREDS];
+    uint16_t nb_free_parents_used = 0;
+    uint16_t nb_free_children_used = 0;
+    child_node_t temp_child_node;
+    parent_node_t temp_parent_node;
+    child_cred_node_t* temp_half_child_node_pt = (child_cred_node_t*)&temp_parent_node;
+    RET_TYPE ret_val = RETURN_OK;
+    
+    // Last parent node known to come before the current service, NODE_ADDR_NULL for the list start
+    uint16_t cursor_parent_addr = NODE_ADDR_NULL;
+    
+    *nb_stored = 0;
+    if ((nb_creds == 0) || (nb_creds > NODEMGMT_BATCH_MAX_NB_CREDS))
+    {
+        return RETURN_NOK;
+    }
+    
+    // Sort credentials, already sorted if they were counted
+    nodemgmt_sort_batch_creds(creds, nb_creds);
+    
+    // Find free nodes for the worst case (only new services & logins) with a single scan
+    if (findFreeNodes(nb_creds, free_parent_addresses, nb_creds, free_child_addresses, pageNumberFromAddress(nodemgmt_current_handle.nextParentFreeNode), nodeNumberFromAddress(nodemgmt_current_handle.nextParentFreeNode)) != 2*nb_creds)
+    {
+        return RETURN_NOK;
+    }
+    nodemgmt_current_handle.deferNodeUsageScan = TRUE;
+    
+    for (uint16_t i = 0; i < nb_creds; i++)
+    {
+        nodemgmt_batch_cred_t* cred = &creds[i];
+        uint16_t parent_addr = NODE_ADDR_NULL;
+        uint16_t child_addr;
+        uint16_t temp_address;
+        
+        // Same service & login than the previous credential: last one wins
+        if ((i+1 < nb_creds) && (nodemgmt_compare_batch_creds(cred, &creds[i+1]) == 0))
+        {
+            continue;
+        }
+        
+        // Walk the parent list from our cursor: credentials are sorted, so we never go back
+        uint16_t addr = (cursor_parent_addr == NODE_ADDR_NULL)? nodemgmt_current_handle.firstParentNode : cursor_parent_addr;
+        while (addr != NODE_ADDR_NULL)
+        {
+            readParentNode(addr, &temp_parent_node, TRUE);
+            int16_t res = utils_custchar_strncmp(cred->service, temp_parent_node.cred_parent.service, MEMBER_ARRAY_SIZE(parent_cred_node_t, service));
+            
+            if (res == 0)
+            {
+                parent_addr = addr;
+                break;
+            }
+            else if (res < 0)
+            {
+                break;
+            }
+            cursor_parent_addr = addr;
+            addr = temp_parent_node.cred_parent.nextParentAddress;
+        }
+        
+        // Unknown service: insert a new parent right after our cursor
+        if (parent_addr == NODE_ADDR_NULL)
+        {
+            memset((void*)&temp_parent_node, 0, sizeof(temp_parent_node));
+            memcpy((void*)temp_parent_node.cred_parent.service, (void*)cred->service, utils_strlen(cred->service)*sizeof(cust_char_t));
+            temp_parent_node.cred_parent.nextChildAddress = NODE_ADDR_NULL;
+            nodemgmt_current_handle.nextParentFreeNode = free_parent_addresses[nb_free_parents_used++];
+            
+            if (cursor_parent_addr == NODE_ADDR_NULL)
+            {
+                ret_val = createGenericNode((generic_node_t*)&temp_parent_node, NODE_TYPE_PARENT, nodemgmt_current_handle.firstParentNode, &temp_address, &parent_addr);
+                if ((ret_val == RETURN_OK) && (temp_address != nodemgmt_current_handle.firstParentNode))
+                {
+                    setStartingParentAddress(temp_address);
+                }
+            }
+            else
+            {
+                ret_val = createGenericNode((generic_node_t*)&temp_parent_node, NODE_TYPE_PARENT, cursor_parent_addr, &temp_address, &parent_addr);
+            }
+            
+            if (ret_val != RETURN_OK)
+            {
+                break;
+            }
+        }
+        
+        // Look for the login among the children: login & links are in the first half of the node
+        readParentNode(parent_addr, &temp_parent_node, FALSE);
+        child_addr = temp_parent_node.cred_parent.nextChildAddress;
+        while (child_addr != NODE_ADDR_NULL)
+        {
+            readParentNode(child_addr, &temp_parent_node, FALSE);
+            if (utils_custchar_strncmp(cred->login, temp_half_child_node_pt->login, MEMBER_ARRAY_SIZE(child_cred_node_t, login)) == 0)
+            {
+                break;
+            }
+            child_addr = temp_half_child_node_pt->nextChildAddress;
+        }
+        
+        if (child_addr != NODE_ADDR_NULL)
+        {
+            // Known login: update password with a single node write
+            readChildNodeDataBlockFromFlash(child_addr, &temp_child_node);
+            checkUserPermissionFromFlagsAndLock(temp_child_node.cred_child.flags);
+            memset((void*)temp_child_node.cred_child.password, 0, sizeof(temp_child_node.cred_child.password));
+            memcpy((void*)temp_child_node.cred_child.password, (void*)cred->password, cred->password_length);
+            ret_val = logic_encryption_ctr_encrypt(temp_child_node.cred_child.password, sizeof(temp_child_node.cred_child.password), temp_child_node.cred_child.ctr);
+            if (ret_val != RETURN_OK)
+            {
+                break;
+            }
+            temp_child_node.cred_child.passwordFormat = NODEMGMT_PWD_FORMAT_AES256_CTR;
+            temp_child_node.cred_child.dateLastUsed = nodemgmt_current_date;
+            writeChildNodeDataBlockToFlash(child_addr, &temp_child_node);
+        }
+        else
+        {
+            // New login
+            memset((void*)&temp_child_node, 0, sizeof(temp_child_node));
+            memcpy((void*)temp_child_node.cred_child.login, (void*)cred->login, utils_strlen(cred->login)*sizeof(cust_char_t));
+            memcpy((void*)temp_child_node.cred_child.password, (void*)cred->password, cred->password_length);
+            ret_val = logic_encryption_ctr_encrypt(temp_child_node.cred_child.password, sizeof(temp_child_node.cred_child.password), temp_child_node.cred_child.ctr);
+            if (ret_val != RETURN_OK)
+            {
+                break;
+            }
+            temp_child_node.cred_child.passwordFormat = NODEMGMT_PWD_FORMAT_AES256_CTR;
+            nodemgmt_current_handle.nextChildFreeNode = free_child_addresses[nb_free_children_used++];
+            ret_val = createChildNode(parent_addr, &temp_child_node.cred_child, &child_addr);
+            if (ret_val != RETURN_OK)
+            {
+                break;
+            }
+        }
+        
+        (*nb_stored)++;
+    }
+    
+    // Our temp node may contain a password being encrypted
+    memset((void*)&temp_child_node, 0, sizeof(temp_child_node));
+    
+    // Single node usage scan & change number update for the whole batch
+    nodemgmt_current_handle.deferNodeUsageScan = FALSE;
+    scanNodeUsage();
+    if (*nb_stored != 0)
+    {
+        userDBChangedActions(FALSE);
+    }
+    
+    return ret_val;
+}
@@ -43,6 +43,9 @@ typedef enum    {SERVICE_CRED_TYPE, SERVICE_DATA_TYPE} service_type_te;
 #define NODEMGMT_ADDR_NULL                          0x0000
 #define NODEMGMT_VBIT_VALID                         0
 #define NODEMGMT_VBIT_INVALID                       1
+#define NODEMGMT_BATCH_MAX_NB_CREDS                 32
+#define NODEMGMT_PWD_FORMAT_PLAINTEXT               0x00
+#define NODEMGMT_PWD_FORMAT_AES256_CTR              0x01
 
 
 /* Structs */
@@ -107,7 +110,7 @@ typedef struct
     uint16_t keyAfterLogin;         // Typed key after login
     uint16_t keyAfterPassword;      // Typed key after password
     uint16_t fakeFlags;             // Same as flags but with bit 5 set to 1
-    uint8_t reserved;               // Reserved
+    uint8_t passwordFormat;         // Password storage format, plaintext for nodes stored before encryption
     uint8_t ctr[3];                 // Encryption counter
     uint8_t password[128];          // Encrypted password
     uint8_t TBD[130];               // TBD
@@ -198,14 +201,33 @@ typedef struct
     uint16_t firstDataParentNode[16];       // The addresses of the users first data parent nodes (read from flash. eg cache)
     uint16_t nextParentFreeNode;            // The address of the next free parent node
     uint16_t nextChildFreeNode;             // The address of the next free child node
+    BOOL deferNodeUsageScan;                // Set during batches: free nodes are provided by the batch, memory is scanned once at the end
     parent_node_t temp_parent_node;         // Temp parent node to be used when needed
 } nodemgmtHandle_t;
 
+// Credential to store in a batch, strings are 0 terminated
+typedef struct
+{
+    cust_char_t* service;
+    cust_char_t* login;
+    uint8_t* password;
+    uint16_t password_length;
+} nodemgmt_batch_cred_t;
+
 /* Prototypes */
+void nodemgmt_count_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_new, uint16_t* nb_updated);
+RET_TYPE nodemgmt_store_credentials_batch(nodemgmt_batch_cred_t* creds, uint16_t nb_creds, uint16_t* nb_stored);
+RET_TYPE readCredChildNode(uint16_t address, child_cred_node_t* child_node);
+void readCredChildNodeLogin(uint16_t address, cust_char_t* login, uint16_t login_length);
+void readParentNode(uint16_t address, parent_node_t* parent_node, BOOL data_clean);
 void nodemgmt_init_context(uint16_t userIdNum);
+BOOL nodemgmt_is_context_valid(void);
+void nodemgmt_delete_context(void);
 RET_TYPE checkUserPermission(uint16_t node_addr);
 void nodemgmt_format_user_profile(uint16_t uid);
 void nodemgmt_set_current_date(uint16_t date);
 void nodemgmt_read_profile_ctr(void* buf);
+void nodemgmt_set_profile_ctr(void* buf);
+uint16_t getStartingParentAddress(void);
 
 #endif /* NODEMGMT_H_ */
\ No newline at end of file
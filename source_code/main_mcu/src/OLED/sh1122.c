@@ -378,14 +378,154 @@ void sh1122_clear_current_screen(sh1122_descriptor_t* oled_descriptor)
 }
 
 #ifdef OLED_INTERNAL_FRAME_BUFFER
+/*! \fn     sh1122_wait_for_frame_buffer_clear(sh1122_descriptor_t* oled_descriptor)
+*   \brief  Wait for a DMA frame buffer clear to be done, to be called before accessing the frame buffer
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*/
+static inline void sh1122_wait_for_frame_buffer_clear(sh1122_descriptor_t* oled_descriptor)
+{
+    #ifdef OLED_DMA_FRAME_BUFFER_CLEAR
+    if (oled_descriptor->frame_buffer_clear_in_progress != FALSE)
+    {
+        while(dma_memset_check_and_clear_dma_transfer_flag() == FALSE);
+        oled_descriptor->frame_buffer_clear_in_progress = FALSE;
+    }
+    #endif
+}
+
 /*! \fn     sh1122_clear_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 *   \brief  Clear frame buffer
 *   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \note   With OLED_DMA_FRAME_BUFFER_CLEAR the clear runs in the background until the next frame buffer access
 */
 void sh1122_clear_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 {
     sh1122_check_for_flush_and_terminate(oled_descriptor);
-    memset((void*)oled_descriptor->frame_buffer, 0x00, sizeof(oled_descriptor->frame_buffer));
+    sh1122_wait_for_frame_buffer_clear(oled_descriptor);
+    
+    #ifdef OLED_DMA_FRAME_BUFFER_CLEAR
+    /* Word-wide DMA memset, frees the bus matrix from CPU stores: waited for when the frame buffer is next accessed */
+    dma_memset_init_transfer((void*)oled_descriptor->frame_buffer, 0x00000000, sizeof(oled_descriptor->frame_buffer)/sizeof(uint32_t));
+    oled_descriptor->frame_buffer_clear_in_progress = TRUE;
+    #else
+    uint32_t* frame_buffer_words = (uint32_t*)oled_descriptor->frame_buffer;
+    for (uint32_t i = 0; i < sizeof(oled_descriptor->frame_buffer)/sizeof(uint32_t); i++)
+    {
+        frame_buffer_words[i] = 0;
+    }
+    #endif
+}
+
+/*! \fn     sh1122_shift_frame_buffer(sh1122_descriptor_t* oled_descriptor, int16_t nb_lines)
+*   \brief  Shift the frame buffer contents vertically, clearing the exposed lines
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  nb_lines            Number of lines: positive to move the contents down, negative to move them up
+*   \note   Frame buffer lines being word aligned, done with 32-bit copies
+*/
+void sh1122_shift_frame_buffer(sh1122_descriptor_t* oled_descriptor, int16_t nb_lines)
+{
+    uint32_t* frame_buffer_words = (uint32_t*)oled_descriptor->frame_buffer;
+    uint32_t nb_words = sizeof(oled_descriptor->frame_buffer)/sizeof(uint32_t);
+    uint32_t offset;
+    uint32_t i;
+    
+    sh1122_check_for_flush_and_terminate(oled_descriptor);
+    sh1122_wait_for_frame_buffer_clear(oled_descriptor);
+    
+    /* Number of words the contents move by */
+    offset = ((nb_lines < 0)? -nb_lines : nb_lines) * (sizeof(oled_descriptor->frame_buffer[0])/sizeof(uint32_t));
+    if (offset > nb_words)
+    {
+        offset = nb_words;
+    }
+    
+    if (nb_lines < 0)
+    {
+        /* Contents up: copy from the top, clear the bottom lines */
+        for (i = 0; i < nb_words - offset; i++)
+        {
+            frame_buffer_words[i] = frame_buffer_words[i + offset];
+        }
+        for (; i < nb_words; i++)
+        {
+            frame_buffer_words[i] = 0;
+        }
+    }
+    else
+    {
+        /* Contents down: copy from the bottom, clear the top lines */
+        for (i = nb_words; i > offset; i--)
+        {
+            frame_buffer_words[i - 1] = frame_buffer_words[i - 1 - offset];
+        }
+        for (i = 0; i < offset; i++)
+        {
+            frame_buffer_words[i] = 0;
+        }
+    }
+}
+
+/*! \fn     sh1122_fill_frame_buffer_line(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, uint16_t width, uint8_t color)
+*   \brief  Fill part of a frame buffer line with a given color
+*   \param  oled_descriptor     Pointer to a sh1122 descriptor struct
+*   \param  x                   Starting x
+*   \param  y                   Line
+*   \param  width               Number of pixels to fill
+*   \param  color               4 bits color
+*   \note   Odd edge pixels are done with nibble masks, unaligned edge bytes with byte stores, the rest with 32-bit stores
+*/
+static void sh1122_fill_frame_buffer_line(sh1122_descriptor_t* oled_descriptor, int16_t x, int16_t y, uint16_t width, uint8_t color)
+{
+    uint8_t fill_byte = (uint8_t)((color & 0x0F) | (color << 4));
+    uint32_t fill_word = fill_byte * 0x01010101UL;
+    int16_t xend = x + width;
+    
+    /* Clip to the screen */
+    if (x < 0)
+    {
+        x = 0;
+    }
+    if (xend > SH1122_OLED_WIDTH)
+    {
+        xend = SH1122_OLED_WIDTH;
+    }
+    if ((y < 0) || (y >= SH1122_OLED_HEIGHT) || (x >= xend))
+    {
+        return;
+    }
+    sh1122_wait_for_frame_buffer_clear(oled_descriptor);
+    uint8_t* line = oled_descriptor->frame_buffer[y];
+    
+    /* Odd start x: pixel in the lower nibble */
+    if ((x & 0x01) != 0)
+    {
+        line[x/2] = (line[x/2] & 0xF0) | (fill_byte & 0x0F);
+        x++;
+    }
+    
+    /* Odd end x: last pixel in the upper nibble */
+    if ((xend & 0x01) != 0)
+    {
+        xend--;
+        line[xend/2] = (line[xend/2] & 0x0F) | (fill_byte & 0xF0);
+    }
+    
+    /* Remaining full bytes, word-wide when aligned */
+    uint16_t byte_index = x/2;
+    uint16_t byte_end = xend/2;
+    while ((byte_index < byte_end) && ((byte_index & 0x03) != 0))
+    {
+        line[byte_index++] = fill_byte;
+    }
+    while (byte_index + 4 <= byte_end)
+    {
+        *(uint32_t*)&line[byte_index] = fill_word;
+        byte_index += 4;
+    }
+    while (byte_index < byte_end)
+    {
+        line[byte_index++] = fill_byte;
+    }
 }
 
 /*! \fn     sh1122_check_for_flush_and_terminate(sh1122_descriptor_t* oled_descriptor)
@@ -424,6 +564,7 @@ void sh1122_flush_frame_buffer_window(sh1122_descriptor_t* oled_descriptor, uint
 {
     x = ((x)/2)*2;
     width = ((width+1)/2)*2;
+    sh1122_wait_for_frame_buffer_clear(oled_descriptor);
     
     /* Sanity checks */
     if (x >= SH1122_OLED_WIDTH)
@@ -456,8 +597,9 @@ void sh1122_flush_frame_buffer_window(sh1122_descriptor_t* oled_descriptor, uint
 */
 void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor)
 {
-    /* Wait for a possible ongoing previous flush */
+    /* Wait for a possible ongoing previous flush & frame buffer clear */
     sh1122_check_for_flush_and_terminate(oled_descriptor);
+    sh1122_wait_for_frame_buffer_clear(oled_descriptor);
     
     if (oled_descriptor->loaded_transition == OLED_TRANS_NONE)
     {        
@@ -696,6 +838,7 @@ void sh1122_init_display(sh1122_descriptor_t* oled_descriptor)
     #ifdef OLED_INTERNAL_FRAME_BUFFER
     memset((void*)oled_descriptor->frame_buffer, 0x00, sizeof(oled_descriptor->frame_buffer));
     oled_descriptor->frame_buffer_flush_in_progress = FALSE;
+    oled_descriptor->frame_buffer_clear_in_progress = FALSE;
     #endif
 
     /* Switch screen on */    
@@ -726,18 +869,16 @@ void sh1122_draw_vertical_line(sh1122_descriptor_t* oled_descriptor, int16_t x,
     #ifdef OLED_INTERNAL_FRAME_BUFFER
     if (write_to_buffer != FALSE)
     {
+        /* Same byte & nibble on each line: walk down a column of the frame buffer */
+        uint8_t pixels = (xoff != 0)? (color & 0x0F) : (uint8_t)(color << 4);
+        sh1122_wait_for_frame_buffer_clear(oled_descriptor);
+        uint8_t* buffer_pt = &oled_descriptor->frame_buffer[ystart][x/2];
+        yend = (yend >= SH1122_OLED_HEIGHT)? SH1122_OLED_HEIGHT-1 : yend;
+        
         for (int16_t y=ystart; y<=yend; y++)
         {
-            uint8_t pixels = color << 4;
-
-            /* Start x not a multiple of 2 */
-            if (xoff != 0)
-            {
-                pixels = color;
-            }
-            
-            /* Fill frame buffer */
-            oled_descriptor->frame_buffer[y][x/2] |= pixels;
+            *buffer_pt |= pixels;
+            buffer_pt += sizeof(oled_descriptor->frame_buffer[0]);
         }
     } 
     else
@@ -808,6 +949,7 @@ void sh1122_display_horizontal_pixel_line(sh1122_descriptor_t* oled_descriptor,
     {
         /* Previous pixels in case we are shifted */
         uint8_t prev_pixels = 0x00;
+        sh1122_wait_for_frame_buffer_clear(oled_descriptor);
         
         /* Boolean to mention if pixel to be written is the first one in the buffer */
         BOOL pixel_shift = FALSE;
@@ -1002,32 +1144,7 @@ void sh1122_draw_rectangle(sh1122_descriptor_t* oled_descriptor, int16_t x, int1
     {
         for (uint16_t yind = 0; yind < height; yind++)
         {
-            uint16_t xind = 0;
-
-            /* Start x not a multiple of 2 */
-            if (xoff != 0)
-            {
-                /* Set xind to 1 as we're writing a pixel */
-                xind = 1;
-                
-                /* one pixel */
-                oled_descriptor->frame_buffer[y+yind][(x+xind)/2] &= 0xF0;
-                oled_descriptor->frame_buffer[y+yind][(x+xind)/2] |= color;
-            }
-            
-            /* Start x multiple of 2, start filling */
-            for (; xind < width; xind+=2)
-            {
-                if ((xind+2) <= width)
-                {
-                    oled_descriptor->frame_buffer[y+yind][(x+xind)/2] = color | (color << 4);
-                }
-                else
-                {
-                    oled_descriptor->frame_buffer[y+yind][(x+xind)/2] &= 0x0F;
-                    oled_descriptor->frame_buffer[y+yind][(x+xind)/2] |= color << 4;
-                }
-            }
+            sh1122_fill_frame_buffer_line(oled_descriptor, x, y+yind, width, (uint8_t)color);
         }
     }
     else
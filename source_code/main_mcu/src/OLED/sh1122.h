@@ -99,8 +99,9 @@ typedef struct
     BOOL oled_on;                                       // Know if oled is on
     oled_transition_te loaded_transition;               // Loaded transition for full frame switch
     #ifdef OLED_INTERNAL_FRAME_BUFFER
-    uint8_t frame_buffer[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/(8/SH1122_OLED_BPP)];
+    uint8_t frame_buffer[SH1122_OLED_HEIGHT][SH1122_OLED_WIDTH/(8/SH1122_OLED_BPP)] __attribute__((aligned(4)));   // Word aligned for 32-bit fills
     BOOL frame_buffer_flush_in_progress;
+    BOOL frame_buffer_clear_in_progress;                // DMA memset started by sh1122_clear_frame_buffer, waited for on the next frame buffer access
     #endif
 } sh1122_descriptor_t;
 
@@ -158,6 +159,7 @@ void sh1122_oled_on(sh1122_descriptor_t* oled_descriptor);
 #ifdef OLED_INTERNAL_FRAME_BUFFER
 void sh1122_flush_frame_buffer_window(sh1122_descriptor_t* oled_descriptor, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
 void sh1122_check_for_flush_and_terminate(sh1122_descriptor_t* oled_descriptor);
+void sh1122_shift_frame_buffer(sh1122_descriptor_t* oled_descriptor, int16_t nb_lines);
 void sh1122_flush_frame_buffer(sh1122_descriptor_t* oled_descriptor);
 void sh1122_clear_frame_buffer(sh1122_descriptor_t* oled_descriptor);
 #endif
@@ -3,19 +3,201 @@
 *    Created:  27/01/2019
 *    Author:   Mathieu Stephan
 */
+#include <string.h>
+#include "platform_defines.h"
+#include "driver_timer.h"
+#include "platform_io.h"
+#include "lis2hh12.h"
+#include "ctr_drbg.h"
 #include "defines.h"
+#include "main.h"
 #include "rng.h"
+// DRBG state
+ctr_drbg_context_t rng_drbg_context;
+BOOL rng_drbg_instantiated = FALSE;
+// Pre-generated random bytes, the available ones being at the beginning of the pool
+uint8_t rng_pool[RNG_POOL_SIZE];
+uint16_t rng_pool_nb_bytes = 0;
+// Collected entropy and the number of bits credited for it
+uint8_t rng_entropy_buffer[RNG_ENTROPY_BUFFER_SIZE];
+uint16_t rng_entropy_buffer_nb_bytes = 0;
+uint16_t rng_entropy_nb_bits = 0;
 
 
+/*! \fn     rng_add_entropy(uint8_t* data, uint16_t nb_bytes, uint16_t nb_bits)
+*   \brief  Add raw entropy to the entropy buffer
+*   \param  data        Raw entropy
+*   \param  nb_bytes    Number of bytes
+*   \param  nb_bits     Number of entropy bits credited for these bytes
+*   \note   A full buffer is conditioned down to CTR_DRBG_SEED_LENGTH bytes with the derivation function
+*/
+static void rng_add_entropy(uint8_t* data, uint16_t nb_bytes, uint16_t nb_bits)
+{
+    uint16_t nb_bytes_to_copy;
+
+    while (nb_bytes > 0)
+    {
+        if (rng_entropy_buffer_nb_bytes == sizeof(rng_entropy_buffer))
+        {
+            ctr_drbg_derive(rng_entropy_buffer, rng_entropy_buffer_nb_bytes, NULL, 0, rng_entropy_buffer);
+            memset((void*)&rng_entropy_buffer[CTR_DRBG_SEED_LENGTH], 0, sizeof(rng_entropy_buffer) - CTR_DRBG_SEED_LENGTH);
+            rng_entropy_buffer_nb_bytes = CTR_DRBG_SEED_LENGTH;
+            if (rng_entropy_nb_bits > CTR_DRBG_SEED_LENGTH*8)
+            {
+                rng_entropy_nb_bits = CTR_DRBG_SEED_LENGTH*8;
+            }
+        }
+
+        nb_bytes_to_copy = sizeof(rng_entropy_buffer) - rng_entropy_buffer_nb_bytes;
+        if (nb_bytes_to_copy > nb_bytes)
+        {
+            nb_bytes_to_copy = nb_bytes;
+        }
+        memcpy((void*)&rng_entropy_buffer[rng_entropy_buffer_nb_bytes], (void*)data, nb_bytes_to_copy);
+        rng_entropy_buffer_nb_bytes += nb_bytes_to_copy;
+        nb_bytes -= nb_bytes_to_copy;
+        data += nb_bytes_to_copy;
+    }
+
+    /* Never credit more than what the buffer can hold */
+    rng_entropy_nb_bits += nb_bits;
+    if (rng_entropy_nb_bits > rng_entropy_buffer_nb_bytes*8)
+    {
+        rng_entropy_nb_bits = rng_entropy_buffer_nb_bytes*8;
+    }
+}
+
+/*! \fn     rng_add_timer_jitter(uint16_t nb_bits)
+*   \brief  Add the low bytes of the cycle counter to the entropy buffer
+*   \param  nb_bits     Number of entropy bits credited
+*/
+static void rng_add_timer_jitter(uint16_t nb_bits)
+{
+    uint32_t cycle_count = timer_get_cycle_count();
+    rng_add_entropy((uint8_t*)&cycle_count, 2, nb_bits);
+}
+
+/*! \fn     rng_feed_from_acc_read(acc_single_fifo_read_t* fifo_read)
+*   \brief  Add the accelerometer samples LSBs and the read timing to the entropy buffer
+*   \param  fifo_read   Accelerometer FIFO read
+*/
+void rng_feed_from_acc_read(acc_single_fifo_read_t* fifo_read)
+{
+    uint8_t sample_lsbs[ARRAY_SIZE(fifo_read->acc_data_array)*3];
+
+    for (uint16_t i = 0; i < ARRAY_SIZE(fifo_read->acc_data_array); i++)
+    {
+        sample_lsbs[i*3+0] = (uint8_t)fifo_read->acc_data_array[i].acc_x;
+        sample_lsbs[i*3+1] = (uint8_t)fifo_read->acc_data_array[i].acc_y;
+        sample_lsbs[i*3+2] = (uint8_t)fifo_read->acc_data_array[i].acc_z;
+    }
+    rng_add_entropy(sample_lsbs, sizeof(sample_lsbs), RNG_ACC_FIFO_READ_ENTROPY_BITS);
+    rng_add_timer_jitter(RNG_TIMER_JITTER_ENTROPY_BITS);
+    memset((void*)sample_lsbs, 0, sizeof(sample_lsbs));
+}
+
+/*! \fn     rng_feed_from_adc_result(uint16_t result)
+*   \brief  Add a battery ADC conversion result to the entropy buffer
+*   \param  result      The conversion result
+*/
+void rng_feed_from_adc_result(uint16_t result)
+{
+    rng_add_entropy((uint8_t*)&result, sizeof(result), RNG_ADC_RESULT_ENTROPY_BITS);
+}
+
+/*! \fn     rng_seed_drbg_if_possible(void)
+*   \brief  Instantiate or reseed the DRBG if enough entropy was collected
+*/
+static void rng_seed_drbg_if_possible(void)
+{
+    if ((rng_drbg_instantiated == FALSE) && (rng_entropy_nb_bits >= RNG_INSTANTIATE_ENTROPY_BITS))
+    {
+        /* Chip serial number as personalization string */
+        uint32_t serial_number[4] = {*(uint32_t*)0x0080A00C, *(uint32_t*)0x0080A040, *(uint32_t*)0x0080A044, *(uint32_t*)0x0080A048};
+        ctr_drbg_instantiate(&rng_drbg_context, rng_entropy_buffer, rng_entropy_buffer_nb_bytes, (uint8_t*)serial_number, sizeof(serial_number));
+        rng_drbg_instantiated = TRUE;
+    }
+    else if ((rng_drbg_instantiated != FALSE) && (rng_drbg_context.reseed_counter > 1) && (rng_entropy_nb_bits >= RNG_RESEED_ENTROPY_BITS))
+    {
+        ctr_drbg_reseed(&rng_drbg_context, rng_entropy_buffer, rng_entropy_buffer_nb_bytes, NULL, 0);
+    }
+    else
+    {
+        return;
+    }
+
+    /* Entropy used */
+    memset((void*)rng_entropy_buffer, 0, sizeof(rng_entropy_buffer));
+    rng_entropy_buffer_nb_bytes = 0;
+    rng_entropy_nb_bits = 0;
+}
+
+/*! \fn     rng_routine(void)
+*   \brief  Collect ADC entropy until the DRBG is instantiated, (re)seed it, refill the pool
+*/
+void rng_routine(void)
+{
+    /* Battery measurements until instantiation */
+    if ((rng_drbg_instantiated == FALSE) && (platform_io_is_voledin_conversion_result_ready() != FALSE))
+    {
+        rng_feed_from_adc_result(platform_io_get_voledin_conversion_result_and_trigger_conversion());
+    }
+
+    rng_seed_drbg_if_possible();
+
+    /* Refill: fails when a reseed is required, until enough entropy is collected */
+    if ((rng_drbg_instantiated != FALSE) && (rng_pool_nb_bytes < sizeof(rng_pool)))
+    {
+        if (ctr_drbg_generate(&rng_drbg_context, &rng_pool[rng_pool_nb_bytes], sizeof(rng_pool) - rng_pool_nb_bytes, NULL, 0) == RETURN_OK)
+        {
+            rng_pool_nb_bytes = sizeof(rng_pool);
+        }
+    }
+}
+
 /*! \fn     rng_fill_array(uint8_t* array, uint16_t nb_bytes)
 *   \brief  Fill array with random numbers
 *   \param  array       Array to fill
 *   \param  nb_bytes    Number of bytes to fill
+*   \return RETURN_NOK if not enough entropy could be collected in RNG_FILL_ARRAY_TIMEOUT_MS: the array is then cleared
+*   \note   Served from the pool, only blocks to collect entropy when the pool is empty and the DRBG can't generate
+*   \note   While blocking, battery ADC results & their timing are collected as well, in case the accelerometer doesn't deliver
 */
-void rng_fill_array(uint8_t* array, uint16_t nb_bytes)
+RET_TYPE rng_fill_array(uint8_t* array, uint16_t nb_bytes)
 {
-    for (uint16_t i = 0; i < nb_bytes; i++)
+    uint32_t start_systick = timer_get_systick();
+    uint16_t nb_bytes_requested = nb_bytes;
+    uint8_t* array_start = array;
+    uint16_t nb_bytes_to_copy;
+
+    while (nb_bytes > 0)
     {
-        array[i] = 4; // Chosen by fair dice roll. Guaranteed to be random.
+        while (rng_pool_nb_bytes == 0)
+        {
+            if ((timer_get_systick() - start_systick) > RNG_FILL_ARRAY_TIMEOUT_MS)
+            {
+                memset((void*)array_start, 0, nb_bytes_requested);
+                return RETURN_NOK;
+            }
+            if (lis2hh12_check_data_received_flag_and_arm_other_transfer(&acc_descriptor) != FALSE)
+            {
+                rng_feed_from_acc_read(&acc_descriptor.fifo_read);
+            }
+            if (platform_io_is_voledin_conversion_result_ready() != FALSE)
+            {
+                rng_feed_from_adc_result(platform_io_get_voledin_conversion_result_and_trigger_conversion());
+                rng_add_timer_jitter(RNG_TIMER_JITTER_ENTROPY_BITS);
+            }
+            rng_routine();
+        }
+
+        /* Serve from the end of the available bytes, then clear them */
+        nb_bytes_to_copy = (nb_bytes < rng_pool_nb_bytes)? nb_bytes : rng_pool_nb_bytes;
+        rng_pool_nb_bytes -= nb_bytes_to_copy;
+        memcpy((void*)array, (void*)&rng_pool[rng_pool_nb_bytes], nb_bytes_to_copy);
+        memset((void*)&rng_pool[rng_pool_nb_bytes], 0, nb_bytes_to_copy);
+        array += nb_bytes_to_copy;
+        nb_bytes -= nb_bytes_to_copy;
     }
-}
\ No newline at end of file
+    return RETURN_OK;
+}
@@ -8,9 +8,31 @@
 #ifndef RNG_H_
 #define RNG_H_
 
+#include "lis2hh12.h"
+#include "defines.h"
+
+/* Defines */
+// Pre-generated random bytes
+#define RNG_POOL_SIZE                       64
+// Raw entropy buffer, conditioned down to CTR_DRBG_SEED_LENGTH bytes when full
+#define RNG_ENTROPY_BUFFER_SIZE             128
+// Entropy required to instantiate (entropy input & nonce) and reseed the DRBG
+#define RNG_INSTANTIATE_ENTROPY_BITS        384
+#define RNG_RESEED_ENTROPY_BITS             256
+// Credited entropy: accelerometer FIFO read (1 bit per x/y/z sample), battery ADC result, cycle counter at each accelerometer or ADC read
+// These are design assumptions, they were not measured on devices
+#define RNG_ACC_FIFO_READ_ENTROPY_BITS      32
+#define RNG_ADC_RESULT_ENTROPY_BITS         1
+#define RNG_TIMER_JITTER_ENTROPY_BITS       1
+// Longest rng_fill_array() wait for entropy
+#define RNG_FILL_ARRAY_TIMEOUT_MS           3000
+
 /* Prototypes */
-void rng_fill_array(uint8_t* array, uint16_t nb_bytes);
+void rng_feed_from_acc_read(acc_single_fifo_read_t* fifo_read);
+RET_TYPE rng_fill_array(uint8_t* array, uint16_t nb_bytes);
+void rng_feed_from_adc_result(uint16_t result);
+void rng_routine(void);
 
 
 
-#endif /* RNG_H_ */
\ No newline at end of file
+#endif /* RNG_H_ */
@@ -0,0 +1,181 @@
+/*!  \file     aes.c
+*    \brief    AES-256 block encryption, table based
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "defines.h"
+#include "aes.h"
+
+/* Macros */
+#define AES_ROTL8(x)            (((x) << 8) | ((x) >> 24))
+#define AES_ROTL16(x)           (((x) << 16) | ((x) >> 16))
+#define AES_ROTL24(x)           (((x) << 24) | ((x) >> 8))
+#define AES_BYTE_ROTL(x, n)     ((uint8_t)(((x) << (n)) | ((x) >> (8-(n)))))
+
+/* S-box & encryption table, generated in SRAM: flash reads go through the NVM cache, SRAM reads take the same time whatever the address */
+uint8_t aes_sbox[256];
+uint32_t aes_te0[256];
+/* Set once the tables are generated */
+BOOL aes_tables_generated = FALSE;
+
+
+/*! \fn     aes_xtime(uint8_t x)
+*   \brief  Multiply by x in GF(2^8), without branch
+*   \param  x   The value
+*   \return x times x
+*/
+static inline uint8_t aes_xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ (0x1B & (uint8_t)(-(x >> 7))));
+}
+
+/*! \fn     aes_load_word(uint8_t* buffer)
+*   \brief  Load a state column / key word, first byte in the LSB
+*   \param  buffer  The 4 bytes
+*   \return The word
+*/
+static inline uint32_t aes_load_word(uint8_t* buffer)
+{
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/*! \fn     aes_store_word(uint8_t* buffer, uint32_t word)
+*   \brief  Store a state column, LSB first
+*   \param  buffer  Where to store the 4 bytes
+*   \param  word    The word
+*/
+static inline void aes_store_word(uint8_t* buffer, uint32_t word)
+{
+    buffer[0] = (uint8_t)word;
+    buffer[1] = (uint8_t)(word >> 8);
+    buffer[2] = (uint8_t)(word >> 16);
+    buffer[3] = (uint8_t)(word >> 24);
+}
+
+/*! \fn     aes_sub_word(uint32_t word)
+*   \brief  S-box substitution of the 4 bytes of a word
+*   \param  word    The word
+*   \return The substituted word
+*/
+static inline uint32_t aes_sub_word(uint32_t word)
+{
+    return (uint32_t)aes_sbox[word & 0xFF] | ((uint32_t)aes_sbox[(word >> 8) & 0xFF] << 8) | ((uint32_t)aes_sbox[(word >> 16) & 0xFF] << 16) | ((uint32_t)aes_sbox[word >> 24] << 24);
+}
+
+/*! \fn     aes_generate_tables(void)
+*   \brief  Generate the S-box and the encryption table
+*   \note   The table holds the (2, 1, 1, 3) MixColumns column of the substituted byte, the other rows are byte rotations of it
+*/
+static void aes_generate_tables(void)
+{
+    uint8_t p = 1;
+    uint8_t q = 1;
+    uint8_t s;
+
+    /* p walks through all non zero elements with the generator 3, q is its inverse */
+    do
+    {
+        p = p ^ aes_xtime(p);
+        q ^= q << 1;
+        q ^= q << 2;
+        q ^= q << 4;
+        if ((q & 0x80) != 0)
+        {
+            q ^= 0x09;
+        }
+        aes_sbox[p] = q ^ AES_BYTE_ROTL(q, 1) ^ AES_BYTE_ROTL(q, 2) ^ AES_BYTE_ROTL(q, 3) ^ AES_BYTE_ROTL(q, 4) ^ 0x63;
+    } while (p != 1);
+    aes_sbox[0] = 0x63;
+
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        s = aes_sbox[i];
+        aes_te0[i] = (uint32_t)aes_xtime(s) | ((uint32_t)s << 8) | ((uint32_t)s << 16) | ((uint32_t)(aes_xtime(s) ^ s) << 24);
+    }
+    aes_tables_generated = TRUE;
+}
+
+/*! \fn     aes256_init_context(aes256_context_t* context, uint8_t* key)
+*   \brief  Expand an AES-256 key
+*   \param  context Context to initialize
+*   \param  key     32 bytes key
+*/
+void aes256_init_context(aes256_context_t* context, uint8_t* key)
+{
+    uint32_t* round_keys = context->round_keys;
+    uint8_t rcon = 0x01;
+    uint32_t temp;
+
+    /* Tables are only generated once */
+    if (aes_tables_generated == FALSE)
+    {
+        aes_generate_tables();
+    }
+
+    for (uint16_t i = 0; i < AES_KEY_LENGTH/32; i++)
+    {
+        round_keys[i] = aes_load_word(&key[4*i]);
+    }
+    for (uint16_t i = AES_KEY_LENGTH/32; i < AES256_NB_ROUND_KEYS; i++)
+    {
+        temp = round_keys[i-1];
+        if ((i % (AES_KEY_LENGTH/32)) == 0)
+        {
+            temp = aes_sub_word(AES_ROTL24(temp)) ^ rcon;
+            rcon = aes_xtime(rcon);
+        }
+        else if ((i % (AES_KEY_LENGTH/32)) == 4)
+        {
+            temp = aes_sub_word(temp);
+        }
+        round_keys[i] = round_keys[i-(AES_KEY_LENGTH/32)] ^ temp;
+    }
+}
+
+/*! \fn     aes256_clear_context(aes256_context_t* context)
+*   \brief  Clear the round keys
+*   \param  context The context
+*/
+void aes256_clear_context(aes256_context_t* context)
+{
+    memset((void*)context, 0, sizeof(*context));
+}
+
+/*! \fn     aes256_encrypt_block(aes256_context_t* context, uint8_t* input, uint8_t* output)
+*   \brief  Encrypt a 16 bytes block
+*   \param  context Initialized context
+*   \param  input   Plain block
+*   \param  output  Encrypted block, can be the input
+*   \note   No branch or table index depends on anything else than the data: the Cortex-M0+ has no data cache and the tables are in SRAM
+*/
+void aes256_encrypt_block(aes256_context_t* context, uint8_t* input, uint8_t* output)
+{
+    uint32_t* round_keys = context->round_keys;
+    uint32_t s0, s1, s2, s3;
+    uint32_t t0, t1, t2, t3;
+
+    /* Initial round key */
+    s0 = aes_load_word(&input[0]) ^ round_keys[0];
+    s1 = aes_load_word(&input[4]) ^ round_keys[1];
+    s2 = aes_load_word(&input[8]) ^ round_keys[2];
+    s3 = aes_load_word(&input[12]) ^ round_keys[3];
+    round_keys += 4;
+
+    /* SubBytes, ShiftRows, MixColumns & AddRoundKey: column c takes row r from column c+r */
+    for (uint16_t round = 1; round < AES256_NB_ROUNDS; round++)
+    {
+        t0 = aes_te0[s0 & 0xFF] ^ AES_ROTL8(aes_te0[(s1 >> 8) & 0xFF]) ^ AES_ROTL16(aes_te0[(s2 >> 16) & 0xFF]) ^ AES_ROTL24(aes_te0[s3 >> 24]) ^ round_keys[0];
+        t1 = aes_te0[s1 & 0xFF] ^ AES_ROTL8(aes_te0[(s2 >> 8) & 0xFF]) ^ AES_ROTL16(aes_te0[(s3 >> 16) & 0xFF]) ^ AES_ROTL24(aes_te0[s0 >> 24]) ^ round_keys[1];
+        t2 = aes_te0[s2 & 0xFF] ^ AES_ROTL8(aes_te0[(s3 >> 8) & 0xFF]) ^ AES_ROTL16(aes_te0[(s0 >> 16) & 0xFF]) ^ AES_ROTL24(aes_te0[s1 >> 24]) ^ round_keys[2];
+        t3 = aes_te0[s3 & 0xFF] ^ AES_ROTL8(aes_te0[(s0 >> 8) & 0xFF]) ^ AES_ROTL16(aes_te0[(s1 >> 16) & 0xFF]) ^ AES_ROTL24(aes_te0[s2 >> 24]) ^ round_keys[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+        round_keys += 4;
+    }
+
+    /* Last round: no MixColumns */
+    aes_store_word(&output[0], ((uint32_t)aes_sbox[s0 & 0xFF] | ((uint32_t)aes_sbox[(s1 >> 8) & 0xFF] << 8) | ((uint32_t)aes_sbox[(s2 >> 16) & 0xFF] << 16) | ((uint32_t)aes_sbox[s3 >> 24] << 24)) ^ round_keys[0]);
+    aes_store_word(&output[4], ((uint32_t)aes_sbox[s1 & 0xFF] | ((uint32_t)aes_sbox[(s2 >> 8) & 0xFF] << 8) | ((uint32_t)aes_sbox[(s3 >> 16) & 0xFF] << 16) | ((uint32_t)aes_sbox[s0 >> 24] << 24)) ^ round_keys[1]);
+    aes_store_word(&output[8], ((uint32_t)aes_sbox[s2 & 0xFF] | ((uint32_t)aes_sbox[(s3 >> 8) & 0xFF] << 8) | ((uint32_t)aes_sbox[(s0 >> 16) & 0xFF] << 16) | ((uint32_t)aes_sbox[s1 >> 24] << 24)) ^ round_keys[2]);
+    aes_store_word(&output[12], ((uint32_t)aes_sbox[s3 & 0xFF] | ((uint32_t)aes_sbox[(s0 >> 8) & 0xFF] << 8) | ((uint32_t)aes_sbox[(s1 >> 16) & 0xFF] << 16) | ((uint32_t)aes_sbox[s2 >> 24] << 24)) ^ round_keys[3]);
+}
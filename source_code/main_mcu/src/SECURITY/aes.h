@@ -0,0 +1,27 @@
+/*!  \file     aes.h
+*    \brief    AES-256 block encryption, table based
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef AES_H_
+#define AES_H_
+
+#include "defines.h"
+
+/* Defines */
+#define AES256_NB_ROUNDS        14
+#define AES256_NB_ROUND_KEYS    (4*(AES256_NB_ROUNDS+1))
+
+/* Typedefs */
+typedef struct
+{
+    uint32_t round_keys[AES256_NB_ROUND_KEYS];
+} aes256_context_t;
+
+/* Prototypes */
+void aes256_encrypt_block(aes256_context_t* context, uint8_t* input, uint8_t* output);
+void aes256_init_context(aes256_context_t* context, uint8_t* key);
+void aes256_clear_context(aes256_context_t* context);
+
+
+#endif /* AES_H_ */
@@ -0,0 +1,116 @@
+/*!  \file     aes256_ctr.c
+*    \brief    AES-256 CTR mode
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "aes256_ctr.h"
+#include "defines.h"
+#include "aes.h"
+
+
+/*! \fn     aes256_ctr_init_context(aes256_ctr_context_t* context, uint8_t* key, uint8_t* nonce)
+*   \brief  Initialize a CTR context
+*   \param  context Context to initialize
+*   \param  key     32 bytes key
+*   \param  nonce   16 bytes nonce: the counter block of block index 0
+*/
+void aes256_ctr_init_context(aes256_ctr_context_t* context, uint8_t* key, uint8_t* nonce)
+{
+    aes256_init_context(&context->aes_context, key);
+    memcpy((void*)context->nonce, (void*)nonce, sizeof(context->nonce));
+}
+
+/*! \fn     aes256_ctr_clear_context(aes256_ctr_context_t* context)
+*   \brief  Clear a CTR context
+*   \param  context The context
+*/
+void aes256_ctr_clear_context(aes256_ctr_context_t* context)
+{
+    memset((void*)context, 0, sizeof(*context));
+}
+
+/*! \fn     aes256_ctr_generate_keystream(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* keystream, uint16_t length)
+*   \brief  Generate keystream bytes, before the data to encrypt / decrypt is available
+*   \param  context     Initialized context
+*   \param  block_index Index of the first block: its counter block is the nonce plus this index, big endian
+*   \param  keystream   Where to store the keystream
+*   \param  length      Number of bytes
+*/
+void aes256_ctr_generate_keystream(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* keystream, uint16_t length)
+{
+    uint8_t counter_block[AES256_CTR_LENGTH/8];
+    uint8_t block[AES_BLOCK_SIZE/8];
+    uint16_t carry = 0;
+
+    /* Counter block: nonce + block index */
+    for (int16_t i = sizeof(counter_block)-1; i >= 0; i--)
+    {
+        carry += context->nonce[i];
+        if (i >= (int16_t)(sizeof(counter_block)-sizeof(block_index)))
+        {
+            carry += (uint8_t)(block_index >> (8*(sizeof(counter_block)-1-i)));
+        }
+        counter_block[i] = (uint8_t)carry;
+        carry >>= 8;
+    }
+
+    while (length != 0)
+    {
+        uint16_t nb_bytes = (length < sizeof(block))? length : sizeof(block);
+
+        /* Encrypt counter block, keep the needed bytes */
+        aes256_encrypt_block(&context->aes_context, counter_block, block);
+        memcpy((void*)keystream, (void*)block, nb_bytes);
+        keystream += nb_bytes;
+        length -= nb_bytes;
+
+        /* Increment counter block */
+        for (int16_t i = sizeof(counter_block)-1; i >= 0; i--)
+        {
+            if (++counter_block[i] != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    memset((void*)block, 0, sizeof(block));
+}
+
+/*! \fn     aes256_ctr_xor_keystream(uint8_t* data, uint8_t* keystream, uint16_t length)
+*   \brief  XOR data with keystream bytes
+*   \param  data        Data to encrypt / decrypt in place
+*   \param  keystream   Keystream
+*   \param  length      Number of bytes
+*/
+void aes256_ctr_xor_keystream(uint8_t* data, uint8_t* keystream, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        data[i] ^= keystream[i];
+    }
+}
+
+/*! \fn     aes256_ctr_crypt(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* data, uint16_t length)
+*   \brief  Encrypt or decrypt data in place
+*   \param  context     Initialized context
+*   \param  block_index Index of the first block
+*   \param  data        Data
+*   \param  length      Number of bytes
+*/
+void aes256_ctr_crypt(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* data, uint16_t length)
+{
+    uint8_t keystream[AES_BLOCK_SIZE/8];
+
+    while (length != 0)
+    {
+        uint16_t nb_bytes = (length < sizeof(keystream))? length : sizeof(keystream);
+        aes256_ctr_generate_keystream(context, block_index++, keystream, nb_bytes);
+        aes256_ctr_xor_keystream(data, keystream, nb_bytes);
+        data += nb_bytes;
+        length -= nb_bytes;
+    }
+
+    memset((void*)keystream, 0, sizeof(keystream));
+}
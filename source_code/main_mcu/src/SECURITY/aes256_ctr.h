@@ -0,0 +1,27 @@
+/*!  \file     aes256_ctr.h
+*    \brief    AES-256 CTR mode
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef AES256_CTR_H_
+#define AES256_CTR_H_
+
+#include "defines.h"
+#include "aes.h"
+
+/* Typedefs */
+typedef struct
+{
+    aes256_context_t aes_context;
+    uint8_t nonce[AES256_CTR_LENGTH/8];
+} aes256_ctr_context_t;
+
+/* Prototypes */
+void aes256_ctr_generate_keystream(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* keystream, uint16_t length);
+void aes256_ctr_crypt(aes256_ctr_context_t* context, uint32_t block_index, uint8_t* data, uint16_t length);
+void aes256_ctr_init_context(aes256_ctr_context_t* context, uint8_t* key, uint8_t* nonce);
+void aes256_ctr_xor_keystream(uint8_t* data, uint8_t* keystream, uint16_t length);
+void aes256_ctr_clear_context(aes256_ctr_context_t* context);
+
+
+#endif /* AES256_CTR_H_ */
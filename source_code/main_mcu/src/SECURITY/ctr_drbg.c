@@ -0,0 +1,239 @@
+/*!  \file     ctr_drbg.c
+*    \brief    NIST SP800-90A CTR_DRBG, AES-256 with derivation function
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "ctr_drbg.h"
+#include "defines.h"
+#include "aes.h"
+
+
+/*! \fn     ctr_drbg_increment_v(uint8_t* v)
+*   \brief  Increment the 128-bit big endian V
+*   \param  v   The V block
+*/
+static inline void ctr_drbg_increment_v(uint8_t* v)
+{
+    for (int16_t i = CTR_DRBG_BLOCK_LENGTH-1; i >= 0; i--)
+    {
+        if (++v[i] != 0)
+        {
+            break;
+        }
+    }
+}
+
+/*! \fn     ctr_drbg_get_df_input_byte(uint16_t position, uint8_t* input1, uint16_t length1, uint8_t* input2, uint16_t length2)
+*   \brief  Get a byte of the derivation function input: L || N || input1 || input2 || 0x80 || 0x00 padding
+*   \param  position    Byte position
+*   \param  input1      First input
+*   \param  length1     First input length
+*   \param  input2      Second input
+*   \param  length2     Second input length
+*   \return The byte
+*/
+static inline uint8_t ctr_drbg_get_df_input_byte(uint16_t position, uint8_t* input1, uint16_t length1, uint8_t* input2, uint16_t length2)
+{
+    uint32_t input_length = (uint32_t)length1 + length2;
+
+    if (position < 4)
+    {
+        return (uint8_t)(input_length >> (8*(3-position)));
+    }
+    else if (position < 8)
+    {
+        return (position == 7)? CTR_DRBG_SEED_LENGTH : 0;
+    }
+    position -= 8;
+    if (position < length1)
+    {
+        return input1[position];
+    }
+    position -= length1;
+    if (position < length2)
+    {
+        return input2[position];
+    }
+    return (position == length2)? 0x80 : 0x00;
+}
+
+/*! \fn     ctr_drbg_derive(uint8_t* input1, uint16_t length1, uint8_t* input2, uint16_t length2, uint8_t* output)
+*   \brief  Block_Cipher_df: derive seed material from the concatenation of two inputs
+*   \param  input1      First input
+*   \param  length1     First input length
+*   \param  input2      Second input, can be NULL if length2 is 0
+*   \param  length2     Second input length
+*   \param  output      Where to store the CTR_DRBG_SEED_LENGTH bytes, can be input1
+*   \note   Also used to condition raw entropy: the output holds up to 8*CTR_DRBG_SEED_LENGTH bits of the input entropy
+*/
+void ctr_drbg_derive(uint8_t* input1, uint16_t length1, uint8_t* input2, uint16_t length2, uint8_t* output)
+{
+    uint16_t padded_length = ((8 + length1 + length2 + 1 + CTR_DRBG_BLOCK_LENGTH - 1) / CTR_DRBG_BLOCK_LENGTH) * CTR_DRBG_BLOCK_LENGTH;
+    uint8_t temp[CTR_DRBG_SEED_LENGTH];
+    aes256_context_t df_context;
+    uint8_t* chaining;
+    uint8_t* x;
+
+    /* Fixed key: 0x00 0x01 ... 0x1F */
+    for (uint16_t i = 0; i < CTR_DRBG_KEY_LENGTH; i++)
+    {
+        temp[i] = (uint8_t)i;
+    }
+    aes256_init_context(&df_context, temp);
+
+    /* BCC of IV || S, the IV holding the 32-bit block index */
+    for (uint16_t i = 0; i < CTR_DRBG_SEED_LENGTH/CTR_DRBG_BLOCK_LENGTH; i++)
+    {
+        chaining = &temp[i*CTR_DRBG_BLOCK_LENGTH];
+        memset((void*)chaining, 0, CTR_DRBG_BLOCK_LENGTH);
+        chaining[3] = (uint8_t)i;
+        aes256_encrypt_block(&df_context, chaining, chaining);
+        for (uint16_t j = 0; j < padded_length; j++)
+        {
+            chaining[j % CTR_DRBG_BLOCK_LENGTH] ^= ctr_drbg_get_df_input_byte(j, input1, length1, input2, length2);
+            if ((j % CTR_DRBG_BLOCK_LENGTH) == (CTR_DRBG_BLOCK_LENGTH-1))
+            {
+                aes256_encrypt_block(&df_context, chaining, chaining);
+            }
+        }
+    }
+
+    /* Encrypt X with the derived key */
+    aes256_init_context(&df_context, temp);
+    x = &temp[CTR_DRBG_KEY_LENGTH];
+    for (uint16_t i = 0; i < CTR_DRBG_SEED_LENGTH; i += CTR_DRBG_BLOCK_LENGTH)
+    {
+        aes256_encrypt_block(&df_context, x, &output[i]);
+        x = &output[i];
+    }
+
+    memset((void*)temp, 0, sizeof(temp));
+    aes256_clear_context(&df_context);
+}
+
+/*! \fn     ctr_drbg_update(ctr_drbg_context_t* context, uint8_t* provided_data)
+*   \brief  CTR_DRBG_Update: new key & V
+*   \param  context         The context
+*   \param  provided_data   CTR_DRBG_SEED_LENGTH bytes
+*/
+static void ctr_drbg_update(ctr_drbg_context_t* context, uint8_t* provided_data)
+{
+    uint8_t temp[CTR_DRBG_SEED_LENGTH];
+
+    for (uint16_t i = 0; i < CTR_DRBG_SEED_LENGTH; i += CTR_DRBG_BLOCK_LENGTH)
+    {
+        ctr_drbg_increment_v(context->v);
+        aes256_encrypt_block(&context->aes_context, context->v, &temp[i]);
+    }
+    for (uint16_t i = 0; i < CTR_DRBG_SEED_LENGTH; i++)
+    {
+        temp[i] ^= provided_data[i];
+    }
+    aes256_init_context(&context->aes_context, temp);
+    memcpy((void*)context->v, (void*)&temp[CTR_DRBG_KEY_LENGTH], CTR_DRBG_BLOCK_LENGTH);
+    memset((void*)temp, 0, sizeof(temp));
+}
+
+/*! \fn     ctr_drbg_instantiate(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* personalization, uint16_t personalization_length)
+*   \brief  Instantiate the DRBG
+*   \param  context                 Context to instantiate
+*   \param  entropy                 Entropy input, followed by the nonce
+*   \param  entropy_length          Entropy input & nonce length
+*   \param  personalization         Personalization string, can be NULL if personalization_length is 0
+*   \param  personalization_length  Personalization string length
+*/
+void ctr_drbg_instantiate(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* personalization, uint16_t personalization_length)
+{
+    uint8_t seed_material[CTR_DRBG_SEED_LENGTH];
+    uint8_t zero_key[CTR_DRBG_KEY_LENGTH];
+
+    ctr_drbg_derive(entropy, entropy_length, personalization, personalization_length, seed_material);
+
+    /* Key & V set to 0 */
+    memset((void*)zero_key, 0, sizeof(zero_key));
+    memset((void*)context, 0, sizeof(*context));
+    aes256_init_context(&context->aes_context, zero_key);
+    ctr_drbg_update(context, seed_material);
+    context->reseed_counter = 1;
+    memset((void*)seed_material, 0, sizeof(seed_material));
+}
+
+/*! \fn     ctr_drbg_reseed(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* additional, uint16_t additional_length)
+*   \brief  Reseed the DRBG
+*   \param  context             Instantiated context
+*   \param  entropy             Entropy input
+*   \param  entropy_length      Entropy input length
+*   \param  additional          Additional input, can be NULL if additional_length is 0
+*   \param  additional_length   Additional input length
+*/
+void ctr_drbg_reseed(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* additional, uint16_t additional_length)
+{
+    uint8_t seed_material[CTR_DRBG_SEED_LENGTH];
+
+    ctr_drbg_derive(entropy, entropy_length, additional, additional_length, seed_material);
+    ctr_drbg_update(context, seed_material);
+    context->reseed_counter = 1;
+    memset((void*)seed_material, 0, sizeof(seed_material));
+}
+
+/*! \fn     ctr_drbg_generate(ctr_drbg_context_t* context, uint8_t* output, uint32_t length, uint8_t* additional, uint16_t additional_length)
+*   \brief  Generate random bytes
+*   \param  context             Instantiated context
+*   \param  output              Where to store the bytes
+*   \param  length              Number of bytes, up to CTR_DRBG_MAX_REQUEST_LENGTH
+*   \param  additional          Additional input, can be NULL if additional_length is 0
+*   \param  additional_length   Additional input length
+*   \return RETURN_NOK if a reseed is required
+*/
+RET_TYPE ctr_drbg_generate(ctr_drbg_context_t* context, uint8_t* output, uint32_t length, uint8_t* additional, uint16_t additional_length)
+{
+    uint8_t additional_seed[CTR_DRBG_SEED_LENGTH];
+    uint8_t block[CTR_DRBG_BLOCK_LENGTH];
+
+    if ((context->reseed_counter > CTR_DRBG_RESEED_INTERVAL) || (length > CTR_DRBG_MAX_REQUEST_LENGTH))
+    {
+        return RETURN_NOK;
+    }
+
+    /* Additional input: derived, then used for both updates */
+    memset((void*)additional_seed, 0, sizeof(additional_seed));
+    if (additional_length != 0)
+    {
+        ctr_drbg_derive(additional, additional_length, NULL, 0, additional_seed);
+        ctr_drbg_update(context, additional_seed);
+    }
+
+    while (length > 0)
+    {
+        ctr_drbg_increment_v(context->v);
+        if (length >= CTR_DRBG_BLOCK_LENGTH)
+        {
+            aes256_encrypt_block(&context->aes_context, context->v, output);
+            output += CTR_DRBG_BLOCK_LENGTH;
+            length -= CTR_DRBG_BLOCK_LENGTH;
+        }
+        else
+        {
+            aes256_encrypt_block(&context->aes_context, context->v, block);
+            memcpy((void*)output, (void*)block, length);
+            length = 0;
+        }
+    }
+
+    /* Backtracking resistance */
+    ctr_drbg_update(context, additional_seed);
+    context->reseed_counter++;
+    memset((void*)block, 0, sizeof(block));
+    memset((void*)additional_seed, 0, sizeof(additional_seed));
+    return RETURN_OK;
+}
+
+/*! \fn     ctr_drbg_clear_context(ctr_drbg_context_t* context)
+*   \brief  Clear the DRBG state
+*   \param  context The context
+*/
+void ctr_drbg_clear_context(ctr_drbg_context_t* context)
+{
+    memset((void*)context, 0, sizeof(*context));
+}
@@ -0,0 +1,37 @@
+/*!  \file     ctr_drbg.h
+*    \brief    NIST SP800-90A CTR_DRBG, AES-256 with derivation function
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef CTR_DRBG_H_
+#define CTR_DRBG_H_
+
+#include "defines.h"
+#include "aes.h"
+
+/* Defines */
+#define CTR_DRBG_KEY_LENGTH                 (AES_KEY_LENGTH/8)
+#define CTR_DRBG_BLOCK_LENGTH               (AES_BLOCK_SIZE/8)
+#define CTR_DRBG_SEED_LENGTH                (CTR_DRBG_KEY_LENGTH + CTR_DRBG_BLOCK_LENGTH)
+// Generate requests allowed before a reseed is required (SP800-90A allows up to 2^48)
+#define CTR_DRBG_RESEED_INTERVAL            (1UL << 20)
+// Max number of bytes per generate request (SP800-90A allows up to 2^16)
+#define CTR_DRBG_MAX_REQUEST_LENGTH         (1UL << 16)
+
+/* Typedefs */
+typedef struct
+{
+    aes256_context_t aes_context;
+    uint8_t v[CTR_DRBG_BLOCK_LENGTH];
+    uint32_t reseed_counter;
+} ctr_drbg_context_t;
+
+/* Prototypes */
+void ctr_drbg_instantiate(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* personalization, uint16_t personalization_length);
+RET_TYPE ctr_drbg_generate(ctr_drbg_context_t* context, uint8_t* output, uint32_t length, uint8_t* additional, uint16_t additional_length);
+void ctr_drbg_reseed(ctr_drbg_context_t* context, uint8_t* entropy, uint16_t entropy_length, uint8_t* additional, uint16_t additional_length);
+void ctr_drbg_derive(uint8_t* input1, uint16_t length1, uint8_t* input2, uint16_t length2, uint8_t* output);
+void ctr_drbg_clear_context(ctr_drbg_context_t* context);
+
+
+#endif /* CTR_DRBG_H_ */
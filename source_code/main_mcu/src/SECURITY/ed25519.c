@@ -0,0 +1,495 @@
+/*!  \file     ed25519.c
+*    \brief    Ed25519 signature verification
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*    \note     Field & group arithmetic follows TweetNaCl (public domain): slow but compact, only used at boot and before updates
+*/
+#include <string.h>
+#include "defines.h"
+#include "ed25519.h"
+#include "sha512.h"
+
+/* Curve constants: d, 2*d, base point x & y, sqrt(-1) */
+const ed25519_fe_t ed25519_d = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070, 0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203};
+const ed25519_fe_t ed25519_d2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0, 0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406};
+const ed25519_fe_t ed25519_base_x = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169};
+const ed25519_fe_t ed25519_base_y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666};
+const ed25519_fe_t ed25519_sqrtm1 = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+/* Group order, little endian */
+const uint8_t ed25519_l[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10};
+
+
+/*! \fn     ed25519_fe_set(ed25519_fe_t r, const ed25519_fe_t a)
+*   \brief  Copy a field element
+*/
+static void ed25519_fe_set(ed25519_fe_t r, const ed25519_fe_t a)
+{
+    memcpy((void*)r, (void*)a, sizeof(ed25519_fe_t));
+}
+
+/*! \fn     ed25519_fe_set_small(ed25519_fe_t r, int64_t value)
+*   \brief  Set a field element to a small value
+*/
+static void ed25519_fe_set_small(ed25519_fe_t r, int64_t value)
+{
+    memset((void*)r, 0, sizeof(ed25519_fe_t));
+    r[0] = value;
+}
+
+/*! \fn     ed25519_fe_carry(ed25519_fe_t o)
+*   \brief  Carry propagation, the top carry being folded back times 38
+*/
+static void ed25519_fe_carry(ed25519_fe_t o)
+{
+    int64_t c;
+
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        o[i] += (1LL << 16);
+        c = o[i] >> 16;
+        if (i < 15)
+        {
+            o[i+1] += c - 1;
+        }
+        else
+        {
+            o[0] += 38 * (c - 1);
+        }
+        o[i] -= c * 65536;
+    }
+}
+
+/*! \fn     ed25519_fe_select(ed25519_fe_t p, ed25519_fe_t q, uint8_t swap)
+*   \brief  Constant time swap of two field elements when swap is 1
+*/
+static void ed25519_fe_select(ed25519_fe_t p, ed25519_fe_t q, uint8_t swap)
+{
+    int64_t mask = -(int64_t)swap;
+    int64_t t;
+
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+/*! \fn     ed25519_fe_pack(uint8_t* o, const ed25519_fe_t n)
+*   \brief  Fully reduce and store a field element as 32 little endian bytes
+*/
+static void ed25519_fe_pack(uint8_t* o, const ed25519_fe_t n)
+{
+    ed25519_fe_t m, t;
+    uint8_t borrow;
+
+    ed25519_fe_set(t, n);
+    ed25519_fe_carry(t);
+    ed25519_fe_carry(t);
+    ed25519_fe_carry(t);
+
+    /* Subtract p twice if no borrow */
+    for (uint16_t j = 0; j < 2; j++)
+    {
+        m[0] = t[0] - 0xffed;
+        for (uint16_t i = 1; i < 15; i++)
+        {
+            m[i] = t[i] - 0xffff - ((m[i-1] >> 16) & 1);
+            m[i-1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        borrow = (uint8_t)((m[15] >> 16) & 1);
+        m[14] &= 0xffff;
+        ed25519_fe_select(t, m, 1 - borrow);
+    }
+
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        o[2*i] = (uint8_t)t[i];
+        o[2*i+1] = (uint8_t)(t[i] >> 8);
+    }
+}
+
+/*! \fn     ed25519_bytes_differ(const uint8_t* a, const uint8_t* b)
+*   \brief  Constant time comparison of 32 bytes
+*   \return TRUE if they differ
+*/
+static BOOL ed25519_bytes_differ(const uint8_t* a, const uint8_t* b)
+{
+    uint8_t difference = 0;
+
+    for (uint16_t i = 0; i < 32; i++)
+    {
+        difference |= a[i] ^ b[i];
+    }
+    return (difference != 0)? TRUE : FALSE;
+}
+
+/*! \fn     ed25519_fe_differ(const ed25519_fe_t a, const ed25519_fe_t b)
+*   \brief  Compare two field elements
+*   \return TRUE if they differ
+*/
+static BOOL ed25519_fe_differ(const ed25519_fe_t a, const ed25519_fe_t b)
+{
+    uint8_t packed_a[32], packed_b[32];
+
+    ed25519_fe_pack(packed_a, a);
+    ed25519_fe_pack(packed_b, b);
+    return ed25519_bytes_differ(packed_a, packed_b);
+}
+
+/*! \fn     ed25519_fe_parity(const ed25519_fe_t a)
+*   \brief  Parity of the fully reduced field element
+*/
+static uint8_t ed25519_fe_parity(const ed25519_fe_t a)
+{
+    uint8_t packed[32];
+
+    ed25519_fe_pack(packed, a);
+    return packed[0] & 1;
+}
+
+/*! \fn     ed25519_fe_unpack(ed25519_fe_t o, const uint8_t* n)
+*   \brief  Load a field element from 32 little endian bytes, ignoring the top bit
+*/
+static void ed25519_fe_unpack(ed25519_fe_t o, const uint8_t* n)
+{
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        o[i] = n[2*i] + ((int64_t)n[2*i+1] << 8);
+    }
+    o[15] &= 0x7fff;
+}
+
+/*! \fn     ed25519_fe_add(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+*   \brief  o = a + b, without carry
+*/
+static void ed25519_fe_add(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+{
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        o[i] = a[i] + b[i];
+    }
+}
+
+/*! \fn     ed25519_fe_sub(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+*   \brief  o = a - b, without carry
+*/
+static void ed25519_fe_sub(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+{
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        o[i] = a[i] - b[i];
+    }
+}
+
+/*! \fn     ed25519_fe_mul(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+*   \brief  o = a * b, o can be a or b
+*/
+static void ed25519_fe_mul(ed25519_fe_t o, const ed25519_fe_t a, const ed25519_fe_t b)
+{
+    int64_t t[31];
+
+    memset((void*)t, 0, sizeof(t));
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        for (uint16_t j = 0; j < 16; j++)
+        {
+            t[i+j] += a[i] * b[j];
+        }
+    }
+    /* 2^256 = 38 mod p */
+    for (uint16_t i = 0; i < 15; i++)
+    {
+        t[i] += 38 * t[i+16];
+    }
+    memcpy((void*)o, (void*)t, sizeof(ed25519_fe_t));
+    ed25519_fe_carry(o);
+    ed25519_fe_carry(o);
+}
+
+/*! \fn     ed25519_fe_invert(ed25519_fe_t o, const ed25519_fe_t a)
+*   \brief  o = a^(p-2) = 1/a
+*/
+static void ed25519_fe_invert(ed25519_fe_t o, const ed25519_fe_t a)
+{
+    ed25519_fe_t c;
+
+    ed25519_fe_set(c, a);
+    for (int16_t i = 253; i >= 0; i--)
+    {
+        ed25519_fe_mul(c, c, c);
+        if ((i != 2) && (i != 4))
+        {
+            ed25519_fe_mul(c, c, a);
+        }
+    }
+    ed25519_fe_set(o, c);
+}
+
+/*! \fn     ed25519_fe_pow2523(ed25519_fe_t o, const ed25519_fe_t a)
+*   \brief  o = a^((p-5)/8), for the square root
+*/
+static void ed25519_fe_pow2523(ed25519_fe_t o, const ed25519_fe_t a)
+{
+    ed25519_fe_t c;
+
+    ed25519_fe_set(c, a);
+    for (int16_t i = 250; i >= 0; i--)
+    {
+        ed25519_fe_mul(c, c, c);
+        if (i != 1)
+        {
+            ed25519_fe_mul(c, c, a);
+        }
+    }
+    ed25519_fe_set(o, c);
+}
+
+/*! \fn     ed25519_point_add(ed25519_fe_t p[4], ed25519_fe_t q[4])
+*   \brief  p = p + q, extended coordinates
+*/
+static void ed25519_point_add(ed25519_fe_t p[4], ed25519_fe_t q[4])
+{
+    ed25519_fe_t a, b, c, d, t, e, f, g, h;
+
+    ed25519_fe_sub(a, p[1], p[0]);
+    ed25519_fe_sub(t, q[1], q[0]);
+    ed25519_fe_mul(a, a, t);
+    ed25519_fe_add(b, p[0], p[1]);
+    ed25519_fe_add(t, q[0], q[1]);
+    ed25519_fe_mul(b, b, t);
+    ed25519_fe_mul(c, p[3], q[3]);
+    ed25519_fe_mul(c, c, ed25519_d2);
+    ed25519_fe_mul(d, p[2], q[2]);
+    ed25519_fe_add(d, d, d);
+    ed25519_fe_sub(e, b, a);
+    ed25519_fe_sub(f, d, c);
+    ed25519_fe_add(g, d, c);
+    ed25519_fe_add(h, b, a);
+
+    ed25519_fe_mul(p[0], e, f);
+    ed25519_fe_mul(p[1], h, g);
+    ed25519_fe_mul(p[2], g, f);
+    ed25519_fe_mul(p[3], e, h);
+}
+
+/*! \fn     ed25519_point_select(ed25519_fe_t p[4], ed25519_fe_t q[4], uint8_t swap)
+*   \brief  Constant time swap of two points when swap is 1
+*/
+static void ed25519_point_select(ed25519_fe_t p[4], ed25519_fe_t q[4], uint8_t swap)
+{
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        ed25519_fe_select(p[i], q[i], swap);
+    }
+}
+
+/*! \fn     ed25519_point_pack(uint8_t* r, ed25519_fe_t p[4])
+*   \brief  Encode a point: y, with the x parity in the top bit
+*/
+static void ed25519_point_pack(uint8_t* r, ed25519_fe_t p[4])
+{
+    ed25519_fe_t tx, ty, zi;
+
+    ed25519_fe_invert(zi, p[2]);
+    ed25519_fe_mul(tx, p[0], zi);
+    ed25519_fe_mul(ty, p[1], zi);
+    ed25519_fe_pack(r, ty);
+    r[31] ^= ed25519_fe_parity(tx) << 7;
+}
+
+/*! \fn     ed25519_point_scalarmult(ed25519_fe_t p[4], ed25519_fe_t q[4], const uint8_t* s)
+*   \brief  p = s * q, q being modified
+*/
+static void ed25519_point_scalarmult(ed25519_fe_t p[4], ed25519_fe_t q[4], const uint8_t* s)
+{
+    uint8_t bit;
+
+    /* Neutral element */
+    ed25519_fe_set_small(p[0], 0);
+    ed25519_fe_set_small(p[1], 1);
+    ed25519_fe_set_small(p[2], 1);
+    ed25519_fe_set_small(p[3], 0);
+
+    for (int16_t i = 255; i >= 0; i--)
+    {
+        bit = (s[i/8] >> (i & 7)) & 1;
+        ed25519_point_select(p, q, bit);
+        ed25519_point_add(q, p);
+        ed25519_point_add(p, p);
+        ed25519_point_select(p, q, bit);
+    }
+}
+
+/*! \fn     ed25519_point_scalarmult_base(ed25519_fe_t p[4], const uint8_t* s)
+*   \brief  p = s * B
+*/
+static void ed25519_point_scalarmult_base(ed25519_fe_t p[4], const uint8_t* s)
+{
+    ed25519_fe_t q[4];
+
+    ed25519_fe_set(q[0], ed25519_base_x);
+    ed25519_fe_set(q[1], ed25519_base_y);
+    ed25519_fe_set_small(q[2], 1);
+    ed25519_fe_mul(q[3], ed25519_base_x, ed25519_base_y);
+    ed25519_point_scalarmult(p, q, s);
+}
+
+/*! \fn     ed25519_point_unpack_negated(ed25519_fe_t r[4], const uint8_t* packed)
+*   \brief  Decode a point and negate it
+*   \return RETURN_NOK if the encoding isn't a curve point
+*/
+static RET_TYPE ed25519_point_unpack_negated(ed25519_fe_t r[4], const uint8_t* packed)
+{
+    ed25519_fe_t t, chk, num, den, den2, den4, den6, zero;
+
+    ed25519_fe_set_small(zero, 0);
+    ed25519_fe_set_small(r[2], 1);
+    ed25519_fe_unpack(r[1], packed);
+
+    /* x^2 = (y^2 - 1) / (d*y^2 + 1) */
+    ed25519_fe_mul(num, r[1], r[1]);
+    ed25519_fe_mul(den, num, ed25519_d);
+    ed25519_fe_sub(num, num, r[2]);
+    ed25519_fe_add(den, r[2], den);
+
+    /* x = num * den^3 * (num * den^7)^((p-5)/8) */
+    ed25519_fe_mul(den2, den, den);
+    ed25519_fe_mul(den4, den2, den2);
+    ed25519_fe_mul(den6, den4, den2);
+    ed25519_fe_mul(t, den6, num);
+    ed25519_fe_mul(t, t, den);
+    ed25519_fe_pow2523(t, t);
+    ed25519_fe_mul(t, t, num);
+    ed25519_fe_mul(t, t, den);
+    ed25519_fe_mul(t, t, den);
+    ed25519_fe_mul(r[0], t, den);
+
+    /* Fix the root, or no root */
+    ed25519_fe_mul(chk, r[0], r[0]);
+    ed25519_fe_mul(chk, chk, den);
+    if (ed25519_fe_differ(chk, num) != FALSE)
+    {
+        ed25519_fe_mul(r[0], r[0], ed25519_sqrtm1);
+    }
+    ed25519_fe_mul(chk, r[0], r[0]);
+    ed25519_fe_mul(chk, chk, den);
+    if (ed25519_fe_differ(chk, num) != FALSE)
+    {
+        return RETURN_NOK;
+    }
+
+    /* Negated point: opposite x parity */
+    if (ed25519_fe_parity(r[0]) == (packed[31] >> 7))
+    {
+        ed25519_fe_sub(r[0], zero, r[0]);
+    }
+    ed25519_fe_mul(r[3], r[0], r[1]);
+    return RETURN_OK;
+}
+
+/*! \fn     ed25519_scalar_reduce(uint8_t* r)
+*   \brief  Reduce a 64 bytes little endian value modulo L, result in the first 32 bytes
+*/
+static void ed25519_scalar_reduce(uint8_t* r)
+{
+    int64_t x[64];
+    int64_t carry;
+    int16_t i, j;
+
+    for (i = 0; i < 64; i++)
+    {
+        x[i] = r[i];
+    }
+
+    for (i = 63; i >= 32; i--)
+    {
+        carry = 0;
+        for (j = i - 32; j < i - 12; j++)
+        {
+            x[j] += carry - 16 * x[i] * ed25519_l[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+    carry = 0;
+    for (j = 0; j < 32; j++)
+    {
+        x[j] += carry - (x[31] >> 4) * ed25519_l[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for (j = 0; j < 32; j++)
+    {
+        x[j] -= carry * ed25519_l[j];
+    }
+    for (i = 0; i < 32; i++)
+    {
+        x[i+1] += x[i] >> 8;
+        r[i] = (uint8_t)(x[i] & 255);
+    }
+    memset((void*)&r[32], 0, 32);
+}
+
+/*! \fn     ed25519_scalar_is_canonical(const uint8_t* s)
+*   \brief  Check that a 32 bytes little endian scalar is below L
+*/
+static BOOL ed25519_scalar_is_canonical(const uint8_t* s)
+{
+    for (int16_t i = 31; i >= 0; i--)
+    {
+        if (s[i] < ed25519_l[i])
+        {
+            return TRUE;
+        }
+        else if (s[i] > ed25519_l[i])
+        {
+            return FALSE;
+        }
+    }
+    return FALSE;
+}
+
+/*! \fn     ed25519_verify(uint8_t* signature, uint8_t* message, uint16_t message_length, uint8_t* public_key)
+*   \brief  Verify an Ed25519 signature (RFC 8032)
+*   \param  signature       R || S, ED25519_SIGNATURE_LENGTH bytes
+*   \param  message         The signed message
+*   \param  message_length  Message length
+*   \param  public_key      ED25519_PUBLIC_KEY_LENGTH bytes public key
+*   \return RETURN_OK if the signature is valid
+*/
+RET_TYPE ed25519_verify(uint8_t* signature, uint8_t* message, uint16_t message_length, uint8_t* public_key)
+{
+    sha512_context_t hash_context;
+    ed25519_fe_t p[4], q[4];
+    uint8_t h[SHA512_DIGEST_LENGTH];
+    uint8_t r[32];
+
+    if ((ed25519_scalar_is_canonical(&signature[32]) == FALSE) || (ed25519_point_unpack_negated(q, public_key) != RETURN_OK))
+    {
+        return RETURN_NOK;
+    }
+
+    /* h = SHA512(R || A || M) mod L */
+    sha512_init(&hash_context);
+    sha512_update(&hash_context, signature, 32);
+    sha512_update(&hash_context, public_key, ED25519_PUBLIC_KEY_LENGTH);
+    sha512_update(&hash_context, message, message_length);
+    sha512_final(&hash_context, h);
+    ed25519_scalar_reduce(h);
+
+    /* S * B - h * A should be R */
+    ed25519_point_scalarmult(p, q, h);
+    ed25519_point_scalarmult_base(q, &signature[32]);
+    ed25519_point_add(p, q);
+    ed25519_point_pack(r, p);
+
+    if (ed25519_bytes_differ(r, signature) != FALSE)
+    {
+        return RETURN_NOK;
+    }
+    return RETURN_OK;
+}
@@ -0,0 +1,23 @@
+/*!  \file     ed25519.h
+*    \brief    Ed25519 signature verification
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef ED25519_H_
+#define ED25519_H_
+
+#include "defines.h"
+
+/* Defines */
+#define ED25519_PUBLIC_KEY_LENGTH   32
+#define ED25519_SIGNATURE_LENGTH    64
+
+/* Typedefs */
+// Field element: 16 limbs of 16 bits, radix 2^16
+typedef int64_t ed25519_fe_t[16];
+
+/* Prototypes */
+RET_TYPE ed25519_verify(uint8_t* signature, uint8_t* message, uint16_t message_length, uint8_t* public_key);
+
+
+#endif /* ED25519_H_ */
@@ -0,0 +1,153 @@
+/*!  \file     sha256.c
+*    \brief    SHA-256, streaming
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "defines.h"
+#include "sha256.h"
+
+/* Macros */
+#define SHA256_ROTR(x, n)       (((x) >> (n)) | ((x) << (32-(n))))
+#define SHA256_CH(x, y, z)      ((z) ^ ((x) & ((y) ^ (z))))
+#define SHA256_MAJ(x, y, z)     (((x) & (y)) | ((z) & ((x) | (y))))
+#define SHA256_SIGMA0(x)        (SHA256_ROTR(x, 2) ^ SHA256_ROTR(x, 13) ^ SHA256_ROTR(x, 22))
+#define SHA256_SIGMA1(x)        (SHA256_ROTR(x, 6) ^ SHA256_ROTR(x, 11) ^ SHA256_ROTR(x, 25))
+#define SHA256_GAMMA0(x)        (SHA256_ROTR(x, 7) ^ SHA256_ROTR(x, 18) ^ ((x) >> 3))
+#define SHA256_GAMMA1(x)        (SHA256_ROTR(x, 17) ^ SHA256_ROTR(x, 19) ^ ((x) >> 10))
+
+/* Round constants */
+const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+
+/*! \fn     sha256_compress(sha256_context_t* context, uint8_t* block)
+*   \brief  Process a 64 bytes block
+*   \param  context     The context
+*   \param  block       The block
+*   \note   The message schedule is computed in place on a 16 words window
+*/
+static void sha256_compress(sha256_context_t* context, uint8_t* block)
+{
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    uint32_t w[16];
+
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[i*4] << 24) | ((uint32_t)block[i*4+1] << 16) | ((uint32_t)block[i*4+2] << 8) | (uint32_t)block[i*4+3];
+    }
+
+    a = context->state[0]; b = context->state[1]; c = context->state[2]; d = context->state[3];
+    e = context->state[4]; f = context->state[5]; g = context->state[6]; h = context->state[7];
+
+    for (uint16_t i = 0; i < 64; i++)
+    {
+        if (i >= 16)
+        {
+            w[i & 15] += SHA256_GAMMA1(w[(i-2) & 15]) + w[(i-7) & 15] + SHA256_GAMMA0(w[(i-15) & 15]);
+        }
+        t1 = h + SHA256_SIGMA1(e) + SHA256_CH(e, f, g) + sha256_k[i] + w[i & 15];
+        t2 = SHA256_SIGMA0(a) + SHA256_MAJ(a, b, c);
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    context->state[0] += a; context->state[1] += b; context->state[2] += c; context->state[3] += d;
+    context->state[4] += e; context->state[5] += f; context->state[6] += g; context->state[7] += h;
+}
+
+/*! \fn     sha256_init(sha256_context_t* context)
+*   \brief  Initialize a hash computation
+*   \param  context     The context
+*/
+void sha256_init(sha256_context_t* context)
+{
+    context->state[0] = 0x6a09e667; context->state[1] = 0xbb67ae85; context->state[2] = 0x3c6ef372; context->state[3] = 0xa54ff53a;
+    context->state[4] = 0x510e527f; context->state[5] = 0x9b05688c; context->state[6] = 0x1f83d9ab; context->state[7] = 0x5be0cd19;
+    context->total_nb_bytes = 0;
+    context->block_nb_bytes = 0;
+}
+
+/*! \fn     sha256_update(sha256_context_t* context, uint8_t* data, uint32_t length)
+*   \brief  Hash data
+*   \param  context     The context
+*   \param  data        The data
+*   \param  length      Number of bytes
+*   \note   Whole blocks are hashed from the data itself, without copy
+*/
+void sha256_update(sha256_context_t* context, uint8_t* data, uint32_t length)
+{
+    uint32_t nb_bytes_to_copy;
+
+    context->total_nb_bytes += length;
+
+    /* Complete a partial block */
+    if (context->block_nb_bytes != 0)
+    {
+        nb_bytes_to_copy = SHA256_BLOCK_LENGTH - context->block_nb_bytes;
+        if (nb_bytes_to_copy > length)
+        {
+            nb_bytes_to_copy = length;
+        }
+        memcpy((void*)&context->block[context->block_nb_bytes], (void*)data, nb_bytes_to_copy);
+        context->block_nb_bytes += nb_bytes_to_copy;
+        data += nb_bytes_to_copy;
+        length -= nb_bytes_to_copy;
+        if (context->block_nb_bytes < SHA256_BLOCK_LENGTH)
+        {
+            return;
+        }
+        sha256_compress(context, context->block);
+        context->block_nb_bytes = 0;
+    }
+
+    while (length >= SHA256_BLOCK_LENGTH)
+    {
+        sha256_compress(context, data);
+        data += SHA256_BLOCK_LENGTH;
+        length -= SHA256_BLOCK_LENGTH;
+    }
+
+    memcpy((void*)context->block, (void*)data, length);
+    context->block_nb_bytes = length;
+}
+
+/*! \fn     sha256_final(sha256_context_t* context, uint8_t* digest)
+*   \brief  Pad the message and output the digest
+*   \param  context     The context
+*   \param  digest      Where to store the SHA256_DIGEST_LENGTH bytes
+*/
+void sha256_final(sha256_context_t* context, uint8_t* digest)
+{
+    uint32_t total_nb_bits_high = context->total_nb_bytes >> 29;
+    uint32_t total_nb_bits_low = context->total_nb_bytes << 3;
+
+    /* 0x80, zeros, 64 bits big endian message length */
+    context->block[context->block_nb_bytes++] = 0x80;
+    if (context->block_nb_bytes > SHA256_BLOCK_LENGTH - 8)
+    {
+        memset((void*)&context->block[context->block_nb_bytes], 0, SHA256_BLOCK_LENGTH - context->block_nb_bytes);
+        sha256_compress(context, context->block);
+        context->block_nb_bytes = 0;
+    }
+    memset((void*)&context->block[context->block_nb_bytes], 0, SHA256_BLOCK_LENGTH - 8 - context->block_nb_bytes);
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        context->block[SHA256_BLOCK_LENGTH-8+i] = (uint8_t)(total_nb_bits_high >> (24 - i*8));
+        context->block[SHA256_BLOCK_LENGTH-4+i] = (uint8_t)(total_nb_bits_low >> (24 - i*8));
+    }
+    sha256_compress(context, context->block);
+
+    for (uint16_t i = 0; i < SHA256_DIGEST_LENGTH; i++)
+    {
+        digest[i] = (uint8_t)(context->state[i/4] >> (24 - (i%4)*8));
+    }
+    memset((void*)context, 0, sizeof(*context));
+}
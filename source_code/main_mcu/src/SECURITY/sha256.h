@@ -0,0 +1,30 @@
+/*!  \file     sha256.h
+*    \brief    SHA-256, streaming
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef SHA256_H_
+#define SHA256_H_
+
+#include "defines.h"
+
+/* Defines */
+#define SHA256_BLOCK_LENGTH     64
+#define SHA256_DIGEST_LENGTH    32
+
+/* Typedefs */
+typedef struct
+{
+    uint32_t state[8];
+    uint32_t total_nb_bytes;
+    uint8_t block[SHA256_BLOCK_LENGTH];
+    uint16_t block_nb_bytes;
+} sha256_context_t;
+
+/* Prototypes */
+void sha256_update(sha256_context_t* context, uint8_t* data, uint32_t length);
+void sha256_final(sha256_context_t* context, uint8_t* digest);
+void sha256_init(sha256_context_t* context);
+
+
+#endif /* SHA256_H_ */
@@ -0,0 +1,148 @@
+/*!  \file     sha512.c
+*    \brief    SHA-512, streaming (Ed25519 signature verification)
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#include <string.h>
+#include "defines.h"
+#include "sha512.h"
+
+/* Macros */
+#define SHA512_ROTR(x, n)       (((x) >> (n)) | ((x) << (64-(n))))
+#define SHA512_CH(x, y, z)      ((z) ^ ((x) & ((y) ^ (z))))
+#define SHA512_MAJ(x, y, z)     (((x) & (y)) | ((z) & ((x) | (y))))
+#define SHA512_SIGMA0(x)        (SHA512_ROTR(x, 28) ^ SHA512_ROTR(x, 34) ^ SHA512_ROTR(x, 39))
+#define SHA512_SIGMA1(x)        (SHA512_ROTR(x, 14) ^ SHA512_ROTR(x, 18) ^ SHA512_ROTR(x, 41))
+#define SHA512_GAMMA0(x)        (SHA512_ROTR(x, 1) ^ SHA512_ROTR(x, 8) ^ ((x) >> 7))
+#define SHA512_GAMMA1(x)        (SHA512_ROTR(x, 19) ^ SHA512_ROTR(x, 61) ^ ((x) >> 6))
+
+/* Round constants */
+const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+
+/*! \fn     sha512_compress(sha512_context_t* context, uint8_t* block)
+*   \brief  Process a 128 bytes block
+*   \param  context     The context
+*   \param  block       The block
+*/
+static void sha512_compress(sha512_context_t* context, uint8_t* block)
+{
+    uint64_t a, b, c, d, e, f, g, h, t1, t2;
+    uint64_t w[16];
+
+    for (uint16_t i = 0; i < 16; i++)
+    {
+        w[i] = 0;
+        for (uint16_t j = 0; j < 8; j++)
+        {
+            w[i] = (w[i] << 8) | block[i*8+j];
+        }
+    }
+
+    a = context->state[0]; b = context->state[1]; c = context->state[2]; d = context->state[3];
+    e = context->state[4]; f = context->state[5]; g = context->state[6]; h = context->state[7];
+
+    for (uint16_t i = 0; i < 80; i++)
+    {
+        if (i >= 16)
+        {
+            w[i & 15] += SHA512_GAMMA1(w[(i-2) & 15]) + w[(i-7) & 15] + SHA512_GAMMA0(w[(i-15) & 15]);
+        }
+        t1 = h + SHA512_SIGMA1(e) + SHA512_CH(e, f, g) + sha512_k[i] + w[i & 15];
+        t2 = SHA512_SIGMA0(a) + SHA512_MAJ(a, b, c);
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    context->state[0] += a; context->state[1] += b; context->state[2] += c; context->state[3] += d;
+    context->state[4] += e; context->state[5] += f; context->state[6] += g; context->state[7] += h;
+}
+
+/*! \fn     sha512_init(sha512_context_t* context)
+*   \brief  Initialize a hash computation
+*   \param  context     The context
+*/
+void sha512_init(sha512_context_t* context)
+{
+    context->state[0] = 0x6a09e667f3bcc908ULL; context->state[1] = 0xbb67ae8584caa73bULL;
+    context->state[2] = 0x3c6ef372fe94f82bULL; context->state[3] = 0xa54ff53a5f1d36f1ULL;
+    context->state[4] = 0x510e527fade682d1ULL; context->state[5] = 0x9b05688c2b3e6c1fULL;
+    context->state[6] = 0x1f83d9abfb41bd6bULL; context->state[7] = 0x5be0cd19137e2179ULL;
+    context->total_nb_bytes = 0;
+    context->block_nb_bytes = 0;
+}
+
+/*! \fn     sha512_update(sha512_context_t* context, uint8_t* data, uint32_t length)
+*   \brief  Hash data
+*   \param  context     The context
+*   \param  data        The data
+*   \param  length      Number of bytes
+*/
+void sha512_update(sha512_context_t* context, uint8_t* data, uint32_t length)
+{
+    context->total_nb_bytes += length;
+
+    while (length > 0)
+    {
+        context->block[context->block_nb_bytes++] = *data++;
+        length--;
+        if (context->block_nb_bytes == SHA512_BLOCK_LENGTH)
+        {
+            sha512_compress(context, context->block);
+            context->block_nb_bytes = 0;
+        }
+    }
+}
+
+/*! \fn     sha512_final(sha512_context_t* context, uint8_t* digest)
+*   \brief  Pad the message and output the digest
+*   \param  context     The context
+*   \param  digest      Where to store the SHA512_DIGEST_LENGTH bytes
+*/
+void sha512_final(sha512_context_t* context, uint8_t* digest)
+{
+    uint32_t total_nb_bits_high = context->total_nb_bytes >> 29;
+    uint32_t total_nb_bits_low = context->total_nb_bytes << 3;
+
+    /* 0x80, zeros, 128 bits big endian message length */
+    context->block[context->block_nb_bytes++] = 0x80;
+    if (context->block_nb_bytes > SHA512_BLOCK_LENGTH - 16)
+    {
+        memset((void*)&context->block[context->block_nb_bytes], 0, SHA512_BLOCK_LENGTH - context->block_nb_bytes);
+        sha512_compress(context, context->block);
+        context->block_nb_bytes = 0;
+    }
+    memset((void*)&context->block[context->block_nb_bytes], 0, SHA512_BLOCK_LENGTH - 8 - context->block_nb_bytes);
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        context->block[SHA512_BLOCK_LENGTH-8+i] = (uint8_t)(total_nb_bits_high >> (24 - i*8));
+        context->block[SHA512_BLOCK_LENGTH-4+i] = (uint8_t)(total_nb_bits_low >> (24 - i*8));
+    }
+    sha512_compress(context, context->block);
+
+    for (uint16_t i = 0; i < SHA512_DIGEST_LENGTH; i++)
+    {
+        digest[i] = (uint8_t)(context->state[i/8] >> (56 - (i%8)*8));
+    }
+    memset((void*)context, 0, sizeof(*context));
+}
@@ -0,0 +1,30 @@
+/*!  \file     sha512.h
+*    \brief    SHA-512, streaming (Ed25519 signature verification)
+*    Created:  19/10/2026
+*    Author:   Mathieu Stephan
+*/
+#ifndef SHA512_H_
+#define SHA512_H_
+
+#include "defines.h"
+
+/* Defines */
+#define SHA512_BLOCK_LENGTH     128
+#define SHA512_DIGEST_LENGTH    64
+
+/* Typedefs */
+typedef struct
+{
+    uint64_t state[8];
+    uint32_t total_nb_bytes;
+    uint8_t block[SHA512_BLOCK_LENGTH];
+    uint16_t block_nb_bytes;
+} sha512_context_t;
+
+/* Prototypes */
+void sha512_update(sha512_context_t* context, uint8_t* data, uint32_t length);
+void sha512_final(sha512_context_t* context, uint8_t* digest);
+void sha512_init(sha512_context_t* context);
+
+
+#endif /* SHA512_H_ */
@@ -9,6 +9,104 @@
 #include "main.h"
 #include "defines.h"
 #include <string.h>
+/* Image of the card memory as read in the current security state, see smartcard_highlevel_fill_shadow() */
+uint8_t smartcard_highlevel_shadow[SMARTCARD_MEM_BIT_LENGTH/8];
+/* Set when the shadow matches the card */
+volatile BOOL smartcard_highlevel_shadow_valid = FALSE;
+
+
+/*! \fn     smartcard_highlevel_fill_shadow(void)
+*   \brief  Read the whole card memory into the shadow, in a single pass
+*   \note   What the card outputs depends on its security state: call after insertion and after authentication
+*/
+void smartcard_highlevel_fill_shadow(void)
+{
+    smartcard_lowlevel_read_smc(SMARTCARD_MEM_BIT_LENGTH/8, 0, smartcard_highlevel_shadow);
+    smartcard_highlevel_shadow_valid = TRUE;
+}
+
+/*! \fn     smartcard_highlevel_invalidate_shadow(void)
+*   \brief  Invalidate and clear the shadow: reads go to the card until it is filled again
+*   \note   To be called on card removal and on any operation changing the security state or zone contents (code validation, fuses, erases)
+*/
+void smartcard_highlevel_invalidate_shadow(void)
+{
+    smartcard_highlevel_shadow_valid = FALSE;
+    memset((void*)smartcard_highlevel_shadow, 0x00, sizeof(smartcard_highlevel_shadow));
+}
+
+/*! \fn     smartcard_highlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t start_record_index, uint8_t* data_to_receive)
+*   \brief  Read bytes from the shadow, or from the card if the shadow isn't valid
+*   \param  nb_bytes_total_read     The number of bytes to be read, from the card start
+*   \param  start_record_index      The index at which we start recording the answer
+*   \param  data_to_receive         Pointer to the buffer
+*   \return The buffer
+*/
+uint8_t* smartcard_highlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t start_record_index, uint8_t* data_to_receive)
+{
+    if ((smartcard_highlevel_shadow_valid == FALSE) || (nb_bytes_total_read > sizeof(smartcard_highlevel_shadow)) || (start_record_index > nb_bytes_total_read))
+    {
+        return smartcard_lowlevel_read_smc(nb_bytes_total_read, start_record_index, data_to_receive);
+    }
+    
+    memcpy((void*)data_to_receive, (void*)&smartcard_highlevel_shadow[start_record_index], nb_bytes_total_read - start_record_index);
+    return data_to_receive;
+}
+
+/*! \fn     smartcard_highlevel_is_shadow_exact(uint16_t start_index_bit, uint16_t nb_bits)
+*   \brief  Check if the shadow holds the stored bits of a given range, and not only what the card outputs for them
+*   \param  start_index_bit         Range start
+*   \param  nb_bits                 Range length
+*   \return TRUE if the range is within the CPZ or an application zone, which read as stored once authenticated
+*/
+static BOOL smartcard_highlevel_is_shadow_exact(uint16_t start_index_bit, uint16_t nb_bits)
+{
+    uint16_t end_index_bit = start_index_bit + nb_bits;
+    
+    if (smartcard_highlevel_shadow_valid == FALSE)
+    {
+        return FALSE;
+    }
+    else if ((start_index_bit >= SMARTCARD_CPZ_BIT_START) && (end_index_bit <= SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ_BIT_LENGTH))
+    {
+        return TRUE;
+    }
+    else if ((start_index_bit >= SMARTCARD_AZ2_BIT_START) && (end_index_bit <= SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ_BIT_LENGTH))
+    {
+        return TRUE;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+/*! \fn     smartcard_highlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write)
+*   \brief  Write bits to the smart card, through the shadow
+*   \param  start_index_bit         Where to start writing bits
+*   \param  nb_bits                 Number of bits to write
+*   \param  data_to_write           Pointer to the buffer
+*   \note   When the shadow holds the range contents, only the changed words are erased / programmed
+*   \note   The written words are read back into the shadow: the card may ignore writes depending on its security state
+*/
+void smartcard_highlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write)
+{
+    /* Words touched by the write, as the low level erases whole words */
+    uint16_t start_byte = (start_index_bit >> 4) << 1;
+    uint16_t end_byte = ((start_index_bit + nb_bits + 15) >> 4) << 1;
+    uint8_t* card_image = 0;
+    
+    if (smartcard_highlevel_is_shadow_exact(start_index_bit, nb_bits) != FALSE)
+    {
+        card_image = smartcard_highlevel_shadow;
+    }
+    
+    /* Nothing to read back if the card already held the data */
+    if ((smartcard_lowlevel_write_smc(start_index_bit, nb_bits, data_to_write, card_image) != FALSE) && (smartcard_highlevel_shadow_valid != FALSE) && (end_byte <= sizeof(smartcard_highlevel_shadow)))
+    {
+        smartcard_lowlevel_read_smc(end_byte, start_byte, &smartcard_highlevel_shadow[start_byte]);
+    }
+}
 
 
 /*! \fn     smartcard_highlevel_read_aes_key(uint8_t* buffer)
@@ -17,7 +115,7 @@
 */
 void smartcard_highlevel_read_aes_key(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH)/8, (SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED)/8, buffer);
+    smartcard_highlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH)/8, (SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED)/8, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_application_zone1(uint8_t* buffer)
@@ -26,7 +124,7 @@ void smartcard_highlevel_read_aes_key(uint8_t* buffer)
 */
 void smartcard_highlevel_read_application_zone1(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ_BIT_LENGTH)/8, (SMARTCARD_AZ1_BIT_START)/8, buffer);
+    smartcard_highlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ_BIT_LENGTH)/8, (SMARTCARD_AZ1_BIT_START)/8, buffer);
 }
 
 /*! \fn     smartcard_highlevel_write_application_zone1(uint8_t* buffer)
@@ -35,7 +133,7 @@ void smartcard_highlevel_read_application_zone1(uint8_t* buffer)
 */
 void smartcard_highlevel_write_application_zone1(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(SMARTCARD_AZ1_BIT_START, SMARTCARD_AZ_BIT_LENGTH, buffer);
+    smartcard_highlevel_write_smc(SMARTCARD_AZ1_BIT_START, SMARTCARD_AZ_BIT_LENGTH, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_application_zone2(uint8_t* buffer)
@@ -44,7 +142,7 @@ void smartcard_highlevel_write_application_zone1(uint8_t* buffer)
 */
 void smartcard_highlevel_read_application_zone2(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc((SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ_BIT_LENGTH)/8, (SMARTCARD_AZ2_BIT_START)/8, buffer);
+    smartcard_highlevel_read_smc((SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ_BIT_LENGTH)/8, (SMARTCARD_AZ2_BIT_START)/8, buffer);
 }
 
 /*! \fn     smartcard_highlevel_write_application_zone2(uint8_t* buffer)
@@ -53,7 +151,7 @@ void smartcard_highlevel_read_application_zone2(uint8_t* buffer)
 */
 void smartcard_highlevel_write_application_zone2(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(SMARTCARD_AZ2_BIT_START, SMARTCARD_AZ_BIT_LENGTH, buffer);
+    smartcard_highlevel_write_smc(SMARTCARD_AZ2_BIT_START, SMARTCARD_AZ_BIT_LENGTH, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_card_login(uint8_t* buffer)
@@ -63,7 +161,7 @@ void smartcard_highlevel_write_application_zone2(uint8_t* buffer)
 void smartcard_highlevel_read_card_login(uint8_t* buffer)
 {
     // We take the space left in AZ2 -> 62 bytes (512 - 16 = 62 bytes)
-    smartcard_lowlevel_read_smc((SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ2_BIT_RESERVED + SMARTCARD_MTP_LOGIN_LENGTH)/8, (SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ2_BIT_RESERVED)/8, buffer);
+    smartcard_highlevel_read_smc((SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ2_BIT_RESERVED + SMARTCARD_MTP_LOGIN_LENGTH)/8, (SMARTCARD_AZ2_BIT_START + SMARTCARD_AZ2_BIT_RESERVED)/8, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_card_password(uint8_t* buffer)
@@ -73,7 +171,7 @@ void smartcard_highlevel_read_card_login(uint8_t* buffer)
 void smartcard_highlevel_read_card_password(uint8_t* buffer)
 {
     // We take the space left in AZ1 -> 30 bytes (512 - 256 - 16 = 30 bytes)
-    smartcard_lowlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH + SMARTCARD_MTP_PASS_LENGTH)/8, (SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH)/8, buffer);
+    smartcard_highlevel_read_smc((SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH + SMARTCARD_MTP_PASS_LENGTH)/8, (SMARTCARD_AZ1_BIT_START + SMARTCARD_AZ1_BIT_RESERVED + AES_KEY_LENGTH)/8, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_fab_zone(uint8_t* buffer)
@@ -83,7 +181,7 @@ void smartcard_highlevel_read_card_password(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_fab_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(2, 0, buffer);
+    smartcard_highlevel_read_smc(2, 0, buffer);
     return buffer;
 }
 
@@ -94,7 +192,7 @@ uint8_t* smartcard_highlevel_read_fab_zone(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_mem_test_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(178, 176, buffer);
+    smartcard_highlevel_read_smc(178, 176, buffer);
     return buffer;
 }
 
@@ -104,7 +202,7 @@ uint8_t* smartcard_highlevel_read_mem_test_zone(uint8_t* buffer)
 */
 void smartcard_highlevel_write_mem_test_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(1408, 16, buffer);
+    smartcard_highlevel_write_smc(1408, 16, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_manufacturer_zone(uint8_t* buffer)
@@ -114,7 +212,7 @@ void smartcard_highlevel_write_mem_test_zone(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_manufacturer_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(180, 178, buffer);
+    smartcard_highlevel_read_smc(180, 178, buffer);
     return buffer;
 }
 
@@ -125,7 +223,7 @@ uint8_t* smartcard_highlevel_read_manufacturer_zone(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_code_attempts_counter(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(14, 12, buffer);
+    smartcard_highlevel_read_smc(14, 12, buffer);
     return buffer;
 }
 
@@ -136,7 +234,7 @@ uint8_t* smartcard_highlevel_read_code_attempts_counter(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_issuer_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(10, 2, buffer);
+    smartcard_highlevel_read_smc(10, 2, buffer);
     return buffer;
 }
 
@@ -146,7 +244,7 @@ uint8_t* smartcard_highlevel_read_issuer_zone(uint8_t* buffer)
 */
 void smartcard_highlevel_write_issuer_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(16, 64, buffer);
+    smartcard_highlevel_write_smc(16, 64, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_code_protected_zone(uint8_t* buffer)
@@ -156,7 +254,7 @@ void smartcard_highlevel_write_issuer_zone(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_code_protected_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(22, 14, buffer);
+    smartcard_highlevel_read_smc(22, 14, buffer);
     return buffer;
 }
 
@@ -166,7 +264,7 @@ uint8_t* smartcard_highlevel_read_code_protected_zone(uint8_t* buffer)
 */
 void smartcard_highlevel_write_protected_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(112, 64, buffer);
+    smartcard_highlevel_write_smc(112, 64, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_appzone1_erase_key(uint8_t* buffer)
@@ -176,7 +274,7 @@ void smartcard_highlevel_write_protected_zone(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_appzone1_erase_key(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(92, 86, buffer);
+    smartcard_highlevel_read_smc(92, 86, buffer);
     return buffer;
 }
 
@@ -186,7 +284,7 @@ uint8_t* smartcard_highlevel_read_appzone1_erase_key(uint8_t* buffer)
 */
 void smartcard_highlevel_write_appzone1_erase_key(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(688, 48, buffer);
+    smartcard_highlevel_write_smc(688, 48, buffer);
 }
 
 /*! \fn     smartcard_highlevel_read_appzone2_erase_key(uint8_t* buffer)
@@ -196,7 +294,7 @@ void smartcard_highlevel_write_appzone1_erase_key(uint8_t* buffer)
 */
 uint8_t* smartcard_highlevel_read_appzone2_erase_key(uint8_t* buffer)
 {
-    smartcard_lowlevel_read_smc(160, 156, buffer);
+    smartcard_highlevel_read_smc(160, 156, buffer);
     return buffer;
 }
 
@@ -206,7 +304,7 @@ uint8_t* smartcard_highlevel_read_appzone2_erase_key(uint8_t* buffer)
 */
 void smartcard_highlevel_write_appzone2_erase_key(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(1248, 32, buffer);
+    smartcard_highlevel_write_smc(1248, 32, buffer);
 }
 
 /*! \fn     smartcard_highlevel_write_manufacturer_zone(uint8_t* buffer)
@@ -215,7 +313,7 @@ void smartcard_highlevel_write_appzone2_erase_key(uint8_t* buffer)
 */
 void smartcard_highlevel_write_manufacturer_zone(uint8_t* buffer)
 {
-    smartcard_lowlevel_write_smc(1424, 16, buffer);
+    smartcard_highlevel_write_smc(1424, 16, buffer);
 }
 
 /*! \fn     smartcard_highlevel_write_manufacturer_fuse(void)
@@ -280,6 +378,9 @@ mooltipass_card_detect_return_te smartcard_high_level_mooltipass_card_detected_r
 
     if (temp_rettype == RETURN_PIN_OK)                                   // Unlock successful
     {
+        // Authenticated: the card outputs the protected zones from now on, serve the next reads from the shadow
+        smartcard_highlevel_fill_shadow();
+        
         // Check that the card is in security mode 2
         if (smartcard_highlevel_check_security_mode2() == RETURN_NOK)
         {
@@ -383,8 +484,8 @@ void smartcard_highlevel_erase_smartcard(void)
 */
 RET_TYPE smartcard_highlevel_write_to_appzone_and_check(uint16_t addr, uint16_t nb_bits, uint8_t* buffer, uint8_t* temp_buffer)
 {    
-    smartcard_lowlevel_write_smc(addr, nb_bits, buffer);
-    smartcard_lowlevel_read_smc((addr + nb_bits) >> 3, (addr >> 3), temp_buffer);
+    smartcard_highlevel_write_smc(addr, nb_bits, buffer);
+    smartcard_highlevel_read_smc((addr + nb_bits) >> 3, (addr >> 3), temp_buffer);
     
     if (memcmp(buffer, temp_buffer, (nb_bits >> 3)) == 0)
     {
@@ -437,7 +538,9 @@ void smartcard_highlevel_reset_blank_card(void)
     uint16_t default_pin = SMARTCARD_FACTORY_PIN;
     uint8_t data_buffer[2] = {0xFF, 0xFF};
     
-    smartcard_lowlevel_write_smc(1441, 1, data_buffer);
+    /* Block erase: all zones but FZ/MTZ/MFZ are reset */
+    smartcard_highlevel_write_smc(1441, 1, data_buffer);
+    smartcard_highlevel_invalidate_shadow();
     smartcard_highlevel_write_security_code(&default_pin);
 }
 
@@ -448,7 +551,7 @@ void smartcard_highlevel_reset_blank_card(void)
 uint16_t smartcard_highlevel_read_security_code(void)
 {
     uint16_t temp_uint;
-    smartcard_lowlevel_read_smc(12, 10, (uint8_t*)&temp_uint);
+    smartcard_highlevel_read_smc(12, 10, (uint8_t*)&temp_uint);
     return swap16(temp_uint);
 }
 
@@ -459,7 +562,7 @@ uint16_t smartcard_highlevel_read_security_code(void)
 void smartcard_highlevel_write_security_code(volatile uint16_t* code)
 {
     *code = swap16(*code);
-    smartcard_lowlevel_write_smc(80, 16, (uint8_t*)code);
+    smartcard_highlevel_write_smc(80, 16, (uint8_t*)code);
     *code = swap16(*code);
 }
 
@@ -471,7 +574,7 @@ RET_TYPE smartcard_highlevel_set_authenticated_readwrite_to_zone1(void)
 {
     // Set P1 to 1 to allow write, remove R1 to prevent non authenticated reads
     uint8_t temp_buffer[2] = {0x80, 0x00};
-    smartcard_lowlevel_write_smc(176, 16, temp_buffer);
+    smartcard_highlevel_write_smc(176, 16, temp_buffer);
     
     return smartcard_highlevel_check_authenticated_readwrite_to_zone1();
 }
@@ -484,7 +587,7 @@ RET_TYPE smartcard_highlevel_check_authenticated_readwrite_to_zone1(void)
 {
     uint8_t temp_buffer[2];
 
-    smartcard_lowlevel_read_smc(24, 22, temp_buffer);
+    smartcard_highlevel_read_smc(24, 22, temp_buffer);
 
     if ((temp_buffer[0] == 0x80) && (temp_buffer[1] == 0x00))
     {
@@ -504,7 +607,7 @@ RET_TYPE smartcard_highlevel_set_authenticated_readwrite_to_zone2(void)
 {
     // Set P2 to 1 to allow write, remove R2 to prevent non authenticated reads
     uint8_t temp_buffer[2] = {0x80, 0x00};
-    smartcard_lowlevel_write_smc(736, 16, temp_buffer);
+    smartcard_highlevel_write_smc(736, 16, temp_buffer);
     
     return smartcard_highlevel_check_authenticated_readwrite_to_zone2();
 }
@@ -516,9 +619,9 @@ void smartcard_highlevel_set_authenticated_readwrite_to_zone1and2(void)
 {
     uint8_t temp_buffer[2] = {0x80, 0x00};
     // Set P1 to 1 to allow write, remove R1 to prevent non authenticated reads
-    smartcard_lowlevel_write_smc(176, 16, temp_buffer);
+    smartcard_highlevel_write_smc(176, 16, temp_buffer);
     // Set P2 to 1 to allow write, remove R2 to prevent non authenticated reads
-    smartcard_lowlevel_write_smc(736, 16, temp_buffer);
+    smartcard_highlevel_write_smc(736, 16, temp_buffer);
 }
 
 /*! \fn     smartcard_highlevel_check_authenticated_readwrite_to_zone2(void)
@@ -529,7 +632,7 @@ RET_TYPE smartcard_highlevel_check_authenticated_readwrite_to_zone2(void)
 {
     uint8_t temp_buffer[2];
 
-    smartcard_lowlevel_read_smc(94, 92, temp_buffer);
+    smartcard_highlevel_read_smc(94, 92, temp_buffer);
 
     if ((temp_buffer[0] == 0x80) && (temp_buffer[1] == 0x00))
     {
@@ -550,8 +653,8 @@ RET_TYPE smartcard_highlevel_check_authenticated_readwrite_to_zone12(void)
     uint8_t temp_buffer[2];
     uint8_t temp_buffer2[2];
 
-    smartcard_lowlevel_read_smc(24, 22, temp_buffer);
-    smartcard_lowlevel_read_smc(94, 92, temp_buffer2);
+    smartcard_highlevel_read_smc(24, 22, temp_buffer);
+    smartcard_highlevel_read_smc(94, 92, temp_buffer2);
 
     if ((temp_buffer[0] == 0x80) && (temp_buffer[1] == 0x00) && (temp_buffer2[0] == 0x80) && (temp_buffer2[1] == 0x00))
     {
@@ -573,7 +676,7 @@ uint8_t smartcard_highlevel_get_nb_az2_writes_left(void)
     uint8_t return_val = 0;
     uint8_t i;
 
-    smartcard_lowlevel_read_smc(176, 160, temp_buffer);
+    smartcard_highlevel_read_smc(176, 160, temp_buffer);
     for(i = 0; i < 128; i++)
     {
         if ((temp_buffer[i>>3] >> (i&0x07)) & 0x01)
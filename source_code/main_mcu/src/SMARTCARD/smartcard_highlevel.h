@@ -18,6 +18,10 @@
 
 
 /************ PROTOTYPES ************/
+uint8_t* smartcard_highlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t start_record_index, uint8_t* data_to_receive);
+void smartcard_highlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write);
+void smartcard_highlevel_invalidate_shadow(void);
+void smartcard_highlevel_fill_shadow(void);
 RET_TYPE smartcard_highlevel_write_to_appzone_and_check(uint16_t addr, uint16_t nb_bits, uint8_t* buffer, uint8_t* temp_buffer);
 mooltipass_card_detect_return_te smartcard_high_level_mooltipass_card_detected_routine(volatile uint16_t* pin_code);
 RET_TYPE smartcard_highlevel_check_security_mode2(void);
@@ -19,6 +19,14 @@ volatile det_ret_type_te card_return = RETURN_REL;
 volatile uint16_t card_detect_counter = 0;
 /* Smartcard powered state */
 volatile BOOL card_powered = FALSE;
+#ifdef SMARTCARD_TIMER_BITBANG
+/* Number of clock edges left in the pulse train generated by the bit banging timer */
+volatile uint16_t smartcard_lowlevel_timer_nb_edges_left = 0;
+/* Set when the pulse train is made of inverted clock pulses */
+volatile BOOL smartcard_lowlevel_timer_inverted_pulses = FALSE;
+/* Set while the bit banging timer is running */
+volatile BOOL smartcard_lowlevel_timer_running = FALSE;
+#endif
 
 
 /*! \fn     smartcard_lowlevel_hpulse_delay(void)
@@ -29,12 +37,89 @@ void smartcard_lowlevel_hpulse_delay(void)
     DELAYUS(2);
 }
 
+#ifdef SMARTCARD_TIMER_BITBANG
+/*! \fn     smartcard_lowlevel_timer_drive_next_edge(void)
+*   \brief  Drive the next clock edge of the timer pulse train
+*   \note   Clock pulses start with a rising edge, inverted clock pulses with a falling edge
+*/
+static inline void smartcard_lowlevel_timer_drive_next_edge(void)
+{
+    if (((smartcard_lowlevel_timer_nb_edges_left & 0x0001) == 0) != (smartcard_lowlevel_timer_inverted_pulses != FALSE))
+    {
+        PORT->Group[SMC_SCK_GROUP].OUTSET.reg = SMC_SCK_MASK;
+    }
+    else
+    {
+        PORT->Group[SMC_SCK_GROUP].OUTCLR.reg = SMC_SCK_MASK;
+    }
+    smartcard_lowlevel_timer_nb_edges_left--;
+}
+
+/*! \fn     smartcard_lowlevel_timer_callback(void)
+*   \brief  Called by the bit banging timer interrupt at the end of each period
+*/
+void smartcard_lowlevel_timer_callback(void)
+{
+    if (smartcard_lowlevel_timer_nb_edges_left != 0)
+    {
+        /* Drive the edge then restart the period: interrupt latency can only lengthen the half pulses */
+        smartcard_lowlevel_timer_drive_next_edge();
+        while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);
+        SMARTCARD_BB_TC->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    }
+    else
+    {
+        smartcard_lowlevel_timer_running = FALSE;
+    }
+}
+
+/*! \fn     smartcard_lowlevel_timer_run(uint16_t nb_edges, uint16_t nb_ticks, BOOL inverted)
+*   \brief  Generate a clock pulse train with the bit banging timer, or just wait
+*   \param  nb_edges    Number of clock edges, 0 for a wait
+*   \param  nb_ticks    Timer period in 3MHz ticks: time between two edges, and after the last one
+*   \param  inverted    TRUE for inverted clock pulses
+*   \note   The CPU sleeps until the train is over, interrupts are still served
+*/
+static void smartcard_lowlevel_timer_run(uint16_t nb_edges, uint16_t nb_ticks, BOOL inverted)
+{
+    /* Setup the pulse train and drive its first edge */
+    smartcard_lowlevel_timer_nb_edges_left = nb_edges;
+    smartcard_lowlevel_timer_inverted_pulses = inverted;
+    smartcard_lowlevel_timer_running = TRUE;
+    if (nb_edges != 0)
+    {
+        smartcard_lowlevel_timer_drive_next_edge();
+    }
+
+    /* Start the timer */
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);
+    SMARTCARD_BB_TC->COUNT16.CC[0].reg = nb_ticks - 1;
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);
+    SMARTCARD_BB_TC->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+
+    /* Sleep until done: the timer interrupt wakes us up even with interrupts masked. Standby sleep leaves SLEEPDEEP set */
+    cpu_irq_disable();
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    while (smartcard_lowlevel_timer_running != FALSE)
+    {
+        __WFI();
+        cpu_irq_enable();
+        cpu_irq_disable();
+    }
+    cpu_irq_enable();
+}
+#endif
+
 /*! \fn     smartcard_lowlevel_tchp_delay(void)
 *   \brief  Tchp delay (3.0ms min)
 */
 static inline void smartcard_lowlevel_tchp_delay(void)
 {
-    timer_delay_ms(4);
+    #ifdef SMARTCARD_TIMER_BITBANG
+        smartcard_lowlevel_timer_run(0, SMARTCARD_TIMER_TCHP_TICKS, FALSE);
+    #else
+        timer_delay_ms(4);
+    #endif
 }
 
 /*! \fn     smartcard_lowlevel_clock_pulse(void)
@@ -59,6 +144,38 @@ void smartcard_lowlevel_inverted_clock_pulse(void)
     smartcard_lowlevel_hpulse_delay();
 }
 
+/*! \fn     smartcard_lowlevel_clock_pulses(uint16_t nb_pulses)
+*   \brief  Send a train of 4us H->L clock pulses
+*   \param  nb_pulses   Number of pulses
+*/
+void smartcard_lowlevel_clock_pulses(uint16_t nb_pulses)
+{
+    #ifdef SMARTCARD_TIMER_BITBANG
+        if (nb_pulses != 0)
+        {
+            smartcard_lowlevel_timer_run(2*nb_pulses, SMARTCARD_TIMER_HPULSE_TICKS, FALSE);
+        }
+    #else
+        while(nb_pulses--) smartcard_lowlevel_clock_pulse();
+    #endif
+}
+
+/*! \fn     smartcard_lowlevel_inverted_clock_pulses(uint16_t nb_pulses)
+*   \brief  Send a train of 4us L->H clock pulses
+*   \param  nb_pulses   Number of pulses
+*/
+void smartcard_lowlevel_inverted_clock_pulses(uint16_t nb_pulses)
+{
+    #ifdef SMARTCARD_TIMER_BITBANG
+        if (nb_pulses != 0)
+        {
+            smartcard_lowlevel_timer_run(2*nb_pulses, SMARTCARD_TIMER_HPULSE_TICKS, TRUE);
+        }
+    #else
+        while(nb_pulses--) smartcard_lowlevel_inverted_clock_pulse();
+    #endif
+}
+
 /*! \fn     smartcard_lowlevel_write_nerase(BOOL is_write)
 *   \brief  Perform a write or erase operation on the smart card
 *   \param  is_write    Boolean to indicate if it is a write
@@ -122,6 +239,9 @@ void smartcard_lowlevel_blow_fuse(card_fuse_type_te fuse_name)
     {
         i = 0;
     }
+    
+    /* Fuses change what can be read & written */
+    smartcard_highlevel_invalidate_shadow();
 
     /* Switch to bit banging */
     platform_io_smc_switch_to_bb();
@@ -129,7 +249,7 @@ void smartcard_lowlevel_blow_fuse(card_fuse_type_te fuse_name)
     smartcard_lowlevel_clear_pgmrst_signals();
 
     /* Get to the good index */
-    while(i--)smartcard_lowlevel_clock_pulse();
+    smartcard_lowlevel_clock_pulses(i);
 
     /* Set RST signal */
     PORT->Group[SMC_RST_GROUP].OUTSET.reg = SMC_RST_MASK;
@@ -200,6 +320,7 @@ void smartcard_lowlevel_detect(void)
         {
             card_powered = FALSE;
             platform_io_smc_remove_function();
+            smartcard_highlevel_invalidate_shadow();
             logic_security_clear_security_bools();
             #ifdef SPECIAL_DEVELOPER_CARD_FEATURE
             special_dev_card_inserted = FALSE;
@@ -232,6 +353,9 @@ card_detect_return_te smartcard_lowlevel_first_detect_function(void)
 
     /* Let the card come online */
     timer_delay_ms(300);
+    
+    /* New insertion session: read the card once, the detection reads below are served from the shadow */
+    smartcard_highlevel_fill_shadow();
 
     /* Check smart card FZ */
     smartcard_highlevel_read_fab_zone((uint8_t*)&data_buffer);
@@ -279,6 +403,9 @@ void smartcard_lowlevel_erase_application_zone1_nzone2(BOOL zone1_nzone2)
     {
         i = 688;
     }
+    
+    /* Zone contents change */
+    smartcard_highlevel_invalidate_shadow();
 
     /* Switch to bit banging */
     platform_io_smc_switch_to_bb();
@@ -286,7 +413,7 @@ void smartcard_lowlevel_erase_application_zone1_nzone2(BOOL zone1_nzone2)
     smartcard_lowlevel_clear_pgmrst_signals();
 
     /* Get to the good EZx */
-    while(i--) smartcard_lowlevel_inverted_clock_pulse();
+    smartcard_lowlevel_inverted_clock_pulses(i);
 
     /* How many bits to compare */
     if (zone1_nzone2 == FALSE)
@@ -336,6 +463,9 @@ pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code)
     pin_check_return_te return_val = RETURN_PIN_NOK_0;
     BOOL temp_bool;
     uint16_t i;
+    
+    /* Security state & attempts counter change */
+    smartcard_highlevel_invalidate_shadow();
 
     /* Switch to bit banging */
     platform_io_smc_switch_to_bb();
@@ -343,10 +473,7 @@ pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code)
     smartcard_lowlevel_clear_pgmrst_signals();
 
     /* Get to the SC */
-    for(i = 0; i < 80; i++)
-    {
-        smartcard_lowlevel_inverted_clock_pulse();
-    }
+    smartcard_lowlevel_inverted_clock_pulses(80);
 
     /* Clock is at high level now, as input must be switched during this time */
     /* Enter the SC */
@@ -448,17 +575,102 @@ pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code)
     return return_val;
 }
 
-/*! \fn     smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write)
+/*! \fn     smartcard_lowlevel_get_buffer_bit(uint8_t* buffer, uint16_t bit_index)
+*   \brief  Get a bit from a buffer, MSB first as the card outputs them
+*   \param  buffer      The buffer
+*   \param  bit_index   Bit index
+*   \return The bit value
+*/
+static inline uint16_t smartcard_lowlevel_get_buffer_bit(uint8_t* buffer, uint16_t bit_index)
+{
+    return (buffer[bit_index >> 3] >> (7 - (bit_index & 0x0007))) & 0x01;
+}
+
+/*! \fn     smartcard_lowlevel_get_word_write_type(uint16_t word_start_bit, uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write, uint8_t* card_image)
+*   \brief  Find out what a write needs to do to a 16 bits word
+*   \param  word_start_bit          Index of the word first bit
+*   \param  start_index_bit         Where the write starts
+*   \param  nb_bits                 Number of bits to write
+*   \param  data_to_write           Pointer to the buffer
+*   \param  card_image              Image of the card memory, 0 if unknown
+*   \return What to do, see smc_word_write_type_te
+*   \note   A written word ends up with the written bits, and 1s for the bits of the word that are outside of the write range
+*/
+static smc_word_write_type_te smartcard_lowlevel_get_word_write_type(uint16_t word_start_bit, uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write, uint8_t* card_image)
+{
+    uint16_t current_word = 0;
+    uint16_t target_word = 0;
+    
+    /* Contents unknown */
+    if (card_image == 0)
+    {
+        return SMC_WORD_ERASE_PROGRAM;
+    }
+    
+    for (uint16_t i = word_start_bit; i < word_start_bit + 16; i++)
+    {
+        current_word = (current_word << 1) | smartcard_lowlevel_get_buffer_bit(card_image, i);
+        if ((i >= start_index_bit) && (i < start_index_bit + nb_bits))
+        {
+            target_word = (target_word << 1) | smartcard_lowlevel_get_buffer_bit(data_to_write, i - start_index_bit);
+        }
+        else
+        {
+            target_word = (target_word << 1) | 0x0001;
+        }
+    }
+    
+    if (current_word == target_word)
+    {
+        return SMC_WORD_UNCHANGED;
+    }
+    else if ((current_word & target_word) == target_word)
+    {
+        /* Only 1s to turn into 0s */
+        return SMC_WORD_PROGRAM;
+    }
+    else
+    {
+        return SMC_WORD_ERASE_PROGRAM;
+    }
+}
+
+/*! \fn     smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write, uint8_t* card_image)
 *   \brief  Write bits to the smart card
 *   \param  start_index_bit         Where to start writing bits
 *   \param  nb_bits                 Number of bits to write
 *   \param  data_to_write           Pointer to the buffer
+*   \param  card_image              Image of the current card memory (SMARTCARD_MEM_BIT_LENGTH bits), 0 to erase & program every word
+*   \return TRUE if the card was erased or programmed
+*   \note   With a card image, words already holding the data are skipped, words only needing 1s turned into 0s aren't erased,
+*   \note   and clocking stops after the last word to be changed. The address counter walks forward through the skipped words
 */
-void smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write)
+BOOL smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write, uint8_t* card_image)
 {
+    smc_word_write_type_te word_write_type = SMC_WORD_ERASE_PROGRAM;
     uint16_t current_written_bit = 0;
     uint16_t masked_bit_to_write = 0;
+    uint16_t nb_bits_to_clock = 0;
     uint16_t i;
+    
+    /* Find the last word to be changed */
+    for (i = start_index_bit & 0xFFF0; i < start_index_bit + nb_bits; i += 16)
+    {
+        if (smartcard_lowlevel_get_word_write_type(i, start_index_bit, nb_bits, data_to_write, card_image) != SMC_WORD_UNCHANGED)
+        {
+            nb_bits_to_clock = i + 16 - start_index_bit;
+        }
+    }
+    if (nb_bits_to_clock > nb_bits)
+    {
+        nb_bits_to_clock = nb_bits;
+    }
+    
+    /* Card already holds the data */
+    if (nb_bits_to_clock == 0)
+    {
+        return FALSE;
+    }
 
     /* Switch to bit banging */
     platform_io_smc_switch_to_bb();
@@ -469,42 +681,37 @@ void smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, ui
     if (start_index_bit >= SMARTCARD_AZ2_BIT_START)
     {
         /* Clock pulses until AZ2 start - 1 */
-        for(i = 0; i < SMARTCARD_AZ2_BIT_START - 1; i++)
-        {
-            smartcard_lowlevel_clock_pulse();
-        }
+        smartcard_lowlevel_clock_pulses(SMARTCARD_AZ2_BIT_START - 1);
         PORT->Group[SMC_MOSI_GROUP].OUTSET.reg = SMC_MOSI_MASK;
         smartcard_lowlevel_clock_pulse();
         PORT->Group[SMC_MOSI_GROUP].OUTCLR.reg = SMC_MOSI_MASK;
         /* Clock for the rest */
-        for(i = 0; i < (start_index_bit - SMARTCARD_AZ2_BIT_START); i++)
-        {
-            smartcard_lowlevel_clock_pulse();
-        }
+        smartcard_lowlevel_clock_pulses(start_index_bit - SMARTCARD_AZ2_BIT_START);
     }
     else
     {
         /* Get to the good index, clock pulses */
-        for(i = 0; i < start_index_bit; i++)
-        {
-            smartcard_lowlevel_clock_pulse();
-        }
+        smartcard_lowlevel_clock_pulses(start_index_bit);
     }
 
     /* Start writing */
-    for(current_written_bit = 0; current_written_bit < nb_bits; current_written_bit++)
+    for(current_written_bit = 0; current_written_bit < nb_bits_to_clock; current_written_bit++)
     {
-        /* If we are at the start of a 16bits word or writing our first bit, erase the word */
+        /* If we are at the start of a 16bits word or writing our first bit, see what this word needs and erase it if required */
         if ((((start_index_bit+current_written_bit) & 0x000F) == 0) || (current_written_bit == 0))
         {
-            smartcard_lowlevel_write_nerase(FALSE);
+            word_write_type = smartcard_lowlevel_get_word_write_type((start_index_bit+current_written_bit) & 0xFFF0, start_index_bit, nb_bits, data_to_write, card_image);
+            if (word_write_type == SMC_WORD_ERASE_PROGRAM)
+            {
+                smartcard_lowlevel_write_nerase(FALSE);
+            }
         }
 
         /* Get good bit to write */
-        masked_bit_to_write = (data_to_write[(current_written_bit>>3)] >> (7 - (current_written_bit & 0x0007))) & 0x01;
+        masked_bit_to_write = smartcard_lowlevel_get_buffer_bit(data_to_write, current_written_bit);
 
-        /* Write only if the data is a 0 */
-        if (masked_bit_to_write == 0x00)
+        /* Write only if the data is a 0, and if not already a 0 when the word wasn't erased */
+        if ((masked_bit_to_write == 0x00) && ((word_write_type == SMC_WORD_ERASE_PROGRAM) || ((word_write_type == SMC_WORD_PROGRAM) && (smartcard_lowlevel_get_buffer_bit(card_image, start_index_bit+current_written_bit) != 0))))
         {
             smartcard_lowlevel_write_nerase(TRUE);
         }
@@ -518,6 +725,8 @@ void smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, ui
 
     /* Switch to SPI mode */
     platform_io_smc_switch_to_spi();
+    
+    return TRUE;
 }
 
 /*! \fn     smartcard_lowlevel_clear_pgmrst_signals(void)
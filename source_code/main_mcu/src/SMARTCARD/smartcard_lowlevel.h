@@ -12,22 +12,29 @@
 
 /* Typedefs */
 typedef enum    {MAN_FUSE = 0, EC2EN_FUSE = 1, ISSUER_FUSE = 2} card_fuse_type_te;
+typedef enum    {SMC_WORD_UNCHANGED = 0, SMC_WORD_PROGRAM = 1, SMC_WORD_ERASE_PROGRAM = 2} smc_word_write_type_te;
     
 /* Defines */
 #define CARD_DELAY_FOR_DETECTION    250
+// Bit banging timer periods, in 3MHz ticks: 2us half pulse, 4ms tchp
+#define SMARTCARD_TIMER_HPULSE_TICKS    6
+#define SMARTCARD_TIMER_TCHP_TICKS      12000
 
 // Prototypes
 uint8_t* smartcard_lowlevel_read_smc(uint16_t nb_bytes_total_read, uint16_t start_record_index, uint8_t* data_to_receive);
-void smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write);
+BOOL smartcard_lowlevel_write_smc(uint16_t start_index_bit, uint16_t nb_bits, uint8_t* data_to_write, uint8_t* card_image);
 pin_check_return_te smartcard_lowlevel_validate_code(volatile uint16_t* code);
 void smartcard_lowlevel_erase_application_zone1_nzone2(BOOL zone1_nzone2);
+void smartcard_lowlevel_inverted_clock_pulses(uint16_t nb_pulses);
 card_detect_return_te smartcard_lowlevel_first_detect_function(void);
 void smartcard_lowlevel_blow_fuse(card_fuse_type_te fuse_name);
 det_ret_type_te smartcard_lowlevel_is_card_plugged(void);
 void smartcard_lowlevel_write_nerase(BOOL is_write);
 void smartcard_lowlevel_inverted_clock_pulse(void);
 void smartcard_lowlevel_clear_pgmrst_signals(void);
+void smartcard_lowlevel_clock_pulses(uint16_t nb_pulses);
 void smartcard_lowlevel_set_pgmrst_signals(void);
+void smartcard_lowlevel_timer_callback(void);
 void smartcard_lowlevel_hpulse_delay(void);
 void smartcard_lowlevel_clock_pulse(void);
 void smartcard_lowlevel_detect(void);
@@ -56,6 +63,7 @@ static inline RET_TYPE smartcard_low_level_is_smc_absent(void)
 #define SMARTCARD_FABRICATION_ZONE  0x0F0F
 #define SMARTCARD_FACTORY_PIN       0xF0F0
 #define SMARTCARD_DEFAULT_PIN       0xF0F0
+#define SMARTCARD_CPZ_BIT_START     112
 #define SMARTCARD_AZ_BIT_LENGTH     512
 #define SMARTCARD_AZ1_BIT_START     176
 #define SMARTCARD_AZ1_BIT_RESERVED  16
@@ -67,5 +75,6 @@ static inline RET_TYPE smartcard_low_level_is_smc_absent(void)
 #define SMARTCARD_MTP_LOGIN_OFFSET  SMARTCARD_AZ2_BIT_RESERVED
 #define SMARTCARD_CPZ_LENGTH        8
 #define SMARTCARD_ISSUER_ZONE_LGTH  8
+#define SMARTCARD_MEM_BIT_LENGTH    1568
 
 #endif /* SMARTCARD_H_ */
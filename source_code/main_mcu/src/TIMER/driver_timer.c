@@ -40,6 +40,23 @@ void TCC0_Handler(void)
     #endif
 }
 
+#ifdef SMARTCARD_TIMER_BITBANG
+/*! \fn     SMARTCARD_BB_TC_HANDLER(void)
+*   \brief  Called by interrupt at the end of each smartcard bit banging timer period
+*/
+void SMARTCARD_BB_TC_HANDLER(void)
+{
+    if (SMARTCARD_BB_TC->COUNT16.INTFLAG.reg & TC_INTFLAG_OVF)
+    {
+        /* Overflow interrupt: clear flag */
+        SMARTCARD_BB_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        
+        /* Next clock edge or end of wait */
+        smartcard_lowlevel_timer_callback();
+    }
+}
+#endif
+
 /*! \fn     timer_initialize_timebase(void)
 *   \brief  Initialize the platform time base
 *   \note   Will use GCLK3 for a 1.024KHz and uses the RTC module in calendar mode
@@ -108,6 +125,32 @@ void timer_initialize_timebase(void)
     TCC0->CTRLA = tcc_ctrl_reg;                                         // Write register
     TCC0->INTENSET.reg = TCC_INTENSET_OVF;                              // Enable overflow interrupt
     NVIC_EnableIRQ(TCC0_IRQn);                                          // Enable int
+    
+    #ifdef SMARTCARD_TIMER_BITBANG
+    /* Set GCLK Multiplexer for the smartcard bit banging TC to 48MHz GCLK0 */
+    clocks_map_gclk_to_peripheral_clock(GCLK_ID_48M, SMARTCARD_BB_GCLK_TC_ID);
+    
+    /* Setup smartcard bit banging TC: 3MHz one shot counter, stopped until the smartcard driver retriggers it */
+    PM->APBCMASK.bit.SMARTCARD_BB_APB_TC_BIT = 1;                       // Enable APBC clock for TC
+    TC_CTRLA_Type tc_ctrl_reg;                                          // tc ctrl reg
+    tc_ctrl_reg.reg = 0;                                                // Reset temp var
+    tc_ctrl_reg.bit.MODE = TC_CTRLA_MODE_COUNT16_Val;                   // 16 bits counter
+    tc_ctrl_reg.bit.WAVEGEN = TC_CTRLA_WAVEGEN_MFRQ_Val;                // Period set by CC0
+    tc_ctrl_reg.bit.PRESCALER = TC_CTRLA_PRESCALER_DIV16_Val;           // 48M/16 = 3MHz
+    tc_ctrl_reg.bit.RUNSTDBY = 0;                                       // Do not run during standby
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);    // Wait for sync
+    SMARTCARD_BB_TC->COUNT16.CTRLA = tc_ctrl_reg;                       // Write register
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);    // Wait for sync
+    SMARTCARD_BB_TC->COUNT16.CTRLBSET.reg = TC_CTRLBSET_ONESHOT;        // Stop on overflow
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);    // Wait for sync
+    SMARTCARD_BB_TC->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;              // Enable tc
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);    // Wait for sync
+    SMARTCARD_BB_TC->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_STOP;       // Do not start counting
+    while(SMARTCARD_BB_TC->COUNT16.STATUS.reg & TC_STATUS_SYNCBUSY);    // Wait for sync
+    SMARTCARD_BB_TC->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;              // Clear overflow flag
+    SMARTCARD_BB_TC->COUNT16.INTENSET.reg = TC_INTENSET_OVF;            // Enable overflow interrupt
+    NVIC_EnableIRQ(SMARTCARD_BB_TC_IRQn);                               // Enable int
+    #endif
 }
 
 /*!	\fn		timer_get_calendar(void)
@@ -152,6 +195,34 @@ uint32_t timer_get_systick(void)
     return sysTick;
 }
 
+/*!	\fn		timer_get_cycle_count(void)
+*	\brief	Get a 48MHz cycle counter, built from the ms tick and TCC0 counter
+*   \return The number of CPU cycles since boot, wrapping every ~89 seconds
+*   \note   Only meant for measuring durations
+*/
+uint32_t timer_get_cycle_count(void)
+{
+    uint32_t ms_ticks;
+    uint32_t tcc_count;
+    
+    cpu_irq_enter_critical();
+    
+    /* Request a synchronized read of TCC0 counter */
+    TCC0->CTRLBSET.reg = TCC_CTRLBSET_CMD_READSYNC;
+    while(TCC0->SYNCBUSY.reg & (TCC_SYNCBUSY_CTRLB | TCC_SYNCBUSY_COUNT));
+    tcc_count = TCC0->COUNT.reg;
+    ms_ticks = sysTick;
+    
+    /* Counter overflowed but the interrupt wasn't served yet */
+    if ((TCC0->INTFLAG.reg & TCC_INTFLAG_OVF) && (tcc_count < 48000/2))
+    {
+        ms_ticks++;
+    }
+    
+    cpu_irq_leave_critical();
+    return ms_ticks*48000 + tcc_count;
+}
+
 /*!	\fn		timer_has_timer_expired(timer_id_te uid, BOOL clear)
 *	\brief	Know if a timer expired and clear the flag if so
 *   \param  uid     Unique ID
@@ -23,7 +23,7 @@ typedef struct
 typedef RTC_MODE2_CLOCK_Type calendar_t;
 
 /* Enums */
-typedef enum {TIMER_WAIT_FUNCTS = 0, TIMER_TIMEOUT_FUNCTS = 1, TIMER_USER_INTERACTION = 2, TIMER_SCROLLING = 3, TIMER_ANIMATIONS = 4, TIMER_SCREEN = 5, TOTAL_NUMBER_OF_TIMERS} timer_id_te;
+typedef enum {TIMER_WAIT_FUNCTS = 0, TIMER_TIMEOUT_FUNCTS = 1, TIMER_USER_INTERACTION = 2, TIMER_SCROLLING = 3, TIMER_ANIMATIONS = 4, TIMER_SCREEN = 5, TIMER_AUX_LINK_NACK = 6, TOTAL_NUMBER_OF_TIMERS} timer_id_te;
 typedef enum {TIMER_EXPIRED = 0, TIMER_RUNNING = 1} timer_flag_te;
     
 /* Macros */
@@ -41,6 +41,7 @@ void timer_start_timer(timer_id_te uid, uint32_t val);
 void timer_get_calendar(calendar_t* calendar_pt);
 uint32_t timer_get_timer_val(timer_id_te uid);
 void timer_initialize_timebase(void);
+uint32_t timer_get_cycle_count(void);
 uint32_t timer_get_systick(void);
 void timer_delay_ms(uint32_t ms);
 void timer_ms_tick(void);
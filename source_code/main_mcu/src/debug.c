@@ -175,9 +175,13 @@ void debug_debug_menu(void)
             }
             else if (selected_item == 10)
             {
-                custom_fs_settings_set_fw_upgrade_flag();
-                cpu_irq_disable();
-                NVIC_SystemReset();
+                /* The bootloader only checks the bundle crc32 */
+                if (custom_fs_check_external_bundle_signature() == RETURN_OK)
+                {
+                    custom_fs_settings_set_fw_upgrade_flag();
+                    cpu_irq_disable();
+                    NVIC_SystemReset();
+                }
             }
             else if (selected_item == 11)
             {
@@ -605,7 +609,7 @@ void debug_mcu_and_aux_info(void)
     comms_aux_mcu_send_message(TRUE);
     
     /* Wait for message from aux MCU */
-    while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
+    while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
         
     /* Cast aux MCU DID */
     DSU_DID_Type aux_mcu_did;
@@ -652,7 +656,12 @@ void debug_atbtlc_info(void)
     aux_mcu_message_t* temp_tx_message_pt;
     
     /* Enable BLE */
-    logic_aux_mcu_enable_ble(TRUE);
+    if (logic_aux_mcu_enable_ble(TRUE) != RETURN_OK)
+    {
+        sh1122_put_error_string(&plat_oled_descriptor, u"BLE enable timeout!");
+        timer_delay_ms(2000);
+        return;
+    }
     
     /* Generate our packet */
     comms_aux_mcu_get_empty_packet_ready_to_be_sent(&temp_tx_message_pt, AUX_MCU_MSG_TYPE_PLAT_DETAILS, TX_REPLY_REQUEST_FLAG);
@@ -661,7 +670,7 @@ void debug_atbtlc_info(void)
     comms_aux_mcu_send_message(TRUE);
     
     /* Wait for message from aux MCU */
-    while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
+    while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_PLAT_DETAILS) == RETURN_NOK){}
         
     /* Output debug info */
     sh1122_clear_current_screen(&plat_oled_descriptor);
@@ -851,7 +860,7 @@ void debug_nimh_charging(void)
             comms_aux_mcu_send_message(TRUE);
             
             /* Wait for message from aux MCU */
-            while(comms_aux_mcu_active_wait(&temp_rx_message, FALSE, AUX_MCU_MSG_TYPE_NIMH_CHARGE) == RETURN_NOK){}
+            while(comms_aux_mcu_active_wait(&temp_rx_message, AUX_MCU_MSG_TYPE_NIMH_CHARGE) == RETURN_NOK){}
             
             /* Clear screen */
             sh1122_clear_current_screen(&plat_oled_descriptor);
@@ -10,6 +10,7 @@
 
 /* Defines */
 #define AUX_MCU_MESSAGE_REPLY_TIMEOUT_MS    500
+#define BLE_ENABLE_TIMEOUT_MS               5000
 
 /* Fonts defines */
 #define FONT_UBUNTU_MONO_BOLD_30_ID 0
@@ -20,6 +21,7 @@
 #define STR(x)                      #x
 #define ARRAY_SIZE(x)               (sizeof((x)) / sizeof((x)[0]))
 #define MEMBER_SIZE(type, member)   sizeof(((type*)0)->member)
+#define MEMBER_ARRAY_SIZE(type, member) (sizeof(((type*)0)->member)/sizeof(((type*)0)->member[0]))
 
 /* Standard defines */
 #define AES_KEY_LENGTH          256
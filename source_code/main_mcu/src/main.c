@@ -7,8 +7,10 @@
 #include "logic_smartcard.h"
 #include "gui_dispatcher.h"
 #include "logic_aux_mcu.h"
+#include "logic_keyboard.h"
 #include "driver_clocks.h"
 #include "comms_aux_mcu.h"
+#include "comms_trace.h"
 #include "driver_timer.h"
 #include "logic_device.h"
 #include "gui_prompts.h"
@@ -21,6 +23,7 @@
 #include "dbflash.h"
 #include "defines.h"
 #include "sh1122.h"
+#include "rng.h"
 #include "inputs.h"
 #include "fuses.h"
 #include "debug.h"
@@ -104,6 +107,7 @@ void main_platform_init(void)
     
     /* Check if battery powered and undervoltage */
     uint16_t battery_voltage = platform_io_get_voledin_conversion_result_and_trigger_conversion();
+    rng_feed_from_adc_result(battery_voltage);
     if ((platform_io_is_usb_3v3_present() == FALSE) && (battery_voltage < BATTERY_ADC_OUT_CUTOUT))
     {
         platform_io_disable_switch_and_die();
@@ -129,6 +133,12 @@ void main_platform_init(void)
         {
             /* Bundle integrity check */
             bundle_integrity_check_return = custom_fs_compute_and_check_external_bundle_crc32();
+            
+            /* Load the keyboard layout recommended for the default language */
+            if (bundle_integrity_check_return != RETURN_NOK)
+            {
+                logic_keyboard_set_layout(custom_fs_get_recommended_layout_for_current_language());
+            }
         }
     }
     
@@ -229,8 +239,7 @@ void main_platform_init(void)
         sh1122_put_error_string(&plat_oled_descriptor, u"First Boot Tests...");
         
         /* Get BLE ID */
-        logic_aux_mcu_enable_ble(TRUE);
-        if (logic_aux_mcu_get_ble_chip_id() == 0)
+        if ((logic_aux_mcu_enable_ble(TRUE) != RETURN_OK) || (logic_aux_mcu_get_ble_chip_id() == 0))
         {
             sh1122_put_error_string(&plat_oled_descriptor, u"ATBTLC1000 error!");
             while(1);
@@ -424,11 +433,20 @@ int main(void)
         /* Communications */        
         comms_aux_mcu_routine(MSG_NO_RESTRICT);
         
+        /* Send traces if the link is idle */
+        #ifdef DEBUG_TRACE_ENABLED
+        comms_trace_routine();
+        #endif
+        
         /* Accelerometer interrupt */
         if (lis2hh12_check_data_received_flag_and_arm_other_transfer(&acc_descriptor) != FALSE)
         {
+            rng_feed_from_acc_read(&acc_descriptor.fifo_read);
         }
         
+        /* Random pool refill, DRBG reseeding */
+        rng_routine();
+        
         /* Get current smartcard detection result */
         card_detection_res = smartcard_lowlevel_is_card_plugged();
     }
@@ -64,12 +64,36 @@
      #define DBFLASH_CHIP_8M
 #endif
 
+/* Bundle signature check: switched on by providing the Ed25519 public key, as a 32 bytes initializer list */
+/* Only setups with developer features may skip it, to load unsigned bundles, when no key is provided */
+/* The bootloader keeps to the crc32 check, as the signature check doesn't fit in its 8kB: the application checks the signature before setting the fw upgrade flag */
+#if defined(BOOTLOADER) || (defined(DEVELOPER_FEATURES_ENABLED) && !defined(BUNDLE_SIGNING_PUBLIC_KEY))
+    #define NO_BUNDLE_SIGNATURE_CHECK
+#endif
+#if defined(NO_BUNDLE_SIGNATURE_CHECK) && !defined(DEVELOPER_FEATURES_ENABLED) && !defined(BOOTLOADER)
+    #error "The bundle signature check can't be disabled without developer features"
+#endif
+#if !defined(NO_BUNDLE_SIGNATURE_CHECK) && !defined(BUNDLE_SIGNING_PUBLIC_KEY)
+    #error "BUNDLE_SIGNING_PUBLIC_KEY must be defined to check the bundle signature"
+#endif
+
 /* Developer features */
 #ifdef DEVELOPER_FEATURES_ENABLED
     #define DEV_SKIP_INTRO_ANIM
     #define SPECIAL_DEVELOPER_CARD_FEATURE
 #endif
 
+/* Per screen render time & flash traffic, per HID command call count & cycles, fetched through debug USB commands */
+#ifdef DEBUG_USB_COMMANDS_ENABLED
+    #define DEBUG_RENDER_STATS_ENABLED
+    #define DEBUG_HID_CMD_STATS_ENABLED
+#endif
+
+/* Binary traces (see comms_trace.h), sent to the host when the aux MCU link is idle */
+#ifdef DEBUG_USB_COMMANDS_ENABLED
+    #define DEBUG_TRACE_ENABLED
+#endif
+
 /* Enums */
 typedef enum {PIN_GROUP_0 = 0, PIN_GROUP_1 = 1} pin_group_te;
 typedef uint32_t PIN_MASK_T;
@@ -129,6 +153,10 @@ typedef struct
 #define OLED_DMA_TRANSFER
 /* Use a frame buffer on the platform */
 #define OLED_INTERNAL_FRAME_BUFFER
+/* Use the DMA controller to clear the frame buffer */
+#define OLED_DMA_FRAME_BUFFER_CLEAR
+/* Use a timer/counter to generate the smartcard bit banging clock pulse trains & waits: to be measured on target first */
+//#define SMARTCARD_TIMER_BITBANG
 /* allow printf for the screen */
 //#define OLED_PRINTF_ENABLED
 /* Allow debug USB commands */
@@ -216,6 +244,13 @@ typedef struct
     #define ACC_SERCOM                  SERCOM0
 #endif
 
+/* Smartcard bit banging timer defines */
+#define SMARTCARD_BB_GCLK_TC_ID     GCLK_CLKCTRL_ID_TCC2_TC3_Val
+#define SMARTCARD_BB_APB_TC_BIT     TC3_
+#define SMARTCARD_BB_TC_HANDLER     TC3_Handler
+#define SMARTCARD_BB_TC_IRQn        TC3_IRQn
+#define SMARTCARD_BB_TC             TC3
+
 /* DMA channel descriptors */
 #define DMA_DESCID_RX_COMMS         0
 #define DMA_DESCID_RX_FS            1
@@ -224,6 +259,10 @@ typedef struct
 #define DMA_DESCID_TX_OLED          4
 #define DMA_DESCID_RX_ACC           5
 #define DMA_DESCID_TX_COMMS         6
+#define DMA_DESCID_MEMSET           7
+#define DMA_DESCID_RX_DBFLASH       8
+#define DMA_DESCID_TX_DBFLASH       9
+#define DMA_NB_DESCIDS              10
 
 /* External interrupts numbers */
 #if defined(PLAT_V1_SETUP) || defined(PLAT_V2_SETUP)
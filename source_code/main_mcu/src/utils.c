@@ -47,6 +47,40 @@ int16_t utils_custchar_strncmp(cust_char_t* f_string, cust_char_t* sec_string, u
     return 0;
 }
 
+/*! \fn     utils_custchar_strcat(cust_char_t* string, const cust_char_t* appended)
+*   \brief  Our own custom strcat
+*   \param  string      0 terminated string, with room for the appended one
+*   \param  appended    String to append
+*/
+void utils_custchar_strcat(cust_char_t* string, const cust_char_t* appended)
+{
+    string += utils_strlen(string);
+    while (*appended != 0)
+    {
+        *string++ = *appended++;
+    }
+    *string = 0;
+}
+
+/*! \fn     utils_custchar_append_uint16(cust_char_t* string, uint16_t value)
+*   \brief  Append a number in decimal to a string
+*   \param  string      0 terminated string, with room for 5 more characters
+*   \param  value       The number
+*/
+void utils_custchar_append_uint16(cust_char_t* string, uint16_t value)
+{
+    cust_char_t digits[6];
+    uint16_t i = sizeof(digits)/sizeof(digits[0]) - 1;
+    
+    digits[i] = 0;
+    do
+    {
+        digits[--i] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    utils_custchar_strcat(string, &digits[i]);
+}
+
 /*! \fn     utils_check_value_for_range(uint16_t val, uint16_t min, uint16_t max)
 *   \brief  Make sure a given value is within a range
 *   \param  val     The value to check
@@ -15,5 +15,7 @@
 int16_t utils_custchar_strncmp(cust_char_t* f_string, cust_char_t* sec_string, uint16_t nb_chars);
 uint16_t utils_check_value_for_range(uint16_t val, uint16_t min, uint16_t max);
 uint16_t utils_strlen(cust_char_t* string);
+void utils_custchar_strcat(cust_char_t* string, const cust_char_t* appended);
+void utils_custchar_append_uint16(cust_char_t* string, uint16_t value);
 
 #endif /* UTILS_H_ */
\ No newline at end of file